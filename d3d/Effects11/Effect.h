@@ -749,6 +749,91 @@ struct SAnonymousShader : public TUncastableVariable<ID3DX11EffectShaderVariable
     STDMETHOD_(LPCSTR, GetMemberSemantic)(UINT Index);
 };
 
+//////////////////////////////////////////////////////////////////////////
+// SSharedConstantBuffer - a cbuffer shared by several effects
+//
+// Effects created with D3DX11_EFFECT_SHARED_CONSTANT_BUFFERS look their
+// cbuffers up in g_SharedConstantBuffers when they are bound to the device.
+// The cbuffers with the same name and layout on one device use one buffer
+// and one backing store: a value set through any of the effects is seen by
+// all of them, and uploaded once. The dirty range lives here too, so that
+// the first effect applied after a change does the upload, and so does the
+// version the apply contexts compare their copies against.
+//////////////////////////////////////////////////////////////////////////
+
+struct SSharedConstantBuffer
+{
+    UINT                    RefCount;           // Effect cbuffers using it, changed under the list lock
+    ID3D11Device            *pDevice;           // Not AddRef'd, pD3DObject holds the device
+    ID3D11Buffer            *pD3DObject;
+    BYTE                    *pBackingStore;
+    UINT                    Size;               // in bytes
+
+    UINT                    LayoutHash;
+    CEffectVector<BYTE>     Layout;             // See CEffect::GetCBLayout
+
+    BOOL                    IsDirty;
+    UINT                    DirtyStart;
+    UINT                    DirtyEnd;
+    UINT                    Version;            // Bumped by every MarkDirty
+
+    SSharedConstantBuffer()
+    {
+        RefCount = 0;
+        pDevice = NULL;
+        pD3DObject = NULL;
+        pBackingStore = NULL;
+        Size = 0;
+        LayoutHash = 0;
+        IsDirty = FALSE;
+        DirtyStart = 0;
+        DirtyEnd = 0;
+        Version = 0;
+    }
+
+    ~SSharedConstantBuffer()
+    {
+        SAFE_RELEASE(pD3DObject);
+        SAFE_DELETE_ARRAY(pBackingStore);
+    }
+
+    D3DX11INLINE void MarkDirty(UINT Offset, UINT ByteCount)
+    {
+        if (!IsDirty)
+        {
+            DirtyStart = Offset;
+            DirtyEnd = Offset + ByteCount;
+            IsDirty = TRUE;
+        }
+        else
+        {
+            DirtyStart = min(DirtyStart, Offset);
+            DirtyEnd = max(DirtyEnd, Offset + ByteCount);
+        }
+        ++ Version;
+    }
+};
+
+class CSharedConstantBufferList
+{
+public:
+    CSharedConstantBufferList();
+    ~CSharedConstantBufferList();
+
+    // The shared cbuffer of this device, size and layout, created from the
+    // buffer and values of pCB when no effect has one yet. Holds a reference
+    // until Release.
+    HRESULT Acquire(ID3D11Device *pDevice, SConstantBuffer *pCB, CONST BYTE *pLayout, UINT LayoutSize, SSharedConstantBuffer **ppShared);
+    void AddRef(SSharedConstantBuffer *pShared);
+    void Release(SSharedConstantBuffer *pShared);
+
+protected:
+    CEffectVector<SSharedConstantBuffer*>   m_Buffers;
+    CRITICAL_SECTION                        m_Lock;
+};
+
+extern CSharedConstantBufferList g_SharedConstantBuffers;
+
 ////////////////////////////////////////////////////////////////////////////////
 // ID3DX11EffectConstantBuffer (SConstantBuffer implementation)
 ////////////////////////////////////////////////////////////////////////////////
@@ -778,6 +863,16 @@ struct SConstantBuffer : public TUncastableVariable<ID3DX11EffectConstantBuffer>
     BOOL                    IsUserPacked:1;     // Set if the elements have user-specified offsets
     BOOL                    IsSingle:1;         // Set to true if you want to share this CB with cloned Effects
     BOOL                    IsNonUpdatable:1;   // Set to true if you want to share this CB with cloned Effects
+    BOOL                    IsDynamic:1;        // Set if the buffer is updated with MAP_WRITE_DISCARD
+    BOOL                    IsPartiallyUpdatable:1;// Set if the device takes D3D11.1 boxed updates of this cbuffer
+
+    // Bytes written since the last update, valid while IsDirty is set
+    UINT                    DirtyStart;
+    UINT                    DirtyEnd;
+
+    // Bumped by every MarkDirty: an apply context whose copy was taken at
+    // another version takes it again (see SPrivateConstantBuffer)
+    UINT                    Version;
 
     union
     {
@@ -787,6 +882,7 @@ struct SConstantBuffer : public TUncastableVariable<ID3DX11EffectConstantBuffer>
     };
 
     CEffect                 *pEffect;
+    SSharedConstantBuffer   *pShared;           // Set if the buffer and backing store are shared with other effects
 
     SConstantBuffer()
     {
@@ -808,7 +904,62 @@ struct SConstantBuffer : public TUncastableVariable<ID3DX11EffectConstantBuffer>
         IsUserPacked = FALSE;
         IsSingle = FALSE;
         IsNonUpdatable = FALSE;
+        IsDynamic = FALSE;
+        IsPartiallyUpdatable = FALSE;
+        DirtyStart = 0;
+        DirtyEnd = 0;
+        Version = 0;
         pEffect = NULL;
+        pShared = NULL;
+    }
+
+    // Widens the dirty range to [Offset, Offset + ByteCount)
+    D3DX11INLINE void MarkDirty(UINT Offset, UINT ByteCount)
+    {
+        if (pShared)
+        {
+            pShared->MarkDirty(Offset, ByteCount);
+        }
+        else
+        {
+            if (!IsDirty)
+            {
+                DirtyStart = Offset;
+                DirtyEnd = Offset + ByteCount;
+                IsDirty = TRUE;
+            }
+            else
+            {
+                DirtyStart = min(DirtyStart, Offset);
+                DirtyEnd = max(DirtyEnd, Offset + ByteCount);
+            }
+            ++ Version;
+        }
+    }
+
+    // Dirty state of the buffer, kept in the shared block when it is shared
+    D3DX11INLINE BOOL NeedsUpdate() const
+    {
+        return pShared ? pShared->IsDirty : IsDirty;
+    }
+
+    D3DX11INLINE void GetDirtyRange(UINT *pStart, UINT *pEnd) const
+    {
+        *pStart = pShared ? pShared->DirtyStart : DirtyStart;
+        *pEnd = pShared ? pShared->DirtyEnd : DirtyEnd;
+    }
+
+    D3DX11INLINE void ClearDirty()
+    {
+        if (pShared)
+            pShared->IsDirty = FALSE;
+        else
+            IsDirty = FALSE;
+    }
+
+    D3DX11INLINE UINT GetVersion() const
+    {
+        return pShared ? pShared->Version : Version;
     }
 
     bool ClonedSingle() const;
@@ -1009,6 +1160,192 @@ public:
     ~CEffectHeap();
 };
 
+//////////////////////////////////////////////////////////////////////////
+// CEffectStateFilter - shadow of the state the effects bound on a context
+//
+// Every Set* call the effects would make goes through the filter first,
+// which tells whether its arguments differ from what is bound. The shadow
+// holds no references: whatever it records is bound on the context, which
+// keeps it alive. It is only valid as long as nothing else binds state on
+// the context; after that, Invalidate must be called (see
+// D3DX11InvalidateEffectStateFilter).
+//////////////////////////////////////////////////////////////////////////
+
+class CEffectStateFilter
+{
+public:
+    CEffectStateFilter(ID3D11DeviceContext *pContext);
+
+    // The filter list holds one reference and every Find returns another: a
+    // filter disabled while an Apply on another thread still uses it is only
+    // deleted once that Apply is done with it
+    void AddRef() { InterlockedIncrement(&m_RefCount); }
+    void Release();
+
+    ID3D11DeviceContext *GetContext() const { return m_pContext; }
+
+    // Each returns TRUE when the call has to be made, and then records the
+    // new state, or FALSE when the state is already bound
+    BOOL SetBlendState(ID3D11BlendState *pState, CONST FLOAT BlendFactor[4], UINT SampleMask);
+    BOOL SetDepthStencilState(ID3D11DepthStencilState *pState, UINT StencilRef);
+    BOOL SetRasterizerState(ID3D11RasterizerState *pState);
+    BOOL SetShader(CONST SD3DShaderVTable *pVT, ID3D11DeviceChild *pShader, UINT NumClassInstances);
+    BOOL SetConstantBuffers(CONST SD3DShaderVTable *pVT, UINT StartSlot, UINT NumBuffers, ID3D11Buffer *CONST *ppBuffers);
+    BOOL SetSamplers(CONST SD3DShaderVTable *pVT, UINT StartSlot, UINT NumSamplers, ID3D11SamplerState *CONST *ppSamplers);
+    BOOL SetShaderResources(CONST SD3DShaderVTable *pVT, UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView *CONST *ppViews);
+
+    // Binding outputs (render targets, UAVs) makes the runtime unbind the
+    // shader resources they alias
+    void InvalidateShaderResources();
+    void Invalidate();
+
+    void GetStats(D3DX11_EFFECT_STATE_FILTER_STATS *pStats) const { *pStats = m_Stats; }
+
+protected:
+    enum EStage
+    {
+        ES_Vertex,
+        ES_Hull,
+        ES_Domain,
+        ES_Geometry,
+        ES_Pixel,
+        ES_Compute,
+        ES_Count
+    };
+
+    struct SStage
+    {
+        ID3D11DeviceChild           *pShader;
+        ID3D11Buffer                *pConstantBuffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+        ID3D11SamplerState          *pSamplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+        ID3D11ShaderResourceView    *pShaderResources[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+    };
+
+    SStage *GetStage(CONST SD3DShaderVTable *pVT);
+    BOOL FilterRange(void **ppBound, UINT StartSlot, UINT Count, void *CONST *ppNew);
+
+    volatile LONG                       m_RefCount;
+    ID3D11DeviceContext                 *m_pContext;        // Only compared once the filter is disabled
+
+    // Invalidate fills everything with 0xff: no argument matches an invalidated slot
+    ID3D11BlendState                    *m_pBlendState;
+    FLOAT                               m_BlendFactor[4];
+    UINT                                m_SampleMask;
+    ID3D11DepthStencilState             *m_pDepthStencilState;
+    UINT                                m_StencilRef;
+    ID3D11RasterizerState               *m_pRasterizerState;
+    SStage                              m_Stages[ES_Count];
+
+    D3DX11_EFFECT_STATE_FILTER_STATS    m_Stats;
+};
+
+// The filters of the contexts they are enabled on. Apply looks the context
+// up. Enabling or disabling the filter of a context while a pass is applied
+// on it is safe, but that Apply may still use the former filter (or none).
+class CEffectStateFilterList
+{
+public:
+    CEffectStateFilterList();
+    ~CEffectStateFilterList();
+
+    HRESULT Enable(ID3D11DeviceContext *pContext, BOOL Enable);
+
+    // AddRef'd, NULL when filtering is not enabled on pContext
+    CEffectStateFilter *Find(ID3D11DeviceContext *pContext);
+
+    // Changes whenever a filter is enabled or disabled
+    LONG GetGeneration() const { return m_Generation; }
+
+protected:
+    CEffectVector<CEffectStateFilter*>  m_Filters;
+    volatile LONG                       m_FilterCount;     // Lets Find skip the lock while no filter is enabled
+    volatile LONG                       m_Generation;      // Lets the effects keep the result of Find
+    CRITICAL_SECTION                    m_Lock;
+};
+
+extern CEffectStateFilterList g_EffectStateFilters;
+
+// Totals of the buffer updates made by Apply
+void GetUploadStats(D3DX11_EFFECT_UPLOAD_STATS *pStats);
+
+//////////////////////////////////////////////////////////////////////////
+// SPrivateConstantBuffer - an apply context's copy of a cbuffer
+//
+// Its own buffer and values, so that the threads recording with the same
+// effect neither write the effect's backing stores nor share a buffer.
+// The copy is taken from the effect when it is made and again whenever
+// the effect's values change (Version); what the context wrote with
+// SetRawValue is kept until then.
+//////////////////////////////////////////////////////////////////////////
+
+struct SPrivateConstantBuffer
+{
+    ID3D11Buffer                *pD3DObject;
+    ID3D11ShaderResourceView    *pShaderResource;   // tbuffers only
+    BYTE                        *pBackingStore;
+    UINT                        Version;            // Of the effect's values last copied
+
+    BOOL                        IsDirty;
+    UINT                        DirtyStart;
+    UINT                        DirtyEnd;
+
+    SPrivateConstantBuffer()
+    {
+        pD3DObject = NULL;
+        pShaderResource = NULL;
+        pBackingStore = NULL;
+        Version = 0;
+        IsDirty = FALSE;
+        DirtyStart = 0;
+        DirtyEnd = 0;
+    }
+
+    ~SPrivateConstantBuffer()
+    {
+        SAFE_RELEASE(pD3DObject);
+        SAFE_RELEASE(pShaderResource);
+        SAFE_DELETE_ARRAY(pBackingStore);
+    }
+
+    D3DX11INLINE void MarkDirty(UINT Offset, UINT ByteCount)
+    {
+        if (!IsDirty)
+        {
+            DirtyStart = Offset;
+            DirtyEnd = Offset + ByteCount;
+            IsDirty = TRUE;
+        }
+        else
+        {
+            DirtyStart = min(DirtyStart, Offset);
+            DirtyEnd = max(DirtyEnd, Offset + ByteCount);
+        }
+    }
+
+    // Take the effect's values again if they changed since the last copy
+    D3DX11INLINE void Refresh(SConstantBuffer *pCB)
+    {
+        UINT EffectVersion = pCB->GetVersion();
+
+        if (Version != EffectVersion)
+        {
+            memcpy(pBackingStore, pCB->pBackingStore, pCB->Size);
+            Version = EffectVersion;
+            MarkDirty(0, pCB->Size);
+        }
+    }
+};
+
+// What one Apply works with. ID3DX11EffectPass::Apply fills it on the stack
+// and updates the effect's own buffers; an apply context passes its filter
+// and its copies of the effect's cbuffers.
+struct SApplyState
+{
+    ID3D11DeviceContext         *pContext;
+    CEffectStateFilter          *pStateFilter;      // NULL if filtering is not enabled on pContext
+    SPrivateConstantBuffer      *pPrivateCBs;       // [m_CBCount] of the effect, NULL to use its own
+};
+
 class CEffectReflection
 {
 public:
@@ -1023,12 +1360,15 @@ class CEffect : public ID3DX11Effect
     friend struct SPassBlock;
     friend class CEffectLoader;
     friend struct SConstantBuffer;
+    friend struct STechnique;
+    friend struct SGroup;
     friend struct TSamplerVariable<TGlobalVariable<ID3DX11EffectSamplerVariable>>;
     friend struct TSamplerVariable<TVariable<TMember<ID3DX11EffectSamplerVariable>>>;
+    friend class CEffectApplyContext;
     
 protected:
 
-    UINT                    m_RefCount;
+    volatile LONG           m_RefCount;         // Effects are AddRef'd and released from any thread
     UINT                    m_Flags;
 
     // Private heap - all pointers should point into here
@@ -1098,9 +1438,14 @@ protected:
     UINT                    m_FXLIndex;
 
     ID3D11Device            *m_pDevice;
-    ID3D11DeviceContext     *m_pContext;
     ID3D11ClassLinkage      *m_pClassLinkage;
 
+    // Held while a pass is evaluated (the timer, the assignments and the
+    // state blocks they recreate), and through the whole of an
+    // ID3DX11EffectPass::Apply, which also updates the effect's buffers.
+    // The state of an Apply itself is in SApplyState.
+    CRITICAL_SECTION        m_ApplyLock;
+
     // Master lists of reflection interfaces
     CEffectVectorOwner<SSingleElementType> m_pTypeInterfaces;
     CEffectVectorOwner<SMember>            m_pMemberInterfaces;
@@ -1130,14 +1475,34 @@ protected:
 
     HRESULT OptimizeTypes(CPointerMappingTable *pMappingTable, bool Cloning = false);
 
+    //////////////////////////////////////////////////////////////////////////    
+    // Name lookup
+
+    // Indices of the named variables, constant buffers, groups, techniques
+    // (scoped by group index) and passes (scoped by technique index, as in
+    // GetTechniqueByIndex). Only IndexLoadedNames and BuildNameTables fill
+    // them, the lookups just read them. All are dropped by Optimize().
+    CEffectNameTable        m_VariableNames;
+    CEffectNameTable        m_CBNames;
+    CEffectNameTable        m_GroupNames;
+    CEffectNameTable        m_TechniqueNames;
+    CEffectNameTable        m_PassNames;
+
+    HRESULT IndexLoadedNames();
+    HRESULT BuildNameTables();
+    HRESULT CopyNameTables( CEffect* pEffectSource );
+    void CleanupNameTables();
+
 
     //////////////////////////////////////////////////////////////////////////    
     // Runtime (performance critical)
     
-    void ApplyShaderBlock(SShaderBlock *pBlock);
+    void EvaluateShaderBlock(SShaderBlock *pBlock);
+    void EvaluatePassBlock(SPassBlock *pBlock);
+    void ApplyShaderBlock(SShaderBlock *pBlock, SApplyState *pState);
     BOOL ApplyRenderStateBlock(SBaseBlock *pBlock);
     BOOL ApplySamplerBlock(SSamplerBlock *pBlock);
-    void ApplyPassBlock(SPassBlock *pBlock);
+    void ApplyPassBlock(SPassBlock *pBlock, SApplyState *pState);
     BOOL EvaluateAssignment(SAssignment *pAssignment);
     BOOL ValidateShaderBlock( SShaderBlock* pBlock );
     BOOL ValidatePassBlock( SPassBlock* pBlock );
@@ -1149,6 +1514,9 @@ protected:
     SGlobalVariable *FindVariableByName(LPCSTR pVarName);
     SVariable *FindVariableByNameWithParsing(LPCSTR pVarName);
     SConstantBuffer *FindCB(LPCSTR pName);
+    SGroup *FindGroup(LPCSTR pName);
+    STechnique *FindTechnique(SGroup *pGroup, LPCSTR pName);
+    SPassBlock *FindPass(STechnique *pTechnique, LPCSTR pName);
     void ReplaceCBReference(SConstantBuffer *pOldBufferBlock, ID3D11Buffer *pNewBuffer);            // Used by user-managed CBs
     void ReplaceSamplerReference(SSamplerBlock *pOldSamplerBlock, ID3D11SamplerState *pNewSampler);
     void AddRefAllForCloning( CEffect* pEffectSource );
@@ -1157,6 +1525,10 @@ protected:
     HRESULT CopyTypePool( CEffect* pEffectSource, CPointerMappingTable& mappingTableTypes, CPointerMappingTable& mappingTableStrings );
     HRESULT CopyOptimizedTypePool( CEffect* pEffectSource, CPointerMappingTable& mappingTableTypes );
     HRESULT RecreateCBs();
+    HRESULT GetCBLayout(SConstantBuffer *pCB, CEffectVector<BYTE> *pLayout);
+    void RebaseCBData(SConstantBuffer *pCB, BYTE *pOldStore);
+    void RebaseAssignments(SBaseBlock *pBlock, SConstantBuffer *pCB, BYTE *pOldStore);
+    HRESULT ShareConstantBuffers();
     HRESULT FixupMemberInterface( SMember* pMember, CEffect* pEffectSource, CPointerMappingTable& mappingTableStrings );
 
     void ValidateIndex(UINT Elements);
@@ -1181,6 +1553,7 @@ public:
     
     BOOL IsReflectionData(void *pData) const { return m_pReflection->m_Heap.IsInHeap(pData); }
     BOOL IsRuntimeData(void *pData) const { return m_Heap.IsInHeap(pData); }
+    BOOL IsSharedData(void *pData) const;
 
     //////////////////////////////////////////////////////////////////////////    
     // Public interface
@@ -1223,4 +1596,51 @@ public:
 
 };
 
+//////////////////////////////////////////////////////////////////////////
+// CEffectApplyContext - ID3DX11EffectApplyContext implementation
+//
+// The per apply state of the effects it applies: its context, the state
+// filter of that context, and a copy of each effect's cbuffers. Only the
+// evaluation of a pass takes the lock of its effect; the buffer updates
+// and the state setting calls only read the effect.
+//////////////////////////////////////////////////////////////////////////
+
+class CEffectApplyContext : public ID3DX11EffectApplyContext
+{
+public:
+    CEffectApplyContext(ID3D11DeviceContext *pContext);
+    virtual ~CEffectApplyContext();
+
+    // IUnknown
+    STDMETHOD(QueryInterface)(REFIID iid, LPVOID *ppv);
+    STDMETHOD_(ULONG, AddRef)();
+    STDMETHOD_(ULONG, Release)();
+
+    STDMETHOD(GetContext)(ID3D11DeviceContext** ppContext);
+    STDMETHOD(Apply)(ID3DX11EffectPass *pPass, UINT Flags);
+    STDMETHOD(SetRawValue)(ID3DX11EffectVariable *pVariable, CONST void *pData, UINT ByteOffset, UINT ByteCount);
+    STDMETHOD(Reset)();
+
+protected:
+    struct SEffectCopy
+    {
+        CEffect                 *pEffect;           // AddRef'd
+        SPrivateConstantBuffer  *pCBs;              // [pEffect->m_CBCount]
+    };
+
+    // The copy of the buffers of pEffect, made the first time it is asked for
+    HRESULT GetEffectCopy(CEffect *pEffect, SEffectCopy **ppCopy);
+    HRESULT CreatePrivateCB(CEffect *pEffect, SConstantBuffer *pCB, SPrivateConstantBuffer *pPrivate);
+
+    volatile LONG                       m_RefCount;
+    ID3D11DeviceContext                 *m_pContext;
+    CEffectVector<SEffectCopy>          m_Effects;
+    UINT                                m_LastEffect;       // Index of the last effect found
+
+    // Last filter lookup (holds a reference on the filter), redone when the
+    // enabled filters change
+    CEffectStateFilter                  *m_pStateFilter;
+    LONG                                m_FilterGeneration;
+};
+
 }
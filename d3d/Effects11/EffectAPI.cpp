@@ -27,3 +27,73 @@ lExit:
     }
     return hr;
 }
+
+HRESULT WINAPI D3DX11CreateEffectApplyContext(ID3D11DeviceContext *pContext, ID3DX11EffectApplyContext **ppApplyContext)
+{
+    HRESULT hr = S_OK;
+
+    if (NULL == pContext || NULL == ppApplyContext)
+    {
+        DPF(0, "D3DX11CreateEffectApplyContext: pContext and ppApplyContext cannot be NULL");
+        return D3DERR_INVALIDCALL;
+    }
+
+    VN( *ppApplyContext = NEW CEffectApplyContext(pContext) );
+
+lExit:
+    return hr;
+}
+
+HRESULT WINAPI D3DX11EnableEffectStateFilter(ID3D11DeviceContext *pContext, BOOL Enable)
+{
+    if (NULL == pContext)
+    {
+        DPF(0, "D3DX11EnableEffectStateFilter: pContext cannot be NULL");
+        return D3DERR_INVALIDCALL;
+    }
+
+    return g_EffectStateFilters.Enable(pContext, Enable);
+}
+
+HRESULT WINAPI D3DX11InvalidateEffectStateFilter(ID3D11DeviceContext *pContext)
+{
+    CEffectStateFilter *pFilter = g_EffectStateFilters.Find(pContext);
+
+    if (NULL == pFilter)
+    {
+        DPF(0, "D3DX11InvalidateEffectStateFilter: state filtering is not enabled on pContext");
+        return D3DERR_INVALIDCALL;
+    }
+
+    pFilter->Invalidate();
+    pFilter->Release();
+    return S_OK;
+}
+
+HRESULT WINAPI D3DX11GetEffectStateFilterStats(ID3D11DeviceContext *pContext, D3DX11_EFFECT_STATE_FILTER_STATS *pStats)
+{
+    CEffectStateFilter *pFilter = g_EffectStateFilters.Find(pContext);
+
+    if (NULL == pFilter || NULL == pStats)
+    {
+        DPF(0, "D3DX11GetEffectStateFilterStats: state filtering is not enabled on pContext, or pStats is NULL");
+        SAFE_RELEASE(pFilter);
+        return D3DERR_INVALIDCALL;
+    }
+
+    pFilter->GetStats(pStats);
+    pFilter->Release();
+    return S_OK;
+}
+
+HRESULT WINAPI D3DX11GetEffectUploadStats(D3DX11_EFFECT_UPLOAD_STATS *pStats)
+{
+    if (NULL == pStats)
+    {
+        DPF(0, "D3DX11GetEffectUploadStats: pStats cannot be NULL");
+        return D3DERR_INVALIDCALL;
+    }
+
+    GetUploadStats(pStats);
+    return S_OK;
+}
@@ -828,6 +828,11 @@ HRESULT CEffectLoader::LoadEffect(CEffect *pEffect, CONST void *pEffectBuffer, U
     VHD( m_msStructured.Seek(oStructured), "Invalid pEffectBuffer: Missing structured data block." );
     VH( m_msUnstructured.SetData(m_pData + sizeof(SBinaryHeader5), oStructured - sizeof(SBinaryHeader5)) );
 
+    // Variables and CBs are looked up by name while loading, IndexLoadedNames
+    // adds them as they come
+    VH( m_pEffect->m_VariableNames.Reserve(m_pHeader->Effect.cObjectVariables + m_pHeader->Effect.cNumericVariables + m_pHeader->cInterfaceVariables) );
+    VH( m_pEffect->m_CBNames.Reserve(m_pHeader->Effect.cCBs) );
+
     VH( LoadCBs() );
     VH( LoadObjectVariables() );
     VH( LoadInterfaceVariables() );
@@ -881,6 +886,8 @@ HRESULT CEffectLoader::LoadEffect(CEffect *pEffect, CONST void *pEffectBuffer, U
     VBD( m_pEffect->m_SamplerBlockCount == m_pHeader->cSamplers, "Internal loading error: mismatched sampler count." );
     VBD( m_pEffect->m_StringCount == m_pHeader->cStrings, "Internal loading error: mismatched string count." );
 
+    VH( m_pEffect->BuildNameTables() );
+
     // Uncomment if you really need this information
     // DPF(0, "Effect heap size: %d, reflection heap size: %d, allocations avoided: %d", m_EffectMemory, m_ReflectionMemory, m_BulkHeap.m_cAllocations);
     
@@ -1331,6 +1338,7 @@ HRESULT CEffectLoader::LoadCBs()
     }
 
     m_pEffect->m_CBCount = m_pHeader->Effect.cCBs;
+    VH( m_pEffect->IndexLoadedNames() );
 
 lExit:
     return hr;
@@ -1937,6 +1945,7 @@ HRESULT CEffectLoader::LoadObjectVariables()
         VHD( GetStringAndAddToReflection(psBlock->oSemantic, &pVar->pSemantic), "Invalid pEffectBuffer: cannot read object variable semantic." );
 
         m_pEffect->m_VariableCount++;
+        VH( m_pEffect->IndexLoadedNames() );
         elementsToRead = max(1, pType->Elements);
         chkElementsTotal = elementsToRead;
 
@@ -2268,6 +2277,7 @@ HRESULT CEffectLoader::LoadInterfaceVariables()
         VHD( GetStringAndAddToReflection(psBlock->oName, &pVar->pName), "Invalid pEffectBuffer: cannot read interface name." );
 
         m_pEffect->m_VariableCount++;
+        VH( m_pEffect->IndexLoadedNames() );
         elementsToRead = max(1, pType->Elements);
         chkElementsTotal = elementsToRead;
 
@@ -3683,10 +3693,21 @@ HRESULT CEffectLoader::ReallocateEffectData( bool Cloning )
                 pCB->pMemberData = (SMemberDataPointer*)( (BYTE*)m_pEffect->m_pMemberDataBlocks + ( pCB->MemberDataOffsetPlus4 - 4 ) );
             }
         }
-        else if (pCB->pMemberData)
+        else
         {
-            // When cloning an effect, pMemberData points to valid data in the original effect
-            VH( FixupMemberDataPointer( &pCB->pMemberData ) );
+            // The backing store was just copied out of the shared one: the clone
+            // gets a private cbuffer, shared again after RecreateCBs
+            if( pCB->pShared )
+            {
+                g_SharedConstantBuffers.Release( pCB->pShared );
+                pCB->pShared = NULL;
+            }
+
+            if (pCB->pMemberData)
+            {
+                // When cloning an effect, pMemberData points to valid data in the original effect
+                VH( FixupMemberDataPointer( &pCB->pMemberData ) );
+            }
         }
     }
 
@@ -3893,7 +3914,8 @@ HRESULT CEffectLoader::ReallocateEffectData( bool Cloning )
         {
             if( pMember->pType->BelongsInConstantBuffer() )
             {
-                D3DXASSERT( pMember->Data.pGeneric == NULL || (*ppTopLevelEntity)->pEffect->m_Heap.IsInHeap(pMember->Data.pGeneric) );
+                D3DXASSERT( pMember->Data.pGeneric == NULL || (*ppTopLevelEntity)->pEffect->m_Heap.IsInHeap(pMember->Data.pGeneric) ||
+                            (*ppTopLevelEntity)->pEffect->IsSharedData(pMember->Data.pGeneric) );
                 pMember->Data.Offset = (UINT)( (BYTE*)pMember->Data.pGeneric - (BYTE*)(*ppTopLevelEntity)->pCB->pBackingStore );
             }
             if( bGlobalMemberDataBlock && pMember->pMemberData )
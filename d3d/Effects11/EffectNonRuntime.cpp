@@ -706,7 +706,7 @@ CEffect::CEffect( UINT Flags )
     m_pDepthStencilViews = NULL;
     m_pDevice = NULL;
     m_pClassLinkage = NULL;
-    m_pContext = NULL;
+    InitializeCriticalSection(&m_ApplyLock);
 
     m_VariableCount = 0;
     m_AnonymousShaderCount = 0;
@@ -780,6 +780,7 @@ CEffect::~CEffect()
     }
 
     SAFE_DELETE( m_pReflection );
+    DeleteCriticalSection( &m_ApplyLock );
     SAFE_DELETE( m_pTypePool );
     SAFE_DELETE( m_pStringPool );
     SAFE_DELETE( m_pPooledHeap );
@@ -876,6 +877,12 @@ CEffect::~CEffect()
         {
             SAFE_RELEASE(m_pCBs[i].TBuffer.pShaderResource);
             SAFE_RELEASE(m_pCBs[i].pD3DObject);
+
+            if (m_pCBs[i].pShared)
+            {
+                g_SharedConstantBuffers.Release(m_pCBs[i].pShared);
+                m_pCBs[i].pShared = NULL;
+            }
         }
 
         D3DXASSERT(NULL == m_pShaderBlocks || m_Heap.IsInHeap(m_pShaderBlocks));
@@ -887,7 +894,6 @@ CEffect::~CEffect()
         SAFE_RELEASE( m_pDevice );
     }
     SAFE_RELEASE( m_pClassLinkage );
-    D3DXASSERT( m_pContext == NULL );
 
     // Restore debug spew
     if (pInfoQueue)
@@ -1000,6 +1006,11 @@ void CEffect::AddRefAllForCloning( CEffect* pEffectSource )
     {
         SAFE_ADDREF(m_pCBs[i].TBuffer.pShaderResource);
         SAFE_ADDREF(m_pCBs[i].pD3DObject);
+
+        if (m_pCBs[i].pShared)
+        {
+            g_SharedConstantBuffers.AddRef(m_pCBs[i].pShared);
+        }
     }
 
     D3DXASSERT(NULL == m_pShaderBlocks || pEffectSource->m_Heap.IsInHeap(m_pShaderBlocks));
@@ -1011,7 +1022,6 @@ void CEffect::AddRefAllForCloning( CEffect* pEffectSource )
     SAFE_ADDREF( m_pDevice );
 
     SAFE_ADDREF( m_pClassLinkage );
-    D3DXASSERT( m_pContext == NULL );
 }
 
 HRESULT CEffect::QueryInterface(REFIID iid, LPVOID *ppv)
@@ -1047,14 +1057,16 @@ EXIT:
 
 ULONG CEffect::AddRef()
 {
-    return ++ m_RefCount;
+    return InterlockedIncrement(&m_RefCount);
 }
 
 ULONG CEffect::Release()
 {
-    if (-- m_RefCount > 0)
+    LONG RefCount = InterlockedDecrement(&m_RefCount);
+
+    if (RefCount > 0)
     {
-        return m_RefCount;
+        return RefCount;
     }
     else
     {
@@ -1100,6 +1112,276 @@ void CEffect::ReplaceSamplerReference(SSamplerBlock *pOldSamplerBlock, ID3D11Sam
     }
 }
 
+//////////////////////////////////////////////////////////////////////////
+// CSharedConstantBufferList
+//////////////////////////////////////////////////////////////////////////
+
+CSharedConstantBufferList g_SharedConstantBuffers;
+
+CSharedConstantBufferList::CSharedConstantBufferList()
+{
+    InitializeCriticalSection(&m_Lock);
+}
+
+CSharedConstantBufferList::~CSharedConstantBufferList()
+{
+    // The effects release their cbuffers, the entries of the effects still
+    // alive at exit are left to them
+    DeleteCriticalSection(&m_Lock);
+}
+
+HRESULT CSharedConstantBufferList::Acquire(ID3D11Device *pDevice, SConstantBuffer *pCB, CONST BYTE *pLayout, UINT LayoutSize, SSharedConstantBuffer **ppShared)
+{
+    HRESULT hr = S_OK;
+    SSharedConstantBuffer *pShared = NULL;
+    UINT hash = ComputeHash((BYTE*) pLayout, LayoutSize);
+    UINT i;
+
+    EnterCriticalSection(&m_Lock);
+
+    for (i = 0; i < m_Buffers.GetSize(); ++ i)
+    {
+        SSharedConstantBuffer *pEntry = m_Buffers[i];
+
+        if (pEntry->LayoutHash == hash && pEntry->pDevice == pDevice && pEntry->Size == pCB->Size &&
+            pEntry->Layout.GetSize() == LayoutSize && 0 == memcmp(pEntry->Layout.GetData(), pLayout, LayoutSize))
+        {
+            pShared = pEntry;
+            break;
+        }
+    }
+
+    if (NULL == pShared)
+    {
+        // The first effect gives its buffer and its initial values
+        VN( pShared = NEW SSharedConstantBuffer );
+        VN( pShared->pBackingStore = NEW BYTE[pCB->Size] );
+        VH( pShared->Layout.AddRange(pLayout, LayoutSize) );
+        memcpy(pShared->pBackingStore, pCB->pBackingStore, pCB->Size);
+        pShared->pDevice = pDevice;
+        pShared->pD3DObject = pCB->pD3DObject;
+        pShared->pD3DObject->AddRef();
+        pShared->Size = pCB->Size;
+        pShared->LayoutHash = hash;
+        pShared->MarkDirty(0, pCB->Size);
+        VH( m_Buffers.Add(pShared) );
+    }
+
+    ++ pShared->RefCount;
+    *ppShared = pShared;
+    pShared = NULL;
+
+lExit:
+    SAFE_DELETE(pShared);
+    LeaveCriticalSection(&m_Lock);
+    return hr;
+}
+
+void CSharedConstantBufferList::AddRef(SSharedConstantBuffer *pShared)
+{
+    EnterCriticalSection(&m_Lock);
+    ++ pShared->RefCount;
+    LeaveCriticalSection(&m_Lock);
+}
+
+void CSharedConstantBufferList::Release(SSharedConstantBuffer *pShared)
+{
+    UINT i;
+
+    EnterCriticalSection(&m_Lock);
+
+    D3DXASSERT(pShared->RefCount > 0);
+    if (0 == -- pShared->RefCount)
+    {
+        for (i = 0; i < m_Buffers.GetSize(); ++ i)
+        {
+            if (m_Buffers[i] == pShared)
+            {
+                m_Buffers.QuickDelete(i);
+                break;
+            }
+        }
+        SAFE_DELETE(pShared);
+    }
+
+    LeaveCriticalSection(&m_Lock);
+}
+
+static HRESULT AddLayoutData(CEffectVector<BYTE> *pLayout, CONST void *pData, UINT Size)
+{
+    return pLayout->AddRange((CONST BYTE*) pData, Size);
+}
+
+static HRESULT AddLayoutString(CEffectVector<BYTE> *pLayout, LPCSTR pString)
+{
+    if (NULL == pString)
+        pString = "";
+
+    return AddLayoutData(pLayout, pString, (UINT) strlen(pString) + 1);
+}
+
+// What two effects must agree on to share a cbuffer: its name and size, how
+// its buffer is updated, and the name, type and place of every variable
+HRESULT CEffect::GetCBLayout(SConstantBuffer *pCB, CEffectVector<BYTE> *pLayout)
+{
+    HRESULT hr = S_OK;
+    BOOL isDynamic = pCB->IsDynamic;
+    UINT i;
+
+    VH( AddLayoutString(pLayout, pCB->pName) );
+    VH( AddLayoutData(pLayout, &pCB->Size, sizeof(pCB->Size)) );
+    VH( AddLayoutData(pLayout, &isDynamic, sizeof(isDynamic)) );
+    VH( AddLayoutData(pLayout, &pCB->VariableCount, sizeof(pCB->VariableCount)) );
+
+    for (i = 0; i < pCB->VariableCount; ++ i)
+    {
+        SGlobalVariable *pVariable = &pCB->pVariables[i];
+        UINT offset = (UINT) (pVariable->Data.pNumeric - pCB->pBackingStore);
+
+        VH( AddLayoutString(pLayout, pVariable->pName) );
+        VH( AddLayoutString(pLayout, pVariable->pType->pTypeName) );
+        VH( AddLayoutData(pLayout, &offset, sizeof(offset)) );
+        VH( AddLayoutData(pLayout, &pVariable->pType->Elements, sizeof(pVariable->pType->Elements)) );
+        VH( AddLayoutData(pLayout, &pVariable->pType->TotalSize, sizeof(pVariable->pType->TotalSize)) );
+    }
+
+lExit:
+    return hr;
+}
+
+// Points the data of the variables, members and assignments of pCB, which
+// was in pOldStore, into its current backing store
+void CEffect::RebaseCBData(SConstantBuffer *pCB, BYTE *pOldStore)
+{
+    UINT i, j;
+
+    for (i = 0; i < pCB->VariableCount; ++ i)
+    {
+        pCB->pVariables[i].Data.pNumeric = pCB->pBackingStore + (pCB->pVariables[i].Data.pNumeric - pOldStore);
+    }
+
+    for (i = 0; i < m_pMemberInterfaces.GetSize(); ++ i)
+    {
+        SMember *pMember = m_pMemberInterfaces[i];
+
+        if (pMember && pMember->pType->BelongsInConstantBuffer() && pMember->Data.pNumeric &&
+            ((SGlobalVariable*) pMember->pTopLevelEntity)->pCB == pCB)
+        {
+            pMember->Data.pNumeric = pCB->pBackingStore + (pMember->Data.pNumeric - pOldStore);
+        }
+    }
+
+    // Numeric assignments read the variable from the backing store
+    for (UINT iGroup = 0; iGroup < m_GroupCount; ++ iGroup)
+    {
+        for (i = 0; i < m_pGroups[iGroup].TechniqueCount; ++ i)
+        {
+            for (j = 0; j < m_pGroups[iGroup].pTechniques[i].PassCount; ++ j)
+            {
+                RebaseAssignments(&m_pGroups[iGroup].pTechniques[i].pPasses[j], pCB, pOldStore);
+            }
+        }
+    }
+
+    for (i = 0; i < m_DepthStencilBlockCount; ++ i)
+    {
+        RebaseAssignments(&m_pDepthStencilBlocks[i], pCB, pOldStore);
+    }
+
+    for (i = 0; i < m_RasterizerBlockCount; ++ i)
+    {
+        RebaseAssignments(&m_pRasterizerBlocks[i], pCB, pOldStore);
+    }
+
+    for (i = 0; i < m_BlendBlockCount; ++ i)
+    {
+        RebaseAssignments(&m_pBlendBlocks[i], pCB, pOldStore);
+    }
+
+    for (i = 0; i < m_SamplerBlockCount; ++ i)
+    {
+        RebaseAssignments(&m_pSamplerBlocks[i], pCB, pOldStore);
+    }
+}
+
+void CEffect::RebaseAssignments(SBaseBlock *pBlock, SConstantBuffer *pCB, BYTE *pOldStore)
+{
+    for (UINT i = 0; i < pBlock->AssignmentCount; ++ i)
+    {
+        SAssignment *pAssignment = &pBlock->pAssignments[i];
+
+        switch (pAssignment->AssignmentType)
+        {
+        case ERAT_NumericVariable:
+        case ERAT_NumericConstIndex:
+        case ERAT_NumericVariableIndex:
+            // the variable or variable array is always the last dependency in the chain
+            if (pAssignment->pDependencies[pAssignment->DependencyCount - 1].pVariable->pCB == pCB)
+                pAssignment->Source.pNumeric = pCB->pBackingStore + (pAssignment->Source.pNumeric - pOldStore);
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+// With D3DX11_EFFECT_SHARED_CONSTANT_BUFFERS, moves the cbuffers onto the
+// buffers and backing stores shared with the other effects of the device.
+// An effect joining a cbuffer that is already shared takes its current
+// values, the initial values of its own file are dropped. Tbuffers, and
+// the single cbuffers of clones, stay private.
+HRESULT CEffect::ShareConstantBuffers()
+{
+    HRESULT hr = S_OK;
+    CEffectVector<BYTE> layout;
+    UINT i;
+
+    for (i = 0; i < m_CBCount; ++ i)
+    {
+        SConstantBuffer *pCB = &m_pCBs[i];
+        SSharedConstantBuffer *pShared = NULL;
+        BYTE *pOldStore = pCB->pBackingStore;
+
+        D3DXASSERT(NULL == pCB->pShared);
+        if (0 == pCB->Size || pCB->IsTBuffer || pCB->IsUserManaged || pCB->ClonedSingle() || NULL == pCB->pName)
+            continue;
+
+        layout.Clear();
+        VH( GetCBLayout(pCB, &layout) );
+        VH( g_SharedConstantBuffers.Acquire(m_pDevice, pCB, layout.GetData(), layout.GetSize(), &pShared) );
+
+        pCB->pShared = pShared;
+        pCB->pBackingStore = pShared->pBackingStore;
+        pCB->IsDirty = FALSE;
+        RebaseCBData(pCB, pOldStore);
+
+        if (pCB->pD3DObject != pShared->pD3DObject)
+        {
+            pShared->pD3DObject->AddRef();
+            SAFE_RELEASE(pCB->pD3DObject);
+            pCB->pD3DObject = pShared->pD3DObject;
+            ReplaceCBReference(pCB, pCB->pD3DObject);
+        }
+    }
+
+lExit:
+    return hr;
+}
+
+// Is pData in the backing store of one of the shared cbuffers
+BOOL CEffect::IsSharedData(void *pData) const
+{
+    for (UINT i = 0; i < m_CBCount; ++ i)
+    {
+        SSharedConstantBuffer *pShared = m_pCBs[i].pShared;
+
+        if (pShared && (BYTE*) pData >= pShared->pBackingStore && (BYTE*) pData < pShared->pBackingStore + pShared->Size)
+            return TRUE;
+    }
+    return FALSE;
+}
+
 // Call BindToDevice after the effect has been fully loaded.
 // BindToDevice will release all D3D11 objects and create new ones on the new device
 HRESULT CEffect::BindToDevice(ID3D11Device *pDevice)
@@ -1121,6 +1403,13 @@ HRESULT CEffect::BindToDevice(ID3D11Device *pDevice)
 
     bool featureLevelGE11 = ( pDevice->GetFeatureLevel() >= D3D_FEATURE_LEVEL_11_0 );
 
+    // Only D3D11.1 runtimes and drivers take a box when updating a constant
+    // buffer, older runtimes fail the query
+    BOOL partialCBUpdates = FALSE;
+    SD3D11Options options;
+    if (SUCCEEDED(pDevice->CheckFeatureSupport(c_FeatureD3D11Options, &options, sizeof(options))))
+        partialCBUpdates = options.ConstantBufferPartialUpdate;
+
     pDevice->AddRef();
     SAFE_RELEASE(m_pDevice);
     m_pDevice = pDevice;
@@ -1167,11 +1456,19 @@ HRESULT CEffect::BindToDevice(ID3D11Device *pDevice)
                 bufDesc.CPUAccessFlags = 0;
                 bufDesc.MiscFlags = 0;
 
+                pCB->IsDynamic = (m_Flags & D3DX11_EFFECT_DYNAMIC_CONSTANT_BUFFERS) != 0;
+                if (pCB->IsDynamic)
+                {
+                    bufDesc.Usage = D3D11_USAGE_DYNAMIC;
+                    bufDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+                }
+                pCB->IsPartiallyUpdatable = partialCBUpdates && !pCB->IsDynamic;
+
                 VH( pDevice->CreateBuffer( &bufDesc, NULL, &pCB->pD3DObject) );
                 pCB->TBuffer.pShaderResource = NULL;
             }
 
-            pCB->IsDirty = TRUE;
+            pCB->MarkDirty(0, pCB->Size);
         }
         else
         {
@@ -1179,6 +1476,17 @@ HRESULT CEffect::BindToDevice(ID3D11Device *pDevice)
         }
     }
 
+    if (m_Flags & D3DX11_EFFECT_SHARED_CONSTANT_BUFFERS)
+    {
+        VH( ShareConstantBuffers() );
+    }
+
+    // The state objects are created straight on the device, effect by effect.
+    // No cache is kept across effects: the D3D11 runtime already returns the
+    // same object for the same description (it holds at most 4096 unique
+    // objects of each type per device), so blocks with the same description
+    // in different effects share one object without any help from here.
+
     // Create all RasterizerStates
     SRasterizerBlock *pRB = m_pRasterizerBlocks;
     SRasterizerBlock *pRBLast = m_pRasterizerBlocks + m_RasterizerBlockCount;
@@ -1488,15 +1796,19 @@ SGlobalVariable * CEffect::FindVariableByName(LPCSTR pName)
 
 SGlobalVariable * CEffect::FindLocalVariableByName(LPCSTR pName)
 {
-    SGlobalVariable *pVariable, *pVariableEnd;
+    UINT  hash = ComputeHash(pName);
+    UINT  slot, i;
 
-    pVariableEnd = m_pVariables + m_VariableCount;
-    for (pVariable = m_pVariables; pVariable != pVariableEnd; pVariable++)
+    if (m_VariableNames.FindFirst(hash, 0, &slot, &i))
     {
-        if (strcmp( pVariable->pName, pName) == 0)
+        do
         {
-            return pVariable;
+            if (strcmp(m_pVariables[i].pName, pName) == 0)
+            {
+                return m_pVariables + i;
+            }
         }
+        while (m_VariableNames.FindNext(hash, 0, &slot, &i));
     }
 
     return NULL;
@@ -1630,19 +1942,207 @@ UINT SType::GetTotalPackedSize(BOOL IsSingleElement) CONST
 
 SConstantBuffer *CEffect::FindCB(LPCSTR pName)
 {
-    UINT  i;
+    UINT  hash = ComputeHash(pName);
+    UINT  slot, i;
 
-    for (i=0; i<m_CBCount; i++)
+    if (m_CBNames.FindFirst(hash, 0, &slot, &i))
     {
-        if (!strcmp(m_pCBs[i].pName, pName))
+        do
         {
-            return &m_pCBs[i];
+            if (!strcmp(m_pCBs[i].pName, pName))
+            {
+                return &m_pCBs[i];
+            }
+        }
+        while (m_CBNames.FindNext(hash, 0, &slot, &i));
+    }
+
+    return NULL;
+}
+
+SGroup *CEffect::FindGroup(LPCSTR pName)
+{
+    UINT  hash = ComputeHash(pName);
+    UINT  slot, i;
+
+    if (m_GroupNames.FindFirst(hash, 0, &slot, &i))
+    {
+        do
+        {
+            if (NULL != m_pGroups[i].pName &&
+                strcmp(m_pGroups[i].pName, pName) == 0)
+            {
+                return m_pGroups + i;
+            }
+        }
+        while (m_GroupNames.FindNext(hash, 0, &slot, &i));
+    }
+
+    return NULL;
+}
+
+STechnique *CEffect::FindTechnique(SGroup *pGroup, LPCSTR pName)
+{
+    D3DXASSERT(pGroup >= m_pGroups && pGroup < m_pGroups + m_GroupCount);
+
+    UINT  hash = ComputeHash(pName);
+    UINT  scope = (UINT)(pGroup - m_pGroups);
+    UINT  slot, i;
+
+    if (m_TechniqueNames.FindFirst(hash, scope, &slot, &i))
+    {
+        do
+        {
+            if (NULL != pGroup->pTechniques[i].pName &&
+                strcmp(pGroup->pTechniques[i].pName, pName) == 0)
+            {
+                return pGroup->pTechniques + i;
+            }
+        }
+        while (m_TechniqueNames.FindNext(hash, scope, &slot, &i));
+    }
+
+    return NULL;
+}
+
+SPassBlock *CEffect::FindPass(STechnique *pTechnique, LPCSTR pName)
+{
+    UINT  hash = ComputeHash(pName);
+    UINT  scope = 0;
+    UINT  slot, i;
+
+    // Passes are scoped by the index of their technique in the effect
+    for (i = 0; i < m_GroupCount; ++ i)
+    {
+        if (pTechnique >= m_pGroups[i].pTechniques && pTechnique < m_pGroups[i].pTechniques + m_pGroups[i].TechniqueCount)
+        {
+            break;
+        }
+        scope += m_pGroups[i].TechniqueCount;
+    }
+    D3DXASSERT(i < m_GroupCount);
+    scope += (UINT)(pTechnique - m_pGroups[i].pTechniques);
+
+    if (m_PassNames.FindFirst(hash, scope, &slot, &i))
+    {
+        do
+        {
+            if (NULL != pTechnique->pPasses[i].pName &&
+                strcmp(pTechnique->pPasses[i].pName, pName) == 0)
+            {
+                return pTechnique->pPasses + i;
+            }
         }
+        while (m_PassNames.FindNext(hash, scope, &slot, &i));
     }
 
     return NULL;
 }
 
+// Indexes the variables and CBs loaded since the last call. The loader calls
+// it after adding each of them, as it looks them up by name while loading.
+HRESULT CEffect::IndexLoadedNames()
+{
+    HRESULT hr = S_OK;
+    UINT  i;
+
+    VH( m_VariableNames.Reserve(m_VariableCount) );
+    for (i = m_VariableNames.GetNumEntries(); i < m_VariableCount; ++ i)
+    {
+        VH( m_VariableNames.Add(ComputeHash(m_pVariables[i].pName), 0, i) );
+    }
+
+    VH( m_CBNames.Reserve(m_CBCount) );
+    for (i = m_CBNames.GetNumEntries(); i < m_CBCount; ++ i)
+    {
+        VH( m_CBNames.Add(ComputeHash(m_pCBs[i].pName), 0, i) );
+    }
+
+lExit:
+    return hr;
+}
+
+// Indexes all the names once the effect is loaded
+HRESULT CEffect::BuildNameTables()
+{
+    HRESULT hr = S_OK;
+    UINT  i, j, k;
+    UINT  techniqueIndex = 0;
+    UINT  passCount = 0;
+
+    VH( IndexLoadedNames() );
+
+    for (i = 0; i < m_GroupCount; ++ i)
+    {
+        for (j = 0; j < m_pGroups[i].TechniqueCount; ++ j)
+        {
+            passCount += m_pGroups[i].pTechniques[j].PassCount;
+        }
+    }
+
+    m_GroupNames.Cleanup();
+    m_TechniqueNames.Cleanup();
+    m_PassNames.Cleanup();
+    VH( m_GroupNames.Reserve(m_GroupCount) );
+    VH( m_TechniqueNames.Reserve(m_TechniqueCount) );
+    VH( m_PassNames.Reserve(passCount) );
+
+    for (i = 0; i < m_GroupCount; ++ i)
+    {
+        SGroup *pGroup = m_pGroups + i;
+
+        if (NULL != pGroup->pName)
+        {
+            VH( m_GroupNames.Add(ComputeHash(pGroup->pName), 0, i) );
+        }
+
+        for (j = 0; j < pGroup->TechniqueCount; ++ j, ++ techniqueIndex)
+        {
+            STechnique *pTechnique = pGroup->pTechniques + j;
+
+            if (NULL != pTechnique->pName)
+            {
+                VH( m_TechniqueNames.Add(ComputeHash(pTechnique->pName), i, j) );
+            }
+
+            for (k = 0; k < pTechnique->PassCount; ++ k)
+            {
+                if (NULL != pTechnique->pPasses[k].pName)
+                {
+                    VH( m_PassNames.Add(ComputeHash(pTechnique->pPasses[k].pName), techniqueIndex, k) );
+                }
+            }
+        }
+    }
+
+lExit:
+    return hr;
+}
+
+// The indices are the same in a clone, the tables are copied as they are
+HRESULT CEffect::CopyNameTables( CEffect* pEffectSource )
+{
+    HRESULT hr = S_OK;
+
+    VH( m_VariableNames.Initialize(&pEffectSource->m_VariableNames) );
+    VH( m_CBNames.Initialize(&pEffectSource->m_CBNames) );
+    VH( m_GroupNames.Initialize(&pEffectSource->m_GroupNames) );
+    VH( m_TechniqueNames.Initialize(&pEffectSource->m_TechniqueNames) );
+    VH( m_PassNames.Initialize(&pEffectSource->m_PassNames) );
+
+lExit:
+    return hr;
+}
+
+void CEffect::CleanupNameTables()
+{
+    m_VariableNames.Cleanup();
+    m_CBNames.Cleanup();
+    m_GroupNames.Cleanup();
+    m_TechniqueNames.Cleanup();
+    m_PassNames.Cleanup();
+}
+
 inline UINT  PtrToDword(void *pPtr)
 {
     return (UINT)(UINT_PTR) pPtr;
@@ -1979,7 +2479,7 @@ HRESULT CEffect::RecreateCBs()
                 ReplaceCBReference( pCB, (*ppOriginalBuffer) );
             }
 
-            pCB->IsDirty = TRUE;
+            pCB->MarkDirty(0, pCB->Size);
         }
     }
 
@@ -2136,6 +2636,15 @@ HRESULT CEffect::CloneEffect(UINT Flags, ID3DX11Effect** ppClonedEffect )
     // fixup this effect's variable's types
     VH( pNewEffect->OptimizeTypes(&mappingTableTypes, true) );
     VH( pNewEffect->RecreateCBs() );
+    if( pNewEffect->m_Flags & D3DX11_EFFECT_SHARED_CONSTANT_BUFFERS )
+    {
+        VH( pNewEffect->ShareConstantBuffers() );
+    }
+
+    if( !IsOptimized() )
+    {
+        VH( pNewEffect->CopyNameTables( this ) );
+    }
 
 
     for (UINT i = 0; i < pNewEffect->m_pMemberInterfaces.GetSize(); ++ i)
@@ -2251,6 +2760,9 @@ HRESULT CEffect::Optimize()
         }
     }
 
+    // The names are gone, so are their indices
+    CleanupNameTables();
+
     // Delete annotations and names on CBs
 
     for (i = 0; i < m_CBCount; ++ i)
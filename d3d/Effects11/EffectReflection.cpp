@@ -148,7 +148,7 @@ ID3DX11EffectVariable * CEffect::CreatePooledVariableMemberInterface(TTopLevelVa
             if (!pTopLevelEntity->pType->IsObjectType(EOT_String))
             {
                 // strings are funny; their data is reflection data, so ignore those
-                D3DXASSERT( pTopLevelEntity->pEffect->IsRuntimeData(Data.pGeneric) );
+                D3DXASSERT( pTopLevelEntity->pEffect->IsRuntimeData(Data.pGeneric) || pTopLevelEntity->pEffect->IsSharedData(Data.pGeneric) );
             }
         }
         IsAnnotation = FALSE;
@@ -1114,7 +1114,7 @@ HRESULT SConstantBuffer::SetRawValue(CONST void *pData, UINT  Offset, UINT  Coun
     }
     else
     {
-        IsDirty = TRUE;
+        MarkDirty(Offset, Count);
     }
 
     memcpy(pBackingStore + Offset, pData, Count);
@@ -1579,17 +1579,24 @@ ID3DX11EffectVariable * SPassBlock::GetAnnotationByName(LPCSTR Name)
 
 HRESULT SPassBlock::Apply(UINT  Flags, ID3D11DeviceContext* pContext)
 {
-    HRESULT hr = S_OK;
+    SApplyState State;
 
     // TODO: Flags are not yet implemented    
 
-    D3DXASSERT( pEffect->m_pContext == NULL );
-    pEffect->m_pContext = pContext;
-    pEffect->ApplyPassBlock(this);
-    pEffect->m_pContext = NULL;
+    State.pContext = pContext;
+    State.pStateFilter = g_EffectStateFilters.Find(pContext);
+    State.pPrivateCBs = NULL;
 
-lExit:
-    return hr;
+    // The pass writes the cbuffers and blocks of its effect: the applies of
+    // one effect on several threads take turns (see ID3DX11EffectApplyContext
+    // to record them concurrently)
+    EnterCriticalSection(&pEffect->m_ApplyLock);
+    pEffect->EvaluatePassBlock(this);
+    pEffect->ApplyPassBlock(this, &State);
+    LeaveCriticalSection(&pEffect->m_ApplyLock);
+
+    SAFE_RELEASE(State.pStateFilter);
+    return S_OK;
 }
 
 HRESULT SPassBlock::ComputeStateBlockMask(D3DX11_STATE_BLOCK_MASK *pStateBlockMask)
@@ -1761,24 +1768,21 @@ ID3DX11EffectPass * STechnique::GetPassByName(LPCSTR Name)
 {
     LPCSTR pFuncName = "ID3DX11EffectTechnique::GetPassByName";
 
-    UINT  i;
+    SPassBlock *pPass = NULL;
 
-    for (i = 0; i < PassCount; ++ i)
+    // The passes know their effect, which indexes their names
+    if (PassCount > 0)
     {
-        if (NULL != pPasses[i].pName &&
-            strcmp(pPasses[i].pName, Name) == 0)
-        {
-            break;
-        }
+        pPass = pPasses[0].pEffect->FindPass(this, Name);
     }
 
-    if (i == PassCount)
+    if (NULL == pPass)
     {
         DPF(0, "%s: Pass [%s] not found", pFuncName, Name);
         return &g_InvalidPass;
     }
 
-    return (ID3DX11EffectPass *)(pPasses + i);
+    return (ID3DX11EffectPass *)pPass;
 }
 
 HRESULT STechnique::ComputeStateBlockMask(D3DX11_STATE_BLOCK_MASK *pStateBlockMask)
@@ -1856,24 +1860,40 @@ ID3DX11EffectTechnique * SGroup::GetTechniqueByName(LPCSTR Name)
 {
     LPCSTR pFuncName = "ID3DX11EffectGroup::GetTechniqueByName";
 
+    STechnique *pTechnique = NULL;
     UINT  i;
 
+    // The effect, which indexes the technique names, is found through a pass
     for (i = 0; i < TechniqueCount; ++ i)
     {
-        if (NULL != pTechniques[i].pName &&
-            strcmp(pTechniques[i].pName, Name) == 0)
+        if (pTechniques[i].PassCount > 0)
         {
+            pTechnique = pTechniques[i].pPasses[0].pEffect->FindTechnique(this, Name);
             break;
         }
     }
 
+    // Without passes there is no effect to ask
     if (i == TechniqueCount)
+    {
+        for (i = 0; i < TechniqueCount; ++ i)
+        {
+            if (NULL != pTechniques[i].pName &&
+                strcmp(pTechniques[i].pName, Name) == 0)
+            {
+                pTechnique = pTechniques + i;
+                break;
+            }
+        }
+    }
+
+    if (NULL == pTechnique)
     {
         DPF(0, "%s: Technique [%s] not found", pFuncName, Name);
         return &g_InvalidTechnique;
     }
 
-    return (ID3DX11EffectTechnique *)(pTechniques + i);
+    return (ID3DX11EffectTechnique *)pTechnique;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -1941,14 +1961,10 @@ ID3DX11EffectConstantBuffer * CEffect::GetConstantBufferByName(LPCSTR Name)
         return &g_InvalidConstantBuffer;
     }
 
-    UINT  i;
-
-    for (i = 0; i < m_CBCount; ++ i)
+    SConstantBuffer *pCB = FindCB(Name);
+    if (NULL != pCB)
     {
-        if (strcmp(m_pCBs[i].pName, Name) == 0)
-        {
-            return m_pCBs + i;
-        }
+        return pCB;
     }
 
     DPF(0, "%s: Constant Buffer [%s] not found", pFuncName, Name);
@@ -1985,14 +2001,10 @@ ID3DX11EffectVariable * CEffect::GetVariableByName(LPCSTR Name)
         return &g_InvalidScalarVariable;
     }
 
-    UINT  i;
-
-    for (i = 0; i < m_VariableCount; ++ i)
+    SGlobalVariable *pVariable = FindLocalVariableByName(Name);
+    if (NULL != pVariable)
     {
-        if (strcmp(m_pVariables[i].pName, Name) == 0)
-        {
-            return m_pVariables + i;
-        }
+        return pVariable;
     }
 
     DPF(0, "%s: Variable [%s] not found", pFuncName, Name);
@@ -2128,24 +2140,14 @@ ID3DX11EffectGroup * CEffect::GetGroupByName(LPCSTR Name)
         return m_pNullGroup ? (ID3DX11EffectGroup *)m_pNullGroup : &g_InvalidGroup;
     }
 
-    UINT  i;
-
-    for (i = 0; i < m_GroupCount; ++ i)
-    {
-        if (NULL != m_pGroups[i].pName && 
-            strcmp(m_pGroups[i].pName, Name) == 0)
-        {
-            break;
-        }
-    }
-
-    if (i == m_GroupCount)
+    SGroup *pGroup = FindGroup(Name);
+    if (NULL == pGroup)
     {
         DPF(0, "%s: Group [%s] not found", pFuncName, Name);
         return &g_InvalidGroup;
     }
 
-    return (ID3DX11EffectGroup *)(m_pGroups + i);
+    return (ID3DX11EffectGroup *)pGroup;
 }
 
 }
@@ -128,24 +128,212 @@ BOOL SPassBlock::CheckDependencies()
 }
 
 
+// Buffer updates of all the effects, on any thread
+static volatile LONGLONG g_UploadUpdates = 0;
+static volatile LONGLONG g_UploadDiscardMaps = 0;
+static volatile LONGLONG g_UploadBytes = 0;
+static volatile LONGLONG g_UploadBytesSkipped = 0;
+
+void GetUploadStats(D3DX11_EFFECT_UPLOAD_STATS *pStats)
+{
+    pStats->Updates = (UINT64) g_UploadUpdates;
+    pStats->DiscardMaps = (UINT64) g_UploadDiscardMaps;
+    pStats->BytesUploaded = (UINT64) g_UploadBytes;
+    pStats->BytesSkipped = (UINT64) g_UploadBytesSkipped;
+}
+
+// Send the dirty bytes [start, end) of a backing store to its buffer: the
+// cbuffer's own, or an apply context's copy of it. Returns FALSE when the
+// buffer cannot be mapped; it is left dirty, the next apply retries.
+static BOOL UpdateBuffer_FX(ID3D11DeviceContext *pContext, SConstantBuffer *pCB, ID3D11Buffer *pBuffer, BYTE *pBackingStore, UINT start, UINT end)
+{
+    if (pCB->IsDynamic)
+    {
+        D3D11_MAPPED_SUBRESOURCE mapped;
+
+        if (FAILED(pContext->Map(pBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+            return FALSE;
+
+        start = 0;
+        end = pCB->Size;
+        memcpy(mapped.pData, pBackingStore, pCB->Size);
+        pContext->Unmap(pBuffer, 0);
+        InterlockedIncrement64(&g_UploadDiscardMaps);
+    }
+    else if ((pCB->IsTBuffer || pCB->IsPartiallyUpdatable) && D3D11_DEVICE_CONTEXT_IMMEDIATE == pContext->GetType())
+    {
+        // A tbuffer is a plain buffer, it can be updated in part; a constant
+        // buffer only through D3D11.1. Deferred contexts are left out: drivers
+        // without command lists misplace the source of a boxed update there.
+        D3D11_BOX box;
+
+        start = start & ~(SType::c_RegisterSize - 1);
+        end = min(AlignToPowerOf2(end, SType::c_RegisterSize), pCB->Size);
+
+        box.left = start;
+        box.right = end;
+        box.top = 0;
+        box.bottom = 1;
+        box.front = 0;
+        box.back = 1;
+
+        if (pCB->IsTBuffer)
+        {
+            pContext->UpdateSubresource(pBuffer, 0, &box, pBackingStore + start, 0, 0);
+        }
+        else
+        {
+            ID3D11DeviceContext1_FX *pContext1 = NULL;
+
+            if (SUCCEEDED(pContext->QueryInterface(c_IID_ID3D11DeviceContext1, (void**) &pContext1)))
+            {
+                // No copy flag: the registers outside the box are still in use
+                pContext1->UpdateSubresource1(pBuffer, 0, &box, pBackingStore + start, 0, 0, 0);
+                SAFE_RELEASE(pContext1);
+            }
+            else
+            {
+                start = 0;
+                end = pCB->Size;
+                pContext->UpdateSubresource(pBuffer, 0, NULL, pBackingStore, pCB->Size, pCB->Size);
+            }
+        }
+    }
+    else
+    {
+        start = 0;
+        end = pCB->Size;
+        pContext->UpdateSubresource(pBuffer, 0, NULL, pBackingStore, pCB->Size, pCB->Size);
+    }
+
+    InterlockedIncrement64(&g_UploadUpdates);
+    InterlockedExchangeAdd64(&g_UploadBytes, end - start);
+    InterlockedExchangeAdd64(&g_UploadBytesSkipped, pCB->Size - (end - start));
+    return TRUE;
+}
+
+// Send the dirty part of the backing store to the buffer
+static void UpdateCB_FX(ID3D11DeviceContext *pContext, SConstantBuffer *pCB)
+{
+    UINT start, end;
+
+    pCB->GetDirtyRange(&start, &end);
+    if (UpdateBuffer_FX(pContext, pCB, pCB->pD3DObject, pCB->pBackingStore, start, end))
+        pCB->ClearDirty();
+}
+
 // Update constant buffer contents if necessary
 D3DX11INLINE void CheckAndUpdateCB_FX(ID3D11DeviceContext *pContext, SConstantBuffer *pCB)
 {
-    if (pCB->IsDirty && !pCB->IsNonUpdatable)
+    if (pCB->NeedsUpdate() && !pCB->IsNonUpdatable)
     {
         // CB out of date; rebuild it
-        pContext->UpdateSubresource(pCB->pD3DObject, 0, NULL, pCB->pBackingStore, pCB->Size, pCB->Size);
-        pCB->IsDirty = FALSE;
+        UpdateCB_FX(pContext, pCB);
     }
 }
 
+// The buffer an apply context binds for a cbuffer: its copy, brought up to
+// date with the effect's values and the context's own writes
+D3DX11INLINE ID3D11Buffer *UpdatePrivateCB_FX(ID3D11DeviceContext *pContext, SConstantBuffer *pCB, SPrivateConstantBuffer *pPrivate)
+{
+    if (NULL == pPrivate->pD3DObject || pCB->IsUserManaged)
+    {
+        // Not copied (user managed, or single in a clone): bound as it is
+        return pCB->pD3DObject;
+    }
+
+    pPrivate->Refresh(pCB);
+    if (pPrivate->IsDirty && UpdateBuffer_FX(pContext, pCB, pPrivate->pD3DObject, pPrivate->pBackingStore, pPrivate->DirtyStart, pPrivate->DirtyEnd))
+        pPrivate->IsDirty = FALSE;
+
+    return pPrivate->pD3DObject;
+}
 
-// Set the shader and dependent state (SRVs, samplers, UAVs, interfaces)
-void CEffect::ApplyShaderBlock(SShaderBlock *pBlock)
+// Bring the objects a shader binds up to date with the variables: samplers
+// recreated from their state assignments, views and class instances set
+// since. The arrays are only written when something changed, so that the
+// apply contexts reading them meanwhile see no write at all.
+void CEffect::EvaluateShaderBlock(SShaderBlock *pBlock)
 {
     UINT i;
 
+    SShaderSamplerDependency *pSampDep = pBlock->pSampDeps;
+    SShaderSamplerDependency *pLastSampDep = pBlock->pSampDeps + pBlock->SampDepCount;
+
+    for (; pSampDep<pLastSampDep; pSampDep++)
+    {
+        D3DXASSERT(pSampDep->ppFXPointers);
+
+        for (i=0; i<pSampDep->Count; i++)
+        {
+            if ( ApplyRenderStateBlock(pSampDep->ppFXPointers[i]) )
+            {
+                // If the sampler was updated, its pointer will have changed
+                pSampDep->ppD3DObjects[i] = pSampDep->ppFXPointers[i]->pD3DObject;
+            }
+        }
+    }
+
+    // UAV ranges were combined in EffectLoad
+    D3DXASSERT( pBlock->UAVDepCount < 2 );
+    if( pBlock->UAVDepCount > 0 )
+    {
+        SUnorderedAccessViewDependency *pUAVDep = pBlock->pUAVDeps;
+        D3DXASSERT(pUAVDep->ppFXPointers);
+
+        for (i=0; i<pUAVDep->Count; i++)
+        {
+            if (pUAVDep->ppD3DObjects[i] != pUAVDep->ppFXPointers[i]->pUnorderedAccessView)
+                pUAVDep->ppD3DObjects[i] = pUAVDep->ppFXPointers[i]->pUnorderedAccessView;
+        }
+    }
+
+    SShaderResourceDependency *pResourceDep = pBlock->pResourceDeps;
+    SShaderResourceDependency *pLastResourceDep = pBlock->pResourceDeps + pBlock->ResourceDepCount;
+
+    for (; pResourceDep<pLastResourceDep; pResourceDep++)
+    {
+        D3DXASSERT(pResourceDep->ppFXPointers);
+
+        for (i=0; i<pResourceDep->Count; i++)
+        {
+            if (pResourceDep->ppD3DObjects[i] != pResourceDep->ppFXPointers[i]->pShaderResource)
+                pResourceDep->ppD3DObjects[i] = pResourceDep->ppFXPointers[i]->pShaderResource;
+        }
+    }
+
+    D3DXASSERT( pBlock->InterfaceDepCount < 2 );
+    if( pBlock->InterfaceDepCount > 0 )
+    {
+        SInterfaceDependency *pInterfaceDep = pBlock->pInterfaceDeps;
+        D3DXASSERT(pInterfaceDep->ppFXPointers);
+
+        for (i=0; i<pInterfaceDep->Count; i++)
+        {
+            SClassInstanceGlobalVariable* pCI = pInterfaceDep->ppFXPointers[i]->pClassInstance;
+            ID3D11ClassInstance *pClassInstance = NULL;
+
+            if( pCI )
+            {
+                D3DXASSERT( pCI->pMemberData != NULL );
+                pClassInstance = pCI->pMemberData->Data.pD3DClassInstance;
+            }
+
+            if (pInterfaceDep->ppD3DObjects[i] != pClassInstance)
+                pInterfaceDep->ppD3DObjects[i] = pClassInstance;
+        }
+    }
+}
+
+// Set the shader and dependent state (SRVs, samplers, UAVs, interfaces), as
+// EvaluateShaderBlock left them
+void CEffect::ApplyShaderBlock(SShaderBlock *pBlock, SApplyState *pState)
+{
+    UINT i, j;
+
     SD3DShaderVTable *pVT = pBlock->pVT;
+    ID3D11DeviceContext *pContext = pState->pContext;
+    CEffectStateFilter *pStateFilter = pState->pStateFilter;
 
     // Apply constant buffers first (tbuffers are done later)
     SShaderCBDependency *pCBDep = pBlock->pCBDeps;
@@ -153,14 +341,33 @@ void CEffect::ApplyShaderBlock(SShaderBlock *pBlock)
 
     for (; pCBDep<pLastCBDep; pCBDep++)
     {
+        ID3D11Buffer *pPrivateBuffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+        ID3D11Buffer **ppBuffers = pCBDep->ppD3DObjects;
+
         D3DXASSERT(pCBDep->ppFXPointers);
 
-        for (i = 0; i < pCBDep->Count; ++ i)
+        if (NULL == pState->pPrivateCBs)
         {
-            CheckAndUpdateCB_FX(m_pContext, (SConstantBuffer*)pCBDep->ppFXPointers[i]);
+            for (i = 0; i < pCBDep->Count; ++ i)
+            {
+                CheckAndUpdateCB_FX(pContext, (SConstantBuffer*)pCBDep->ppFXPointers[i]);
+            }
         }
+        else
+        {
+            D3DXASSERT(pCBDep->Count <= D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+            for (i = 0; i < pCBDep->Count; ++ i)
+            {
+                SConstantBuffer *pCB = (SConstantBuffer*)pCBDep->ppFXPointers[i];
 
-        (m_pContext->*(pVT->pSetConstantBuffers))(pCBDep->StartIndex, pCBDep->Count, pCBDep->ppD3DObjects);
+                D3DXASSERT(pCB >= m_pCBs && pCB < m_pCBs + m_CBCount);
+                pPrivateBuffers[i] = UpdatePrivateCB_FX(pContext, pCB, pState->pPrivateCBs + (pCB - m_pCBs));
+            }
+            ppBuffers = pPrivateBuffers;
+        }
+
+        if (NULL == pStateFilter || pStateFilter->SetConstantBuffers(pVT, pCBDep->StartIndex, pCBDep->Count, ppBuffers))
+            (pContext->*(pVT->pSetConstantBuffers))(pCBDep->StartIndex, pCBDep->Count, ppBuffers);
     }
 
     // Next, apply samplers
@@ -169,17 +376,8 @@ void CEffect::ApplyShaderBlock(SShaderBlock *pBlock)
 
     for (; pSampDep<pLastSampDep; pSampDep++)
     {
-        D3DXASSERT(pSampDep->ppFXPointers);
-
-        for (i=0; i<pSampDep->Count; i++)
-        {
-            if ( ApplyRenderStateBlock(pSampDep->ppFXPointers[i]) )
-            {
-                // If the sampler was updated, its pointer will have changed
-                pSampDep->ppD3DObjects[i] = pSampDep->ppFXPointers[i]->pD3DObject;
-            }
-        }
-        (m_pContext->*(pVT->pSetSamplers))(pSampDep->StartIndex, pSampDep->Count, pSampDep->ppD3DObjects);
+        if (NULL == pStateFilter || pStateFilter->SetSamplers(pVT, pSampDep->StartIndex, pSampDep->Count, pSampDep->ppD3DObjects))
+            (pContext->*(pVT->pSetSamplers))(pSampDep->StartIndex, pSampDep->Count, pSampDep->ppD3DObjects);
     }
  
     // Set the UAVs
@@ -188,22 +386,19 @@ void CEffect::ApplyShaderBlock(SShaderBlock *pBlock)
     if( pBlock->UAVDepCount > 0 )
     {
         SUnorderedAccessViewDependency *pUAVDep = pBlock->pUAVDeps;
-        D3DXASSERT(pUAVDep->ppFXPointers);
-
-        for (i=0; i<pUAVDep->Count; i++)
-        {
-            pUAVDep->ppD3DObjects[i] = pUAVDep->ppFXPointers[i]->pUnorderedAccessView;
-        }
 
         if( EOT_ComputeShader5 == pBlock->GetShaderType() )
         {
-            m_pContext->CSSetUnorderedAccessViews( pUAVDep->StartIndex, pUAVDep->Count, pUAVDep->ppD3DObjects, g_pNegativeOnes );
+            pContext->CSSetUnorderedAccessViews( pUAVDep->StartIndex, pUAVDep->Count, pUAVDep->ppD3DObjects, g_pNegativeOnes );
         }
         else
         {
             // This call could be combined with the call to set render targets if both exist in the pass
-            m_pContext->OMSetRenderTargetsAndUnorderedAccessViews( D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL, NULL, NULL, pUAVDep->StartIndex, pUAVDep->Count, pUAVDep->ppD3DObjects, g_pNegativeOnes );
+            pContext->OMSetRenderTargetsAndUnorderedAccessViews( D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL, NULL, NULL, pUAVDep->StartIndex, pUAVDep->Count, pUAVDep->ppD3DObjects, g_pNegativeOnes );
         }
+
+        if (NULL != pStateFilter)
+            pStateFilter->InvalidateShaderResources();
     }
 
     // TBuffers are funny:
@@ -215,7 +410,10 @@ void CEffect::ApplyShaderBlock(SShaderBlock *pBlock)
 
     for (; ppTB<ppLastTB; ppTB++)
     {
-        CheckAndUpdateCB_FX(m_pContext, (SConstantBuffer*)*ppTB);
+        if (NULL == pState->pPrivateCBs)
+            CheckAndUpdateCB_FX(pContext, (SConstantBuffer*)*ppTB);
+        else
+            UpdatePrivateCB_FX(pContext, *ppTB, pState->pPrivateCBs + (*ppTB - m_pCBs));
     }
 
     // Set the textures
@@ -224,44 +422,45 @@ void CEffect::ApplyShaderBlock(SShaderBlock *pBlock)
 
     for (; pResourceDep<pLastResourceDep; pResourceDep++)
     {
-        D3DXASSERT(pResourceDep->ppFXPointers);
+        ID3D11ShaderResourceView *pPrivateViews[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+        ID3D11ShaderResourceView **ppViews = pResourceDep->ppD3DObjects;
 
-        for (i=0; i<pResourceDep->Count; i++)
+        if (NULL != pState->pPrivateCBs && pBlock->TBufferDepCount > 0)
         {
-            pResourceDep->ppD3DObjects[i] = pResourceDep->ppFXPointers[i]->pShaderResource;
+            // The tbuffers are bound through the views of the copies
+            D3DXASSERT(pResourceDep->Count <= D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT);
+            for (i = 0; i < pResourceDep->Count; ++ i)
+            {
+                pPrivateViews[i] = pResourceDep->ppD3DObjects[i];
+                for (j = 0; j < pBlock->TBufferDepCount; ++ j)
+                {
+                    SConstantBuffer *pTB = pBlock->ppTbufDeps[j];
+                    SPrivateConstantBuffer *pPrivate = pState->pPrivateCBs + (pTB - m_pCBs);
+
+                    if (pResourceDep->ppFXPointers[i] == &pTB->TBuffer && NULL != pPrivate->pShaderResource && !pTB->IsUserManaged)
+                        pPrivateViews[i] = pPrivate->pShaderResource;
+                }
+            }
+            ppViews = pPrivateViews;
         }
 
-        (m_pContext->*(pVT->pSetShaderResources))(pResourceDep->StartIndex, pResourceDep->Count, pResourceDep->ppD3DObjects);
+        if (NULL == pStateFilter || pStateFilter->SetShaderResources(pVT, pResourceDep->StartIndex, pResourceDep->Count, ppViews))
+            (pContext->*(pVT->pSetShaderResources))(pResourceDep->StartIndex, pResourceDep->Count, ppViews);
     }
 
-    // Update Interface dependencies
+    // Interface dependencies
     UINT Interfaces = 0;
     ID3D11ClassInstance** ppClassInstances = NULL;
     D3DXASSERT( pBlock->InterfaceDepCount < 2 );
     if( pBlock->InterfaceDepCount > 0 )
     {
-        SInterfaceDependency *pInterfaceDep = pBlock->pInterfaceDeps;
-        D3DXASSERT(pInterfaceDep->ppFXPointers);
-
-        ppClassInstances = pInterfaceDep->ppD3DObjects;
-        Interfaces = pInterfaceDep->Count;
-        for (i=0; i<pInterfaceDep->Count; i++)
-        {
-            SClassInstanceGlobalVariable* pCI = pInterfaceDep->ppFXPointers[i]->pClassInstance;
-            if( pCI )
-            {
-                D3DXASSERT( pCI->pMemberData != NULL );
-                pInterfaceDep->ppD3DObjects[i] = pCI->pMemberData->Data.pD3DClassInstance;
-            }
-            else
-            {
-                pInterfaceDep->ppD3DObjects[i] = NULL;
-            }
-        }
+        ppClassInstances = pBlock->pInterfaceDeps->ppD3DObjects;
+        Interfaces = pBlock->pInterfaceDeps->Count;
     }
 
     // Now set the shader
-    (m_pContext->*(pVT->pSetShader))(pBlock->pD3DObject, ppClassInstances, Interfaces);
+    if (NULL == pStateFilter || pStateFilter->SetShader(pVT, pBlock->pD3DObject, Interfaces))
+        (pContext->*(pVT->pSetShader))(pBlock->pD3DObject, ppClassInstances, Interfaces);
 }
 
 // Returns TRUE if the block D3D data was recreated
@@ -499,44 +698,93 @@ BOOL CEffect::ValidatePassBlock( SPassBlock* pBlock )
     return TRUE;
 }
 
-// Set all state defined in the pass
-void CEffect::ApplyPassBlock(SPassBlock *pBlock)
+// Evaluate the pass: its assignments, the state objects they select (recreated
+// when stale) and the objects its shaders bind. This writes to the effect, the
+// caller holds m_ApplyLock.
+void CEffect::EvaluatePassBlock(SPassBlock *pBlock)
 {
     pBlock->ApplyPassAssignments();
 
     if (NULL != pBlock->BackingStore.pBlendBlock)
     {
         ApplyRenderStateBlock(pBlock->BackingStore.pBlendBlock);
+        if (pBlock->BackingStore.pBlendState != pBlock->BackingStore.pBlendBlock->pBlendObject)
+            pBlock->BackingStore.pBlendState = pBlock->BackingStore.pBlendBlock->pBlendObject;
+    }
+
+    if (NULL != pBlock->BackingStore.pDepthStencilBlock)
+    {
+        ApplyRenderStateBlock(pBlock->BackingStore.pDepthStencilBlock);
+        if (pBlock->BackingStore.pDepthStencilState != pBlock->BackingStore.pDepthStencilBlock->pDSObject)
+            pBlock->BackingStore.pDepthStencilState = pBlock->BackingStore.pDepthStencilBlock->pDSObject;
+    }
+
+    if (NULL != pBlock->BackingStore.pRasterizerBlock)
+        ApplyRenderStateBlock(pBlock->BackingStore.pRasterizerBlock);
+
+    if (NULL != pBlock->BackingStore.pVertexShaderBlock)
+        EvaluateShaderBlock(pBlock->BackingStore.pVertexShaderBlock);
+
+    if (NULL != pBlock->BackingStore.pPixelShaderBlock)
+        EvaluateShaderBlock(pBlock->BackingStore.pPixelShaderBlock);
+
+    if (NULL != pBlock->BackingStore.pGeometryShaderBlock)
+        EvaluateShaderBlock(pBlock->BackingStore.pGeometryShaderBlock);
+
+    if (NULL != pBlock->BackingStore.pHullShaderBlock)
+        EvaluateShaderBlock(pBlock->BackingStore.pHullShaderBlock);
+
+    if (NULL != pBlock->BackingStore.pDomainShaderBlock)
+        EvaluateShaderBlock(pBlock->BackingStore.pDomainShaderBlock);
+
+    if (NULL != pBlock->BackingStore.pComputeShaderBlock)
+        EvaluateShaderBlock(pBlock->BackingStore.pComputeShaderBlock);
+}
+
+// Set all state defined in the pass, as EvaluatePassBlock left it. Only reads
+// the effect: the cbuffers go through the apply context's copies, if any.
+void CEffect::ApplyPassBlock(SPassBlock *pBlock, SApplyState *pState)
+{
+    ID3D11DeviceContext *pContext = pState->pContext;
+    CEffectStateFilter *pStateFilter = pState->pStateFilter;
+
+    if (NULL != pBlock->BackingStore.pBlendBlock)
+    {
 #ifdef FXDEBUG
         if( !pBlock->BackingStore.pBlendBlock->IsValid )
             DPF( 0, "Pass::Apply - warning: applying invalid BlendState." );
 #endif
-        pBlock->BackingStore.pBlendState = pBlock->BackingStore.pBlendBlock->pBlendObject;
-        m_pContext->OMSetBlendState(pBlock->BackingStore.pBlendState,
-            pBlock->BackingStore.BlendFactor,
-            pBlock->BackingStore.SampleMask);
+        if (NULL == pStateFilter || pStateFilter->SetBlendState(pBlock->BackingStore.pBlendState,
+            pBlock->BackingStore.BlendFactor, pBlock->BackingStore.SampleMask))
+        {
+            pContext->OMSetBlendState(pBlock->BackingStore.pBlendState,
+                pBlock->BackingStore.BlendFactor,
+                pBlock->BackingStore.SampleMask);
+        }
     }
 
     if (NULL != pBlock->BackingStore.pDepthStencilBlock)
     {
-        ApplyRenderStateBlock(pBlock->BackingStore.pDepthStencilBlock);
 #ifdef FXDEBUG
         if( !pBlock->BackingStore.pDepthStencilBlock->IsValid )
             DPF( 0, "Pass::Apply - warning: applying invalid DepthStencilState." );
 #endif
-        pBlock->BackingStore.pDepthStencilState = pBlock->BackingStore.pDepthStencilBlock->pDSObject;
-        m_pContext->OMSetDepthStencilState(pBlock->BackingStore.pDepthStencilState,
-            pBlock->BackingStore.StencilRef);
+        if (NULL == pStateFilter || pStateFilter->SetDepthStencilState(pBlock->BackingStore.pDepthStencilState,
+            pBlock->BackingStore.StencilRef))
+        {
+            pContext->OMSetDepthStencilState(pBlock->BackingStore.pDepthStencilState,
+                pBlock->BackingStore.StencilRef);
+        }
     }
 
     if (NULL != pBlock->BackingStore.pRasterizerBlock)
     {
-        ApplyRenderStateBlock(pBlock->BackingStore.pRasterizerBlock);
 #ifdef FXDEBUG
         if( !pBlock->BackingStore.pRasterizerBlock->IsValid )
             DPF( 0, "Pass::Apply - warning: applying invalid RasterizerState." );
 #endif
-        m_pContext->RSSetState(pBlock->BackingStore.pRasterizerBlock->pRasterizerObject);
+        if (NULL == pStateFilter || pStateFilter->SetRasterizerState(pBlock->BackingStore.pRasterizerBlock->pRasterizerObject))
+            pContext->RSSetState(pBlock->BackingStore.pRasterizerBlock->pRasterizerObject);
     }
 
     if (NULL != pBlock->BackingStore.pRenderTargetViews[0])
@@ -553,7 +801,10 @@ void CEffect::ApplyPassBlock(SPassBlock *pBlock)
         }
 
         // This call could be combined with the call to set PS UAVs if both exist in the pass
-        m_pContext->OMSetRenderTargetsAndUnorderedAccessViews( pBlock->BackingStore.RenderTargetViewCount, pRTV, pBlock->BackingStore.pDepthStencilView->pDepthStencilView, 7, D3D11_KEEP_UNORDERED_ACCESS_VIEWS, NULL, NULL );
+        pContext->OMSetRenderTargetsAndUnorderedAccessViews( pBlock->BackingStore.RenderTargetViewCount, pRTV, pBlock->BackingStore.pDepthStencilView->pDepthStencilView, 7, D3D11_KEEP_UNORDERED_ACCESS_VIEWS, NULL, NULL );
+
+        if (NULL != pStateFilter)
+            pStateFilter->InvalidateShaderResources();
     }
 
     if (NULL != pBlock->BackingStore.pVertexShaderBlock)
@@ -562,7 +813,7 @@ void CEffect::ApplyPassBlock(SPassBlock *pBlock)
         if( !pBlock->BackingStore.pVertexShaderBlock->IsValid )
             DPF( 0, "Pass::Apply - warning: applying invalid vertex shader." );
 #endif
-        ApplyShaderBlock(pBlock->BackingStore.pVertexShaderBlock);
+        ApplyShaderBlock(pBlock->BackingStore.pVertexShaderBlock, pState);
     }
 
     if (NULL != pBlock->BackingStore.pPixelShaderBlock)
@@ -571,7 +822,7 @@ void CEffect::ApplyPassBlock(SPassBlock *pBlock)
         if( !pBlock->BackingStore.pPixelShaderBlock->IsValid )
             DPF( 0, "Pass::Apply - warning: applying invalid pixel shader." );
 #endif
-        ApplyShaderBlock(pBlock->BackingStore.pPixelShaderBlock);
+        ApplyShaderBlock(pBlock->BackingStore.pPixelShaderBlock, pState);
     }
 
     if (NULL != pBlock->BackingStore.pGeometryShaderBlock)
@@ -580,7 +831,7 @@ void CEffect::ApplyPassBlock(SPassBlock *pBlock)
         if( !pBlock->BackingStore.pGeometryShaderBlock->IsValid )
             DPF( 0, "Pass::Apply - warning: applying invalid geometry shader." );
 #endif
-        ApplyShaderBlock(pBlock->BackingStore.pGeometryShaderBlock);
+        ApplyShaderBlock(pBlock->BackingStore.pGeometryShaderBlock, pState);
     }
 
     if (NULL != pBlock->BackingStore.pHullShaderBlock)
@@ -589,7 +840,7 @@ void CEffect::ApplyPassBlock(SPassBlock *pBlock)
         if( !pBlock->BackingStore.pHullShaderBlock->IsValid )
             DPF( 0, "Pass::Apply - warning: applying invalid hull shader." );
 #endif
-        ApplyShaderBlock(pBlock->BackingStore.pHullShaderBlock);
+        ApplyShaderBlock(pBlock->BackingStore.pHullShaderBlock, pState);
     }
 
     if (NULL != pBlock->BackingStore.pDomainShaderBlock)
@@ -598,7 +849,7 @@ void CEffect::ApplyPassBlock(SPassBlock *pBlock)
         if( !pBlock->BackingStore.pDomainShaderBlock->IsValid )
             DPF( 0, "Pass::Apply - warning: applying invalid domain shader." );
 #endif
-        ApplyShaderBlock(pBlock->BackingStore.pDomainShaderBlock);
+        ApplyShaderBlock(pBlock->BackingStore.pDomainShaderBlock, pState);
     }
 
     if (NULL != pBlock->BackingStore.pComputeShaderBlock)
@@ -607,7 +858,7 @@ void CEffect::ApplyPassBlock(SPassBlock *pBlock)
         if( !pBlock->BackingStore.pComputeShaderBlock->IsValid )
             DPF( 0, "Pass::Apply - warning: applying invalid compute shader." );
 #endif
-        ApplyShaderBlock(pBlock->BackingStore.pComputeShaderBlock);
+        ApplyShaderBlock(pBlock->BackingStore.pComputeShaderBlock, pState);
     }
 }
 
@@ -691,4 +942,542 @@ void CEffect::HandleLocalTimerRollover()
     }
 }
 
+
+//////////////////////////////////////////////////////////////////////////
+// CEffectStateFilter
+//////////////////////////////////////////////////////////////////////////
+
+extern SD3DShaderVTable g_vtVS;
+extern SD3DShaderVTable g_vtGS;
+extern SD3DShaderVTable g_vtPS;
+extern SD3DShaderVTable g_vtHS;
+extern SD3DShaderVTable g_vtDS;
+extern SD3DShaderVTable g_vtCS;
+
+CEffectStateFilter::CEffectStateFilter(ID3D11DeviceContext *pContext)
+{
+    m_RefCount = 1;
+    m_pContext = pContext;
+    ZeroMemory(&m_Stats, sizeof(m_Stats));
+    Invalidate();
+}
+
+void CEffectStateFilter::Release()
+{
+    if (0 == InterlockedDecrement(&m_RefCount))
+    {
+        delete this;
+    }
+}
+
+void CEffectStateFilter::Invalidate()
+{
+    memset(&m_pBlendState, 0xff, sizeof(m_pBlendState));
+    memset(m_BlendFactor, 0xff, sizeof(m_BlendFactor));
+    memset(&m_SampleMask, 0xff, sizeof(m_SampleMask));
+    memset(&m_pDepthStencilState, 0xff, sizeof(m_pDepthStencilState));
+    memset(&m_StencilRef, 0xff, sizeof(m_StencilRef));
+    memset(&m_pRasterizerState, 0xff, sizeof(m_pRasterizerState));
+    memset(m_Stages, 0xff, sizeof(m_Stages));
+}
+
+void CEffectStateFilter::InvalidateShaderResources()
+{
+    UINT i;
+
+    for (i = 0; i < ES_Count; ++ i)
+    {
+        memset(m_Stages[i].pShaderResources, 0xff, sizeof(m_Stages[i].pShaderResources));
+    }
+}
+
+CEffectStateFilter::SStage *CEffectStateFilter::GetStage(CONST SD3DShaderVTable *pVT)
+{
+    if (&g_vtVS == pVT)
+        return &m_Stages[ES_Vertex];
+    else if (&g_vtPS == pVT)
+        return &m_Stages[ES_Pixel];
+    else if (&g_vtGS == pVT)
+        return &m_Stages[ES_Geometry];
+    else if (&g_vtHS == pVT)
+        return &m_Stages[ES_Hull];
+    else if (&g_vtDS == pVT)
+        return &m_Stages[ES_Domain];
+
+    D3DXASSERT(&g_vtCS == pVT);
+    return &m_Stages[ES_Compute];
+}
+
+BOOL CEffectStateFilter::FilterRange(void **ppBound, UINT StartSlot, UINT Count, void *CONST *ppNew)
+{
+    if (0 == memcmp(ppBound + StartSlot, ppNew, Count * sizeof(void*)))
+    {
+        ++ m_Stats.CallsSkipped;
+        return FALSE;
+    }
+
+    memcpy(ppBound + StartSlot, ppNew, Count * sizeof(void*));
+    ++ m_Stats.CallsIssued;
+    return TRUE;
+}
+
+BOOL CEffectStateFilter::SetBlendState(ID3D11BlendState *pState, CONST FLOAT BlendFactor[4], UINT SampleMask)
+{
+    if (m_pBlendState == pState && m_SampleMask == SampleMask &&
+        0 == memcmp(m_BlendFactor, BlendFactor, sizeof(m_BlendFactor)))
+    {
+        ++ m_Stats.CallsSkipped;
+        return FALSE;
+    }
+
+    m_pBlendState = pState;
+    memcpy(m_BlendFactor, BlendFactor, sizeof(m_BlendFactor));
+    m_SampleMask = SampleMask;
+    ++ m_Stats.CallsIssued;
+    return TRUE;
+}
+
+BOOL CEffectStateFilter::SetDepthStencilState(ID3D11DepthStencilState *pState, UINT StencilRef)
+{
+    if (m_pDepthStencilState == pState && m_StencilRef == StencilRef)
+    {
+        ++ m_Stats.CallsSkipped;
+        return FALSE;
+    }
+
+    m_pDepthStencilState = pState;
+    m_StencilRef = StencilRef;
+    ++ m_Stats.CallsIssued;
+    return TRUE;
+}
+
+BOOL CEffectStateFilter::SetRasterizerState(ID3D11RasterizerState *pState)
+{
+    return FilterRange((void**) &m_pRasterizerState, 0, 1, (void *CONST *) &pState);
+}
+
+BOOL CEffectStateFilter::SetShader(CONST SD3DShaderVTable *pVT, ID3D11DeviceChild *pShader, UINT NumClassInstances)
+{
+    SStage *pStage = GetStage(pVT);
+
+    if (NumClassInstances > 0)
+    {
+        // The class instances are not shadowed, neither is a shader bound with them
+        memset(&pStage->pShader, 0xff, sizeof(pStage->pShader));
+        ++ m_Stats.CallsIssued;
+        return TRUE;
+    }
+
+    return FilterRange((void**) &pStage->pShader, 0, 1, (void *CONST *) &pShader);
+}
+
+BOOL CEffectStateFilter::SetConstantBuffers(CONST SD3DShaderVTable *pVT, UINT StartSlot, UINT NumBuffers, ID3D11Buffer *CONST *ppBuffers)
+{
+    SStage *pStage = GetStage(pVT);
+
+    D3DXASSERT(StartSlot + NumBuffers <= D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+    return FilterRange((void**) pStage->pConstantBuffers, StartSlot, NumBuffers, (void *CONST *) ppBuffers);
+}
+
+BOOL CEffectStateFilter::SetSamplers(CONST SD3DShaderVTable *pVT, UINT StartSlot, UINT NumSamplers, ID3D11SamplerState *CONST *ppSamplers)
+{
+    SStage *pStage = GetStage(pVT);
+
+    D3DXASSERT(StartSlot + NumSamplers <= D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT);
+    return FilterRange((void**) pStage->pSamplers, StartSlot, NumSamplers, (void *CONST *) ppSamplers);
+}
+
+BOOL CEffectStateFilter::SetShaderResources(CONST SD3DShaderVTable *pVT, UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView *CONST *ppViews)
+{
+    SStage *pStage = GetStage(pVT);
+
+    D3DXASSERT(StartSlot + NumViews <= D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT);
+    return FilterRange((void**) pStage->pShaderResources, StartSlot, NumViews, (void *CONST *) ppViews);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// CEffectStateFilterList
+//////////////////////////////////////////////////////////////////////////
+
+CEffectStateFilterList g_EffectStateFilters;
+
+CEffectStateFilterList::CEffectStateFilterList()
+{
+    m_FilterCount = 0;
+    m_Generation = 0;
+    InitializeCriticalSection(&m_Lock);
+}
+
+CEffectStateFilterList::~CEffectStateFilterList()
+{
+    UINT i;
+
+    for (i = 0; i < m_Filters.GetSize(); ++ i)
+    {
+        m_Filters[i]->GetContext()->Release();
+        SAFE_RELEASE(m_Filters[i]);
+    }
+    m_Filters.Clear();
+
+    DeleteCriticalSection(&m_Lock);
+}
+
+HRESULT CEffectStateFilterList::Enable(ID3D11DeviceContext *pContext, BOOL Enable)
+{
+    HRESULT hr = S_OK;
+    CEffectStateFilter *pFilter = NULL;
+    UINT i;
+
+    EnterCriticalSection(&m_Lock);
+
+    for (i = 0; i < m_Filters.GetSize(); ++ i)
+    {
+        if (m_Filters[i]->GetContext() == pContext)
+        {
+            if (!Enable)
+            {
+                pFilter = m_Filters[i];
+                m_Filters.QuickDelete(i);
+                InterlockedDecrement(&m_FilterCount);
+                InterlockedIncrement(&m_Generation);
+
+                // Deleted now, or by the last Apply still using it
+                pContext->Release();
+                SAFE_RELEASE(pFilter);
+            }
+            goto lExit;
+        }
+    }
+
+    if (Enable)
+    {
+        VN( pFilter = NEW CEffectStateFilter(pContext) );
+        VH( m_Filters.Add(pFilter) );
+        pFilter = NULL;
+
+        pContext->AddRef();
+        InterlockedIncrement(&m_FilterCount);
+        InterlockedIncrement(&m_Generation);
+    }
+
+lExit:
+    SAFE_RELEASE(pFilter);
+    LeaveCriticalSection(&m_Lock);
+    return hr;
+}
+
+CEffectStateFilter *CEffectStateFilterList::Find(ID3D11DeviceContext *pContext)
+{
+    CEffectStateFilter *pFilter = NULL;
+    UINT i;
+
+    if (0 == m_FilterCount)
+    {
+        return NULL;
+    }
+
+    EnterCriticalSection(&m_Lock);
+
+    for (i = 0; i < m_Filters.GetSize(); ++ i)
+    {
+        if (m_Filters[i]->GetContext() == pContext)
+        {
+            pFilter = m_Filters[i];
+            pFilter->AddRef();
+            break;
+        }
+    }
+
+    LeaveCriticalSection(&m_Lock);
+    return pFilter;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// CEffectApplyContext
+//////////////////////////////////////////////////////////////////////////
+
+CEffectApplyContext::CEffectApplyContext(ID3D11DeviceContext *pContext)
+{
+    m_RefCount = 1;
+    m_pContext = pContext;
+    m_pContext->AddRef();
+    m_LastEffect = 0;
+
+    // Generation first: a filter enabled in between is found again next Apply
+    m_FilterGeneration = g_EffectStateFilters.GetGeneration();
+    m_pStateFilter = g_EffectStateFilters.Find(pContext);
+}
+
+CEffectApplyContext::~CEffectApplyContext()
+{
+    Reset();
+    SAFE_RELEASE(m_pStateFilter);
+    SAFE_RELEASE(m_pContext);
+}
+
+HRESULT CEffectApplyContext::QueryInterface(REFIID iid, LPVOID *ppv)
+{
+    HRESULT hr = S_OK;
+
+    if(NULL == ppv)
+    {
+        DPF(0, "ID3DX11EffectApplyContext::QueryInterface: NULL parameter");
+        hr = E_INVALIDARG;
+        goto EXIT;
+    }
+
+    *ppv = NULL;
+    if(IsEqualIID(iid, IID_IUnknown))
+    {
+        *ppv = (IUnknown *) this;
+    }
+    else if(IsEqualIID(iid, IID_ID3DX11EffectApplyContext))
+    {
+        *ppv = (ID3DX11EffectApplyContext *) this;
+    }
+    else
+    {
+        return E_NOINTERFACE;
+    }
+
+    AddRef();
+
+EXIT:
+    return hr;
+}
+
+ULONG CEffectApplyContext::AddRef()
+{
+    return InterlockedIncrement(&m_RefCount);
+}
+
+ULONG CEffectApplyContext::Release()
+{
+    LONG RefCount = InterlockedDecrement(&m_RefCount);
+
+    if (RefCount > 0)
+    {
+        return RefCount;
+    }
+    else
+    {
+        delete this;
+    }
+
+    return 0;
+}
+
+HRESULT CEffectApplyContext::GetContext(ID3D11DeviceContext **ppContext)
+{
+    HRESULT hr = S_OK;
+    LPCSTR pFuncName = "ID3DX11EffectApplyContext::GetContext";
+
+    VERIFYPARAMETER(ppContext);
+
+    *ppContext = m_pContext;
+    m_pContext->AddRef();
+
+lExit:
+    return hr;
+}
+
+HRESULT CEffectApplyContext::Apply(ID3DX11EffectPass *pPass, UINT Flags)
+{
+    HRESULT hr = S_OK;
+    LPCSTR pFuncName = "ID3DX11EffectApplyContext::Apply";
+    SPassBlock *pBlock;
+    SEffectCopy *pCopy;
+    SApplyState State;
+    LONG Generation;
+
+    // TODO: Flags are not yet implemented    
+
+    if (NULL == pPass || !pPass->IsValid())
+    {
+        DPF(0, "%s: Invalid pass specified", pFuncName);
+        VH( D3DERR_INVALIDCALL );
+    }
+
+    pBlock = (SPassBlock*)pPass;
+    VH( GetEffectCopy(pBlock->pEffect, &pCopy) );
+
+    Generation = g_EffectStateFilters.GetGeneration();
+    if (Generation != m_FilterGeneration)
+    {
+        SAFE_RELEASE(m_pStateFilter);
+        m_FilterGeneration = Generation;
+        m_pStateFilter = g_EffectStateFilters.Find(m_pContext);
+    }
+
+    State.pContext = m_pContext;
+    State.pStateFilter = m_pStateFilter;
+    State.pPrivateCBs = pCopy->pCBs;
+
+    // Only the evaluation writes to the effect; the rest runs alongside the
+    // other threads' applies
+    EnterCriticalSection(&pBlock->pEffect->m_ApplyLock);
+    pBlock->pEffect->EvaluatePassBlock(pBlock);
+    LeaveCriticalSection(&pBlock->pEffect->m_ApplyLock);
+
+    pBlock->pEffect->ApplyPassBlock(pBlock, &State);
+
+lExit:
+    return hr;
+}
+
+HRESULT CEffectApplyContext::SetRawValue(ID3DX11EffectVariable *pVariable, CONST void *pData, UINT ByteOffset, UINT ByteCount)
+{
+    HRESULT hr = S_OK;
+    LPCSTR pFuncName = "ID3DX11EffectApplyContext::SetRawValue";
+    ID3DX11EffectConstantBuffer *pParent;
+    D3DX11_EFFECT_VARIABLE_DESC VariableDesc;
+    D3DX11_EFFECT_TYPE_DESC TypeDesc;
+    SConstantBuffer *pCB;
+    SEffectCopy *pCopy;
+    SPrivateConstantBuffer *pPrivate;
+    UINT Offset;
+
+    VERIFYPARAMETER(pVariable);
+    VERIFYPARAMETER(pData);
+
+    pParent = pVariable->GetParentConstantBuffer();
+    if (!pParent->IsValid())
+    {
+        DPF(0, "%s: The variable is not in a constant buffer", pFuncName);
+        VH( E_INVALIDARG );
+    }
+
+    VH( pVariable->GetDesc(&VariableDesc) );
+    VH( pVariable->GetType()->GetDesc(&TypeDesc) );
+    if ((ByteOffset + ByteCount < ByteOffset) ||
+        ((ByteOffset + ByteCount) > TypeDesc.UnpackedSize))
+    {
+        // overflow of some kind
+        DPF(0, "%s: Invalid range specified", pFuncName);
+        VH( E_INVALIDARG );
+    }
+
+    pCB = (SConstantBuffer*)pParent;
+    VH( GetEffectCopy(pCB->pEffect, &pCopy) );
+
+    D3DXASSERT(pCB >= pCB->pEffect->m_pCBs && pCB < pCB->pEffect->m_pCBs + pCB->pEffect->m_CBCount);
+    pPrivate = pCopy->pCBs + (pCB - pCB->pEffect->m_pCBs);
+    if (NULL == pPrivate->pBackingStore)
+    {
+        DPF(0, "%s: The variable's buffer is user managed or shared by clones; set the variable on the effect", pFuncName);
+        VH( D3DERR_INVALIDCALL );
+    }
+
+    pPrivate->Refresh(pCB);
+
+    Offset = VariableDesc.BufferOffset + ByteOffset;
+    memcpy(pPrivate->pBackingStore + Offset, pData, ByteCount);
+    pPrivate->MarkDirty(Offset, ByteCount);
+
+lExit:
+    return hr;
+}
+
+HRESULT CEffectApplyContext::Reset()
+{
+    UINT i;
+
+    for (i = 0; i < m_Effects.GetSize(); ++ i)
+    {
+        SAFE_DELETE_ARRAY(m_Effects[i].pCBs);
+        SAFE_RELEASE(m_Effects[i].pEffect);
+    }
+
+    m_Effects.Clear();
+    m_LastEffect = 0;
+    return S_OK;
+}
+
+HRESULT CEffectApplyContext::GetEffectCopy(CEffect *pEffect, SEffectCopy **ppCopy)
+{
+    HRESULT hr = S_OK;
+    SEffectCopy Copy;
+    UINT i;
+
+    // A context mostly applies the passes of one effect in a row
+    if (m_LastEffect < m_Effects.GetSize() && m_Effects[m_LastEffect].pEffect == pEffect)
+    {
+        *ppCopy = &m_Effects[m_LastEffect];
+        return S_OK;
+    }
+
+    for (i = 0; i < m_Effects.GetSize(); ++ i)
+    {
+        if (m_Effects[i].pEffect == pEffect)
+        {
+            m_LastEffect = i;
+            *ppCopy = &m_Effects[i];
+            return S_OK;
+        }
+    }
+
+    Copy.pEffect = pEffect;
+    Copy.pCBs = NULL;
+
+    if (pEffect->m_CBCount > 0)
+    {
+        VN( Copy.pCBs = NEW SPrivateConstantBuffer[pEffect->m_CBCount] );
+
+        for (i = 0; i < pEffect->m_CBCount; ++ i)
+        {
+            VH( CreatePrivateCB(pEffect, pEffect->m_pCBs + i, Copy.pCBs + i) );
+        }
+    }
+
+    VH( m_Effects.Add(Copy) );
+    pEffect->AddRef();
+
+    m_LastEffect = m_Effects.GetSize() - 1;
+    *ppCopy = &m_Effects[m_LastEffect];
+
+lExit:
+    if (FAILED(hr))
+    {
+        SAFE_DELETE_ARRAY(Copy.pCBs);
+    }
+    return hr;
+}
+
+// A buffer like the effect's, with its current values. User managed buffers
+// are bound as they are; so are the single buffers of a clone, which only the
+// effect they came from updates.
+HRESULT CEffectApplyContext::CreatePrivateCB(CEffect *pEffect, SConstantBuffer *pCB, SPrivateConstantBuffer *pPrivate)
+{
+    HRESULT hr = S_OK;
+    D3D11_BUFFER_DESC BufferDesc;
+    D3D11_SUBRESOURCE_DATA InitData;
+
+    if (NULL == pCB->pD3DObject || 0 == pCB->Size || pCB->IsUserManaged || pCB->IsNonUpdatable)
+    {
+        return S_OK;
+    }
+
+    VN( pPrivate->pBackingStore = NEW BYTE[pCB->Size] );
+    memcpy(pPrivate->pBackingStore, pCB->pBackingStore, pCB->Size);
+    pPrivate->Version = pCB->GetVersion();
+
+    pCB->pD3DObject->GetDesc(&BufferDesc);
+    InitData.pSysMem = pPrivate->pBackingStore;
+    InitData.SysMemPitch = 0;
+    InitData.SysMemSlicePitch = 0;
+    VH( pEffect->m_pDevice->CreateBuffer(&BufferDesc, &InitData, &pPrivate->pD3DObject) );
+
+    if (pCB->IsTBuffer)
+    {
+        D3D11_SHADER_RESOURCE_VIEW_DESC ViewDesc;
+
+        D3DXASSERT(NULL != pCB->TBuffer.pShaderResource);
+        pCB->TBuffer.pShaderResource->GetDesc(&ViewDesc);
+        VH( pEffect->m_pDevice->CreateShaderResourceView(pPrivate->pD3DObject, &ViewDesc, &pPrivate->pShaderResource) );
+    }
+
+lExit:
+    return hr;
+}
+
 }
@@ -1119,7 +1119,7 @@ struct TMember : public SVariable, public IBaseInterface
             if (!pTopLevelEntity->pType->IsObjectType(EOT_String))
             {
                 // strings are funny; their data is reflection data, so ignore those
-                D3DXASSERT(pTopLevelEntity->pEffect->IsRuntimeData(Data.pGeneric));
+                D3DXASSERT(pTopLevelEntity->pEffect->IsRuntimeData(Data.pGeneric) || pTopLevelEntity->pEffect->IsSharedData(Data.pGeneric));
             }
             
             pDesc->Annotations = ((TGlobalVariable<ID3DX11Effect>*)pTopLevelEntity)->AnnotationCount;
@@ -1311,7 +1311,7 @@ lExit:
     D3DX11INLINE void DirtyVariable()
     {
         D3DXASSERT(NULL != pCB);
-        pCB->IsDirty = TRUE;
+        pCB->MarkDirty((UINT)(Data.pNumeric - pCB->pBackingStore), pType->TotalSize);
         LastModifiedTime = pEffect->GetCurrentTime();
     }
 
@@ -89,7 +89,23 @@ typedef struct _D3DX11_STATE_BLOCK_MASK
 // These flags are passed in when creating an effect, and affect
 // the runtime effect behavior:
 //
-// (Currently none)
+// D3DX11_EFFECT_DYNAMIC_CONSTANT_BUFFERS
+//   Create the constant buffers with D3D11_USAGE_DYNAMIC and update them
+//   with D3D11_MAP_WRITE_DISCARD instead of UpdateSubresource. Meant for
+//   effects whose constants are rewritten every frame. Clones inherit it.
+//
+// D3DX11_EFFECT_SHARED_CONSTANT_BUFFERS
+//   Share the constant buffers with the other effects created with this
+//   flag on the same device: cbuffers with the same name, size and
+//   variables (same names, types and offsets) use one buffer and one
+//   backing store. A value set through one effect is seen by all of them
+//   and uploaded once, so a per-frame cbuffer included by every effect is
+//   only set once. An effect takes the current values of the cbuffers that
+//   are already shared, not the initial values of its file. Tbuffers are
+//   not shared. State blocks whose values come from a shared variable see
+//   the changes made through their own effect only. The effects sharing a
+//   cbuffer must be updated and applied from one thread at a time. Clones
+//   inherit it.
 //
 //
 // These flags are set by the effect runtime:
@@ -110,8 +126,11 @@ typedef struct _D3DX11_STATE_BLOCK_MASK
 #define D3DX11_EFFECT_OPTIMIZED                         (1 << 21)
 #define D3DX11_EFFECT_CLONE                             (1 << 22)
 
+#define D3DX11_EFFECT_DYNAMIC_CONSTANT_BUFFERS          (1 << 0)
+#define D3DX11_EFFECT_SHARED_CONSTANT_BUFFERS           (1 << 1)
+
 // These are the only valid parameter flags to D3DX11CreateEffect*
-#define D3DX11_EFFECT_RUNTIME_VALID_FLAGS (0)
+#define D3DX11_EFFECT_RUNTIME_VALID_FLAGS (D3DX11_EFFECT_DYNAMIC_CONSTANT_BUFFERS | D3DX11_EFFECT_SHARED_CONSTANT_BUFFERS)
 
 //----------------------------------------------------------------------------
 // D3DX11_EFFECT_VARIABLE flags:
@@ -142,6 +161,9 @@ typedef struct _D3DX11_STATE_BLOCK_MASK
 // D3DX11_EFFECT_CLONE_FORCE_NONSINGLE
 //   Ignore all "single" qualifiers on cbuffers.  All cbuffers will have their
 //   own ID3D11Buffer's created in the cloned effect.
+//
+// To record the passes of one effect on several deferred contexts at once,
+// there is no need to clone it: see ID3DX11EffectApplyContext.
 //----------------------------------------------------------------------------
 
 #define D3DX11_EFFECT_CLONE_FORCE_NONSINGLE        	    (1 << 0)
@@ -1521,6 +1543,69 @@ DECLARE_INTERFACE_(ID3DX11Effect, IUnknown)
     STDMETHOD_(BOOL, IsOptimized)(THIS) PURE;
 };
 
+//////////////////////////////////////////////////////////////////////////////
+// ID3DX11EffectApplyContext /////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+//----------------------------------------------------------------------------
+// ID3DX11EffectApplyContext:
+// --------------------------
+// Applies the passes of any effect on one context, usually a deferred
+// context owned by a recording thread, without writing the effect. Several
+// apply contexts can apply the passes of the same effect at once, from
+// different threads.
+//
+// For each effect it applies, the apply context keeps a copy of the
+// constant and texture buffers: its own buffers and values. SetRawValue
+// writes a variable in this copy; the variables of the effect itself hold
+// the values every copy starts from. When a cbuffer of the effect is
+// written, the copies of that cbuffer are taken again at their next Apply,
+// dropping what was written into them. User managed cbuffers (see
+// ID3DX11EffectConstantBuffer::SetConstantBuffer), and the single cbuffers
+// of a clone, are bound as they are and cannot be set through SetRawValue.
+//
+// The effect is shared read only: do not write its variables, nor apply
+// it with ID3DX11EffectPass::Apply, while the apply contexts record. The
+// state assignments of the passes, and the state objects they pick, are
+// evaluated from the effect's values.
+//
+// An apply context is used by one thread at a time. It holds a reference
+// on its context and on the effects it applied until Reset. Apply uses the
+// state filter enabled on the context, if any (see
+// D3DX11EnableEffectStateFilter).
+//----------------------------------------------------------------------------
+
+typedef interface ID3DX11EffectApplyContext ID3DX11EffectApplyContext;
+typedef interface ID3DX11EffectApplyContext *LPD3DX11EFFECTAPPLYCONTEXT;
+
+// {3CCD9163-278E-4809-87D7-F47D9E6263EE}
+DEFINE_GUID(IID_ID3DX11EffectApplyContext, 
+            0x3ccd9163, 0x278e, 0x4809, 0x87, 0xd7, 0xf4, 0x7d, 0x9e, 0x62, 0x63, 0xee);
+
+#undef INTERFACE
+#define INTERFACE ID3DX11EffectApplyContext
+
+DECLARE_INTERFACE_(ID3DX11EffectApplyContext, IUnknown)
+{
+    // IUnknown
+    STDMETHOD(QueryInterface)(THIS_ REFIID iid, LPVOID *ppv) PURE;
+    STDMETHOD_(ULONG, AddRef)(THIS) PURE;
+    STDMETHOD_(ULONG, Release)(THIS) PURE;
+
+    STDMETHOD(GetContext)(THIS_ ID3D11DeviceContext** ppContext) PURE;
+
+    // Sets the state of the pass on the context, with this apply context's
+    // copy of the buffers of the pass's effect
+    STDMETHOD(Apply)(THIS_ ID3DX11EffectPass *pPass, UINT Flags) PURE;
+
+    // Writes a numeric variable (or a member or element of one) in this
+    // apply context's copy of its cbuffer, as ID3DX11EffectVariable::SetRawValue
+    STDMETHOD(SetRawValue)(THIS_ ID3DX11EffectVariable *pVariable, CONST void *pData, UINT ByteOffset, UINT ByteCount) PURE;
+
+    // Releases the copies, and the effects they were made of
+    STDMETHOD(Reset)(THIS) PURE;
+};
+
 //////////////////////////////////////////////////////////////////////////////
 // APIs //////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
@@ -1558,6 +1643,115 @@ extern "C" {
 
 HRESULT WINAPI D3DX11CreateEffectFromMemory(CONST void *pData, SIZE_T DataLength, UINT FXFlags, ID3D11Device *pDevice, ID3DX11Effect **ppEffect);
 
+//----------------------------------------------------------------------------
+// D3DX11CreateEffectApplyContext:
+// -------------------------------
+// Creates an apply context for the passes applied on pContext (see
+// ID3DX11EffectApplyContext).
+//
+// Parameters:
+//
+// [in]
+//
+//  pContext
+//      Context the passes are applied on, usually a deferred context
+//
+// [out]
+//
+//  ppApplyContext
+//      Address of the new apply context
+//
+//----------------------------------------------------------------------------
+
+HRESULT WINAPI D3DX11CreateEffectApplyContext(ID3D11DeviceContext *pContext, ID3DX11EffectApplyContext **ppApplyContext);
+
+//----------------------------------------------------------------------------
+// D3DX11_EFFECT_STATE_FILTER_STATS:
+// ---------------------------------
+// State setting calls of the passes applied on a context with state
+// filtering enabled. Only the calls the filter can drop are counted:
+// OMSetBlendState, OMSetDepthStencilState, RSSetState and the per stage
+// Set*Shader, Set*ConstantBuffers, Set*Samplers and Set*ShaderResources.
+//----------------------------------------------------------------------------
+
+typedef struct _D3DX11_EFFECT_STATE_FILTER_STATS
+{
+    UINT64  CallsIssued;                // Calls made on the context
+    UINT64  CallsSkipped;               // Calls dropped, their state was already bound
+} D3DX11_EFFECT_STATE_FILTER_STATS;
+
+//----------------------------------------------------------------------------
+// D3DX11EnableEffectStateFilter:
+// ------------------------------
+// Enables or disables redundant state filtering for the passes applied on
+// a context. While enabled, Apply skips the state setting calls whose
+// arguments match what the passes bound last on the context, whichever
+// effect they belong to. Enabling keeps a reference on the context until
+// filtering is disabled again. Disabling it while another thread applies a
+// pass on the context is safe: that Apply finishes with the former filter.
+//
+// The filter only sees what the passes bind: after binding state directly
+// on the context (including ClearState and binding render targets), call
+// D3DX11InvalidateEffectStateFilter before the next Apply. The same goes
+// after FinishCommandList and ExecuteCommandList, which clear the state of
+// the context unless asked to restore it. Each context has its own filter,
+// the threads recording deferred contexts do not share any.
+//
+// Parameters:
+//
+// [in]
+//
+//  pContext
+//      Context the passes are applied on
+//  Enable
+//      TRUE to start filtering, FALSE to stop
+//
+//----------------------------------------------------------------------------
+
+HRESULT WINAPI D3DX11EnableEffectStateFilter(ID3D11DeviceContext *pContext, BOOL Enable);
+
+//----------------------------------------------------------------------------
+// D3DX11InvalidateEffectStateFilter:
+// ----------------------------------
+// Forgets the state recorded for a context, the next Apply makes all its
+// calls. Fails if filtering is not enabled on pContext.
+//----------------------------------------------------------------------------
+
+HRESULT WINAPI D3DX11InvalidateEffectStateFilter(ID3D11DeviceContext *pContext);
+
+//----------------------------------------------------------------------------
+// D3DX11GetEffectStateFilterStats:
+// --------------------------------
+// Calls issued and skipped on a context since filtering was enabled on it.
+// Fails if filtering is not enabled on pContext.
+//----------------------------------------------------------------------------
+
+HRESULT WINAPI D3DX11GetEffectStateFilterStats(ID3D11DeviceContext *pContext, D3DX11_EFFECT_STATE_FILTER_STATS *pStats);
+
+//----------------------------------------------------------------------------
+// D3DX11_EFFECT_UPLOAD_STATS:
+// ---------------------------
+// Constant and texture buffer updates made by Apply, all effects and
+// contexts together, since the process started. Sample it every frame
+// and subtract to get per frame figures.
+//
+// Texture buffers only send the registers written since their last update
+// (on immediate contexts). Constant buffers are sent in part too, with
+// UpdateSubresource1, on Direct3D 11.1 runtimes whose device reports
+// ConstantBufferPartialUpdate; on Direct3D 11.0 they are updated whole.
+// Dynamic constant buffers are always mapped and written whole.
+//----------------------------------------------------------------------------
+
+typedef struct _D3DX11_EFFECT_UPLOAD_STATS
+{
+    UINT64  Updates;                    // Buffers updated
+    UINT64  DiscardMaps;                // Updates made with D3D11_MAP_WRITE_DISCARD
+    UINT64  BytesUploaded;              // Bytes sent
+    UINT64  BytesSkipped;               // Bytes whole buffer updates would have sent on top
+} D3DX11_EFFECT_UPLOAD_STATS;
+
+HRESULT WINAPI D3DX11GetEffectUploadStats(D3DX11_EFFECT_UPLOAD_STATS *pStats);
+
 #ifdef __cplusplus
 }
 #endif //__cplusplus
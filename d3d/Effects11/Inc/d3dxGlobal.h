@@ -1335,3 +1335,204 @@ lExit:
         return hr;
     }
 };
+
+// Maps names to indices into an array owned by the caller (variables,
+// constant buffers, techniques...). The table only holds the hashes: the
+// caller enumerates the candidates of a hash and compares the names itself,
+// so the entries stay valid when the named objects or their strings are
+// moved. Names are looked up within a scope (the group of a technique, the
+// technique of a pass), 0 when there is only one.
+//
+// Open addressing with linear probing, at most half full. Entries of equal
+// hash and scope are enumerated in the order they were added, so the first
+// match is the one a linear search would have found.
+
+class CEffectNameTable
+{
+protected:
+
+    struct SNameEntry
+    {
+        UINT        Hash;
+        UINT        Scope;
+        UINT        Index;      // c_FreeSlot if the slot is free
+    };
+
+    static const UINT c_FreeSlot = (UINT) -1;
+
+    SNameEntry  *m_pEntries;
+    UINT        m_NumSlots;
+    UINT        m_NumEntries;
+
+    UINT GetFirstSlot(UINT Hash, UINT Scope) const
+    {
+        return (Hash ^ (Scope * 0x9e3779b9)) % m_NumSlots;
+    }
+
+    // Rehash into NumSlots slots
+    HRESULT Resize(UINT NumSlots)
+    {
+        HRESULT hr = S_OK;
+        SNameEntry *pNewEntries = NULL;
+        UINT i, start;
+
+        VN( pNewEntries = NEW SNameEntry[NumSlots] );
+        for (i = 0; i < NumSlots; ++ i)
+        {
+            pNewEntries[i].Index = c_FreeSlot;
+        }
+
+        // Walk the old slots from a free one: each run of entries is then
+        // visited from its beginning, which keeps equal entries in order
+        for (start = 0; start < m_NumSlots && m_pEntries[start].Index != c_FreeSlot; ++ start);
+
+        for (i = 0; i < m_NumSlots; ++ i)
+        {
+            SNameEntry *pEntry = &m_pEntries[(start + i) % m_NumSlots];
+            if (pEntry->Index != c_FreeSlot)
+            {
+                UINT slot = (pEntry->Hash ^ (pEntry->Scope * 0x9e3779b9)) % NumSlots;
+                while (pNewEntries[slot].Index != c_FreeSlot)
+                {
+                    slot = (slot + 1) % NumSlots;
+                }
+                pNewEntries[slot] = *pEntry;
+            }
+        }
+
+        SAFE_DELETE_ARRAY(m_pEntries);
+        m_pEntries = pNewEntries;
+        m_NumSlots = NumSlots;
+        pNewEntries = NULL;
+
+lExit:
+        SAFE_DELETE_ARRAY(pNewEntries);
+        return hr;
+    }
+
+public:
+    CEffectNameTable()
+    {
+        m_pEntries = NULL;
+        m_NumSlots = 0;
+        m_NumEntries = 0;
+    }
+
+    ~CEffectNameTable()
+    {
+        Cleanup();
+    }
+
+    void Cleanup()
+    {
+        SAFE_DELETE_ARRAY(m_pEntries);
+        m_NumSlots = 0;
+        m_NumEntries = 0;
+    }
+
+    UINT GetNumEntries() const
+    {
+        return m_NumEntries;
+    }
+
+    // Copy of another table
+    HRESULT Initialize(const CEffectNameTable *pOther)
+    {
+        HRESULT hr = S_OK;
+
+        Cleanup();
+
+        if (pOther->m_NumSlots > 0)
+        {
+            VN( m_pEntries = NEW SNameEntry[pOther->m_NumSlots] );
+            memcpy(m_pEntries, pOther->m_pEntries, sizeof(SNameEntry) * pOther->m_NumSlots);
+            m_NumSlots = pOther->m_NumSlots;
+            m_NumEntries = pOther->m_NumEntries;
+        }
+
+lExit:
+        return hr;
+    }
+
+    // Makes room for NumEntries entries without rehashing
+    HRESULT Reserve(UINT NumEntries)
+    {
+        if (2 * NumEntries < m_NumSlots)
+        {
+            return S_OK;
+        }
+
+        UINT size = 2 * NumEntries + 1;
+        for (UINT i = 0; i < c_NumPrimes; ++ i)
+        {
+            if (c_PrimeSizes[i] > 2 * NumEntries)
+            {
+                size = c_PrimeSizes[i];
+                break;
+            }
+        }
+
+        return Resize(size);
+    }
+
+    // Adds Index without checking for an existing name
+    HRESULT Add(UINT Hash, UINT Scope, UINT Index)
+    {
+        HRESULT hr = S_OK;
+        UINT slot;
+
+        D3DXASSERT(Index != c_FreeSlot);
+
+        VH( Reserve(m_NumEntries + 1) );
+
+        slot = GetFirstSlot(Hash, Scope);
+        while (m_pEntries[slot].Index != c_FreeSlot)
+        {
+            slot = (slot + 1) % m_NumSlots;
+        }
+
+        m_pEntries[slot].Hash = Hash;
+        m_pEntries[slot].Scope = Scope;
+        m_pEntries[slot].Index = Index;
+        ++ m_NumEntries;
+
+lExit:
+        return hr;
+    }
+
+    // Enumerates the indices added with this hash and scope; *pSlot is the
+    // position of the enumeration. Returns FALSE past the last one.
+    BOOL FindFirst(UINT Hash, UINT Scope, UINT *pSlot, UINT *pIndex) const
+    {
+        if (0 == m_NumSlots)
+        {
+            return FALSE;
+        }
+
+        *pSlot = GetFirstSlot(Hash, Scope);
+        return FindNext(Hash, Scope, pSlot, pIndex);
+    }
+
+    BOOL FindNext(UINT Hash, UINT Scope, UINT *pSlot, UINT *pIndex) const
+    {
+        UINT slot = *pSlot;
+        while (m_pEntries[slot].Index != c_FreeSlot)
+        {
+            const SNameEntry &entry = m_pEntries[slot];
+            slot = (slot + 1) % m_NumSlots;
+            if (entry.Hash == Hash && entry.Scope == Scope)
+            {
+                *pSlot = slot;
+                *pIndex = entry.Index;
+                return TRUE;
+            }
+        }
+
+        *pSlot = slot;
+        return FALSE;
+    }
+
+private:
+    CEffectNameTable(const CEffectNameTable&);
+    CEffectNameTable& operator=(const CEffectNameTable&);
+};
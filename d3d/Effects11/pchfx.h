@@ -37,6 +37,48 @@
 
 namespace D3DX11Effects
 {
+
+//////////////////////////////////////////////////////////////////////////
+// Direct3D 11.1 partial constant buffer updates
+//
+// The library builds against the DirectX SDK headers, which predate
+// d3d11_1.h. The parts it uses are declared here under their own names, so
+// they do not clash with the Windows 8 SDK headers; whether the runtime and
+// driver take them is checked at BindToDevice.
+//////////////////////////////////////////////////////////////////////////
+
+// D3D11_FEATURE_D3D11_OPTIONS and D3D11_FEATURE_DATA_D3D11_OPTIONS
+static const D3D11_FEATURE c_FeatureD3D11Options = (D3D11_FEATURE) 5;
+
+struct SD3D11Options
+{
+    BOOL OutputMergerLogicOp;
+    BOOL UAVOnlyRenderingForcedSampleCount;
+    BOOL DiscardAPIsSeenByDriver;
+    BOOL FlagsForUpdateAndCopySeenByDriver;
+    BOOL ClearView;
+    BOOL CopyWithOverlap;
+    BOOL ConstantBufferPartialUpdate;
+    BOOL ConstantBufferOffsetting;
+    BOOL MapNoOverwriteOnDynamicConstantBuffer;
+    BOOL MapNoOverwriteOnDynamicBufferSRV;
+    BOOL MultisampleRTVWithForcedSampleCountOne;
+    BOOL SAD4ShaderInstructions;
+    BOOL ExtendedDoublesShaderInstructions;
+    BOOL ExtendedResourceSharing;
+};
+
+// The first methods of ID3D11DeviceContext1, in its vtable order
+static const IID c_IID_ID3D11DeviceContext1 = { 0xbb2c6faa, 0xb5fb, 0x4082, { 0x8e, 0x6b, 0x38, 0x8b, 0x8c, 0xfa, 0x90, 0xe1 } };
+
+struct ID3D11DeviceContext1_FX : public ID3D11DeviceContext
+{
+    STDMETHOD_(void, CopySubresourceRegion1)(ID3D11Resource *pDstResource, UINT DstSubresource, UINT DstX, UINT DstY, UINT DstZ,
+        ID3D11Resource *pSrcResource, UINT SrcSubresource, const D3D11_BOX *pSrcBox, UINT CopyFlags) PURE;
+    STDMETHOD_(void, UpdateSubresource1)(ID3D11Resource *pDstResource, UINT DstSubresource, const D3D11_BOX *pDstBox,
+        const void *pSrcData, UINT SrcRowPitch, UINT SrcDepthPitch, UINT CopyFlags) PURE;
+};
+
 } // end namespace D3DX11Effects
 
 #endif // __D3DX11_PCHFX_H__
@@ -1,6 +1,7 @@
 
 #include "effects.h"
 #include "config.h"
+#include "threadPool.h"
 #include <vector>
 #include <fstream>
 
@@ -117,9 +118,15 @@ std::unique_ptr<TessellationEffect> Effects::TessellationFX = nullptr;
 
 void Effects::InitAll(ID3D11Device* device)
 {
-    BasicFX.reset(new BasicEffect(device, "FX/Basic.fxo"));
-    BlurFX.reset(new BlurEffect(device, "FX/Blur.fxo"));
-    TessellationFX.reset(new TessellationEffect(device, "FX/Tessellation.fxo"));
+    // The effects are independent and the device is free threaded, read and
+    // create them concurrently.
+    ThreadPool::Task tasks[3] =
+    {
+        [device]() { BasicFX.reset(new BasicEffect(device, "FX/Basic.fxo")); },
+        [device]() { BlurFX.reset(new BlurEffect(device, "FX/Blur.fxo")); },
+        [device]() { TessellationFX.reset(new TessellationEffect(device, "FX/Tessellation.fxo")); },
+    };
+    ThreadPool::Shared().RunAll(tasks, 3);
 }
 
 void Effects::DestroyAll()
@@ -1,6 +1,7 @@
 
 #include "effects.h"
 #include "config.h"
+#include "threadPool.h"
 #include <vector>
 #include <fstream>
 
@@ -94,8 +95,14 @@ std::unique_ptr<BlurEffect> Effects::BlurFX = nullptr;
 
 void Effects::InitAll(ID3D11Device* device)
 {
-    BasicFX.reset(new BasicEffect(device, "FX/Basic.fxo"));
-    BlurFX.reset(new BlurEffect(device, "FX/Blur.fxo"));
+    // The effects are independent and the device is free threaded, read and
+    // create them concurrently.
+    ThreadPool::Task tasks[2] =
+    {
+        [device]() { BasicFX.reset(new BasicEffect(device, "FX/Basic.fxo")); },
+        [device]() { BlurFX.reset(new BlurEffect(device, "FX/Blur.fxo")); },
+    };
+    ThreadPool::Shared().RunAll(tasks, 2);
 }
 
 void Effects::DestroyAll()
@@ -1,6 +1,7 @@
 
 #include "effects.h"
 #include "config.h"
+#include "threadPool.h"
 #include <vector>
 #include <fstream>
 
@@ -93,8 +94,14 @@ std::unique_ptr<VecAddEffect> Effects::VecAddFX = nullptr;
 
 void Effects::InitAll(ID3D11Device* device)
 {
-    BasicFX.reset(new BasicEffect(device, "FX/Basic.fxo"));
-    VecAddFX.reset(new VecAddEffect(device, "FX/VecAdd.fxo"));
+    // The effects are independent and the device is free threaded, read and
+    // create them concurrently.
+    ThreadPool::Task tasks[2] =
+    {
+        [device]() { BasicFX.reset(new BasicEffect(device, "FX/Basic.fxo")); },
+        [device]() { VecAddFX.reset(new VecAddEffect(device, "FX/VecAdd.fxo")); },
+    };
+    ThreadPool::Shared().RunAll(tasks, 2);
 }
 
 void Effects::DestroyAll()
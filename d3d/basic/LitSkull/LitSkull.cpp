@@ -12,10 +12,10 @@
 #include "lightHelper.h"
 #include "effects.h"
 #include "vertex.h"
+#include "meshRegistry.h"
 #include <d3dcompiler.h>
 #include <iostream>
 #include <sstream>
-#include <fstream>
 #include <vector>
 
 class LitSkullDemo : public DemoApp
@@ -41,6 +41,7 @@ private:
 
     ComPtr<ID3D11Buffer>           m_skullVB;
     ComPtr<ID3D11Buffer>           m_skullIB;
+    MeshAssetPtr                   m_skull;
 
     DirectionalLight m_dirLights[3];
 	Material m_gridMat;
@@ -287,36 +288,16 @@ void LitSkullDemo::BuildShapeGeometryBuffers()
 
 void LitSkullDemo::BuildSkullGeometryBuffers()
 {
-    std::ifstream fin("Models/skull.txt");
-    OC_ASSERT(fin.good());
-	
-	uint32 vcount = 0;
-	uint32 tcount = 0;
-	std::string ignore;
+    // Shared with the other scenes of the process that use the same model.
+    m_skull = MeshRegistry::Shared().Acquire("Models/skull.txt");
+    OC_ASSERT(m_skull);
 
-	fin >> ignore >> vcount; //vertex
-	fin >> ignore >> tcount; //triangle
-	fin >> ignore >> ignore >> ignore >> ignore;
+	uint32 vcount = m_skull->VertexCount();
 	
-	std::vector<Vertex::PosNormal> vertices(vcount);
-	for(uint32 i = 0; i < vcount; ++i)
-	{
-		fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-		fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
-	}
-
-	fin >> ignore;
-	fin >> ignore;
-	fin >> ignore;
-
-	m_skullIndexCount = 3*tcount;
-    std::vector<uint32> indices(m_skullIndexCount);
-	for(uint32 i = 0; i < tcount; ++i)
-	{
-		fin >> indices[i*3+0] >> indices[i*3+1] >> indices[i*3+2];
-	}
+	std::vector<Vertex::PosNormal> vertices;
+    CopyMeshVertices(*m_skull, &vertices);
 
-	fin.close();
+	m_skullIndexCount = m_skull->IndexCount();
 
     D3D11_BUFFER_DESC vbd;
     vbd.Usage = D3D11_USAGE_IMMUTABLE;
@@ -339,7 +320,7 @@ void LitSkullDemo::BuildSkullGeometryBuffers()
     ibd.CPUAccessFlags = 0;
     ibd.MiscFlags = 0;
     D3D11_SUBRESOURCE_DATA iinitData;
-	iinitData.pSysMem = &indices[0];
+	iinitData.pSysMem = &m_skull->Indices[0];
     HR(m_dxDevice->CreateBuffer(&ibd, &iinitData, m_skullIB.GetAddressOf()));
 }
 
@@ -29,10 +29,10 @@
 #include "effects.h"
 #include "renderStates.h"
 #include "vertex.h"
+#include "meshRegistry.h"
 #include <d3dcompiler.h>
 #include <iostream>
 #include <sstream>
-#include <fstream>
 #include <vector>
 
 enum RenderOptions
@@ -64,6 +64,7 @@ private:
     ComPtr<ID3D11Buffer>           m_roomVB;
     ComPtr<ID3D11Buffer>           m_skullVB;
     ComPtr<ID3D11Buffer>           m_skullIB;
+    MeshAssetPtr                   m_skull;
 
 	ComPtr<ID3D11ShaderResourceView> m_floorDiffuseMapSRV;
 	ComPtr<ID3D11ShaderResourceView> m_wallDiffuseMapSRV;
@@ -181,36 +182,16 @@ void MirrorApp::InitGeometryBuffers()
 
 void MirrorApp::BuildSkullBuffers()
 {
-    std::ifstream fin("Models/skull.txt");
-    OC_ASSERT(fin.good());
+    // Shared with the other scenes of the process that use the same model.
+    m_skull = MeshRegistry::Shared().Acquire("Models/skull.txt");
+    OC_ASSERT(m_skull);
 
-	UINT vcount = 0;
-	UINT tcount = 0;
-	std::string ignore;
-
-	fin >> ignore >> vcount;
-	fin >> ignore >> tcount;
-	fin >> ignore >> ignore >> ignore >> ignore;
+	UINT vcount = m_skull->VertexCount();
 	
-	std::vector<Vertex::Basic32> vertices(vcount);
-	for(UINT i = 0; i < vcount; ++i)
-	{
-		fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-		fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
-	}
-
-	fin >> ignore;
-	fin >> ignore;
-	fin >> ignore;
-
-    m_skullIndexCount = 3*tcount;
-	std::vector<UINT> indices(m_skullIndexCount);
-	for(UINT i = 0; i < tcount; ++i)
-	{
-		fin >> indices[i*3+0] >> indices[i*3+1] >> indices[i*3+2];
-	}
+	std::vector<Vertex::Basic32> vertices;
+    CopyMeshVertices(*m_skull, &vertices);
 
-	fin.close();
+	m_skullIndexCount = m_skull->IndexCount();
 
     D3D11_BUFFER_DESC vbd;
     vbd.Usage = D3D11_USAGE_IMMUTABLE;
@@ -230,7 +211,7 @@ void MirrorApp::BuildSkullBuffers()
     ibd.CPUAccessFlags = 0;
     ibd.MiscFlags = 0;
     D3D11_SUBRESOURCE_DATA iinitData;
-	iinitData.pSysMem = &indices[0];
+	iinitData.pSysMem = &m_skull->Indices[0];
     HR(m_dxDevice->CreateBuffer(&ibd, &iinitData, m_skullIB.GetAddressOf()));
 }
 
@@ -1,6 +1,7 @@
 
 #include "effects.h"
 #include "config.h"
+#include "threadPool.h"
 #include <vector>
 #include <fstream>
 
@@ -103,8 +104,14 @@ std::unique_ptr<TreeSpriteEffect> Effects::TreeSpriteFX = nullptr;
 
 void Effects::InitAll(ID3D11Device* device)
 {
-    BasicFX.reset(new BasicEffect(device, "FX/Basic.fxo"));
-    TreeSpriteFX.reset(new TreeSpriteEffect(device, "FX/TreeSprite.fxo"));
+    // The effects are independent and the device is free threaded, read and
+    // create them concurrently.
+    ThreadPool::Task tasks[2] =
+    {
+        [device]() { BasicFX.reset(new BasicEffect(device, "FX/Basic.fxo")); },
+        [device]() { TreeSpriteFX.reset(new TreeSpriteEffect(device, "FX/TreeSprite.fxo")); },
+    };
+    ThreadPool::Shared().RunAll(tasks, 2);
 }
 
 void Effects::DestroyAll()
@@ -0,0 +1,159 @@
+#include "assetLoader.h"
+#include "threadPool.h"
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    AssetLoader::FileDataPtr ReadFile(const std::string& fileName)
+    {
+        std::ifstream fin(fileName, std::ios::binary);
+        if(!fin.good())
+            return nullptr;
+
+        fin.seekg(0, std::ios_base::end);
+        std::streamoff size = fin.tellg();
+        fin.seekg(0, std::ios_base::beg);
+        if(size <= 0)
+            return nullptr;
+
+        std::shared_ptr<std::vector<uint8>> data = std::make_shared<std::vector<uint8>>((size_t)size);
+        fin.read(reinterpret_cast<char*>(&(*data)[0]), size);
+        if(fin.fail())
+            return nullptr;
+
+        return data;
+    }
+}
+
+AssetLoader::AssetLoader(ThreadPool* pPool)
+: m_pool(pPool ? *pPool : ThreadPool::Shared())
+, m_inFlight(0)
+{
+}
+
+AssetLoader::~AssetLoader()
+{
+    // The workers reference the loader until their load is done.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(m_inFlight > 0)
+        m_loaded.wait(lock);
+}
+
+template<typename T>
+std::shared_future<T> AssetLoader::Request(std::unordered_map<std::string, std::shared_ptr<Load<T>>>& loads,
+    const std::string& fileName, const std::function<void(const T&)>& onLoaded, const std::function<T()>& work)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = loads.find(fileName);
+    if(it != loads.end())
+    {
+        Load<T>& load = *it->second;
+        if(onLoaded)
+        {
+            if(load.Done)
+            {
+                std::shared_future<T> result = load.Result;
+                m_ready.push_back([onLoaded, result]() { onLoaded(result.get()); });
+            }
+            else
+                load.Callbacks.push_back(onLoaded);
+        }
+        return load.Result;
+    }
+
+    std::shared_ptr<Load<T>> load = std::make_shared<Load<T>>();
+    std::shared_ptr<std::promise<T>> promise = std::make_shared<std::promise<T>>();
+    load->Result = promise->get_future().share();
+    load->Done = false;
+    if(onLoaded)
+        load->Callbacks.push_back(onLoaded);
+
+    loads[fileName] = load;
+    ++m_inFlight;
+
+    m_pool.Submit([this, load, promise, work]()
+    {
+        T result = work();
+        promise->set_value(result);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(size_t i = 0; i < load->Callbacks.size(); ++i)
+        {
+            std::function<void(const T&)> callback = load->Callbacks[i];
+            m_ready.push_back([callback, result]() { callback(result); });
+        }
+        load->Callbacks.clear();
+        load->Done = true;
+
+        --m_inFlight;
+        m_loaded.notify_all();
+    });
+
+    return load->Result;
+}
+
+std::shared_future<AssetLoader::FileDataPtr> AssetLoader::LoadFile(const std::string& fileName,
+    const FileCallback& onLoaded)
+{
+    return Request<FileDataPtr>(m_files, fileName, onLoaded, [fileName]() { return ReadFile(fileName); });
+}
+
+std::shared_future<MeshAssetPtr> AssetLoader::LoadMesh(const std::string& fileName, const MeshCallback& onLoaded,
+    const WeldTolerance* pWeld)
+{
+    ThreadPool* pPool = &m_pool;
+    if(!pWeld)
+    {
+        return Request<MeshAssetPtr>(m_meshes, fileName, onLoaded, [fileName, pPool]()
+        {
+            return MeshRegistry::Shared().Acquire(fileName.c_str(), pPool);
+        });
+    }
+
+    std::ostringstream key;
+    key << fileName << "|weld " << pWeld->Position << " " << pWeld->Normal;
+
+    WeldTolerance tolerance = *pWeld;
+    return Request<MeshAssetPtr>(m_meshes, key.str(), onLoaded, [fileName, pPool, tolerance]()
+    {
+        return MeshRegistry::Shared().Acquire(fileName.c_str(), pPool, &tolerance);
+    });
+}
+
+uint32 AssetLoader::Update()
+{
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ready.swap(m_ready);
+    }
+
+    for(size_t i = 0; i < ready.size(); ++i)
+        ready[i]();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_inFlight;
+}
+
+void AssetLoader::Finish()
+{
+    for(;;)
+    {
+        std::vector<std::function<void()>> ready;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(m_ready.empty() && m_inFlight > 0)
+                m_loaded.wait(lock);
+
+            if(m_ready.empty())
+                return;
+
+            ready.swap(m_ready);
+        }
+
+        for(size_t i = 0; i < ready.size(); ++i)
+            ready[i]();
+    }
+}
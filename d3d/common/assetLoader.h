@@ -0,0 +1,91 @@
+//---------------------------------------------------------------------------------------
+//
+// Background loading of the files an app needs at startup.
+//
+// The loads run on the thread pool: LoadFile reads a whole file (compiled effects,
+// textures), LoadMesh parses a text model through the MeshRegistry (bounds included).
+// Each load returns a future and can take a completion callback. The callbacks are
+// not called by the workers: Update and Finish run them on the calling thread, the
+// main one, so they can create the device objects. Requesting all the files first
+// and creating the objects as they arrive bounds the startup by the slowest file
+// instead of the sum of all of them.
+//
+// A file requested twice is loaded once, the second request gets the same future
+// (a mesh requested with another weld tolerance is another load).
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_ASSETLOADER_H
+#define _INCGUARD_ASSETLOADER_H
+
+#include "meshRegistry.h"
+#include "types.h"
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+class AssetLoader
+{
+public:
+    // Content of a file, null if it can not be read.
+    typedef std::shared_ptr<const std::vector<uint8>> FileDataPtr;
+
+    typedef std::function<void(const FileDataPtr&)> FileCallback;
+    typedef std::function<void(const MeshAssetPtr&)> MeshCallback;
+
+    // Null uses the shared pool.
+    explicit AssetLoader(ThreadPool* pPool = nullptr);
+
+    // Waits for the loads in flight, their callbacks are not run.
+    ~AssetLoader();
+
+    std::shared_future<FileDataPtr> LoadFile(const std::string& fileName, const FileCallback& onLoaded = FileCallback());
+    std::shared_future<MeshAssetPtr> LoadMesh(const std::string& fileName, const MeshCallback& onLoaded = MeshCallback(),
+        const WeldTolerance* pWeld = nullptr);
+
+    // Run the callbacks of the loads finished so far. Returns the number of
+    // loads still in flight.
+    uint32 Update();
+
+    // Wait for all the loads, running their callbacks as they finish
+    // (including the loads requested by the callbacks).
+    void Finish();
+
+private:
+    AssetLoader(const AssetLoader&);
+    AssetLoader& operator=(const AssetLoader&);
+
+    template<typename T>
+    struct Load
+    {
+        std::shared_future<T> Result;
+        std::vector<std::function<void(const T&)>> Callbacks;
+        bool Done;
+    };
+
+    template<typename T>
+    std::shared_future<T> Request(std::unordered_map<std::string, std::shared_ptr<Load<T>>>& loads,
+        const std::string& fileName, const std::function<void(const T&)>& onLoaded,
+        const std::function<T()>& work);
+
+    ThreadPool& m_pool;
+
+    std::unordered_map<std::string, std::shared_ptr<Load<FileDataPtr>>> m_files;
+    std::unordered_map<std::string, std::shared_ptr<Load<MeshAssetPtr>>> m_meshes;
+
+    // Callbacks of the finished loads, waiting for Update or Finish.
+    std::vector<std::function<void()>> m_ready;
+    uint32 m_inFlight;
+
+    std::mutex m_mutex;
+    std::condition_variable m_loaded;
+};
+
+#endif // _INCGUARD_ASSETLOADER_H
@@ -0,0 +1,94 @@
+#include "coherentCulling.h"
+
+namespace XNA
+{
+
+//-----------------------------------------------------------------------------
+// Shared by the box and sphere versions, PlaneTest is one of the
+// Intersect*Plane routines (0 = outside, 1 = intersecting, 2 = inside).
+//-----------------------------------------------------------------------------
+template<typename Volume, typename PlaneTest>
+static inline INT Intersect6PlanesCoherent( const Volume* pVolume, const XMVECTOR* pPlanes, UINT PlaneMask,
+                                            UINT* pOutPlaneMask, BYTE* pLastFailedPlane, PlaneTest Test )
+{
+    XMASSERT( pVolume );
+    XMASSERT( pPlanes );
+    XMASSERT( pLastFailedPlane );
+
+    UINT Remaining = PlaneMask & PLANE_MASK_ALL;
+
+    // Most of the time the last failing plane rejects the volume again.
+    UINT Last = *pLastFailedPlane;
+    if( Last < 6 && ( Remaining & ( 1 << Last ) ) )
+    {
+        INT Result = Test( pVolume, pPlanes[Last] );
+
+        if( Result == 0 )
+        {
+            if( pOutPlaneMask )
+                *pOutPlaneMask = 0;
+            return 0;
+        }
+
+        if( Result == 2 )
+            Remaining &= ~( 1 << Last );
+    }
+    else
+    {
+        // Not in the mask, so nothing to retest.
+        Last = 6;
+    }
+
+    UINT Straddled = Remaining;
+
+    for( UINT i = 0; i < 6; i++ )
+    {
+        if( i == Last || !( Remaining & ( 1 << i ) ) )
+            continue;
+
+        INT Result = Test( pVolume, pPlanes[i] );
+
+        if( Result == 0 )
+        {
+            *pLastFailedPlane = (BYTE)i;
+
+            if( pOutPlaneMask )
+                *pOutPlaneMask = 0;
+            return 0;
+        }
+
+        if( Result == 2 )
+            Straddled &= ~( 1 << i );
+    }
+
+    if( pOutPlaneMask )
+        *pOutPlaneMask = Straddled;
+
+    return Straddled ? 1 : 2;
+}
+
+static inline INT TestAxisAlignedBoxPlane( const AxisAlignedBox* pVolume, FXMVECTOR Plane )
+{
+    return IntersectAxisAlignedBoxPlane( pVolume, Plane );
+}
+
+static inline INT TestSpherePlane( const Sphere* pVolume, FXMVECTOR Plane )
+{
+    return IntersectSpherePlane( pVolume, Plane );
+}
+
+INT IntersectAxisAlignedBox6PlanesCoherent( const AxisAlignedBox* pVolume, const XMVECTOR* pPlanes, UINT PlaneMask,
+                                            UINT* pOutPlaneMask, BYTE* pLastFailedPlane )
+{
+    return Intersect6PlanesCoherent( pVolume, pPlanes, PlaneMask, pOutPlaneMask, pLastFailedPlane,
+                                     TestAxisAlignedBoxPlane );
+}
+
+INT IntersectSphere6PlanesCoherent( const Sphere* pVolume, const XMVECTOR* pPlanes, UINT PlaneMask,
+                                    UINT* pOutPlaneMask, BYTE* pLastFailedPlane )
+{
+    return Intersect6PlanesCoherent( pVolume, pPlanes, PlaneMask, pOutPlaneMask, pLastFailedPlane,
+                                     TestSpherePlane );
+}
+
+}; // namespace
@@ -0,0 +1,44 @@
+//---------------------------------------------------------------------------------------
+//
+// Frustum culling with frame to frame coherence.
+//
+// Same tests (and return codes) as XNA::IntersectAxisAlignedBox6Planes and
+// XNA::IntersectSphere6Planes with two shortcuts:
+//  - the plane that rejected a volume last frame is tested first. With a camera
+//    moving smoothly it usually rejects the volume again, after a single test.
+//  - a plane mask tells which planes still have to be tested. A node fully
+//    inside some planes hands the reduced mask to its children, a node inside
+//    all of them (empty mask) accepts its children without any test.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_COHERENTCULLING_H
+#define _INCGUARD_COHERENTCULLING_H
+
+#include "xnacollision.h"
+
+namespace XNA
+{
+
+// One bit per plane, all 6 planes to be tested.
+const UINT PLANE_MASK_ALL = 0x3f;
+
+//-----------------------------------------------------------------------------
+// pPlanes:          the 6 planes (outside is the positive side).
+// PlaneMask:        planes to test, PLANE_MASK_ALL for a root volume.
+// pOutPlaneMask:    planes the volume is not fully inside, to be passed to the
+//                   children of the volume. Can be null.
+// pLastFailedPlane: per volume state kept between frames, initialize it to 0.
+//                   Updated when a plane rejects the volume.
+// Return values: 0 = volume is outside one of the planes,
+//                1 = may be intersecting,
+//                2 = volume is inside all the planes
+//-----------------------------------------------------------------------------
+INT IntersectAxisAlignedBox6PlanesCoherent( const AxisAlignedBox* pVolume, const XMVECTOR* pPlanes, UINT PlaneMask,
+                                            UINT* pOutPlaneMask, BYTE* pLastFailedPlane );
+INT IntersectSphere6PlanesCoherent( const Sphere* pVolume, const XMVECTOR* pPlanes, UINT PlaneMask,
+                                    UINT* pOutPlaneMask, BYTE* pLastFailedPlane );
+
+}; // namespace
+
+#endif // _INCGUARD_COHERENTCULLING_H
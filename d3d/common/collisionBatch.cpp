@@ -0,0 +1,645 @@
+#include "collisionBatch.h"
+#include "cpuFeatures.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#if defined(OC_CPU_X86)
+#include <immintrin.h>
+#endif
+
+namespace XNA
+{
+
+typedef void (*BoxStreamFn)( const AxisAlignedBoxStream*, uint32, uint32, const PlaneSet6*, uint8* );
+typedef void (*SphereStreamFn)( const SphereStream*, uint32, uint32, const PlaneSet6*, uint8* );
+typedef void (*BoxMultiFn)( const AxisAlignedBoxStream*, uint32, uint32, const MultiFrustumPlanes*, uint32* );
+typedef void (*SphereMultiFn)( const SphereStream*, uint32, uint32, const MultiFrustumPlanes*, uint32* );
+
+//-----------------------------------------------------------------------------
+// Scalar reference path.
+// Every backend evaluates the distances in the same order, without fused
+// multiply-add, so all of them return exactly the same results.
+//-----------------------------------------------------------------------------
+static void IntersectBoxStreamScalar( const AxisAlignedBoxStream* pVolumes, uint32 Begin, uint32 End,
+                                      const PlaneSet6* pPlanes, uint8* pResults )
+{
+    for( uint32 i = Begin; i < End; i++ )
+    {
+        float cx = pVolumes->CenterX[i];
+        float cy = pVolumes->CenterY[i];
+        float cz = pVolumes->CenterZ[i];
+        float ex = pVolumes->ExtentX[i];
+        float ey = pVolumes->ExtentY[i];
+        float ez = pVolumes->ExtentZ[i];
+
+        bool AnyOutside = false;
+        bool AllInside = true;
+
+        for( int k = 0; k < 6; k++ )
+        {
+            float Dist = cx * pPlanes->Nx[k] + cy * pPlanes->Ny[k] + cz * pPlanes->Nz[k] + pPlanes->D[k];
+            float Radius = ex * fabsf( pPlanes->Nx[k] ) + ey * fabsf( pPlanes->Ny[k] ) + ez * fabsf( pPlanes->Nz[k] );
+
+            AnyOutside |= ( Dist > Radius );
+            AllInside &= ( Dist < -Radius );
+        }
+
+        pResults[i] = AnyOutside ? 0 : ( AllInside ? 2 : 1 );
+    }
+}
+
+static void IntersectSphereStreamScalar( const SphereStream* pVolumes, uint32 Begin, uint32 End,
+                                         const PlaneSet6* pPlanes, uint8* pResults )
+{
+    for( uint32 i = Begin; i < End; i++ )
+    {
+        float cx = pVolumes->CenterX[i];
+        float cy = pVolumes->CenterY[i];
+        float cz = pVolumes->CenterZ[i];
+        float Radius = pVolumes->Radius[i];
+
+        bool AnyOutside = false;
+        bool AllInside = true;
+
+        for( int k = 0; k < 6; k++ )
+        {
+            float Dist = cx * pPlanes->Nx[k] + cy * pPlanes->Ny[k] + cz * pPlanes->Nz[k] + pPlanes->D[k];
+
+            AnyOutside |= ( Dist > Radius );
+            AllInside &= ( Dist < -Radius );
+        }
+
+        pResults[i] = AnyOutside ? 0 : ( AllInside ? 2 : 1 );
+    }
+}
+
+static void CullBoxStreamMultiScalar( const AxisAlignedBoxStream* pVolumes, uint32 Begin, uint32 End,
+                                      const MultiFrustumPlanes* pPlanes, uint32* pMasks )
+{
+    for( uint32 i = Begin; i < End; i++ )
+    {
+        float cx = pVolumes->CenterX[i];
+        float cy = pVolumes->CenterY[i];
+        float cz = pVolumes->CenterZ[i];
+        float ex = pVolumes->ExtentX[i];
+        float ey = pVolumes->ExtentY[i];
+        float ez = pVolumes->ExtentZ[i];
+
+        uint32 Mask = 0;
+
+        for( uint32 f = 0; f < pPlanes->FrustumCount; f++ )
+        {
+            bool AnyOutside = false;
+
+            for( uint32 k = f * 6; k < f * 6 + 6; k++ )
+            {
+                float Dist = cx * pPlanes->Nx[k] + cy * pPlanes->Ny[k] + cz * pPlanes->Nz[k] + pPlanes->D[k];
+                float Radius = ex * pPlanes->AbsNx[k] + ey * pPlanes->AbsNy[k] + ez * pPlanes->AbsNz[k];
+
+                AnyOutside |= ( Dist > Radius );
+            }
+
+            Mask |= AnyOutside ? 0 : ( 1u << f );
+        }
+
+        pMasks[i] = Mask;
+    }
+}
+
+static void CullSphereStreamMultiScalar( const SphereStream* pVolumes, uint32 Begin, uint32 End,
+                                         const MultiFrustumPlanes* pPlanes, uint32* pMasks )
+{
+    for( uint32 i = Begin; i < End; i++ )
+    {
+        float cx = pVolumes->CenterX[i];
+        float cy = pVolumes->CenterY[i];
+        float cz = pVolumes->CenterZ[i];
+        float Radius = pVolumes->Radius[i];
+
+        uint32 Mask = 0;
+
+        for( uint32 f = 0; f < pPlanes->FrustumCount; f++ )
+        {
+            bool AnyOutside = false;
+
+            for( uint32 k = f * 6; k < f * 6 + 6; k++ )
+            {
+                float Dist = cx * pPlanes->Nx[k] + cy * pPlanes->Ny[k] + cz * pPlanes->Nz[k] + pPlanes->D[k];
+
+                AnyOutside |= ( Dist > Radius );
+            }
+
+            Mask |= AnyOutside ? 0 : ( 1u << f );
+        }
+
+        pMasks[i] = Mask;
+    }
+}
+
+
+
+#if defined(OC_CPU_X86)
+//-----------------------------------------------------------------------------
+// SSE4.1 path, 4 volumes per iteration.
+//-----------------------------------------------------------------------------
+OC_TARGET_SSE41 static inline void StoreResultsSSE41( __m128 Outside, __m128 Inside, uint8* pResults )
+{
+    const __m128 One = _mm_castsi128_ps( _mm_set1_epi32( 1 ) );
+    const __m128 Two = _mm_castsi128_ps( _mm_set1_epi32( 2 ) );
+
+    __m128 Codes = _mm_blendv_ps( One, Two, Inside );
+    Codes = _mm_blendv_ps( Codes, _mm_setzero_ps(), Outside );
+
+    __m128i Packed = _mm_packus_epi32( _mm_castps_si128( Codes ), _mm_castps_si128( Codes ) );
+    Packed = _mm_packus_epi16( Packed, Packed );
+
+    int Bytes = _mm_cvtsi128_si32( Packed );
+    memcpy( pResults, &Bytes, 4 );
+}
+
+OC_TARGET_SSE41 static void IntersectBoxStreamSSE41( const AxisAlignedBoxStream* pVolumes, uint32 Begin, uint32 End,
+                                                     const PlaneSet6* pPlanes, uint8* pResults )
+{
+    const __m128 AbsMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) );
+    const __m128 Zero = _mm_setzero_ps();
+    const __m128 True = _mm_cmpeq_ps( Zero, Zero );
+
+    uint32 i = Begin;
+    for( ; i + 4 <= End; i += 4 )
+    {
+        __m128 cx = _mm_loadu_ps( pVolumes->CenterX + i );
+        __m128 cy = _mm_loadu_ps( pVolumes->CenterY + i );
+        __m128 cz = _mm_loadu_ps( pVolumes->CenterZ + i );
+        __m128 ex = _mm_loadu_ps( pVolumes->ExtentX + i );
+        __m128 ey = _mm_loadu_ps( pVolumes->ExtentY + i );
+        __m128 ez = _mm_loadu_ps( pVolumes->ExtentZ + i );
+
+        __m128 AnyOutside = Zero;
+        __m128 AllInside = True;
+
+        for( int k = 0; k < 6; k++ )
+        {
+            __m128 nx = _mm_set1_ps( pPlanes->Nx[k] );
+            __m128 ny = _mm_set1_ps( pPlanes->Ny[k] );
+            __m128 nz = _mm_set1_ps( pPlanes->Nz[k] );
+            __m128 d = _mm_set1_ps( pPlanes->D[k] );
+
+            __m128 Dist = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( cx, nx ), _mm_mul_ps( cy, ny ) ),
+                                                  _mm_mul_ps( cz, nz ) ), d );
+            __m128 Radius = _mm_add_ps( _mm_add_ps( _mm_mul_ps( ex, _mm_and_ps( nx, AbsMask ) ),
+                                                    _mm_mul_ps( ey, _mm_and_ps( ny, AbsMask ) ) ),
+                                        _mm_mul_ps( ez, _mm_and_ps( nz, AbsMask ) ) );
+
+            AnyOutside = _mm_or_ps( AnyOutside, _mm_cmpgt_ps( Dist, Radius ) );
+            AllInside = _mm_and_ps( AllInside, _mm_cmplt_ps( Dist, _mm_sub_ps( Zero, Radius ) ) );
+        }
+
+        StoreResultsSSE41( AnyOutside, AllInside, pResults + i );
+    }
+
+    IntersectBoxStreamScalar( pVolumes, i, End, pPlanes, pResults );
+}
+
+OC_TARGET_SSE41 static void IntersectSphereStreamSSE41( const SphereStream* pVolumes, uint32 Begin, uint32 End,
+                                                        const PlaneSet6* pPlanes, uint8* pResults )
+{
+    const __m128 Zero = _mm_setzero_ps();
+    const __m128 True = _mm_cmpeq_ps( Zero, Zero );
+
+    uint32 i = Begin;
+    for( ; i + 4 <= End; i += 4 )
+    {
+        __m128 cx = _mm_loadu_ps( pVolumes->CenterX + i );
+        __m128 cy = _mm_loadu_ps( pVolumes->CenterY + i );
+        __m128 cz = _mm_loadu_ps( pVolumes->CenterZ + i );
+        __m128 Radius = _mm_loadu_ps( pVolumes->Radius + i );
+        __m128 NegRadius = _mm_sub_ps( Zero, Radius );
+
+        __m128 AnyOutside = Zero;
+        __m128 AllInside = True;
+
+        for( int k = 0; k < 6; k++ )
+        {
+            __m128 Dist = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( cx, _mm_set1_ps( pPlanes->Nx[k] ) ),
+                                                              _mm_mul_ps( cy, _mm_set1_ps( pPlanes->Ny[k] ) ) ),
+                                                  _mm_mul_ps( cz, _mm_set1_ps( pPlanes->Nz[k] ) ) ),
+                                      _mm_set1_ps( pPlanes->D[k] ) );
+
+            AnyOutside = _mm_or_ps( AnyOutside, _mm_cmpgt_ps( Dist, Radius ) );
+            AllInside = _mm_and_ps( AllInside, _mm_cmplt_ps( Dist, NegRadius ) );
+        }
+
+        StoreResultsSSE41( AnyOutside, AllInside, pResults + i );
+    }
+
+    IntersectSphereStreamScalar( pVolumes, i, End, pPlanes, pResults );
+}
+
+OC_TARGET_SSE41 static void CullBoxStreamMultiSSE41( const AxisAlignedBoxStream* pVolumes, uint32 Begin, uint32 End,
+                                                     const MultiFrustumPlanes* pPlanes, uint32* pMasks )
+{
+    uint32 i = Begin;
+    for( ; i + 4 <= End; i += 4 )
+    {
+        __m128 cx = _mm_loadu_ps( pVolumes->CenterX + i );
+        __m128 cy = _mm_loadu_ps( pVolumes->CenterY + i );
+        __m128 cz = _mm_loadu_ps( pVolumes->CenterZ + i );
+        __m128 ex = _mm_loadu_ps( pVolumes->ExtentX + i );
+        __m128 ey = _mm_loadu_ps( pVolumes->ExtentY + i );
+        __m128 ez = _mm_loadu_ps( pVolumes->ExtentZ + i );
+
+        __m128i Mask = _mm_setzero_si128();
+
+        for( uint32 f = 0; f < pPlanes->FrustumCount; f++ )
+        {
+            __m128 AnyOutside = _mm_setzero_ps();
+
+            for( uint32 k = f * 6; k < f * 6 + 6; k++ )
+            {
+                __m128 Dist = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( cx, _mm_set1_ps( pPlanes->Nx[k] ) ),
+                                                                  _mm_mul_ps( cy, _mm_set1_ps( pPlanes->Ny[k] ) ) ),
+                                                      _mm_mul_ps( cz, _mm_set1_ps( pPlanes->Nz[k] ) ) ),
+                                          _mm_set1_ps( pPlanes->D[k] ) );
+                __m128 Radius = _mm_add_ps( _mm_add_ps( _mm_mul_ps( ex, _mm_set1_ps( pPlanes->AbsNx[k] ) ),
+                                                        _mm_mul_ps( ey, _mm_set1_ps( pPlanes->AbsNy[k] ) ) ),
+                                            _mm_mul_ps( ez, _mm_set1_ps( pPlanes->AbsNz[k] ) ) );
+
+                AnyOutside = _mm_or_ps( AnyOutside, _mm_cmpgt_ps( Dist, Radius ) );
+            }
+
+            Mask = _mm_or_si128( Mask, _mm_andnot_si128( _mm_castps_si128( AnyOutside ), _mm_set1_epi32( (int)( 1u << f ) ) ) );
+        }
+
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( pMasks + i ), Mask );
+    }
+
+    CullBoxStreamMultiScalar( pVolumes, i, End, pPlanes, pMasks );
+}
+
+OC_TARGET_SSE41 static void CullSphereStreamMultiSSE41( const SphereStream* pVolumes, uint32 Begin, uint32 End,
+                                                        const MultiFrustumPlanes* pPlanes, uint32* pMasks )
+{
+    uint32 i = Begin;
+    for( ; i + 4 <= End; i += 4 )
+    {
+        __m128 cx = _mm_loadu_ps( pVolumes->CenterX + i );
+        __m128 cy = _mm_loadu_ps( pVolumes->CenterY + i );
+        __m128 cz = _mm_loadu_ps( pVolumes->CenterZ + i );
+        __m128 Radius = _mm_loadu_ps( pVolumes->Radius + i );
+
+        __m128i Mask = _mm_setzero_si128();
+
+        for( uint32 f = 0; f < pPlanes->FrustumCount; f++ )
+        {
+            __m128 AnyOutside = _mm_setzero_ps();
+
+            for( uint32 k = f * 6; k < f * 6 + 6; k++ )
+            {
+                __m128 Dist = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( cx, _mm_set1_ps( pPlanes->Nx[k] ) ),
+                                                                  _mm_mul_ps( cy, _mm_set1_ps( pPlanes->Ny[k] ) ) ),
+                                                      _mm_mul_ps( cz, _mm_set1_ps( pPlanes->Nz[k] ) ) ),
+                                          _mm_set1_ps( pPlanes->D[k] ) );
+
+                AnyOutside = _mm_or_ps( AnyOutside, _mm_cmpgt_ps( Dist, Radius ) );
+            }
+
+            Mask = _mm_or_si128( Mask, _mm_andnot_si128( _mm_castps_si128( AnyOutside ), _mm_set1_epi32( (int)( 1u << f ) ) ) );
+        }
+
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( pMasks + i ), Mask );
+    }
+
+    CullSphereStreamMultiScalar( pVolumes, i, End, pPlanes, pMasks );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// AVX2 path, 8 volumes per iteration.
+//-----------------------------------------------------------------------------
+OC_TARGET_AVX2 static inline void StoreResultsAVX2( __m256 Outside, __m256 Inside, uint8* pResults )
+{
+    const __m256 One = _mm256_castsi256_ps( _mm256_set1_epi32( 1 ) );
+    const __m256 Two = _mm256_castsi256_ps( _mm256_set1_epi32( 2 ) );
+
+    __m256 Codes = _mm256_blendv_ps( One, Two, Inside );
+    Codes = _mm256_blendv_ps( Codes, _mm256_setzero_ps(), Outside );
+
+    // Packing works per 128 bit lane: the low dword of each lane ends up
+    // holding the 4 result bytes of that lane.
+    __m256i Packed = _mm256_packus_epi32( _mm256_castps_si256( Codes ), _mm256_castps_si256( Codes ) );
+    Packed = _mm256_packus_epi16( Packed, Packed );
+
+    int Low = _mm_cvtsi128_si32( _mm256_castsi256_si128( Packed ) );
+    int High = _mm_cvtsi128_si32( _mm256_extracti128_si256( Packed, 1 ) );
+    memcpy( pResults, &Low, 4 );
+    memcpy( pResults + 4, &High, 4 );
+}
+
+OC_TARGET_AVX2 static void IntersectBoxStreamAVX2( const AxisAlignedBoxStream* pVolumes, uint32 Begin, uint32 End,
+                                                   const PlaneSet6* pPlanes, uint8* pResults )
+{
+    const __m256 AbsMask = _mm256_castsi256_ps( _mm256_set1_epi32( 0x7fffffff ) );
+    const __m256 Zero = _mm256_setzero_ps();
+    const __m256 True = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+
+    uint32 i = Begin;
+    for( ; i + 8 <= End; i += 8 )
+    {
+        __m256 cx = _mm256_loadu_ps( pVolumes->CenterX + i );
+        __m256 cy = _mm256_loadu_ps( pVolumes->CenterY + i );
+        __m256 cz = _mm256_loadu_ps( pVolumes->CenterZ + i );
+        __m256 ex = _mm256_loadu_ps( pVolumes->ExtentX + i );
+        __m256 ey = _mm256_loadu_ps( pVolumes->ExtentY + i );
+        __m256 ez = _mm256_loadu_ps( pVolumes->ExtentZ + i );
+
+        __m256 AnyOutside = Zero;
+        __m256 AllInside = True;
+
+        for( int k = 0; k < 6; k++ )
+        {
+            __m256 nx = _mm256_set1_ps( pPlanes->Nx[k] );
+            __m256 ny = _mm256_set1_ps( pPlanes->Ny[k] );
+            __m256 nz = _mm256_set1_ps( pPlanes->Nz[k] );
+            __m256 d = _mm256_set1_ps( pPlanes->D[k] );
+
+            __m256 Dist = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( cx, nx ), _mm256_mul_ps( cy, ny ) ),
+                                                        _mm256_mul_ps( cz, nz ) ), d );
+            __m256 Radius = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( ex, _mm256_and_ps( nx, AbsMask ) ),
+                                                          _mm256_mul_ps( ey, _mm256_and_ps( ny, AbsMask ) ) ),
+                                           _mm256_mul_ps( ez, _mm256_and_ps( nz, AbsMask ) ) );
+
+            AnyOutside = _mm256_or_ps( AnyOutside, _mm256_cmp_ps( Dist, Radius, _CMP_GT_OQ ) );
+            AllInside = _mm256_and_ps( AllInside, _mm256_cmp_ps( Dist, _mm256_sub_ps( Zero, Radius ), _CMP_LT_OQ ) );
+        }
+
+        StoreResultsAVX2( AnyOutside, AllInside, pResults + i );
+    }
+
+    _mm256_zeroupper();
+
+    IntersectBoxStreamScalar( pVolumes, i, End, pPlanes, pResults );
+}
+
+OC_TARGET_AVX2 static void IntersectSphereStreamAVX2( const SphereStream* pVolumes, uint32 Begin, uint32 End,
+                                                      const PlaneSet6* pPlanes, uint8* pResults )
+{
+    const __m256 Zero = _mm256_setzero_ps();
+    const __m256 True = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+
+    uint32 i = Begin;
+    for( ; i + 8 <= End; i += 8 )
+    {
+        __m256 cx = _mm256_loadu_ps( pVolumes->CenterX + i );
+        __m256 cy = _mm256_loadu_ps( pVolumes->CenterY + i );
+        __m256 cz = _mm256_loadu_ps( pVolumes->CenterZ + i );
+        __m256 Radius = _mm256_loadu_ps( pVolumes->Radius + i );
+        __m256 NegRadius = _mm256_sub_ps( Zero, Radius );
+
+        __m256 AnyOutside = Zero;
+        __m256 AllInside = True;
+
+        for( int k = 0; k < 6; k++ )
+        {
+            __m256 Dist = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps(
+                                             _mm256_mul_ps( cx, _mm256_set1_ps( pPlanes->Nx[k] ) ),
+                                             _mm256_mul_ps( cy, _mm256_set1_ps( pPlanes->Ny[k] ) ) ),
+                                             _mm256_mul_ps( cz, _mm256_set1_ps( pPlanes->Nz[k] ) ) ),
+                                         _mm256_set1_ps( pPlanes->D[k] ) );
+
+            AnyOutside = _mm256_or_ps( AnyOutside, _mm256_cmp_ps( Dist, Radius, _CMP_GT_OQ ) );
+            AllInside = _mm256_and_ps( AllInside, _mm256_cmp_ps( Dist, NegRadius, _CMP_LT_OQ ) );
+        }
+
+        StoreResultsAVX2( AnyOutside, AllInside, pResults + i );
+    }
+
+    _mm256_zeroupper();
+
+    IntersectSphereStreamScalar( pVolumes, i, End, pPlanes, pResults );
+}
+
+OC_TARGET_AVX2 static void CullBoxStreamMultiAVX2( const AxisAlignedBoxStream* pVolumes, uint32 Begin, uint32 End,
+                                                   const MultiFrustumPlanes* pPlanes, uint32* pMasks )
+{
+    uint32 i = Begin;
+    for( ; i + 8 <= End; i += 8 )
+    {
+        __m256 cx = _mm256_loadu_ps( pVolumes->CenterX + i );
+        __m256 cy = _mm256_loadu_ps( pVolumes->CenterY + i );
+        __m256 cz = _mm256_loadu_ps( pVolumes->CenterZ + i );
+        __m256 ex = _mm256_loadu_ps( pVolumes->ExtentX + i );
+        __m256 ey = _mm256_loadu_ps( pVolumes->ExtentY + i );
+        __m256 ez = _mm256_loadu_ps( pVolumes->ExtentZ + i );
+
+        __m256i Mask = _mm256_setzero_si256();
+
+        for( uint32 f = 0; f < pPlanes->FrustumCount; f++ )
+        {
+            __m256 AnyOutside = _mm256_setzero_ps();
+
+            for( uint32 k = f * 6; k < f * 6 + 6; k++ )
+            {
+                __m256 Dist = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps(
+                                                 _mm256_mul_ps( cx, _mm256_set1_ps( pPlanes->Nx[k] ) ),
+                                                 _mm256_mul_ps( cy, _mm256_set1_ps( pPlanes->Ny[k] ) ) ),
+                                                 _mm256_mul_ps( cz, _mm256_set1_ps( pPlanes->Nz[k] ) ) ),
+                                             _mm256_set1_ps( pPlanes->D[k] ) );
+                __m256 Radius = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( ex, _mm256_set1_ps( pPlanes->AbsNx[k] ) ),
+                                                              _mm256_mul_ps( ey, _mm256_set1_ps( pPlanes->AbsNy[k] ) ) ),
+                                               _mm256_mul_ps( ez, _mm256_set1_ps( pPlanes->AbsNz[k] ) ) );
+
+                AnyOutside = _mm256_or_ps( AnyOutside, _mm256_cmp_ps( Dist, Radius, _CMP_GT_OQ ) );
+            }
+
+            Mask = _mm256_or_si256( Mask, _mm256_andnot_si256( _mm256_castps_si256( AnyOutside ),
+                                                               _mm256_set1_epi32( (int)( 1u << f ) ) ) );
+        }
+
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( pMasks + i ), Mask );
+    }
+
+    _mm256_zeroupper();
+
+    CullBoxStreamMultiScalar( pVolumes, i, End, pPlanes, pMasks );
+}
+
+OC_TARGET_AVX2 static void CullSphereStreamMultiAVX2( const SphereStream* pVolumes, uint32 Begin, uint32 End,
+                                                      const MultiFrustumPlanes* pPlanes, uint32* pMasks )
+{
+    uint32 i = Begin;
+    for( ; i + 8 <= End; i += 8 )
+    {
+        __m256 cx = _mm256_loadu_ps( pVolumes->CenterX + i );
+        __m256 cy = _mm256_loadu_ps( pVolumes->CenterY + i );
+        __m256 cz = _mm256_loadu_ps( pVolumes->CenterZ + i );
+        __m256 Radius = _mm256_loadu_ps( pVolumes->Radius + i );
+
+        __m256i Mask = _mm256_setzero_si256();
+
+        for( uint32 f = 0; f < pPlanes->FrustumCount; f++ )
+        {
+            __m256 AnyOutside = _mm256_setzero_ps();
+
+            for( uint32 k = f * 6; k < f * 6 + 6; k++ )
+            {
+                __m256 Dist = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps(
+                                                 _mm256_mul_ps( cx, _mm256_set1_ps( pPlanes->Nx[k] ) ),
+                                                 _mm256_mul_ps( cy, _mm256_set1_ps( pPlanes->Ny[k] ) ) ),
+                                                 _mm256_mul_ps( cz, _mm256_set1_ps( pPlanes->Nz[k] ) ) ),
+                                             _mm256_set1_ps( pPlanes->D[k] ) );
+
+                AnyOutside = _mm256_or_ps( AnyOutside, _mm256_cmp_ps( Dist, Radius, _CMP_GT_OQ ) );
+            }
+
+            Mask = _mm256_or_si256( Mask, _mm256_andnot_si256( _mm256_castps_si256( AnyOutside ),
+                                                               _mm256_set1_epi32( (int)( 1u << f ) ) ) );
+        }
+
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( pMasks + i ), Mask );
+    }
+
+    _mm256_zeroupper();
+
+    CullSphereStreamMultiScalar( pVolumes, i, End, pPlanes, pMasks );
+}
+#endif
+
+
+
+//-----------------------------------------------------------------------------
+// Dispatch.
+//-----------------------------------------------------------------------------
+struct SimdBackendTable
+{
+    const char* Name;
+    BoxStreamFn Box;
+    SphereStreamFn Sphere;
+    BoxMultiFn BoxMulti;
+    SphereMultiFn SphereMulti;
+};
+
+static const SimdBackendTable g_Backends[SIMD_BACKEND_COUNT] =
+{
+    { "scalar", IntersectBoxStreamScalar, IntersectSphereStreamScalar, CullBoxStreamMultiScalar, CullSphereStreamMultiScalar },
+#if defined(OC_CPU_X86)
+    { "sse4.1", IntersectBoxStreamSSE41, IntersectSphereStreamSSE41, CullBoxStreamMultiSSE41, CullSphereStreamMultiSSE41 },
+    { "avx2", IntersectBoxStreamAVX2, IntersectSphereStreamAVX2, CullBoxStreamMultiAVX2, CullSphereStreamMultiAVX2 },
+#else
+    { "sse4.1", IntersectBoxStreamScalar, IntersectSphereStreamScalar, CullBoxStreamMultiScalar, CullSphereStreamMultiScalar },
+    { "avx2", IntersectBoxStreamScalar, IntersectSphereStreamScalar, CullBoxStreamMultiScalar, CullSphereStreamMultiScalar },
+#endif
+};
+
+// Resolved on first use, SetSimdBackend can be called from any thread.
+static std::atomic<int> g_ActiveBackend( -1 );
+
+bool IsSimdBackendSupported( SimdBackend backend )
+{
+    switch( backend )
+    {
+    case SIMD_BACKEND_SCALAR:
+        return true;
+#if defined(OC_CPU_X86)
+    case SIMD_BACKEND_SSE41:
+        return CpuFeatures::HasSSE41();
+    case SIMD_BACKEND_AVX2:
+        return CpuFeatures::HasAVX2();
+#endif
+    default:
+        return false;
+    }
+}
+
+const char* GetSimdBackendName( SimdBackend backend )
+{
+    if( backend < 0 || backend >= SIMD_BACKEND_COUNT )
+        return "unknown";
+
+    return g_Backends[backend].Name;
+}
+
+SimdBackend SetSimdBackend( SimdBackend backend )
+{
+    int selected = ( backend >= 0 && backend < SIMD_BACKEND_COUNT ) ? backend : SIMD_BACKEND_AVX2;
+
+    while( selected > SIMD_BACKEND_SCALAR && !IsSimdBackendSupported( (SimdBackend)selected ) )
+        --selected;
+
+    g_ActiveBackend.store( selected );
+    return (SimdBackend)selected;
+}
+
+SimdBackend GetSimdBackend()
+{
+    int active = g_ActiveBackend.load();
+
+    if( active < 0 )
+        return SetSimdBackend( SIMD_BACKEND_AVX2 );
+
+    return (SimdBackend)active;
+}
+
+void LoadPlaneSet6( PlaneSet6* pOut, const float* pPlanes )
+{
+    for( int k = 0; k < 6; k++ )
+    {
+        pOut->Nx[k] = pPlanes[k * 4 + 0];
+        pOut->Ny[k] = pPlanes[k * 4 + 1];
+        pOut->Nz[k] = pPlanes[k * 4 + 2];
+        pOut->D[k] = pPlanes[k * 4 + 3];
+    }
+
+    // Padding planes never reject anything.
+    for( int k = 6; k < 8; k++ )
+    {
+        pOut->Nx[k] = pOut->Ny[k] = pOut->Nz[k] = 0.0f;
+        pOut->D[k] = -1.0f;
+    }
+}
+
+void IntersectAxisAlignedBoxStream6Planes( const AxisAlignedBoxStream* pVolumes, uint32 Count,
+                                           const PlaneSet6* pPlanes, uint8* pResults )
+{
+    g_Backends[GetSimdBackend()].Box( pVolumes, 0, Count, pPlanes, pResults );
+}
+
+void IntersectSphereStream6Planes( const SphereStream* pVolumes, uint32 Count,
+                                   const PlaneSet6* pPlanes, uint8* pResults )
+{
+    g_Backends[GetSimdBackend()].Sphere( pVolumes, 0, Count, pPlanes, pResults );
+}
+
+void LoadMultiFrustumPlanes( MultiFrustumPlanes* pOut, const float* pPlanes, uint32 FrustumCount )
+{
+    if( FrustumCount > MULTI_FRUSTUM_MAX )
+        FrustumCount = MULTI_FRUSTUM_MAX;
+
+    pOut->FrustumCount = FrustumCount;
+
+    for( uint32 k = 0; k < FrustumCount * 6; k++ )
+    {
+        pOut->Nx[k] = pPlanes[k * 4 + 0];
+        pOut->Ny[k] = pPlanes[k * 4 + 1];
+        pOut->Nz[k] = pPlanes[k * 4 + 2];
+        pOut->D[k] = pPlanes[k * 4 + 3];
+        pOut->AbsNx[k] = fabsf( pOut->Nx[k] );
+        pOut->AbsNy[k] = fabsf( pOut->Ny[k] );
+        pOut->AbsNz[k] = fabsf( pOut->Nz[k] );
+    }
+}
+
+void CullAxisAlignedBoxStreamMultiFrustum( const AxisAlignedBoxStream* pVolumes, uint32 Count,
+                                           const MultiFrustumPlanes* pPlanes, uint32* pMasks )
+{
+    g_Backends[GetSimdBackend()].BoxMulti( pVolumes, 0, Count, pPlanes, pMasks );
+}
+
+void CullSphereStreamMultiFrustum( const SphereStream* pVolumes, uint32 Count,
+                                   const MultiFrustumPlanes* pPlanes, uint32* pMasks )
+{
+    g_Backends[GetSimdBackend()].SphereMulti( pVolumes, 0, Count, pPlanes, pMasks );
+}
+
+}; // namespace
@@ -0,0 +1,127 @@
+//---------------------------------------------------------------------------------------
+//
+// Batched bounding volume vs planes tests.
+//
+// Same tests (and return codes) as XNA::IntersectAxisAlignedBox6Planes and
+// XNA::IntersectSphere6Planes but run over whole streams of volumes stored as
+// structure of arrays. The code does not depend on XNAMath so it can be built on
+// any platform. There is a scalar reference path and SSE4.1 / AVX2 paths, the
+// fastest one supported by the CPU is chosen at runtime.
+//
+// The single volume Intersect* and Compute* routines have portable versions in
+// collisionPortable.h, on the same backends. tools/CollisionBatchTest checks the
+// backends against each other, and against the XNAMath functions on Windows.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_COLLISIONBATCH_H
+#define _INCGUARD_COLLISIONBATCH_H
+
+#include "types.h"
+
+namespace XNA
+{
+
+enum SimdBackend
+{
+    SIMD_BACKEND_SCALAR = 0,
+    SIMD_BACKEND_SSE41,
+    SIMD_BACKEND_AVX2,
+    SIMD_BACKEND_COUNT
+};
+
+// Backend used by the batch and the portable routines. Picked from CPUID on
+// first use.
+SimdBackend GetSimdBackend();
+
+// Force a backend (for comparisons). Falls back to the best supported backend
+// if the requested one is not available, returns the backend in effect.
+SimdBackend SetSimdBackend(SimdBackend backend);
+
+bool IsSimdBackendSupported(SimdBackend backend);
+const char* GetSimdBackendName(SimdBackend backend);
+
+//-----------------------------------------------------------------------------
+// Six planes in SoA form, padded to 8 so a plane can be broadcast from a
+// single aligned load. Outside a plane is the positive side (same convention
+// as ComputePlanesFromFrustum).
+//-----------------------------------------------------------------------------
+struct PlaneSet6
+{
+    float Nx[8];
+    float Ny[8];
+    float Nz[8];
+    float D[8];
+};
+
+// pPlanes holds 6 planes as (a, b, c, d) quadruplets.
+void LoadPlaneSet6(PlaneSet6* pOut, const float* pPlanes);
+
+//-----------------------------------------------------------------------------
+// Volume streams (structure of arrays).
+//-----------------------------------------------------------------------------
+struct AxisAlignedBoxStream
+{
+    const float* CenterX;
+    const float* CenterY;
+    const float* CenterZ;
+    const float* ExtentX;
+    const float* ExtentY;
+    const float* ExtentZ;
+};
+
+struct SphereStream
+{
+    const float* CenterX;
+    const float* CenterY;
+    const float* CenterZ;
+    const float* Radius;
+};
+
+//-----------------------------------------------------------------------------
+// Test Count volumes vs the 6 planes and write one result per volume.
+// Return values: 0 = volume is outside one of the planes,
+//                1 = may be intersecting,
+//                2 = volume is inside all the planes
+//-----------------------------------------------------------------------------
+void IntersectAxisAlignedBoxStream6Planes( const AxisAlignedBoxStream* pVolumes, uint32 Count,
+                                           const PlaneSet6* pPlanes, uint8* pResults );
+void IntersectSphereStream6Planes( const SphereStream* pVolumes, uint32 Count,
+                                   const PlaneSet6* pPlanes, uint8* pResults );
+
+//-----------------------------------------------------------------------------
+// Several frustums (cube map faces, main camera, shadow cascades...) tested in
+// one sweep. The planes of all the frustums are stored back to back in SoA
+// form, with the absolute normals used by the box tests computed once.
+//-----------------------------------------------------------------------------
+const uint32 MULTI_FRUSTUM_MAX = 32;
+
+struct MultiFrustumPlanes
+{
+    uint32 FrustumCount;
+    float Nx[MULTI_FRUSTUM_MAX * 6];
+    float Ny[MULTI_FRUSTUM_MAX * 6];
+    float Nz[MULTI_FRUSTUM_MAX * 6];
+    float D[MULTI_FRUSTUM_MAX * 6];
+    float AbsNx[MULTI_FRUSTUM_MAX * 6];
+    float AbsNy[MULTI_FRUSTUM_MAX * 6];
+    float AbsNz[MULTI_FRUSTUM_MAX * 6];
+};
+
+// pPlanes holds FrustumCount * 6 planes as (a, b, c, d) quadruplets, frustum
+// after frustum. FrustumCount must not exceed MULTI_FRUSTUM_MAX.
+void LoadMultiFrustumPlanes( MultiFrustumPlanes* pOut, const float* pPlanes, uint32 FrustumCount );
+
+//-----------------------------------------------------------------------------
+// Test Count volumes vs every frustum and write one visibility mask per volume:
+// bit k is set unless the volume is outside one of the planes of frustum k
+// (i.e. the 6 planes test did not return 0).
+//-----------------------------------------------------------------------------
+void CullAxisAlignedBoxStreamMultiFrustum( const AxisAlignedBoxStream* pVolumes, uint32 Count,
+                                           const MultiFrustumPlanes* pPlanes, uint32* pMasks );
+void CullSphereStreamMultiFrustum( const SphereStream* pVolumes, uint32 Count,
+                                   const MultiFrustumPlanes* pPlanes, uint32* pMasks );
+
+}; // namespace
+
+#endif // _INCGUARD_COLLISIONBATCH_H
@@ -0,0 +1,398 @@
+#include "collisionPortable.h"
+#include "collisionBatch.h"
+#include "cpuFeatures.h"
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(OC_CPU_X86)
+#include <immintrin.h>
+#endif
+
+namespace XNA
+{
+namespace Portable
+{
+
+//-----------------------------------------------------------------------------
+// Control of VectorPermute: byte i of the result is byte FromA[i] of the first
+// vector or'ed with byte FromB[i] of the second, 0x80 selects zero (the pshufb
+// convention). Elements 0-3 are x-w of the first vector and 4-7 x-w of the
+// second, like XM_PERMUTE_0X to XM_PERMUTE_1W.
+//-----------------------------------------------------------------------------
+struct PermuteControl
+{
+    uint8 FromA[16];
+    uint8 FromB[16];
+};
+
+#define XNA_PERMUTE_BYTE_A( E, B ) ( uint8 )( ( E ) < 4 ? ( E ) * 4 + ( B ) : 0x80 )
+#define XNA_PERMUTE_BYTE_B( E, B ) ( uint8 )( ( E ) >= 4 ? ( ( E ) - 4 ) * 4 + ( B ) : 0x80 )
+#define XNA_PERMUTE_LANE_A( E ) \
+    XNA_PERMUTE_BYTE_A( E, 0 ), XNA_PERMUTE_BYTE_A( E, 1 ), XNA_PERMUTE_BYTE_A( E, 2 ), XNA_PERMUTE_BYTE_A( E, 3 )
+#define XNA_PERMUTE_LANE_B( E ) \
+    XNA_PERMUTE_BYTE_B( E, 0 ), XNA_PERMUTE_BYTE_B( E, 1 ), XNA_PERMUTE_BYTE_B( E, 2 ), XNA_PERMUTE_BYTE_B( E, 3 )
+
+// Constant initializer, so static controls need no code at startup.
+#define XNA_PERMUTE_CONTROL( E0, E1, E2, E3 ) \
+    { \
+        { XNA_PERMUTE_LANE_A( E0 ), XNA_PERMUTE_LANE_A( E1 ), XNA_PERMUTE_LANE_A( E2 ), XNA_PERMUTE_LANE_A( E3 ) }, \
+        { XNA_PERMUTE_LANE_B( E0 ), XNA_PERMUTE_LANE_B( E1 ), XNA_PERMUTE_LANE_B( E2 ), XNA_PERMUTE_LANE_B( E3 ) } \
+    }
+
+static inline void BuildPermuteControl( PermuteControl* pControl, uint32 E0, uint32 E1, uint32 E2, uint32 E3 )
+{
+    const uint32 Elements[4] = { E0, E1, E2, E3 };
+
+    for( int i = 0; i < 4; i++ )
+    {
+        for( int b = 0; b < 4; b++ )
+        {
+            pControl->FromA[i * 4 + b] = XNA_PERMUTE_BYTE_A( Elements[i], b );
+            pControl->FromB[i * 4 + b] = XNA_PERMUTE_BYTE_B( Elements[i], b );
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Routines of one backend.
+//-----------------------------------------------------------------------------
+struct KernelTable
+{
+    void (*ComputeBoundingSphereFromPoints)( Sphere*, uint32, const Float3*, uint32 );
+    void (*ComputeBoundingAxisAlignedBoxFromPoints)( AxisAlignedBox*, uint32, const Float3*, uint32 );
+    void (*ComputeBoundingOrientedBoxFromPoints)( OrientedBox*, uint32, const Float3*, uint32 );
+    void (*ComputeFrustumFromProjection)( Frustum*, const Matrix* );
+    void (*ComputePlanesFromFrustum)( const Frustum*, Float4*, Float4*, Float4*, Float4*, Float4*, Float4* );
+    bool (*IntersectPointSphere)( const Float4&, const Sphere* );
+    bool (*IntersectPointAxisAlignedBox)( const Float4&, const AxisAlignedBox* );
+    bool (*IntersectPointOrientedBox)( const Float4&, const OrientedBox* );
+    bool (*IntersectPointFrustum)( const Float4&, const Frustum* );
+    bool (*IntersectRayTriangle)( const Float4&, const Float4&, const Float4&, const Float4&, const Float4&,
+                                  float* );
+    bool (*IntersectRaySphere)( const Float4&, const Float4&, const Sphere*, float* );
+    bool (*IntersectRayAxisAlignedBox)( const Float4&, const Float4&, const AxisAlignedBox*, float* );
+    bool (*IntersectRayOrientedBox)( const Float4&, const Float4&, const OrientedBox*, float* );
+    bool (*IntersectTriangleTriangle)( const Float4&, const Float4&, const Float4&, const Float4&, const Float4&,
+                                       const Float4& );
+    bool (*IntersectTriangleSphere)( const Float4&, const Float4&, const Float4&, const Sphere* );
+    bool (*IntersectTriangleAxisAlignedBox)( const Float4&, const Float4&, const Float4&, const AxisAlignedBox* );
+    bool (*IntersectTriangleOrientedBox)( const Float4&, const Float4&, const Float4&, const OrientedBox* );
+    bool (*IntersectSphereSphere)( const Sphere*, const Sphere* );
+    bool (*IntersectSphereAxisAlignedBox)( const Sphere*, const AxisAlignedBox* );
+    bool (*IntersectSphereOrientedBox)( const Sphere*, const OrientedBox* );
+    bool (*IntersectAxisAlignedBoxAxisAlignedBox)( const AxisAlignedBox*, const AxisAlignedBox* );
+    bool (*IntersectAxisAlignedBoxOrientedBox)( const AxisAlignedBox*, const OrientedBox* );
+    bool (*IntersectOrientedBoxOrientedBox)( const OrientedBox*, const OrientedBox* );
+    int (*IntersectTriangleFrustum)( const Float4&, const Float4&, const Float4&, const Frustum* );
+    int (*IntersectSphereFrustum)( const Sphere*, const Frustum* );
+    int (*IntersectAxisAlignedBoxFrustum)( const AxisAlignedBox*, const Frustum* );
+    int (*IntersectOrientedBoxFrustum)( const OrientedBox*, const Frustum* );
+    int (*IntersectFrustumFrustum)( const Frustum*, const Frustum* );
+    int (*IntersectTriangle6Planes)( const Float4&, const Float4&, const Float4&, const Float4&, const Float4&,
+                                     const Float4&, const Float4&, const Float4&, const Float4& );
+    int (*IntersectSphere6Planes)( const Sphere*, const Float4&, const Float4&, const Float4&, const Float4&,
+                                   const Float4&, const Float4& );
+    int (*IntersectAxisAlignedBox6Planes)( const AxisAlignedBox*, const Float4&, const Float4&, const Float4&,
+                                           const Float4&, const Float4&, const Float4& );
+    int (*IntersectOrientedBox6Planes)( const OrientedBox*, const Float4&, const Float4&, const Float4&,
+                                        const Float4&, const Float4&, const Float4& );
+    int (*IntersectFrustum6Planes)( const Frustum*, const Float4&, const Float4&, const Float4&, const Float4&,
+                                    const Float4&, const Float4& );
+    int (*IntersectTrianglePlane)( const Float4&, const Float4&, const Float4&, const Float4& );
+    int (*IntersectSpherePlane)( const Sphere*, const Float4& );
+    int (*IntersectAxisAlignedBoxPlane)( const AxisAlignedBox*, const Float4& );
+    int (*IntersectOrientedBoxPlane)( const OrientedBox*, const Float4& );
+    int (*IntersectFrustumPlane)( const Frustum*, const Float4& );
+};
+
+// The vector layer and the routines are compiled once per backend, in its own
+// namespace, every function carrying the target of the backend. The routines call
+// each other through the Backend alias, the public overloads taking Float4 would
+// otherwise be found too.
+#define XNA_KERNEL XNA_KERNEL_TARGET static inline
+
+//-----------------------------------------------------------------------------
+// Scalar reference path.
+//-----------------------------------------------------------------------------
+namespace Scalar
+{
+namespace Backend = XNA::Portable::Scalar;
+
+#define XNA_KERNEL_TARGET
+#include "collisionPortableVector.inl"
+#include "collisionPortableKernels.inl"
+#undef XNA_KERNEL_TARGET
+}; // namespace Scalar
+
+
+
+#if defined(OC_CPU_X86)
+#define XNA_PORTABLE_SSE
+
+//-----------------------------------------------------------------------------
+// SSE4.1 path.
+//-----------------------------------------------------------------------------
+namespace SSE41
+{
+namespace Backend = XNA::Portable::SSE41;
+
+#define XNA_KERNEL_TARGET OC_TARGET_SSE41
+#include "collisionPortableVector.inl"
+#include "collisionPortableKernels.inl"
+#undef XNA_KERNEL_TARGET
+}; // namespace SSE41
+
+
+
+//-----------------------------------------------------------------------------
+// AVX2 path. The routines work on one vector at a time, so this is the SSE
+// code with the VEX encoding, which saves the register copies of the legacy
+// two operand forms.
+//-----------------------------------------------------------------------------
+namespace AVX2
+{
+namespace Backend = XNA::Portable::AVX2;
+
+#define XNA_KERNEL_TARGET OC_TARGET_AVX2
+#include "collisionPortableVector.inl"
+#include "collisionPortableKernels.inl"
+#undef XNA_KERNEL_TARGET
+}; // namespace AVX2
+
+#undef XNA_PORTABLE_SSE
+#endif
+
+#undef XNA_KERNEL
+
+
+
+//-----------------------------------------------------------------------------
+// Dispatch, on the backend of collisionBatch.h.
+//-----------------------------------------------------------------------------
+static const KernelTable* const g_Kernels[SIMD_BACKEND_COUNT] =
+{
+    &Scalar::Kernels,
+#if defined(OC_CPU_X86)
+    &SSE41::Kernels,
+    &AVX2::Kernels,
+#else
+    &Scalar::Kernels,
+    &Scalar::Kernels,
+#endif
+};
+
+static inline const KernelTable& ActiveKernels()
+{
+    return *g_Kernels[GetSimdBackend()];
+}
+
+void ComputeBoundingSphereFromPoints( Sphere* pOut, uint32 Count, const Float3* pPoints, uint32 Stride )
+{
+    ActiveKernels().ComputeBoundingSphereFromPoints( pOut, Count, pPoints, Stride );
+}
+
+void ComputeBoundingAxisAlignedBoxFromPoints( AxisAlignedBox* pOut, uint32 Count, const Float3* pPoints,
+                                              uint32 Stride )
+{
+    ActiveKernels().ComputeBoundingAxisAlignedBoxFromPoints( pOut, Count, pPoints, Stride );
+}
+
+void ComputeBoundingOrientedBoxFromPoints( OrientedBox* pOut, uint32 Count, const Float3* pPoints, uint32 Stride )
+{
+    ActiveKernels().ComputeBoundingOrientedBoxFromPoints( pOut, Count, pPoints, Stride );
+}
+
+void ComputeFrustumFromProjection( Frustum* pOut, const Matrix* pProjection )
+{
+    ActiveKernels().ComputeFrustumFromProjection( pOut, pProjection );
+}
+
+void ComputePlanesFromFrustum( const Frustum* pVolume, Float4* pPlane0, Float4* pPlane1, Float4* pPlane2,
+                               Float4* pPlane3, Float4* pPlane4, Float4* pPlane5 )
+{
+    ActiveKernels().ComputePlanesFromFrustum( pVolume, pPlane0, pPlane1, pPlane2, pPlane3, pPlane4, pPlane5 );
+}
+
+bool IntersectPointSphere( const Float4& Point, const Sphere* pVolume )
+{
+    return ActiveKernels().IntersectPointSphere( Point, pVolume );
+}
+
+bool IntersectPointAxisAlignedBox( const Float4& Point, const AxisAlignedBox* pVolume )
+{
+    return ActiveKernels().IntersectPointAxisAlignedBox( Point, pVolume );
+}
+
+bool IntersectPointOrientedBox( const Float4& Point, const OrientedBox* pVolume )
+{
+    return ActiveKernels().IntersectPointOrientedBox( Point, pVolume );
+}
+
+bool IntersectPointFrustum( const Float4& Point, const Frustum* pVolume )
+{
+    return ActiveKernels().IntersectPointFrustum( Point, pVolume );
+}
+
+bool IntersectRayTriangle( const Float4& Origin, const Float4& Direction, const Float4& V0, const Float4& V1,
+                           const Float4& V2, float* pDist )
+{
+    return ActiveKernels().IntersectRayTriangle( Origin, Direction, V0, V1, V2, pDist );
+}
+
+bool IntersectRaySphere( const Float4& Origin, const Float4& Direction, const Sphere* pVolume, float* pDist )
+{
+    return ActiveKernels().IntersectRaySphere( Origin, Direction, pVolume, pDist );
+}
+
+bool IntersectRayAxisAlignedBox( const Float4& Origin, const Float4& Direction, const AxisAlignedBox* pVolume,
+                                 float* pDist )
+{
+    return ActiveKernels().IntersectRayAxisAlignedBox( Origin, Direction, pVolume, pDist );
+}
+
+bool IntersectRayOrientedBox( const Float4& Origin, const Float4& Direction, const OrientedBox* pVolume,
+                              float* pDist )
+{
+    return ActiveKernels().IntersectRayOrientedBox( Origin, Direction, pVolume, pDist );
+}
+
+bool IntersectTriangleTriangle( const Float4& A0, const Float4& A1, const Float4& A2, const Float4& B0,
+                                const Float4& B1, const Float4& B2 )
+{
+    return ActiveKernels().IntersectTriangleTriangle( A0, A1, A2, B0, B1, B2 );
+}
+
+bool IntersectTriangleSphere( const Float4& V0, const Float4& V1, const Float4& V2, const Sphere* pVolume )
+{
+    return ActiveKernels().IntersectTriangleSphere( V0, V1, V2, pVolume );
+}
+
+bool IntersectTriangleAxisAlignedBox( const Float4& V0, const Float4& V1, const Float4& V2,
+                                      const AxisAlignedBox* pVolume )
+{
+    return ActiveKernels().IntersectTriangleAxisAlignedBox( V0, V1, V2, pVolume );
+}
+
+bool IntersectTriangleOrientedBox( const Float4& V0, const Float4& V1, const Float4& V2,
+                                   const OrientedBox* pVolume )
+{
+    return ActiveKernels().IntersectTriangleOrientedBox( V0, V1, V2, pVolume );
+}
+
+bool IntersectSphereSphere( const Sphere* pVolumeA, const Sphere* pVolumeB )
+{
+    return ActiveKernels().IntersectSphereSphere( pVolumeA, pVolumeB );
+}
+
+bool IntersectSphereAxisAlignedBox( const Sphere* pVolumeA, const AxisAlignedBox* pVolumeB )
+{
+    return ActiveKernels().IntersectSphereAxisAlignedBox( pVolumeA, pVolumeB );
+}
+
+bool IntersectSphereOrientedBox( const Sphere* pVolumeA, const OrientedBox* pVolumeB )
+{
+    return ActiveKernels().IntersectSphereOrientedBox( pVolumeA, pVolumeB );
+}
+
+bool IntersectAxisAlignedBoxAxisAlignedBox( const AxisAlignedBox* pVolumeA, const AxisAlignedBox* pVolumeB )
+{
+    return ActiveKernels().IntersectAxisAlignedBoxAxisAlignedBox( pVolumeA, pVolumeB );
+}
+
+bool IntersectAxisAlignedBoxOrientedBox( const AxisAlignedBox* pVolumeA, const OrientedBox* pVolumeB )
+{
+    return ActiveKernels().IntersectAxisAlignedBoxOrientedBox( pVolumeA, pVolumeB );
+}
+
+bool IntersectOrientedBoxOrientedBox( const OrientedBox* pVolumeA, const OrientedBox* pVolumeB )
+{
+    return ActiveKernels().IntersectOrientedBoxOrientedBox( pVolumeA, pVolumeB );
+}
+
+int IntersectTriangleFrustum( const Float4& V0, const Float4& V1, const Float4& V2, const Frustum* pVolume )
+{
+    return ActiveKernels().IntersectTriangleFrustum( V0, V1, V2, pVolume );
+}
+
+int IntersectSphereFrustum( const Sphere* pVolumeA, const Frustum* pVolumeB )
+{
+    return ActiveKernels().IntersectSphereFrustum( pVolumeA, pVolumeB );
+}
+
+int IntersectAxisAlignedBoxFrustum( const AxisAlignedBox* pVolumeA, const Frustum* pVolumeB )
+{
+    return ActiveKernels().IntersectAxisAlignedBoxFrustum( pVolumeA, pVolumeB );
+}
+
+int IntersectOrientedBoxFrustum( const OrientedBox* pVolumeA, const Frustum* pVolumeB )
+{
+    return ActiveKernels().IntersectOrientedBoxFrustum( pVolumeA, pVolumeB );
+}
+
+int IntersectFrustumFrustum( const Frustum* pVolumeA, const Frustum* pVolumeB )
+{
+    return ActiveKernels().IntersectFrustumFrustum( pVolumeA, pVolumeB );
+}
+
+int IntersectTriangle6Planes( const Float4& V0, const Float4& V1, const Float4& V2, const Float4& Plane0,
+                              const Float4& Plane1, const Float4& Plane2, const Float4& Plane3,
+                              const Float4& Plane4, const Float4& Plane5 )
+{
+    return ActiveKernels().IntersectTriangle6Planes( V0, V1, V2, Plane0, Plane1, Plane2, Plane3, Plane4, Plane5 );
+}
+
+int IntersectSphere6Planes( const Sphere* pVolume, const Float4& Plane0, const Float4& Plane1, const Float4& Plane2,
+                            const Float4& Plane3, const Float4& Plane4, const Float4& Plane5 )
+{
+    return ActiveKernels().IntersectSphere6Planes( pVolume, Plane0, Plane1, Plane2, Plane3, Plane4, Plane5 );
+}
+
+int IntersectAxisAlignedBox6Planes( const AxisAlignedBox* pVolume, const Float4& Plane0, const Float4& Plane1,
+                                    const Float4& Plane2, const Float4& Plane3, const Float4& Plane4,
+                                    const Float4& Plane5 )
+{
+    return ActiveKernels().IntersectAxisAlignedBox6Planes( pVolume, Plane0, Plane1, Plane2, Plane3, Plane4, Plane5 );
+}
+
+int IntersectOrientedBox6Planes( const OrientedBox* pVolume, const Float4& Plane0, const Float4& Plane1,
+                                 const Float4& Plane2, const Float4& Plane3, const Float4& Plane4,
+                                 const Float4& Plane5 )
+{
+    return ActiveKernels().IntersectOrientedBox6Planes( pVolume, Plane0, Plane1, Plane2, Plane3, Plane4, Plane5 );
+}
+
+int IntersectFrustum6Planes( const Frustum* pVolume, const Float4& Plane0, const Float4& Plane1,
+                             const Float4& Plane2, const Float4& Plane3, const Float4& Plane4,
+                             const Float4& Plane5 )
+{
+    return ActiveKernels().IntersectFrustum6Planes( pVolume, Plane0, Plane1, Plane2, Plane3, Plane4, Plane5 );
+}
+
+int IntersectTrianglePlane( const Float4& V0, const Float4& V1, const Float4& V2, const Float4& Plane )
+{
+    return ActiveKernels().IntersectTrianglePlane( V0, V1, V2, Plane );
+}
+
+int IntersectSpherePlane( const Sphere* pVolume, const Float4& Plane )
+{
+    return ActiveKernels().IntersectSpherePlane( pVolume, Plane );
+}
+
+int IntersectAxisAlignedBoxPlane( const AxisAlignedBox* pVolume, const Float4& Plane )
+{
+    return ActiveKernels().IntersectAxisAlignedBoxPlane( pVolume, Plane );
+}
+
+int IntersectOrientedBoxPlane( const OrientedBox* pVolume, const Float4& Plane )
+{
+    return ActiveKernels().IntersectOrientedBoxPlane( pVolume, Plane );
+}
+
+int IntersectFrustumPlane( const Frustum* pVolume, const Float4& Plane )
+{
+    return ActiveKernels().IntersectFrustumPlane( pVolume, Plane );
+}
+}; // namespace Portable
+}; // namespace XNA
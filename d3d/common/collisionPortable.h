@@ -0,0 +1,179 @@
+//---------------------------------------------------------------------------------------
+//
+// Portable single volume collision routines.
+//
+// The Intersect* and Compute* routines of xnacollision.h, with the same names,
+// arguments and return codes, ported so they do not depend on XNAMath. They run on
+// the backend selected by the collisionBatch.h dispatch (GetSimdBackend and
+// SetSimdBackend): a scalar reference path, and SSE4.1 and AVX2 paths. The Transform*
+// routines are not ported.
+//
+// Every backend builds the routines from the same lane-wise operations. It does not
+// use estimates or fused multiply-add, and sums horizontally in a fixed order, so
+// all the backends return bitwise identical results. They follow the XNAMath code
+// closely but do not always use the same operation order, so results may differ
+// from XNA's in the last bits.
+//
+// The volume structures have the layout of the XNA ones (XMFLOAT3 and XMFLOAT4 are
+// plain floats), and vectors are passed as Float4 where XNA takes an XMVECTOR.
+// tools/CollisionBatchTest checks the backends against each other, and against
+// xnacollision on Windows.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_COLLISIONPORTABLE_H
+#define _INCGUARD_COLLISIONPORTABLE_H
+
+#include "types.h"
+
+namespace XNA
+{
+namespace Portable
+{
+
+struct Float3
+{
+    float x, y, z;
+};
+
+struct Float4
+{
+    float x, y, z, w;
+};
+
+// Rows, as XMMATRIX.
+struct Matrix
+{
+    Float4 r[4];
+};
+
+//-----------------------------------------------------------------------------
+// Bounding volumes, same members and layout as xnacollision.h.
+//-----------------------------------------------------------------------------
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4324)
+#define XNA_PORTABLE_ALIGN16 __declspec(align(16))
+#else
+#define XNA_PORTABLE_ALIGN16 __attribute__((aligned(16)))
+#endif
+
+struct XNA_PORTABLE_ALIGN16 Sphere
+{
+    Float3 Center;              // Center of the sphere.
+    float Radius;               // Radius of the sphere.
+};
+
+struct XNA_PORTABLE_ALIGN16 AxisAlignedBox
+{
+    Float3 Center;              // Center of the box.
+    Float3 Extents;             // Distance from the center to each side.
+};
+
+struct XNA_PORTABLE_ALIGN16 OrientedBox
+{
+    Float3 Center;              // Center of the box.
+    Float3 Extents;             // Distance from the center to each side.
+    Float4 Orientation;         // Unit quaternion representing rotation (box -> world).
+};
+
+struct XNA_PORTABLE_ALIGN16 Frustum
+{
+    Float3 Origin;              // Origin of the frustum (and projection).
+    Float4 Orientation;         // Unit quaternion representing rotation.
+
+    float RightSlope;           // Positive X slope (X/Z).
+    float LeftSlope;            // Negative X slope.
+    float TopSlope;             // Positive Y slope (Y/Z).
+    float BottomSlope;          // Negative Y slope.
+    float Near, Far;            // Z of the near plane and far plane.
+};
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+//-----------------------------------------------------------------------------
+// Bounding volume construction.
+//-----------------------------------------------------------------------------
+void ComputeBoundingSphereFromPoints( Sphere* pOut, uint32 Count, const Float3* pPoints, uint32 Stride );
+void ComputeBoundingAxisAlignedBoxFromPoints( AxisAlignedBox* pOut, uint32 Count, const Float3* pPoints, uint32 Stride );
+void ComputeBoundingOrientedBoxFromPoints( OrientedBox* pOut, uint32 Count, const Float3* pPoints, uint32 Stride );
+void ComputeFrustumFromProjection( Frustum* pOut, const Matrix* pProjection );
+void ComputePlanesFromFrustum( const Frustum* pVolume, Float4* pPlane0, Float4* pPlane1, Float4* pPlane2,
+                               Float4* pPlane3, Float4* pPlane4, Float4* pPlane5 );
+
+//-----------------------------------------------------------------------------
+// Intersection testing routines.
+//-----------------------------------------------------------------------------
+bool IntersectPointSphere( const Float4& Point, const Sphere* pVolume );
+bool IntersectPointAxisAlignedBox( const Float4& Point, const AxisAlignedBox* pVolume );
+bool IntersectPointOrientedBox( const Float4& Point, const OrientedBox* pVolume );
+bool IntersectPointFrustum( const Float4& Point, const Frustum* pVolume );
+bool IntersectRayTriangle( const Float4& Origin, const Float4& Direction, const Float4& V0, const Float4& V1,
+                           const Float4& V2, float* pDist );
+bool IntersectRaySphere( const Float4& Origin, const Float4& Direction, const Sphere* pVolume, float* pDist );
+bool IntersectRayAxisAlignedBox( const Float4& Origin, const Float4& Direction, const AxisAlignedBox* pVolume,
+                                 float* pDist );
+bool IntersectRayOrientedBox( const Float4& Origin, const Float4& Direction, const OrientedBox* pVolume, float* pDist );
+bool IntersectTriangleTriangle( const Float4& A0, const Float4& A1, const Float4& A2, const Float4& B0,
+                                const Float4& B1, const Float4& B2 );
+bool IntersectTriangleSphere( const Float4& V0, const Float4& V1, const Float4& V2, const Sphere* pVolume );
+bool IntersectTriangleAxisAlignedBox( const Float4& V0, const Float4& V1, const Float4& V2,
+                                      const AxisAlignedBox* pVolume );
+bool IntersectTriangleOrientedBox( const Float4& V0, const Float4& V1, const Float4& V2, const OrientedBox* pVolume );
+bool IntersectSphereSphere( const Sphere* pVolumeA, const Sphere* pVolumeB );
+bool IntersectSphereAxisAlignedBox( const Sphere* pVolumeA, const AxisAlignedBox* pVolumeB );
+bool IntersectSphereOrientedBox( const Sphere* pVolumeA, const OrientedBox* pVolumeB );
+bool IntersectAxisAlignedBoxAxisAlignedBox( const AxisAlignedBox* pVolumeA, const AxisAlignedBox* pVolumeB );
+bool IntersectAxisAlignedBoxOrientedBox( const AxisAlignedBox* pVolumeA, const OrientedBox* pVolumeB );
+bool IntersectOrientedBoxOrientedBox( const OrientedBox* pVolumeA, const OrientedBox* pVolumeB );
+
+//-----------------------------------------------------------------------------
+// Frustum intersection testing routines.
+// Return values: 0 = no intersection,
+//                1 = intersection,
+//                2 = A is completely inside B
+//-----------------------------------------------------------------------------
+int IntersectTriangleFrustum( const Float4& V0, const Float4& V1, const Float4& V2, const Frustum* pVolume );
+int IntersectSphereFrustum( const Sphere* pVolumeA, const Frustum* pVolumeB );
+int IntersectAxisAlignedBoxFrustum( const AxisAlignedBox* pVolumeA, const Frustum* pVolumeB );
+int IntersectOrientedBoxFrustum( const OrientedBox* pVolumeA, const Frustum* pVolumeB );
+int IntersectFrustumFrustum( const Frustum* pVolumeA, const Frustum* pVolumeB );
+
+//-----------------------------------------------------------------------------
+// Test vs six planes (usually forming a frustum) intersection routines.
+// Return values: 0 = volume is outside one of the planes (no intersection),
+//                1 = not completely inside or completely outside (intersecting),
+//                2 = volume is inside all the planes (completely inside)
+//-----------------------------------------------------------------------------
+int IntersectTriangle6Planes( const Float4& V0, const Float4& V1, const Float4& V2, const Float4& Plane0,
+                              const Float4& Plane1, const Float4& Plane2, const Float4& Plane3, const Float4& Plane4,
+                              const Float4& Plane5 );
+int IntersectSphere6Planes( const Sphere* pVolume, const Float4& Plane0, const Float4& Plane1, const Float4& Plane2,
+                            const Float4& Plane3, const Float4& Plane4, const Float4& Plane5 );
+int IntersectAxisAlignedBox6Planes( const AxisAlignedBox* pVolume, const Float4& Plane0, const Float4& Plane1,
+                                    const Float4& Plane2, const Float4& Plane3, const Float4& Plane4,
+                                    const Float4& Plane5 );
+int IntersectOrientedBox6Planes( const OrientedBox* pVolume, const Float4& Plane0, const Float4& Plane1,
+                                 const Float4& Plane2, const Float4& Plane3, const Float4& Plane4,
+                                 const Float4& Plane5 );
+int IntersectFrustum6Planes( const Frustum* pVolume, const Float4& Plane0, const Float4& Plane1, const Float4& Plane2,
+                             const Float4& Plane3, const Float4& Plane4, const Float4& Plane5 );
+
+//-----------------------------------------------------------------------------
+// Volume vs plane intersection testing routines.
+// Return values: 0 = volume is outside the plane (on the positive side of the plane),
+//                1 = volume intersects the plane,
+//                2 = volume is inside the plane (on the negative side of the plane)
+//-----------------------------------------------------------------------------
+int IntersectTrianglePlane( const Float4& V0, const Float4& V1, const Float4& V2, const Float4& Plane );
+int IntersectSpherePlane( const Sphere* pVolume, const Float4& Plane );
+int IntersectAxisAlignedBoxPlane( const AxisAlignedBox* pVolume, const Float4& Plane );
+int IntersectOrientedBoxPlane( const OrientedBox* pVolume, const Float4& Plane );
+int IntersectFrustumPlane( const Frustum* pVolume, const Float4& Plane );
+
+}; // namespace Portable
+}; // namespace XNA
+
+#endif // _INCGUARD_COLLISIONPORTABLE_H
@@ -0,0 +1,3852 @@
+//---------------------------------------------------------------------------------------
+//
+// Intersect* and Compute* routines of xnacollision.cpp on the portable vector layer.
+//
+// Included by collisionPortable.cpp inside each backend namespace, after
+// collisionPortableVector.inl. The routines are the xnacollision ones with the
+// XNAMath types and functions replaced by those of the vector layer, the logic and
+// the comments are unchanged. The Transform* routines are not ported.
+//
+//---------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Return true if any of the elements of a 3 vector are equal to 0xffffffff.
+// Slightly more efficient than using Vector3EqualInt.
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool Vector3AnyTrue( CVec V )
+{
+    Vec C;
+
+    // Duplicate the fourth element from the first element.
+    C = VectorSwizzle( V, 0, 1, 2, 0 );
+
+    return ComparisonAnyTrue( Vector4EqualIntR( C, VectorTrueInt() ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Return true if all of the elements of a 3 vector are equal to 0xffffffff.
+// Slightly more efficient than using Vector3EqualInt.
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool Vector3AllTrue( CVec V )
+{
+    Vec C;
+
+    // Duplicate the fourth element from the first element.
+    C = VectorSwizzle( V, 0, 1, 2, 0 );
+
+    return ComparisonAllTrue( Vector4EqualIntR( C, VectorTrueInt() ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Return true if the vector is a unit vector (length == 1).
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool Vector3IsUnit( CVec V )
+{
+    Vec Difference = Vector3Length( V ) - VectorSplatOne();
+
+    return Vector4Less( VectorAbs( Difference ), VectorReplicate( 1.0e-4f ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Return true if the quaterion is a unit quaternion.
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool QuaternionIsUnit( CVec Q )
+{
+    Vec Difference = Vector4Length( Q ) - VectorSplatOne();
+
+    return Vector4Less( VectorAbs( Difference ), VectorReplicate( 1.0e-4f ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Return true if the plane is a unit plane.
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool PlaneIsUnit( CVec Plane )
+{
+    Vec Difference = Vector3Length( Plane ) - VectorSplatOne();
+
+    return Vector4Less( VectorAbs( Difference ), VectorReplicate( 1.0e-4f ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Transform a plane by a rotation and translation.
+//-----------------------------------------------------------------------------
+XNA_KERNEL Vec TransformPlane( CVec Plane, CVec Rotation, CVec Translation )
+{
+    Vec Normal = Vector3Rotate( Plane, Rotation );
+    Vec D = VectorSplatW( Plane ) - Vector3Dot( Normal, Translation );
+
+    return VectorInsert( Normal, D, 0, 0, 0, 0, 1 );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Return the point on the line segement (S1, S2) nearest the point P.
+//-----------------------------------------------------------------------------
+XNA_KERNEL Vec PointOnLineSegmentNearestPoint( CVec S1, CVec S2, CVec P )
+{
+    Vec Dir = S2 - S1;
+    Vec Projection = ( Vector3Dot( P, Dir ) - Vector3Dot( S1, Dir ) );
+    Vec LengthSq = Vector3Dot( Dir, Dir );
+
+    Vec t = Projection * VectorReciprocal( LengthSq );
+    Vec Point = S1 + t * Dir;
+
+    // t < 0
+    Vec SelectS1 = VectorLess( Projection, VectorZero() );
+    Point = VectorSelect( Point, S1, SelectS1 );
+
+    // t > 1
+    Vec SelectS2 = VectorGreater( Projection, LengthSq );
+    Point = VectorSelect( Point, S2, SelectS2 );
+
+    return Point;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Test if the point (P) on the plane of the triangle is inside the triangle 
+// (V0, V1, V2).
+//-----------------------------------------------------------------------------
+XNA_KERNEL Vec PointOnPlaneInsideTriangle( CVec P, CVec V0, CVec V1, CVec V2 )
+{
+    // Compute the triangle normal.
+    Vec N = Vector3Cross( V2 - V0, V1 - V0 );
+
+    // Compute the cross products of the vector from the base of each edge to 
+    // the point with each edge vector.
+    Vec C0 = Vector3Cross( P - V0, V1 - V0 );
+    Vec C1 = Vector3Cross( P - V1, V2 - V1 );
+    Vec C2 = Vector3Cross( P - V2, V0 - V2 );
+
+    // If the cross product points in the same direction as the normal the the
+    // point is inside the edge (it is zero if is on the edge).
+    Vec Zero = VectorZero();
+    Vec Inside0 = VectorGreaterOrEqual( Vector3Dot( C0, N ), Zero );
+    Vec Inside1 = VectorGreaterOrEqual( Vector3Dot( C1, N ), Zero );
+    Vec Inside2 = VectorGreaterOrEqual( Vector3Dot( C2, N ), Zero );
+
+    // If the point inside all of the edges it is inside.
+    return VectorAndInt( VectorAndInt( Inside0, Inside1 ), Inside2 );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Find the approximate smallest enclosing bounding sphere for a set of 
+// points. Exact computation of the smallest enclosing bounding sphere is 
+// possible but is slower and requires a more complex algorithm.
+// The algorithm is based on  Jack Ritter, "An Efficient Bounding Sphere", 
+// Graphics Gems.
+//-----------------------------------------------------------------------------
+XNA_KERNEL void ComputeBoundingSphereFromPoints( Sphere* pOut, uint32 Count, const Float3* pPoints, uint32 Stride )
+{
+    assert( pOut );
+    assert( Count > 0 );
+    assert( pPoints );
+
+    // Find the points with minimum and maximum x, y, and z
+    Vec MinX, MaxX, MinY, MaxY, MinZ, MaxZ;
+
+    MinX = MaxX = MinY = MaxY = MinZ = MaxZ = LoadFloat3( pPoints );
+
+    for( uint32 i = 1; i < Count; i++ )
+    {
+        Vec Point = LoadFloat3( ( const Float3* )( ( const uint8* )pPoints + i * Stride ) );
+
+        float px = VectorGetX( Point );
+        float py = VectorGetY( Point );
+        float pz = VectorGetZ( Point );
+
+        if( px < VectorGetX( MinX ) )
+            MinX = Point;
+
+        if( px > VectorGetX( MaxX ) )
+            MaxX = Point;
+
+        if( py < VectorGetY( MinY ) )
+            MinY = Point;
+
+        if( py > VectorGetY( MaxY ) )
+            MaxY = Point;
+
+        if( pz < VectorGetZ( MinZ ) )
+            MinZ = Point;
+
+        if( pz > VectorGetZ( MaxZ ) )
+            MaxZ = Point;
+    }
+
+    // Use the min/max pair that are farthest apart to form the initial sphere.
+    Vec DeltaX = MaxX - MinX;
+    Vec DistX = Vector3Length( DeltaX );
+
+    Vec DeltaY = MaxY - MinY;
+    Vec DistY = Vector3Length( DeltaY );
+
+    Vec DeltaZ = MaxZ - MinZ;
+    Vec DistZ = Vector3Length( DeltaZ );
+
+    Vec Center;
+    Vec Radius;
+
+    if( Vector3Greater( DistX, DistY ) )
+    {
+        if( Vector3Greater( DistX, DistZ ) )
+        {
+            // Use min/max x.
+            Center = ( MaxX + MinX ) * 0.5f;
+            Radius = DistX * 0.5f;
+        }
+        else
+        {
+            // Use min/max z.
+            Center = ( MaxZ + MinZ ) * 0.5f;
+            Radius = DistZ * 0.5f;
+        }
+    }
+    else // Y >= X
+    {
+        if( Vector3Greater( DistY, DistZ ) )
+        {
+            // Use min/max y.
+            Center = ( MaxY + MinY ) * 0.5f;
+            Radius = DistY * 0.5f;
+        }
+        else
+        {
+            // Use min/max z.
+            Center = ( MaxZ + MinZ ) * 0.5f;
+            Radius = DistZ * 0.5f;
+        }
+    }
+
+    // Add any points not inside the sphere.
+    for( uint32 i = 0; i < Count; i++ )
+    {
+        Vec Point = LoadFloat3( ( const Float3* )( ( const uint8* )pPoints + i * Stride ) );
+
+        Vec Delta = Point - Center;
+
+        Vec Dist = Vector3Length( Delta );
+
+        if( Vector3Greater( Dist, Radius ) )
+        {
+            // Adjust sphere to include the new point.
+            Radius = ( Radius + Dist ) * 0.5f;
+            Center += ( VectorReplicate( 1.0f ) - Radius * VectorReciprocal( Dist ) ) * Delta;
+        }
+    }
+
+    StoreFloat3( &pOut->Center, Center );
+    StoreFloat( &pOut->Radius, Radius );
+
+    return;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Find the minimum axis aligned bounding box containing a set of points.
+//-----------------------------------------------------------------------------
+XNA_KERNEL void ComputeBoundingAxisAlignedBoxFromPoints( AxisAlignedBox* pOut, uint32 Count, const Float3* pPoints, uint32 Stride )
+{
+    assert( pOut );
+    assert( Count > 0 );
+    assert( pPoints );
+
+    // Find the minimum and maximum x, y, and z
+    Vec vMin, vMax;
+
+    vMin = vMax = LoadFloat3( pPoints );
+
+    for( uint32 i = 1; i < Count; i++ )
+    {
+        Vec Point = LoadFloat3( ( const Float3* )( ( const uint8* )pPoints + i * Stride ) );
+
+        vMin = VectorMin( vMin, Point );
+        vMax = VectorMax( vMax, Point );
+    }
+
+    // Store center and extents.
+    StoreFloat3( &pOut->Center, ( vMin + vMax ) * 0.5f );
+    StoreFloat3( &pOut->Extents, ( vMax - vMin ) * 0.5f );
+
+    return;
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool SolveCubic( float e, float f, float g, float* t, float* u, float* v )
+{
+    float p, q, h, rc, d, theta, costh3, sinth3;
+
+    p = f - e * e / 3.0f;
+    q = g - e * f / 3.0f + e * e * e * 2.0f / 27.0f;
+    h = q * q / 4.0f + p * p * p / 27.0f;
+
+    if( h > 0.0 )
+    {
+        return false; // only one real root
+    }
+
+    if( ( h == 0.0 ) && ( q == 0.0 ) ) // all the same root
+    {
+        *t = - e / 3;
+        *u = - e / 3;
+        *v = - e / 3;
+
+        return true;
+    }
+
+    d = sqrtf( q * q / 4.0f - h );
+    if( d < 0 )
+        rc = -powf( -d, 1.0f / 3.0f );
+    else
+        rc = powf( d, 1.0f / 3.0f );
+
+    theta = acosf( -q / ( 2.0f * d ) );
+    costh3 = cosf( theta / 3.0f );
+    sinth3 = sqrtf( 3.0f ) * sinf( theta / 3.0f );
+    *t = 2.0f * rc * costh3 - e / 3.0f;
+    *u = -rc * ( costh3 + sinth3 ) - e / 3.0f;
+    *v = -rc * ( costh3 - sinth3 ) - e / 3.0f;
+
+    return true;
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL Vec CalculateEigenVector( float m11, float m12, float m13,
+                                     float m22, float m23, float m33, float e )
+{
+    float f1, f2, f3;
+
+    float fTmp[3];
+    fTmp[0] = ( float )( m12 * m23 - m13 * ( m22 - e ) );
+    fTmp[1] = ( float )( m13 * m12 - m23 * ( m11 - e ) );
+    fTmp[2] = ( float )( ( m11 - e ) * ( m22 - e ) - m12 * m12 );
+
+    Vec vTmp = LoadFloat3( (const Float3*)fTmp );
+
+    if( Vector3Equal( vTmp, VectorZero() ) ) // planar or linear
+    {
+        // we only have one equation - find a valid one
+        if( ( m11 - e != 0.0 ) || ( m12 != 0.0 ) || ( m13 != 0.0 ) )
+        {
+            f1 = m11 - e; f2 = m12; f3 = m13;
+        }
+        else if( ( m12 != 0.0 ) || ( m22 - e != 0.0 ) || ( m23 != 0.0 ) )
+        {
+            f1 = m12; f2 = m22 - e; f3 = m23;
+        }
+        else if( ( m13 != 0.0 ) || ( m23 != 0.0 ) || ( m33 - e != 0.0 ) )
+        {
+            f1 = m13; f2 = m23; f3 = m33 - e;
+        }
+        else
+        {
+            // error, we'll just make something up - we have NO context
+            f1 = 1.0; f2 = 0.0; f3 = 0.0;
+        }
+
+        if( f1 == 0.0 )
+            vTmp = VectorSetX( vTmp, 0.0f );
+        else
+            vTmp = VectorSetX( vTmp, 1.0f );
+
+        if( f2 == 0.0 )
+            vTmp = VectorSetY( vTmp, 0.0f );
+        else
+            vTmp = VectorSetY( vTmp, 1.0f );
+
+        if( f3 == 0.0 )
+        {
+            vTmp = VectorSetZ( vTmp, 0.0f );
+            // recalculate y to make equation work
+            if( m12 != 0.0 )
+                vTmp = VectorSetY( vTmp, ( float )( -f1 / f2 ) );
+        }
+        else
+        {
+            vTmp = VectorSetZ( vTmp, ( float )( ( f2 - f1 ) / f3 ) );
+        }
+    }
+
+    if( VectorGetX( Vector3LengthSq( vTmp ) ) > 1e-5f )
+    {
+        return Vector3Normalize( vTmp );
+    }
+    else
+    {
+        // Multiply by a value large enough to make the vector non-zero.
+        vTmp *= 1e5f;
+        return Vector3Normalize( vTmp );
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool CalculateEigenVectors( float m11, float m12, float m13,
+                                       float m22, float m23, float m33,
+                                       float e1, float e2, float e3,
+                                       Vec* pV1, Vec* pV2, Vec* pV3 )
+{
+    Vec vTmp, vUp, vRight;
+
+    bool v1z, v2z, v3z, e12, e13, e23;
+
+    vUp = VectorSetBinaryConstant( 0, 1, 0, 0 );
+    vRight = VectorSetBinaryConstant( 1, 0, 0, 0 );
+
+    *pV1 = CalculateEigenVector( m11, m12, m13, m22, m23, m33, e1 );
+    *pV2 = CalculateEigenVector( m11, m12, m13, m22, m23, m33, e2 );
+    *pV3 = CalculateEigenVector( m11, m12, m13, m22, m23, m33, e3 );
+
+    v1z = v2z = v3z = false;
+
+    Vec Zero = VectorZero();
+
+    if ( Vector3Equal( *pV1, Zero ) )
+        v1z = true;
+
+    if ( Vector3Equal( *pV2, Zero ) )
+        v2z = true;
+
+    if ( Vector3Equal( *pV3, Zero ))
+        v3z = true;
+
+    e12 = ( fabsf( VectorGetX( Vector3Dot( *pV1, *pV2 ) ) ) > 0.1f ); // check for non-orthogonal vectors
+    e13 = ( fabsf( VectorGetX( Vector3Dot( *pV1, *pV3 ) ) ) > 0.1f );
+    e23 = ( fabsf( VectorGetX( Vector3Dot( *pV2, *pV3 ) ) ) > 0.1f );
+
+    if( ( v1z && v2z && v3z ) || ( e12 && e13 && e23 ) ||
+        ( e12 && v3z ) || ( e13 && v2z ) || ( e23 && v1z ) ) // all eigenvectors are 0- any basis set
+    {
+        *pV1 = VectorSetBinaryConstant( 1, 0, 0, 0 );
+        *pV2 = VectorSetBinaryConstant( 0, 1, 0, 0 );
+        *pV3 = VectorSetBinaryConstant( 0, 0, 1, 0 );
+        return true;
+    }
+
+    if( v1z && v2z )
+    {
+        vTmp = Vector3Cross( vUp, *pV3 );
+        if( VectorGetX( Vector3LengthSq( vTmp ) ) < 1e-5f )
+        {
+            vTmp = Vector3Cross( vRight, *pV3 );
+        }
+        *pV1 = Vector3Normalize( vTmp );
+        *pV2 = Vector3Cross( *pV3, *pV1 );
+        return true;
+    }
+
+    if( v3z && v1z )
+    {
+        vTmp = Vector3Cross( vUp, *pV2 );
+        if( VectorGetX( Vector3LengthSq( vTmp ) ) < 1e-5f )
+        {
+            vTmp = Vector3Cross( vRight, *pV2 );
+        }
+        *pV3 = Vector3Normalize( vTmp );
+        *pV1 = Vector3Cross( *pV2, *pV3 );
+        return true;
+    }
+
+    if( v2z && v3z )
+    {
+        vTmp = Vector3Cross( vUp, *pV1 );
+        if( VectorGetX( Vector3LengthSq( vTmp ) ) < 1e-5f )
+        {
+            vTmp = Vector3Cross( vRight, *pV1 );
+        }
+        *pV2 = Vector3Normalize( vTmp );
+        *pV3 = Vector3Cross( *pV1, *pV2 );
+        return true;
+    }
+
+    if( ( v1z ) || e12 )
+    {
+        *pV1 = Vector3Cross( *pV2, *pV3 );
+        return true;
+    }
+
+    if( ( v2z ) || e23 )
+    {
+        *pV2 = Vector3Cross( *pV3, *pV1 );
+        return true;
+    }
+
+    if( ( v3z ) || e13 )
+    {
+        *pV3 = Vector3Cross( *pV1, *pV2 );
+        return true;
+    }
+
+    return true;
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool CalculateEigenVectorsFromCovarianceMatrix( float Cxx, float Cyy, float Czz,
+                                                           float Cxy, float Cxz, float Cyz,
+                                                           Vec* pV1, Vec* pV2, Vec* pV3 )
+{
+    float e, f, g, ev1, ev2, ev3;
+
+    // Calculate the eigenvalues by solving a cubic equation.
+    e = -( Cxx + Cyy + Czz );
+    f = Cxx * Cyy + Cyy * Czz + Czz * Cxx - Cxy * Cxy - Cxz * Cxz - Cyz * Cyz;
+    g = Cxy * Cxy * Czz + Cxz * Cxz * Cyy + Cyz * Cyz * Cxx - Cxy * Cyz * Cxz * 2.0f - Cxx * Cyy * Czz;
+
+    if( !SolveCubic( e, f, g, &ev1, &ev2, &ev3 ) )
+    {
+        // set them to arbitrary orthonormal basis set
+        *pV1 = VectorSetBinaryConstant( 1, 0, 0, 0 );
+        *pV2 = VectorSetBinaryConstant( 0, 1, 0, 0 );
+        *pV3 = VectorSetBinaryConstant( 0, 0, 1, 0 );
+        return false;
+    }
+
+    return CalculateEigenVectors( Cxx, Cxy, Cxz, Cyy, Cyz, Czz, ev1, ev2, ev3, pV1, pV2, pV3 );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Find the approximate minimum oriented bounding box containing a set of 
+// points.  Exact computation of minimum oriented bounding box is possible but 
+// is slower and requires a more complex algorithm.
+// The algorithm works by computing the inertia tensor of the points and then
+// using the eigenvectors of the intertia tensor as the axes of the box.
+// Computing the intertia tensor of the convex hull of the points will usually 
+// result in better bounding box but the computation is more complex. 
+// Exact computation of the minimum oriented bounding box is possible but the
+// best know algorithm is O(N^3) and is significanly more complex to implement.
+//-----------------------------------------------------------------------------
+XNA_KERNEL void ComputeBoundingOrientedBoxFromPoints( OrientedBox* pOut, uint32 Count, const Float3* pPoints, uint32 Stride )
+{
+    static const PermuteControl PermuteXXY = XNA_PERMUTE_CONTROL( 0, 0, 1, 3 );
+    static const PermuteControl PermuteYZZ = XNA_PERMUTE_CONTROL( 1, 2, 2, 3 );
+
+    assert( pOut );
+    assert( Count > 0 );
+    assert( pPoints );
+
+    Vec CenterOfMass = VectorZero();
+
+    // Compute the center of mass and inertia tensor of the points.
+    for( uint32 i = 0; i < Count; i++ )
+    {
+        Vec Point = LoadFloat3( ( const Float3* )( ( const uint8* )pPoints + i * Stride ) );
+
+        CenterOfMass += Point;
+    }
+
+    CenterOfMass *= VectorReciprocal( VectorReplicate( float( Count ) ) );
+
+    // Compute the inertia tensor of the points around the center of mass.
+    // Using the center of mass is not strictly necessary, but will hopefully
+    // improve the stability of finding the eigenvectors.
+    Vec XX_YY_ZZ = VectorZero();
+    Vec XY_XZ_YZ = VectorZero();
+
+    for( uint32 i = 0; i < Count; i++ )
+    {
+        Vec Point = LoadFloat3( ( const Float3* )( ( const uint8* )pPoints + i * Stride ) ) - CenterOfMass;
+
+        XX_YY_ZZ += Point * Point;
+
+        Vec XXY = VectorPermute( Point, Point, PermuteXXY );
+        Vec YZZ = VectorPermute( Point, Point, PermuteYZZ );
+
+        XY_XZ_YZ += XXY * YZZ;
+    }
+
+    Vec v1, v2, v3;
+
+    // Compute the eigenvectors of the inertia tensor.
+    CalculateEigenVectorsFromCovarianceMatrix( VectorGetX( XX_YY_ZZ ), VectorGetY( XX_YY_ZZ ),
+                                               VectorGetZ( XX_YY_ZZ ),
+                                               VectorGetX( XY_XZ_YZ ), VectorGetY( XY_XZ_YZ ),
+                                               VectorGetZ( XY_XZ_YZ ),
+                                               &v1, &v2, &v3 );
+
+    // Put them in a matrix.
+    VMatrix R;
+
+    R.r[0] = VectorSetW( v1, 0.f );
+    R.r[1] = VectorSetW( v2, 0.f );
+    R.r[2] = VectorSetW( v3, 0.f );
+    R.r[3] = VectorSetBinaryConstant( 0, 0, 0, 1 );
+
+    // Multiply by -1 to convert the matrix into a right handed coordinate 
+    // system (Det ~= 1) in case the eigenvectors form a left handed 
+    // coordinate system (Det ~= -1) because QuaternionRotationMatrix only 
+    // works on right handed matrices.
+    Vec Det = MatrixDeterminant( R );
+
+    if( Vector4Less( Det, VectorZero() ) )
+    {
+        const Vec VectorNegativeOne = VectorSet( -1.0f, -1.0f, -1.0f, -1.0f );
+
+        R.r[0] *= VectorNegativeOne;
+        R.r[1] *= VectorNegativeOne;
+        R.r[2] *= VectorNegativeOne;
+    }
+
+    // Get the rotation quaternion from the matrix.
+    Vec Orientation = QuaternionRotationMatrix( R );
+
+    // Make sure it is normal (in case the vectors are slightly non-orthogonal).
+    Orientation = QuaternionNormalize( Orientation );
+
+    // Rebuild the rotation matrix from the quaternion.
+    R = MatrixRotationQuaternion( Orientation );
+
+    // Build the rotation into the rotated space.
+    VMatrix InverseR = MatrixTranspose( R );
+
+    // Find the minimum OBB using the eigenvectors as the axes.
+    Vec vMin, vMax;
+
+    vMin = vMax = Vector3TransformNormal( LoadFloat3( pPoints ), InverseR );
+
+    for( uint32 i = 1; i < Count; i++ )
+    {
+        Vec Point = Vector3TransformNormal( LoadFloat3( ( const Float3* )( ( const uint8* )pPoints + i * Stride ) ),
+                                            InverseR );
+
+        vMin = VectorMin( vMin, Point );
+        vMax = VectorMax( vMax, Point );
+    }
+
+    // Rotate the center into world space.
+    Vec Center = ( vMin + vMax ) * 0.5f;
+    Center = Vector3TransformNormal( Center, R );
+
+    // Store center, extents, and orientation.
+    StoreFloat3( &pOut->Center, Center );
+    StoreFloat3( &pOut->Extents, ( vMax - vMin ) * 0.5f );
+    StoreFloat4( &pOut->Orientation, Orientation );
+
+    return;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Build a frustum from a persepective projection matrix.  The matrix may only
+// contain a projection; any rotation, translation or scale will cause the
+// constructed frustum to be incorrect.
+//-----------------------------------------------------------------------------
+XNA_KERNEL void ComputeFrustumFromProjection( Frustum* pOut, VMatrix* pProjection )
+{
+    assert( pOut );
+    assert( pProjection );
+
+    // Corners of the projection frustum in homogenous space.
+    const Vec HomogenousPoints[6] =
+    {
+        VectorSet(  1.0f,  0.0f, 1.0f, 1.0f ),   // right (at far plane)
+        VectorSet( -1.0f,  0.0f, 1.0f, 1.0f ),   // left
+        VectorSet(  0.0f,  1.0f, 1.0f, 1.0f ),   // top
+        VectorSet(  0.0f, -1.0f, 1.0f, 1.0f ),   // bottom
+
+        VectorSet( 0.0f, 0.0f, 0.0f, 1.0f ),     // near
+        VectorSet( 0.0f, 0.0f, 1.0f, 1.0f )      // far
+    };
+
+    Vec Determinant;
+    VMatrix matInverse = MatrixInverse( &Determinant, *pProjection );
+
+    // Compute the frustum corners in world space.
+    Vec Points[6];
+
+    for( int i = 0; i < 6; i++ )
+    {
+        // Transform point.
+        Points[i] = Vector4Transform( HomogenousPoints[i], matInverse );
+    }
+
+    pOut->Origin = MakeFloat3( 0.0f, 0.0f, 0.0f );
+    pOut->Orientation = MakeFloat4( 0.0f, 0.0f, 0.0f, 1.0f );
+
+    // Compute the slopes.
+    Points[0] = Points[0] * VectorReciprocal( VectorSplatZ( Points[0] ) );
+    Points[1] = Points[1] * VectorReciprocal( VectorSplatZ( Points[1] ) );
+    Points[2] = Points[2] * VectorReciprocal( VectorSplatZ( Points[2] ) );
+    Points[3] = Points[3] * VectorReciprocal( VectorSplatZ( Points[3] ) );
+
+    pOut->RightSlope = VectorGetX( Points[0] );
+    pOut->LeftSlope = VectorGetX( Points[1] );
+    pOut->TopSlope = VectorGetY( Points[2] );
+    pOut->BottomSlope = VectorGetY( Points[3] );
+
+    // Compute near and far.
+    Points[4] = Points[4] * VectorReciprocal( VectorSplatW( Points[4] ) );
+    Points[5] = Points[5] * VectorReciprocal( VectorSplatW( Points[5] ) );
+
+    pOut->Near = VectorGetZ( Points[4] );
+    pOut->Far = VectorGetZ( Points[5] );
+
+    return;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Build the 6 frustum planes from a frustum.
+//-----------------------------------------------------------------------------
+XNA_KERNEL void ComputePlanesFromFrustum( const Frustum* pVolume, Vec* pPlane0, Vec* pPlane1, Vec* pPlane2,
+                                          Vec* pPlane3, Vec* pPlane4, Vec* pPlane5 )
+{
+    assert( pVolume );
+    assert( pPlane0 );
+    assert( pPlane1 );
+    assert( pPlane2 );
+    assert( pPlane3 );
+    assert( pPlane4 );
+    assert( pPlane5 );
+
+    // Load origin and orientation of the frustum.
+    Vec Origin = LoadFloat3( &pVolume->Origin );
+    Vec Orientation = LoadFloat4( &pVolume->Orientation );
+
+    // Build the frustum planes.
+    Vec Plane0 = VectorSet( 0.0f, 0.0f, -1.0f, pVolume->Near );
+    Vec Plane1 = VectorSet( 0.0f, 0.0f, 1.0f, -pVolume->Far );
+    Vec Plane2 = VectorSet( 1.0f, 0.0f, -pVolume->RightSlope, 0.0f );
+    Vec Plane3 = VectorSet( -1.0f, 0.0f, pVolume->LeftSlope, 0.0f );
+    Vec Plane4 = VectorSet( 0.0f, 1.0f, -pVolume->TopSlope, 0.0f );
+    Vec Plane5 = VectorSet( 0.0f, -1.0f, pVolume->BottomSlope, 0.0f );
+
+    Plane0 = TransformPlane( Plane0, Orientation, Origin );
+    Plane1 = TransformPlane( Plane1, Orientation, Origin );
+    Plane2 = TransformPlane( Plane2, Orientation, Origin );
+    Plane3 = TransformPlane( Plane3, Orientation, Origin );
+    Plane4 = TransformPlane( Plane4, Orientation, Origin );
+    Plane5 = TransformPlane( Plane5, Orientation, Origin );
+
+    *pPlane0 = PlaneNormalize( Plane0 );
+    *pPlane1 = PlaneNormalize( Plane1 );
+    *pPlane2 = PlaneNormalize( Plane2 );
+    *pPlane3 = PlaneNormalize( Plane3 );
+    *pPlane4 = PlaneNormalize( Plane4 );
+    *pPlane5 = PlaneNormalize( Plane5 );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Transform a sphere by an angle preserving transform.
+XNA_KERNEL bool IntersectPointSphere( CVec Point, const Sphere* pVolume )
+{
+    assert( pVolume );
+
+    Vec Center = LoadFloat3( &pVolume->Center );
+    Vec Radius = VectorReplicatePtr( &pVolume->Radius );
+
+    Vec DistanceSquared = Vector3LengthSq( Point - Center );
+    Vec RadiusSquared = Radius * Radius;
+
+    return Vector4LessOrEqual( DistanceSquared, RadiusSquared );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Point in axis aligned box test.
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectPointAxisAlignedBox( CVec Point, const AxisAlignedBox* pVolume )
+{
+    assert( pVolume );
+
+    Vec Center = LoadFloat3( &pVolume->Center );
+    Vec Extents = LoadFloat3( &pVolume->Extents );
+
+    return Vector3InBounds( Point - Center, Extents );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Point in oriented box test.
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectPointOrientedBox( CVec Point, const OrientedBox* pVolume )
+{
+    assert( pVolume );
+
+    Vec Center = LoadFloat3( &pVolume->Center );
+    Vec Extents = LoadFloat3( &pVolume->Extents );
+    Vec Orientation = LoadFloat4( &pVolume->Orientation );
+
+    assert( QuaternionIsUnit( Orientation ) );
+
+    // Transform the point to be local to the box.
+    Vec TPoint = Vector3InverseRotate( Point - Center, Orientation );
+
+    return Vector3InBounds( TPoint, Extents );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Point in frustum test.
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectPointFrustum( CVec Point, const Frustum* pVolume )
+{
+    const Vec SelectW = VectorSetInt( 0, 0, 0, 0xFFFFFFFF );
+    const Vec SelectZ = VectorSetInt( 0, 0, 0xFFFFFFFF, 0 );
+
+    const Vec BasePlanes[6] =
+    {
+        VectorSet(  0.0f,  0.0f, -1.0f, 0.0f ),
+        VectorSet(  0.0f,  0.0f,  1.0f, 0.0f ),
+        VectorSet(  1.0f,  0.0f,  0.0f, 0.0f ),
+        VectorSet( -1.0f,  0.0f,  0.0f, 0.0f ),
+        VectorSet(  0.0f,  1.0f,  0.0f, 0.0f ),
+        VectorSet(  0.0f, -1.0f,  0.0f, 0.0f )
+    };
+
+    assert( pVolume );
+
+    // Build frustum planes.
+    Vec Planes[6];
+    Planes[0] = VectorSelect( BasePlanes[0], VectorSplatX(  LoadFloat( &pVolume->Near ) ),
+                              SelectW );
+    Planes[1] = VectorSelect( BasePlanes[1], VectorSplatX( -LoadFloat( &pVolume->Far ) ),
+                              SelectW );
+    Planes[2] = VectorSelect( BasePlanes[2], VectorSplatX( -LoadFloat( &pVolume->RightSlope ) ),
+                              SelectZ );
+    Planes[3] = VectorSelect( BasePlanes[3], VectorSplatX(  LoadFloat( &pVolume->LeftSlope ) ),
+                              SelectZ );
+    Planes[4] = VectorSelect( BasePlanes[4], VectorSplatX( -LoadFloat( &pVolume->TopSlope ) ),
+                              SelectZ );
+    Planes[5] = VectorSelect( BasePlanes[5], VectorSplatX(  LoadFloat( &pVolume->BottomSlope ) ),
+                              SelectZ );
+
+    // Load origin and orientation.
+    Vec Origin = LoadFloat3( &pVolume->Origin );
+    Vec Orientation = LoadFloat4( &pVolume->Orientation );
+
+    assert( QuaternionIsUnit( Orientation ) );
+
+    // Transform point into local space of frustum.
+    Vec TPoint = Vector3InverseRotate( Point - Origin, Orientation );
+
+    // Set w to one.
+    TPoint = VectorInsert( TPoint, VectorSplatOne(), 0, 0, 0, 0, 1);
+
+    Vec Zero = VectorZero();
+    Vec Outside = Zero;
+
+    // Test point against each plane of the frustum.
+    for( int i = 0; i < 6; i++ )
+    {
+        Vec Dot = Vector4Dot( TPoint, Planes[i] );
+        Outside = VectorOrInt( Outside, VectorGreater( Dot, Zero ) );
+    }
+
+    return Vector4NotEqualInt( Outside, VectorTrueInt() );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Compute the intersection of a ray (Origin, Direction) with a triangle 
+// (V0, V1, V2).  Return true if there is an intersection and also set *pDist 
+// to the distance along the ray to the intersection.
+// 
+// The algorithm is based on Moller, Tomas and Trumbore, "Fast, Minimum Storage 
+// Ray-Triangle Intersection", Journal of Graphics Tools, vol. 2, no. 1, 
+// pp 21-28, 1997.
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectRayTriangle( CVec Origin, CVec Direction, CVec V0, CVec V1, CVec V2,
+                                      float* pDist )
+{
+    assert( pDist );
+    assert( Vector3IsUnit( Direction ) );
+
+    const Vec Epsilon = VectorSet( 1e-20f, 1e-20f, 1e-20f, 1e-20f );
+
+    Vec Zero = VectorZero();
+
+    Vec e1 = V1 - V0;
+    Vec e2 = V2 - V0;
+
+    // p = Direction ^ e2;
+    Vec p = Vector3Cross( Direction, e2 );
+
+    // det = e1 * p;
+    Vec det = Vector3Dot( e1, p );
+
+    Vec u, v, t;
+
+    if( Vector3GreaterOrEqual( det, Epsilon ) )
+    {
+        // Determinate is positive (front side of the triangle).
+        Vec s = Origin - V0;
+
+        // u = s * p;
+        u = Vector3Dot( s, p );
+
+        Vec NoIntersection = VectorLess( u, Zero );
+        NoIntersection = VectorOrInt( NoIntersection, VectorGreater( u, det ) );
+
+        // q = s ^ e1;
+        Vec q = Vector3Cross( s, e1 );
+
+        // v = Direction * q;
+        v = Vector3Dot( Direction, q );
+
+        NoIntersection = VectorOrInt( NoIntersection, VectorLess( v, Zero ) );
+        NoIntersection = VectorOrInt( NoIntersection, VectorGreater( u + v, det ) );
+
+        // t = e2 * q;
+        t = Vector3Dot( e2, q );
+
+        NoIntersection = VectorOrInt( NoIntersection, VectorLess( t, Zero ) );
+
+        if( Vector4EqualInt( NoIntersection, VectorTrueInt() ) )
+            return false;
+    }
+    else if( Vector3LessOrEqual( det, -Epsilon ) )
+    {
+        // Determinate is negative (back side of the triangle).
+        Vec s = Origin - V0;
+
+        // u = s * p;
+        u = Vector3Dot( s, p );
+
+        Vec NoIntersection = VectorGreater( u, Zero );
+        NoIntersection = VectorOrInt( NoIntersection, VectorLess( u, det ) );
+
+        // q = s ^ e1;
+        Vec q = Vector3Cross( s, e1 );
+
+        // v = Direction * q;
+        v = Vector3Dot( Direction, q );
+
+        NoIntersection = VectorOrInt( NoIntersection, VectorGreater( v, Zero ) );
+        NoIntersection = VectorOrInt( NoIntersection, VectorLess( u + v, det ) );
+
+        // t = e2 * q;
+        t = Vector3Dot( e2, q );
+
+        NoIntersection = VectorOrInt( NoIntersection, VectorGreater( t, Zero ) );
+
+        if ( Vector4EqualInt( NoIntersection, VectorTrueInt() ) )
+            return false;
+    }
+    else
+    {
+        // Parallel ray.
+        return false;
+    }
+
+    Vec inv_det = VectorReciprocal( det );
+
+    t *= inv_det;
+
+    // u * inv_det and v * inv_det are the barycentric cooridinates of the intersection.
+
+    // Store the x-component to *pDist
+    StoreFloat( pDist, t );
+
+    return true;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Compute the intersection of a ray (Origin, Direction) with a sphere.
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectRaySphere( CVec Origin, CVec Direction, const Sphere* pVolume, float* pDist )
+{
+    assert( pVolume );
+    assert( pDist );
+    assert( Vector3IsUnit( Direction ) );
+
+    Vec Center = LoadFloat3( &pVolume->Center );
+    Vec Radius = VectorReplicatePtr( &pVolume->Radius );
+
+    // l is the vector from the ray origin to the center of the sphere.
+    Vec l = Center - Origin;
+
+    // s is the projection of the l onto the ray direction.
+    Vec s = Vector3Dot( l, Direction );
+
+    Vec l2 = Vector3Dot( l, l );
+
+    Vec r2 = Radius * Radius;
+
+    // m2 is squared distance from the center of the sphere to the projection.
+    Vec m2 = l2 - s * s;
+
+    Vec NoIntersection;
+
+    // If the ray origin is outside the sphere and the center of the sphere is 
+    // behind the ray origin there is no intersection.
+    NoIntersection = VectorAndInt( VectorLess( s, VectorZero() ), VectorGreater( l2, r2 ) );
+
+    // If the squared distance from the center of the sphere to the projection
+    // is greater than the radius squared the ray will miss the sphere.
+    NoIntersection = VectorOrInt( NoIntersection, VectorGreater( m2, r2 ) );
+
+    // The ray hits the sphere, compute the nearest intersection point.
+    Vec q = VectorSqrt( r2 - m2 );
+    Vec t1 = s - q;
+    Vec t2 = s + q;
+
+    Vec OriginInside = VectorLessOrEqual( l2, r2 );
+    Vec t = VectorSelect( t1, t2, OriginInside );
+
+    if( Vector4NotEqualInt( NoIntersection, VectorTrueInt() ) )
+    {
+        // Store the x-component to *pDist.
+        StoreFloat( pDist, t );
+        return true;
+    }
+
+    return false;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Compute the intersection of a ray (Origin, Direction) with an axis aligned 
+// box using the slabs method.
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectRayAxisAlignedBox( CVec Origin, CVec Direction, const AxisAlignedBox* pVolume, float* pDist )
+{
+    assert( pVolume );
+    assert( pDist );
+    assert( Vector3IsUnit( Direction ) );
+
+    const Vec Epsilon = VectorSet( 1e-20f, 1e-20f, 1e-20f, 1e-20f );
+    const Vec FltMin = VectorSet( -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX );
+    const Vec FltMax = VectorSet( FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX );
+
+    // Load the box.
+    Vec Center = LoadFloat3( &pVolume->Center );
+    Vec Extents = LoadFloat3( &pVolume->Extents );
+
+    // Adjust ray origin to be relative to center of the box.
+    Vec TOrigin = Center - Origin;
+
+    // Compute the dot product againt each axis of the box.
+    // Since the axii are (1,0,0), (0,1,0), (0,0,1) no computation is necessary.
+    Vec AxisDotOrigin = TOrigin;
+    Vec AxisDotDirection = Direction;
+
+    // if (fabs(AxisDotDirection) <= Epsilon) the ray is nearly parallel to the slab.
+    Vec IsParallel = VectorLessOrEqual( VectorAbs( AxisDotDirection ), Epsilon );
+
+    // Test against all three axii simultaneously.
+    Vec InverseAxisDotDirection = VectorReciprocal( AxisDotDirection );
+    Vec t1 = ( AxisDotOrigin - Extents ) * InverseAxisDotDirection;
+    Vec t2 = ( AxisDotOrigin + Extents ) * InverseAxisDotDirection;
+
+    // Compute the max of min(t1,t2) and the min of max(t1,t2) ensuring we don't
+    // use the results from any directions parallel to the slab.
+    Vec t_min = VectorSelect( VectorMin( t1, t2 ), FltMin, IsParallel );
+    Vec t_max = VectorSelect( VectorMax( t1, t2 ), FltMax, IsParallel );
+
+    // t_min.x = maximum( t_min.x, t_min.y, t_min.z );
+    // t_max.x = minimum( t_max.x, t_max.y, t_max.z );
+    t_min = VectorMax( t_min, VectorSplatY( t_min ) );  // x = max(x,y)
+    t_min = VectorMax( t_min, VectorSplatZ( t_min ) );  // x = max(max(x,y),z)
+    t_max = VectorMin( t_max, VectorSplatY( t_max ) );  // x = min(x,y)
+    t_max = VectorMin( t_max, VectorSplatZ( t_max ) );  // x = min(min(x,y),z)
+
+    // if ( t_min > t_max ) return false;
+    Vec NoIntersection = VectorGreater( VectorSplatX( t_min ), VectorSplatX( t_max ) );
+
+    // if ( t_max < 0.0f ) return false;
+    NoIntersection = VectorOrInt( NoIntersection, VectorLess( VectorSplatX( t_max ), VectorZero() ) );
+
+    // if (IsParallel && (-Extents > AxisDotOrigin || Extents < AxisDotOrigin)) return false;
+    Vec ParallelOverlap = VectorInBounds( AxisDotOrigin, Extents );
+    NoIntersection = VectorOrInt( NoIntersection, VectorAndCInt( IsParallel, ParallelOverlap ) );
+
+    if( !Vector3AnyTrue( NoIntersection ) )
+    {
+        // Store the x-component to *pDist
+        StoreFloat( pDist, t_min );
+        return true;
+    }
+
+    return false;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Compute the intersection of a ray (Origin, Direction) with an oriented box
+// using the slabs method.
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectRayOrientedBox( CVec Origin, CVec Direction, const OrientedBox* pVolume, float* pDist )
+{
+    assert( pVolume );
+    assert( pDist );
+    assert( Vector3IsUnit( Direction ) );
+
+    const Vec Epsilon = VectorSet( 1e-20f, 1e-20f, 1e-20f, 1e-20f );
+    const Vec FltMin = VectorSet( -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX );
+    const Vec FltMax = VectorSet( FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX );
+    const Vec SelectY = VectorSetInt( 0, 0xFFFFFFFF, 0, 0 );
+    const Vec SelectZ = VectorSetInt( 0, 0, 0xFFFFFFFF, 0 );
+
+    // Load the box.
+    Vec Center = LoadFloat3( &pVolume->Center );
+    Vec Extents = LoadFloat3( &pVolume->Extents );
+    Vec Orientation = LoadFloat4( &pVolume->Orientation );
+
+    assert( QuaternionIsUnit( Orientation ) );
+
+    // Get the boxes normalized side directions.
+    VMatrix R = MatrixRotationQuaternion( Orientation );
+
+    // Adjust ray origin to be relative to center of the box.
+    Vec TOrigin = Center - Origin;
+
+    // Compute the dot product againt each axis of the box.
+    Vec AxisDotOrigin = Vector3Dot( R.r[0], TOrigin );
+    AxisDotOrigin = VectorSelect( AxisDotOrigin, Vector3Dot( R.r[1], TOrigin ), SelectY );
+    AxisDotOrigin = VectorSelect( AxisDotOrigin, Vector3Dot( R.r[2], TOrigin ), SelectZ );
+
+    Vec AxisDotDirection = Vector3Dot( R.r[0], Direction );
+    AxisDotDirection = VectorSelect( AxisDotDirection, Vector3Dot( R.r[1], Direction ), SelectY );
+    AxisDotDirection = VectorSelect( AxisDotDirection, Vector3Dot( R.r[2], Direction ), SelectZ );
+
+    // if (fabs(AxisDotDirection) <= Epsilon) the ray is nearly parallel to the slab.
+    Vec IsParallel = VectorLessOrEqual( VectorAbs( AxisDotDirection ), Epsilon );
+
+    // Test against all three axes simultaneously.
+    Vec InverseAxisDotDirection = VectorReciprocal( AxisDotDirection );
+    Vec t1 = ( AxisDotOrigin - Extents ) * InverseAxisDotDirection;
+    Vec t2 = ( AxisDotOrigin + Extents ) * InverseAxisDotDirection;
+
+    // Compute the max of min(t1,t2) and the min of max(t1,t2) ensuring we don't
+    // use the results from any directions parallel to the slab.
+    Vec t_min = VectorSelect( VectorMin( t1, t2 ), FltMin, IsParallel );
+    Vec t_max = VectorSelect( VectorMax( t1, t2 ), FltMax, IsParallel );
+
+    // t_min.x = maximum( t_min.x, t_min.y, t_min.z );
+    // t_max.x = minimum( t_max.x, t_max.y, t_max.z );
+    t_min = VectorMax( t_min, VectorSplatY( t_min ) );  // x = max(x,y)
+    t_min = VectorMax( t_min, VectorSplatZ( t_min ) );  // x = max(max(x,y),z)
+    t_max = VectorMin( t_max, VectorSplatY( t_max ) );  // x = min(x,y)
+    t_max = VectorMin( t_max, VectorSplatZ( t_max ) );  // x = min(min(x,y),z)
+
+    // if ( t_min > t_max ) return false;
+    Vec NoIntersection = VectorGreater( VectorSplatX( t_min ), VectorSplatX( t_max ) );
+
+    // if ( t_max < 0.0f ) return false;
+    NoIntersection = VectorOrInt( NoIntersection, VectorLess( VectorSplatX( t_max ), VectorZero() ) );
+
+    // if (IsParallel && (-Extents > AxisDotOrigin || Extents < AxisDotOrigin)) return false;
+    Vec ParallelOverlap = VectorInBounds( AxisDotOrigin, Extents );
+    NoIntersection = VectorOrInt( NoIntersection, VectorAndCInt( IsParallel, ParallelOverlap ) );
+
+    if( !Vector3AnyTrue( NoIntersection ) )
+    {
+        // Store the x-component to *pDist
+        StoreFloat( pDist, t_min );
+        return true;
+    }
+
+    return false;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Test if two triangles intersect.
+//
+// The final test of algorithm is based on Shen, Heng, and Tang, "A Fast 
+// Triangle-Triangle Overlap Test Using Signed Distances", Journal of Graphics 
+// Tools, vol. 8, no. 1, pp 17-23, 2003 and Guigue and Devillers, "Fast and 
+// Robust Triangle-Triangle Overlap Test Using Orientation Predicates", Journal 
+// of Graphics Tools, vol. 8, no. 1, pp 25-32, 2003.
+//
+// The final test could be considered an edge-edge separating plane test with
+// the 9 possible cases narrowed down to the only two pairs of edges that can 
+// actaully result in a seperation.
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectTriangleTriangle( CVec A0, CVec A1, CVec A2, CVec B0, CVec B1, CVec B2 )
+{
+    const Vec Epsilon = VectorSet( 1e-20f, 1e-20f, 1e-20f, 1e-20f );
+    const Vec SelectY = VectorSetInt( 0, 0xFFFFFFFF, 0, 0 );
+    const Vec SelectZ = VectorSetInt( 0, 0, 0xFFFFFFFF, 0 );
+    const Vec Select0111 = VectorSetInt( 0, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF );
+    const Vec Select1011 = VectorSetInt( 0xFFFFFFFF, 0, 0xFFFFFFFF, 0xFFFFFFFF );
+    const Vec Select1101 = VectorSetInt( 0xFFFFFFFF, 0xFFFFFFFF, 0, 0xFFFFFFFF );
+
+    Vec Zero = VectorZero();
+
+    // Compute the normal of triangle A.
+    Vec N1 = Vector3Cross( A1 - A0, A2 - A0 );
+
+    // Assert that the triangle is not degenerate.
+    assert( !Vector3Equal( N1, Zero ) );
+
+    // Test points of B against the plane of A.
+    Vec BDist = Vector3Dot( N1, B0 - A0 );
+    BDist = VectorSelect( BDist, Vector3Dot( N1, B1 - A0 ), SelectY );
+    BDist = VectorSelect( BDist, Vector3Dot( N1, B2 - A0 ), SelectZ );
+
+    // Ensure robustness with co-planar triangles by zeroing small distances.
+    uint32 BDistIsZeroCR;
+    Vec BDistIsZero = VectorGreaterR( &BDistIsZeroCR, Epsilon, VectorAbs( BDist ) );
+    BDist = VectorSelect( BDist, Zero, BDistIsZero );
+
+    uint32 BDistIsLessCR;
+    Vec BDistIsLess = VectorGreaterR( &BDistIsLessCR, Zero, BDist );
+
+    uint32 BDistIsGreaterCR;
+    Vec BDistIsGreater = VectorGreaterR( &BDistIsGreaterCR, BDist, Zero );
+
+    // If all the points are on the same side we don't intersect.
+    if( ComparisonAllTrue( BDistIsLessCR ) || ComparisonAllTrue( BDistIsGreaterCR ) )
+        return false;
+
+    // Compute the normal of triangle B.
+    Vec N2 = Vector3Cross( B1 - B0, B2 - B0 );
+
+    // Assert that the triangle is not degenerate.
+    assert( !Vector3Equal( N2, Zero ) );
+
+    // Test points of A against the plane of B.
+    Vec ADist = Vector3Dot( N2, A0 - B0 );
+    ADist = VectorSelect( ADist, Vector3Dot( N2, A1 - B0 ), SelectY );
+    ADist = VectorSelect( ADist, Vector3Dot( N2, A2 - B0 ), SelectZ );
+
+    // Ensure robustness with co-planar triangles by zeroing small distances.
+    uint32 ADistIsZeroCR;
+    Vec ADistIsZero = VectorGreaterR( &ADistIsZeroCR, Epsilon, VectorAbs( BDist ) );
+    ADist = VectorSelect( ADist, Zero, ADistIsZero );
+
+    uint32 ADistIsLessCR;
+    Vec ADistIsLess = VectorGreaterR( &ADistIsLessCR, Zero, ADist );
+
+    uint32 ADistIsGreaterCR;
+    Vec ADistIsGreater = VectorGreaterR( &ADistIsGreaterCR, ADist, Zero );
+
+    // If all the points are on the same side we don't intersect.
+    if( ComparisonAllTrue( ADistIsLessCR ) || ComparisonAllTrue( ADistIsGreaterCR ) )
+        return false;
+
+    // Special case for co-planar triangles.
+    if( ComparisonAllTrue( ADistIsZeroCR ) || ComparisonAllTrue( BDistIsZeroCR ) )
+    {
+        Vec Axis, Dist, MinDist;
+
+        // Compute an axis perpindicular to the edge (points out).
+        Axis = Vector3Cross( N1, A1 - A0 );
+        Dist = Vector3Dot( Axis, A0 );
+
+        // Test points of B against the axis.
+        MinDist = Vector3Dot( B0, Axis );
+        MinDist = VectorMin( MinDist, Vector3Dot( B1, Axis ) );
+        MinDist = VectorMin( MinDist, Vector3Dot( B2, Axis ) );
+        if( Vector4GreaterOrEqual( MinDist, Dist ) )
+            return false;
+
+        // Edge (A1, A2)
+        Axis = Vector3Cross( N1, A2 - A1 );
+        Dist = Vector3Dot( Axis, A1 );
+
+        MinDist = Vector3Dot( B0, Axis );
+        MinDist = VectorMin( MinDist, Vector3Dot( B1, Axis ) );
+        MinDist = VectorMin( MinDist, Vector3Dot( B2, Axis ) );
+        if( Vector4GreaterOrEqual( MinDist, Dist ) )
+            return false;
+
+        // Edge (A2, A0)
+        Axis = Vector3Cross( N1, A0 - A2 );
+        Dist = Vector3Dot( Axis, A2 );
+
+        MinDist = Vector3Dot( B0, Axis );
+        MinDist = VectorMin( MinDist, Vector3Dot( B1, Axis ) );
+        MinDist = VectorMin( MinDist, Vector3Dot( B2, Axis ) );
+        if( Vector4GreaterOrEqual( MinDist, Dist ) )
+            return false;
+
+        // Edge (B0, B1)
+        Axis = Vector3Cross( N2, B1 - B0 );
+        Dist = Vector3Dot( Axis, B0 );
+
+        MinDist = Vector3Dot( A0, Axis );
+        MinDist = VectorMin( MinDist, Vector3Dot( A1, Axis ) );
+        MinDist = VectorMin( MinDist, Vector3Dot( A2, Axis ) );
+        if( Vector4GreaterOrEqual( MinDist, Dist ) )
+            return false;
+
+        // Edge (B1, B2)
+        Axis = Vector3Cross( N2, B2 - B1 );
+        Dist = Vector3Dot( Axis, B1 );
+
+        MinDist = Vector3Dot( A0, Axis );
+        MinDist = VectorMin( MinDist, Vector3Dot( A1, Axis ) );
+        MinDist = VectorMin( MinDist, Vector3Dot( A2, Axis ) );
+        if( Vector4GreaterOrEqual( MinDist, Dist ) )
+            return false;
+
+        // Edge (B2,B0)
+        Axis = Vector3Cross( N2, B0 - B2 );
+        Dist = Vector3Dot( Axis, B2 );
+
+        MinDist = Vector3Dot( A0, Axis );
+        MinDist = VectorMin( MinDist, Vector3Dot( A1, Axis ) );
+        MinDist = VectorMin( MinDist, Vector3Dot( A2, Axis ) );
+        if( Vector4GreaterOrEqual( MinDist, Dist ) )
+            return false;
+
+        return true;
+    }
+
+    //
+    // Find the single vertex of A and B (ie the vertex on the opposite side
+    // of the plane from the other two) and reorder the edges so we can compute 
+    // the signed edge/edge distances.
+    //
+    // if ( (V0 >= 0 && V1 <  0 && V2 <  0) ||
+    //      (V0 >  0 && V1 <= 0 && V2 <= 0) ||
+    //      (V0 <= 0 && V1 >  0 && V2 >  0) ||
+    //      (V0 <  0 && V1 >= 0 && V2 >= 0) ) then V0 is singular;
+    //
+    // If our singular vertex is not on the positive side of the plane we reverse
+    // the triangle winding so that the overlap comparisons will compare the 
+    // correct edges with the correct signs.
+    //
+    Vec ADistIsLessEqual = VectorOrInt( ADistIsLess, ADistIsZero );
+    Vec ADistIsGreaterEqual = VectorOrInt( ADistIsGreater, ADistIsZero );
+
+    Vec AA0, AA1, AA2;
+    bool bPositiveA;
+
+    if( Vector3AllTrue( VectorSelect( ADistIsGreaterEqual, ADistIsLess, Select0111 ) ) ||
+        Vector3AllTrue( VectorSelect( ADistIsGreater, ADistIsLessEqual, Select0111 ) ) )
+    {
+        // A0 is singular, crossing from positive to negative.
+        AA0 = A0; AA1 = A1; AA2 = A2;
+        bPositiveA = true;
+    }
+    else if( Vector3AllTrue( VectorSelect( ADistIsLessEqual, ADistIsGreater, Select0111 ) ) ||
+             Vector3AllTrue( VectorSelect( ADistIsLess, ADistIsGreaterEqual, Select0111 ) ) )
+    {
+        // A0 is singular, crossing from negative to positive.
+        AA0 = A0; AA1 = A2; AA2 = A1;
+        bPositiveA = false;
+    }
+    else if( Vector3AllTrue( VectorSelect( ADistIsGreaterEqual, ADistIsLess, Select1011 ) ) ||
+             Vector3AllTrue( VectorSelect( ADistIsGreater, ADistIsLessEqual, Select1011 ) ) )
+    {
+        // A1 is singular, crossing from positive to negative.
+        AA0 = A1; AA1 = A2; AA2 = A0;
+        bPositiveA = true;
+    }
+    else if( Vector3AllTrue( VectorSelect( ADistIsLessEqual, ADistIsGreater, Select1011 ) ) ||
+             Vector3AllTrue( VectorSelect( ADistIsLess, ADistIsGreaterEqual, Select1011 ) ) )
+    {
+        // A1 is singular, crossing from negative to positive.
+        AA0 = A1; AA1 = A0; AA2 = A2;
+        bPositiveA = false;
+    }
+    else if( Vector3AllTrue( VectorSelect( ADistIsGreaterEqual, ADistIsLess, Select1101 ) ) ||
+             Vector3AllTrue( VectorSelect( ADistIsGreater, ADistIsLessEqual, Select1101 ) ) )
+    {
+        // A2 is singular, crossing from positive to negative.
+        AA0 = A2; AA1 = A0; AA2 = A1;
+        bPositiveA = true;
+    }
+    else if( Vector3AllTrue( VectorSelect( ADistIsLessEqual, ADistIsGreater, Select1101 ) ) ||
+             Vector3AllTrue( VectorSelect( ADistIsLess, ADistIsGreaterEqual, Select1101 ) ) )
+    {
+        // A2 is singular, crossing from negative to positive.
+        AA0 = A2; AA1 = A1; AA2 = A0;
+        bPositiveA = false;
+    }
+    else
+    {
+        assert( false );
+        return false;
+    }
+
+    Vec BDistIsLessEqual = VectorOrInt( BDistIsLess, BDistIsZero );
+    Vec BDistIsGreaterEqual = VectorOrInt( BDistIsGreater, BDistIsZero );
+
+    Vec BB0, BB1, BB2;
+    bool bPositiveB;
+
+    if( Vector3AllTrue( VectorSelect( BDistIsGreaterEqual, BDistIsLess, Select0111 ) ) ||
+        Vector3AllTrue( VectorSelect( BDistIsGreater, BDistIsLessEqual, Select0111 ) ) )
+    {
+        // B0 is singular, crossing from positive to negative.
+        BB0 = B0; BB1 = B1; BB2 = B2;
+        bPositiveB = true;
+    }
+    else if( Vector3AllTrue( VectorSelect( BDistIsLessEqual, BDistIsGreater, Select0111 ) ) ||
+             Vector3AllTrue( VectorSelect( BDistIsLess, BDistIsGreaterEqual, Select0111 ) ) )
+    {
+        // B0 is singular, crossing from negative to positive.
+        BB0 = B0; BB1 = B2; BB2 = B1;
+        bPositiveB = false;
+    }
+    else if( Vector3AllTrue( VectorSelect( BDistIsGreaterEqual, BDistIsLess, Select1011 ) ) ||
+             Vector3AllTrue( VectorSelect( BDistIsGreater, BDistIsLessEqual, Select1011 ) ) )
+    {
+        // B1 is singular, crossing from positive to negative.
+        BB0 = B1; BB1 = B2; BB2 = B0;
+        bPositiveB = true;
+    }
+    else if( Vector3AllTrue( VectorSelect( BDistIsLessEqual, BDistIsGreater, Select1011 ) ) ||
+             Vector3AllTrue( VectorSelect( BDistIsLess, BDistIsGreaterEqual, Select1011 ) ) )
+    {
+        // B1 is singular, crossing from negative to positive.
+        BB0 = B1; BB1 = B0; BB2 = B2;
+        bPositiveB = false;
+    }
+    else if( Vector3AllTrue( VectorSelect( BDistIsGreaterEqual, BDistIsLess, Select1101 ) ) ||
+             Vector3AllTrue( VectorSelect( BDistIsGreater, BDistIsLessEqual, Select1101 ) ) )
+    {
+        // B2 is singular, crossing from positive to negative.
+        BB0 = B2; BB1 = B0; BB2 = B1;
+        bPositiveB = true;
+    }
+    else if( Vector3AllTrue( VectorSelect( BDistIsLessEqual, BDistIsGreater, Select1101 ) ) ||
+             Vector3AllTrue( VectorSelect( BDistIsLess, BDistIsGreaterEqual, Select1101 ) ) )
+    {
+        // B2 is singular, crossing from negative to positive.
+        BB0 = B2; BB1 = B1; BB2 = B0;
+        bPositiveB = false;
+    }
+    else
+    {
+        assert( false );
+        return false;
+    }
+
+    Vec Delta0, Delta1;
+
+    // Reverse the direction of the test depending on whether the singular vertices are
+    // the same sign or different signs.
+    if( bPositiveA ^ bPositiveB )
+    {
+        Delta0 = ( BB0 - AA0 );
+        Delta1 = ( AA0 - BB0 );
+    }
+    else
+    {
+        Delta0 = ( AA0 - BB0 );
+        Delta1 = ( BB0 - AA0 );
+    }
+
+    // Check if the triangles overlap on the line of intersection between the
+    // planes of the two triangles by finding the signed line distances.
+    Vec Dist0 = Vector3Dot( Delta0, Vector3Cross( ( BB2 - BB0 ), ( AA2 - AA0 ) ) );
+    if( Vector4Greater( Dist0, Zero ) )
+        return false;
+
+    Vec Dist1 = Vector3Dot( Delta1, Vector3Cross( ( BB1 - BB0 ), ( AA1 - AA0 ) ) );
+    if( Vector4Greater( Dist1, Zero ) )
+        return false;
+
+    return true;
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectTriangleSphere( CVec V0, CVec V1, CVec V2, const Sphere* pVolume )
+{
+    assert( pVolume );
+
+    // Load the sphere.    
+    Vec Center = LoadFloat3( &pVolume->Center );
+    Vec Radius = VectorReplicatePtr( &pVolume->Radius );
+
+    // Compute the plane of the triangle (has to be normalized).
+    Vec N = Vector3Normalize( Vector3Cross( V1 - V0, V2 - V0 ) );
+
+    // Assert that the triangle is not degenerate.
+    assert( !Vector3Equal( N, VectorZero() ) );
+
+    // Find the nearest feature on the triangle to the sphere.
+    Vec Dist = Vector3Dot( Center - V0, N );
+
+    // If the center of the sphere is farther from the plane of the triangle than
+    // the radius of the sphere, then there cannot be an intersection.
+    Vec NoIntersection = VectorLess( Dist, -Radius );
+    NoIntersection = VectorOrInt( NoIntersection, VectorGreater( Dist, Radius ) );
+
+    // Project the center of the sphere onto the plane of the triangle.
+    Vec Point = Center - ( N * Dist );
+
+    // Is it inside all the edges? If so we intersect because the distance 
+    // to the plane is less than the radius.
+    Vec Intersection = PointOnPlaneInsideTriangle( Point, V0, V1, V2 );
+
+    // Find the nearest point on each edge.
+    Vec RadiusSq = Radius * Radius;
+
+    // Edge 0,1
+    Point = PointOnLineSegmentNearestPoint( V0, V1, Center );
+
+    // If the distance to the center of the sphere to the point is less than 
+    // the radius of the sphere then it must intersect.
+    Intersection = VectorOrInt( Intersection, VectorLessOrEqual( Vector3LengthSq( Center - Point ), RadiusSq ) );
+
+    // Edge 1,2
+    Point = PointOnLineSegmentNearestPoint( V1, V2, Center );
+
+    // If the distance to the center of the sphere to the point is less than 
+    // the radius of the sphere then it must intersect.
+    Intersection = VectorOrInt( Intersection, VectorLessOrEqual( Vector3LengthSq( Center - Point ), RadiusSq ) );
+
+    // Edge 2,0
+    Point = PointOnLineSegmentNearestPoint( V2, V0, Center );
+
+    // If the distance to the center of the sphere to the point is less than 
+    // the radius of the sphere then it must intersect.
+    Intersection = VectorOrInt( Intersection, VectorLessOrEqual( Vector3LengthSq( Center - Point ), RadiusSq ) );
+
+    return Vector4EqualInt( VectorAndCInt( Intersection, NoIntersection ), VectorTrueInt() );
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectTriangleAxisAlignedBox( CVec V0, CVec V1, CVec V2, const AxisAlignedBox* pVolume )
+{
+    assert( pVolume );
+
+    static const PermuteControl Permute0W1Z0Y0X = XNA_PERMUTE_CONTROL( 3, 6, 1, 0 );
+    static const PermuteControl Permute0Z0W1X0Y = XNA_PERMUTE_CONTROL( 2, 3, 4, 1 );
+    static const PermuteControl Permute1Y0X0W0Z = XNA_PERMUTE_CONTROL( 5, 0, 3, 2 );
+
+    Vec Zero = VectorZero();
+
+    // Load the box.
+    Vec Center = LoadFloat3( &pVolume->Center );
+    Vec Extents = LoadFloat3( &pVolume->Extents );
+
+    Vec BoxMin = Center - Extents;
+    Vec BoxMax = Center + Extents;
+
+    // Test the axes of the box (in effect test the AAB against the minimal AAB 
+    // around the triangle).
+    Vec TriMin = VectorMin( VectorMin( V0, V1 ), V2 );
+    Vec TriMax = VectorMax( VectorMax( V0, V1 ), V2 );
+
+    // for each i in (x, y, z) if a_min(i) > b_max(i) or b_min(i) > a_max(i) then disjoint
+    Vec Disjoint = VectorOrInt( VectorGreater( TriMin, BoxMax ), VectorGreater( BoxMin, TriMax ) );
+    if( Vector3AnyTrue( Disjoint ) )
+        return false;
+
+    // Test the plane of the triangle.
+    Vec Normal = Vector3Cross( V1 - V0, V2 - V0 );
+    Vec Dist = Vector3Dot( Normal, V0 );
+
+    // Assert that the triangle is not degenerate.
+    assert( !Vector3Equal( Normal, Zero ) );
+
+    // for each i in (x, y, z) if n(i) >= 0 then v_min(i)=b_min(i), v_max(i)=b_max(i)
+    // else v_min(i)=b_max(i), v_max(i)=b_min(i)
+    Vec NormalSelect = VectorGreater( Normal, Zero );
+    Vec V_Min = VectorSelect( BoxMax, BoxMin, NormalSelect );
+    Vec V_Max = VectorSelect( BoxMin, BoxMax, NormalSelect );
+
+    // if n dot v_min + d > 0 || n dot v_max + d < 0 then disjoint
+    Vec MinDist = Vector3Dot( V_Min, Normal );
+    Vec MaxDist = Vector3Dot( V_Max, Normal );
+
+    Vec NoIntersection = VectorGreater( MinDist, Dist );
+    NoIntersection = VectorOrInt( NoIntersection, VectorLess( MaxDist, Dist ) );
+
+    // Move the box center to zero to simplify the following tests.
+    Vec TV0 = V0 - Center;
+    Vec TV1 = V1 - Center;
+    Vec TV2 = V2 - Center;
+
+    // Test the edge/edge axes (3*3).
+    Vec e0 = TV1 - TV0;
+    Vec e1 = TV2 - TV1;
+    Vec e2 = TV0 - TV2;
+
+    // Make w zero.
+    e0 = VectorInsert( e0, Zero, 0, 0, 0, 0, 1 );
+    e1 = VectorInsert( e1, Zero, 0, 0, 0, 0, 1 );
+    e2 = VectorInsert( e2, Zero, 0, 0, 0, 0, 1 );
+
+    Vec Axis;
+    Vec p0, p1, p2;
+    Vec Min, Max;
+    Vec Radius;
+
+    // Axis == (1,0,0) x e0 = (0, -e0.z, e0.y)
+    Axis = VectorPermute( e0, -e0, Permute0W1Z0Y0X );
+    p0 = Vector3Dot( TV0, Axis );
+    // p1 = Vector3Dot( V1, Axis ); // p1 = p0;
+    p2 = Vector3Dot( TV2, Axis );
+    Min = VectorMin( p0, p2 );
+    Max = VectorMax( p0, p2 );
+    Radius = Vector3Dot( Extents, VectorAbs( Axis ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorGreater( Min, Radius ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorLess( Max, -Radius ) );
+
+    // Axis == (1,0,0) x e1 = (0, -e1.z, e1.y)
+    Axis = VectorPermute( e1, -e1, Permute0W1Z0Y0X );
+    p0 = Vector3Dot( TV0, Axis );
+    p1 = Vector3Dot( TV1, Axis );
+    // p2 = Vector3Dot( V2, Axis ); // p2 = p1;
+    Min = VectorMin( p0, p1 );
+    Max = VectorMax( p0, p1 );
+    Radius = Vector3Dot( Extents, VectorAbs( Axis ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorGreater( Min, Radius ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorLess( Max, -Radius ) );
+
+    // Axis == (1,0,0) x e2 = (0, -e2.z, e2.y)
+    Axis = VectorPermute( e2, -e2, Permute0W1Z0Y0X );
+    p0 = Vector3Dot( TV0, Axis );
+    p1 = Vector3Dot( TV1, Axis );
+    // p2 = Vector3Dot( V2, Axis ); // p2 = p0;
+    Min = VectorMin( p0, p1 );
+    Max = VectorMax( p0, p1 );
+    Radius = Vector3Dot( Extents, VectorAbs( Axis ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorGreater( Min, Radius ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorLess( Max, -Radius ) );
+
+    // Axis == (0,1,0) x e0 = (e0.z, 0, -e0.x)
+    Axis = VectorPermute( e0, -e0, Permute0Z0W1X0Y );
+    p0 = Vector3Dot( TV0, Axis );
+    // p1 = Vector3Dot( V1, Axis ); // p1 = p0;
+    p2 = Vector3Dot( TV2, Axis );
+    Min = VectorMin( p0, p2 );
+    Max = VectorMax( p0, p2 );
+    Radius = Vector3Dot( Extents, VectorAbs( Axis ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorGreater( Min, Radius ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorLess( Max, -Radius ) );
+
+    // Axis == (0,1,0) x e1 = (e1.z, 0, -e1.x)
+    Axis = VectorPermute( e1, -e1, Permute0Z0W1X0Y );
+    p0 = Vector3Dot( TV0, Axis );
+    p1 = Vector3Dot( TV1, Axis );
+    // p2 = Vector3Dot( V2, Axis ); // p2 = p1;
+    Min = VectorMin( p0, p1 );
+    Max = VectorMax( p0, p1 );
+    Radius = Vector3Dot( Extents, VectorAbs( Axis ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorGreater( Min, Radius ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorLess( Max, -Radius ) );
+
+    // Axis == (0,0,1) x e2 = (e2.z, 0, -e2.x)
+    Axis = VectorPermute( e2, -e2, Permute0Z0W1X0Y );
+    p0 = Vector3Dot( TV0, Axis );
+    p1 = Vector3Dot( TV1, Axis );
+    // p2 = Vector3Dot( V2, Axis ); // p2 = p0;
+    Min = VectorMin( p0, p1 );
+    Max = VectorMax( p0, p1 );
+    Radius = Vector3Dot( Extents, VectorAbs( Axis ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorGreater( Min, Radius ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorLess( Max, -Radius ) );
+
+    // Axis == (0,0,1) x e0 = (-e0.y, e0.x, 0)
+    Axis = VectorPermute( e0, -e0, Permute1Y0X0W0Z );
+    p0 = Vector3Dot( TV0, Axis );
+    // p1 = Vector3Dot( V1, Axis ); // p1 = p0;
+    p2 = Vector3Dot( TV2, Axis );
+    Min = VectorMin( p0, p2 );
+    Max = VectorMax( p0, p2 );
+    Radius = Vector3Dot( Extents, VectorAbs( Axis ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorGreater( Min, Radius ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorLess( Max, -Radius ) );
+
+    // Axis == (0,0,1) x e1 = (-e1.y, e1.x, 0)
+    Axis = VectorPermute( e1, -e1, Permute1Y0X0W0Z );
+    p0 = Vector3Dot( TV0, Axis );
+    p1 = Vector3Dot( TV1, Axis );
+    // p2 = Vector3Dot( V2, Axis ); // p2 = p1;
+    Min = VectorMin( p0, p1 );
+    Max = VectorMax( p0, p1 );
+    Radius = Vector3Dot( Extents, VectorAbs( Axis ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorGreater( Min, Radius ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorLess( Max, -Radius ) );
+
+    // Axis == (0,0,1) x e2 = (-e2.y, e2.x, 0)
+    Axis = VectorPermute( e2, -e2, Permute1Y0X0W0Z );
+    p0 = Vector3Dot( TV0, Axis );
+    p1 = Vector3Dot( TV1, Axis );
+    // p2 = Vector3Dot( V2, Axis ); // p2 = p0;
+    Min = VectorMin( p0, p1 );
+    Max = VectorMax( p0, p1 );
+    Radius = Vector3Dot( Extents, VectorAbs( Axis ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorGreater( Min, Radius ) );
+    NoIntersection = VectorOrInt( NoIntersection, VectorLess( Max, -Radius ) );
+
+    return Vector4NotEqualInt( NoIntersection, VectorTrueInt() );
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectTriangleOrientedBox( CVec V0, CVec V1, CVec V2, const OrientedBox* pVolume )
+{
+    assert( pVolume );
+
+    // Load the box center & orientation.
+    Vec Center = LoadFloat3( &pVolume->Center );
+    Vec Orientation = LoadFloat4( &pVolume->Orientation );
+
+    assert( QuaternionIsUnit( Orientation ) );
+
+    // Transform the triangle vertices into the space of the box.
+    Vec TV0 = Vector3InverseRotate( V0 - Center, Orientation );
+    Vec TV1 = Vector3InverseRotate( V1 - Center, Orientation );
+    Vec TV2 = Vector3InverseRotate( V2 - Center, Orientation );
+
+    AxisAlignedBox Box;
+    Box.Center = MakeFloat3( 0.0f, 0.0f, 0.0f );
+    Box.Extents = pVolume->Extents;
+
+    // Use the triangle vs axis aligned box intersection routine.
+    return IntersectTriangleAxisAlignedBox( TV0, TV1, TV2, &Box );
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectSphereSphere( const Sphere* pVolumeA, const Sphere* pVolumeB )
+{
+    assert( pVolumeA );
+    assert( pVolumeB );
+
+    // Load A.
+    Vec CenterA = LoadFloat3( &pVolumeA->Center );
+    Vec RadiusA = VectorReplicatePtr( &pVolumeA->Radius );
+
+    // Load B.
+    Vec CenterB = LoadFloat3( &pVolumeB->Center );
+    Vec RadiusB = VectorReplicatePtr( &pVolumeB->Radius );
+
+    // Distance squared between centers.    
+    Vec Delta = CenterB - CenterA;
+    Vec DistanceSquared = Vector3LengthSq( Delta );
+
+    // Sum of the radii sqaured.
+    Vec RadiusSquared = RadiusA + RadiusB;
+    RadiusSquared = RadiusSquared * RadiusSquared;
+
+    return Vector4LessOrEqual( DistanceSquared, RadiusSquared );
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectSphereAxisAlignedBox( const Sphere* pVolumeA, const AxisAlignedBox* pVolumeB )
+{
+    assert( pVolumeA );
+    assert( pVolumeB );
+
+    Vec SphereCenter = LoadFloat3( &pVolumeA->Center );
+    Vec SphereRadius = VectorReplicatePtr( &pVolumeA->Radius );
+
+    Vec BoxCenter = LoadFloat3( &pVolumeB->Center );
+    Vec BoxExtents = LoadFloat3( &pVolumeB->Extents );
+
+    Vec BoxMin = BoxCenter - BoxExtents;
+    Vec BoxMax = BoxCenter + BoxExtents;
+
+    // Find the distance to the nearest point on the box.
+    // for each i in (x, y, z)
+    // if (SphereCenter(i) < BoxMin(i)) d2 += (SphereCenter(i) - BoxMin(i)) ^ 2
+    // else if (SphereCenter(i) > BoxMax(i)) d2 += (SphereCenter(i) - BoxMax(i)) ^ 2
+
+    Vec d = VectorZero();
+
+    // Compute d for each dimension.
+    Vec LessThanMin = VectorLess( SphereCenter, BoxMin );
+    Vec GreaterThanMax = VectorGreater( SphereCenter, BoxMax );
+
+    Vec MinDelta = SphereCenter - BoxMin;
+    Vec MaxDelta = SphereCenter - BoxMax;
+
+    // Choose value for each dimension based on the comparison.
+    d = VectorSelect( d, MinDelta, LessThanMin );
+    d = VectorSelect( d, MaxDelta, GreaterThanMax );
+
+    // Use a dot-product to square them and sum them together.
+    Vec d2 = Vector3Dot( d, d );
+
+    return Vector4LessOrEqual( d2, VectorMultiply( SphereRadius, SphereRadius ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectSphereOrientedBox( const Sphere* pVolumeA, const OrientedBox* pVolumeB )
+{
+    assert( pVolumeA );
+    assert( pVolumeB );
+
+    Vec SphereCenter = LoadFloat3( &pVolumeA->Center );
+    Vec SphereRadius = VectorReplicatePtr( &pVolumeA->Radius );
+
+    Vec BoxCenter = LoadFloat3( &pVolumeB->Center );
+    Vec BoxExtents = LoadFloat3( &pVolumeB->Extents );
+    Vec BoxOrientation = LoadFloat4( &pVolumeB->Orientation );
+
+    assert( QuaternionIsUnit( BoxOrientation ) );
+
+    // Transform the center of the sphere to be local to the box.
+    // BoxMin = -BoxExtents
+    // BoxMax = +BoxExtents
+    SphereCenter = Vector3InverseRotate( SphereCenter - BoxCenter, BoxOrientation );
+
+    // Find the distance to the nearest point on the box.
+    // for each i in (x, y, z)
+    // if (SphereCenter(i) < BoxMin(i)) d2 += (SphereCenter(i) - BoxMin(i)) ^ 2
+    // else if (SphereCenter(i) > BoxMax(i)) d2 += (SphereCenter(i) - BoxMax(i)) ^ 2
+
+    Vec d = VectorZero();
+
+    // Compute d for each dimension.
+    Vec LessThanMin = VectorLess( SphereCenter, -BoxExtents );
+    Vec GreaterThanMax = VectorGreater( SphereCenter, BoxExtents );
+
+    Vec MinDelta = SphereCenter + BoxExtents;
+    Vec MaxDelta = SphereCenter - BoxExtents;
+
+    // Choose value for each dimension based on the comparison.
+    d = VectorSelect( d, MinDelta, LessThanMin );
+    d = VectorSelect( d, MaxDelta, GreaterThanMax );
+
+    // Use a dot-product to square them and sum them together.
+    Vec d2 = Vector3Dot( d, d );
+
+    return Vector4LessOrEqual( d2, VectorMultiply( SphereRadius, SphereRadius ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectAxisAlignedBoxAxisAlignedBox( const AxisAlignedBox* pVolumeA, const AxisAlignedBox* pVolumeB )
+{
+    assert( pVolumeA );
+    assert( pVolumeB );
+
+    Vec CenterA = LoadFloat3( &pVolumeA->Center );
+    Vec ExtentsA = LoadFloat3( &pVolumeA->Extents );
+
+    Vec CenterB = LoadFloat3( &pVolumeB->Center );
+    Vec ExtentsB = LoadFloat3( &pVolumeB->Extents );
+
+    Vec MinA = CenterA - ExtentsA;
+    Vec MaxA = CenterA + ExtentsA;
+
+    Vec MinB = CenterB - ExtentsB;
+    Vec MaxB = CenterB + ExtentsB;
+
+    // for each i in (x, y, z) if a_min(i) > b_max(i) or b_min(i) > a_max(i) then return false
+    Vec Disjoint = VectorOrInt( VectorGreater( MinA, MaxB ), VectorGreater( MinB, MaxA ) );
+
+    return !Vector3AnyTrue( Disjoint );
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectAxisAlignedBoxOrientedBox( const AxisAlignedBox* pVolumeA, const OrientedBox* pVolumeB )
+{
+    assert( pVolumeA );
+    assert( pVolumeB );
+
+    // Make the axis aligned box oriented and do an OBB vs OBB test.
+    OrientedBox BoxA;
+
+    BoxA.Center = pVolumeA->Center;
+    BoxA.Extents = pVolumeA->Extents;
+    BoxA.Orientation.x = 0.0f;
+    BoxA.Orientation.y = 0.0f;
+    BoxA.Orientation.z = 0.0f;
+    BoxA.Orientation.w = 1.0f;
+
+    return IntersectOrientedBoxOrientedBox( &BoxA, pVolumeB );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Fast oriented box / oriented box intersection test using the separating axis 
+// theorem.
+//-----------------------------------------------------------------------------
+XNA_KERNEL bool IntersectOrientedBoxOrientedBox( const OrientedBox* pVolumeA, const OrientedBox* pVolumeB )
+{
+    static const PermuteControl Permute0W1Z0Y0X = XNA_PERMUTE_CONTROL( 3, 6, 1, 0 );
+    static const PermuteControl Permute0Z0W1X0Y = XNA_PERMUTE_CONTROL( 2, 3, 4, 1 );
+    static const PermuteControl Permute1Y0X0W0Z = XNA_PERMUTE_CONTROL( 5, 0, 3, 2 );
+    static const PermuteControl PermuteWZYX = XNA_PERMUTE_CONTROL( 3, 2, 1, 0 );
+    static const PermuteControl PermuteZWXY = XNA_PERMUTE_CONTROL( 2, 3, 0, 1 );
+    static const PermuteControl PermuteYXWZ = XNA_PERMUTE_CONTROL( 1, 0, 3, 2 );
+
+    assert( pVolumeA );
+    assert( pVolumeB );
+
+    // Build the 3x3 rotation matrix that defines the orientation of B relative to A.
+    Vec A_quat = LoadFloat4( &pVolumeA->Orientation );
+    Vec B_quat = LoadFloat4( &pVolumeB->Orientation );
+
+    assert( QuaternionIsUnit( A_quat ) );
+    assert( QuaternionIsUnit( B_quat ) );
+
+    Vec Q = QuaternionMultiply( A_quat, QuaternionConjugate( B_quat ) );
+    VMatrix R = MatrixRotationQuaternion( Q );
+
+    // Compute the translation of B relative to A.
+    Vec A_cent = LoadFloat3( &pVolumeA->Center );
+    Vec B_cent = LoadFloat3( &pVolumeB->Center );
+    Vec t = Vector3InverseRotate( B_cent - A_cent, A_quat );
+
+    //
+    // h(A) = extents of A.
+    // h(B) = extents of B.
+    //
+    // a(u) = axes of A = (1,0,0), (0,1,0), (0,0,1)
+    // b(u) = axes of B relative to A = (r00,r10,r20), (r01,r11,r21), (r02,r12,r22)
+    //  
+    // For each possible separating axis l:
+    //   d(A) = sum (for i = u,v,w) h(A)(i) * abs( a(i) dot l )
+    //   d(B) = sum (for i = u,v,w) h(B)(i) * abs( b(i) dot l )
+    //   if abs( t dot l ) > d(A) + d(B) then disjoint
+    //
+
+    // Load extents of A and B.
+    Vec h_A = LoadFloat3( &pVolumeA->Extents );
+    Vec h_B = LoadFloat3( &pVolumeB->Extents );
+
+    // Rows. Note R[0,1,2]X.w = 0.
+    Vec R0X = R.r[0];
+    Vec R1X = R.r[1];
+    Vec R2X = R.r[2];
+
+    R = MatrixTranspose( R );
+
+    // Columns. Note RX[0,1,2].w = 0.
+    Vec RX0 = R.r[0];
+    Vec RX1 = R.r[1];
+    Vec RX2 = R.r[2];
+
+    // Absolute value of rows.
+    Vec AR0X = VectorAbs( R0X );
+    Vec AR1X = VectorAbs( R1X );
+    Vec AR2X = VectorAbs( R2X );
+
+    // Absolute value of columns.
+    Vec ARX0 = VectorAbs( RX0 );
+    Vec ARX1 = VectorAbs( RX1 );
+    Vec ARX2 = VectorAbs( RX2 );
+
+    // Test each of the 15 possible seperating axii.
+    Vec d, d_A, d_B;
+
+    // l = a(u) = (1, 0, 0)
+    // t dot l = t.x
+    // d(A) = h(A).x
+    // d(B) = h(B) dot abs(r00, r01, r02)
+    d = VectorSplatX( t );
+    d_A = VectorSplatX( h_A );
+    d_B = Vector3Dot( h_B, AR0X );
+    Vec NoIntersection = VectorGreater( VectorAbs(d), VectorAdd( d_A, d_B ) );
+
+    // l = a(v) = (0, 1, 0)
+    // t dot l = t.y
+    // d(A) = h(A).y
+    // d(B) = h(B) dot abs(r10, r11, r12)
+    d = VectorSplatY( t );
+    d_A = VectorSplatY( h_A );
+    d_B = Vector3Dot( h_B, AR1X );
+    NoIntersection = VectorOrInt( NoIntersection, 
+                                  VectorGreater( VectorAbs(d), VectorAdd( d_A, d_B ) ) );
+
+    // l = a(w) = (0, 0, 1)
+    // t dot l = t.z
+    // d(A) = h(A).z
+    // d(B) = h(B) dot abs(r20, r21, r22)
+    d = VectorSplatZ( t );
+    d_A = VectorSplatZ( h_A );
+    d_B = Vector3Dot( h_B, AR2X );
+    NoIntersection = VectorOrInt( NoIntersection, 
+                                  VectorGreater( VectorAbs(d), VectorAdd( d_A, d_B ) ) );
+
+    // l = b(u) = (r00, r10, r20)
+    // d(A) = h(A) dot abs(r00, r10, r20)
+    // d(B) = h(B).x
+    d = Vector3Dot( t, RX0 );
+    d_A = Vector3Dot( h_A, ARX0 );
+    d_B = VectorSplatX( h_B );
+    NoIntersection = VectorOrInt( NoIntersection, 
+                                  VectorGreater( VectorAbs(d), VectorAdd( d_A, d_B ) ) );
+
+    // l = b(v) = (r01, r11, r21)
+    // d(A) = h(A) dot abs(r01, r11, r21)
+    // d(B) = h(B).y
+    d = Vector3Dot( t, RX1 );
+    d_A = Vector3Dot( h_A, ARX1 );
+    d_B = VectorSplatY( h_B );
+    NoIntersection = VectorOrInt( NoIntersection, 
+                                  VectorGreater( VectorAbs(d), VectorAdd( d_A, d_B ) ) );
+
+    // l = b(w) = (r02, r12, r22)
+    // d(A) = h(A) dot abs(r02, r12, r22)
+    // d(B) = h(B).z
+    d = Vector3Dot( t, RX2 );
+    d_A = Vector3Dot( h_A, ARX2 );
+    d_B = VectorSplatZ( h_B );
+    NoIntersection = VectorOrInt( NoIntersection, 
+                                  VectorGreater( VectorAbs(d), VectorAdd( d_A, d_B ) ) );
+
+    // l = a(u) x b(u) = (0, -r20, r10)
+    // d(A) = h(A) dot abs(0, r20, r10)
+    // d(B) = h(B) dot abs(0, r02, r01)
+    d = Vector3Dot( t, VectorPermute( RX0, -RX0, Permute0W1Z0Y0X ) );
+    d_A = Vector3Dot( h_A, VectorPermute( ARX0, ARX0, PermuteWZYX ) );
+    d_B = Vector3Dot( h_B, VectorPermute( AR0X, AR0X, PermuteWZYX ) );
+    NoIntersection = VectorOrInt( NoIntersection, 
+                                  VectorGreater( VectorAbs(d), VectorAdd( d_A, d_B ) ) );
+
+    // l = a(u) x b(v) = (0, -r21, r11)
+    // d(A) = h(A) dot abs(0, r21, r11)
+    // d(B) = h(B) dot abs(r02, 0, r00)
+    d = Vector3Dot( t, VectorPermute( RX1, -RX1, Permute0W1Z0Y0X ) );
+    d_A = Vector3Dot( h_A, VectorPermute( ARX1, ARX1, PermuteWZYX ) );
+    d_B = Vector3Dot( h_B, VectorPermute( AR0X, AR0X, PermuteZWXY ) );
+    NoIntersection = VectorOrInt( NoIntersection, 
+                                  VectorGreater( VectorAbs(d), VectorAdd( d_A, d_B ) ) );
+
+    // l = a(u) x b(w) = (0, -r22, r12)
+    // d(A) = h(A) dot abs(0, r22, r12)
+    // d(B) = h(B) dot abs(r01, r00, 0)
+    d = Vector3Dot( t, VectorPermute( RX2, -RX2, Permute0W1Z0Y0X ) );
+    d_A = Vector3Dot( h_A, VectorPermute( ARX2, ARX2, PermuteWZYX ) );
+    d_B = Vector3Dot( h_B, VectorPermute( AR0X, AR0X, PermuteYXWZ ) );
+    NoIntersection = VectorOrInt( NoIntersection, 
+                                  VectorGreater( VectorAbs(d), VectorAdd( d_A, d_B ) ) );
+
+    // l = a(v) x b(u) = (r20, 0, -r00)
+    // d(A) = h(A) dot abs(r20, 0, r00)
+    // d(B) = h(B) dot abs(0, r12, r11)
+    d = Vector3Dot( t, VectorPermute( RX0, -RX0, Permute0Z0W1X0Y ) );
+    d_A = Vector3Dot( h_A, VectorPermute( ARX0, ARX0, PermuteZWXY ) );
+    d_B = Vector3Dot( h_B, VectorPermute( AR1X, AR1X, PermuteWZYX ) );
+    NoIntersection = VectorOrInt( NoIntersection, 
+                                  VectorGreater( VectorAbs(d), VectorAdd( d_A, d_B ) ) );
+
+    // l = a(v) x b(v) = (r21, 0, -r01)
+    // d(A) = h(A) dot abs(r21, 0, r01)
+    // d(B) = h(B) dot abs(r12, 0, r10)
+    d = Vector3Dot( t, VectorPermute( RX1, -RX1, Permute0Z0W1X0Y ) );
+    d_A = Vector3Dot( h_A, VectorPermute( ARX1, ARX1, PermuteZWXY ) );
+    d_B = Vector3Dot( h_B, VectorPermute( AR1X, AR1X, PermuteZWXY ) );
+    NoIntersection = VectorOrInt( NoIntersection, 
+                                  VectorGreater( VectorAbs(d), VectorAdd( d_A, d_B ) ) );
+
+    // l = a(v) x b(w) = (r22, 0, -r02)
+    // d(A) = h(A) dot abs(r22, 0, r02)
+    // d(B) = h(B) dot abs(r11, r10, 0)
+    d = Vector3Dot( t, VectorPermute( RX2, -RX2, Permute0Z0W1X0Y ) );
+    d_A = Vector3Dot( h_A, VectorPermute( ARX2, ARX2, PermuteZWXY ) );
+    d_B = Vector3Dot( h_B, VectorPermute( AR1X, AR1X, PermuteYXWZ ) );
+    NoIntersection = VectorOrInt( NoIntersection, 
+                                  VectorGreater( VectorAbs(d), VectorAdd( d_A, d_B ) ) );
+
+    // l = a(w) x b(u) = (-r10, r00, 0)
+    // d(A) = h(A) dot abs(r10, r00, 0)
+    // d(B) = h(B) dot abs(0, r22, r21)
+    d = Vector3Dot( t, VectorPermute( RX0, -RX0, Permute1Y0X0W0Z ) );
+    d_A = Vector3Dot( h_A, VectorPermute( ARX0, ARX0, PermuteYXWZ ) );
+    d_B = Vector3Dot( h_B, VectorPermute( AR2X, AR2X, PermuteWZYX ) );
+    NoIntersection = VectorOrInt( NoIntersection, 
+                                  VectorGreater( VectorAbs(d), VectorAdd( d_A, d_B ) ) );
+
+    // l = a(w) x b(v) = (-r11, r01, 0)
+    // d(A) = h(A) dot abs(r11, r01, 0)
+    // d(B) = h(B) dot abs(r22, 0, r20)
+    d = Vector3Dot( t, VectorPermute( RX1, -RX1, Permute1Y0X0W0Z ) );
+    d_A = Vector3Dot( h_A, VectorPermute( ARX1, ARX1, PermuteYXWZ ) );
+    d_B = Vector3Dot( h_B, VectorPermute( AR2X, AR2X, PermuteZWXY ) );
+    NoIntersection = VectorOrInt( NoIntersection, 
+                                  VectorGreater( VectorAbs(d), VectorAdd( d_A, d_B ) ) );
+
+    // l = a(w) x b(w) = (-r12, r02, 0)
+    // d(A) = h(A) dot abs(r12, r02, 0)
+    // d(B) = h(B) dot abs(r21, r20, 0)
+    d = Vector3Dot( t, VectorPermute( RX2, -RX2, Permute1Y0X0W0Z ) );
+    d_A = Vector3Dot( h_A, VectorPermute( ARX2, ARX2, PermuteYXWZ ) );
+    d_B = Vector3Dot( h_B, VectorPermute( AR2X, AR2X, PermuteYXWZ ) );
+    NoIntersection = VectorOrInt( NoIntersection, 
+                                  VectorGreater( VectorAbs(d), VectorAdd( d_A, d_B ) ) );
+
+    // No seperating axis found, boxes must intersect.
+    return Vector4NotEqualInt( NoIntersection, VectorTrueInt() );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Exact triangle vs frustum test.
+// Return values: 0 = no intersection, 
+//                1 = intersection, 
+//                2 = triangle is completely inside frustum
+//-----------------------------------------------------------------------------
+XNA_KERNEL int IntersectTriangleFrustum( CVec V0, CVec V1, CVec V2, const Frustum* pVolume )
+{
+    assert( pVolume );
+
+    // Build the frustum planes (NOTE: D is negated from the usual).
+    Vec Planes[6];
+    Planes[0] = VectorSet( 0.0f, 0.0f, -1.0f, -pVolume->Near );
+    Planes[1] = VectorSet( 0.0f, 0.0f, 1.0f, pVolume->Far );
+    Planes[2] = VectorSet( 1.0f, 0.0f, -pVolume->RightSlope, 0.0f );
+    Planes[3] = VectorSet( -1.0f, 0.0f, pVolume->LeftSlope, 0.0f );
+    Planes[4] = VectorSet( 0.0f, 1.0f, -pVolume->TopSlope, 0.0f );
+    Planes[5] = VectorSet( 0.0f, -1.0f, pVolume->BottomSlope, 0.0f );
+
+    // Load origin and orientation of the frustum.
+    Vec Origin = LoadFloat3( &pVolume->Origin );
+    Vec Orientation = LoadFloat4( &pVolume->Orientation );
+
+    assert( QuaternionIsUnit( Orientation ) );
+
+    // Transform triangle into the local space of frustum.
+    Vec TV0 = Vector3InverseRotate( V0 - Origin, Orientation );
+    Vec TV1 = Vector3InverseRotate( V1 - Origin, Orientation );
+    Vec TV2 = Vector3InverseRotate( V2 - Origin, Orientation );
+
+    // Test each vertex of the triangle against the frustum planes.
+    Vec Outside = VectorFalseInt();
+    Vec InsideAll = VectorTrueInt();
+
+    for( int i = 0; i < 6; i++ )
+    {
+        Vec Dist0 = Vector3Dot( TV0, Planes[i] );
+        Vec Dist1 = Vector3Dot( TV1, Planes[i] );
+        Vec Dist2 = Vector3Dot( TV2, Planes[i] );
+
+        Vec MinDist = VectorMin( Dist0, Dist1 );
+        MinDist = VectorMin( MinDist, Dist2 );
+        Vec MaxDist = VectorMax( Dist0, Dist1 );
+        MaxDist = VectorMax( MaxDist, Dist2 );
+
+        Vec PlaneDist = VectorSplatW( Planes[i] );
+
+        // Outside the plane?
+        Outside = VectorOrInt( Outside, VectorGreater( MinDist, PlaneDist ) );
+
+        // Fully inside the plane?
+        InsideAll = VectorAndInt( InsideAll, VectorLessOrEqual( MaxDist, PlaneDist ) );
+    }
+
+    // If the triangle is outside any of the planes it is outside. 
+    if ( Vector4EqualInt( Outside, VectorTrueInt() ) )
+        return 0;
+
+    // If the triangle is inside all planes it is fully inside.
+    if ( Vector4EqualInt( InsideAll, VectorTrueInt() ) )
+        return 2;
+
+    // Build the corners of the frustum.
+    Vec RightTop = VectorSet( pVolume->RightSlope, pVolume->TopSlope, 1.0f, 0.0f );
+    Vec RightBottom = VectorSet( pVolume->RightSlope, pVolume->BottomSlope, 1.0f, 0.0f );
+    Vec LeftTop = VectorSet( pVolume->LeftSlope, pVolume->TopSlope, 1.0f, 0.0f );
+    Vec LeftBottom = VectorSet( pVolume->LeftSlope, pVolume->BottomSlope, 1.0f, 0.0f );
+    Vec Near = VectorReplicatePtr( &pVolume->Near );
+    Vec Far = VectorReplicatePtr( &pVolume->Far );
+
+    Vec Corners[8];
+    Corners[0] = RightTop * Near;
+    Corners[1] = RightBottom * Near;
+    Corners[2] = LeftTop * Near;
+    Corners[3] = LeftBottom * Near;
+    Corners[4] = RightTop * Far;
+    Corners[5] = RightBottom * Far;
+    Corners[6] = LeftTop * Far;
+    Corners[7] = LeftBottom * Far;
+
+    // Test the plane of the triangle.
+    Vec Normal = Vector3Cross( V1 - V0, V2 - V0 );
+    Vec Dist = Vector3Dot( Normal, V0 );
+
+    Vec MinDist, MaxDist;
+    MinDist = MaxDist = Vector3Dot( Corners[0], Normal );
+    for( int i = 1; i < 8; i++ )
+    {
+        Vec Temp = Vector3Dot( Corners[i], Normal );
+        MinDist = VectorMin( MinDist, Temp );
+        MaxDist = VectorMax( MaxDist, Temp );
+    }
+
+    Outside = VectorOrInt( VectorGreater( MinDist, Dist ), VectorLess( MaxDist, Dist ) );   
+    if ( Vector4EqualInt( Outside, VectorTrueInt() ) )
+        return 0;
+
+    // Check the edge/edge axes (3*6).
+    Vec TriangleEdgeAxis[3];
+    TriangleEdgeAxis[0] = V1 - V0;
+    TriangleEdgeAxis[1] = V2 - V1;
+    TriangleEdgeAxis[2] = V0 - V2;
+
+    Vec FrustumEdgeAxis[6];
+    FrustumEdgeAxis[0] = RightTop;
+    FrustumEdgeAxis[1] = RightBottom;
+    FrustumEdgeAxis[2] = LeftTop;
+    FrustumEdgeAxis[3] = LeftBottom;
+    FrustumEdgeAxis[4] = RightTop - LeftTop;
+    FrustumEdgeAxis[5] = LeftBottom - LeftTop;
+
+    for( int i = 0; i < 3; i++ )
+    {
+        for( int j = 0; j < 6; j++ )
+        {
+            // Compute the axis we are going to test.
+            Vec Axis = Vector3Cross( TriangleEdgeAxis[i], FrustumEdgeAxis[j] );
+
+            // Find the min/max of the projection of the triangle onto the axis.
+            Vec MinA, MaxA;
+
+            Vec Dist0 = Vector3Dot( V0, Axis );
+            Vec Dist1 = Vector3Dot( V1, Axis );
+            Vec Dist2 = Vector3Dot( V2, Axis );
+
+            MinA = VectorMin( Dist0, Dist1 );
+            MinA = VectorMin( MinA, Dist2 );
+            MaxA = VectorMax( Dist0, Dist1 );
+            MaxA = VectorMax( MaxA, Dist2 );
+
+            // Find the min/max of the projection of the frustum onto the axis.
+            Vec MinB, MaxB;
+
+            MinB = MaxB = Vector3Dot( Axis, Corners[0] );
+
+            for( int k = 1; k < 8; k++ )
+            {
+                Vec Temp = Vector3Dot( Axis, Corners[k] );
+                MinB = VectorMin( MinB, Temp );
+                MaxB = VectorMax( MaxB, Temp );
+            }
+
+            // if (MinA > MaxB || MinB > MaxA) reject;
+            Outside = VectorOrInt( Outside, VectorGreater( MinA, MaxB ) );
+            Outside = VectorOrInt( Outside, VectorGreater( MinB, MaxA ) );
+        }
+    }
+
+    if ( Vector4EqualInt( Outside, VectorTrueInt() ) )
+        return 0;
+
+    // If we did not find a separating plane then the triangle must intersect the frustum.
+    return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Exact sphere vs frustum test.  The algorithm first checks the sphere against
+// the planes of the frustum, then if the plane checks were indeterminate finds
+// the nearest feature (plane, line, point) on the frustum to the center of the
+// sphere and compares the distance to the nearest feature to the radius of the 
+// sphere (it is so cool that all the comment lines above are the same length).
+// Return values: 0 = no intersection, 
+//                1 = intersection, 
+//                2 = sphere is completely inside frustum
+//-----------------------------------------------------------------------------
+XNA_KERNEL int IntersectSphereFrustum( const Sphere* pVolumeA, const Frustum* pVolumeB )
+{
+    assert( pVolumeA );
+    assert( pVolumeB );
+
+    Vec Zero = VectorZero();
+
+    // Build the frustum planes.
+    Vec Planes[6];
+    Planes[0] = VectorSet( 0.0f, 0.0f, -1.0f, pVolumeB->Near );
+    Planes[1] = VectorSet( 0.0f, 0.0f, 1.0f, -pVolumeB->Far );
+    Planes[2] = VectorSet( 1.0f, 0.0f, -pVolumeB->RightSlope, 0.0f );
+    Planes[3] = VectorSet( -1.0f, 0.0f, pVolumeB->LeftSlope, 0.0f );
+    Planes[4] = VectorSet( 0.0f, 1.0f, -pVolumeB->TopSlope, 0.0f );
+    Planes[5] = VectorSet( 0.0f, -1.0f, pVolumeB->BottomSlope, 0.0f );
+
+    // Normalize the planes so we can compare to the sphere radius.
+    Planes[2] = Vector3Normalize( Planes[2] );
+    Planes[3] = Vector3Normalize( Planes[3] );
+    Planes[4] = Vector3Normalize( Planes[4] );
+    Planes[5] = Vector3Normalize( Planes[5] );
+
+    // Load origin and orientation of the frustum.
+    Vec Origin = LoadFloat3( &pVolumeB->Origin );
+    Vec Orientation = LoadFloat4( &pVolumeB->Orientation );
+
+    assert( QuaternionIsUnit( Orientation ) );
+
+    // Load the sphere.
+    Vec Center = LoadFloat3( &pVolumeA->Center );
+    Vec Radius = VectorReplicatePtr( &pVolumeA->Radius );
+
+    // Transform the center of the sphere into the local space of frustum.
+    Center = Vector3InverseRotate( Center - Origin, Orientation );
+
+    // Set w of the center to one so we can dot4 with the plane.
+    Center = VectorInsert( Center, VectorSplatOne(), 0, 0, 0, 0, 1);
+
+    // Check against each plane of the frustum.
+    Vec Outside = VectorFalseInt();
+    Vec InsideAll = VectorTrueInt();
+    Vec CenterInsideAll = VectorTrueInt();
+
+    Vec Dist[6];
+
+    for( int i = 0; i < 6; i++ )
+    {
+        Dist[i] = Vector4Dot( Center, Planes[i] );
+
+        // Outside the plane?
+        Outside = VectorOrInt( Outside, VectorGreater( Dist[i], Radius ) );
+
+        // Fully inside the plane?
+        InsideAll = VectorAndInt( InsideAll, VectorLessOrEqual( Dist[i], -Radius ) );
+
+        // Check if the center is inside the plane.
+        CenterInsideAll = VectorAndInt( CenterInsideAll, VectorLessOrEqual( Dist[i], Zero ) );
+    }
+
+    // If the sphere is outside any of the planes it is outside. 
+    if ( Vector4EqualInt( Outside, VectorTrueInt() ) )
+        return 0;
+
+    // If the sphere is inside all planes it is fully inside.
+    if ( Vector4EqualInt( InsideAll, VectorTrueInt() ) )
+        return 2;
+
+    // If the center of the sphere is inside all planes and the sphere intersects 
+    // one or more planes then it must intersect.
+    if ( Vector4EqualInt( CenterInsideAll, VectorTrueInt() ) )
+        return 1;
+
+    // The sphere may be outside the frustum or intersecting the frustum.
+    // Find the nearest feature (face, edge, or corner) on the frustum 
+    // to the sphere.
+
+    // The faces adjacent to each face are:
+    static const int adjacent_faces[6][4] =
+    {
+        { 2, 3, 4, 5 },    // 0
+        { 2, 3, 4, 5 },    // 1
+        { 0, 1, 4, 5 },    // 2
+        { 0, 1, 4, 5 },    // 3
+        { 0, 1, 2, 3 },    // 4
+        { 0, 1, 2, 3 }
+    };  // 5
+
+    Vec Intersects = VectorFalseInt();
+
+    // Check to see if the nearest feature is one of the planes.
+    for( int i = 0; i < 6; i++ )
+    {
+        // Find the nearest point on the plane to the center of the sphere.
+        Vec Point = Center - (Planes[i] * Dist[i]);
+
+        // Set w of the point to one.
+        Point = VectorInsert( Point, VectorSplatOne(), 0, 0, 0, 0, 1 );
+        
+        // If the point is inside the face (inside the adjacent planes) then
+        // this plane is the nearest feature.
+        Vec InsideFace = VectorTrueInt();
+        
+        for ( int j = 0; j < 4; j++ )
+        {
+            int plane_index = adjacent_faces[i][j];
+
+            InsideFace = VectorAndInt( InsideFace,
+                                       VectorLessOrEqual( Vector4Dot( Point, Planes[plane_index] ), Zero ) );
+        }
+     
+        // Since we have already checked distance from the plane we know that the
+        // sphere must intersect if this plane is the nearest feature.
+        Intersects = VectorOrInt( Intersects, 
+                                  VectorAndInt( VectorGreater( Dist[i], Zero ), InsideFace ) );
+    }
+
+    if ( Vector4EqualInt( Intersects, VectorTrueInt() ) )
+        return 1;
+
+    // Build the corners of the frustum.
+    Vec RightTop = VectorSet( pVolumeB->RightSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
+    Vec RightBottom = VectorSet( pVolumeB->RightSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
+    Vec LeftTop = VectorSet( pVolumeB->LeftSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
+    Vec LeftBottom = VectorSet( pVolumeB->LeftSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
+    Vec Near = VectorReplicatePtr( &pVolumeB->Near );
+    Vec Far = VectorReplicatePtr( &pVolumeB->Far );
+
+    Vec Corners[8];
+    Corners[0] = RightTop * Near;
+    Corners[1] = RightBottom * Near;
+    Corners[2] = LeftTop * Near;
+    Corners[3] = LeftBottom * Near;
+    Corners[4] = RightTop * Far;
+    Corners[5] = RightBottom * Far;
+    Corners[6] = LeftTop * Far;
+    Corners[7] = LeftBottom * Far;
+
+    // The Edges are:
+    static const int edges[12][2] =
+    {
+        { 0, 1 }, { 2, 3 }, { 0, 2 }, { 1, 3 },    // Near plane
+        { 4, 5 }, { 6, 7 }, { 4, 6 }, { 5, 7 },    // Far plane
+        { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 },
+    }; // Near to far
+
+    Vec RadiusSq = Radius * Radius;
+
+    // Check to see if the nearest feature is one of the edges (or corners).
+    for( int i = 0; i < 12; i++ )
+    {
+        int ei0 = edges[i][0];
+        int ei1 = edges[i][1];
+
+        // Find the nearest point on the edge to the center of the sphere.
+        // The corners of the frustum are included as the endpoints of the edges.
+        Vec Point = PointOnLineSegmentNearestPoint( Corners[ei0], Corners[ei1], Center );
+
+        Vec Delta = Center - Point;
+
+        Vec DistSq = Vector3Dot( Delta, Delta );
+
+        // If the distance to the center of the sphere to the point is less than 
+        // the radius of the sphere then it must intersect.
+        Intersects = VectorOrInt( Intersects, VectorLessOrEqual( DistSq, RadiusSq ) );
+    }
+
+    if ( Vector4EqualInt( Intersects, VectorTrueInt() ) )
+        return 1;
+
+    // The sphere must be outside the frustum.
+    return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Exact axis alinged box vs frustum test.  Constructs an oriented box and uses
+// the oriented box vs frustum test.
+//
+// Return values: 0 = no intersection, 
+//                1 = intersection, 
+//                2 = box is completely inside frustum
+//-----------------------------------------------------------------------------
+XNA_KERNEL int IntersectAxisAlignedBoxFrustum( const AxisAlignedBox* pVolumeA, const Frustum* pVolumeB )
+{
+    assert( pVolumeA );
+    assert( pVolumeB );
+
+    // Make the axis aligned box oriented and do an OBB vs frustum test.
+    OrientedBox BoxA;
+
+    BoxA.Center = pVolumeA->Center;
+    BoxA.Extents = pVolumeA->Extents;
+    BoxA.Orientation.x = 0.0f;
+    BoxA.Orientation.y = 0.0f;
+    BoxA.Orientation.z = 0.0f;
+    BoxA.Orientation.w = 1.0f;
+
+    return IntersectOrientedBoxFrustum( &BoxA, pVolumeB );
+}
+
+
+//-----------------------------------------------------------------------------
+// Exact oriented box vs frustum test.
+// Return values: 0 = no intersection, 
+//                1 = intersection, 
+//                2 = box is completely inside frustum
+//-----------------------------------------------------------------------------
+XNA_KERNEL int IntersectOrientedBoxFrustum( const OrientedBox* pVolumeA, const Frustum* pVolumeB )
+{
+    assert( pVolumeA );
+    assert( pVolumeB );
+
+    const Vec SelectY = VectorSetInt( 0, 0xFFFFFFFF, 0, 0 );
+    const Vec SelectZ = VectorSetInt( 0, 0, 0xFFFFFFFF, 0 );
+
+    Vec Zero = VectorZero();
+
+    // Build the frustum planes.
+    Vec Planes[6];
+    Planes[0] = VectorSet( 0.0f, 0.0f, -1.0f, pVolumeB->Near );
+    Planes[1] = VectorSet( 0.0f, 0.0f, 1.0f, -pVolumeB->Far );
+    Planes[2] = VectorSet( 1.0f, 0.0f, -pVolumeB->RightSlope, 0.0f );
+    Planes[3] = VectorSet( -1.0f, 0.0f, pVolumeB->LeftSlope, 0.0f );
+    Planes[4] = VectorSet( 0.0f, 1.0f, -pVolumeB->TopSlope, 0.0f );
+    Planes[5] = VectorSet( 0.0f, -1.0f, pVolumeB->BottomSlope, 0.0f );
+
+    // Load origin and orientation of the frustum.
+    Vec Origin = LoadFloat3( &pVolumeB->Origin );
+    Vec FrustumOrientation = LoadFloat4( &pVolumeB->Orientation );
+
+    assert( QuaternionIsUnit( FrustumOrientation ) );
+
+    // Load the box.
+    Vec Center = LoadFloat3( &pVolumeA->Center );
+    Vec Extents = LoadFloat3( &pVolumeA->Extents );
+    Vec BoxOrientation = LoadFloat4( &pVolumeA->Orientation );
+
+    assert( QuaternionIsUnit( BoxOrientation ) );
+
+    // Transform the oriented box into the space of the frustum in order to 
+    // minimize the number of transforms we have to do.
+    Center = Vector3InverseRotate( Center - Origin, FrustumOrientation );
+    BoxOrientation = QuaternionMultiply( BoxOrientation, QuaternionConjugate( FrustumOrientation ) );
+
+    // Set w of the center to one so we can dot4 with the plane.
+    Center = VectorInsert( Center, VectorSplatOne(), 0, 0, 0, 0, 1);
+
+    // Build the 3x3 rotation matrix that defines the box axes.
+    VMatrix R = MatrixRotationQuaternion( BoxOrientation );
+
+    // Check against each plane of the frustum.
+    Vec Outside = VectorFalseInt();
+    Vec InsideAll = VectorTrueInt();
+    Vec CenterInsideAll = VectorTrueInt();
+
+    for( int i = 0; i < 6; i++ )
+    {
+        // Compute the distance to the center of the box.
+        Vec Dist = Vector4Dot( Center, Planes[i] );
+
+        // Project the axes of the box onto the normal of the plane.  Half the
+        // length of the projection (sometime called the "radius") is equal to
+        // h(u) * abs(n dot b(u))) + h(v) * abs(n dot b(v)) + h(w) * abs(n dot b(w))
+        // where h(i) are extents of the box, n is the plane normal, and b(i) are the 
+        // axes of the box.
+        Vec Radius = Vector3Dot( Planes[i], R.r[0] );
+        Radius = VectorSelect( Radius, Vector3Dot( Planes[i], R.r[1] ), SelectY );
+        Radius = VectorSelect( Radius, Vector3Dot( Planes[i], R.r[2] ), SelectZ );
+        Radius = Vector3Dot( Extents, VectorAbs( Radius ) );
+
+        // Outside the plane?
+        Outside = VectorOrInt( Outside, VectorGreater( Dist, Radius ) );
+
+        // Fully inside the plane?
+        InsideAll = VectorAndInt( InsideAll, VectorLessOrEqual( Dist, -Radius ) );
+
+        // Check if the center is inside the plane.
+        CenterInsideAll = VectorAndInt( CenterInsideAll, VectorLessOrEqual( Dist, Zero ) );
+    }
+
+    // If the box is outside any of the planes it is outside. 
+    if ( Vector4EqualInt( Outside, VectorTrueInt() ) )
+        return 0;
+
+    // If the box is inside all planes it is fully inside.
+    if ( Vector4EqualInt( InsideAll, VectorTrueInt() ) )
+        return 2;
+
+    // If the center of the box is inside all planes and the box intersects 
+    // one or more planes then it must intersect.
+    if ( Vector4EqualInt( CenterInsideAll, VectorTrueInt() ) )
+        return 1;
+
+    // Build the corners of the frustum.
+    Vec RightTop = VectorSet( pVolumeB->RightSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
+    Vec RightBottom = VectorSet( pVolumeB->RightSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
+    Vec LeftTop = VectorSet( pVolumeB->LeftSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
+    Vec LeftBottom = VectorSet( pVolumeB->LeftSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
+    Vec Near = VectorReplicatePtr( &pVolumeB->Near );
+    Vec Far = VectorReplicatePtr( &pVolumeB->Far );
+
+    Vec Corners[8];
+    Corners[0] = RightTop * Near;
+    Corners[1] = RightBottom * Near;
+    Corners[2] = LeftTop * Near;
+    Corners[3] = LeftBottom * Near;
+    Corners[4] = RightTop * Far;
+    Corners[5] = RightBottom * Far;
+    Corners[6] = LeftTop * Far;
+    Corners[7] = LeftBottom * Far;
+
+    // Test against box axes (3)
+    {
+        // Find the min/max values of the projection of the frustum onto each axis.
+        Vec FrustumMin, FrustumMax;
+
+        FrustumMin = Vector3Dot( Corners[0], R.r[0] );
+        FrustumMin = VectorSelect( FrustumMin, Vector3Dot( Corners[0], R.r[1] ), SelectY );
+        FrustumMin = VectorSelect( FrustumMin, Vector3Dot( Corners[0], R.r[2] ), SelectZ );
+        FrustumMax = FrustumMin;
+
+        for( int i = 1; i < 8; i++ )
+        {
+            Vec Temp = Vector3Dot( Corners[i], R.r[0] );
+            Temp = VectorSelect( Temp, Vector3Dot( Corners[i], R.r[1] ), SelectY );
+            Temp = VectorSelect( Temp, Vector3Dot( Corners[i], R.r[2] ), SelectZ );
+
+            FrustumMin = VectorMin( FrustumMin, Temp );
+            FrustumMax = VectorMax( FrustumMax, Temp );
+        }
+
+        // Project the center of the box onto the axes.
+        Vec BoxDist = Vector3Dot( Center, R.r[0] );
+        BoxDist = VectorSelect( BoxDist, Vector3Dot( Center, R.r[1] ), SelectY );
+        BoxDist = VectorSelect( BoxDist, Vector3Dot( Center, R.r[2] ), SelectZ );
+
+        // The projection of the box onto the axis is just its Center and Extents.
+        // if (min > box_max || max < box_min) reject;
+        Vec Result = VectorOrInt( VectorGreater( FrustumMin, BoxDist + Extents ),
+                                  VectorLess( FrustumMax, BoxDist - Extents ) );
+
+        if( Vector3AnyTrue( Result ) )
+            return 0;
+    }
+
+    // Test against edge/edge axes (3*6).
+    Vec FrustumEdgeAxis[6];
+
+    FrustumEdgeAxis[0] = RightTop;
+    FrustumEdgeAxis[1] = RightBottom;
+    FrustumEdgeAxis[2] = LeftTop;
+    FrustumEdgeAxis[3] = LeftBottom;
+    FrustumEdgeAxis[4] = RightTop - LeftTop;
+    FrustumEdgeAxis[5] = LeftBottom - LeftTop;
+
+    for( int i = 0; i < 3; i++ )
+    {
+        for( int j = 0; j < 6; j++ )
+        {
+            // Compute the axis we are going to test.
+            Vec Axis = Vector3Cross( R.r[i], FrustumEdgeAxis[j] );
+
+            // Find the min/max values of the projection of the frustum onto the axis.
+            Vec FrustumMin, FrustumMax;
+
+            FrustumMin = FrustumMax = Vector3Dot( Axis, Corners[0] );
+
+            for( int k = 1; k < 8; k++ )
+            {
+                Vec Temp = Vector3Dot( Axis, Corners[k] );
+                FrustumMin = VectorMin( FrustumMin, Temp );
+                FrustumMax = VectorMax( FrustumMax, Temp );
+            }
+
+            // Project the center of the box onto the axis.
+            Vec Dist = Vector3Dot( Center, Axis );
+
+            // Project the axes of the box onto the axis to find the "radius" of the box.
+            Vec Radius = Vector3Dot( Axis, R.r[0] );
+            Radius = VectorSelect( Radius, Vector3Dot( Axis, R.r[1] ), SelectY );
+            Radius = VectorSelect( Radius, Vector3Dot( Axis, R.r[2] ), SelectZ );
+            Radius = Vector3Dot( Extents, VectorAbs( Radius ) );
+
+            // if (center > max + radius || center < min - radius) reject;
+            Outside = VectorOrInt( Outside, VectorGreater( Dist, FrustumMax + Radius ) );
+            Outside = VectorOrInt( Outside, VectorLess( Dist, FrustumMin - Radius ) );
+        }
+    }
+
+    if ( Vector4EqualInt( Outside, VectorTrueInt() ) )
+        return 0;
+
+    // If we did not find a separating plane then the box must intersect the frustum.
+    return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Exact frustum vs frustum test.
+// Return values: 0 = no intersection, 
+//                1 = intersection, 
+//                2 = frustum A is completely inside frustum B
+//-----------------------------------------------------------------------------
+XNA_KERNEL int IntersectFrustumFrustum( const Frustum* pVolumeA, const Frustum* pVolumeB )
+{
+    assert( pVolumeA );
+    assert( pVolumeB );
+
+    // Load origin and orientation of frustum B.
+    Vec OriginB = LoadFloat3( &pVolumeB->Origin );
+    Vec OrientationB = LoadFloat4( &pVolumeB->Orientation );
+
+    assert( QuaternionIsUnit( OrientationB ) );
+
+    // Build the planes of frustum B.
+    Vec AxisB[6];
+    AxisB[0] = VectorSet( 0.0f, 0.0f, -1.0f, 0.0f );
+    AxisB[1] = VectorSet( 0.0f, 0.0f, 1.0f, 0.0f );
+    AxisB[2] = VectorSet( 1.0f, 0.0f, -pVolumeB->RightSlope, 0.0f );
+    AxisB[3] = VectorSet( -1.0f, 0.0f, pVolumeB->LeftSlope, 0.0f );
+    AxisB[4] = VectorSet( 0.0f, 1.0f, -pVolumeB->TopSlope, 0.0f );
+    AxisB[5] = VectorSet( 0.0f, -1.0f, pVolumeB->BottomSlope, 0.0f );
+
+    Vec PlaneDistB[6];
+    PlaneDistB[0] = -VectorReplicatePtr( &pVolumeB->Near );
+    PlaneDistB[1] = VectorReplicatePtr( &pVolumeB->Far );
+    PlaneDistB[2] = VectorZero();
+    PlaneDistB[3] = VectorZero();
+    PlaneDistB[4] = VectorZero();
+    PlaneDistB[5] = VectorZero();
+
+    // Load origin and orientation of frustum A.
+    Vec OriginA = LoadFloat3( &pVolumeA->Origin );
+    Vec OrientationA = LoadFloat4( &pVolumeA->Orientation );
+
+    assert( QuaternionIsUnit( OrientationA ) );
+
+    // Transform frustum A into the space of the frustum B in order to 
+    // minimize the number of transforms we have to do.
+    OriginA = Vector3InverseRotate( OriginA - OriginB, OrientationB );
+    OrientationA = QuaternionMultiply( OrientationA, QuaternionConjugate( OrientationB ) );
+
+    // Build the corners of frustum A (in the local space of B).
+    Vec RightTopA = VectorSet( pVolumeA->RightSlope, pVolumeA->TopSlope, 1.0f, 0.0f );
+    Vec RightBottomA = VectorSet( pVolumeA->RightSlope, pVolumeA->BottomSlope, 1.0f, 0.0f );
+    Vec LeftTopA = VectorSet( pVolumeA->LeftSlope, pVolumeA->TopSlope, 1.0f, 0.0f );
+    Vec LeftBottomA = VectorSet( pVolumeA->LeftSlope, pVolumeA->BottomSlope, 1.0f, 0.0f );
+    Vec NearA = VectorReplicatePtr( &pVolumeA->Near );
+    Vec FarA = VectorReplicatePtr( &pVolumeA->Far );
+
+    RightTopA = Vector3Rotate( RightTopA, OrientationA );
+    RightBottomA = Vector3Rotate( RightBottomA, OrientationA );
+    LeftTopA = Vector3Rotate( LeftTopA, OrientationA );
+    LeftBottomA = Vector3Rotate( LeftBottomA, OrientationA );
+
+    Vec CornersA[8];
+    CornersA[0] = OriginA + RightTopA * NearA;
+    CornersA[1] = OriginA + RightBottomA * NearA;
+    CornersA[2] = OriginA + LeftTopA * NearA;
+    CornersA[3] = OriginA + LeftBottomA * NearA;
+    CornersA[4] = OriginA + RightTopA * FarA;
+    CornersA[5] = OriginA + RightBottomA * FarA;
+    CornersA[6] = OriginA + LeftTopA * FarA;
+    CornersA[7] = OriginA + LeftBottomA * FarA;
+
+    // Check frustum A against each plane of frustum B.
+    Vec Outside = VectorFalseInt();
+    Vec InsideAll = VectorTrueInt();
+
+    for( int i = 0; i < 6; i++ )
+    {
+        // Find the min/max projection of the frustum onto the plane normal.
+        Vec Min, Max;
+
+        Min = Max = Vector3Dot( AxisB[i], CornersA[0] );
+
+        for( int j = 1; j < 8; j++ )
+        {
+            Vec Temp = Vector3Dot( AxisB[i], CornersA[j] );
+            Min = VectorMin( Min, Temp );
+            Max = VectorMax( Max, Temp );
+        }
+
+        // Outside the plane?
+        Outside = VectorOrInt( Outside, VectorGreater( Min, PlaneDistB[i] ) );
+
+        // Fully inside the plane?
+        InsideAll = VectorAndInt( InsideAll, VectorLessOrEqual( Max, PlaneDistB[i] ) );
+    }
+
+    // If the frustum A is outside any of the planes of frustum B it is outside. 
+    if ( Vector4EqualInt( Outside, VectorTrueInt() ) )
+        return 0;
+
+    // If frustum A is inside all planes of frustum B it is fully inside.
+    if ( Vector4EqualInt( InsideAll, VectorTrueInt() ) )
+        return 2;
+
+    // Build the corners of frustum B.
+    Vec RightTopB = VectorSet( pVolumeB->RightSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
+    Vec RightBottomB = VectorSet( pVolumeB->RightSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
+    Vec LeftTopB = VectorSet( pVolumeB->LeftSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
+    Vec LeftBottomB = VectorSet( pVolumeB->LeftSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
+    Vec NearB = VectorReplicatePtr( &pVolumeB->Near );
+    Vec FarB = VectorReplicatePtr( &pVolumeB->Far );
+
+    Vec CornersB[8];
+    CornersB[0] = RightTopB * NearB;
+    CornersB[1] = RightBottomB * NearB;
+    CornersB[2] = LeftTopB * NearB;
+    CornersB[3] = LeftBottomB * NearB;
+    CornersB[4] = RightTopB * FarB;
+    CornersB[5] = RightBottomB * FarB;
+    CornersB[6] = LeftTopB * FarB;
+    CornersB[7] = LeftBottomB * FarB;
+
+    // Build the planes of frustum A (in the local space of B).
+    Vec AxisA[6];
+    Vec PlaneDistA[6];
+
+    AxisA[0] = VectorSet( 0.0f, 0.0f, -1.0f, 0.0f );
+    AxisA[1] = VectorSet( 0.0f, 0.0f, 1.0f, 0.0f );
+    AxisA[2] = VectorSet( 1.0f, 0.0f, -pVolumeA->RightSlope, 0.0f );
+    AxisA[3] = VectorSet( -1.0f, 0.0f, pVolumeA->LeftSlope, 0.0f );
+    AxisA[4] = VectorSet( 0.0f, 1.0f, -pVolumeA->TopSlope, 0.0f );
+    AxisA[5] = VectorSet( 0.0f, -1.0f, pVolumeA->BottomSlope, 0.0f );
+
+    AxisA[0] = Vector3Rotate( AxisA[0], OrientationA );
+    AxisA[1] = -AxisA[0];
+    AxisA[2] = Vector3Rotate( AxisA[2], OrientationA );
+    AxisA[3] = Vector3Rotate( AxisA[3], OrientationA );
+    AxisA[4] = Vector3Rotate( AxisA[4], OrientationA );
+    AxisA[5] = Vector3Rotate( AxisA[5], OrientationA );
+
+    PlaneDistA[0] = Vector3Dot( AxisA[0], CornersA[0] );  // Re-use corner on near plane.
+    PlaneDistA[1] = Vector3Dot( AxisA[1], CornersA[4] );  // Re-use corner on far plane.
+    PlaneDistA[2] = Vector3Dot( AxisA[2], OriginA );
+    PlaneDistA[3] = Vector3Dot( AxisA[3], OriginA );
+    PlaneDistA[4] = Vector3Dot( AxisA[4], OriginA );
+    PlaneDistA[5] = Vector3Dot( AxisA[5], OriginA );
+
+    // Check each axis of frustum A for a seperating plane (5).
+    for( int i = 0; i < 6; i++ )
+    {
+        // Find the minimum projection of the frustum onto the plane normal.
+        Vec Min;
+
+        Min = Vector3Dot( AxisA[i], CornersB[0] );
+
+        for( int j = 1; j < 8; j++ )
+        {
+            Vec Temp = Vector3Dot( AxisA[i], CornersB[j] );
+            Min = VectorMin( Min, Temp );
+        }
+
+        // Outside the plane?
+        Outside = VectorOrInt( Outside, VectorGreater( Min, PlaneDistA[i] ) );
+    }
+
+    // If the frustum B is outside any of the planes of frustum A it is outside. 
+    if ( Vector4EqualInt( Outside, VectorTrueInt() ) )
+        return 0;
+
+    // Check edge/edge axes (6 * 6).
+    Vec FrustumEdgeAxisA[6];
+    FrustumEdgeAxisA[0] = RightTopA;
+    FrustumEdgeAxisA[1] = RightBottomA;
+    FrustumEdgeAxisA[2] = LeftTopA;
+    FrustumEdgeAxisA[3] = LeftBottomA;
+    FrustumEdgeAxisA[4] = RightTopA - LeftTopA;
+    FrustumEdgeAxisA[5] = LeftBottomA - LeftTopA;
+
+    Vec FrustumEdgeAxisB[6];
+    FrustumEdgeAxisB[0] = RightTopB;
+    FrustumEdgeAxisB[1] = RightBottomB;
+    FrustumEdgeAxisB[2] = LeftTopB;
+    FrustumEdgeAxisB[3] = LeftBottomB;
+    FrustumEdgeAxisB[4] = RightTopB - LeftTopB;
+    FrustumEdgeAxisB[5] = LeftBottomB - LeftTopB;
+
+    for( int i = 0; i < 6; i++ )
+    {
+        for( int j = 0; j < 6; j++ )
+        {
+            // Compute the axis we are going to test.
+            Vec Axis = Vector3Cross( FrustumEdgeAxisA[i], FrustumEdgeAxisB[j] );
+
+            // Find the min/max values of the projection of both frustums onto the axis.
+            Vec MinA, MaxA;
+            Vec MinB, MaxB;
+
+            MinA = MaxA = Vector3Dot( Axis, CornersA[0] );
+            MinB = MaxB = Vector3Dot( Axis, CornersB[0] );
+
+            for( int k = 1; k < 8; k++ )
+            {
+                Vec TempA = Vector3Dot( Axis, CornersA[k] );
+                MinA = VectorMin( MinA, TempA );
+                MaxA = VectorMax( MaxA, TempA );
+
+                Vec TempB = Vector3Dot( Axis, CornersB[k] );
+                MinB = VectorMin( MinB, TempB );
+                MaxB = VectorMax( MaxB, TempB );
+            }
+
+            // if (MinA > MaxB || MinB > MaxA) reject
+            Outside = VectorOrInt( Outside, VectorGreater( MinA, MaxB ) );
+            Outside = VectorOrInt( Outside, VectorGreater( MinB, MaxA ) );
+        }
+    }
+
+    // If there is a seperating plane, then the frustums do not intersect.
+    if ( Vector4EqualInt( Outside, VectorTrueInt() ) )
+        return 0;
+
+    // If we did not find a separating plane then the frustums intersect.
+    return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL void FastIntersectTrianglePlane( CVec V0, CVec V1, CVec V2, CVec Plane,
+                                            Vec& Outside, Vec& Inside )
+{
+    // Plane0
+    Vec Dist0 = Vector4Dot( V0, Plane );
+    Vec Dist1 = Vector4Dot( V1, Plane );
+    Vec Dist2 = Vector4Dot( V2, Plane );
+
+    Vec MinDist = VectorMin( Dist0, Dist1 );
+    MinDist = VectorMin( MinDist, Dist2 );
+
+    Vec MaxDist = VectorMax( Dist0, Dist1 );
+    MaxDist = VectorMax( MaxDist, Dist2 );
+
+    Vec Zero = VectorZero();
+
+    // Outside the plane?
+    Outside = VectorGreater( MinDist, Zero );
+
+    // Fully inside the plane?
+    Inside = VectorLess( MaxDist, Zero );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Test a triangle vs 6 planes (typically forming a frustum).
+// Return values: 0 = no intersection, 
+//                1 = may be intersecting, 
+//                2 = triangle is inside all planes
+//-----------------------------------------------------------------------------
+XNA_KERNEL int IntersectTriangle6Planes( CVec V0, CVec V1, CVec V2, CVec Plane0, CVec Plane1,
+                                         CVec Plane2, CVec Plane3, CVec Plane4, CVec Plane5 )
+{
+    Vec One = VectorSplatOne();
+
+    // Set w of the points to one so we can dot4 with a plane.
+    Vec TV0 = VectorInsert(V0, One, 0, 0, 0, 0, 1);
+    Vec TV1 = VectorInsert(V1, One, 0, 0, 0, 0, 1);
+    Vec TV2 = VectorInsert(V2, One, 0, 0, 0, 0, 1);
+
+    Vec Outside, Inside;
+
+    // Test against each plane.
+    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane0, Outside, Inside );
+
+    Vec AnyOutside = Outside;
+    Vec AllInside = Inside;
+
+    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane1, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane2, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane3, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane4, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane5, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    // If the triangle is outside any plane it is outside.
+    if ( Vector4EqualInt( AnyOutside, VectorTrueInt() ) )
+        return 0;
+
+    // If the triangle is inside all planes it is inside.
+    if ( Vector4EqualInt( AllInside, VectorTrueInt() ) )
+        return 2;
+
+    // The triangle is not inside all planes or outside a plane, it may intersect.
+    return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL void FastIntersectSpherePlane( CVec Center, CVec Radius, CVec Plane,
+                                          Vec& Outside, Vec& Inside )
+{
+    Vec Dist = Vector4Dot( Center, Plane );
+
+    // Outside the plane?
+    Outside = VectorGreater( Dist, Radius );
+
+    // Fully inside the plane?
+    Inside = VectorLess( Dist, -Radius );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Test a sphere vs 6 planes (typically forming a frustum).
+// Return values: 0 = no intersection, 
+//                1 = may be intersecting, 
+//                2 = sphere is inside all planes
+//-----------------------------------------------------------------------------
+XNA_KERNEL int IntersectSphere6Planes( const Sphere* pVolume, CVec Plane0, CVec Plane1, CVec Plane2,
+                                       CVec Plane3, CVec Plane4, CVec Plane5 )
+{
+    assert( pVolume );
+
+    // Load the sphere.
+    Vec Center = LoadFloat3( &pVolume->Center );
+    Vec Radius = VectorReplicatePtr( &pVolume->Radius );
+
+    // Set w of the center to one so we can dot4 with a plane.
+    Center = VectorInsert( Center, VectorSplatOne(), 0, 0, 0, 0, 1);
+
+    Vec Outside, Inside;
+
+    // Test against each plane.
+    FastIntersectSpherePlane( Center, Radius, Plane0, Outside, Inside );
+
+    Vec AnyOutside = Outside;
+    Vec AllInside = Inside;
+
+    FastIntersectSpherePlane( Center, Radius, Plane1, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectSpherePlane( Center, Radius, Plane2, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectSpherePlane( Center, Radius, Plane3, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectSpherePlane( Center, Radius, Plane4, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectSpherePlane( Center, Radius, Plane5, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    // If the sphere is outside any plane it is outside.
+    if ( Vector4EqualInt( AnyOutside, VectorTrueInt() ) )
+        return 0;
+
+    // If the sphere is inside all planes it is inside.
+    if ( Vector4EqualInt( AllInside, VectorTrueInt() ) )
+        return 2;
+
+    // The sphere is not inside all planes or outside a plane, it may intersect.
+    return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL void FastIntersectAxisAlignedBoxPlane( CVec Center, CVec Extents, CVec Plane,
+                                                  Vec& Outside, Vec& Inside )
+{
+    // Compute the distance to the center of the box.
+    Vec Dist = Vector4Dot( Center, Plane );
+
+    // Project the axes of the box onto the normal of the plane.  Half the
+    // length of the projection (sometime called the "radius") is equal to
+    // h(u) * abs(n dot b(u))) + h(v) * abs(n dot b(v)) + h(w) * abs(n dot b(w))
+    // where h(i) are extents of the box, n is the plane normal, and b(i) are the 
+    // axes of the box. In this case b(i) = [(1,0,0), (0,1,0), (0,0,1)].
+    Vec Radius = Vector3Dot( Extents, VectorAbs( Plane ) );
+
+    // Outside the plane?
+    Outside = VectorGreater( Dist, Radius );
+
+    // Fully inside the plane?
+    Inside = VectorLess( Dist, -Radius );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Test an axis alinged box vs 6 planes (typically forming a frustum).
+// Return values: 0 = no intersection, 
+//                1 = may be intersecting, 
+//                2 = box is inside all planes
+//-----------------------------------------------------------------------------
+XNA_KERNEL int IntersectAxisAlignedBox6Planes( const AxisAlignedBox* pVolume, CVec Plane0, CVec Plane1,
+                                               CVec Plane2, CVec Plane3, CVec Plane4, CVec Plane5 )
+{
+    assert( pVolume );
+
+    // Load the box.
+    Vec Center = LoadFloat3( &pVolume->Center );
+    Vec Extents = LoadFloat3( &pVolume->Extents );
+
+    // Set w of the center to one so we can dot4 with a plane.
+    Center = VectorInsert( Center, VectorSplatOne(), 0, 0, 0, 0, 1 );
+
+    Vec Outside, Inside;
+
+    // Test against each plane.
+    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane0, Outside, Inside );
+
+    Vec AnyOutside = Outside;
+    Vec AllInside = Inside;
+
+    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane1, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane2, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane3, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane4, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane5, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    // If the box is outside any plane it is outside.
+    if ( Vector4EqualInt( AnyOutside, VectorTrueInt() ) )
+        return 0;
+
+    // If the box is inside all planes it is inside.
+    if ( Vector4EqualInt( AllInside, VectorTrueInt() ) )
+        return 2;
+
+    // The box is not inside all planes or outside a plane, it may intersect.
+    return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL void FastIntersectOrientedBoxPlane( CVec Center, CVec Extents, CVec Axis0, CVec Axis1,
+                                               CVec Axis2, CVec Plane, Vec& Outside, Vec& Inside )
+{
+    // Compute the distance to the center of the box.
+    Vec Dist = Vector4Dot( Center, Plane );
+
+    // Project the axes of the box onto the normal of the plane.  Half the
+    // length of the projection (sometime called the "radius") is equal to
+    // h(u) * abs(n dot b(u))) + h(v) * abs(n dot b(v)) + h(w) * abs(n dot b(w))
+    // where h(i) are extents of the box, n is the plane normal, and b(i) are the 
+    // axes of the box.
+    Vec Radius = Vector3Dot( Plane, Axis0 );
+    Radius = VectorInsert( Radius, Vector3Dot( Plane, Axis1 ), 0, 0, 1, 0, 0 );
+    Radius = VectorInsert( Radius, Vector3Dot( Plane, Axis2 ), 0, 0, 0, 1, 0 );
+    Radius = Vector3Dot( Extents, VectorAbs( Radius ) );
+
+    // Outside the plane?
+    Outside = VectorGreater( Dist, Radius );
+
+    // Fully inside the plane?
+    Inside = VectorLess( Dist, -Radius );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Test an oriented box vs 6 planes (typically forming a frustum).
+// Return values: 0 = no intersection, 
+//                1 = may be intersecting, 
+//                2 = box is inside all planes
+//-----------------------------------------------------------------------------
+XNA_KERNEL int IntersectOrientedBox6Planes( const OrientedBox* pVolume, CVec Plane0, CVec Plane1, CVec Plane2,
+                                            CVec Plane3, CVec Plane4, CVec Plane5 )
+{
+    assert( pVolume );
+
+    // Load the box.
+    Vec Center = LoadFloat3( &pVolume->Center );
+    Vec Extents = LoadFloat3( &pVolume->Extents );
+    Vec BoxOrientation = LoadFloat4( &pVolume->Orientation );
+
+    assert( QuaternionIsUnit( BoxOrientation ) );
+
+    // Set w of the center to one so we can dot4 with a plane.
+    Center = VectorInsert( Center, VectorSplatOne(), 0, 0, 0, 0, 1 );
+
+    // Build the 3x3 rotation matrix that defines the box axes.
+    VMatrix R = MatrixRotationQuaternion( BoxOrientation );
+
+    Vec Outside, Inside;
+
+    // Test against each plane.
+    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane0, Outside, Inside );
+
+    Vec AnyOutside = Outside;
+    Vec AllInside = Inside;
+
+    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane1, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane2, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane3, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane4, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane5, Outside, Inside );
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    // If the box is outside any plane it is outside.
+    if ( Vector4EqualInt( AnyOutside, VectorTrueInt() ) )
+        return 0;
+
+    // If the box is inside all planes it is inside.
+    if ( Vector4EqualInt( AllInside, VectorTrueInt() ) )
+        return 2;
+
+    // The box is not inside all planes or outside a plane, it may intersect.
+    return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL void FastIntersectFrustumPlane( CVec Point0, CVec Point1, CVec Point2, CVec Point3,
+                                           CVec Point4, CVec Point5, CVec Point6, CVec Point7,
+                                           CVec Plane, Vec& Outside, Vec& Inside )
+{
+    // Find the min/max projection of the frustum onto the plane normal.
+    Vec Min, Max, Dist;
+
+    Min = Max = Vector3Dot( Plane, Point0 );
+
+    Dist = Vector3Dot( Plane, Point1 );
+    Min = VectorMin( Min, Dist );
+    Max = VectorMax( Max, Dist );
+
+    Dist = Vector3Dot( Plane, Point2 );
+    Min = VectorMin( Min, Dist );
+    Max = VectorMax( Max, Dist );
+
+    Dist = Vector3Dot( Plane, Point3 );
+    Min = VectorMin( Min, Dist );
+    Max = VectorMax( Max, Dist );
+
+    Dist = Vector3Dot( Plane, Point4 );
+    Min = VectorMin( Min, Dist );
+    Max = VectorMax( Max, Dist );
+
+    Dist = Vector3Dot( Plane, Point5 );
+    Min = VectorMin( Min, Dist );
+    Max = VectorMax( Max, Dist );
+
+    Dist = Vector3Dot( Plane, Point6 );
+    Min = VectorMin( Min, Dist );
+    Max = VectorMax( Max, Dist );
+
+    Dist = Vector3Dot( Plane, Point7 );
+    Min = VectorMin( Min, Dist );
+    Max = VectorMax( Max, Dist );
+
+    Vec PlaneDist = -VectorSplatW( Plane );
+
+    // Outside the plane?
+    Outside = VectorGreater( Min, PlaneDist );
+
+    // Fully inside the plane?
+    Inside = VectorLess( Max, PlaneDist );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Test a frustum vs 6 planes (typically forming another frustum).
+// Return values: 0 = no intersection, 
+//                1 = may be intersecting, 
+//                2 = frustum is inside all planes
+//-----------------------------------------------------------------------------
+XNA_KERNEL int IntersectFrustum6Planes( const Frustum* pVolume, CVec Plane0, CVec Plane1, CVec Plane2,
+                                        CVec Plane3, CVec Plane4, CVec Plane5 )
+{
+    assert( pVolume );
+
+    // Load origin and orientation of the frustum.
+    Vec Origin = LoadFloat3( &pVolume->Origin );
+    Vec Orientation = LoadFloat4( &pVolume->Orientation );
+
+    assert( QuaternionIsUnit( Orientation ) );
+
+    // Set w of the origin to one so we can dot4 with a plane.
+    Origin = VectorInsert( Origin, VectorSplatOne(), 0, 0, 0, 0, 1 );
+
+    // Build the corners of the frustum (in world space).
+    Vec RightTop = VectorSet( pVolume->RightSlope, pVolume->TopSlope, 1.0f, 0.0f );
+    Vec RightBottom = VectorSet( pVolume->RightSlope, pVolume->BottomSlope, 1.0f, 0.0f );
+    Vec LeftTop = VectorSet( pVolume->LeftSlope, pVolume->TopSlope, 1.0f, 0.0f );
+    Vec LeftBottom = VectorSet( pVolume->LeftSlope, pVolume->BottomSlope, 1.0f, 0.0f );
+    Vec Near = VectorSet( pVolume->Near, pVolume->Near, pVolume->Near, 0.0f );
+    Vec Far = VectorSet( pVolume->Far, pVolume->Far, pVolume->Far, 0.0f );
+
+    RightTop = Vector3Rotate( RightTop, Orientation );
+    RightBottom = Vector3Rotate( RightBottom, Orientation );
+    LeftTop = Vector3Rotate( LeftTop, Orientation );
+    LeftBottom = Vector3Rotate( LeftBottom, Orientation );
+
+    Vec Corners0 = Origin + RightTop * Near;
+    Vec Corners1 = Origin + RightBottom * Near;
+    Vec Corners2 = Origin + LeftTop * Near;
+    Vec Corners3 = Origin + LeftBottom * Near;
+    Vec Corners4 = Origin + RightTop * Far;
+    Vec Corners5 = Origin + RightBottom * Far;
+    Vec Corners6 = Origin + LeftTop * Far;
+    Vec Corners7 = Origin + LeftBottom * Far;
+
+    Vec Outside, Inside;
+
+    // Test against each plane.
+    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
+                               Corners4, Corners5, Corners6, Corners7, 
+                               Plane0, Outside, Inside );
+
+    Vec AnyOutside = Outside;
+    Vec AllInside = Inside;
+
+    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
+                               Corners4, Corners5, Corners6, Corners7, 
+                               Plane1, Outside, Inside );
+
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
+                               Corners4, Corners5, Corners6, Corners7, 
+                               Plane2, Outside, Inside );
+
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
+                               Corners4, Corners5, Corners6, Corners7, 
+                               Plane3, Outside, Inside );
+
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
+                               Corners4, Corners5, Corners6, Corners7, 
+                               Plane4, Outside, Inside );
+
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
+                               Corners4, Corners5, Corners6, Corners7, 
+                               Plane5, Outside, Inside );
+
+    AnyOutside = VectorOrInt( AnyOutside, Outside );
+    AllInside = VectorAndInt( AllInside, Inside );
+
+    // If the frustum is outside any plane it is outside.
+    if ( Vector4EqualInt( AnyOutside, VectorTrueInt() ) )
+        return 0;
+
+    // If the frustum is inside all planes it is inside.
+    if ( Vector4EqualInt( AllInside, VectorTrueInt() ) )
+        return 2;
+
+    // The frustum is not inside all planes or outside a plane, it may intersect.
+    return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL int IntersectTrianglePlane( CVec V0, CVec V1, CVec V2, CVec Plane )
+{
+    Vec One = VectorSplatOne();
+
+    assert( PlaneIsUnit( Plane ) );
+
+    // Set w of the points to one so we can dot4 with a plane.
+    Vec TV0 = VectorInsert(V0, One, 0, 0, 0, 0, 1);
+    Vec TV1 = VectorInsert(V1, One, 0, 0, 0, 0, 1);
+    Vec TV2 = VectorInsert(V2, One, 0, 0, 0, 0, 1);
+
+    Vec Outside, Inside;
+    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane, Outside, Inside );
+
+    // If the triangle is outside any plane it is outside.
+    if ( Vector4EqualInt( Outside, VectorTrueInt() ) )
+        return 0;
+
+    // If the triangle is inside all planes it is inside.
+    if ( Vector4EqualInt( Inside, VectorTrueInt() ) )
+        return 2;
+
+    // The triangle is not inside all planes or outside a plane it intersects.
+    return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL int IntersectSpherePlane( const Sphere* pVolume, CVec Plane )
+{
+    assert( pVolume );
+    assert( PlaneIsUnit( Plane ) );
+
+    // Load the sphere.
+    Vec Center = LoadFloat3( &pVolume->Center );
+    Vec Radius = VectorReplicatePtr( &pVolume->Radius );
+
+    // Set w of the center to one so we can dot4 with a plane.
+    Center = VectorInsert( Center, VectorSplatOne(), 0, 0, 0, 0, 1 );
+
+    Vec Outside, Inside;
+    FastIntersectSpherePlane( Center, Radius, Plane, Outside, Inside );
+
+    // If the sphere is outside any plane it is outside.
+    if ( Vector4EqualInt( Outside, VectorTrueInt() ) )
+        return 0;
+
+    // If the sphere is inside all planes it is inside.
+    if ( Vector4EqualInt( Inside, VectorTrueInt() ) )
+        return 2;
+
+    // The sphere is not inside all planes or outside a plane it intersects.
+    return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL int IntersectAxisAlignedBoxPlane( const AxisAlignedBox* pVolume, CVec Plane )
+{
+    assert( pVolume );
+    assert( PlaneIsUnit( Plane ) );
+
+    // Load the box.
+    Vec Center = LoadFloat3( &pVolume->Center );
+    Vec Extents = LoadFloat3( &pVolume->Extents );
+
+    // Set w of the center to one so we can dot4 with a plane.
+    Center = VectorInsert( Center, VectorSplatOne(), 0, 0, 0, 0, 1);
+
+    Vec Outside, Inside;
+    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane, Outside, Inside );
+
+    // If the box is outside any plane it is outside.
+    if ( Vector4EqualInt( Outside, VectorTrueInt() ) )
+        return 0;
+
+    // If the box is inside all planes it is inside.
+    if ( Vector4EqualInt( Inside, VectorTrueInt() ) )
+        return 2;
+
+    // The box is not inside all planes or outside a plane it intersects.
+    return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL int IntersectOrientedBoxPlane( const OrientedBox* pVolume, CVec Plane )
+{
+    assert( pVolume );
+    assert( PlaneIsUnit( Plane ) );
+
+    // Load the box.
+    Vec Center = LoadFloat3( &pVolume->Center );
+    Vec Extents = LoadFloat3( &pVolume->Extents );
+    Vec BoxOrientation = LoadFloat4( &pVolume->Orientation );
+
+    assert( QuaternionIsUnit( BoxOrientation ) );
+
+    // Set w of the center to one so we can dot4 with a plane.
+    Center = VectorInsert( Center, VectorSplatOne(), 0, 0, 0, 0, 1);
+
+    // Build the 3x3 rotation matrix that defines the box axes.
+    VMatrix R = MatrixRotationQuaternion( BoxOrientation );
+
+    Vec Outside, Inside;
+    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane, Outside, Inside );
+
+    // If the box is outside any plane it is outside.
+    if ( Vector4EqualInt( Outside, VectorTrueInt() ) )
+        return 0;
+
+    // If the box is inside all planes it is inside.
+    if ( Vector4EqualInt( Inside, VectorTrueInt() ) )
+        return 2;
+
+    // The box is not inside all planes or outside a plane it intersects.
+    return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+XNA_KERNEL int IntersectFrustumPlane( const Frustum* pVolume, CVec Plane )
+{
+    assert( pVolume );
+    assert( PlaneIsUnit( Plane ) );
+
+    // Load origin and orientation of the frustum.
+    Vec Origin = LoadFloat3( &pVolume->Origin );
+    Vec Orientation = LoadFloat4( &pVolume->Orientation );
+
+    assert( QuaternionIsUnit( Orientation ) );
+
+    // Set w of the origin to one so we can dot4 with a plane.
+    Origin = VectorInsert( Origin, VectorSplatOne(), 0, 0, 0, 0, 1);
+
+    // Build the corners of the frustum (in world space).
+    Vec RightTop = VectorSet( pVolume->RightSlope, pVolume->TopSlope, 1.0f, 0.0f );
+    Vec RightBottom = VectorSet( pVolume->RightSlope, pVolume->BottomSlope, 1.0f, 0.0f );
+    Vec LeftTop = VectorSet( pVolume->LeftSlope, pVolume->TopSlope, 1.0f, 0.0f );
+    Vec LeftBottom = VectorSet( pVolume->LeftSlope, pVolume->BottomSlope, 1.0f, 0.0f );
+    Vec Near = VectorSet( pVolume->Near, pVolume->Near, pVolume->Near, 0.0f );
+    Vec Far = VectorSet( pVolume->Far, pVolume->Far, pVolume->Far, 0.0f );
+
+    RightTop = Vector3Rotate( RightTop, Orientation );
+    RightBottom = Vector3Rotate( RightBottom, Orientation );
+    LeftTop = Vector3Rotate( LeftTop, Orientation );
+    LeftBottom = Vector3Rotate( LeftBottom, Orientation );
+
+    Vec Corners0 = Origin + RightTop * Near;
+    Vec Corners1 = Origin + RightBottom * Near;
+    Vec Corners2 = Origin + LeftTop * Near;
+    Vec Corners3 = Origin + LeftBottom * Near;
+    Vec Corners4 = Origin + RightTop * Far;
+    Vec Corners5 = Origin + RightBottom * Far;
+    Vec Corners6 = Origin + LeftTop * Far;
+    Vec Corners7 = Origin + LeftBottom * Far;
+
+    Vec Outside, Inside;
+    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
+                               Corners4, Corners5, Corners6, Corners7, 
+                               Plane, Outside, Inside );
+
+    // If the frustum is outside any plane it is outside.
+    if ( Vector4EqualInt( Outside, VectorTrueInt() ) )
+        return 0;
+
+    // If the frustum is inside all planes it is inside.
+    if ( Vector4EqualInt( Inside, VectorTrueInt() ) )
+        return 2;
+
+    // The frustum is not inside all planes or outside a plane it intersects.
+    return 1;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// Entry points with the public signatures, for the dispatch table.
+//-----------------------------------------------------------------------------
+XNA_KERNEL_TARGET static void EntryComputeBoundingSphereFromPoints( Sphere* pOut, uint32 Count,
+                                                                    const Float3* pPoints, uint32 Stride )
+{
+    Backend::ComputeBoundingSphereFromPoints( pOut, Count, pPoints, Stride );
+}
+
+XNA_KERNEL_TARGET static void EntryComputeBoundingAxisAlignedBoxFromPoints( AxisAlignedBox* pOut, uint32 Count,
+                                                                            const Float3* pPoints, uint32 Stride )
+{
+    Backend::ComputeBoundingAxisAlignedBoxFromPoints( pOut, Count, pPoints, Stride );
+}
+
+XNA_KERNEL_TARGET static void EntryComputeBoundingOrientedBoxFromPoints( OrientedBox* pOut, uint32 Count,
+                                                                         const Float3* pPoints, uint32 Stride )
+{
+    Backend::ComputeBoundingOrientedBoxFromPoints( pOut, Count, pPoints, Stride );
+}
+
+XNA_KERNEL_TARGET static void EntryComputeFrustumFromProjection( Frustum* pOut, const Matrix* pProjection )
+{
+    VMatrix Projection = LoadMatrix( pProjection );
+    Backend::ComputeFrustumFromProjection( pOut, &Projection );
+}
+
+XNA_KERNEL_TARGET static void EntryComputePlanesFromFrustum( const Frustum* pVolume, Float4* pPlane0,
+                                                             Float4* pPlane1, Float4* pPlane2, Float4* pPlane3,
+                                                             Float4* pPlane4, Float4* pPlane5 )
+{
+    Vec Plane0;
+    Vec Plane1;
+    Vec Plane2;
+    Vec Plane3;
+    Vec Plane4;
+    Vec Plane5;
+    Backend::ComputePlanesFromFrustum( pVolume, &Plane0, &Plane1, &Plane2, &Plane3, &Plane4, &Plane5 );
+    StoreFloat4( pPlane0, Plane0 );
+    StoreFloat4( pPlane1, Plane1 );
+    StoreFloat4( pPlane2, Plane2 );
+    StoreFloat4( pPlane3, Plane3 );
+    StoreFloat4( pPlane4, Plane4 );
+    StoreFloat4( pPlane5, Plane5 );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectPointSphere( const Float4& Point, const Sphere* pVolume )
+{
+    return Backend::IntersectPointSphere( LoadFloat4( &Point ), pVolume );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectPointAxisAlignedBox( const Float4& Point,
+                                                                 const AxisAlignedBox* pVolume )
+{
+    return Backend::IntersectPointAxisAlignedBox( LoadFloat4( &Point ), pVolume );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectPointOrientedBox( const Float4& Point, const OrientedBox* pVolume )
+{
+    return Backend::IntersectPointOrientedBox( LoadFloat4( &Point ), pVolume );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectPointFrustum( const Float4& Point, const Frustum* pVolume )
+{
+    return Backend::IntersectPointFrustum( LoadFloat4( &Point ), pVolume );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectRayTriangle( const Float4& Origin, const Float4& Direction,
+                                                         const Float4& V0, const Float4& V1, const Float4& V2,
+                                                         float* pDist )
+{
+    return Backend::IntersectRayTriangle( LoadFloat4( &Origin ), LoadFloat4( &Direction ), LoadFloat4( &V0 ), LoadFloat4( &V1 ), LoadFloat4( &V2 ), pDist );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectRaySphere( const Float4& Origin, const Float4& Direction,
+                                                       const Sphere* pVolume, float* pDist )
+{
+    return Backend::IntersectRaySphere( LoadFloat4( &Origin ), LoadFloat4( &Direction ), pVolume, pDist );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectRayAxisAlignedBox( const Float4& Origin, const Float4& Direction,
+                                                               const AxisAlignedBox* pVolume, float* pDist )
+{
+    return Backend::IntersectRayAxisAlignedBox( LoadFloat4( &Origin ), LoadFloat4( &Direction ), pVolume, pDist );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectRayOrientedBox( const Float4& Origin, const Float4& Direction,
+                                                            const OrientedBox* pVolume, float* pDist )
+{
+    return Backend::IntersectRayOrientedBox( LoadFloat4( &Origin ), LoadFloat4( &Direction ), pVolume, pDist );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectTriangleTriangle( const Float4& A0, const Float4& A1, const Float4& A2,
+                                                              const Float4& B0, const Float4& B1, const Float4& B2 )
+{
+    return Backend::IntersectTriangleTriangle( LoadFloat4( &A0 ), LoadFloat4( &A1 ), LoadFloat4( &A2 ), LoadFloat4( &B0 ), LoadFloat4( &B1 ), LoadFloat4( &B2 ) );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectTriangleSphere( const Float4& V0, const Float4& V1, const Float4& V2,
+                                                            const Sphere* pVolume )
+{
+    return Backend::IntersectTriangleSphere( LoadFloat4( &V0 ), LoadFloat4( &V1 ), LoadFloat4( &V2 ), pVolume );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectTriangleAxisAlignedBox( const Float4& V0, const Float4& V1,
+                                                                    const Float4& V2,
+                                                                    const AxisAlignedBox* pVolume )
+{
+    return Backend::IntersectTriangleAxisAlignedBox( LoadFloat4( &V0 ), LoadFloat4( &V1 ), LoadFloat4( &V2 ), pVolume );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectTriangleOrientedBox( const Float4& V0, const Float4& V1,
+                                                                 const Float4& V2, const OrientedBox* pVolume )
+{
+    return Backend::IntersectTriangleOrientedBox( LoadFloat4( &V0 ), LoadFloat4( &V1 ), LoadFloat4( &V2 ), pVolume );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectSphereSphere( const Sphere* pVolumeA, const Sphere* pVolumeB )
+{
+    return Backend::IntersectSphereSphere( pVolumeA, pVolumeB );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectSphereAxisAlignedBox( const Sphere* pVolumeA,
+                                                                  const AxisAlignedBox* pVolumeB )
+{
+    return Backend::IntersectSphereAxisAlignedBox( pVolumeA, pVolumeB );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectSphereOrientedBox( const Sphere* pVolumeA, const OrientedBox* pVolumeB )
+{
+    return Backend::IntersectSphereOrientedBox( pVolumeA, pVolumeB );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectAxisAlignedBoxAxisAlignedBox( const AxisAlignedBox* pVolumeA,
+                                                                          const AxisAlignedBox* pVolumeB )
+{
+    return Backend::IntersectAxisAlignedBoxAxisAlignedBox( pVolumeA, pVolumeB );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectAxisAlignedBoxOrientedBox( const AxisAlignedBox* pVolumeA,
+                                                                       const OrientedBox* pVolumeB )
+{
+    return Backend::IntersectAxisAlignedBoxOrientedBox( pVolumeA, pVolumeB );
+}
+
+XNA_KERNEL_TARGET static bool EntryIntersectOrientedBoxOrientedBox( const OrientedBox* pVolumeA,
+                                                                    const OrientedBox* pVolumeB )
+{
+    return Backend::IntersectOrientedBoxOrientedBox( pVolumeA, pVolumeB );
+}
+
+XNA_KERNEL_TARGET static int EntryIntersectTriangleFrustum( const Float4& V0, const Float4& V1, const Float4& V2,
+                                                            const Frustum* pVolume )
+{
+    return Backend::IntersectTriangleFrustum( LoadFloat4( &V0 ), LoadFloat4( &V1 ), LoadFloat4( &V2 ), pVolume );
+}
+
+XNA_KERNEL_TARGET static int EntryIntersectSphereFrustum( const Sphere* pVolumeA, const Frustum* pVolumeB )
+{
+    return Backend::IntersectSphereFrustum( pVolumeA, pVolumeB );
+}
+
+XNA_KERNEL_TARGET static int EntryIntersectAxisAlignedBoxFrustum( const AxisAlignedBox* pVolumeA,
+                                                                  const Frustum* pVolumeB )
+{
+    return Backend::IntersectAxisAlignedBoxFrustum( pVolumeA, pVolumeB );
+}
+
+XNA_KERNEL_TARGET static int EntryIntersectOrientedBoxFrustum( const OrientedBox* pVolumeA,
+                                                               const Frustum* pVolumeB )
+{
+    return Backend::IntersectOrientedBoxFrustum( pVolumeA, pVolumeB );
+}
+
+XNA_KERNEL_TARGET static int EntryIntersectFrustumFrustum( const Frustum* pVolumeA, const Frustum* pVolumeB )
+{
+    return Backend::IntersectFrustumFrustum( pVolumeA, pVolumeB );
+}
+
+XNA_KERNEL_TARGET static int EntryIntersectTriangle6Planes( const Float4& V0, const Float4& V1, const Float4& V2,
+                                                            const Float4& Plane0, const Float4& Plane1,
+                                                            const Float4& Plane2, const Float4& Plane3,
+                                                            const Float4& Plane4, const Float4& Plane5 )
+{
+    return Backend::IntersectTriangle6Planes( LoadFloat4( &V0 ), LoadFloat4( &V1 ), LoadFloat4( &V2 ), LoadFloat4( &Plane0 ), LoadFloat4( &Plane1 ), LoadFloat4( &Plane2 ), LoadFloat4( &Plane3 ), LoadFloat4( &Plane4 ), LoadFloat4( &Plane5 ) );
+}
+
+XNA_KERNEL_TARGET static int EntryIntersectSphere6Planes( const Sphere* pVolume, const Float4& Plane0,
+                                                          const Float4& Plane1, const Float4& Plane2,
+                                                          const Float4& Plane3, const Float4& Plane4,
+                                                          const Float4& Plane5 )
+{
+    return Backend::IntersectSphere6Planes( pVolume, LoadFloat4( &Plane0 ), LoadFloat4( &Plane1 ), LoadFloat4( &Plane2 ), LoadFloat4( &Plane3 ), LoadFloat4( &Plane4 ), LoadFloat4( &Plane5 ) );
+}
+
+XNA_KERNEL_TARGET static int EntryIntersectAxisAlignedBox6Planes( const AxisAlignedBox* pVolume,
+                                                                  const Float4& Plane0, const Float4& Plane1,
+                                                                  const Float4& Plane2, const Float4& Plane3,
+                                                                  const Float4& Plane4, const Float4& Plane5 )
+{
+    return Backend::IntersectAxisAlignedBox6Planes( pVolume, LoadFloat4( &Plane0 ), LoadFloat4( &Plane1 ), LoadFloat4( &Plane2 ), LoadFloat4( &Plane3 ), LoadFloat4( &Plane4 ), LoadFloat4( &Plane5 ) );
+}
+
+XNA_KERNEL_TARGET static int EntryIntersectOrientedBox6Planes( const OrientedBox* pVolume, const Float4& Plane0,
+                                                               const Float4& Plane1, const Float4& Plane2,
+                                                               const Float4& Plane3, const Float4& Plane4,
+                                                               const Float4& Plane5 )
+{
+    return Backend::IntersectOrientedBox6Planes( pVolume, LoadFloat4( &Plane0 ), LoadFloat4( &Plane1 ), LoadFloat4( &Plane2 ), LoadFloat4( &Plane3 ), LoadFloat4( &Plane4 ), LoadFloat4( &Plane5 ) );
+}
+
+XNA_KERNEL_TARGET static int EntryIntersectFrustum6Planes( const Frustum* pVolume, const Float4& Plane0,
+                                                           const Float4& Plane1, const Float4& Plane2,
+                                                           const Float4& Plane3, const Float4& Plane4,
+                                                           const Float4& Plane5 )
+{
+    return Backend::IntersectFrustum6Planes( pVolume, LoadFloat4( &Plane0 ), LoadFloat4( &Plane1 ), LoadFloat4( &Plane2 ), LoadFloat4( &Plane3 ), LoadFloat4( &Plane4 ), LoadFloat4( &Plane5 ) );
+}
+
+XNA_KERNEL_TARGET static int EntryIntersectTrianglePlane( const Float4& V0, const Float4& V1, const Float4& V2,
+                                                          const Float4& Plane )
+{
+    return Backend::IntersectTrianglePlane( LoadFloat4( &V0 ), LoadFloat4( &V1 ), LoadFloat4( &V2 ), LoadFloat4( &Plane ) );
+}
+
+XNA_KERNEL_TARGET static int EntryIntersectSpherePlane( const Sphere* pVolume, const Float4& Plane )
+{
+    return Backend::IntersectSpherePlane( pVolume, LoadFloat4( &Plane ) );
+}
+
+XNA_KERNEL_TARGET static int EntryIntersectAxisAlignedBoxPlane( const AxisAlignedBox* pVolume, const Float4& Plane )
+{
+    return Backend::IntersectAxisAlignedBoxPlane( pVolume, LoadFloat4( &Plane ) );
+}
+
+XNA_KERNEL_TARGET static int EntryIntersectOrientedBoxPlane( const OrientedBox* pVolume, const Float4& Plane )
+{
+    return Backend::IntersectOrientedBoxPlane( pVolume, LoadFloat4( &Plane ) );
+}
+
+XNA_KERNEL_TARGET static int EntryIntersectFrustumPlane( const Frustum* pVolume, const Float4& Plane )
+{
+    return Backend::IntersectFrustumPlane( pVolume, LoadFloat4( &Plane ) );
+}
+
+static const KernelTable Kernels =
+{
+    EntryComputeBoundingSphereFromPoints,
+    EntryComputeBoundingAxisAlignedBoxFromPoints,
+    EntryComputeBoundingOrientedBoxFromPoints,
+    EntryComputeFrustumFromProjection,
+    EntryComputePlanesFromFrustum,
+    EntryIntersectPointSphere,
+    EntryIntersectPointAxisAlignedBox,
+    EntryIntersectPointOrientedBox,
+    EntryIntersectPointFrustum,
+    EntryIntersectRayTriangle,
+    EntryIntersectRaySphere,
+    EntryIntersectRayAxisAlignedBox,
+    EntryIntersectRayOrientedBox,
+    EntryIntersectTriangleTriangle,
+    EntryIntersectTriangleSphere,
+    EntryIntersectTriangleAxisAlignedBox,
+    EntryIntersectTriangleOrientedBox,
+    EntryIntersectSphereSphere,
+    EntryIntersectSphereAxisAlignedBox,
+    EntryIntersectSphereOrientedBox,
+    EntryIntersectAxisAlignedBoxAxisAlignedBox,
+    EntryIntersectAxisAlignedBoxOrientedBox,
+    EntryIntersectOrientedBoxOrientedBox,
+    EntryIntersectTriangleFrustum,
+    EntryIntersectSphereFrustum,
+    EntryIntersectAxisAlignedBoxFrustum,
+    EntryIntersectOrientedBoxFrustum,
+    EntryIntersectFrustumFrustum,
+    EntryIntersectTriangle6Planes,
+    EntryIntersectSphere6Planes,
+    EntryIntersectAxisAlignedBox6Planes,
+    EntryIntersectOrientedBox6Planes,
+    EntryIntersectFrustum6Planes,
+    EntryIntersectTrianglePlane,
+    EntryIntersectSpherePlane,
+    EntryIntersectAxisAlignedBoxPlane,
+    EntryIntersectOrientedBoxPlane,
+    EntryIntersectFrustumPlane
+};
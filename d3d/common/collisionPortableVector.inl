@@ -0,0 +1,677 @@
+//---------------------------------------------------------------------------------------
+//
+// Vector layer of the portable collision routines.
+//
+// Included by collisionPortable.cpp inside each backend namespace, with XNA_KERNEL
+// set to the function prefix of the backend (static inline and its target). With
+// XNA_PORTABLE_SSE defined the lanes are a __m128, otherwise four floats.
+//
+// The first part is the handful of lane-wise primitives that differ between the
+// backends. The rest builds the XNAMath functions used by xnacollision on top of
+// them, under the same names without the XM prefix, so the routines read like the
+// originals. Horizontal sums always add in the same order, and the matrix helpers
+// work on plain floats, so every backend computes exactly the same values.
+//
+//---------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Primitives.
+//-----------------------------------------------------------------------------
+#if defined(XNA_PORTABLE_SSE)
+
+struct Vec
+{
+    __m128 v;
+};
+
+// Vectors are passed by reference, MSVC cannot pass aligned types by value on x86.
+typedef const Vec& CVec;
+
+XNA_KERNEL Vec VWrap( __m128 v )
+{
+    Vec Result;
+    Result.v = v;
+    return Result;
+}
+
+XNA_KERNEL Vec VSet( float x, float y, float z, float w ) { return VWrap( _mm_setr_ps( x, y, z, w ) ); }
+XNA_KERNEL Vec VSetInt( uint32 x, uint32 y, uint32 z, uint32 w )
+{
+    return VWrap( _mm_castsi128_ps( _mm_setr_epi32( ( int )x, ( int )y, ( int )z, ( int )w ) ) );
+}
+XNA_KERNEL Vec VLoad4( const float* p ) { return VWrap( _mm_loadu_ps( p ) ); }
+XNA_KERNEL void VStore4( float* p, CVec a ) { _mm_storeu_ps( p, a.v ); }
+XNA_KERNEL float VGetX( CVec a ) { return _mm_cvtss_f32( a.v ); }
+
+XNA_KERNEL Vec VSplatX( CVec a ) { return VWrap( _mm_shuffle_ps( a.v, a.v, _MM_SHUFFLE( 0, 0, 0, 0 ) ) ); }
+XNA_KERNEL Vec VSplatY( CVec a ) { return VWrap( _mm_shuffle_ps( a.v, a.v, _MM_SHUFFLE( 1, 1, 1, 1 ) ) ); }
+XNA_KERNEL Vec VSplatZ( CVec a ) { return VWrap( _mm_shuffle_ps( a.v, a.v, _MM_SHUFFLE( 2, 2, 2, 2 ) ) ); }
+XNA_KERNEL Vec VSplatW( CVec a ) { return VWrap( _mm_shuffle_ps( a.v, a.v, _MM_SHUFFLE( 3, 3, 3, 3 ) ) ); }
+
+XNA_KERNEL Vec VAdd( CVec a, CVec b ) { return VWrap( _mm_add_ps( a.v, b.v ) ); }
+XNA_KERNEL Vec VSub( CVec a, CVec b ) { return VWrap( _mm_sub_ps( a.v, b.v ) ); }
+XNA_KERNEL Vec VMul( CVec a, CVec b ) { return VWrap( _mm_mul_ps( a.v, b.v ) ); }
+XNA_KERNEL Vec VDiv( CVec a, CVec b ) { return VWrap( _mm_div_ps( a.v, b.v ) ); }
+XNA_KERNEL Vec VSqrt( CVec a ) { return VWrap( _mm_sqrt_ps( a.v ) ); }
+XNA_KERNEL Vec VMin( CVec a, CVec b ) { return VWrap( _mm_min_ps( a.v, b.v ) ); }
+XNA_KERNEL Vec VMax( CVec a, CVec b ) { return VWrap( _mm_max_ps( a.v, b.v ) ); }
+
+XNA_KERNEL Vec VAnd( CVec a, CVec b ) { return VWrap( _mm_and_ps( a.v, b.v ) ); }
+XNA_KERNEL Vec VOr( CVec a, CVec b ) { return VWrap( _mm_or_ps( a.v, b.v ) ); }
+XNA_KERNEL Vec VXor( CVec a, CVec b ) { return VWrap( _mm_xor_ps( a.v, b.v ) ); }
+XNA_KERNEL Vec VAndC( CVec a, CVec b ) { return VWrap( _mm_andnot_ps( b.v, a.v ) ); }
+
+XNA_KERNEL Vec VCmpEq( CVec a, CVec b ) { return VWrap( _mm_cmpeq_ps( a.v, b.v ) ); }
+XNA_KERNEL Vec VCmpNeq( CVec a, CVec b ) { return VWrap( _mm_cmpneq_ps( a.v, b.v ) ); }
+XNA_KERNEL Vec VCmpLt( CVec a, CVec b ) { return VWrap( _mm_cmplt_ps( a.v, b.v ) ); }
+XNA_KERNEL Vec VCmpLe( CVec a, CVec b ) { return VWrap( _mm_cmple_ps( a.v, b.v ) ); }
+XNA_KERNEL Vec VCmpEqInt( CVec a, CVec b )
+{
+    return VWrap( _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_castps_si128( a.v ), _mm_castps_si128( b.v ) ) ) );
+}
+
+// Sign bits of the four lanes, x in bit 0.
+XNA_KERNEL int VMoveMask( CVec a ) { return _mm_movemask_ps( a.v ); }
+
+XNA_KERNEL Vec VPermute( CVec a, CVec b, const PermuteControl& Control )
+{
+    __m128i ControlA = _mm_loadu_si128( ( const __m128i* )Control.FromA );
+    __m128i ControlB = _mm_loadu_si128( ( const __m128i* )Control.FromB );
+    __m128i FromA = _mm_shuffle_epi8( _mm_castps_si128( a.v ), ControlA );
+    __m128i FromB = _mm_shuffle_epi8( _mm_castps_si128( b.v ), ControlB );
+
+    return VWrap( _mm_castsi128_ps( _mm_or_si128( FromA, FromB ) ) );
+}
+
+#else
+
+struct Vec
+{
+    uint32 u[4];
+};
+
+typedef const Vec& CVec;
+
+XNA_KERNEL float AsFloat( uint32 u )
+{
+    float f;
+    memcpy( &f, &u, sizeof( f ) );
+    return f;
+}
+
+XNA_KERNEL uint32 AsUint( float f )
+{
+    uint32 u;
+    memcpy( &u, &f, sizeof( u ) );
+    return u;
+}
+
+XNA_KERNEL Vec VSetInt( uint32 x, uint32 y, uint32 z, uint32 w )
+{
+    Vec Result = { { x, y, z, w } };
+    return Result;
+}
+XNA_KERNEL Vec VSet( float x, float y, float z, float w )
+{
+    return VSetInt( AsUint( x ), AsUint( y ), AsUint( z ), AsUint( w ) );
+}
+XNA_KERNEL Vec VLoad4( const float* p ) { return VSet( p[0], p[1], p[2], p[3] ); }
+XNA_KERNEL void VStore4( float* p, CVec a ) { memcpy( p, a.u, sizeof( a.u ) ); }
+XNA_KERNEL float VGetX( CVec a ) { return AsFloat( a.u[0] ); }
+
+XNA_KERNEL Vec VSplatX( CVec a ) { return VSetInt( a.u[0], a.u[0], a.u[0], a.u[0] ); }
+XNA_KERNEL Vec VSplatY( CVec a ) { return VSetInt( a.u[1], a.u[1], a.u[1], a.u[1] ); }
+XNA_KERNEL Vec VSplatZ( CVec a ) { return VSetInt( a.u[2], a.u[2], a.u[2], a.u[2] ); }
+XNA_KERNEL Vec VSplatW( CVec a ) { return VSetInt( a.u[3], a.u[3], a.u[3], a.u[3] ); }
+
+// Lane-wise operations, x and y are the lanes of a and b.
+#define XNA_LANEWISE_FLOAT( Name, Expr ) \
+    XNA_KERNEL Vec Name( CVec a, CVec b ) \
+    { \
+        Vec Result; \
+        for( int i = 0; i < 4; i++ ) \
+        { \
+            float x = AsFloat( a.u[i] ); \
+            float y = AsFloat( b.u[i] ); \
+            ( void )y; \
+            Result.u[i] = AsUint( Expr ); \
+        } \
+        return Result; \
+    }
+
+#define XNA_LANEWISE_BITS( Name, Expr ) \
+    XNA_KERNEL Vec Name( CVec a, CVec b ) \
+    { \
+        Vec Result; \
+        for( int i = 0; i < 4; i++ ) \
+        { \
+            uint32 x = a.u[i]; \
+            uint32 y = b.u[i]; \
+            Result.u[i] = ( Expr ); \
+        } \
+        return Result; \
+    }
+
+#define XNA_LANEWISE_COMPARE( Name, Expr ) \
+    XNA_KERNEL Vec Name( CVec a, CVec b ) \
+    { \
+        Vec Result; \
+        for( int i = 0; i < 4; i++ ) \
+        { \
+            float x = AsFloat( a.u[i] ); \
+            float y = AsFloat( b.u[i] ); \
+            Result.u[i] = ( Expr ) ? 0xFFFFFFFF : 0; \
+        } \
+        return Result; \
+    }
+
+XNA_LANEWISE_FLOAT( VAdd, x + y )
+XNA_LANEWISE_FLOAT( VSub, x - y )
+XNA_LANEWISE_FLOAT( VMul, x * y )
+XNA_LANEWISE_FLOAT( VDiv, x / y )
+// Same operand order as minps / maxps: the second operand when either is NaN.
+XNA_LANEWISE_FLOAT( VMin, x < y ? x : y )
+XNA_LANEWISE_FLOAT( VMax, x > y ? x : y )
+
+XNA_LANEWISE_BITS( VAnd, x & y )
+XNA_LANEWISE_BITS( VOr, x | y )
+XNA_LANEWISE_BITS( VXor, x ^ y )
+XNA_LANEWISE_BITS( VAndC, x & ~y )
+XNA_LANEWISE_BITS( VCmpEqInt, x == y ? 0xFFFFFFFF : 0 )
+
+XNA_LANEWISE_COMPARE( VCmpEq, x == y )
+XNA_LANEWISE_COMPARE( VCmpNeq, x != y )
+XNA_LANEWISE_COMPARE( VCmpLt, x < y )
+XNA_LANEWISE_COMPARE( VCmpLe, x <= y )
+
+#undef XNA_LANEWISE_FLOAT
+#undef XNA_LANEWISE_BITS
+#undef XNA_LANEWISE_COMPARE
+
+XNA_KERNEL Vec VSqrt( CVec a )
+{
+    return VSet( sqrtf( AsFloat( a.u[0] ) ), sqrtf( AsFloat( a.u[1] ) ), sqrtf( AsFloat( a.u[2] ) ),
+                 sqrtf( AsFloat( a.u[3] ) ) );
+}
+
+XNA_KERNEL int VMoveMask( CVec a )
+{
+    return ( int )( ( a.u[0] >> 31 ) | ( ( a.u[1] >> 31 ) << 1 ) | ( ( a.u[2] >> 31 ) << 2 ) | ( ( a.u[3] >> 31 ) << 3 ) );
+}
+
+XNA_KERNEL Vec VPermute( CVec a, CVec b, const PermuteControl& Control )
+{
+    uint8 BytesA[16], BytesB[16], Result[16];
+    memcpy( BytesA, a.u, 16 );
+    memcpy( BytesB, b.u, 16 );
+
+    for( int i = 0; i < 16; i++ )
+    {
+        uint8 ByteA = ( Control.FromA[i] & 0x80 ) ? 0 : BytesA[Control.FromA[i] & 15];
+        uint8 ByteB = ( Control.FromB[i] & 0x80 ) ? 0 : BytesB[Control.FromB[i] & 15];
+        Result[i] = ByteA | ByteB;
+    }
+
+    Vec Out;
+    memcpy( Out.u, Result, 16 );
+    return Out;
+}
+
+#endif
+
+XNA_KERNEL Vec VCmpGt( CVec a, CVec b ) { return VCmpLt( b, a ); }
+XNA_KERNEL Vec VCmpGe( CVec a, CVec b ) { return VCmpLe( b, a ); }
+
+
+
+//-----------------------------------------------------------------------------
+// Constants, loads and stores.
+//-----------------------------------------------------------------------------
+struct VMatrix
+{
+    Vec r[4];
+};
+
+XNA_KERNEL Vec VectorSet( float x, float y, float z, float w ) { return VSet( x, y, z, w ); }
+XNA_KERNEL Vec VectorSetInt( uint32 x, uint32 y, uint32 z, uint32 w ) { return VSetInt( x, y, z, w ); }
+XNA_KERNEL Vec VectorZero() { return VSet( 0.0f, 0.0f, 0.0f, 0.0f ); }
+XNA_KERNEL Vec VectorSplatOne() { return VSet( 1.0f, 1.0f, 1.0f, 1.0f ); }
+XNA_KERNEL Vec VectorTrueInt() { return VSetInt( 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF ); }
+XNA_KERNEL Vec VectorFalseInt() { return VSetInt( 0, 0, 0, 0 ); }
+XNA_KERNEL Vec VectorReplicate( float Value ) { return VSet( Value, Value, Value, Value ); }
+XNA_KERNEL Vec VectorReplicatePtr( const float* pValue ) { return VectorReplicate( *pValue ); }
+XNA_KERNEL Vec VectorSetBinaryConstant( uint32 C0, uint32 C1, uint32 C2, uint32 C3 )
+{
+    return VSet( ( C0 & 1 ) ? 1.0f : 0.0f, ( C1 & 1 ) ? 1.0f : 0.0f, ( C2 & 1 ) ? 1.0f : 0.0f,
+                 ( C3 & 1 ) ? 1.0f : 0.0f );
+}
+
+XNA_KERNEL Float3 MakeFloat3( float x, float y, float z )
+{
+    Float3 Result = { x, y, z };
+    return Result;
+}
+
+XNA_KERNEL Float4 MakeFloat4( float x, float y, float z, float w )
+{
+    Float4 Result = { x, y, z, w };
+    return Result;
+}
+
+XNA_KERNEL Vec LoadFloat( const float* pSource ) { return VSet( *pSource, 0.0f, 0.0f, 0.0f ); }
+XNA_KERNEL Vec LoadFloat3( const Float3* pSource ) { return VSet( pSource->x, pSource->y, pSource->z, 0.0f ); }
+XNA_KERNEL Vec LoadFloat4( const Float4* pSource ) { return VLoad4( &pSource->x ); }
+
+XNA_KERNEL void StoreFloat( float* pDestination, CVec V ) { *pDestination = VGetX( V ); }
+XNA_KERNEL void StoreFloat4( Float4* pDestination, CVec V ) { VStore4( &pDestination->x, V ); }
+XNA_KERNEL void StoreFloat3( Float3* pDestination, CVec V )
+{
+    float Lanes[4];
+    VStore4( Lanes, V );
+    pDestination->x = Lanes[0];
+    pDestination->y = Lanes[1];
+    pDestination->z = Lanes[2];
+}
+
+XNA_KERNEL VMatrix LoadMatrix( const Matrix* pSource )
+{
+    VMatrix M;
+    for( int i = 0; i < 4; i++ )
+        M.r[i] = LoadFloat4( &pSource->r[i] );
+    return M;
+}
+
+XNA_KERNEL void StoreMatrix( float* pDestination, const VMatrix& M )
+{
+    for( int i = 0; i < 4; i++ )
+        VStore4( pDestination + i * 4, M.r[i] );
+}
+
+XNA_KERNEL VMatrix LoadMatrix( const float* pSource )
+{
+    VMatrix M;
+    for( int i = 0; i < 4; i++ )
+        M.r[i] = VLoad4( pSource + i * 4 );
+    return M;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Component access and permutes.
+//-----------------------------------------------------------------------------
+XNA_KERNEL Vec VectorSplatX( CVec V ) { return VSplatX( V ); }
+XNA_KERNEL Vec VectorSplatY( CVec V ) { return VSplatY( V ); }
+XNA_KERNEL Vec VectorSplatZ( CVec V ) { return VSplatZ( V ); }
+XNA_KERNEL Vec VectorSplatW( CVec V ) { return VSplatW( V ); }
+
+XNA_KERNEL float VectorGetX( CVec V ) { return VGetX( V ); }
+XNA_KERNEL float VectorGetY( CVec V ) { return VGetX( VSplatY( V ) ); }
+XNA_KERNEL float VectorGetZ( CVec V ) { return VGetX( VSplatZ( V ) ); }
+XNA_KERNEL float VectorGetW( CVec V ) { return VGetX( VSplatW( V ) ); }
+
+XNA_KERNEL Vec VectorSelect( CVec V1, CVec V2, CVec Control )
+{
+    return VOr( VAndC( V1, Control ), VAnd( V2, Control ) );
+}
+
+XNA_KERNEL Vec VectorSetX( CVec V, float x ) { return VectorSelect( V, VectorReplicate( x ), VSetInt( 0xFFFFFFFF, 0, 0, 0 ) ); }
+XNA_KERNEL Vec VectorSetY( CVec V, float y ) { return VectorSelect( V, VectorReplicate( y ), VSetInt( 0, 0xFFFFFFFF, 0, 0 ) ); }
+XNA_KERNEL Vec VectorSetZ( CVec V, float z ) { return VectorSelect( V, VectorReplicate( z ), VSetInt( 0, 0, 0xFFFFFFFF, 0 ) ); }
+XNA_KERNEL Vec VectorSetW( CVec V, float w ) { return VectorSelect( V, VectorReplicate( w ), VSetInt( 0, 0, 0, 0xFFFFFFFF ) ); }
+
+XNA_KERNEL Vec VectorPermute( CVec V1, CVec V2, const PermuteControl& Control ) { return VPermute( V1, V2, Control ); }
+
+XNA_KERNEL Vec VectorSwizzle( CVec V, uint32 E0, uint32 E1, uint32 E2, uint32 E3 )
+{
+    PermuteControl Control;
+    BuildPermuteControl( &Control, E0 & 3, E1 & 3, E2 & 3, E3 & 3 );
+    return VPermute( V, V, Control );
+}
+
+// Replace the selected elements of VD by the elements of VS rotated left.
+XNA_KERNEL Vec VectorInsert( CVec VD, CVec VS, uint32 VSLeftRotateElements,
+                              uint32 Select0, uint32 Select1, uint32 Select2, uint32 Select3 )
+{
+    Vec Control = VSetInt( ( Select0 & 1 ) ? 0xFFFFFFFF : 0, ( Select1 & 1 ) ? 0xFFFFFFFF : 0,
+                           ( Select2 & 1 ) ? 0xFFFFFFFF : 0, ( Select3 & 1 ) ? 0xFFFFFFFF : 0 );
+
+    Vec Source = VS;
+    if( VSLeftRotateElements & 3 )
+        Source = VectorSwizzle( VS, VSLeftRotateElements, VSLeftRotateElements + 1, VSLeftRotateElements + 2,
+                                VSLeftRotateElements + 3 );
+
+    return VectorSelect( VD, Source, Control );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Arithmetic.
+//-----------------------------------------------------------------------------
+XNA_KERNEL Vec VectorAdd( CVec V1, CVec V2 ) { return VAdd( V1, V2 ); }
+XNA_KERNEL Vec VectorSubtract( CVec V1, CVec V2 ) { return VSub( V1, V2 ); }
+XNA_KERNEL Vec VectorMultiply( CVec V1, CVec V2 ) { return VMul( V1, V2 ); }
+XNA_KERNEL Vec VectorReciprocal( CVec V ) { return VDiv( VectorSplatOne(), V ); }
+XNA_KERNEL Vec VectorSqrt( CVec V ) { return VSqrt( V ); }
+XNA_KERNEL Vec VectorMin( CVec V1, CVec V2 ) { return VMin( V1, V2 ); }
+XNA_KERNEL Vec VectorMax( CVec V1, CVec V2 ) { return VMax( V1, V2 ); }
+
+XNA_KERNEL Vec VectorSignMask() { return VSetInt( 0x80000000, 0x80000000, 0x80000000, 0x80000000 ); }
+XNA_KERNEL Vec VectorNegate( CVec V ) { return VXor( V, VectorSignMask() ); }
+XNA_KERNEL Vec VectorAbs( CVec V ) { return VAndC( V, VectorSignMask() ); }
+
+XNA_KERNEL Vec VectorAndInt( CVec V1, CVec V2 ) { return VAnd( V1, V2 ); }
+XNA_KERNEL Vec VectorOrInt( CVec V1, CVec V2 ) { return VOr( V1, V2 ); }
+XNA_KERNEL Vec VectorAndCInt( CVec V1, CVec V2 ) { return VAndC( V1, V2 ); }
+
+XNA_KERNEL Vec operator+( CVec V1, CVec V2 ) { return VAdd( V1, V2 ); }
+XNA_KERNEL Vec operator-( CVec V1, CVec V2 ) { return VSub( V1, V2 ); }
+XNA_KERNEL Vec operator*( CVec V1, CVec V2 ) { return VMul( V1, V2 ); }
+XNA_KERNEL Vec operator*( CVec V, float S ) { return VMul( V, VectorReplicate( S ) ); }
+XNA_KERNEL Vec operator*( float S, CVec V ) { return VMul( VectorReplicate( S ), V ); }
+XNA_KERNEL Vec operator-( CVec V ) { return VectorNegate( V ); }
+XNA_KERNEL Vec& operator+=( Vec& V1, CVec V2 ) { V1 = VAdd( V1, V2 ); return V1; }
+XNA_KERNEL Vec& operator-=( Vec& V1, CVec V2 ) { V1 = VSub( V1, V2 ); return V1; }
+XNA_KERNEL Vec& operator*=( Vec& V1, CVec V2 ) { V1 = VMul( V1, V2 ); return V1; }
+XNA_KERNEL Vec& operator*=( Vec& V, float S ) { V = VMul( V, VectorReplicate( S ) ); return V; }
+
+
+
+//-----------------------------------------------------------------------------
+// Comparisons. The R versions also return a comparison record like XNAMath:
+// CRMASK_CR6TRUE when all the lanes are true, CRMASK_CR6FALSE when none is.
+//-----------------------------------------------------------------------------
+static const uint32 CRMASK_CR6TRUE = 0x00000080;
+static const uint32 CRMASK_CR6FALSE = 0x00000020;
+
+XNA_KERNEL uint32 ComparisonRecord( CVec Mask )
+{
+    int Bits = VMoveMask( Mask );
+    return ( Bits == 15 ) ? CRMASK_CR6TRUE : ( Bits == 0 ) ? CRMASK_CR6FALSE : 0;
+}
+
+XNA_KERNEL bool ComparisonAllTrue( uint32 CR ) { return ( CR & CRMASK_CR6TRUE ) == CRMASK_CR6TRUE; }
+XNA_KERNEL bool ComparisonAnyTrue( uint32 CR ) { return ( CR & CRMASK_CR6FALSE ) != CRMASK_CR6FALSE; }
+
+XNA_KERNEL Vec VectorEqual( CVec V1, CVec V2 ) { return VCmpEq( V1, V2 ); }
+XNA_KERNEL Vec VectorLess( CVec V1, CVec V2 ) { return VCmpLt( V1, V2 ); }
+XNA_KERNEL Vec VectorLessOrEqual( CVec V1, CVec V2 ) { return VCmpLe( V1, V2 ); }
+XNA_KERNEL Vec VectorGreater( CVec V1, CVec V2 ) { return VCmpGt( V1, V2 ); }
+XNA_KERNEL Vec VectorGreaterOrEqual( CVec V1, CVec V2 ) { return VCmpGe( V1, V2 ); }
+XNA_KERNEL Vec VectorGreaterR( uint32* pCR, CVec V1, CVec V2 )
+{
+    Vec Result = VCmpGt( V1, V2 );
+    *pCR = ComparisonRecord( Result );
+    return Result;
+}
+
+XNA_KERNEL Vec VectorInBounds( CVec V, CVec Bounds )
+{
+    return VAnd( VCmpLe( V, Bounds ), VCmpLe( VectorNegate( Bounds ), V ) );
+}
+
+XNA_KERNEL bool Vector3Equal( CVec V1, CVec V2 ) { return ( VMoveMask( VCmpEq( V1, V2 ) ) & 7 ) == 7; }
+XNA_KERNEL bool Vector3EqualInt( CVec V1, CVec V2 ) { return ( VMoveMask( VCmpEqInt( V1, V2 ) ) & 7 ) == 7; }
+XNA_KERNEL bool Vector3Greater( CVec V1, CVec V2 ) { return ( VMoveMask( VCmpGt( V1, V2 ) ) & 7 ) == 7; }
+XNA_KERNEL bool Vector3GreaterOrEqual( CVec V1, CVec V2 ) { return ( VMoveMask( VCmpGe( V1, V2 ) ) & 7 ) == 7; }
+XNA_KERNEL bool Vector3LessOrEqual( CVec V1, CVec V2 ) { return ( VMoveMask( VCmpLe( V1, V2 ) ) & 7 ) == 7; }
+XNA_KERNEL bool Vector3InBounds( CVec V, CVec Bounds ) { return ( VMoveMask( VectorInBounds( V, Bounds ) ) & 7 ) == 7; }
+
+XNA_KERNEL bool Vector4EqualInt( CVec V1, CVec V2 ) { return VMoveMask( VCmpEqInt( V1, V2 ) ) == 15; }
+XNA_KERNEL bool Vector4NotEqualInt( CVec V1, CVec V2 ) { return VMoveMask( VCmpEqInt( V1, V2 ) ) != 15; }
+XNA_KERNEL uint32 Vector4EqualIntR( CVec V1, CVec V2 ) { return ComparisonRecord( VCmpEqInt( V1, V2 ) ); }
+XNA_KERNEL bool Vector4Greater( CVec V1, CVec V2 ) { return VMoveMask( VCmpGt( V1, V2 ) ) == 15; }
+XNA_KERNEL bool Vector4GreaterOrEqual( CVec V1, CVec V2 ) { return VMoveMask( VCmpGe( V1, V2 ) ) == 15; }
+XNA_KERNEL bool Vector4Less( CVec V1, CVec V2 ) { return VMoveMask( VCmpLt( V1, V2 ) ) == 15; }
+XNA_KERNEL bool Vector4LessOrEqual( CVec V1, CVec V2 ) { return VMoveMask( VCmpLe( V1, V2 ) ) == 15; }
+
+
+
+//-----------------------------------------------------------------------------
+// Geometric functions. Sums go x, y, z, w from left to right.
+//-----------------------------------------------------------------------------
+XNA_KERNEL Vec Vector3Dot( CVec V1, CVec V2 )
+{
+    Vec Product = VMul( V1, V2 );
+    return VAdd( VAdd( VSplatX( Product ), VSplatY( Product ) ), VSplatZ( Product ) );
+}
+
+XNA_KERNEL Vec Vector4Dot( CVec V1, CVec V2 )
+{
+    Vec Product = VMul( V1, V2 );
+    return VAdd( VAdd( VAdd( VSplatX( Product ), VSplatY( Product ) ), VSplatZ( Product ) ), VSplatW( Product ) );
+}
+
+XNA_KERNEL Vec Vector3Cross( CVec V1, CVec V2 )
+{
+    static const PermuteControl PermuteYZXW = XNA_PERMUTE_CONTROL( 1, 2, 0, 3 );
+    static const PermuteControl PermuteZXYW = XNA_PERMUTE_CONTROL( 2, 0, 1, 3 );
+
+    Vec Result = VSub( VMul( VPermute( V1, V1, PermuteYZXW ), VPermute( V2, V2, PermuteZXYW ) ),
+                       VMul( VPermute( V1, V1, PermuteZXYW ), VPermute( V2, V2, PermuteYZXW ) ) );
+
+    return VAnd( Result, VSetInt( 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0 ) );
+}
+
+XNA_KERNEL Vec Vector3LengthSq( CVec V ) { return Vector3Dot( V, V ); }
+XNA_KERNEL Vec Vector3Length( CVec V ) { return VSqrt( Vector3Dot( V, V ) ); }
+XNA_KERNEL Vec Vector4Length( CVec V ) { return VSqrt( Vector4Dot( V, V ) ); }
+
+// V divided by Length, zero for a zero length and QNaN for an infinite one.
+XNA_KERNEL Vec NormalizeByLength( CVec V, CVec LengthSq )
+{
+    Vec Length = VSqrt( LengthSq );
+    Vec Result = VAnd( VDiv( V, Length ), VCmpNeq( Length, VectorZero() ) );
+    Vec Infinity = VSetInt( 0x7F800000, 0x7F800000, 0x7F800000, 0x7F800000 );
+    Vec QNaN = VSetInt( 0x7FC00000, 0x7FC00000, 0x7FC00000, 0x7FC00000 );
+
+    return VectorSelect( QNaN, Result, VCmpNeq( LengthSq, Infinity ) );
+}
+
+XNA_KERNEL Vec Vector3Normalize( CVec V ) { return NormalizeByLength( V, Vector3Dot( V, V ) ); }
+XNA_KERNEL Vec QuaternionNormalize( CVec Q ) { return NormalizeByLength( Q, Vector4Dot( Q, Q ) ); }
+XNA_KERNEL Vec PlaneNormalize( CVec P ) { return NormalizeByLength( P, Vector3Dot( P, P ) ); }
+
+XNA_KERNEL Vec QuaternionConjugate( CVec Q )
+{
+    return VXor( Q, VSetInt( 0x80000000, 0x80000000, 0x80000000, 0 ) );
+}
+
+// Q2 * Q1, the rotation Q1 followed by Q2 (XMQuaternionMultiply).
+XNA_KERNEL Vec QuaternionMultiply( CVec Q1, CVec Q2 )
+{
+    static const PermuteControl PermuteWZYX = XNA_PERMUTE_CONTROL( 3, 2, 1, 0 );
+    static const PermuteControl PermuteZWXY = XNA_PERMUTE_CONTROL( 2, 3, 0, 1 );
+    static const PermuteControl PermuteYXWZ = XNA_PERMUTE_CONTROL( 1, 0, 3, 2 );
+
+    Vec ControlWZYX = VSet( 1.0f, -1.0f, 1.0f, -1.0f );
+    Vec ControlZWXY = VSet( 1.0f, 1.0f, -1.0f, -1.0f );
+    Vec ControlYXWZ = VSet( -1.0f, 1.0f, 1.0f, -1.0f );
+
+    Vec Result = VMul( VSplatW( Q2 ), Q1 );
+    Vec Q2X = VMul( VMul( VSplatX( Q2 ), VPermute( Q1, Q1, PermuteWZYX ) ), ControlWZYX );
+    Vec Q2Y = VMul( VMul( VSplatY( Q2 ), VPermute( Q1, Q1, PermuteZWXY ) ), ControlZWXY );
+    Vec Q2Z = VMul( VMul( VSplatZ( Q2 ), VPermute( Q1, Q1, PermuteYXWZ ) ), ControlYXWZ );
+
+    return VAdd( VAdd( Result, Q2X ), VAdd( Q2Y, Q2Z ) );
+}
+
+XNA_KERNEL Vec Vector3Rotate( CVec V, CVec RotationQuaternion )
+{
+    Vec A = VAnd( V, VSetInt( 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0 ) );
+    Vec Result = QuaternionMultiply( QuaternionConjugate( RotationQuaternion ), A );
+    return QuaternionMultiply( Result, RotationQuaternion );
+}
+
+XNA_KERNEL Vec Vector3InverseRotate( CVec V, CVec RotationQuaternion )
+{
+    Vec A = VAnd( V, VSetInt( 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0 ) );
+    Vec Result = QuaternionMultiply( RotationQuaternion, A );
+    return QuaternionMultiply( Result, QuaternionConjugate( RotationQuaternion ) );
+}
+
+XNA_KERNEL Vec Vector3TransformNormal( CVec V, const VMatrix& M )
+{
+    Vec Result = VMul( VSplatX( V ), M.r[0] );
+    Result = VAdd( Result, VMul( VSplatY( V ), M.r[1] ) );
+    return VAdd( Result, VMul( VSplatZ( V ), M.r[2] ) );
+}
+
+XNA_KERNEL Vec Vector4Transform( CVec V, const VMatrix& M )
+{
+    Vec Result = VMul( VSplatX( V ), M.r[0] );
+    Result = VAdd( Result, VMul( VSplatY( V ), M.r[1] ) );
+    Result = VAdd( Result, VMul( VSplatZ( V ), M.r[2] ) );
+    return VAdd( Result, VMul( VSplatW( V ), M.r[3] ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Matrix functions, only used to build volumes, computed on plain floats.
+//-----------------------------------------------------------------------------
+XNA_KERNEL VMatrix MatrixTranspose( const VMatrix& M )
+{
+    float m[16], t[16];
+    StoreMatrix( m, M );
+
+    for( int i = 0; i < 4; i++ )
+        for( int j = 0; j < 4; j++ )
+            t[i * 4 + j] = m[j * 4 + i];
+
+    return LoadMatrix( t );
+}
+
+// Cofactors of the first row and determinant, by 2x2 minors of the lower rows.
+XNA_KERNEL float MatrixCofactors( const float* m, float* pInverse )
+{
+    float s0 = m[0] * m[5] - m[4] * m[1];
+    float s1 = m[0] * m[6] - m[4] * m[2];
+    float s2 = m[0] * m[7] - m[4] * m[3];
+    float s3 = m[1] * m[6] - m[5] * m[2];
+    float s4 = m[1] * m[7] - m[5] * m[3];
+    float s5 = m[2] * m[7] - m[6] * m[3];
+
+    float c5 = m[10] * m[15] - m[14] * m[11];
+    float c4 = m[9] * m[15] - m[13] * m[11];
+    float c3 = m[9] * m[14] - m[13] * m[10];
+    float c2 = m[8] * m[15] - m[12] * m[11];
+    float c1 = m[8] * m[14] - m[12] * m[10];
+    float c0 = m[8] * m[13] - m[12] * m[9];
+
+    float Det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+
+    if( pInverse )
+    {
+        pInverse[0] = m[5] * c5 - m[6] * c4 + m[7] * c3;
+        pInverse[1] = -m[1] * c5 + m[2] * c4 - m[3] * c3;
+        pInverse[2] = m[13] * s5 - m[14] * s4 + m[15] * s3;
+        pInverse[3] = -m[9] * s5 + m[10] * s4 - m[11] * s3;
+
+        pInverse[4] = -m[4] * c5 + m[6] * c2 - m[7] * c1;
+        pInverse[5] = m[0] * c5 - m[2] * c2 + m[3] * c1;
+        pInverse[6] = -m[12] * s5 + m[14] * s2 - m[15] * s1;
+        pInverse[7] = m[8] * s5 - m[10] * s2 + m[11] * s1;
+
+        pInverse[8] = m[4] * c4 - m[5] * c2 + m[7] * c0;
+        pInverse[9] = -m[0] * c4 + m[1] * c2 - m[3] * c0;
+        pInverse[10] = m[12] * s4 - m[13] * s2 + m[15] * s0;
+        pInverse[11] = -m[8] * s4 + m[9] * s2 - m[11] * s0;
+
+        pInverse[12] = -m[4] * c3 + m[5] * c1 - m[6] * c0;
+        pInverse[13] = m[0] * c3 - m[1] * c1 + m[2] * c0;
+        pInverse[14] = -m[12] * s3 + m[13] * s1 - m[14] * s0;
+        pInverse[15] = m[8] * s3 - m[9] * s1 + m[10] * s0;
+    }
+
+    return Det;
+}
+
+XNA_KERNEL Vec MatrixDeterminant( const VMatrix& M )
+{
+    float m[16];
+    StoreMatrix( m, M );
+    return VectorReplicate( MatrixCofactors( m, NULL ) );
+}
+
+XNA_KERNEL VMatrix MatrixInverse( Vec* pDeterminant, const VMatrix& M )
+{
+    float m[16], Inverse[16];
+    StoreMatrix( m, M );
+
+    float Det = MatrixCofactors( m, Inverse );
+    float InvDet = 1.0f / Det;
+
+    for( int i = 0; i < 16; i++ )
+        Inverse[i] *= InvDet;
+
+    if( pDeterminant )
+        *pDeterminant = VectorReplicate( Det );
+
+    return LoadMatrix( Inverse );
+}
+
+XNA_KERNEL VMatrix MatrixRotationQuaternion( CVec Quaternion )
+{
+    float q[4];
+    VStore4( q, Quaternion );
+
+    float xx = q[0] * q[0], yy = q[1] * q[1], zz = q[2] * q[2];
+    float xy = q[0] * q[1], xz = q[0] * q[2], yz = q[1] * q[2];
+    float wx = q[3] * q[0], wy = q[3] * q[1], wz = q[3] * q[2];
+
+    float m[16] =
+    {
+        1.0f - 2.0f * ( yy + zz ), 2.0f * ( xy + wz ), 2.0f * ( xz - wy ), 0.0f,
+        2.0f * ( xy - wz ), 1.0f - 2.0f * ( xx + zz ), 2.0f * ( yz + wx ), 0.0f,
+        2.0f * ( xz + wy ), 2.0f * ( yz - wx ), 1.0f - 2.0f * ( xx + yy ), 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+
+    return LoadMatrix( m );
+}
+
+XNA_KERNEL Vec QuaternionRotationMatrix( const VMatrix& M )
+{
+    float m[16];
+    StoreMatrix( m, M );
+
+    float Trace = m[0] + m[5] + m[10];
+    float x, y, z, w;
+
+    if( Trace > 0.0f )
+    {
+        float s = sqrtf( Trace + 1.0f ) * 2.0f;
+        w = 0.25f * s;
+        x = ( m[6] - m[9] ) / s;
+        y = ( m[8] - m[2] ) / s;
+        z = ( m[1] - m[4] ) / s;
+    }
+    else if( m[0] > m[5] && m[0] > m[10] )
+    {
+        float s = sqrtf( 1.0f + m[0] - m[5] - m[10] ) * 2.0f;
+        w = ( m[6] - m[9] ) / s;
+        x = 0.25f * s;
+        y = ( m[4] + m[1] ) / s;
+        z = ( m[8] + m[2] ) / s;
+    }
+    else if( m[5] > m[10] )
+    {
+        float s = sqrtf( 1.0f + m[5] - m[0] - m[10] ) * 2.0f;
+        w = ( m[8] - m[2] ) / s;
+        x = ( m[4] + m[1] ) / s;
+        y = 0.25f * s;
+        z = ( m[9] + m[6] ) / s;
+    }
+    else
+    {
+        float s = sqrtf( 1.0f + m[10] - m[0] - m[5] ) * 2.0f;
+        w = ( m[1] - m[4] ) / s;
+        x = ( m[8] + m[2] ) / s;
+        y = ( m[9] + m[6] ) / s;
+        z = 0.25f * s;
+    }
+
+    return VSet( x, y, z, w );
+}
@@ -0,0 +1,56 @@
+//---------------------------------------------------------------------------------------
+//
+// 64 bits hash of a file content, to key the caches of loaded assets.
+//
+// FNV-1a on 64 bits words, in four independent lanes so the multiplications overlap,
+// the lanes and the size are mixed at the end. A few GB/s, small next to any parse.
+// Not a cryptographic hash: the caches also compare the sizes.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_CONTENTHASH_H
+#define _INCGUARD_CONTENTHASH_H
+
+#include "types.h"
+#include <cstring>
+
+// Final mix of a 64 bits value (MurmurHash3's).
+inline uint64 MixHash(uint64 h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+inline uint64 HashBytes(const void* bytes, uint64 size)
+{
+    const uint64 HashPrime = 0x100000001b3ull;
+    const uint64 HashBasis = 0xcbf29ce484222325ull;
+
+    const uint8* data = static_cast<const uint8*>(bytes);
+    uint64 lanes[4] = { HashBasis, HashBasis ^ 1, HashBasis ^ 2, HashBasis ^ 3 };
+
+    uint64 i = 0;
+    for(; i + 32 <= size; i += 32)
+    {
+        for(uint32 l = 0; l < 4; ++l)
+        {
+            uint64 word;
+            memcpy(&word, data + i + 8 * l, sizeof(word));
+            lanes[l] = (lanes[l] ^ word) * HashPrime;
+        }
+    }
+
+    for(; i < size; ++i)
+        lanes[0] = (lanes[0] ^ data[i]) * HashPrime;
+
+    uint64 h = MixHash(size);
+    for(uint32 l = 0; l < 4; ++l)
+        h = MixHash(h ^ lanes[l]);
+    return h;
+}
+
+#endif // _INCGUARD_CONTENTHASH_H
@@ -0,0 +1,86 @@
+#include "cpuFeatures.h"
+#include <thread>
+
+#if defined(OC_CPU_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(OC_CPU_X86)
+static void QueryCpuid(int leaf, int subLeaf, int regs[4])
+{
+#if defined(_MSC_VER)
+    __cpuidex(regs, leaf, subLeaf);
+#else
+    unsigned int a = 0, b = 0, c = 0, d = 0;
+    __cpuid_count(leaf, subLeaf, a, b, c, d);
+    regs[0] = (int)a; regs[1] = (int)b; regs[2] = (int)c; regs[3] = (int)d;
+#endif
+}
+
+static uint64 QueryXcr0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32 eax = 0, edx = 0;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64)edx << 32) | eax;
+#endif
+}
+#endif
+
+const CpuFeatures::Flags& CpuFeatures::Detect()
+{
+    // Function local static, filled once on first use.
+    static Flags flags = []()
+    {
+        Flags f = { false, false };
+
+#if defined(OC_CPU_X86)
+        int regs[4];
+        QueryCpuid(0, 0, regs);
+        int maxLeaf = regs[0];
+
+        if(maxLeaf >= 1)
+        {
+            QueryCpuid(1, 0, regs);
+            f.sse41 = (regs[2] & (1 << 19)) != 0;
+
+            // AVX state must be enabled by the OS (XMM and YMM bits of XCR0).
+            bool osxsave = (regs[2] & (1 << 27)) != 0;
+            bool avx     = (regs[2] & (1 << 28)) != 0;
+            bool osYmm   = osxsave && ((QueryXcr0() & 0x6) == 0x6);
+
+            if(maxLeaf >= 7 && avx && osYmm)
+            {
+                QueryCpuid(7, 0, regs);
+                f.avx2 = (regs[1] & (1 << 5)) != 0;
+            }
+        }
+#endif
+        return f;
+    }();
+
+    return flags;
+}
+
+bool CpuFeatures::HasSSE41()
+{
+    return Detect().sse41;
+}
+
+bool CpuFeatures::HasAVX2()
+{
+    return Detect().avx2;
+}
+
+uint32 CpuFeatures::HardwareThreadCount()
+{
+    uint32 count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
@@ -0,0 +1,47 @@
+//---------------------------------------------------------------------------------------
+//
+// Runtime detection of the SIMD instruction sets supported by the host CPU
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_CPUFEATURES_H
+#define _INCGUARD_CPUFEATURES_H
+
+#include "types.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define OC_CPU_X86 1
+
+// Function attributes enabling an instruction set in one function. MSVC lets any
+// intrinsic be used in any function, gcc/clang need the target to be enabled per
+// function so the rest of the file keeps the baseline ISA.
+#if defined(_MSC_VER)
+#define OC_TARGET_SSE41
+#define OC_TARGET_AVX2
+#else
+#define OC_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define OC_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+class CpuFeatures
+{
+public:
+    // True if the CPU (and for AVX the OS, through XSAVE) supports the instruction set.
+    static bool HasSSE41();
+    static bool HasAVX2();
+
+    // Number of hardware threads, at least 1.
+    static uint32 HardwareThreadCount();
+
+private:
+    struct Flags
+    {
+        bool sse41;
+        bool avx2;
+    };
+
+    static const Flags& Detect();
+};
+
+#endif // _INCGUARD_CPUFEATURES_H
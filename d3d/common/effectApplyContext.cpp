@@ -0,0 +1,50 @@
+#include "effectApplyContext.h"
+
+EffectApplyContext::EffectApplyContext()
+{
+}
+
+EffectApplyContext::~EffectApplyContext()
+{
+    Clear();
+    if(m_context)
+        D3DX11EnableEffectStateFilter(m_context.Get(), FALSE);
+}
+
+HRESULT EffectApplyContext::Init(ID3D11Device* device)
+{
+    HRESULT hr = device->CreateDeferredContext(0, m_context.ReleaseAndGetAddressOf());
+    if(FAILED(hr))
+        return hr;
+
+    hr = D3DX11EnableEffectStateFilter(m_context.Get(), TRUE);
+    if(FAILED(hr))
+        return hr;
+
+    return D3DX11CreateEffectApplyContext(m_context.Get(), m_applyContext.ReleaseAndGetAddressOf());
+}
+
+HRESULT EffectApplyContext::SetRawValue(ID3DX11EffectVariable* variable, const void* data, uint32 offset, uint32 size)
+{
+    return m_applyContext->SetRawValue(variable, data, offset, size);
+}
+
+HRESULT EffectApplyContext::Apply(ID3DX11EffectPass* pass)
+{
+    return m_applyContext->Apply(pass, 0);
+}
+
+HRESULT EffectApplyContext::Finish(ID3D11CommandList** ppCommandList)
+{
+    HRESULT hr = m_context->FinishCommandList(FALSE, ppCommandList);
+
+    // The deferred context is back to its default state, whatever the outcome.
+    D3DX11InvalidateEffectStateFilter(m_context.Get());
+    return hr;
+}
+
+void EffectApplyContext::Clear()
+{
+    if(m_applyContext)
+        m_applyContext->Reset();
+}
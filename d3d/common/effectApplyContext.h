@@ -0,0 +1,62 @@
+//---------------------------------------------------------------------------------------
+//
+// Per thread state for recording effect passes on a deferred context.
+//
+// A thread recording draws gets its own deferred context and an
+// ID3DX11EffectApplyContext on it. The effects are shared by all the threads: their
+// shaders, state objects and variables are only read while the threads record. The
+// apply context keeps a private copy of the cbuffers of every effect it applies, and
+// the deferred context has its own effect state filter, so the threads do not share
+// any mutable state.
+//
+// Set the per draw values through SetRawValue, which writes the copies of this
+// context. Values set on the shared effect reach every context, at its next Apply;
+// the shared effect must not be written while the threads record.
+//
+// A context is used by one thread at a time, several contexts at once.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_EFFECTAPPLYCONTEXT_H
+#define _INCGUARD_EFFECTAPPLYCONTEXT_H
+
+#include "comPtr.h"
+#include "d3dx11Effect.h"
+#include "types.h"
+
+class EffectApplyContext
+{
+public:
+    EffectApplyContext();
+    ~EffectApplyContext();
+
+    // Create the deferred context, enable the effect state filter on it and
+    // create the apply context.
+    HRESULT Init(ID3D11Device* device);
+
+    ID3D11DeviceContext* Context() const { return m_context.Get(); }
+
+    // Set a variable of a shared effect for the passes this context applies.
+    HRESULT SetRawValue(ID3DX11EffectVariable* variable, const void* data, uint32 offset, uint32 size);
+
+    // Record a pass of a shared effect on the deferred context.
+    HRESULT Apply(ID3DX11EffectPass* pass);
+
+    // End the recording. The deferred context starts over from the default state,
+    // its state filter is reset too. After executing the list on the immediate
+    // context without restoring its state, invalidate the filter of the immediate
+    // context if it has one.
+    HRESULT Finish(ID3D11CommandList** ppCommandList);
+
+    // Release the copies, and the references on the effects.
+    void Clear();
+
+private:
+    EffectApplyContext(const EffectApplyContext&);
+    EffectApplyContext& operator=(const EffectApplyContext&);
+
+    ComPtr<ID3D11DeviceContext> m_context;
+    ComPtr<ID3DX11EffectApplyContext> m_applyContext;
+};
+
+#endif // _INCGUARD_EFFECTAPPLYCONTEXT_H
@@ -0,0 +1,116 @@
+#include "effectCache.h"
+#include "contentHash.h"
+#include "timer.h"
+
+EffectCache::EffectCache()
+: m_loads(0)
+, m_hits(0)
+, m_loadTime(0.0)
+, m_cloneTime(0.0)
+, m_loadTimeSaved(0.0)
+{
+}
+
+EffectCache::~EffectCache()
+{
+}
+
+EffectCache& EffectCache::Shared()
+{
+    static EffectCache cache;
+    return cache;
+}
+
+HRESULT EffectCache::Create(ID3D11Device* device, const std::vector<uint8>& compiled, ID3DX11Effect** ppEffect)
+{
+    if(compiled.empty())
+        return E_INVALIDARG;
+    return Create(device, &compiled[0], compiled.size(), ppEffect);
+}
+
+HRESULT EffectCache::Create(ID3D11Device* device, const void* data, size_t size, ID3DX11Effect** ppEffect)
+{
+    *ppEffect = nullptr;
+    uint64 hash = HashBytes(data, size);
+
+    Timer timer;
+    timer.Reset();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto range = m_masters.equal_range(hash);
+        for(auto it = range.first; it != range.second; ++it)
+        {
+            Master& master = it->second;
+            if(master.Device != device || master.Size != size)
+                continue;
+
+            timer.Tick();
+            HRESULT hr = master.Effect->CloneEffect(D3DX11_EFFECT_CLONE_FORCE_NONSINGLE, ppEffect);
+            timer.Tick();
+            if(FAILED(hr))
+                return hr;
+
+            ++m_hits;
+            m_cloneTime += timer.DeltaTime();
+            m_loadTimeSaved += master.LoadTime;
+            return S_OK;
+        }
+    }
+
+    // Load outside the lock, other effects can be created meanwhile.
+    Master master;
+    master.Device = device;
+    master.Size = size;
+
+    timer.Tick();
+    HRESULT hr = D3DX11CreateEffectFromMemory(data, size, 0, device, master.Effect.GetAddressOf());
+    timer.Tick();
+    if(FAILED(hr))
+        return hr;
+    master.LoadTime = timer.DeltaTime();
+
+    // The caller gets a clone too, the master keeps the values of the file.
+    timer.Tick();
+    hr = master.Effect->CloneEffect(D3DX11_EFFECT_CLONE_FORCE_NONSINGLE, ppEffect);
+    timer.Tick();
+    if(FAILED(hr))
+        return hr;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_loads;
+    m_loadTime += master.LoadTime;
+    m_cloneTime += timer.DeltaTime();
+
+    // Another thread may have loaded the same effect in the meantime, keep
+    // a single master.
+    auto range = m_masters.equal_range(hash);
+    for(auto it = range.first; it != range.second; ++it)
+    {
+        if(it->second.Device == device && it->second.Size == size)
+            return S_OK;
+    }
+
+    m_masters.insert(std::make_pair(hash, master));
+    return S_OK;
+}
+
+void EffectCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_masters.clear();
+}
+
+EffectCache::Stats EffectCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Stats stats;
+    stats.Loads = m_loads;
+    stats.Hits = m_hits;
+    stats.Masters = (uint32)m_masters.size();
+    stats.LoadTime = (float)m_loadTime;
+    stats.CloneTime = (float)m_cloneTime;
+    stats.LoadTimeSaved = (float)m_loadTimeSaved;
+    return stats;
+}
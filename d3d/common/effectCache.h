@@ -0,0 +1,89 @@
+//---------------------------------------------------------------------------------------
+//
+// Process wide cache of the loaded effects.
+//
+// D3DX11CreateEffectFromMemory parses the compiled effect, reflects its shaders, lays
+// out its data in the effect heaps and creates its device objects, every time. The
+// cache keys the effects by the device and a hash of the compiled effect: the first
+// request loads the effect and keeps it as a master, the next ones get a clone of
+// it. CloneEffect relocates the laid out heaps of the master in one copy and shares
+// its shaders and states, nothing is parsed or created again.
+//
+// The clones are independent of each other and of the master (no cbuffer is shared,
+// see D3DX11_EFFECT_CLONE_FORCE_NONSINGLE). The master is never handed out, so every
+// effect starts from the values of the file. The masters hold their device until
+// Clear.
+//
+// This is an in-process cache: every run still loads each effect once. Keeping the
+// loaded heaps across runs, as a memory-mapped image with offsets in place of the
+// pointers, is left as a follow-up. It needs a relocation pass over the heaps like
+// the one CloneEffect does through CPointerMappingTable, writing offsets instead of
+// new pointers, and a loader that skips the parse and only creates the device
+// objects. The heaps also hold vtable pointers and shader reflection objects that
+// have to be rebuilt rather than relocated.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_EFFECTCACHE_H
+#define _INCGUARD_EFFECTCACHE_H
+
+#include "comPtr.h"
+#include "d3dx11Effect.h"
+#include "types.h"
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class EffectCache
+{
+public:
+    struct Stats
+    {
+        uint32 Loads;           // Effects created from their compiled data.
+        uint32 Hits;            // Create calls served by a clone.
+        uint32 Masters;         // Effects currently cached.
+        float LoadTime;         // Seconds spent in D3DX11CreateEffectFromMemory.
+        float CloneTime;        // Seconds spent cloning.
+        float LoadTimeSaved;    // Loading time the hits avoided.
+    };
+
+    EffectCache();
+    ~EffectCache();
+
+    // Effect of the compiled data (a .fxo file), cloned from the cached one
+    // when there is one for this device.
+    HRESULT Create(ID3D11Device* device, const void* data, size_t size, ID3DX11Effect** ppEffect);
+    HRESULT Create(ID3D11Device* device, const std::vector<uint8>& compiled, ID3DX11Effect** ppEffect);
+
+    // Release the masters, and through them their devices.
+    void Clear();
+
+    Stats GetStats() const;
+
+    // Process wide cache.
+    static EffectCache& Shared();
+
+private:
+    EffectCache(const EffectCache&);
+    EffectCache& operator=(const EffectCache&);
+
+    struct Master
+    {
+        ComPtr<ID3DX11Effect> Effect;
+        ID3D11Device* Device;
+        uint64 Size;
+        float LoadTime;
+    };
+
+    // Keyed by the content hash, the devices of a same content are chained.
+    std::unordered_multimap<uint64, Master> m_masters;
+    mutable std::mutex m_mutex;
+
+    uint32 m_loads;
+    uint32 m_hits;
+    double m_loadTime;
+    double m_cloneTime;
+    double m_loadTimeSaved;
+};
+
+#endif // _INCGUARD_EFFECTCACHE_H
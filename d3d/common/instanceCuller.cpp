@@ -0,0 +1,376 @@
+#include "instanceCuller.h"
+#include "coherentCulling.h"
+#include "mathHelper.h"
+#include "threadPool.h"
+#include "config.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // Instances per culling task (at least).
+    const uint32 CullChunkSize = 256;
+
+    // Coarsest LOD precise enough at the given projected size.
+    uint32 LodOfSize(float size, const float* maxSizes, uint32 lodCount)
+    {
+        uint32 lod = 0;
+        while(lod + 1 < lodCount && size <= maxSizes[lod + 1])
+            ++lod;
+        return lod;
+    }
+
+    // Radius of the bounding sphere of a mesh box.
+    float LocalBoundingRadius(const XNA::AxisAlignedBox& box)
+    {
+        return XMVectorGetX(XMVector3Length(XMLoadFloat3(&box.Extents)));
+    }
+
+    // Largest scale of the axes of a world matrix.
+    float InstanceScale(const XMFLOAT4X4& world)
+    {
+        float x = world._11 * world._11 + world._12 * world._12 + world._13 * world._13;
+        float y = world._21 * world._21 + world._22 * world._22 + world._23 * world._23;
+        float z = world._31 * world._31 + world._32 * world._32 + world._33 * world._33;
+        return sqrtf(std::max(x, std::max(y, z)));
+    }
+}
+
+InstanceCuller::InstanceCuller(uint32 occlusionWidth, uint32 occlusionHeight, uint32 maxOccluders)
+: m_octree(nullptr)
+, m_occlusionBuffer(occlusionWidth, occlusionHeight)
+, m_maxOccluders(maxOccluders)
+, m_lodCount(1)
+, m_lodHysteresis(0.0f)
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+    memset(m_lodRanges, 0, sizeof(m_lodRanges));
+    m_lodMaxSizes[0] = MathHelper::Infinity;
+}
+
+void InstanceCuller::SetMesh(const XNA::AxisAlignedBox& localBox, const XMFLOAT3* positions, uint32 vertexCount,
+    const uint32* indices, uint32 triangleCount)
+{
+    m_instances.SetLocalBox(localBox);
+
+    m_meshPositions.assign(positions, positions + vertexCount);
+    m_meshIndices.assign(indices, indices + triangleCount * 3);
+}
+
+uint32 InstanceCuller::AddInstance(CXMMATRIX world)
+{
+    m_lastFailedPlane.push_back(0);
+    m_lods.push_back(0);
+    return m_instances.Add(world);
+}
+
+void InstanceCuller::Build(const XNA::AxisAlignedBox& sceneBounds, uint32 octreeDepth)
+{
+    m_instances.UpdateBounds();
+
+    m_octree.reset(new LooseOctree(sceneBounds, octreeDepth));
+    for(uint32 i = 0; i < m_instances.Count(); ++i)
+        m_octree->Insert(i, m_instances.WorldBox(i));
+}
+
+void InstanceCuller::Update(std::vector<uint32>* pMoved)
+{
+    OC_ASSERT(m_octree);
+
+    m_moved.clear();
+    m_instances.UpdateBounds(&m_moved);
+
+    for(size_t m = 0; m < m_moved.size(); ++m)
+        m_octree->Update(m_moved[m], m_instances.WorldBox(m_moved[m]));
+
+    if(pMoved)
+        pMoved->insert(pMoved->end(), m_moved.begin(), m_moved.end());
+}
+
+void InstanceCuller::Cull(CXMMATRIX viewProj, FXMVECTOR eyePos, FrustumMethod method, bool occlusion,
+    ThreadPool* pPool, const VisibleWriter& writer)
+{
+    OC_ASSERT(m_octree);
+
+    ThreadPool& pool = pPool ? *pPool : ThreadPool::Shared();
+    uint32 instanceCount = m_instances.Count();
+
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_stats.InstanceCount = instanceCount;
+
+    if(method == FRUSTUM_NONE)
+    {
+        m_visibleInstances.resize(instanceCount);
+        for(uint32 i = 0; i < instanceCount; ++i)
+            m_visibleInstances[i] = i;
+
+        m_stats.FrustumVisible = instanceCount;
+        m_stats.Visible = instanceCount;
+        ResetLodRanges();
+        WriteVisible(pool, writer);
+        return;
+    }
+
+    // World space planes of the camera frustum, so the instances are tested
+    // with their cached world boxes.
+    XMFLOAT4 planes[6];
+    MathHelper::ExtractFrustumPlanes(viewProj, planes);
+
+    XMVECTOR planeVectors[6];
+    for(int p = 0; p < 6; ++p)
+        planeVectors[p] = XMLoadFloat4(&planes[p]);
+
+    m_frustumVisible.clear();
+
+    if(method == FRUSTUM_OCTREE)
+    {
+        // Nodes outside the frustum reject all their instances at once, the
+        // ones inside accept them without testing them one by one.
+        m_octree->CullFrustum(planeVectors, &m_frustumVisible);
+
+        m_stats.TestedNodes = m_octree->TestedNodeCount();
+        m_stats.TestedBoxes = m_octree->TestedObjectCount();
+    }
+    else
+    {
+        m_flags.resize(instanceCount);
+        m_frustumVisible.resize(instanceCount);
+
+        // Without occlusion this list is the final one.
+        bool lastPass = !occlusion || m_meshIndices.empty();
+
+        uint32 count = pool.ParallelCompact(instanceCount, CullChunkSize,
+            [&](uint32, uint32 begin, uint32 end) -> uint32
+            {
+                uint32 kept = 0;
+                for(uint32 i = begin; i < end; ++i)
+                {
+                    m_flags[i] = XNA::IntersectAxisAlignedBox6PlanesCoherent(&m_instances.WorldBox(i), planeVectors,
+                        XNA::PLANE_MASK_ALL, nullptr, &m_lastFailedPlane[i]) != 0;
+                    kept += m_flags[i];
+                }
+                return kept;
+            },
+            [&](uint32, uint32 begin, uint32 end, uint32 slot)
+            {
+                for(uint32 i = begin; i < end; ++i)
+                {
+                    if(m_flags[i])
+                    {
+                        if(lastPass && writer)
+                            writer(slot, i);
+                        m_frustumVisible[slot++] = i;
+                    }
+                }
+            });
+
+        m_frustumVisible.resize(count);
+        m_stats.TestedBoxes = instanceCount;
+    }
+
+    uint32 candidateCount = (uint32)m_frustumVisible.size();
+    m_stats.FrustumVisible = candidateCount;
+
+    if(!occlusion || m_meshIndices.empty())
+    {
+        m_visibleInstances.swap(m_frustumVisible);
+        m_stats.Visible = candidateCount;
+        ResetLodRanges();
+
+        // The octree collects its list on this thread, the linear test wrote
+        // it already.
+        if(method == FRUSTUM_OCTREE)
+            WriteVisible(pool, writer);
+        return;
+    }
+
+    RasterizeOccluders(viewProj, eyePos, pool);
+
+    // Keep the instances that are not hidden: each task counts its
+    // survivors, then writes them at the offset of its chunk.
+    m_flags.resize(candidateCount);
+    m_visibleInstances.resize(candidateCount);
+
+    std::atomic<uint32> occludedCount(0);
+    uint32 count = pool.ParallelCompact(candidateCount, CullChunkSize,
+        [&](uint32, uint32 begin, uint32 end) -> uint32
+        {
+            uint32 kept = 0;
+            for(uint32 c = begin; c < end; ++c)
+            {
+                m_flags[c] = !m_occlusionBuffer.IsOccluded(m_instances.WorldBox(m_frustumVisible[c]), viewProj);
+                kept += m_flags[c];
+            }
+
+            occludedCount += (end - begin) - kept;
+            return kept;
+        },
+        [&](uint32, uint32 begin, uint32 end, uint32 slot)
+        {
+            for(uint32 c = begin; c < end; ++c)
+            {
+                if(m_flags[c])
+                {
+                    if(writer)
+                        writer(slot, m_frustumVisible[c]);
+                    m_visibleInstances[slot++] = m_frustumVisible[c];
+                }
+            }
+        });
+
+    m_visibleInstances.resize(count);
+    m_stats.Occluded = occludedCount;
+    m_stats.Visible = count;
+    ResetLodRanges();
+}
+
+void InstanceCuller::SetLods(const float* geometricErrors, uint32 lodCount, float maxPixelError, float hysteresis)
+{
+    OC_ASSERT(lodCount >= 1 && lodCount <= MaxLods);
+
+    // The error of a LOD scales with the projected size of the bounding sphere
+    // of the local box, as SelectLods measures it: the error covers
+    // error / (2 * radius) of that diameter in pixels.
+    float radius = LocalBoundingRadius(m_instances.LocalBox());
+
+    m_lodCount = lodCount;
+    m_lodHysteresis = hysteresis;
+    for(uint32 lod = 0; lod < lodCount; ++lod)
+    {
+        m_lodMaxSizes[lod] = geometricErrors[lod] > 0.0f ?
+            2.0f * maxPixelError * radius / geometricErrors[lod] : MathHelper::Infinity;
+    }
+
+    // Every instance starts at the full mesh.
+    std::fill(m_lods.begin(), m_lods.end(), (uint8)0);
+}
+
+void InstanceCuller::SelectLods(FXMVECTOR eyePos, float fovY, float viewportHeight, ThreadPool* pPool,
+    const VisibleWriter& writer)
+{
+    ThreadPool& pool = pPool ? *pPool : ThreadPool::Shared();
+    if(m_lodCount == 1)
+    {
+        WriteVisible(pool, writer);
+        return;
+    }
+
+    uint32 visibleCount = (uint32)m_visibleInstances.size();
+    uint32 chunkCount = pool.ChunkCount(visibleCount, CullChunkSize);
+
+    // Pixels covered by one unit at distance one.
+    float pixelsPerUnit = 0.5f * viewportHeight / tanf(0.5f * fovY);
+    float localRadius = LocalBoundingRadius(m_instances.LocalBox());
+
+    // Each task picks the LOD of its instances and counts them per LOD.
+    m_lodHistograms.assign(chunkCount * MaxLods, 0);
+    pool.ParallelFor(visibleCount, CullChunkSize, [&](uint32 chunk, uint32 begin, uint32 end)
+    {
+        uint32* histogram = &m_lodHistograms[chunk * MaxLods];
+        for(uint32 v = begin; v < end; ++v)
+        {
+            uint32 i = m_visibleInstances[v];
+            const XNA::AxisAlignedBox& box = m_instances.WorldBox(i);
+
+            // Diameter on screen of the bounding sphere of the local box, in
+            // world space: the sphere SetLods measured the errors against, not
+            // the one of the world box, which grows with the rotation. The
+            // world box is centered on the transformed local center. The
+            // camera inside the sphere gets the full mesh.
+            XMVECTOR center = XMLoadFloat3(&box.Center);
+            float radius = localRadius * InstanceScale(m_instances.World(i));
+            float distance = XMVectorGetX(XMVector3Length(center - eyePos));
+            float size = distance > radius ? 2.0f * radius * pixelsPerUnit / distance : MathHelper::Infinity;
+
+            // Keep the current LOD while it is between the LODs chosen with
+            // the size enlarged and reduced by the hysteresis.
+            uint32 finest = LodOfSize(size * (1.0f + m_lodHysteresis), m_lodMaxSizes, m_lodCount);
+            uint32 coarsest = LodOfSize(size * (1.0f - m_lodHysteresis), m_lodMaxSizes, m_lodCount);
+            uint32 lod = std::min(std::max((uint32)m_lods[i], finest), coarsest);
+
+            m_lods[i] = (uint8)lod;
+            ++histogram[lod];
+        }
+    });
+
+    // LOD ranges, and where each chunk writes in them.
+    uint32 offset = 0;
+    for(uint32 lod = 0; lod < MaxLods; ++lod)
+    {
+        m_lodRanges[lod].First = offset;
+        for(uint32 chunk = 0; chunk < chunkCount; ++chunk)
+        {
+            uint32 count = m_lodHistograms[chunk * MaxLods + lod];
+            m_lodHistograms[chunk * MaxLods + lod] = offset;
+            offset += count;
+        }
+        m_lodRanges[lod].Count = offset - m_lodRanges[lod].First;
+    }
+
+    // Same chunks as the first pass.
+    m_lodSorted.resize(visibleCount);
+    pool.ParallelFor(visibleCount, CullChunkSize, [&](uint32 chunk, uint32 begin, uint32 end)
+    {
+        uint32* slots = &m_lodHistograms[chunk * MaxLods];
+        for(uint32 v = begin; v < end; ++v)
+        {
+            uint32 i = m_visibleInstances[v];
+            uint32 slot = slots[m_lods[i]]++;
+            if(writer)
+                writer(slot, i);
+            m_lodSorted[slot] = i;
+        }
+    });
+
+    m_visibleInstances.swap(m_lodSorted);
+}
+
+void InstanceCuller::ResetLodRanges()
+{
+    memset(m_lodRanges, 0, sizeof(m_lodRanges));
+    m_lodRanges[0].Count = (uint32)m_visibleInstances.size();
+}
+
+void InstanceCuller::WriteVisible(ThreadPool& pool, const VisibleWriter& writer)
+{
+    if(!writer)
+        return;
+
+    pool.ParallelFor((uint32)m_visibleInstances.size(), CullChunkSize, [&](uint32, uint32 begin, uint32 end)
+    {
+        for(uint32 v = begin; v < end; ++v)
+            writer(v, m_visibleInstances[v]);
+    });
+}
+
+void InstanceCuller::RasterizeOccluders(CXMMATRIX viewProj, FXMVECTOR eyePos, ThreadPool& pool)
+{
+    // The nearest instances in the frustum hide the most, rasterize them.
+    m_occluderCandidates.clear();
+    for(size_t c = 0; c < m_frustumVisible.size(); ++c)
+    {
+        uint32 i = m_frustumVisible[c];
+        XMVECTOR d = XMVector3LengthSq(XMLoadFloat3(&m_instances.WorldBox(i).Center) - eyePos);
+        m_occluderCandidates.push_back(std::make_pair(XMVectorGetX(d), i));
+    }
+
+    uint32 occluderCount = std::min((uint32)m_occluderCandidates.size(), m_maxOccluders);
+    std::partial_sort(m_occluderCandidates.begin(), m_occluderCandidates.begin() + occluderCount,
+        m_occluderCandidates.end());
+
+    m_rasterizeTimer.Reset();
+
+    m_occlusionBuffer.Clear();
+    for(uint32 o = 0; o < occluderCount; ++o)
+    {
+        XMMATRIX world = XMLoadFloat4x4(&m_instances.World(m_occluderCandidates[o].second));
+        m_occlusionBuffer.AddOccluder(&m_meshPositions[0], sizeof(XMFLOAT3), (uint32)m_meshPositions.size(),
+            &m_meshIndices[0], (uint32)m_meshIndices.size() / 3, XMMatrixMultiply(world, viewProj));
+    }
+    m_occlusionBuffer.Rasterize(&pool);
+
+    m_rasterizeTimer.Tick();
+    m_stats.RasterizeTime = m_rasterizeTimer.DeltaTime();
+}
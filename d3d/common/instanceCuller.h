@@ -0,0 +1,150 @@
+//---------------------------------------------------------------------------------------
+//
+// Visibility of the instances of one mesh.
+//
+// Groups the instance store, the octree over the instances and the occlusion
+// buffer so the demos and the headless benchmark run the same culling code.
+// Cull produces the list of visible instances. SelectLods then sorts that
+// list by level of detail, one instanced draw per LOD drawing its range. The
+// call that settles the order can be given a writer, run by the tasks that
+// fill the list, so the caller writes the instance data (in whatever format)
+// straight to its mapped instance buffer.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_INSTANCECULLER_H
+#define _INCGUARD_INSTANCECULLER_H
+
+#include "instanceStore.h"
+#include "looseOctree.h"
+#include "occlusionBuffer.h"
+#include "timer.h"
+#include "types.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+class ThreadPool;
+
+class InstanceCuller
+{
+public:
+    enum FrustumMethod
+    {
+        FRUSTUM_NONE = 0,       // Every instance is visible (occlusion is skipped too).
+        FRUSTUM_LINEAR,         // Every instance box is tested, in parallel.
+        FRUSTUM_OCTREE          // Hierarchical test through the octree.
+    };
+
+    struct Stats
+    {
+        uint32 InstanceCount;
+        uint32 FrustumVisible;  // In the frustum.
+        uint32 Occluded;        // In the frustum but hidden.
+        uint32 Visible;
+        uint32 TestedNodes;     // Octree nodes and instance boxes tested against the frustum.
+        uint32 TestedBoxes;
+        float RasterizeTime;    // Seconds spent rasterizing the occluders, included in the Cull call.
+    };
+
+    // Range of VisibleInstances drawn with one LOD.
+    struct LodRange
+    {
+        uint32 First;
+        uint32 Count;
+    };
+
+    static const uint32 MaxLods = 8;
+
+    // Called from the pool tasks with each entry of VisibleInstances: its slot
+    // and the instance index. Different tasks write different slots.
+    typedef std::function<void(uint32 slot, uint32 instance)> VisibleWriter;
+
+    InstanceCuller(uint32 occlusionWidth = 320, uint32 occlusionHeight = 180, uint32 maxOccluders = 16);
+
+    // Bounds and geometry of the instanced mesh in its local space. The
+    // geometry is copied and rasterized as occluder, it may be empty.
+    void SetMesh(const XNA::AxisAlignedBox& localBox, const XMFLOAT3* positions, uint32 vertexCount,
+        const uint32* indices, uint32 triangleCount);
+
+    // See OcclusionBuffer, off by default.
+    void SetConservativeOcclusion(bool conservative) { m_occlusionBuffer.SetConservative(conservative); }
+
+    uint32 AddInstance(CXMMATRIX world);
+    void SetWorld(uint32 index, CXMMATRIX world) { m_instances.SetWorld(index, world); }
+    const InstanceStore& Instances() const { return m_instances; }
+
+    // Build the octree over the instances added so far. sceneBounds should
+    // contain the instance centers, see LooseOctree.
+    void Build(const XNA::AxisAlignedBox& sceneBounds, uint32 octreeDepth = 5);
+
+    // Refresh the bounds of the instances moved by SetWorld. Their indices are
+    // appended to pMoved if not null.
+    void Update(std::vector<uint32>* pMoved = nullptr);
+
+    // Find the visible instances. The list only depends on the instances and
+    // the camera, not on the thread scheduling. pPool may be null, the shared
+    // pool is used then. writer, if set, gets every visible instance from the
+    // pass that writes it to the list.
+    void Cull(CXMMATRIX viewProj, FXMVECTOR eyePos, FrustumMethod method, bool occlusion,
+        ThreadPool* pPool = nullptr, const VisibleWriter& writer = VisibleWriter());
+
+    // Levels of detail of the mesh, from the full mesh. geometricErrors are the
+    // largest distances (mesh local units) from each LOD to the full mesh, the
+    // coarsest LOD whose error projects to at most maxPixelError pixels is
+    // used. hysteresis widens the switch distances by that ratio in both
+    // directions so the instances near a switch do not flicker between LODs.
+    // Called after SetMesh.
+    void SetLods(const float* geometricErrors, uint32 lodCount, float maxPixelError = 1.0f,
+        float hysteresis = 0.1f);
+
+    // Pick the LOD of each visible instance from the projected size of the
+    // bounding sphere of the mesh box, scaled by the instance world matrix, and
+    // sort VisibleInstances by LOD (the order within a LOD is kept).
+    // Called after Cull, which puts every visible instance in LOD 0. writer, if
+    // set, gets every visible instance at its sorted slot.
+    void SelectLods(FXMVECTOR eyePos, float fovY, float viewportHeight, ThreadPool* pPool = nullptr,
+        const VisibleWriter& writer = VisibleWriter());
+
+    uint32 LodCount() const { return m_lodCount; }
+    const LodRange& VisibleLodRange(uint32 lod) const { return m_lodRanges[lod]; }
+
+    const std::vector<uint32>& VisibleInstances() const { return m_visibleInstances; }
+    const Stats& LastStats() const { return m_stats; }
+
+private:
+    void RasterizeOccluders(CXMMATRIX viewProj, FXMVECTOR eyePos, ThreadPool& pool);
+    void ResetLodRanges();
+    void WriteVisible(ThreadPool& pool, const VisibleWriter& writer);
+
+    InstanceStore m_instances;
+    std::unique_ptr<LooseOctree> m_octree;
+    std::vector<BYTE> m_lastFailedPlane;    // Used by the linear test, the octree keeps its own.
+
+    std::vector<XMFLOAT3> m_meshPositions;
+    std::vector<uint32> m_meshIndices;
+
+    OcclusionBuffer m_occlusionBuffer;
+    uint32 m_maxOccluders;
+    Timer m_rasterizeTimer;
+    std::vector<std::pair<float, uint32> > m_occluderCandidates;
+
+    std::vector<uint32> m_frustumVisible;
+    std::vector<uint32> m_visibleInstances;
+    std::vector<uint8> m_flags;
+
+    // Largest projected diameter (pixels) of the bounding sphere of the mesh
+    // box for which each LOD is precise enough, decreasing.
+    uint32 m_lodCount;
+    float m_lodMaxSizes[MaxLods];
+    float m_lodHysteresis;
+    std::vector<uint8> m_lods;              // Current LOD of each instance.
+    std::vector<uint32> m_lodHistograms;    // Instances per LOD in each task chunk.
+    std::vector<uint32> m_lodSorted;
+    LodRange m_lodRanges[MaxLods];
+
+    std::vector<uint32> m_moved;
+    Stats m_stats;
+};
+
+#endif // _INCGUARD_INSTANCECULLER_H
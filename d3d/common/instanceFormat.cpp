@@ -0,0 +1,60 @@
+#include "instanceFormat.h"
+
+void EncodeCompactInstance(CompactInstanceData* pOut, CXMMATRIX world, FXMVECTOR color)
+{
+    float scale = XMVectorGetX(XMVector3Length(world.r[0]));
+
+    // Rotation of the unscaled matrix, q and -q being the same rotation
+    // the sign is fixed so w is never negative.
+    XMMATRIX rotation = world;
+    if(scale > 0.0f)
+    {
+        float invScale = 1.0f / scale;
+        rotation.r[0] *= invScale;
+        rotation.r[1] *= invScale;
+        rotation.r[2] *= invScale;
+    }
+    rotation.r[3] = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+
+    XMVECTOR q = XMQuaternionNormalize(XMQuaternionRotationMatrix(rotation));
+    if(XMVectorGetW(q) < 0.0f)
+        q = XMVectorNegate(q);
+
+    XMStoreFloat3(&pOut->Position, world.r[3]);
+    pOut->Scale = scale;
+    XMStoreShortN4(&pOut->Rotation, q);
+    XMStoreColor(&pOut->Color, color);
+}
+
+void EncodeCompactInstances(CompactInstanceData* pOut, const XMFLOAT4X4* pWorlds, uint32 worldStride,
+    const XMFLOAT4* pColors, uint32 colorStride, uint32 count)
+{
+    const uint8* world = reinterpret_cast<const uint8*>(pWorlds);
+    const uint8* color = reinterpret_cast<const uint8*>(pColors);
+
+    for(uint32 i = 0; i < count; ++i)
+    {
+        EncodeCompactInstance(&pOut[i],
+            XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(world + i * worldStride)),
+            XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(color + i * colorStride)));
+    }
+}
+
+XMMATRIX DecodeCompactInstanceWorld(const CompactInstanceData& instance)
+{
+    // Same as the vertex shader: the 16 bit quaternion is renormalized.
+    XMVECTOR q = XMQuaternionNormalize(XMLoadShortN4(&instance.Rotation));
+
+    XMMATRIX world = XMMatrixRotationQuaternion(q);
+    world.r[0] *= instance.Scale;
+    world.r[1] *= instance.Scale;
+    world.r[2] *= instance.Scale;
+    world.r[3] = XMVectorSet(instance.Position.x, instance.Position.y, instance.Position.z, 1.0f);
+
+    return world;
+}
+
+XMVECTOR DecodeCompactInstanceColor(const CompactInstanceData& instance)
+{
+    return XMLoadColor(&instance.Color);
+}
@@ -0,0 +1,40 @@
+//---------------------------------------------------------------------------------------
+//
+// Compact per instance data for instanced drawing.
+//
+// A rigid transform with uniform scale is stored as translation + scale and a
+// quaternion in 16 bit normalized integers, the color as 8 bit BGRA: 28 bytes
+// instead of the 80 of a full matrix and a float color. The vertex shader
+// rebuilds the transform (DXGI_FORMAT_R16G16B16A16_SNORM rotation,
+// DXGI_FORMAT_B8G8R8A8_UNORM color).
+//
+// Shear and non uniform scale cannot be represented: the scale of the first
+// matrix row is used for all the axes.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_INSTANCEFORMAT_H
+#define _INCGUARD_INSTANCEFORMAT_H
+
+#include <Windows.h>
+#include <xnamath.h>
+#include "types.h"
+
+struct CompactInstanceData
+{
+    XMFLOAT3 Position;
+    float Scale;
+    XMSHORTN4 Rotation;     // Unit quaternion, w >= 0.
+    XMCOLOR Color;
+};
+
+void EncodeCompactInstance(CompactInstanceData* pOut, CXMMATRIX world, FXMVECTOR color);
+
+// Encode count instances, the matrices and colors being read with the given strides.
+void EncodeCompactInstances(CompactInstanceData* pOut, const XMFLOAT4X4* pWorlds, uint32 worldStride,
+    const XMFLOAT4* pColors, uint32 colorStride, uint32 count);
+
+XMMATRIX DecodeCompactInstanceWorld(const CompactInstanceData& instance);
+XMVECTOR DecodeCompactInstanceColor(const CompactInstanceData& instance);
+
+#endif // _INCGUARD_INSTANCEFORMAT_H
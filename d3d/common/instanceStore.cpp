@@ -0,0 +1,82 @@
+#include "instanceStore.h"
+#include <cmath>
+
+InstanceStore::InstanceStore()
+{
+    m_localBox.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    m_localBox.Extents = XMFLOAT3(0.0f, 0.0f, 0.0f);
+}
+
+void InstanceStore::SetLocalBox(const XNA::AxisAlignedBox& box)
+{
+    m_localBox = box;
+
+    for(uint32 i = 0; i < Count(); ++i)
+        MarkDirty(i);
+}
+
+uint32 InstanceStore::Add(CXMMATRIX world)
+{
+    uint32 index = Count();
+
+    m_world.push_back(XMFLOAT4X4());
+    XMStoreFloat4x4(&m_world.back(), world);
+    m_worldBoxes.push_back(m_localBox);
+    m_isDirty.push_back(0);
+
+    MarkDirty(index);
+    return index;
+}
+
+void InstanceStore::Clear()
+{
+    m_world.clear();
+    m_worldBoxes.clear();
+    m_dirtyList.clear();
+    m_isDirty.clear();
+}
+
+void InstanceStore::SetWorld(uint32 index, CXMMATRIX world)
+{
+    XMStoreFloat4x4(&m_world[index], world);
+    MarkDirty(index);
+}
+
+void InstanceStore::MarkDirty(uint32 index)
+{
+    if(m_isDirty[index])
+        return;
+
+    m_isDirty[index] = 1;
+    m_dirtyList.push_back(index);
+}
+
+uint32 InstanceStore::UpdateBounds(std::vector<uint32>* pUpdated)
+{
+    XMVECTOR localCenter = XMLoadFloat3(&m_localBox.Center);
+    const XMFLOAT3& e = m_localBox.Extents;
+
+    for(size_t d = 0; d < m_dirtyList.size(); ++d)
+    {
+        uint32 i = m_dirtyList[d];
+        const XMFLOAT4X4& W = m_world[i];
+        XNA::AxisAlignedBox& box = m_worldBoxes[i];
+
+        // The center is transformed as a point, the extents by the absolute
+        // value of the matrix (Arvo), no inverse nor decomposition needed.
+        XMStoreFloat3(&box.Center, XMVector3TransformCoord(localCenter, XMLoadFloat4x4(&W)));
+        box.Extents = XMFLOAT3(
+            e.x*fabsf(W._11) + e.y*fabsf(W._21) + e.z*fabsf(W._31),
+            e.x*fabsf(W._12) + e.y*fabsf(W._22) + e.z*fabsf(W._32),
+            e.x*fabsf(W._13) + e.y*fabsf(W._23) + e.z*fabsf(W._33));
+
+        m_isDirty[i] = 0;
+    }
+
+    uint32 updated = (uint32)m_dirtyList.size();
+    if(pUpdated)
+        pUpdated->insert(pUpdated->end(), m_dirtyList.begin(), m_dirtyList.end());
+
+    m_dirtyList.clear();
+    return updated;
+}
@@ -0,0 +1,61 @@
+//---------------------------------------------------------------------------------------
+//
+// Instances of one mesh with cached world space bounds.
+//
+// The world box of an instance is derived from the local box of the mesh and
+// the world matrix, and recomputed only when that matrix changes: SetWorld
+// marks the instance dirty and UpdateBounds refreshes the dirty instances.
+// Culling can then test the cached boxes against world space planes directly.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_INSTANCESTORE_H
+#define _INCGUARD_INSTANCESTORE_H
+
+#include "xnacollision.h"
+#include "types.h"
+#include <vector>
+
+class InstanceStore
+{
+public:
+    InstanceStore();
+
+    // Bounds of the mesh in its local space. Every instance becomes dirty.
+    void SetLocalBox(const XNA::AxisAlignedBox& box);
+    const XNA::AxisAlignedBox& LocalBox() const { return m_localBox; }
+
+    // Add an instance, returns its index. The instance starts dirty.
+    uint32 Add(CXMMATRIX world);
+    void Clear();
+
+    uint32 Count() const { return (uint32)m_world.size(); }
+
+    void SetWorld(uint32 index, CXMMATRIX world);
+    const XMFLOAT4X4& World(uint32 index) const { return m_world[index]; }
+
+    // Recompute the world boxes of the dirty instances, returns how many were
+    // updated. Their indices are appended to pUpdated if not null (to update
+    // a spatial structure with the new boxes).
+    uint32 UpdateBounds(std::vector<uint32>* pUpdated = nullptr);
+
+    // Valid for clean instances (after UpdateBounds).
+    const XNA::AxisAlignedBox& WorldBox(uint32 index) const { return m_worldBoxes[index]; }
+    const XNA::AxisAlignedBox* WorldBoxes() const { return m_worldBoxes.empty() ? nullptr : &m_worldBoxes[0]; }
+
+    uint32 DirtyCount() const { return (uint32)m_dirtyList.size(); }
+
+private:
+    void MarkDirty(uint32 index);
+
+    XNA::AxisAlignedBox m_localBox;
+
+    std::vector<XMFLOAT4X4> m_world;
+    std::vector<XNA::AxisAlignedBox> m_worldBoxes;
+
+    // Dirty instances, each one listed once (m_isDirty tells if it is already listed).
+    std::vector<uint32> m_dirtyList;
+    std::vector<uint8> m_isDirty;
+};
+
+#endif // _INCGUARD_INSTANCESTORE_H
@@ -0,0 +1,237 @@
+#include "looseOctree.h"
+#include "coherentCulling.h"
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+
+LooseOctree::LooseOctree(const XNA::AxisAlignedBox& bounds, uint32 maxDepth)
+: m_maxDepth(maxDepth)
+, m_testedNodeCount(0)
+, m_testedObjectCount(0)
+{
+    Node root;
+    root.Center = bounds.Center;
+    root.HalfSize = std::max(bounds.Extents.x, std::max(bounds.Extents.y, bounds.Extents.z));
+    root.Parent = InvalidNode;
+    root.Depth = 0;
+    std::fill(root.Children, root.Children + 8, 0);
+    root.SubtreeCount = 0;
+    root.LastFailedPlane = 0;
+
+    m_nodes.push_back(root);
+}
+
+void LooseOctree::Clear()
+{
+    // Keep the root only.
+    m_nodes.resize(1);
+    std::fill(m_nodes[0].Children, m_nodes[0].Children + 8, 0);
+    m_nodes[0].SubtreeCount = 0;
+    m_nodes[0].Objects.clear();
+
+    m_objects.clear();
+}
+
+bool LooseOctree::FitsNode(const Node& node, const XNA::AxisAlignedBox& box) const
+{
+    const XMFLOAT3& c = box.Center;
+    const XMFLOAT3& e = box.Extents;
+    float loose = 2.0f * node.HalfSize;
+
+    return fabsf(c.x - node.Center.x) + e.x <= loose &&
+           fabsf(c.y - node.Center.y) + e.y <= loose &&
+           fabsf(c.z - node.Center.z) + e.z <= loose;
+}
+
+uint32 LooseOctree::FindNode(const XNA::AxisAlignedBox& box)
+{
+    const XMFLOAT3& c = box.Center;
+    float size = std::max(box.Extents.x, std::max(box.Extents.y, box.Extents.z));
+
+    const Node& root = m_nodes[0];
+    if(fabsf(c.x - root.Center.x) > root.HalfSize ||
+       fabsf(c.y - root.Center.y) > root.HalfSize ||
+       fabsf(c.z - root.Center.z) > root.HalfSize)
+    {
+        return 0;
+    }
+
+    // Go down while the child cell is at least as large as the box.
+    uint32 node = 0;
+    while(m_nodes[node].Depth < m_maxDepth)
+    {
+        float childHalf = 0.5f * m_nodes[node].HalfSize;
+        if(size > childHalf)
+            break;
+
+        const XMFLOAT3 nodeCenter = m_nodes[node].Center;
+        uint32 octant = (c.x >= nodeCenter.x ? 1 : 0) | (c.y >= nodeCenter.y ? 2 : 0) | (c.z >= nodeCenter.z ? 4 : 0);
+
+        if(m_nodes[node].Children[octant] == 0)
+        {
+            Node child;
+            child.Center = XMFLOAT3(
+                nodeCenter.x + ((octant & 1) ? childHalf : -childHalf),
+                nodeCenter.y + ((octant & 2) ? childHalf : -childHalf),
+                nodeCenter.z + ((octant & 4) ? childHalf : -childHalf));
+            child.HalfSize = childHalf;
+            child.Parent = node;
+            child.Depth = m_nodes[node].Depth + 1;
+            std::fill(child.Children, child.Children + 8, 0);
+            child.SubtreeCount = 0;
+            child.LastFailedPlane = 0;
+
+            // Empty nodes are kept, they are skipped by SubtreeCount.
+            m_nodes.push_back(child);
+            m_nodes[node].Children[octant] = (uint32)m_nodes.size() - 1;
+        }
+
+        node = m_nodes[node].Children[octant];
+    }
+
+    return node;
+}
+
+void LooseOctree::Link(uint32 id, uint32 node)
+{
+    Object& object = m_objects[id];
+    object.Node = node;
+    object.Slot = (uint32)m_nodes[node].Objects.size();
+    m_nodes[node].Objects.push_back(id);
+
+    for(uint32 n = node; n != InvalidNode; n = m_nodes[n].Parent)
+        ++m_nodes[n].SubtreeCount;
+}
+
+void LooseOctree::Unlink(uint32 id)
+{
+    Object& object = m_objects[id];
+    std::vector<uint32>& objects = m_nodes[object.Node].Objects;
+
+    // Swap with the last object of the node.
+    uint32 last = objects.back();
+    objects[object.Slot] = last;
+    m_objects[last].Slot = object.Slot;
+    objects.pop_back();
+
+    for(uint32 n = object.Node; n != InvalidNode; n = m_nodes[n].Parent)
+        --m_nodes[n].SubtreeCount;
+
+    object.Node = InvalidNode;
+}
+
+void LooseOctree::Insert(uint32 id, const XNA::AxisAlignedBox& box)
+{
+    if(id >= m_objects.size())
+    {
+        Object empty;
+        empty.Node = InvalidNode;
+        empty.Slot = 0;
+        empty.LastFailedPlane = 0;
+        m_objects.resize(id + 1, empty);
+    }
+
+    OC_ASSERT(m_objects[id].Node == InvalidNode);
+
+    m_objects[id].Box = box;
+    m_objects[id].LastFailedPlane = 0;
+    Link(id, FindNode(box));
+}
+
+void LooseOctree::Update(uint32 id, const XNA::AxisAlignedBox& box)
+{
+    OC_ASSERT(Contains(id));
+
+    Object& object = m_objects[id];
+    object.Box = box;
+
+    // Still inside the loose bounds of its node: nothing to move. The root
+    // also keeps the objects outside the tree.
+    if(object.Node == 0 ? FindNode(box) == 0 : FitsNode(m_nodes[object.Node], box))
+        return;
+
+    Unlink(id);
+    Link(id, FindNode(box));
+}
+
+void LooseOctree::Remove(uint32 id)
+{
+    OC_ASSERT(Contains(id));
+    Unlink(id);
+}
+
+void LooseOctree::AcceptSubtree(uint32 node, std::vector<uint32>* pVisible)
+{
+    const Node& n = m_nodes[node];
+    if(n.SubtreeCount == 0)
+        return;
+
+    pVisible->insert(pVisible->end(), n.Objects.begin(), n.Objects.end());
+
+    for(int i = 0; i < 8; ++i)
+    {
+        if(n.Children[i] != 0)
+            AcceptSubtree(n.Children[i], pVisible);
+    }
+}
+
+void LooseOctree::CullFrustum(const XMVECTOR* pPlanes, std::vector<uint32>* pVisible)
+{
+    m_testedNodeCount = 0;
+    m_testedObjectCount = 0;
+
+    if(m_nodes[0].SubtreeCount == 0)
+        return;
+
+    // The root is not tested: it also holds the objects outside the tree bounds.
+    m_stack.clear();
+    StackEntry root = { 0, XNA::PLANE_MASK_ALL };
+    m_stack.push_back(root);
+
+    while(!m_stack.empty())
+    {
+        StackEntry entry = m_stack.back();
+        m_stack.pop_back();
+
+        UINT mask = entry.PlaneMask;
+        Node& node = m_nodes[entry.Node];
+
+        if(entry.Node != 0)
+        {
+            XNA::AxisAlignedBox looseBox;
+            looseBox.Center = node.Center;
+            looseBox.Extents = XMFLOAT3(2.0f * node.HalfSize, 2.0f * node.HalfSize, 2.0f * node.HalfSize);
+
+            ++m_testedNodeCount;
+            INT result = XNA::IntersectAxisAlignedBox6PlanesCoherent(&looseBox, pPlanes, mask, &mask, &node.LastFailedPlane);
+            if(result == 0)
+                continue;
+
+            if(result == 2)
+            {
+                AcceptSubtree(entry.Node, pVisible);
+                continue;
+            }
+        }
+
+        for(size_t i = 0; i < node.Objects.size(); ++i)
+        {
+            Object& object = m_objects[node.Objects[i]];
+
+            ++m_testedObjectCount;
+            if(XNA::IntersectAxisAlignedBox6PlanesCoherent(&object.Box, pPlanes, mask, nullptr, &object.LastFailedPlane) != 0)
+                pVisible->push_back(node.Objects[i]);
+        }
+
+        // Pushed in reverse so the children are visited in octant order.
+        for(int i = 7; i >= 0; --i)
+        {
+            uint32 child = node.Children[i];
+            if(child != 0 && m_nodes[child].SubtreeCount != 0)
+            {
+                StackEntry childEntry = { child, mask };
+                m_stack.push_back(childEntry);
+            }
+        }
+    }
+}
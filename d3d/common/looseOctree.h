@@ -0,0 +1,96 @@
+//---------------------------------------------------------------------------------------
+//
+// Loose octree over object bounding boxes.
+//
+// Each node covers a cube of the world, its loose bounds being twice as large.
+// An object is stored in the deepest node whose cell contains its center and
+// whose half size is at least the largest extent of its box, so it always
+// lies in the loose bounds of its node. Objects never straddle nodes and a
+// moving object only changes node when it leaves the loose bounds.
+//
+// Frustum culling walks the nodes with the coherent plane tests: a node
+// outside the frustum rejects its whole subtree and a node inside accepts it
+// without any further test, so the cost follows the number of nodes on the
+// frustum boundary rather than the number of objects.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_LOOSEOCTREE_H
+#define _INCGUARD_LOOSEOCTREE_H
+
+#include "xnacollision.h"
+#include "types.h"
+#include <vector>
+
+class LooseOctree
+{
+public:
+    // bounds: region the tree subdivides (made cubic). Objects whose center is
+    // outside stay in the root node, which is still correct but not culled hierarchically.
+    // maxDepth bounds the node count: small objects share the deepest nodes
+    // instead of getting a node each.
+    LooseOctree(const XNA::AxisAlignedBox& bounds, uint32 maxDepth = 5);
+
+    // Ids are small integers (instance indices), the storage grows to the largest one.
+    void Insert(uint32 id, const XNA::AxisAlignedBox& box);
+    void Update(uint32 id, const XNA::AxisAlignedBox& box);
+    void Remove(uint32 id);
+    void Clear();
+
+    bool Contains(uint32 id) const { return id < m_objects.size() && m_objects[id].Node != InvalidNode; }
+
+    // Append the ids of the objects that are not outside the 6 planes (outside
+    // is the positive side). The order only depends on the tree content.
+    void CullFrustum(const XMVECTOR* pPlanes, std::vector<uint32>* pVisible);
+
+    uint32 NodeCount() const { return (uint32)m_nodes.size(); }
+
+    // Nodes and objects tested by the last CullFrustum call.
+    uint32 TestedNodeCount() const { return m_testedNodeCount; }
+    uint32 TestedObjectCount() const { return m_testedObjectCount; }
+
+private:
+    static const uint32 InvalidNode = 0xffffffff;
+
+    struct Node
+    {
+        XMFLOAT3 Center;
+        float HalfSize;             // Half size of the cell, the loose bounds are twice as large.
+        uint32 Parent;
+        uint32 Depth;
+        uint32 Children[8];         // 0 for none (the root is never a child).
+        uint32 SubtreeCount;        // Objects in the node and its descendants.
+        BYTE LastFailedPlane;
+        std::vector<uint32> Objects;
+    };
+
+    struct Object
+    {
+        XNA::AxisAlignedBox Box;
+        uint32 Node;
+        uint32 Slot;                // Position in the object list of the node.
+        BYTE LastFailedPlane;
+    };
+
+    uint32 FindNode(const XNA::AxisAlignedBox& box);
+    bool FitsNode(const Node& node, const XNA::AxisAlignedBox& box) const;
+    void Link(uint32 id, uint32 node);
+    void Unlink(uint32 id);
+    void AcceptSubtree(uint32 node, std::vector<uint32>* pVisible);
+
+    std::vector<Node> m_nodes;
+    std::vector<Object> m_objects;
+    uint32 m_maxDepth;
+
+    struct StackEntry
+    {
+        uint32 Node;
+        UINT PlaneMask;
+    };
+    std::vector<StackEntry> m_stack;
+
+    uint32 m_testedNodeCount;
+    uint32 m_testedObjectCount;
+};
+
+#endif // _INCGUARD_LOOSEOCTREE_H
@@ -0,0 +1,133 @@
+//---------------------------------------------------------------------------------------
+//
+// Least recently used cache with a memory budget.
+//
+// The values are immutable and reference counted: an evicted value stays alive while
+// a user holds it, the cache only drops its own reference. Insert evicts the least
+// recently used values until the new one fits the budget (a value larger than the
+// whole budget is still kept, alone). Not thread safe, the users lock around it.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_LRUCACHE_H
+#define _INCGUARD_LRUCACHE_H
+
+#include "types.h"
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+template<typename T>
+class LruCache
+{
+public:
+    typedef std::shared_ptr<const T> ValuePtr;
+
+    struct Stats
+    {
+        uint64 Hits;
+        uint64 Misses;
+        uint64 Evictions;
+        uint32 ResidentValues;
+        uint64 ResidentBytes;
+    };
+
+    explicit LruCache(uint64 byteBudget)
+    : m_budget(byteBudget)
+    , m_residentBytes(0)
+    , m_hits(0)
+    , m_misses(0)
+    , m_evictions(0)
+    {
+    }
+
+    // Value of the key, made the most recently used. Null if it is not in the
+    // cache.
+    ValuePtr Find(uint32 key)
+    {
+        auto it = m_index.find(key);
+        if(it == m_index.end())
+        {
+            ++m_misses;
+            return nullptr;
+        }
+
+        ++m_hits;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return it->second->Value;
+    }
+
+    // Add a value, bytes being its memory. Replaces the value already cached
+    // for the key, if any.
+    void Insert(uint32 key, const ValuePtr& value, uint64 bytes)
+    {
+        auto it = m_index.find(key);
+        if(it != m_index.end())
+        {
+            m_residentBytes -= it->second->Bytes;
+            m_entries.erase(it->second);
+            m_index.erase(it);
+        }
+
+        while(!m_entries.empty() && m_residentBytes + bytes > m_budget)
+        {
+            Entry& last = m_entries.back();
+            m_residentBytes -= last.Bytes;
+            m_index.erase(last.Key);
+            m_entries.pop_back();
+            ++m_evictions;
+        }
+
+        Entry entry;
+        entry.Key = key;
+        entry.Value = value;
+        entry.Bytes = bytes;
+
+        m_entries.push_front(entry);
+        m_index[key] = m_entries.begin();
+        m_residentBytes += bytes;
+    }
+
+    void Clear()
+    {
+        m_entries.clear();
+        m_index.clear();
+        m_residentBytes = 0;
+    }
+
+    uint64 Budget() const { return m_budget; }
+
+    Stats GetStats() const
+    {
+        Stats stats;
+        stats.Hits = m_hits;
+        stats.Misses = m_misses;
+        stats.Evictions = m_evictions;
+        stats.ResidentValues = (uint32)m_entries.size();
+        stats.ResidentBytes = m_residentBytes;
+        return stats;
+    }
+
+private:
+    LruCache(const LruCache&);
+    LruCache& operator=(const LruCache&);
+
+    struct Entry
+    {
+        uint32 Key;
+        ValuePtr Value;
+        uint64 Bytes;
+    };
+
+    // Most recently used first.
+    std::list<Entry> m_entries;
+    std::unordered_map<uint32, typename std::list<Entry>::iterator> m_index;
+
+    uint64 m_budget;
+    uint64 m_residentBytes;
+    uint64 m_hits;
+    uint64 m_misses;
+    uint64 m_evictions;
+};
+
+#endif // _INCGUARD_LRUCACHE_H
@@ -0,0 +1,95 @@
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mappedFile.h"
+
+MappedFile::MappedFile()
+: m_pData(nullptr)
+, m_size(0)
+#if defined(_WIN32)
+, m_file(INVALID_HANDLE_VALUE)
+, m_mapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const char* fileName)
+{
+    Close();
+
+#if defined(_WIN32)
+    m_file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(m_file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if(GetFileSizeEx(m_file, &size) && size.QuadPart > 0)
+    {
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(m_mapping)
+        {
+            m_pData = reinterpret_cast<const uint8*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+            m_size = (uint64)size.QuadPart;
+        }
+    }
+#else
+    int fd = open(fileName, O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    struct stat status;
+    if(fstat(fd, &status) == 0 && status.st_size > 0)
+    {
+        void* view = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(view != MAP_FAILED)
+        {
+            m_pData = reinterpret_cast<const uint8*>(view);
+            m_size = (uint64)status.st_size;
+        }
+    }
+
+    // The mapping keeps the file alive.
+    close(fd);
+#endif
+
+    if(!m_pData)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+    if(m_pData)
+        UnmapViewOfFile(m_pData);
+    if(m_mapping)
+        CloseHandle(m_mapping);
+    if(m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+
+    m_mapping = nullptr;
+    m_file = INVALID_HANDLE_VALUE;
+#else
+    if(m_pData)
+        munmap(const_cast<uint8*>(m_pData), (size_t)m_size);
+#endif
+
+    m_pData = nullptr;
+    m_size = 0;
+}
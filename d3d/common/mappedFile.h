@@ -0,0 +1,43 @@
+//---------------------------------------------------------------------------------------
+//
+// Read only file mapped in memory.
+//
+// CreateFileMapping/MapViewOfFile on Windows, mmap elsewhere. The data stays valid
+// until Close (or the destructor), the pages are read from the disk when touched.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_MAPPEDFILE_H
+#define _INCGUARD_MAPPEDFILE_H
+
+#include "types.h"
+
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // Returns false if the file can not be opened or mapped. Empty files can
+    // not be mapped either.
+    bool Open(const char* fileName);
+    void Close();
+    bool IsOpen() const { return m_pData != nullptr; }
+
+    const uint8* Data() const { return m_pData; }
+    uint64 Size() const { return m_size; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const uint8* m_pData;
+    uint64 m_size;
+
+#if defined(_WIN32)
+    void* m_file;               // HANDLE
+    void* m_mapping;
+#endif
+};
+
+#endif // _INCGUARD_MAPPEDFILE_H
@@ -37,6 +37,28 @@ float MathHelper::AngleFromXY(float x, float y)
 	return theta;
 }
 
+void MathHelper::ExtractFrustumPlanes(CXMMATRIX viewProj, XMFLOAT4 planes[6])
+{
+	// With row vectors clip = p*M, so each clip coordinate is the dot product
+	// of p with a column of M. A point is inside when -w <= x <= w,
+	// -w <= y <= w and 0 <= z <= w. The planes below are negated so the
+	// outside is the positive side.
+	XMMATRIX T = XMMatrixTranspose(viewProj);
+
+	XMVECTOR p[6];
+	p[0] = -(T.r[3] + T.r[0]); // Left
+	p[1] = T.r[0] - T.r[3];    // Right
+	p[2] = -(T.r[3] + T.r[1]); // Bottom
+	p[3] = T.r[1] - T.r[3];    // Top
+	p[4] = -T.r[2];            // Near
+	p[5] = T.r[2] - T.r[3];    // Far
+
+	for(int i = 0; i < 6; ++i)
+	{
+		XMStoreFloat4(&planes[i], XMPlaneNormalize(p[i]));
+	}
+}
+
 XMVECTOR MathHelper::RandUnitVec3()
 {
 	XMVECTOR One  = XMVectorSet(1.0f, 1.0f, 1.0f, 1.0f);
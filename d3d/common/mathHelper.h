@@ -66,6 +66,11 @@ public:
 		return XMMatrixTranspose(XMMatrixInverse(&det, A));
 	}
 
+	// World space frustum planes (left, right, bottom, top, near, far) of a
+	// view * projection matrix. The normals are unit length and point out of
+	// the frustum, as the planes of XNA::ComputePlanesFromFrustum.
+	static void ExtractFrustumPlanes(CXMMATRIX viewProj, XMFLOAT4 planes[6]);
+
 	static XMVECTOR RandUnitVec3();
 	static XMVECTOR RandHemisphereUnitVec3(XMVECTOR n);
 
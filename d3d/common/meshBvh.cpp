@@ -0,0 +1,244 @@
+#include "meshBvh.h"
+#include "config.h"
+#include <algorithm>
+#include <cfloat>
+#include <utility>
+
+MeshBvh::MeshBvh()
+{
+}
+
+void MeshBvh::Build(const XMFLOAT3* positions, uint32 stride, uint32 vertexCount,
+    const uint32* indices, uint32 triangleCount, uint32 maxLeafTriangles)
+{
+    m_nodes.clear();
+    m_vertices.clear();
+    m_triangleIds.clear();
+
+    if(triangleCount == 0)
+        return;
+
+    if(maxLeafTriangles == 0)
+        maxLeafTriangles = 1;
+
+    // Gather the triangle corners and centroids.
+    std::vector<XMFLOAT3> triangleVertices(triangleCount * 3);
+    std::vector<XMFLOAT3> centroids(triangleCount);
+    std::vector<uint32> order(triangleCount);
+
+    for(uint32 t = 0; t < triangleCount; ++t)
+    {
+        XMVECTOR sum = XMVectorZero();
+        for(uint32 k = 0; k < 3; ++k)
+        {
+            uint32 index = indices[t*3 + k];
+            OC_ASSERT(index < vertexCount);
+            (void)vertexCount;
+
+            const XMFLOAT3* p = reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const uint8*>(positions) + index * stride);
+            triangleVertices[t*3 + k] = *p;
+            sum += XMLoadFloat3(p);
+        }
+        XMStoreFloat3(&centroids[t], sum * (1.0f / 3.0f));
+        order[t] = t;
+    }
+
+    // A binary tree with leaves of at least one triangle has less than 2n nodes.
+    m_nodes.reserve(2 * triangleCount);
+    m_nodes.resize(1);
+    BuildNode(0, 0, triangleCount, maxLeafTriangles, triangleVertices, centroids, order);
+
+    // Store the triangles in leaf order so a leaf reads contiguous memory.
+    m_vertices.resize(triangleCount * 3);
+    for(uint32 i = 0; i < triangleCount; ++i)
+    {
+        m_vertices[i*3 + 0] = triangleVertices[order[i]*3 + 0];
+        m_vertices[i*3 + 1] = triangleVertices[order[i]*3 + 1];
+        m_vertices[i*3 + 2] = triangleVertices[order[i]*3 + 2];
+    }
+    m_triangleIds.swap(order);
+}
+
+void MeshBvh::BuildNode(uint32 nodeIndex, uint32 first, uint32 count, uint32 maxLeafTriangles,
+    const std::vector<XMFLOAT3>& triangleVertices, const std::vector<XMFLOAT3>& centroids,
+    std::vector<uint32>& order)
+{
+    // Bounds of the triangles and of their centroids.
+    XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+    XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+    XMVECTOR cMin = vMin;
+    XMVECTOR cMax = vMax;
+
+    for(uint32 i = first; i < first + count; ++i)
+    {
+        uint32 t = order[i];
+        for(uint32 k = 0; k < 3; ++k)
+        {
+            XMVECTOR p = XMLoadFloat3(&triangleVertices[t*3 + k]);
+            vMin = XMVectorMin(vMin, p);
+            vMax = XMVectorMax(vMax, p);
+        }
+
+        XMVECTOR c = XMLoadFloat3(&centroids[t]);
+        cMin = XMVectorMin(cMin, c);
+        cMax = XMVectorMax(cMax, c);
+    }
+
+    Node& node = m_nodes[nodeIndex];
+    XMStoreFloat3(&node.Center, 0.5f*(vMin + vMax));
+    XMStoreFloat3(&node.Extents, 0.5f*(vMax - vMin));
+
+    if(count <= maxLeafTriangles)
+    {
+        node.First = first;
+        node.Count = count;
+        return;
+    }
+
+    // Median split along the longest axis of the centroid bounds.
+    XMFLOAT3 spread;
+    XMStoreFloat3(&spread, cMax - cMin);
+
+    int axis = 0;
+    if(spread.y > spread.x) axis = 1;
+    if(spread.z > (axis == 0 ? spread.x : spread.y)) axis = 2;
+
+    uint32 half = count / 2;
+    std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+        [&centroids, axis](uint32 l, uint32 r)
+        {
+            const float* cl = &centroids[l].x;
+            const float* cr = &centroids[r].x;
+            return cl[axis] < cr[axis];
+        });
+
+    // Children are allocated together so the right child is always First + 1.
+    uint32 left = (uint32)m_nodes.size();
+    m_nodes[nodeIndex].First = left;
+    m_nodes[nodeIndex].Count = 0;
+    m_nodes.resize(m_nodes.size() + 2);
+
+    BuildNode(left, first, half, maxLeafTriangles, triangleVertices, centroids, order);
+    BuildNode(left + 1, first + half, count - half, maxLeafTriangles, triangleVertices, centroids, order);
+}
+
+MeshBvh::RelativeTransform MeshBvh::ComputeRelativeTransform(CXMMATRIX worldA, CXMMATRIX worldB)
+{
+    // B local -> world -> A local
+    XMVECTOR detA = XMMatrixDeterminant(worldA);
+    XMMATRIX toA = XMMatrixMultiply(worldB, XMMatrixInverse(&detA, worldA));
+
+    XMVECTOR scale;
+    XMVECTOR rotQuat;
+    XMVECTOR translation;
+    XMMatrixDecompose(&scale, &rotQuat, &translation, toA);
+
+    RelativeTransform result;
+    result.Scale = XMVectorGetX(scale);
+    XMStoreFloat4(&result.Rotation, rotQuat);
+    XMStoreFloat3(&result.Translation, translation);
+    return result;
+}
+
+bool MeshBvh::Overlaps(const MeshBvh& a, const MeshBvh& b, const RelativeTransform& bToA)
+{
+    return Traverse(a, b, bToA, nullptr);
+}
+
+uint32 MeshBvh::CollectContacts(const MeshBvh& a, const MeshBvh& b, const RelativeTransform& bToA,
+    std::vector<TrianglePair>& pairs)
+{
+    pairs.clear();
+    Traverse(a, b, bToA, &pairs);
+    return (uint32)pairs.size();
+}
+
+bool MeshBvh::Traverse(const MeshBvh& a, const MeshBvh& b, const RelativeTransform& bToA,
+    std::vector<TrianglePair>* pairs)
+{
+    if(a.m_nodes.empty() || b.m_nodes.empty())
+        return false;
+
+    XMVECTOR rotation = XMLoadFloat4(&bToA.Rotation);
+
+    // Scale, rotate then translate (row vector convention).
+    XMMATRIX toA = XMMatrixMultiply(XMMatrixScaling(bToA.Scale, bToA.Scale, bToA.Scale),
+        XMMatrixRotationQuaternion(rotation));
+    toA.r[3] = XMVectorSet(bToA.Translation.x, bToA.Translation.y, bToA.Translation.z, 1.0f);
+
+    bool found = false;
+
+    std::vector<std::pair<uint32, uint32>> stack;
+    stack.reserve(64);
+    stack.push_back(std::make_pair(0u, 0u));
+
+    while(!stack.empty())
+    {
+        const Node& nodeA = a.m_nodes[stack.back().first];
+        const Node& nodeB = b.m_nodes[stack.back().second];
+        stack.pop_back();
+
+        // Node B becomes an oriented box in the space of A.
+        XNA::AxisAlignedBox boxA;
+        boxA.Center = nodeA.Center;
+        boxA.Extents = nodeA.Extents;
+
+        XNA::OrientedBox boxB;
+        XMStoreFloat3(&boxB.Center, XMVector3TransformCoord(XMLoadFloat3(&nodeB.Center), toA));
+        boxB.Extents = XMFLOAT3(nodeB.Extents.x*bToA.Scale, nodeB.Extents.y*bToA.Scale, nodeB.Extents.z*bToA.Scale);
+        boxB.Orientation = bToA.Rotation;
+
+        if(!XNA::IntersectAxisAlignedBoxOrientedBox(&boxA, &boxB))
+            continue;
+
+        bool leafA = nodeA.Count > 0;
+        bool leafB = nodeB.Count > 0;
+
+        if(leafA && leafB)
+        {
+            for(uint32 j = nodeB.First; j < nodeB.First + nodeB.Count; ++j)
+            {
+                XMVECTOR b0 = XMVector3TransformCoord(XMLoadFloat3(&b.m_vertices[j*3 + 0]), toA);
+                XMVECTOR b1 = XMVector3TransformCoord(XMLoadFloat3(&b.m_vertices[j*3 + 1]), toA);
+                XMVECTOR b2 = XMVector3TransformCoord(XMLoadFloat3(&b.m_vertices[j*3 + 2]), toA);
+
+                for(uint32 i = nodeA.First; i < nodeA.First + nodeA.Count; ++i)
+                {
+                    XMVECTOR a0 = XMLoadFloat3(&a.m_vertices[i*3 + 0]);
+                    XMVECTOR a1 = XMLoadFloat3(&a.m_vertices[i*3 + 1]);
+                    XMVECTOR a2 = XMLoadFloat3(&a.m_vertices[i*3 + 2]);
+
+                    if(!XNA::IntersectTriangleTriangle(a0, a1, a2, b0, b1, b2))
+                        continue;
+
+                    if(!pairs)
+                        return true;
+
+                    TrianglePair pair = { a.m_triangleIds[i], b.m_triangleIds[j] };
+                    pairs->push_back(pair);
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // Descend into the larger node so both sides shrink at the same pace.
+        float sizeA = nodeA.Extents.x + nodeA.Extents.y + nodeA.Extents.z;
+        float sizeB = (nodeB.Extents.x + nodeB.Extents.y + nodeB.Extents.z) * bToA.Scale;
+
+        if(leafB || (!leafA && sizeA >= sizeB))
+        {
+            uint32 parentB = (uint32)(&nodeB - &b.m_nodes[0]);
+            stack.push_back(std::make_pair(nodeA.First + 1, parentB));
+            stack.push_back(std::make_pair(nodeA.First, parentB));
+        }
+        else
+        {
+            uint32 parentA = (uint32)(&nodeA - &a.m_nodes[0]);
+            stack.push_back(std::make_pair(parentA, nodeB.First + 1));
+            stack.push_back(std::make_pair(parentA, nodeB.First));
+        }
+    }
+
+    return found;
+}
@@ -0,0 +1,81 @@
+//---------------------------------------------------------------------------------------
+//
+// Bounding volume hierarchy over the triangles of a mesh.
+//
+// Used for mesh vs mesh overlap queries: both trees are traversed at the same
+// time, mesh B being placed in the local space of mesh A by a relative transform.
+// Node pairs are culled with box tests and XNA::IntersectTriangleTriangle is only
+// called on the triangles of overlapping leaves.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_MESHBVH_H
+#define _INCGUARD_MESHBVH_H
+
+#include "xnacollision.h"
+#include "types.h"
+#include <vector>
+
+class MeshBvh
+{
+public:
+    struct Node
+    {
+        XMFLOAT3 Center;
+        uint32 First;       // Leaf: first triangle in leaf order. Inner node: left child (right is First + 1).
+        XMFLOAT3 Extents;
+        uint32 Count;       // Triangles in the leaf, 0 for inner nodes.
+    };
+
+    // Contacting triangles, as indices in the triangle lists given to Build.
+    struct TrianglePair
+    {
+        uint32 TriangleA;
+        uint32 TriangleB;
+    };
+
+    // Rigid transform with uniform scale taking mesh B local space to mesh A local space.
+    struct RelativeTransform
+    {
+        float Scale;
+        XMFLOAT4 Rotation;      // Unit quaternion.
+        XMFLOAT3 Translation;
+    };
+
+    MeshBvh();
+
+    // Positions are read with the given stride (e.g. sizeof(Vertex::Basic32)).
+    void Build(const XMFLOAT3* positions, uint32 stride, uint32 vertexCount,
+        const uint32* indices, uint32 triangleCount, uint32 maxLeafTriangles = 4);
+
+    uint32 NodeCount() const { return (uint32)m_nodes.size(); }
+    uint32 TriangleCount() const { return (uint32)m_triangleIds.size(); }
+
+    // Relative transform between two placed meshes. The world matrices may only
+    // contain uniform scale, rotation and translation.
+    static RelativeTransform ComputeRelativeTransform(CXMMATRIX worldA, CXMMATRIX worldB);
+
+    // True as soon as one triangle of B touches a triangle of A.
+    static bool Overlaps(const MeshBvh& a, const MeshBvh& b, const RelativeTransform& bToA);
+
+    // All the contacting triangle pairs. Returns the number of pairs found.
+    static uint32 CollectContacts(const MeshBvh& a, const MeshBvh& b, const RelativeTransform& bToA,
+        std::vector<TrianglePair>& pairs);
+
+private:
+    void BuildNode(uint32 nodeIndex, uint32 first, uint32 count, uint32 maxLeafTriangles,
+        const std::vector<XMFLOAT3>& triangleVertices, const std::vector<XMFLOAT3>& centroids,
+        std::vector<uint32>& order);
+
+    static bool Traverse(const MeshBvh& a, const MeshBvh& b, const RelativeTransform& bToA,
+        std::vector<TrianglePair>* pairs);
+
+    std::vector<Node> m_nodes;
+
+    // Triangle vertices stored in leaf order (3 per triangle) and the index of
+    // each triangle in the source index list.
+    std::vector<XMFLOAT3> m_vertices;
+    std::vector<uint32> m_triangleIds;
+};
+
+#endif // _INCGUARD_MESHBVH_H
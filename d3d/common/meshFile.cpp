@@ -0,0 +1,140 @@
+#include "meshFile.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    uint32 AlignUp(uint32 offset)
+    {
+        return (offset + MeshFileAlignment - 1) & ~(MeshFileAlignment - 1);
+    }
+}
+
+uint32 MeshVertexStride(uint32 vertexFormat)
+{
+    uint32 stride = 0;
+    if(vertexFormat & MESH_VERTEX_POSITION)
+        stride += sizeof(XMFLOAT3);
+    if(vertexFormat & MESH_VERTEX_NORMAL)
+        stride += sizeof(XMFLOAT3);
+    if(vertexFormat & MESH_VERTEX_TEXCOORD)
+        stride += sizeof(XMFLOAT2);
+    return stride;
+}
+
+bool WriteMeshFile(const char* fileName, uint32 vertexFormat, const void* vertices, uint32 vertexCount,
+    const uint32* indices, uint32 indexCount, bool force32BitIndices)
+{
+    MeshFileHeader header;
+    memset(&header, 0, sizeof(header));
+
+    header.Magic = MeshFileMagic;
+    header.Version = MeshFileVersion;
+    header.VertexFormat = vertexFormat;
+    header.VertexStride = MeshVertexStride(vertexFormat);
+    header.VertexCount = vertexCount;
+    header.IndexCount = indexCount;
+
+    uint32 maxIndex = 0;
+    for(uint32 i = 0; i < indexCount; ++i)
+        maxIndex = indices[i] > maxIndex ? indices[i] : maxIndex;
+    header.IndexSize = (force32BitIndices || maxIndex > 0xffff) ? 4 : 2;
+
+    header.VertexOffset = AlignUp(sizeof(MeshFileHeader));
+    header.IndexOffset = AlignUp(header.VertexOffset + vertexCount * header.VertexStride);
+
+    // Bounds of the positions, the first component of the vertices.
+    if((vertexFormat & MESH_VERTEX_POSITION) && vertexCount > 0)
+    {
+        const uint8* vertex = reinterpret_cast<const uint8*>(vertices);
+        XMVECTOR vMin = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(vertex));
+        XMVECTOR vMax = vMin;
+        for(uint32 i = 1; i < vertexCount; ++i)
+        {
+            XMVECTOR P = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(vertex + i * header.VertexStride));
+            vMin = XMVectorMin(vMin, P);
+            vMax = XMVectorMax(vMax, P);
+        }
+
+        XMStoreFloat3(&header.BoundsCenter, 0.5f*(vMin + vMax));
+        XMStoreFloat3(&header.BoundsExtents, 0.5f*(vMax - vMin));
+    }
+
+    // Laid out in memory first, so the file is written at once.
+    std::vector<uint8> data(header.IndexOffset + indexCount * header.IndexSize, 0);
+    memcpy(&data[0], &header, sizeof(header));
+    if(vertexCount > 0)
+        memcpy(&data[header.VertexOffset], vertices, vertexCount * header.VertexStride);
+
+    for(uint32 i = 0; i < indexCount; ++i)
+    {
+        if(header.IndexSize == 2)
+        {
+            uint16 index = (uint16)indices[i];
+            memcpy(&data[header.IndexOffset + i * 2], &index, 2);
+        }
+        else
+            memcpy(&data[header.IndexOffset + i * 4], &indices[i], 4);
+    }
+
+    FILE* file = fopen(fileName, "wb");
+    if(!file)
+        return false;
+
+    bool written = fwrite(&data[0], 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && written;
+}
+
+bool MeshFile::Open(const char* fileName)
+{
+    if(!m_file.Open(fileName))
+        return false;
+
+    if(m_file.Size() < sizeof(MeshFileHeader) || !Validate())
+    {
+        m_file.Close();
+        return false;
+    }
+
+    return true;
+}
+
+XNA::AxisAlignedBox MeshFile::Bounds() const
+{
+    XNA::AxisAlignedBox box;
+    box.Center = Header().BoundsCenter;
+    box.Extents = Header().BoundsExtents;
+    return box;
+}
+
+uint32 MeshFile::Index(uint32 i) const
+{
+    if(Header().IndexSize == 2)
+        return reinterpret_cast<const uint16*>(Indices())[i];
+
+    return reinterpret_cast<const uint32*>(Indices())[i];
+}
+
+bool MeshFile::Validate() const
+{
+    const MeshFileHeader& header = Header();
+
+    if(header.Magic != MeshFileMagic || header.Version != MeshFileVersion)
+        return false;
+
+    if(header.VertexStride != MeshVertexStride(header.VertexFormat))
+        return false;
+
+    if(header.IndexSize != 2 && header.IndexSize != 4)
+        return false;
+
+    if(header.VertexOffset % MeshFileAlignment != 0 || header.IndexOffset % MeshFileAlignment != 0)
+        return false;
+
+    // The blobs must be inside the file (64 bits, the counts come from the file).
+    uint64 vertexEnd = header.VertexOffset + (uint64)header.VertexCount * header.VertexStride;
+    uint64 indexEnd = header.IndexOffset + (uint64)header.IndexCount * header.IndexSize;
+    return header.VertexOffset >= sizeof(MeshFileHeader) && vertexEnd <= m_file.Size() &&
+        header.IndexOffset >= vertexEnd && indexEnd <= m_file.Size();
+}
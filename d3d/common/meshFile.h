@@ -0,0 +1,87 @@
+//---------------------------------------------------------------------------------------
+//
+// Binary mesh files.
+//
+// A 64 bytes header (counts, bounds, vertex format, index size) followed by the
+// vertex and index blobs, each 16 bytes aligned in the file. MeshFile maps the file
+// in memory: Vertices() and Indices() point in the mapping and can be given as is
+// to CreateBuffer as D3D11_SUBRESOURCE_DATA::pSysMem, nothing is parsed or copied.
+// The files are written by tools/MeshConverter from the text models.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_MESHFILE_H
+#define _INCGUARD_MESHFILE_H
+
+#include "xnacollision.h"
+#include "mappedFile.h"
+#include "types.h"
+
+// Vertex components, stored in this order. Position + Normal matches
+// Vertex::PosNormal, the three of them Vertex::Basic32.
+enum MeshVertexFormat
+{
+    MESH_VERTEX_POSITION = 1,   // XMFLOAT3
+    MESH_VERTEX_NORMAL   = 2,   // XMFLOAT3
+    MESH_VERTEX_TEXCOORD = 4    // XMFLOAT2
+};
+
+const uint32 MeshFileMagic = 0x3148534d;    // "MSH1"
+const uint32 MeshFileVersion = 1;
+const uint32 MeshFileAlignment = 16;
+
+struct MeshFileHeader
+{
+    uint32 Magic;
+    uint32 Version;
+    uint32 VertexFormat;        // MESH_VERTEX_* flags.
+    uint32 VertexStride;        // Bytes.
+    uint32 VertexCount;
+    uint32 IndexSize;           // 2 or 4 bytes.
+    uint32 IndexCount;
+    uint32 VertexOffset;        // From the start of the file.
+    uint32 IndexOffset;
+    XMFLOAT3 BoundsCenter;      // Box of the positions.
+    XMFLOAT3 BoundsExtents;
+    uint32 Reserved;
+};
+
+uint32 MeshVertexStride(uint32 vertexFormat);
+
+// Write a mesh file. The vertices are given in the layout of vertexFormat, the
+// indices are stored on 16 bits when possible (all of them below 65536) unless
+// force32BitIndices is set. Returns false if the file can not be written.
+bool WriteMeshFile(const char* fileName, uint32 vertexFormat, const void* vertices, uint32 vertexCount,
+    const uint32* indices, uint32 indexCount, bool force32BitIndices = false);
+
+class MeshFile
+{
+public:
+    // Map the file. Returns false if it can not be opened or is not a valid
+    // mesh file.
+    bool Open(const char* fileName);
+    void Close() { m_file.Close(); }
+    bool IsOpen() const { return m_file.IsOpen(); }
+
+    const MeshFileHeader& Header() const { return *reinterpret_cast<const MeshFileHeader*>(m_file.Data()); }
+    XNA::AxisAlignedBox Bounds() const;
+
+    uint32 VertexCount() const { return Header().VertexCount; }
+    uint32 VertexStride() const { return Header().VertexStride; }
+    uint32 IndexCount() const { return Header().IndexCount; }
+    uint32 IndexSize() const { return Header().IndexSize; }
+
+    // Valid while the file is open.
+    const void* Vertices() const { return m_file.Data() + Header().VertexOffset; }
+    const void* Indices() const { return m_file.Data() + Header().IndexOffset; }
+
+    // Index i, whatever the index size.
+    uint32 Index(uint32 i) const;
+
+private:
+    bool Validate() const;
+
+    MappedFile m_file;
+};
+
+#endif // _INCGUARD_MESHFILE_H
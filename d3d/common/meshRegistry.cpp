@@ -0,0 +1,164 @@
+#include "meshRegistry.h"
+#include "contentHash.h"
+#include "mappedFile.h"
+#include "textMeshReader.h"
+#include "timer.h"
+
+uint64 MeshAsset::ByteSize() const
+{
+    return Positions.size() * sizeof(XMFLOAT3) + Normals.size() * sizeof(XMFLOAT3) +
+        Indices.size() * sizeof(uint32);
+}
+
+MeshRegistry::MeshRegistry()
+: m_loads(0)
+, m_hits(0)
+, m_bytesSaved(0)
+, m_loadTime(0.0)
+, m_loadTimeSaved(0.0)
+{
+}
+
+MeshRegistry& MeshRegistry::Shared()
+{
+    static MeshRegistry registry;
+    return registry;
+}
+
+MeshAssetPtr MeshRegistry::Acquire(const char* fileName, ThreadPool* pPool, const WeldTolerance* pWeld)
+{
+    uint64 hash;
+    uint64 fileSize;
+    {
+        MappedFile file;
+        if(!file.Open(fileName))
+            return nullptr;
+
+        hash = HashBytes(file.Data(), file.Size());
+        fileSize = file.Size();
+    }
+
+    // The welded versions are other entries.
+    if(pWeld)
+        hash = MixHash(hash ^ HashBytes(pWeld, sizeof(WeldTolerance)));
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_meshes.find(hash);
+        if(it != m_meshes.end())
+        {
+            MeshAssetPtr mesh = it->second.lock();
+            if(mesh && mesh->FileSize == fileSize)
+            {
+                ++m_hits;
+                m_bytesSaved += mesh->ByteSize();
+                m_loadTimeSaved += mesh->LoadTime;
+                return mesh;
+            }
+        }
+    }
+
+    // Parse outside the lock, other meshes can be acquired meanwhile.
+    Timer timer;
+    timer.Reset();
+    timer.Tick();
+
+    TextMeshReader reader;
+    if(!reader.Open(fileName))
+        return nullptr;
+
+    std::shared_ptr<MeshAsset> mesh = std::make_shared<MeshAsset>();
+    mesh->Positions.resize(reader.VertexCount());
+    mesh->Normals.resize(reader.VertexCount());
+    mesh->Indices.resize(3 * reader.TriangleCount());
+    if(mesh->Positions.empty() || mesh->Indices.empty() ||
+       !reader.Read(&mesh->Positions[0], &mesh->Normals[0], sizeof(XMFLOAT3), &mesh->Indices[0], &mesh->Bounds, pPool))
+        return nullptr;
+
+    mesh->SourceVertexCount = mesh->VertexCount();
+    mesh->SourceTriangleCount = mesh->IndexCount() / 3;
+    mesh->WeldTime = 0.0f;
+
+    if(pWeld)
+    {
+        Timer weldTimer;
+        weldTimer.Reset();
+        weldTimer.Tick();
+
+        WeldedMesh welded;
+        WeldVertices(&mesh->Positions[0], &mesh->Normals[0], sizeof(XMFLOAT3), mesh->VertexCount(),
+            &mesh->Indices[0], mesh->IndexCount() / 3, *pWeld, &welded);
+
+        std::vector<XMFLOAT3> positions(welded.Source.size());
+        std::vector<XMFLOAT3> normals(welded.Source.size());
+        for(size_t i = 0; i < welded.Source.size(); ++i)
+        {
+            positions[i] = mesh->Positions[welded.Source[i]];
+            normals[i] = mesh->Normals[welded.Source[i]];
+        }
+
+        mesh->Positions.swap(positions);
+        mesh->Normals.swap(normals);
+        mesh->Indices.swap(welded.Indices);
+        if(mesh->Indices.empty())
+            return nullptr;
+
+        weldTimer.Tick();
+        mesh->WeldTime = weldTimer.DeltaTime();
+    }
+
+    timer.Tick();
+
+    mesh->FileName = fileName;
+    mesh->ContentHash = hash;
+    mesh->FileSize = fileSize;
+    mesh->LoadTime = timer.DeltaTime();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Another thread may have loaded the same content in the meantime, keep
+    // a single copy.
+    std::weak_ptr<const MeshAsset>& entry = m_meshes[hash];
+    MeshAssetPtr loaded = entry.lock();
+    if(loaded && loaded->FileSize == fileSize)
+    {
+        ++m_hits;
+        m_bytesSaved += loaded->ByteSize();
+        m_loadTimeSaved += loaded->LoadTime;
+        return loaded;
+    }
+
+    ++m_loads;
+    m_loadTime += mesh->LoadTime;
+
+    // On a (very unlikely) hash collision the first mesh stays registered.
+    if(!loaded)
+        entry = mesh;
+    return mesh;
+}
+
+MeshRegistry::Stats MeshRegistry::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Stats stats;
+    stats.Loads = m_loads;
+    stats.Hits = m_hits;
+    stats.LiveMeshes = 0;
+    stats.LiveBytes = 0;
+    stats.BytesSaved = m_bytesSaved;
+    stats.LoadTime = (float)m_loadTime;
+    stats.LoadTimeSaved = (float)m_loadTimeSaved;
+
+    for(auto it = m_meshes.begin(); it != m_meshes.end(); ++it)
+    {
+        MeshAssetPtr mesh = it->second.lock();
+        if(mesh)
+        {
+            ++stats.LiveMeshes;
+            stats.LiveBytes += mesh->ByteSize();
+        }
+    }
+
+    return stats;
+}
@@ -0,0 +1,117 @@
+//---------------------------------------------------------------------------------------
+//
+// Process wide registry of the text models.
+//
+// Several demos (and several scenes of a same process) load the same models, the
+// skull is copied in five Models directories. The registry keys the meshes by a hash
+// of the file content, so every copy is parsed once: Acquire returns the mesh already
+// loaded when there is one, otherwise it parses the file with TextMeshReader. The
+// meshes are immutable and reference counted, a mesh is freed when its last user
+// releases it and parsed again if it is needed later.
+//
+// The meshes can be welded on load (see meshWelder.h), the welded and the raw
+// versions of a file are different entries.
+//
+// The statistics tell how many loads were avoided, with the memory and the parsing
+// time they would have cost.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_MESHREGISTRY_H
+#define _INCGUARD_MESHREGISTRY_H
+
+#include "meshWelder.h"
+#include "xnacollision.h"
+#include "types.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+// Parsed model, shared by all the users of the registry.
+struct MeshAsset
+{
+    std::vector<XMFLOAT3> Positions;
+    std::vector<XMFLOAT3> Normals;
+    std::vector<uint32> Indices;
+    XNA::AxisAlignedBox Bounds;
+
+    std::string FileName;       // First file this content was loaded from.
+    uint64 ContentHash;
+    uint64 FileSize;
+    float LoadTime;             // Seconds spent parsing (and welding).
+
+    // Counts in the file, before welding.
+    uint32 SourceVertexCount;
+    uint32 SourceTriangleCount;
+    float WeldTime;             // Seconds, 0 when not welded.
+
+    uint32 VertexCount() const { return (uint32)Positions.size(); }
+    uint32 IndexCount() const { return (uint32)Indices.size(); }
+
+    // CPU memory held by the arrays.
+    uint64 ByteSize() const;
+};
+
+typedef std::shared_ptr<const MeshAsset> MeshAssetPtr;
+
+// Interleave the positions and normals in any vertex type having Pos and Normal
+// members (Vertex::PosNormal, Vertex::Basic32...). The other members are left
+// as they are.
+template<typename V>
+void CopyMeshVertices(const MeshAsset& mesh, std::vector<V>* pVertices)
+{
+    pVertices->resize(mesh.VertexCount());
+    for(uint32 i = 0; i < mesh.VertexCount(); ++i)
+    {
+        (*pVertices)[i].Pos = mesh.Positions[i];
+        (*pVertices)[i].Normal = mesh.Normals[i];
+    }
+}
+
+class MeshRegistry
+{
+public:
+    struct Stats
+    {
+        uint32 Loads;           // Files parsed.
+        uint32 Hits;            // Acquire calls served by a loaded mesh.
+        uint32 LiveMeshes;      // Meshes currently in use.
+        uint64 LiveBytes;       // Their CPU memory.
+        uint64 BytesSaved;      // Memory the hits would have allocated.
+        float LoadTime;         // Seconds spent parsing.
+        float LoadTimeSaved;    // Parsing time the hits avoided.
+    };
+
+    MeshRegistry();
+
+    // Mesh of the given text model, loaded if no user holds a mesh with the same
+    // content. Returns null if the file can not be read or parsed. pPool is used
+    // for the parse, the shared pool when null. The mesh is welded with the
+    // given tolerance when pWeld is not null.
+    MeshAssetPtr Acquire(const char* fileName, ThreadPool* pPool = nullptr, const WeldTolerance* pWeld = nullptr);
+
+    Stats GetStats() const;
+
+    // Process wide registry.
+    static MeshRegistry& Shared();
+
+private:
+    MeshRegistry(const MeshRegistry&);
+    MeshRegistry& operator=(const MeshRegistry&);
+
+    // Users hold the meshes, the registry only watches them.
+    std::unordered_map<uint64, std::weak_ptr<const MeshAsset>> m_meshes;
+    mutable std::mutex m_mutex;
+
+    uint32 m_loads;
+    uint32 m_hits;
+    uint64 m_bytesSaved;
+    double m_loadTime;
+    double m_loadTimeSaved;
+};
+
+#endif // _INCGUARD_MESHREGISTRY_H
@@ -0,0 +1,121 @@
+#include "meshSimplifier.h"
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+    const XMFLOAT3& PositionAt(const XMFLOAT3* positions, uint32 stride, uint32 i)
+    {
+        return *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const uint8*>(positions) + i * stride);
+    }
+}
+
+void ClusterVertices(const XMFLOAT3* positions, uint32 stride, uint32 vertexCount,
+    const uint32* indices, uint32 triangleCount, float cellSize, ClusteredMesh* pOut)
+{
+    OC_ASSERT(cellSize > 0.0f);
+
+    pOut->Positions.clear();
+    pOut->ClusterOf.resize(vertexCount);
+    pOut->Indices.clear();
+    pOut->MaxError = 0.0f;
+
+    if(vertexCount == 0)
+        return;
+
+    XMFLOAT3 vMin = PositionAt(positions, stride, 0);
+    for(uint32 i = 1; i < vertexCount; ++i)
+    {
+        const XMFLOAT3& p = PositionAt(positions, stride, i);
+        vMin.x = std::min(vMin.x, p.x);
+        vMin.y = std::min(vMin.y, p.y);
+        vMin.z = std::min(vMin.z, p.z);
+    }
+
+    // Cell of each vertex, 21 bits per axis in the key (the cell size is far
+    // larger than a 2 millionth of the mesh).
+    float invCellSize = 1.0f / cellSize;
+    std::unordered_map<uint64, uint32> clusterOfCell;
+    std::vector<uint32> clusterSize;
+
+    for(uint32 i = 0; i < vertexCount; ++i)
+    {
+        const XMFLOAT3& p = PositionAt(positions, stride, i);
+        uint64 cx = (uint64)((p.x - vMin.x) * invCellSize) & 0x1fffff;
+        uint64 cy = (uint64)((p.y - vMin.y) * invCellSize) & 0x1fffff;
+        uint64 cz = (uint64)((p.z - vMin.z) * invCellSize) & 0x1fffff;
+        uint64 key = cx | (cy << 21) | (cz << 42);
+
+        std::unordered_map<uint64, uint32>::iterator it = clusterOfCell.find(key);
+        uint32 cluster;
+        if(it == clusterOfCell.end())
+        {
+            cluster = (uint32)pOut->Positions.size();
+            clusterOfCell[key] = cluster;
+            pOut->Positions.push_back(XMFLOAT3(0.0f, 0.0f, 0.0f));
+            clusterSize.push_back(0);
+        }
+        else
+            cluster = it->second;
+
+        pOut->ClusterOf[i] = cluster;
+        pOut->Positions[cluster].x += p.x;
+        pOut->Positions[cluster].y += p.y;
+        pOut->Positions[cluster].z += p.z;
+        ++clusterSize[cluster];
+    }
+
+    for(size_t c = 0; c < pOut->Positions.size(); ++c)
+    {
+        float invSize = 1.0f / clusterSize[c];
+        pOut->Positions[c].x *= invSize;
+        pOut->Positions[c].y *= invSize;
+        pOut->Positions[c].z *= invSize;
+    }
+
+    for(uint32 i = 0; i < vertexCount; ++i)
+    {
+        const XMFLOAT3& p = PositionAt(positions, stride, i);
+        const XMFLOAT3& q = pOut->Positions[pOut->ClusterOf[i]];
+        float dx = p.x - q.x;
+        float dy = p.y - q.y;
+        float dz = p.z - q.z;
+        pOut->MaxError = std::max(pOut->MaxError, sqrtf(dx*dx + dy*dy + dz*dz));
+    }
+
+    // Keep the triangles with 3 distinct clusters, once. A triangle is keyed
+    // by its corners rotated so the smallest comes first, which keeps its
+    // winding: the two sides of a thin part both survive.
+    OC_ASSERT(pOut->Positions.size() <= 0x200000);
+
+    std::unordered_set<uint64> kept;
+    for(uint32 t = 0; t < triangleCount; ++t)
+    {
+        uint32 a = pOut->ClusterOf[indices[3*t + 0]];
+        uint32 b = pOut->ClusterOf[indices[3*t + 1]];
+        uint32 c = pOut->ClusterOf[indices[3*t + 2]];
+        if(a == b || b == c || c == a)
+            continue;
+
+        uint32 first = a, second = b, third = c;
+        if(b < first && b < c)
+        {
+            first = b; second = c; third = a;
+        }
+        else if(c < first && c < b)
+        {
+            first = c; second = a; third = b;
+        }
+
+        uint64 key = (uint64)first | ((uint64)second << 21) | ((uint64)third << 42);
+        if(!kept.insert(key).second)
+            continue;
+
+        pOut->Indices.push_back(a);
+        pOut->Indices.push_back(b);
+        pOut->Indices.push_back(c);
+    }
+}
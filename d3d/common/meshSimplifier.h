@@ -0,0 +1,33 @@
+//---------------------------------------------------------------------------------------
+//
+// Mesh simplification by vertex clustering.
+//
+// The vertices falling in the same cell of a regular grid are merged into one
+// vertex placed at their mean position. Triangles whose corners end up in the
+// same cluster collapse and are dropped, so the cell size sets both the triangle
+// count and the error of the result. Used to build the levels of detail of a mesh.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_MESHSIMPLIFIER_H
+#define _INCGUARD_MESHSIMPLIFIER_H
+
+#include "xnacollision.h"
+#include "types.h"
+#include <vector>
+
+struct ClusteredMesh
+{
+    std::vector<XMFLOAT3> Positions;    // Mean position of each cluster.
+    std::vector<uint32> ClusterOf;      // Cluster of each input vertex.
+    std::vector<uint32> Indices;        // Remaining triangles, indexing the clusters.
+    float MaxError;                     // Largest distance from an input vertex to its cluster.
+};
+
+// Positions are read with the given stride (e.g. sizeof(Vertex::Basic32)). The
+// other vertex attributes are left to the caller, who can average them over
+// ClusterOf.
+void ClusterVertices(const XMFLOAT3* positions, uint32 stride, uint32 vertexCount,
+    const uint32* indices, uint32 triangleCount, float cellSize, ClusteredMesh* pOut);
+
+#endif // _INCGUARD_MESHSIMPLIFIER_H
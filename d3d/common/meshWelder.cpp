@@ -0,0 +1,196 @@
+#include "meshWelder.h"
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const uint32 NoVertex = 0xffffffff;
+
+    const XMFLOAT3& AttributeAt(const XMFLOAT3* attributes, uint32 stride, uint32 i)
+    {
+        return *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const uint8*>(attributes) + i * stride);
+    }
+
+    bool Close(const XMFLOAT3& a, const XMFLOAT3& b, float tolerance)
+    {
+        return fabsf(a.x - b.x) <= tolerance && fabsf(a.y - b.y) <= tolerance && fabsf(a.z - b.z) <= tolerance;
+    }
+
+    // 21 bits per axis. Far away cells may share a key, the candidates are
+    // compared anyway.
+    uint64 CellKey(int64 cx, int64 cy, int64 cz)
+    {
+        return ((uint64)cx & 0x1fffff) | (((uint64)cy & 0x1fffff) << 21) | (((uint64)cz & 0x1fffff) << 42);
+    }
+
+    // First welded vertex of each cell. Open addressing in a power of two
+    // table at most half full, std::unordered_map spent more time allocating
+    // its nodes than the whole weld takes.
+    class CellTable
+    {
+    public:
+        explicit CellTable(uint32 cellCount)
+        {
+            uint32 size = 16;
+            while(size < 2 * cellCount)
+                size *= 2;
+
+            m_mask = size - 1;
+            m_keys.resize(size);
+            m_first.resize(size, NoVertex);
+        }
+
+        // Slot of the key, empty (NoVertex) if the cell has no vertex yet.
+        uint32& operator[](uint64 key)
+        {
+            uint32 slot = (uint32)((key * 0x9e3779b97f4a7c15ull) >> 32) & m_mask;
+            while(m_first[slot] != NoVertex && m_keys[slot] != key)
+                slot = (slot + 1) & m_mask;
+
+            m_keys[slot] = key;
+            return m_first[slot];
+        }
+
+    private:
+        std::vector<uint64> m_keys;
+        std::vector<uint32> m_first;
+        uint32 m_mask;
+    };
+
+    // Without tolerance the key is made of the bits of the position.
+    uint64 ExactKey(const XMFLOAT3& p)
+    {
+        uint32 bits[3];
+        memcpy(bits, &p, sizeof(bits));
+
+        uint64 key = bits[0] | ((uint64)bits[1] << 32);
+        key ^= key >> 29;
+        key *= 0xbf58476d1ce4e5b9ull;
+        return key ^ bits[2] ^ ((uint64)bits[2] << 41);
+    }
+}
+
+void WeldVertices(const XMFLOAT3* positions, const XMFLOAT3* normals, uint32 stride, uint32 vertexCount,
+    const uint32* indices, uint32 triangleCount, const WeldTolerance& tolerance, WeldedMesh* pOut)
+{
+    pOut->Source.clear();
+    pOut->Indices.clear();
+    pOut->DegenerateTriangles = 0;
+
+    if(vertexCount == 0)
+        return;
+
+    XMFLOAT3 vMin = AttributeAt(positions, stride, 0);
+    for(uint32 i = 1; i < vertexCount; ++i)
+    {
+        const XMFLOAT3& p = AttributeAt(positions, stride, i);
+        vMin.x = p.x < vMin.x ? p.x : vMin.x;
+        vMin.y = p.y < vMin.y ? p.y : vMin.y;
+        vMin.z = p.z < vMin.z ? p.z : vMin.z;
+    }
+
+    // Cells twice the tolerance: a vertex can only match in its cell and, on
+    // each axis, the neighbor on the side of the nearest face, so 8 cells are
+    // searched instead of 27.
+    bool exact = tolerance.Position <= 0.0f;
+    float invCellSize = exact ? 0.0f : 0.5f / tolerance.Position;
+    float normalTolerance = tolerance.Normal > 0.0f ? tolerance.Normal : 0.0f;
+
+    // Welded vertex of each input vertex. The welded vertices of a cell are
+    // chained from firstInCell through nextInCell.
+    std::vector<uint32> weldedOf(vertexCount);
+    std::vector<uint32> representative;
+    std::vector<uint32> nextInCell;
+    CellTable firstInCell(vertexCount);
+
+    for(uint32 i = 0; i < vertexCount; ++i)
+    {
+        const XMFLOAT3& p = AttributeAt(positions, stride, i);
+
+        uint64 keys[8];
+        uint32 keyCount = 0;
+        uint64 ownKey;
+        if(exact)
+        {
+            ownKey = ExactKey(p);
+            keys[keyCount++] = ownKey;
+        }
+        else
+        {
+            float fx = (p.x - vMin.x) * invCellSize;
+            float fy = (p.y - vMin.y) * invCellSize;
+            float fz = (p.z - vMin.z) * invCellSize;
+            int64 cx = (int64)floorf(fx);
+            int64 cy = (int64)floorf(fy);
+            int64 cz = (int64)floorf(fz);
+            int64 nx = fx - cx < 0.5f ? cx - 1 : cx + 1;
+            int64 ny = fy - cy < 0.5f ? cy - 1 : cy + 1;
+            int64 nz = fz - cz < 0.5f ? cz - 1 : cz + 1;
+
+            ownKey = CellKey(cx, cy, cz);
+            for(uint32 k = 0; k < 8; ++k)
+                keys[keyCount++] = CellKey(k & 1 ? nx : cx, k & 2 ? ny : cy, k & 4 ? nz : cz);
+        }
+
+        uint32 welded = NoVertex;
+        for(uint32 k = 0; k < keyCount && welded == NoVertex; ++k)
+        {
+            for(uint32 w = firstInCell[keys[k]]; w != NoVertex; w = nextInCell[w])
+            {
+                uint32 r = representative[w];
+                if(Close(AttributeAt(positions, stride, r), p, tolerance.Position) &&
+                   (!normals || Close(AttributeAt(normals, stride, r), AttributeAt(normals, stride, i), normalTolerance)))
+                {
+                    welded = w;
+                    break;
+                }
+            }
+        }
+
+        if(welded == NoVertex)
+        {
+            welded = (uint32)representative.size();
+            representative.push_back(i);
+
+            uint32& first = firstInCell[ownKey];
+            nextInCell.push_back(first);
+            first = welded;
+        }
+
+        weldedOf[i] = welded;
+    }
+
+    // Remap the triangles, the welded vertices are numbered by first use.
+    std::vector<uint32> newIndex(representative.size(), NoVertex);
+    pOut->Indices.reserve(3 * triangleCount);
+
+    for(uint32 t = 0; t < triangleCount; ++t)
+    {
+        uint32 corners[3] = { weldedOf[indices[3*t]], weldedOf[indices[3*t+1]], weldedOf[indices[3*t+2]] };
+        if(corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2])
+        {
+            ++pOut->DegenerateTriangles;
+            continue;
+        }
+
+        XMVECTOR p0 = XMLoadFloat3(&AttributeAt(positions, stride, representative[corners[0]]));
+        XMVECTOR p1 = XMLoadFloat3(&AttributeAt(positions, stride, representative[corners[1]]));
+        XMVECTOR p2 = XMLoadFloat3(&AttributeAt(positions, stride, representative[corners[2]]));
+        if(XMVector3Equal(XMVector3Cross(p1 - p0, p2 - p0), XMVectorZero()))
+        {
+            ++pOut->DegenerateTriangles;
+            continue;
+        }
+
+        for(uint32 c = 0; c < 3; ++c)
+        {
+            uint32& index = newIndex[corners[c]];
+            if(index == NoVertex)
+            {
+                index = (uint32)pOut->Source.size();
+                pOut->Source.push_back(representative[corners[c]]);
+            }
+            pOut->Indices.push_back(index);
+        }
+    }
+}
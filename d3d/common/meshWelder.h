@@ -0,0 +1,41 @@
+//---------------------------------------------------------------------------------------
+//
+// Vertex welding.
+//
+// The text models give every vertex its own position and normal, some of them are
+// repeated (the car has a copy of a vertex per face sharing it). Welding merges the
+// vertices whose position and normal are equal, or closer than a tolerance, and
+// remaps the indices. The vertices are found with a spatial hash on a grid of the
+// position tolerance, so only the neighbor cells are searched. Triangles left with
+// two identical corners or no area are dropped, and the kept vertices are ordered by
+// first use in the triangles, which keeps the vertex fetches local.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_MESHWELDER_H
+#define _INCGUARD_MESHWELDER_H
+
+#include "xnacollision.h"
+#include "types.h"
+#include <vector>
+
+struct WeldTolerance
+{
+    float Position;     // Largest difference per axis, in model units. 0 welds equal positions only.
+    float Normal;       // Largest difference per component.
+};
+
+struct WeldedMesh
+{
+    std::vector<uint32> Source;         // Input vertex of each welded vertex.
+    std::vector<uint32> Indices;        // Kept triangles, indexing the welded vertices.
+    uint32 DegenerateTriangles;         // Dropped ones.
+};
+
+// Positions and normals are read with the given stride (e.g. sizeof(Vertex::Basic32)),
+// normals may be null to weld on the positions only. A welded vertex takes the
+// attributes of its Source vertex.
+void WeldVertices(const XMFLOAT3* positions, const XMFLOAT3* normals, uint32 stride, uint32 vertexCount,
+    const uint32* indices, uint32 triangleCount, const WeldTolerance& tolerance, WeldedMesh* pOut);
+
+#endif // _INCGUARD_MESHWELDER_H
@@ -0,0 +1,403 @@
+#include "occlusionBuffer.h"
+#include "threadPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+
+// SSE2 is part of x64 and of the default Win32 target, 4 pixels are then
+// processed at once. Other targets use the scalar loops.
+#if defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 ) || defined(__SSE2__)
+#define OC_OCCLUSION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Depth of the pixels no occluder covers.
+    const float FarDepth = FLT_MAX;
+}
+
+OcclusionBuffer::OcclusionBuffer(uint32 width, uint32 height)
+: m_width(width)
+, m_height(height)
+, m_pitch((width + TileSize - 1) / TileSize * TileSize)
+, m_tilesX((width + TileSize - 1) / TileSize)
+, m_tilesY((height + TileSize - 1) / TileSize)
+, m_occluderCount(0)
+, m_conservative(false)
+, m_rasterizedTriangleCount(0)
+{
+    m_depth.resize(m_pitch * m_tilesY * TileSize);
+    m_tileMaxDepth.resize(m_tilesX * m_tilesY);
+
+    Clear();
+}
+
+void OcclusionBuffer::Clear()
+{
+    // The padding pixels are set to 0 so they never raise the tile maximum,
+    // occludee tests do not read them.
+    std::fill(m_depth.begin(), m_depth.end(), 0.0f);
+    for(uint32 y = 0; y < m_height; ++y)
+    {
+        std::fill(m_depth.begin() + y * m_pitch, m_depth.begin() + y * m_pitch + m_width, FarDepth);
+    }
+    std::fill(m_tileMaxDepth.begin(), m_tileMaxDepth.end(), FarDepth);
+
+    m_occluderCount = 0;
+    m_rasterizedTriangleCount = 0;
+}
+
+void OcclusionBuffer::AddOccluder(const XMFLOAT3* positions, uint32 stride, uint32 vertexCount,
+    const uint32* indices, uint32 triangleCount, CXMMATRIX worldViewProj)
+{
+    // Occluder records (and their buffers) are kept between frames.
+    if(m_occluderCount == m_occluders.size())
+        m_occluders.resize(m_occluderCount + 1);
+
+    Occluder& occluder = m_occluders[m_occluderCount++];
+    occluder.Positions = positions;
+    occluder.Stride = stride;
+    occluder.VertexCount = vertexCount;
+    occluder.Indices = indices;
+    occluder.TriangleCount = triangleCount;
+    XMStoreFloat4x4(&occluder.WorldViewProj, worldViewProj);
+}
+
+void OcclusionBuffer::Rasterize(ThreadPool* pPool)
+{
+    ThreadPool& pool = pPool ? *pPool : ThreadPool::Shared();
+
+    // Transform and set up the triangles, one occluder per task.
+    pool.ParallelFor(m_occluderCount, 1, [this](uint32, uint32 begin, uint32 end)
+    {
+        for(uint32 i = begin; i < end; ++i)
+            SetupOccluder(m_occluders[i]);
+    });
+
+    // Each task owns whole rows of tiles, so it can also update their maximum depth.
+    pool.ParallelFor(m_tilesY, 1, [this](uint32, uint32 begin, uint32 end)
+    {
+        for(uint32 tileRow = begin; tileRow < end; ++tileRow)
+        {
+            int32 minY = (int32)(tileRow * TileSize);
+            int32 maxY = std::min(minY + (int32)TileSize, (int32)m_height) - 1;
+
+            for(uint32 i = 0; i < m_occluderCount; ++i)
+            {
+                const Occluder& occluder = m_occluders[i];
+                if(occluder.MaxY < minY || occluder.MinY > maxY)
+                    continue;
+
+                for(size_t t = 0; t < occluder.Triangles.size(); ++t)
+                {
+                    const ScreenTriangle& tri = occluder.Triangles[t];
+                    if(tri.MaxY < minY || tri.MinY > maxY)
+                        continue;
+
+                    RasterizeTriangle(tri, std::max(tri.MinY, minY), std::min(tri.MaxY, maxY));
+                }
+            }
+
+            UpdateTileRow(tileRow);
+        }
+    });
+
+    m_rasterizedTriangleCount = 0;
+    for(uint32 i = 0; i < m_occluderCount; ++i)
+    {
+        m_rasterizedTriangleCount += (uint32)m_occluders[i].Triangles.size();
+    }
+}
+
+void OcclusionBuffer::SetupOccluder(Occluder& occluder)
+{
+    occluder.Triangles.clear();
+    occluder.MinY = INT_MAX;
+    occluder.MaxY = INT_MIN;
+
+    XMMATRIX M = XMLoadFloat4x4(&occluder.WorldViewProj);
+
+    occluder.ClipVertices.resize(occluder.VertexCount);
+    for(uint32 i = 0; i < occluder.VertexCount; ++i)
+    {
+        const XMFLOAT3* p = reinterpret_cast<const XMFLOAT3*>(
+            reinterpret_cast<const uint8*>(occluder.Positions) + i * occluder.Stride);
+        XMStoreFloat4(&occluder.ClipVertices[i], XMVector3Transform(XMLoadFloat3(p), M));
+    }
+
+    for(uint32 t = 0; t < occluder.TriangleCount; ++t)
+    {
+        const XMFLOAT4* v[3] =
+        {
+            &occluder.ClipVertices[occluder.Indices[t*3 + 0]],
+            &occluder.ClipVertices[occluder.Indices[t*3 + 1]],
+            &occluder.ClipVertices[occluder.Indices[t*3 + 2]]
+        };
+
+        int inside = (v[0]->z >= 0.0f) + (v[1]->z >= 0.0f) + (v[2]->z >= 0.0f);
+        if(inside == 3)
+        {
+            SetupTriangle(occluder, *v[0], *v[1], *v[2]);
+            continue;
+        }
+        if(inside == 0)
+            continue;
+
+        // Clip against the near plane (z >= 0 in clip space), the polygon
+        // keeps the vertex order so the winding is preserved.
+        XMFLOAT4 polygon[4];
+        int count = 0;
+        for(int k = 0; k < 3; ++k)
+        {
+            const XMFLOAT4& a = *v[k];
+            const XMFLOAT4& b = *v[(k + 1) % 3];
+
+            if(a.z >= 0.0f)
+                polygon[count++] = a;
+
+            if((a.z >= 0.0f) != (b.z >= 0.0f))
+            {
+                float s = a.z / (a.z - b.z);
+                polygon[count++] = XMFLOAT4(a.x + s*(b.x - a.x), a.y + s*(b.y - a.y), 0.0f, a.w + s*(b.w - a.w));
+            }
+        }
+
+        for(int k = 2; k < count; ++k)
+            SetupTriangle(occluder, polygon[0], polygon[k - 1], polygon[k]);
+    }
+}
+
+void OcclusionBuffer::SetupTriangle(Occluder& occluder, const XMFLOAT4& v0, const XMFLOAT4& v1, const XMFLOAT4& v2)
+{
+    if(v0.w <= 0.0f || v1.w <= 0.0f || v2.w <= 0.0f)
+        return;
+
+    // To pixel coordinates (y down) and post projection depth.
+    float halfW = 0.5f * m_width;
+    float halfH = 0.5f * m_height;
+
+    float x0 = (v0.x / v0.w + 1.0f) * halfW, y0 = (1.0f - v0.y / v0.w) * halfH, z0 = v0.z / v0.w;
+    float x1 = (v1.x / v1.w + 1.0f) * halfW, y1 = (1.0f - v1.y / v1.w) * halfH, z1 = v1.z / v1.w;
+    float x2 = (v2.x / v2.w + 1.0f) * halfW, y2 = (1.0f - v2.y / v2.w) * halfH, z2 = v2.z / v2.w;
+
+    // Clockwise on screen is a positive area with y going down.
+    float area = (x1 - x0)*(y2 - y0) - (x2 - x0)*(y1 - y0);
+    if(area <= 0.0f)
+        return;
+
+    // Pixels whose center is in the bounding box.
+    float minX = std::min(x0, std::min(x1, x2));
+    float maxX = std::max(x0, std::max(x1, x2));
+    float minY = std::min(y0, std::min(y1, y2));
+    float maxY = std::max(y0, std::max(y1, y2));
+
+    ScreenTriangle tri;
+    tri.MinX = std::max((int32)ceilf(std::max(minX, -1.0f) - 0.5f), 0);
+    tri.MaxX = std::min((int32)floorf(std::min(maxX, (float)m_width) - 0.5f), (int32)m_width - 1);
+    tri.MinY = std::max((int32)ceilf(std::max(minY, -1.0f) - 0.5f), 0);
+    tri.MaxY = std::min((int32)floorf(std::min(maxY, (float)m_height) - 0.5f), (int32)m_height - 1);
+
+    if(tri.MinX > tri.MaxX || tri.MinY > tri.MaxY)
+        return;
+
+    // Edge k goes from vertex k to vertex k+1, the opposite vertex is on its positive side.
+    const float xs[3] = { x0, x1, x2 };
+    const float ys[3] = { y0, y1, y2 };
+    for(int k = 0; k < 3; ++k)
+    {
+        int n = (k + 1) % 3;
+        tri.A[k] = ys[k] - ys[n];
+        tri.B[k] = xs[n] - xs[k];
+        tri.C[k] = -tri.A[k]*xs[k] - tri.B[k]*ys[k];
+    }
+
+    tri.DzDx = ((z1 - z0)*(y2 - y0) - (z2 - z0)*(y1 - y0)) / area;
+    tri.DzDy = ((x1 - x0)*(z2 - z0) - (x2 - x0)*(z1 - z0)) / area;
+    tri.Z0 = z0 - tri.DzDx*x0 - tri.DzDy*y0;
+
+    if(m_conservative)
+    {
+        // An edge function is smallest over the pixel at a corner, half a pixel
+        // away from the center along both axes: testing the centers against
+        // edges moved inward by that much keeps the fully covered pixels only.
+        // The depth plane is shifted the same way to its farthest corner.
+        for(int k = 0; k < 3; ++k)
+            tri.C[k] -= 0.5f*(fabsf(tri.A[k]) + fabsf(tri.B[k]));
+
+        tri.Z0 += 0.5f*(fabsf(tri.DzDx) + fabsf(tri.DzDy));
+    }
+
+    occluder.Triangles.push_back(tri);
+    occluder.MinY = std::min(occluder.MinY, tri.MinY);
+    occluder.MaxY = std::max(occluder.MaxY, tri.MaxY);
+}
+
+void OcclusionBuffer::RasterizeTriangle(const ScreenTriangle& tri, int32 minY, int32 maxY)
+{
+    // Spans start on a multiple of 4 pixels, rows are padded to TileSize so
+    // the last group never goes past the row.
+    int32 startX = tri.MinX & ~3;
+
+    for(int32 y = minY; y <= maxY; ++y)
+    {
+        float py = y + 0.5f;
+        float* row = &m_depth[y * m_pitch];
+
+#if defined(OC_OCCLUSION_SSE2)
+        const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 zero = _mm_setzero_ps();
+
+        __m128 a0 = _mm_set1_ps(tri.A[0]), a1 = _mm_set1_ps(tri.A[1]), a2 = _mm_set1_ps(tri.A[2]);
+        __m128 rowE0 = _mm_set1_ps(tri.B[0]*py + tri.C[0]);
+        __m128 rowE1 = _mm_set1_ps(tri.B[1]*py + tri.C[1]);
+        __m128 rowE2 = _mm_set1_ps(tri.B[2]*py + tri.C[2]);
+        __m128 dzdx = _mm_set1_ps(tri.DzDx);
+        __m128 rowZ = _mm_set1_ps(tri.Z0 + tri.DzDy*py);
+        __m128i minX = _mm_set1_epi32(tri.MinX - 1);
+        __m128i maxX = _mm_set1_epi32(tri.MaxX + 1);
+
+        for(int32 x = startX; x <= tri.MaxX; x += 4)
+        {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+
+            __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), rowE0);
+            __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), rowE1);
+            __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), rowE2);
+
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                                       _mm_cmpge_ps(e2, zero));
+
+            // Lanes outside [MinX, MaxX] belong to the neighbour pixels.
+            __m128i lane = _mm_add_epi32(_mm_set1_epi32(x), _mm_setr_epi32(0, 1, 2, 3));
+            __m128i inRange = _mm_and_si128(_mm_cmpgt_epi32(lane, minX), _mm_cmplt_epi32(lane, maxX));
+            inside = _mm_and_ps(inside, _mm_castsi128_ps(inRange));
+
+            if(_mm_movemask_ps(inside) == 0)
+                continue;
+
+            __m128 z = _mm_add_ps(_mm_mul_ps(dzdx, px), rowZ);
+            __m128 depth = _mm_loadu_ps(row + x);
+            __m128 nearest = _mm_min_ps(depth, z);
+
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, depth)));
+        }
+#else
+        float rowE0 = tri.B[0]*py + tri.C[0];
+        float rowE1 = tri.B[1]*py + tri.C[1];
+        float rowE2 = tri.B[2]*py + tri.C[2];
+        float rowZ = tri.Z0 + tri.DzDy*py;
+
+        for(int32 x = tri.MinX; x <= tri.MaxX; ++x)
+        {
+            float px = x + 0.5f;
+
+            if(tri.A[0]*px + rowE0 < 0.0f || tri.A[1]*px + rowE1 < 0.0f || tri.A[2]*px + rowE2 < 0.0f)
+                continue;
+
+            float z = tri.DzDx*px + rowZ;
+            if(z < row[x])
+                row[x] = z;
+        }
+        (void)startX;
+#endif
+    }
+}
+
+void OcclusionBuffer::UpdateTileRow(uint32 tileRow)
+{
+    for(uint32 tileX = 0; tileX < m_tilesX; ++tileX)
+    {
+        const float* tile = &m_depth[tileRow * TileSize * m_pitch + tileX * TileSize];
+
+#if defined(OC_OCCLUSION_SSE2)
+        __m128 maxDepth = _mm_setzero_ps();
+        for(uint32 y = 0; y < TileSize; ++y)
+        {
+            maxDepth = _mm_max_ps(maxDepth, _mm_loadu_ps(tile + y * m_pitch));
+            maxDepth = _mm_max_ps(maxDepth, _mm_loadu_ps(tile + y * m_pitch + 4));
+        }
+        maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(1, 0, 3, 2)));
+        maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        m_tileMaxDepth[tileRow * m_tilesX + tileX] = _mm_cvtss_f32(maxDepth);
+#else
+        float maxDepth = 0.0f;
+        for(uint32 y = 0; y < TileSize; ++y)
+        {
+            for(uint32 x = 0; x < TileSize; ++x)
+                maxDepth = std::max(maxDepth, tile[y * m_pitch + x]);
+        }
+
+        m_tileMaxDepth[tileRow * m_tilesX + tileX] = maxDepth;
+#endif
+    }
+}
+
+bool OcclusionBuffer::IsOccluded(const XNA::AxisAlignedBox& box, CXMMATRIX viewProj) const
+{
+    XMVECTOR center = XMLoadFloat3(&box.Center);
+    XMVECTOR extents = XMLoadFloat3(&box.Extents);
+
+    // Screen rectangle and nearest depth of the 8 corners.
+    float minX = FLT_MAX, maxX = -FLT_MAX;
+    float minY = FLT_MAX, maxY = -FLT_MAX;
+    float minZ = FLT_MAX;
+
+    for(int i = 0; i < 8; ++i)
+    {
+        XMVECTOR sign = XMVectorSet((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 0.0f);
+        XMFLOAT4 clip;
+        XMStoreFloat4(&clip, XMVector3Transform(center + sign*extents, viewProj));
+
+        // Crossing the near plane, the projection is not bounded.
+        if(clip.z < 0.0f || clip.w <= 0.0f)
+            return false;
+
+        float x = (clip.x / clip.w + 1.0f) * 0.5f * m_width;
+        float y = (1.0f - clip.y / clip.w) * 0.5f * m_height;
+
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minZ = std::min(minZ, clip.z / clip.w);
+    }
+
+    // Every pixel the rectangle touches.
+    int32 x0 = std::max((int32)floorf(std::max(minX, -1.0f)), 0);
+    int32 x1 = std::min((int32)floorf(std::min(maxX, (float)m_width)), (int32)m_width - 1);
+    int32 y0 = std::max((int32)floorf(std::max(minY, -1.0f)), 0);
+    int32 y1 = std::min((int32)floorf(std::min(maxY, (float)m_height)), (int32)m_height - 1);
+
+    if(x0 > x1 || y0 > y1)
+        return false;
+
+    for(int32 tileY = y0 / TileSize; tileY <= y1 / (int32)TileSize; ++tileY)
+    {
+        for(int32 tileX = x0 / TileSize; tileX <= x1 / (int32)TileSize; ++tileX)
+        {
+            // The whole tile is nearer than the box.
+            if(m_tileMaxDepth[tileY * m_tilesX + tileX] < minZ)
+                continue;
+
+            int32 tx0 = std::max(x0, tileX * (int32)TileSize);
+            int32 tx1 = std::min(x1, tileX * (int32)TileSize + (int32)TileSize - 1);
+            int32 ty0 = std::max(y0, tileY * (int32)TileSize);
+            int32 ty1 = std::min(y1, tileY * (int32)TileSize + (int32)TileSize - 1);
+
+            for(int32 y = ty0; y <= ty1; ++y)
+            {
+                const float* row = &m_depth[y * m_pitch];
+                for(int32 x = tx0; x <= tx1; ++x)
+                {
+                    if(row[x] >= minZ)
+                        return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
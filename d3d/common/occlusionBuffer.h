@@ -0,0 +1,123 @@
+//---------------------------------------------------------------------------------------
+//
+// Software depth buffer for CPU occlusion culling.
+//
+// Occluder triangles are rasterized at low resolution into a depth buffer
+// keeping the nearest depth of each pixel, with a second level holding the
+// farthest depth of each 8x8 tile. Occludees are tested with the screen
+// rectangle and nearest depth of their bounding box: a tile farther than the
+// box is accepted at once, the pixels are only read for the others.
+//
+// By default a pixel takes the depth of an occluder at its center as soon as
+// its center is covered, like the GPU rasterizer. That is not conservative: an
+// occluder covering the center but not the whole pixel, or sloping away from
+// the camera within it, hides the pixel entirely and its farthest depth there
+// may be beyond the stored one. Occludees seen through up to half a pixel at
+// occluder silhouettes, or through gaps thinner than a pixel, can be rejected.
+// In conservative mode a pixel is only written by a triangle covering all of
+// it, with the farthest depth of the triangle over the pixel. No visible box is
+// rejected then, but the pixels along the shared edges of a mesh are covered by
+// no single triangle, so meshes with triangles near the pixel size occlude much
+// less.
+//
+// Triangle setup is split over the occluders and rasterization over rows of
+// tiles, so the worker threads never write to the same memory.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_OCCLUSIONBUFFER_H
+#define _INCGUARD_OCCLUSIONBUFFER_H
+
+#include "xnacollision.h"
+#include "types.h"
+#include <vector>
+
+class ThreadPool;
+
+class OcclusionBuffer
+{
+public:
+    static const uint32 TileSize = 8;
+
+    OcclusionBuffer(uint32 width, uint32 height);
+
+    uint32 Width() const { return m_width; }
+    uint32 Height() const { return m_height; }
+
+    // Forget the occluders and reset the depth to far.
+    void Clear();
+
+    // See above, off by default. Applies from the next Rasterize call.
+    void SetConservative(bool conservative) { m_conservative = conservative; }
+    bool IsConservative() const { return m_conservative; }
+
+    // Queue an indexed mesh as occluder. The data is read during Rasterize
+    // and must stay valid until then. Back faces (counter clockwise on
+    // screen, as for the default D3D rasterizer state) are skipped.
+    void AddOccluder(const XMFLOAT3* positions, uint32 stride, uint32 vertexCount,
+        const uint32* indices, uint32 triangleCount, CXMMATRIX worldViewProj);
+
+    // Rasterize the queued occluders. pPool may be null, the shared pool is used then.
+    void Rasterize(ThreadPool* pPool = nullptr);
+
+    // True if the world space box is hidden by the rasterized occluders.
+    // Boxes crossing the near plane or outside the screen are never occluded.
+    bool IsOccluded(const XNA::AxisAlignedBox& box, CXMMATRIX viewProj) const;
+
+    // Front facing triangles rasterized by the last Rasterize call.
+    uint32 RasterizedTriangleCount() const { return m_rasterizedTriangleCount; }
+
+private:
+    // Screen space triangle: edge functions A*x + B*y + C (>= 0 inside) and
+    // depth plane z = Z0 + DzDx*x + DzDy*y, x and y being pixel coordinates.
+    struct ScreenTriangle
+    {
+        float A[3];
+        float B[3];
+        float C[3];
+        float Z0;
+        float DzDx;
+        float DzDy;
+        int32 MinX;
+        int32 MaxX;
+        int32 MinY;
+        int32 MaxY;
+    };
+
+    struct Occluder
+    {
+        const XMFLOAT3* Positions;
+        uint32 Stride;
+        uint32 VertexCount;
+        const uint32* Indices;
+        uint32 TriangleCount;
+        XMFLOAT4X4 WorldViewProj;
+
+        // Filled by the setup pass.
+        std::vector<XMFLOAT4> ClipVertices;
+        std::vector<ScreenTriangle> Triangles;
+        int32 MinY;
+        int32 MaxY;
+    };
+
+    void SetupOccluder(Occluder& occluder);
+    void SetupTriangle(Occluder& occluder, const XMFLOAT4& v0, const XMFLOAT4& v1, const XMFLOAT4& v2);
+    void RasterizeTriangle(const ScreenTriangle& tri, int32 minY, int32 maxY);
+    void UpdateTileRow(uint32 tileRow);
+
+    uint32 m_width;
+    uint32 m_height;
+    uint32 m_pitch;             // Row length, m_width rounded up to TileSize.
+    uint32 m_tilesX;
+    uint32 m_tilesY;
+
+    std::vector<float> m_depth;
+    std::vector<float> m_tileMaxDepth;
+
+    std::vector<Occluder> m_occluders;
+    uint32 m_occluderCount;
+    bool m_conservative;
+    uint32 m_rasterizedTriangleCount;
+};
+
+#endif // _INCGUARD_OCCLUSIONBUFFER_H
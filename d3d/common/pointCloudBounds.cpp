@@ -0,0 +1,682 @@
+#include "pointCloudBounds.h"
+#include "threadPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+namespace XNA
+{
+
+// Points per chunk below which splitting the work is not worth it.
+static const uint32 g_MinPointsPerChunk = 16 * 1024;
+
+static ThreadPool& PoolOrShared( ThreadPool* pPool )
+{
+    return pPool ? *pPool : ThreadPool::Shared();
+}
+
+//-----------------------------------------------------------------------------
+// Small double precision helpers.
+//-----------------------------------------------------------------------------
+struct Ball
+{
+    double Center[3];
+    double RadiusSq;
+};
+
+static inline double DistanceSq( const double* a, const double* b )
+{
+    double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+static inline void LoadPoint( const PointStream* pPoints, uint32 i, double* p )
+{
+    p[0] = pPoints->X[i];
+    p[1] = pPoints->Y[i];
+    p[2] = pPoints->Z[i];
+}
+
+//-----------------------------------------------------------------------------
+// Eigen vectors of a symmetric 3x3 matrix with cyclic Jacobi rotations.
+// The columns of V receive the eigen vectors.
+//-----------------------------------------------------------------------------
+static void SymmetricEigenVectors( double A[3][3], double V[3][3] )
+{
+    for( int i = 0; i < 3; i++ )
+        for( int j = 0; j < 3; j++ )
+            V[i][j] = ( i == j ) ? 1.0 : 0.0;
+
+    for( int sweep = 0; sweep < 32; sweep++ )
+    {
+        double off = A[0][1] * A[0][1] + A[0][2] * A[0][2] + A[1][2] * A[1][2];
+        double diag = A[0][0] * A[0][0] + A[1][1] * A[1][1] + A[2][2] * A[2][2];
+        if( off <= 1e-24 * diag || off == 0.0 )
+            break;
+
+        for( int p = 0; p < 2; p++ )
+        {
+            for( int q = p + 1; q < 3; q++ )
+            {
+                if( A[p][q] == 0.0 )
+                    continue;
+
+                double theta = ( A[q][q] - A[p][p] ) / ( 2.0 * A[p][q] );
+                double t = ( theta >= 0.0 ? 1.0 : -1.0 ) / ( fabs( theta ) + sqrt( theta * theta + 1.0 ) );
+                double c = 1.0 / sqrt( t * t + 1.0 );
+                double s = t * c;
+
+                // A' = J^T A J
+                for( int k = 0; k < 3; k++ )
+                {
+                    double akp = A[k][p], akq = A[k][q];
+                    A[k][p] = c * akp - s * akq;
+                    A[k][q] = s * akp + c * akq;
+                }
+                for( int k = 0; k < 3; k++ )
+                {
+                    double apk = A[p][k], aqk = A[q][k];
+                    A[p][k] = c * apk - s * aqk;
+                    A[q][k] = s * apk + c * aqk;
+                }
+                for( int k = 0; k < 3; k++ )
+                {
+                    double vkp = V[k][p], vkq = V[k][q];
+                    V[k][p] = c * vkp - s * vkq;
+                    V[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Find the minimum axis aligned bounding box containing a set of points.
+//-----------------------------------------------------------------------------
+void ComputeBoundingAxisAlignedBoxFromPointStream( AxisAlignedBox* pOut, uint32 Count, const PointStream* pPoints,
+                                                   ThreadPool* pPool )
+{
+    XMASSERT( pOut );
+    XMASSERT( Count > 0 );
+    XMASSERT( pPoints );
+
+    ThreadPool& pool = PoolOrShared( pPool );
+    std::vector<float> partial( pool.ChunkCount( Count, g_MinPointsPerChunk ) * 6 );
+
+    pool.ParallelFor( Count, g_MinPointsPerChunk, [&]( uint32 chunk, uint32 begin, uint32 end )
+    {
+        float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        for( uint32 i = begin; i < end; i++ )
+        {
+            lo[0] = std::min( lo[0], pPoints->X[i] ); hi[0] = std::max( hi[0], pPoints->X[i] );
+            lo[1] = std::min( lo[1], pPoints->Y[i] ); hi[1] = std::max( hi[1], pPoints->Y[i] );
+            lo[2] = std::min( lo[2], pPoints->Z[i] ); hi[2] = std::max( hi[2], pPoints->Z[i] );
+        }
+
+        float* out = &partial[chunk * 6];
+        out[0] = lo[0]; out[1] = lo[1]; out[2] = lo[2];
+        out[3] = hi[0]; out[4] = hi[1]; out[5] = hi[2];
+    } );
+
+    float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for( size_t c = 0; c < partial.size(); c += 6 )
+    {
+        for( int k = 0; k < 3; k++ )
+        {
+            lo[k] = std::min( lo[k], partial[c + k] );
+            hi[k] = std::max( hi[k], partial[c + 3 + k] );
+        }
+    }
+
+    pOut->Center = XMFLOAT3( 0.5f * ( lo[0] + hi[0] ), 0.5f * ( lo[1] + hi[1] ), 0.5f * ( lo[2] + hi[2] ) );
+    pOut->Extents = XMFLOAT3( 0.5f * ( hi[0] - lo[0] ), 0.5f * ( hi[1] - lo[1] ), 0.5f * ( hi[2] - lo[2] ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Same principal axes algorithm as ComputeBoundingOrientedBoxFromPoints, with
+// the covariance and the extents gathered by parallel reductions. The
+// covariance is accumulated in double around a shift point to avoid the
+// cancellation of the one pass formula.
+//-----------------------------------------------------------------------------
+void ComputeBoundingOrientedBoxFromPointStream( OrientedBox* pOut, uint32 Count, const PointStream* pPoints,
+                                                ThreadPool* pPool )
+{
+    XMASSERT( pOut );
+    XMASSERT( Count > 0 );
+    XMASSERT( pPoints );
+
+    ThreadPool& pool = PoolOrShared( pPool );
+    uint32 chunkCount = pool.ChunkCount( Count, g_MinPointsPerChunk );
+
+    const double Shift[3] = { pPoints->X[0], pPoints->Y[0], pPoints->Z[0] };
+
+    // Per chunk: x, y, z, xx, yy, zz, xy, xz, yz
+    std::vector<double> moments( chunkCount * 9 );
+
+    pool.ParallelFor( Count, g_MinPointsPerChunk, [&]( uint32 chunk, uint32 begin, uint32 end )
+    {
+        double m[9] = { 0 };
+        for( uint32 i = begin; i < end; i++ )
+        {
+            double x = pPoints->X[i] - Shift[0];
+            double y = pPoints->Y[i] - Shift[1];
+            double z = pPoints->Z[i] - Shift[2];
+
+            m[0] += x; m[1] += y; m[2] += z;
+            m[3] += x * x; m[4] += y * y; m[5] += z * z;
+            m[6] += x * y; m[7] += x * z; m[8] += y * z;
+        }
+        std::copy( m, m + 9, &moments[chunk * 9] );
+    } );
+
+    double m[9] = { 0 };
+    for( uint32 c = 0; c < chunkCount; c++ )
+        for( int k = 0; k < 9; k++ )
+            m[k] += moments[c * 9 + k];
+
+    double n = (double)Count;
+    double mean[3] = { m[0] / n, m[1] / n, m[2] / n };
+
+    double C[3][3];
+    C[0][0] = m[3] / n - mean[0] * mean[0];
+    C[1][1] = m[4] / n - mean[1] * mean[1];
+    C[2][2] = m[5] / n - mean[2] * mean[2];
+    C[0][1] = C[1][0] = m[6] / n - mean[0] * mean[1];
+    C[0][2] = C[2][0] = m[7] / n - mean[0] * mean[2];
+    C[1][2] = C[2][1] = m[8] / n - mean[1] * mean[2];
+
+    double V[3][3];
+    SymmetricEigenVectors( C, V );
+
+    // Put the eigen vectors in the rows of a rotation matrix.
+    XMMATRIX R;
+    R.r[0] = XMVectorSet( (float)V[0][0], (float)V[1][0], (float)V[2][0], 0.0f );
+    R.r[1] = XMVectorSet( (float)V[0][1], (float)V[1][1], (float)V[2][1], 0.0f );
+    R.r[2] = XMVectorSet( (float)V[0][2], (float)V[1][2], (float)V[2][2], 0.0f );
+    R.r[3] = XMVectorSet( 0.0f, 0.0f, 0.0f, 1.0f );
+
+    // XMQuaternionRotationMatrix only works on right handed matrices.
+    if( XMVectorGetX( XMMatrixDeterminant( R ) ) < 0.0f )
+    {
+        R.r[0] = XMVectorNegate( R.r[0] );
+        R.r[1] = XMVectorNegate( R.r[1] );
+        R.r[2] = XMVectorNegate( R.r[2] );
+    }
+
+    XMVECTOR Orientation = XMQuaternionNormalize( XMQuaternionRotationMatrix( R ) );
+    R = XMMatrixRotationQuaternion( Orientation );
+
+    XMFLOAT3 Axis[3];
+    XMStoreFloat3( &Axis[0], R.r[0] );
+    XMStoreFloat3( &Axis[1], R.r[1] );
+    XMStoreFloat3( &Axis[2], R.r[2] );
+
+    // Extents along the axes.
+    std::vector<float> partial( chunkCount * 6 );
+
+    pool.ParallelFor( Count, g_MinPointsPerChunk, [&]( uint32 chunk, uint32 begin, uint32 end )
+    {
+        float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        for( uint32 i = begin; i < end; i++ )
+        {
+            float x = pPoints->X[i], y = pPoints->Y[i], z = pPoints->Z[i];
+            for( int k = 0; k < 3; k++ )
+            {
+                float d = x * Axis[k].x + y * Axis[k].y + z * Axis[k].z;
+                lo[k] = std::min( lo[k], d );
+                hi[k] = std::max( hi[k], d );
+            }
+        }
+
+        float* out = &partial[chunk * 6];
+        out[0] = lo[0]; out[1] = lo[1]; out[2] = lo[2];
+        out[3] = hi[0]; out[4] = hi[1]; out[5] = hi[2];
+    } );
+
+    float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for( uint32 c = 0; c < chunkCount; c++ )
+    {
+        for( int k = 0; k < 3; k++ )
+        {
+            lo[k] = std::min( lo[k], partial[c * 6 + k] );
+            hi[k] = std::max( hi[k], partial[c * 6 + 3 + k] );
+        }
+    }
+
+    // Rotate the center into world space.
+    XMVECTOR vMin = XMVectorSet( lo[0], lo[1], lo[2], 0.0f );
+    XMVECTOR vMax = XMVectorSet( hi[0], hi[1], hi[2], 0.0f );
+    XMVECTOR Center = XMVector3TransformNormal( ( vMin + vMax ) * 0.5f, R );
+
+    XMStoreFloat3( &pOut->Center, Center );
+    XMStoreFloat3( &pOut->Extents, ( vMax - vMin ) * 0.5f );
+    XMStoreFloat4( &pOut->Orientation, Orientation );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Sphere helpers.
+//-----------------------------------------------------------------------------
+
+// Grow the ball so it contains the point (Ritter's update).
+static inline void GrowBall( Ball& b, const double* p )
+{
+    double d2 = DistanceSq( b.Center, p );
+    if( d2 <= b.RadiusSq )
+        return;
+
+    double d = sqrt( d2 );
+    double r = sqrt( b.RadiusSq );
+    double newRadius = 0.5 * ( r + d );
+    double t = ( newRadius - r ) / d;
+
+    for( int k = 0; k < 3; k++ )
+        b.Center[k] += t * ( p[k] - b.Center[k] );
+
+    b.RadiusSq = newRadius * newRadius;
+}
+
+// Smallest ball containing two balls.
+static Ball MergeBalls( const Ball& a, const Ball& b )
+{
+    double ra = sqrt( a.RadiusSq ), rb = sqrt( b.RadiusSq );
+    double d = sqrt( DistanceSq( a.Center, b.Center ) );
+
+    if( d + rb <= ra )
+        return a;
+    if( d + ra <= rb )
+        return b;
+
+    Ball m;
+    double r = 0.5 * ( d + ra + rb );
+    double t = ( r - ra ) / d;
+    for( int k = 0; k < 3; k++ )
+        m.Center[k] = a.Center[k] + t * ( b.Center[k] - a.Center[k] );
+    m.RadiusSq = r * r;
+    return m;
+}
+
+// Run a Ritter growing sweep from the same start ball on every chunk and merge
+// the chunk balls. The result contains every point.
+static Ball ParallelRitterSweep( ThreadPool& pool, uint32 Count, const PointStream* pPoints, const Ball& start )
+{
+    std::vector<Ball> balls( pool.ChunkCount( Count, g_MinPointsPerChunk ), start );
+
+    pool.ParallelFor( Count, g_MinPointsPerChunk, [&]( uint32 chunk, uint32 begin, uint32 end )
+    {
+        Ball b = start;
+        double p[3];
+        for( uint32 i = begin; i < end; i++ )
+        {
+            LoadPoint( pPoints, i, p );
+            GrowBall( b, p );
+        }
+        balls[chunk] = b;
+    } );
+
+    Ball result = balls[0];
+    for( size_t c = 1; c < balls.size(); c++ )
+        result = MergeBalls( result, balls[c] );
+
+    return result;
+}
+
+// Indices of the points with the smallest and largest coordinate along each
+// axis, over the whole stream.
+static void FindAxisExtremes( ThreadPool& pool, uint32 Count, const PointStream* pPoints, uint32 lo[3], uint32 hi[3] )
+{
+    uint32 chunkCount = pool.ChunkCount( Count, g_MinPointsPerChunk );
+    std::vector<uint32> extremes( chunkCount * 6 );
+
+    pool.ParallelFor( Count, g_MinPointsPerChunk, [&]( uint32 chunk, uint32 begin, uint32 end )
+    {
+        const float* axis[3] = { pPoints->X, pPoints->Y, pPoints->Z };
+        uint32* out = &extremes[chunk * 6];
+        for( int k = 0; k < 3; k++ )
+        {
+            uint32 lo = begin, hi = begin;
+            for( uint32 i = begin + 1; i < end; i++ )
+            {
+                if( axis[k][i] < axis[k][lo] ) lo = i;
+                if( axis[k][i] > axis[k][hi] ) hi = i;
+            }
+            out[k * 2 + 0] = lo;
+            out[k * 2 + 1] = hi;
+        }
+    } );
+
+    const float* axis[3] = { pPoints->X, pPoints->Y, pPoints->Z };
+    for( int k = 0; k < 3; k++ )
+    {
+        lo[k] = extremes[k * 2 + 0];
+        hi[k] = extremes[k * 2 + 1];
+        for( uint32 c = 1; c < chunkCount; c++ )
+        {
+            uint32 l = extremes[c * 6 + k * 2 + 0];
+            uint32 h = extremes[c * 6 + k * 2 + 1];
+            if( axis[k][l] < axis[k][lo[k]] ) lo[k] = l;
+            if( axis[k][h] > axis[k][hi[k]] ) hi[k] = h;
+        }
+    }
+}
+
+// Initial ball from the most distant pair of axis extreme points.
+static Ball InitialRitterBall( const PointStream* pPoints, const uint32 lo[3], const uint32 hi[3] )
+{
+    Ball b;
+    double best = -1.0;
+    for( int k = 0; k < 3; k++ )
+    {
+        double a[3], c[3];
+        LoadPoint( pPoints, lo[k], a );
+        LoadPoint( pPoints, hi[k], c );
+
+        double d2 = DistanceSq( a, c );
+        if( d2 > best )
+        {
+            best = d2;
+            for( int j = 0; j < 3; j++ )
+                b.Center[j] = 0.5 * ( a[j] + c[j] );
+            b.RadiusSq = 0.25 * d2;
+        }
+    }
+
+    return b;
+}
+
+// Ball with two points on a diameter.
+static Ball BallFrom2( const double* a, const double* b )
+{
+    Ball r;
+    for( int k = 0; k < 3; k++ )
+        r.Center[k] = 0.5 * ( a[k] + b[k] );
+    r.RadiusSq = 0.25 * DistanceSq( a, b );
+    return r;
+}
+
+// Smallest ball with three points on its boundary (circumcircle of the triangle).
+static bool BallFrom3( const double* p0, const double* p1, const double* p2, Ball& out )
+{
+    double a[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    double b[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    double n[3] = { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+
+    double nn = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+    double aa = a[0] * a[0] + a[1] * a[1] + a[2] * a[2];
+    double bb = b[0] * b[0] + b[1] * b[1] + b[2] * b[2];
+    if( nn <= 1e-20 * aa * bb )
+        return false;
+
+    // center = p0 + (|a|^2 (b x n) + |b|^2 (n x a)) / (2 |n|^2)
+    double bxn[3] = { b[1] * n[2] - b[2] * n[1], b[2] * n[0] - b[0] * n[2], b[0] * n[1] - b[1] * n[0] };
+    double nxa[3] = { n[1] * a[2] - n[2] * a[1], n[2] * a[0] - n[0] * a[2], n[0] * a[1] - n[1] * a[0] };
+
+    double offset[3];
+    for( int k = 0; k < 3; k++ )
+    {
+        offset[k] = ( aa * bxn[k] + bb * nxa[k] ) / ( 2.0 * nn );
+        out.Center[k] = p0[k] + offset[k];
+    }
+    out.RadiusSq = offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2];
+    return true;
+}
+
+// Circumsphere of a tetrahedron.
+static bool BallFrom4( const double* p0, const double* p1, const double* p2, const double* p3, Ball& out )
+{
+    double a[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    double b[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    double c[3] = { p3[0] - p0[0], p3[1] - p0[1], p3[2] - p0[2] };
+
+    double det = a[0] * ( b[1] * c[2] - b[2] * c[1] ) - a[1] * ( b[0] * c[2] - b[2] * c[0] ) +
+                 a[2] * ( b[0] * c[1] - b[1] * c[0] );
+
+    double scale = sqrt( ( a[0] * a[0] + a[1] * a[1] + a[2] * a[2] ) *
+                         ( b[0] * b[0] + b[1] * b[1] + b[2] * b[2] ) *
+                         ( c[0] * c[0] + c[1] * c[1] + c[2] * c[2] ) );
+    if( fabs( det ) <= 1e-12 * scale )
+        return false;
+
+    double ra = 0.5 * ( a[0] * a[0] + a[1] * a[1] + a[2] * a[2] );
+    double rb = 0.5 * ( b[0] * b[0] + b[1] * b[1] + b[2] * b[2] );
+    double rc = 0.5 * ( c[0] * c[0] + c[1] * c[1] + c[2] * c[2] );
+
+    // Cramer's rule on [a; b; c] x = [ra; rb; rc]
+    double x = ( ra * ( b[1] * c[2] - b[2] * c[1] ) - a[1] * ( rb * c[2] - b[2] * rc ) +
+                 a[2] * ( rb * c[1] - b[1] * rc ) ) / det;
+    double y = ( a[0] * ( rb * c[2] - b[2] * rc ) - ra * ( b[0] * c[2] - b[2] * c[0] ) +
+                 a[2] * ( b[0] * rc - rb * c[0] ) ) / det;
+    double z = ( a[0] * ( b[1] * rc - rb * c[1] ) - a[1] * ( b[0] * rc - rb * c[0] ) +
+                 ra * ( b[0] * c[1] - b[1] * c[0] ) ) / det;
+
+    out.Center[0] = p0[0] + x;
+    out.Center[1] = p0[1] + y;
+    out.Center[2] = p0[2] + z;
+    out.RadiusSq = x * x + y * y + z * z;
+    return true;
+}
+
+static inline bool IsOutside( const Ball& b, const double* p )
+{
+    return DistanceSq( b.Center, p ) > b.RadiusSq * ( 1.0 + 1e-10 ) + 1e-20;
+}
+
+// Welzl's algorithm written as nested loops instead of recursion. Expected linear
+// time when the points come in random order.
+static Ball MinimumBall( std::vector<double>& pts )
+{
+    size_t n = pts.size() / 3;
+
+    // Deterministic shuffle.
+    uint32 seed = 0x9E3779B9u;
+    for( size_t i = n - 1; i > 0; i-- )
+    {
+        seed = seed * 1664525u + 1013904223u;
+        size_t j = seed % ( i + 1 );
+        for( int k = 0; k < 3; k++ )
+            std::swap( pts[i * 3 + k], pts[j * 3 + k] );
+    }
+
+    const double* P = &pts[0];
+
+    Ball b;
+    b.Center[0] = P[0]; b.Center[1] = P[1]; b.Center[2] = P[2];
+    b.RadiusSq = 0.0;
+
+    for( size_t i = 1; i < n; i++ )
+    {
+        if( !IsOutside( b, P + i * 3 ) )
+            continue;
+
+        b.Center[0] = P[i * 3]; b.Center[1] = P[i * 3 + 1]; b.Center[2] = P[i * 3 + 2];
+        b.RadiusSq = 0.0;
+
+        for( size_t j = 0; j < i; j++ )
+        {
+            if( !IsOutside( b, P + j * 3 ) )
+                continue;
+
+            b = BallFrom2( P + i * 3, P + j * 3 );
+
+            for( size_t k = 0; k < j; k++ )
+            {
+                if( !IsOutside( b, P + k * 3 ) )
+                    continue;
+
+                Ball b3;
+                if( !BallFrom3( P + i * 3, P + j * 3, P + k * 3, b3 ) )
+                {
+                    // Colinear points, the two farthest apart define the ball.
+                    b = MergeBalls( b, BallFrom2( P + i * 3, P + k * 3 ) );
+                    b = MergeBalls( b, BallFrom2( P + j * 3, P + k * 3 ) );
+                    continue;
+                }
+                b = b3;
+
+                for( size_t l = 0; l < k; l++ )
+                {
+                    if( !IsOutside( b, P + l * 3 ) )
+                        continue;
+
+                    Ball b4;
+                    if( BallFrom4( P + i * 3, P + j * 3, P + k * 3, P + l * 3, b4 ) )
+                        b = b4;
+                    else
+                        GrowBall( b, P + l * 3 );
+                }
+            }
+        }
+    }
+
+    return b;
+}
+
+// Find, per chunk, the point farthest outside the ball. Returns the largest
+// squared distance from the center over all points.
+static double CollectViolators( ThreadPool& pool, uint32 Count, const PointStream* pPoints, const Ball& b,
+                                std::vector<uint32>& violators )
+{
+    uint32 chunkCount = pool.ChunkCount( Count, g_MinPointsPerChunk );
+    std::vector<uint32> farthest( chunkCount );
+    std::vector<double> farthestDistSq( chunkCount );
+
+    pool.ParallelFor( Count, g_MinPointsPerChunk, [&]( uint32 chunk, uint32 begin, uint32 end )
+    {
+        double best = -1.0;
+        uint32 bestIndex = begin;
+        double p[3];
+        for( uint32 i = begin; i < end; i++ )
+        {
+            LoadPoint( pPoints, i, p );
+            double d2 = DistanceSq( b.Center, p );
+            if( d2 > best )
+            {
+                best = d2;
+                bestIndex = i;
+            }
+        }
+        farthest[chunk] = bestIndex;
+        farthestDistSq[chunk] = best;
+    } );
+
+    violators.clear();
+    double maxDistSq = 0.0;
+    for( uint32 c = 0; c < chunkCount; c++ )
+    {
+        double p[3];
+        LoadPoint( pPoints, farthest[c], p );
+        if( IsOutside( b, p ) )
+            violators.push_back( farthest[c] );
+
+        maxDistSq = std::max( maxDistSq, farthestDistSq[c] );
+    }
+
+    return maxDistSq;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Bounding sphere of a point stream.
+//
+// SPHERE_FIT_RITTER runs Ritter's growing pass on every chunk from the same
+// initial sphere then merges the chunk spheres. SPHERE_FIT_RITTER_REFINED then
+// repeatedly shrinks the sphere and grows it back, keeping the smallest one.
+// SPHERE_FIT_EXACT solves the minimum sphere on a small set of support points
+// with Welzl's algorithm, adds the points left outside (found with parallel
+// scans) and repeats until no point is outside.
+//-----------------------------------------------------------------------------
+void ComputeBoundingSphereFromPointStream( Sphere* pOut, uint32 Count, const PointStream* pPoints, SphereFit Fit,
+                                           ThreadPool* pPool )
+{
+    XMASSERT( pOut );
+    XMASSERT( Count > 0 );
+    XMASSERT( pPoints );
+
+    ThreadPool& pool = PoolOrShared( pPool );
+
+    uint32 lo[3], hi[3];
+    FindAxisExtremes( pool, Count, pPoints, lo, hi );
+
+    Ball b = InitialRitterBall( pPoints, lo, hi );
+    b = ParallelRitterSweep( pool, Count, pPoints, b );
+
+    if( Fit == SPHERE_FIT_RITTER_REFINED )
+    {
+        const int RefinePasses = 8;
+
+        Ball best = b;
+        for( int pass = 0; pass < RefinePasses; pass++ )
+        {
+            Ball shrunk = best;
+            shrunk.RadiusSq *= 0.95 * 0.95;
+
+            Ball candidate = ParallelRitterSweep( pool, Count, pPoints, shrunk );
+            if( candidate.RadiusSq < best.RadiusSq )
+                best = candidate;
+        }
+        b = best;
+    }
+    else if( Fit == SPHERE_FIT_EXACT )
+    {
+        // Support set seeded with the extreme points of the whole cloud along
+        // each axis, found for the initial Ritter ball.
+        std::vector<double> support;
+        std::vector<uint32> violators;
+
+        for( int k = 0; k < 3; k++ )
+        {
+            double p[3];
+            LoadPoint( pPoints, lo[k], p ); support.insert( support.end(), p, p + 3 );
+            LoadPoint( pPoints, hi[k], p ); support.insert( support.end(), p, p + 3 );
+        }
+
+        // Every iteration strictly grows the ball, the loop is bounded in
+        // practice by a handful of passes. Stop after a safety count and
+        // keep the enclosing Ritter sphere if it is ever reached.
+        Ball ritter = b;
+        bool converged = false;
+        for( int pass = 0; pass < 64; pass++ )
+        {
+            std::vector<double> work = support;
+            b = MinimumBall( work );
+
+            double maxDistSq = CollectViolators( pool, Count, pPoints, b, violators );
+            if( violators.empty() )
+            {
+                b.RadiusSq = std::max( b.RadiusSq, maxDistSq );
+                converged = true;
+                break;
+            }
+
+            for( size_t v = 0; v < violators.size(); v++ )
+            {
+                double p[3];
+                LoadPoint( pPoints, violators[v], p );
+                support.insert( support.end(), p, p + 3 );
+            }
+        }
+
+        if( !converged || b.RadiusSq > ritter.RadiusSq )
+            b = ritter;
+    }
+
+    pOut->Center = XMFLOAT3( (float)b.Center[0], (float)b.Center[1], (float)b.Center[2] );
+
+    // Round the radius up so the float sphere still contains every point.
+    pOut->Radius = (float)sqrt( b.RadiusSq ) * ( 1.0f + FLT_EPSILON );
+}
+
+}; // namespace
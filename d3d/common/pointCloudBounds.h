@@ -0,0 +1,52 @@
+//---------------------------------------------------------------------------------------
+//
+// Bounding volume builders for very large point sets.
+//
+// Parallel versions of the XNA::ComputeBounding*FromPoints routines reading the
+// points as structure of arrays. The work is split in chunks over a thread pool
+// and the per chunk partial results are reduced in chunk order, so the output
+// does not depend on thread timing.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_POINTCLOUDBOUNDS_H
+#define _INCGUARD_POINTCLOUDBOUNDS_H
+
+#include "xnacollision.h"
+#include "types.h"
+
+class ThreadPool;
+
+namespace XNA
+{
+
+struct PointStream
+{
+    const float* X;
+    const float* Y;
+    const float* Z;
+};
+
+enum SphereFit
+{
+    // Ritter's approximate sphere (same quality as ComputeBoundingSphereFromPoints).
+    SPHERE_FIT_RITTER = 0,
+
+    // Ritter followed by shrink and regrow passes, usually a few percents tighter.
+    SPHERE_FIT_RITTER_REFINED,
+
+    // Minimum enclosing sphere (Welzl on a growing core set of support points).
+    SPHERE_FIT_EXACT
+};
+
+// pPool may be null, the shared pool is used then.
+void ComputeBoundingAxisAlignedBoxFromPointStream( AxisAlignedBox* pOut, uint32 Count, const PointStream* pPoints,
+                                                   ThreadPool* pPool = nullptr );
+void ComputeBoundingOrientedBoxFromPointStream( OrientedBox* pOut, uint32 Count, const PointStream* pPoints,
+                                                ThreadPool* pPool = nullptr );
+void ComputeBoundingSphereFromPointStream( Sphere* pOut, uint32 Count, const PointStream* pPoints, SphereFit Fit,
+                                           ThreadPool* pPool = nullptr );
+
+}; // namespace
+
+#endif // _INCGUARD_POINTCLOUDBOUNDS_H
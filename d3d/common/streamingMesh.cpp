@@ -0,0 +1,649 @@
+#include "streamingMesh.h"
+#include "textMeshReader.h"
+#include "timer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+    // Vertices per page of the temporary vertex file.
+    const uint32 VertexPageSize = 4096;
+
+    // Records read from the text at once.
+    const uint32 StreamBatch = 64 * 1024;
+
+    // The whole model is never mapped: a 32 bits process can not map a file of
+    // several GB, and the files are read sequentially anyway.
+    int SeekFile(FILE* file, uint64 offset)
+    {
+#ifdef _WIN32
+        return _fseeki64(file, (__int64)offset, SEEK_SET);
+#else
+        return fseeko(file, (off_t)offset, SEEK_SET);
+#endif
+    }
+
+    bool ReadAt(FILE* file, uint64 offset, void* data, size_t size)
+    {
+        return SeekFile(file, offset) == 0 && fread(data, 1, size, file) == size;
+    }
+
+    // Closed and deleted when done with.
+    struct TempFile
+    {
+        TempFile(const std::string& name) : Name(name), File(fopen(name.c_str(), "w+b")) {}
+        ~TempFile()
+        {
+            if(File)
+            {
+                fclose(File);
+                remove(Name.c_str());
+            }
+        }
+
+        std::string Name;
+        FILE* File;
+    };
+
+    struct VertexRecord
+    {
+        XMFLOAT3 Pos;
+        XMFLOAT3 Normal;
+    };
+
+    struct TriangleRecord
+    {
+        uint32 Key;
+        uint32 Index[3];
+    };
+
+    bool operator<(const TriangleRecord& a, const TriangleRecord& b)
+    {
+        return a.Key < b.Key;
+    }
+
+    // Insert two zero bits between the 10 low bits of v.
+    uint32 SpreadBits(uint32 v)
+    {
+        v &= 0x3ff;
+        v = (v | (v << 16)) & 0x030000ff;
+        v = (v | (v << 8)) & 0x0300f00f;
+        v = (v | (v << 4)) & 0x030c30c3;
+        v = (v | (v << 2)) & 0x09249249;
+        return v;
+    }
+
+    // Random access to the vertices spilled in the temporary file, through an
+    // LRU cache of pages.
+    class VertexPages
+    {
+    public:
+        typedef std::vector<VertexRecord> Page;
+
+        VertexPages(FILE* file, uint32 vertexCount, uint64 byteBudget)
+        : m_file(file)
+        , m_vertexCount(vertexCount)
+        , m_cache(byteBudget)
+        , m_lastIndex(0xffffffff)
+        , m_reads(0)
+        , m_failed(false)
+        {
+        }
+
+        const VertexRecord& Get(uint32 vertex)
+        {
+            // Consecutive accesses mostly hit the same page, skip the cache then.
+            uint32 index = vertex / VertexPageSize;
+            if(index != m_lastIndex)
+            {
+                m_last = m_cache.Find(index);
+                if(!m_last)
+                {
+                    uint32 first = index * VertexPageSize;
+                    uint32 count = std::min(VertexPageSize, m_vertexCount - first);
+
+                    std::shared_ptr<Page> page = std::make_shared<Page>(count);
+                    if(!ReadAt(m_file, (uint64)first * sizeof(VertexRecord), &(*page)[0], count * sizeof(VertexRecord)))
+                    {
+                        m_failed = true;
+                        memset(&(*page)[0], 0, count * sizeof(VertexRecord));
+                    }
+
+                    m_last = page;
+                    m_cache.Insert(index, m_last, count * sizeof(VertexRecord));
+                    ++m_reads;
+                }
+                m_lastIndex = index;
+            }
+
+            return (*m_last)[vertex % VertexPageSize];
+        }
+
+        uint64 Reads() const { return m_reads; }
+        bool Failed() const { return m_failed; }
+
+    private:
+        FILE* m_file;
+        uint32 m_vertexCount;
+        LruCache<Page> m_cache;
+        LruCache<Page>::ValuePtr m_last;
+        uint32 m_lastIndex;
+        uint64 m_reads;
+        bool m_failed;
+    };
+
+    // Sequential reader of a sorted run, buffered.
+    struct RunReader
+    {
+        uint64 Offset;          // Next record in the run file.
+        uint64 Remaining;       // Records not in the buffer yet.
+        std::vector<TriangleRecord> Buffer;
+        uint32 Count;
+        uint32 Position;
+
+        bool Fill(FILE* file)
+        {
+            Count = (uint32)std::min<uint64>(Remaining, Buffer.size());
+            Position = 0;
+            if(!ReadAt(file, Offset, &Buffer[0], Count * sizeof(TriangleRecord)))
+                return false;
+
+            Offset += Count * sizeof(TriangleRecord);
+            Remaining -= Count;
+            return true;
+        }
+    };
+
+    // Gathers the triangles of a cluster and writes it.
+    class ClusterWriter
+    {
+    public:
+        ClusterWriter(FILE* file, uint64 offset, VertexPages& vertices)
+        : m_file(file)
+        , m_offset(offset)
+        , m_vertices(vertices)
+        , m_failed(false)
+        {
+        }
+
+        void AddTriangle(const uint32 index[3])
+        {
+            for(uint32 c = 0; c < 3; ++c)
+            {
+                auto it = m_localOf.find(index[c]);
+                if(it == m_localOf.end())
+                {
+                    it = m_localOf.insert(std::make_pair(index[c], (uint16)m_source.size())).first;
+                    m_source.push_back(index[c]);
+                }
+                m_indices.push_back(it->second);
+            }
+        }
+
+        uint32 TriangleCount() const { return (uint32)m_indices.size() / 3; }
+
+        void Flush()
+        {
+            if(m_indices.empty())
+                return;
+
+            uint32 vertexCount = (uint32)m_source.size();
+            m_positions.resize(vertexCount);
+            m_normals.resize(vertexCount);
+
+            XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+            XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+            for(uint32 i = 0; i < vertexCount; ++i)
+            {
+                const VertexRecord& vertex = m_vertices.Get(m_source[i]);
+                m_positions[i] = vertex.Pos;
+                m_normals[i] = vertex.Normal;
+
+                XMVECTOR P = XMLoadFloat3(&vertex.Pos);
+                vMin = XMVectorMin(vMin, P);
+                vMax = XMVectorMax(vMax, P);
+            }
+
+            MeshClusterInfo info;
+            info.Offset = m_offset;
+            info.VertexCount = vertexCount;
+            info.TriangleCount = TriangleCount();
+            XMStoreFloat3(&info.BoundsCenter, 0.5f*(vMin + vMax));
+            XMStoreFloat3(&info.BoundsExtents, 0.5f*(vMax - vMin));
+            Directory.push_back(info);
+
+            size_t indexBytes = m_indices.size() * sizeof(uint16);
+            if(fwrite(&m_positions[0], sizeof(XMFLOAT3), vertexCount, m_file) != vertexCount ||
+               fwrite(&m_normals[0], sizeof(XMFLOAT3), vertexCount, m_file) != vertexCount ||
+               fwrite(&m_indices[0], 1, indexBytes, m_file) != indexBytes)
+                m_failed = true;
+
+            m_offset += 2 * vertexCount * sizeof(XMFLOAT3) + indexBytes;
+
+            m_localOf.clear();
+            m_source.clear();
+            m_indices.clear();
+        }
+
+        uint64 Offset() const { return m_offset; }
+        bool Failed() const { return m_failed; }
+
+        std::vector<MeshClusterInfo> Directory;
+
+    private:
+        FILE* m_file;
+        uint64 m_offset;
+        VertexPages& m_vertices;
+        bool m_failed;
+
+        std::unordered_map<uint32, uint16> m_localOf;
+        std::vector<uint32> m_source;       // Source vertex of each local one.
+        std::vector<uint16> m_indices;
+        std::vector<XMFLOAT3> m_positions;
+        std::vector<XMFLOAT3> m_normals;
+    };
+}
+
+uint64 MeshCluster::ByteSize() const
+{
+    return (Positions.size() + Normals.size()) * sizeof(XMFLOAT3) + Indices.size() * sizeof(uint16);
+}
+
+bool BuildStreamingMesh(const char* textFile, const char* outFile, const StreamingMeshSettings& settings,
+    StreamingMeshBuildStats* pStats)
+{
+    Timer timer;
+    timer.Reset();
+    timer.Tick();
+
+    uint32 trianglesPerCluster = std::max(1u, std::min(settings.TrianglesPerCluster, MaxTrianglesPerCluster));
+
+    // A quarter for the vertex pages, the rest for the sort (then the merge).
+    uint64 budget = std::max<uint64>(settings.MemoryBudget, 1024 * 1024);
+    uint64 pageBudget = budget / 4;
+    uint64 sortBudget = budget - pageBudget;
+
+    TextMeshStream stream;
+    if(!stream.Open(textFile))
+        return false;
+
+    uint32 vertexCount = stream.VertexCount();
+    uint32 triangleCount = stream.TriangleCount();
+    if(vertexCount == 0 || triangleCount == 0)
+        return false;
+
+    std::string outName = outFile;
+    TempFile vertexFile(outName + ".vertices.tmp");
+    TempFile runFile(outName + ".runs.tmp");
+    if(!vertexFile.File || !runFile.File)
+        return false;
+
+    // Spill the vertices, computing the bounds on the way.
+    XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+    XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+    {
+        std::vector<VertexRecord> batch(StreamBatch);
+        uint32 read = 0;
+        while(read < vertexCount)
+        {
+            uint32 count = stream.ReadVertices(&batch[0].Pos, &batch[0].Normal, sizeof(VertexRecord), StreamBatch);
+            if(count == 0 || fwrite(&batch[0], sizeof(VertexRecord), count, vertexFile.File) != count)
+                return false;
+
+            for(uint32 i = 0; i < count; ++i)
+            {
+                XMVECTOR P = XMLoadFloat3(&batch[i].Pos);
+                vMin = XMVectorMin(vMin, P);
+                vMax = XMVectorMax(vMax, P);
+            }
+            read += count;
+        }
+
+        if(fflush(vertexFile.File) != 0)
+            return false;
+    }
+
+    XMFLOAT3 boundsMin;
+    XMFLOAT3 boundsSize;
+    XMStoreFloat3(&boundsMin, vMin);
+    XMStoreFloat3(&boundsSize, vMax - vMin);
+
+    // 10 bits per axis, the Morton key of a centroid fits 30 bits.
+    XMFLOAT3 scale(boundsSize.x > 0.0f ? 1023.0f / boundsSize.x : 0.0f,
+                   boundsSize.y > 0.0f ? 1023.0f / boundsSize.y : 0.0f,
+                   boundsSize.z > 0.0f ? 1023.0f / boundsSize.z : 0.0f);
+
+    VertexPages vertices(vertexFile.File, vertexCount, pageBudget);
+
+    // Sort the triangles by the key of their centroid, in runs that fit the
+    // budget.
+    uint32 runRecords = (uint32)std::min<uint64>(std::max<uint64>(sortBudget / sizeof(TriangleRecord), StreamBatch),
+        triangleCount);
+    std::vector<uint64> runSizes;
+    {
+        std::vector<TriangleRecord> run;
+        run.reserve(runRecords);
+        std::vector<uint32> batch(3 * StreamBatch);
+
+        uint32 read = 0;
+        while(read < triangleCount)
+        {
+            uint32 count = stream.ReadTriangles(&batch[0], std::min(StreamBatch, runRecords - (uint32)run.size()));
+            if(count == 0)
+                return false;
+
+            for(uint32 t = 0; t < count; ++t)
+            {
+                TriangleRecord record;
+                memcpy(record.Index, &batch[3 * t], sizeof(record.Index));
+
+                XMFLOAT3 p0 = vertices.Get(record.Index[0]).Pos;
+                XMFLOAT3 p1 = vertices.Get(record.Index[1]).Pos;
+                XMFLOAT3 p2 = vertices.Get(record.Index[2]).Pos;
+
+                float x = ((p0.x + p1.x + p2.x) / 3.0f - boundsMin.x) * scale.x;
+                float y = ((p0.y + p1.y + p2.y) / 3.0f - boundsMin.y) * scale.y;
+                float z = ((p0.z + p1.z + p2.z) / 3.0f - boundsMin.z) * scale.z;
+                uint32 qx = (uint32)std::min(std::max(x, 0.0f), 1023.0f);
+                uint32 qy = (uint32)std::min(std::max(y, 0.0f), 1023.0f);
+                uint32 qz = (uint32)std::min(std::max(z, 0.0f), 1023.0f);
+                record.Key = SpreadBits(qx) | (SpreadBits(qy) << 1) | (SpreadBits(qz) << 2);
+
+                run.push_back(record);
+            }
+            read += count;
+
+            if(run.size() == runRecords || read == triangleCount)
+            {
+                std::stable_sort(run.begin(), run.end());
+                if(fwrite(&run[0], sizeof(TriangleRecord), run.size(), runFile.File) != run.size())
+                    return false;
+
+                runSizes.push_back(run.size());
+                run.clear();
+            }
+        }
+
+        if(vertices.Failed() || fflush(runFile.File) != 0)
+            return false;
+    }
+
+    FILE* file = fopen(outFile, "wb");
+    if(!file)
+        return false;
+
+    StreamingMeshHeader header;
+    memset(&header, 0, sizeof(header));
+    header.Magic = StreamingMeshMagic;
+    header.Version = StreamingMeshVersion;
+    header.VertexCount = vertexCount;
+    header.TriangleCount = triangleCount;
+    header.TrianglesPerCluster = trianglesPerCluster;
+    XMStoreFloat3(&header.BoundsCenter, 0.5f*(vMin + vMax));
+    XMStoreFloat3(&header.BoundsExtents, 0.5f*(vMax - vMin));
+
+    // Written again once the directory is known.
+    bool valid = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    // Merge the runs, the smallest key first, cutting the clusters on the way.
+    ClusterWriter writer(file, sizeof(header), vertices);
+    {
+        uint32 runCount = (uint32)runSizes.size();
+        uint32 bufferRecords = (uint32)std::max<uint64>(sortBudget / runCount / sizeof(TriangleRecord), 256);
+
+        std::vector<RunReader> runs(runCount);
+        uint64 offset = 0;
+        for(uint32 r = 0; r < runCount; ++r)
+        {
+            runs[r].Offset = offset;
+            runs[r].Remaining = runSizes[r];
+            runs[r].Buffer.resize((size_t)std::min<uint64>(bufferRecords, runSizes[r]));
+            offset += runSizes[r] * sizeof(TriangleRecord);
+        }
+
+        // Key in the high bits, run in the low ones.
+        std::priority_queue<uint64, std::vector<uint64>, std::greater<uint64>> heads;
+        for(uint32 r = 0; r < runCount && valid; ++r)
+        {
+            valid = runs[r].Fill(runFile.File);
+            heads.push(((uint64)runs[r].Buffer[0].Key << 32) | r);
+        }
+
+        while(!heads.empty() && valid)
+        {
+            uint32 r = (uint32)heads.top();
+            heads.pop();
+
+            RunReader& run = runs[r];
+            writer.AddTriangle(run.Buffer[run.Position].Index);
+            if(writer.TriangleCount() == trianglesPerCluster)
+                writer.Flush();
+
+            if(++run.Position == run.Count)
+            {
+                if(run.Remaining == 0)
+                    continue;
+                valid = run.Fill(runFile.File);
+            }
+            heads.push(((uint64)run.Buffer[run.Position].Key << 32) | r);
+        }
+
+        writer.Flush();
+    }
+
+    header.ClusterCount = (uint32)writer.Directory.size();
+    header.DirectoryOffset = writer.Offset();
+
+    valid = valid && !writer.Failed() && !vertices.Failed() &&
+        fwrite(&writer.Directory[0], sizeof(MeshClusterInfo), header.ClusterCount, file) == header.ClusterCount &&
+        SeekFile(file, 0) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+
+    valid = fclose(file) == 0 && valid;
+    if(!valid)
+    {
+        remove(outFile);
+        return false;
+    }
+
+    timer.Tick();
+
+    if(pStats)
+    {
+        pStats->VertexCount = vertexCount;
+        pStats->TriangleCount = triangleCount;
+        pStats->ClusterCount = header.ClusterCount;
+        pStats->SortRuns = (uint32)runSizes.size();
+        pStats->VertexPageReads = vertices.Reads();
+        pStats->BuildTime = timer.DeltaTime();
+    }
+
+    return true;
+}
+
+StreamingMesh::StreamingMesh()
+: m_file(nullptr)
+{
+    memset(&m_header, 0, sizeof(m_header));
+}
+
+StreamingMesh::~StreamingMesh()
+{
+    Close();
+}
+
+bool StreamingMesh::Open(const char* fileName)
+{
+    Close();
+
+    m_file = fopen(fileName, "rb");
+    if(!m_file)
+        return false;
+
+    bool valid = fread(&m_header, sizeof(m_header), 1, m_file) == 1 &&
+        m_header.Magic == StreamingMeshMagic && m_header.Version == StreamingMeshVersion &&
+        m_header.TrianglesPerCluster > 0 && m_header.TrianglesPerCluster <= MaxTrianglesPerCluster &&
+        m_header.ClusterCount > 0;
+
+    if(valid)
+    {
+        m_clusters.resize(m_header.ClusterCount);
+        valid = ReadAt(m_file, m_header.DirectoryOffset, &m_clusters[0], m_clusters.size() * sizeof(MeshClusterInfo));
+    }
+
+    for(uint32 c = 0; c < m_header.ClusterCount && valid; ++c)
+    {
+        const MeshClusterInfo& info = m_clusters[c];
+        valid = info.TriangleCount > 0 && info.TriangleCount <= m_header.TrianglesPerCluster &&
+            info.VertexCount > 0 && info.VertexCount <= 3 * info.TriangleCount &&
+            info.Offset >= sizeof(m_header) && info.Offset < m_header.DirectoryOffset;
+    }
+
+    if(!valid)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void StreamingMesh::Close()
+{
+    if(m_file)
+        fclose(m_file);
+
+    m_file = nullptr;
+    memset(&m_header, 0, sizeof(m_header));
+    m_clusters.clear();
+}
+
+XNA::AxisAlignedBox StreamingMesh::Bounds() const
+{
+    XNA::AxisAlignedBox box;
+    box.Center = m_header.BoundsCenter;
+    box.Extents = m_header.BoundsExtents;
+    return box;
+}
+
+XNA::AxisAlignedBox StreamingMesh::ClusterBounds(uint32 cluster) const
+{
+    XNA::AxisAlignedBox box;
+    box.Center = m_clusters[cluster].BoundsCenter;
+    box.Extents = m_clusters[cluster].BoundsExtents;
+    return box;
+}
+
+bool StreamingMesh::ReadCluster(uint32 cluster, MeshCluster* pCluster) const
+{
+    const MeshClusterInfo& info = m_clusters[cluster];
+    pCluster->Positions.resize(info.VertexCount);
+    pCluster->Normals.resize(info.VertexCount);
+    pCluster->Indices.resize(3 * info.TriangleCount);
+
+    {
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+        if(!ReadAt(m_file, info.Offset, &pCluster->Positions[0], info.VertexCount * sizeof(XMFLOAT3)) ||
+           fread(&pCluster->Normals[0], sizeof(XMFLOAT3), info.VertexCount, m_file) != info.VertexCount ||
+           fread(&pCluster->Indices[0], sizeof(uint16), pCluster->Indices.size(), m_file) != pCluster->Indices.size())
+            return false;
+    }
+
+    for(size_t i = 0; i < pCluster->Indices.size(); ++i)
+    {
+        if(pCluster->Indices[i] >= info.VertexCount)
+            return false;
+    }
+
+    return true;
+}
+
+void StreamingMesh::CullClusters(const XNA::Frustum& frustum, std::vector<uint32>* pVisible) const
+{
+    pVisible->clear();
+    for(uint32 c = 0; c < ClusterCount(); ++c)
+    {
+        XNA::AxisAlignedBox box = ClusterBounds(c);
+        if(XNA::IntersectAxisAlignedBoxFrustum(&box, &frustum) != 0)
+            pVisible->push_back(c);
+    }
+}
+
+MeshClusterCache::MeshClusterCache(const StreamingMesh& mesh, uint64 byteBudget)
+: m_mesh(mesh)
+, m_cache(byteBudget)
+{
+}
+
+MeshClusterPtr MeshClusterCache::Acquire(uint32 cluster)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        MeshClusterPtr resident = m_cache.Find(cluster);
+        if(resident)
+            return resident;
+    }
+
+    // Read outside the lock, the resident clusters can be acquired meanwhile.
+    std::shared_ptr<MeshCluster> loaded = std::make_shared<MeshCluster>();
+    if(!m_mesh.ReadCluster(cluster, loaded.get()))
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cache.Insert(cluster, loaded, loaded->ByteSize());
+    return loaded;
+}
+
+bool MeshClusterCache::Pick(FXMVECTOR rayOrigin, FXMVECTOR rayDir, float* pDist, uint32* pCluster, uint32* pTriangle)
+{
+    // Clusters whose box the ray hits, nearest first.
+    std::vector<std::pair<float, uint32>> hits;
+    for(uint32 c = 0; c < m_mesh.ClusterCount(); ++c)
+    {
+        XNA::AxisAlignedBox box = m_mesh.ClusterBounds(c);
+        float tmin = 0.0f;
+        if(XNA::IntersectRayAxisAlignedBox(rayOrigin, rayDir, &box, &tmin))
+            hits.push_back(std::make_pair(tmin, c));
+    }
+    std::sort(hits.begin(), hits.end());
+
+    float nearest = FLT_MAX;
+    bool found = false;
+    for(size_t h = 0; h < hits.size() && hits[h].first < nearest; ++h)
+    {
+        MeshClusterPtr cluster = Acquire(hits[h].second);
+        if(!cluster)
+            continue;
+
+        uint32 triangleCount = (uint32)cluster->Indices.size() / 3;
+        for(uint32 t = 0; t < triangleCount; ++t)
+        {
+            XMVECTOR v0 = XMLoadFloat3(&cluster->Positions[cluster->Indices[3*t]]);
+            XMVECTOR v1 = XMLoadFloat3(&cluster->Positions[cluster->Indices[3*t+1]]);
+            XMVECTOR v2 = XMLoadFloat3(&cluster->Positions[cluster->Indices[3*t+2]]);
+
+            float t0 = 0.0f;
+            if(XNA::IntersectRayTriangle(rayOrigin, rayDir, v0, v1, v2, &t0) && t0 < nearest)
+            {
+                nearest = t0;
+                *pCluster = hits[h].second;
+                *pTriangle = t;
+                found = true;
+            }
+        }
+    }
+
+    if(found)
+        *pDist = nearest;
+    return found;
+}
+
+MeshClusterCache::Stats MeshClusterCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cache.GetStats();
+}
@@ -0,0 +1,163 @@
+//---------------------------------------------------------------------------------------
+//
+// Clustered mesh files, for the models too large to be held in memory.
+//
+// BuildStreamingMesh converts a text model into clusters of a fixed number of
+// triangles, without ever loading the whole model: the text is read sequentially by
+// TextMeshStream, the vertices are spilled to a temporary file, the triangles are
+// sorted along a Morton curve of their centroids in runs that fit the memory budget
+// and merged into the clusters. Neighbor triangles end in the same cluster, so each
+// cluster covers a small box.
+//
+// The file holds the clusters (local vertices, 16 bits indices) followed by a
+// directory of their offsets and bounds. StreamingMesh only keeps the directory in
+// memory, MeshClusterCache loads the clusters on demand and keeps the most recently
+// used ones within a memory budget. Picking and culling test the cluster boxes first,
+// only the clusters a ray hits are loaded.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_STREAMINGMESH_H
+#define _INCGUARD_STREAMINGMESH_H
+
+#include "lruCache.h"
+#include "xnacollision.h"
+#include "types.h"
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+const uint32 StreamingMeshMagic = 0x3143534d;   // "MSC1"
+const uint32 StreamingMeshVersion = 1;
+
+// Clusters index their vertices on 16 bits.
+const uint32 MaxTrianglesPerCluster = 0xffff / 3;
+
+struct StreamingMeshHeader
+{
+    uint32 Magic;
+    uint32 Version;
+    uint32 VertexCount;         // Of the source model.
+    uint32 TriangleCount;
+    uint32 ClusterCount;
+    uint32 TrianglesPerCluster;
+    XMFLOAT3 BoundsCenter;
+    XMFLOAT3 BoundsExtents;
+    uint64 DirectoryOffset;     // ClusterCount MeshClusterInfo.
+};
+
+// A cluster in the file: VertexCount positions, VertexCount normals, then
+// 3 * TriangleCount uint16 indices.
+struct MeshClusterInfo
+{
+    uint64 Offset;
+    uint32 VertexCount;
+    uint32 TriangleCount;
+    XMFLOAT3 BoundsCenter;
+    XMFLOAT3 BoundsExtents;
+};
+
+struct MeshCluster
+{
+    std::vector<XMFLOAT3> Positions;
+    std::vector<XMFLOAT3> Normals;
+    std::vector<uint16> Indices;
+
+    uint64 ByteSize() const;
+};
+
+typedef std::shared_ptr<const MeshCluster> MeshClusterPtr;
+
+struct StreamingMeshSettings
+{
+    StreamingMeshSettings()
+    : TrianglesPerCluster(4096)
+    , MemoryBudget(256ull * 1024 * 1024)
+    {
+    }
+
+    uint32 TrianglesPerCluster;
+    uint64 MemoryBudget;        // Bytes the build may use, the temporary files aside.
+};
+
+struct StreamingMeshBuildStats
+{
+    uint32 VertexCount;
+    uint32 TriangleCount;
+    uint32 ClusterCount;
+    uint32 SortRuns;            // Sorted runs merged into the clusters.
+    uint64 VertexPageReads;     // Pages of the vertex file read from disk.
+    float BuildTime;            // Seconds.
+};
+
+// Convert a text model. The temporary files are written next to outFile.
+// Returns false if the model can not be read or the file written.
+bool BuildStreamingMesh(const char* textFile, const char* outFile, const StreamingMeshSettings& settings,
+    StreamingMeshBuildStats* pStats = nullptr);
+
+class StreamingMesh
+{
+public:
+    StreamingMesh();
+    ~StreamingMesh();
+
+    // Read the header and the directory. Returns false if the file can not be
+    // opened or is not a valid clustered mesh.
+    bool Open(const char* fileName);
+    void Close();
+    bool IsOpen() const { return m_file != nullptr; }
+
+    const StreamingMeshHeader& Header() const { return m_header; }
+    XNA::AxisAlignedBox Bounds() const;
+
+    uint32 ClusterCount() const { return (uint32)m_clusters.size(); }
+    const MeshClusterInfo& ClusterInfo(uint32 cluster) const { return m_clusters[cluster]; }
+    XNA::AxisAlignedBox ClusterBounds(uint32 cluster) const;
+
+    // Read a cluster from the file. Can be called from several threads.
+    bool ReadCluster(uint32 cluster, MeshCluster* pCluster) const;
+
+    // Clusters whose box is in (or intersects) the frustum, given in the space
+    // of the mesh.
+    void CullClusters(const XNA::Frustum& frustum, std::vector<uint32>* pVisible) const;
+
+private:
+    StreamingMesh(const StreamingMesh&);
+    StreamingMesh& operator=(const StreamingMesh&);
+
+    FILE* m_file;
+    StreamingMeshHeader m_header;
+    std::vector<MeshClusterInfo> m_clusters;
+    mutable std::mutex m_fileMutex;
+};
+
+// Resident clusters of a streaming mesh.
+class MeshClusterCache
+{
+public:
+    typedef LruCache<MeshCluster>::Stats Stats;
+
+    MeshClusterCache(const StreamingMesh& mesh, uint64 byteBudget);
+
+    // The cluster, read from the file if it is not resident. Null on a read
+    // error.
+    MeshClusterPtr Acquire(uint32 cluster);
+
+    // Nearest triangle hit by the ray, in the space of the mesh. The clusters are
+    // visited by distance to their box and the search stops at the first box
+    // farther than the nearest hit. Returns false if nothing is hit.
+    bool Pick(FXMVECTOR rayOrigin, FXMVECTOR rayDir, float* pDist, uint32* pCluster, uint32* pTriangle);
+
+    Stats GetStats() const;
+
+private:
+    MeshClusterCache(const MeshClusterCache&);
+    MeshClusterCache& operator=(const MeshClusterCache&);
+
+    const StreamingMesh& m_mesh;
+    LruCache<MeshCluster> m_cache;
+    mutable std::mutex m_mutex;
+};
+
+#endif // _INCGUARD_STREAMINGMESH_H
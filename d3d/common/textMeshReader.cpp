@@ -0,0 +1,587 @@
+#include "textMeshReader.h"
+#include "threadPool.h"
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    // Text per parsing task (at least).
+    const uint32 ChunkBytes = 16 * 1024;
+
+    const double PowersOf10[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    bool IsSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    bool IsDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    const char* SkipSpaces(const char* p, const char* end)
+    {
+        while(p < end && IsSpace(*p))
+            ++p;
+        return p;
+    }
+
+    // Next occurrence of c, or end.
+    const char* Find(const char* p, const char* end, char c)
+    {
+        const void* found = memchr(p, c, end - p);
+        return found ? static_cast<const char*>(found) : end;
+    }
+
+    bool ParseUInt(const char*& p, const char* end, uint32* pValue)
+    {
+        p = SkipSpaces(p, end);
+        if(p == end || !IsDigit(*p))
+            return false;
+
+        uint64 value = 0;
+        while(p < end && IsDigit(*p))
+        {
+            value = value * 10 + (*p++ - '0');
+            if(value > 0xffffffff)
+                return false;
+        }
+
+        *pValue = (uint32)value;
+        return true;
+    }
+
+    // Decimal float, with optional sign, fraction and exponent. The digits are
+    // gathered in an integer then scaled once by an exact power of ten, which
+    // rounds correctly as long as both fit a double (the models have 6
+    // significant digits).
+    bool ParseFloat(const char*& p, const char* end, float* pValue)
+    {
+        p = SkipSpaces(p, end);
+
+        bool negative = false;
+        if(p < end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+
+        uint64 mantissa = 0;
+        int32 exponent = 0;
+        uint32 digits = 0;
+        bool any = false;
+
+        while(p < end && IsDigit(*p))
+        {
+            if(digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+            }
+            else
+                ++exponent;
+            ++p;
+            any = true;
+        }
+
+        if(p < end && *p == '.')
+        {
+            ++p;
+            while(p < end && IsDigit(*p))
+            {
+                if(digits < 19)
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    digits += mantissa != 0;
+                    --exponent;
+                }
+                ++p;
+                any = true;
+            }
+        }
+
+        if(!any)
+            return false;
+
+        if(p < end && (*p == 'e' || *p == 'E'))
+        {
+            ++p;
+            bool negativeExponent = false;
+            if(p < end && (*p == '-' || *p == '+'))
+                negativeExponent = *p++ == '-';
+
+            uint32 e = 0;
+            if(!ParseUInt(p, end, &e) || e > 1000)
+                return false;
+            exponent += negativeExponent ? -(int32)e : (int32)e;
+        }
+
+        double value = (double)mantissa;
+        if(exponent < 0)
+            value = exponent >= -22 ? value / PowersOf10[-exponent] : value * pow(10.0, exponent);
+        else if(exponent > 0)
+            value = exponent <= 22 ? value * PowersOf10[exponent] : value * pow(10.0, exponent);
+
+        *pValue = (float)(negative ? -value : value);
+        return true;
+    }
+
+    // Numbers (blank separated tokens) in [p, end).
+    uint32 CountTokens(const char* p, const char* end)
+    {
+        uint32 count = 0;
+        bool inToken = false;
+        for(; p < end; ++p)
+        {
+            bool space = IsSpace(*p);
+            count += !space && !inToken;
+            inToken = !space;
+        }
+        return count;
+    }
+
+    // Cut [begin, end) in pieces of about the same size, each starting at the
+    // beginning of a line. pSplits gets the chunkCount + 1 bounds.
+    void SplitLines(const char* begin, const char* end, uint32 chunkCount, std::vector<const char*>* pSplits)
+    {
+        pSplits->resize(chunkCount + 1);
+        (*pSplits)[0] = begin;
+        for(uint32 c = 1; c < chunkCount; ++c)
+        {
+            const char* p = begin + (end - begin) * c / chunkCount;
+            if(p < (*pSplits)[c - 1])
+                p = (*pSplits)[c - 1];
+
+            p = Find(p, end, '\n');
+            (*pSplits)[c] = p < end ? p + 1 : end;
+        }
+        (*pSplits)[chunkCount] = end;
+    }
+
+    // Chunks of a list and the first record of each of them.
+    struct ListChunks
+    {
+        std::vector<const char*> Splits;
+        std::vector<uint32> FirstRecord;
+    };
+
+    // Count the records of each chunk in parallel. Returns false if a chunk
+    // holds a partial record or the total is not recordCount.
+    bool SplitList(const char* begin, const char* end, uint32 valuesPerRecord, uint32 recordCount,
+        ThreadPool& pool, ListChunks* pChunks)
+    {
+        uint32 maxChunks = 4 * (pool.ThreadCount() + 1);
+        uint32 chunkCount = (uint32)((end - begin) / ChunkBytes) + 1;
+        if(chunkCount > maxChunks)
+            chunkCount = maxChunks;
+
+        SplitLines(begin, end, chunkCount, &pChunks->Splits);
+
+        std::vector<uint32> tokens(chunkCount);
+        pool.ParallelFor(chunkCount, 1, [&](uint32, uint32 first, uint32 last)
+        {
+            for(uint32 c = first; c < last; ++c)
+                tokens[c] = CountTokens(pChunks->Splits[c], pChunks->Splits[c + 1]);
+        });
+
+        pChunks->FirstRecord.resize(chunkCount + 1);
+        uint32 records = 0;
+        for(uint32 c = 0; c < chunkCount; ++c)
+        {
+            if(tokens[c] % valuesPerRecord != 0)
+                return false;
+
+            pChunks->FirstRecord[c] = records;
+            records += tokens[c] / valuesPerRecord;
+        }
+        pChunks->FirstRecord[chunkCount] = records;
+
+        return records == recordCount;
+    }
+
+    // Text between the braces following the given section name.
+    bool FindList(const char*& p, const char* end, const char* name, const char** pBegin, const char** pEnd)
+    {
+        size_t length = strlen(name);
+        for(;;)
+        {
+            p = SkipSpaces(p, end);
+            if(p == end)
+                return false;
+
+            if((size_t)(end - p) >= length && !memcmp(p, name, length))
+                break;
+
+            p = Find(p, end, '\n');
+        }
+
+        p = Find(p, end, '{');
+        if(p == end)
+            return false;
+
+        *pBegin = ++p;
+        p = Find(p, end, '}');
+        if(p == end)
+            return false;
+
+        *pEnd = p++;
+        return true;
+    }
+}
+
+TextMeshReader::TextMeshReader()
+: m_vertexCount(0)
+, m_triangleCount(0)
+, m_vertexBegin(nullptr)
+, m_vertexEnd(nullptr)
+, m_triangleBegin(nullptr)
+, m_triangleEnd(nullptr)
+{
+}
+
+bool TextMeshReader::Open(const char* fileName)
+{
+    if(!m_file.Open(fileName))
+        return false;
+
+    const char* p = reinterpret_cast<const char*>(m_file.Data());
+    const char* end = p + m_file.Size();
+
+    // "VertexCount: n" and "TriangleCount: m".
+    p = Find(p, end, ':');
+    bool valid = p < end && ParseUInt(++p, end, &m_vertexCount);
+
+    if(valid)
+    {
+        p = Find(p, end, ':');
+        valid = p < end && ParseUInt(++p, end, &m_triangleCount);
+    }
+
+    valid = valid && FindList(p, end, "VertexList", &m_vertexBegin, &m_vertexEnd) &&
+        FindList(p, end, "TriangleList", &m_triangleBegin, &m_triangleEnd);
+
+    if(!valid)
+    {
+        m_file.Close();
+        return false;
+    }
+
+    return true;
+}
+
+bool TextMeshReader::Read(XMFLOAT3* positions, XMFLOAT3* normals, uint32 stride, uint32* indices,
+    XNA::AxisAlignedBox* pBounds, ThreadPool* pPool) const
+{
+    if(!m_file.IsOpen())
+        return false;
+
+    ThreadPool& pool = pPool ? *pPool : ThreadPool::Shared();
+
+    ListChunks vertexChunks;
+    ListChunks triangleChunks;
+    if(!SplitList(m_vertexBegin, m_vertexEnd, 6, m_vertexCount, pool, &vertexChunks) ||
+       !SplitList(m_triangleBegin, m_triangleEnd, 3, m_triangleCount, pool, &triangleChunks))
+        return false;
+
+    uint32 vertexChunkCount = (uint32)vertexChunks.Splits.size() - 1;
+    uint32 triangleChunkCount = (uint32)triangleChunks.Splits.size() - 1;
+
+    // Both lists in one parallel loop, the vertex chunks first.
+    std::vector<uint8> failed(vertexChunkCount + triangleChunkCount, 0);
+    std::vector<XMFLOAT3> chunkMin(vertexChunkCount, XMFLOAT3(+FLT_MAX, +FLT_MAX, +FLT_MAX));
+    std::vector<XMFLOAT3> chunkMax(vertexChunkCount, XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+
+    uint8* positionBytes = reinterpret_cast<uint8*>(positions);
+    uint8* normalBytes = reinterpret_cast<uint8*>(normals);
+
+    pool.ParallelFor(vertexChunkCount + triangleChunkCount, 1, [&](uint32, uint32 first, uint32 last)
+    {
+        for(uint32 c = first; c < last; ++c)
+        {
+            if(c < vertexChunkCount)
+            {
+                const char* p = vertexChunks.Splits[c];
+                const char* end = vertexChunks.Splits[c + 1];
+
+                XMFLOAT3 vMin = chunkMin[c];
+                XMFLOAT3 vMax = chunkMax[c];
+                for(uint32 v = vertexChunks.FirstRecord[c]; v < vertexChunks.FirstRecord[c + 1]; ++v)
+                {
+                    XMFLOAT3* pos = reinterpret_cast<XMFLOAT3*>(positionBytes + v * stride);
+                    XMFLOAT3* normal = reinterpret_cast<XMFLOAT3*>(normalBytes + v * stride);
+                    if(!ParseFloat(p, end, &pos->x) || !ParseFloat(p, end, &pos->y) || !ParseFloat(p, end, &pos->z) ||
+                       !ParseFloat(p, end, &normal->x) || !ParseFloat(p, end, &normal->y) || !ParseFloat(p, end, &normal->z))
+                    {
+                        failed[c] = 1;
+                        break;
+                    }
+
+                    vMin.x = pos->x < vMin.x ? pos->x : vMin.x;
+                    vMin.y = pos->y < vMin.y ? pos->y : vMin.y;
+                    vMin.z = pos->z < vMin.z ? pos->z : vMin.z;
+                    vMax.x = pos->x > vMax.x ? pos->x : vMax.x;
+                    vMax.y = pos->y > vMax.y ? pos->y : vMax.y;
+                    vMax.z = pos->z > vMax.z ? pos->z : vMax.z;
+                }
+                chunkMin[c] = vMin;
+                chunkMax[c] = vMax;
+            }
+            else
+            {
+                uint32 t = c - vertexChunkCount;
+                const char* p = triangleChunks.Splits[t];
+                const char* end = triangleChunks.Splits[t + 1];
+
+                for(uint32 i = 3 * triangleChunks.FirstRecord[t]; i < 3 * triangleChunks.FirstRecord[t + 1]; ++i)
+                {
+                    if(!ParseUInt(p, end, &indices[i]) || indices[i] >= m_vertexCount)
+                    {
+                        failed[c] = 1;
+                        break;
+                    }
+                }
+            }
+        }
+    });
+
+    for(size_t c = 0; c < failed.size(); ++c)
+    {
+        if(failed[c])
+            return false;
+    }
+
+    if(pBounds)
+    {
+        XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+        XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+        for(uint32 c = 0; c < vertexChunkCount; ++c)
+        {
+            vMin = XMVectorMin(vMin, XMLoadFloat3(&chunkMin[c]));
+            vMax = XMVectorMax(vMax, XMLoadFloat3(&chunkMax[c]));
+        }
+
+        XMStoreFloat3(&pBounds->Center, 0.5f*(vMin + vMax));
+        XMStoreFloat3(&pBounds->Extents, 0.5f*(vMax - vMin));
+    }
+
+    return true;
+}
+
+namespace
+{
+    // Text buffered by TextMeshStream, and the longest record it can read.
+    const uint32 StreamBufferBytes = 1024 * 1024;
+    const uint32 MaxRecordBytes = 512;
+}
+
+TextMeshStream::TextMeshStream()
+: m_file(nullptr)
+, m_bufferSize(0)
+, m_position(0)
+, m_lineEnd(0)
+, m_vertexCount(0)
+, m_triangleCount(0)
+, m_verticesRead(0)
+, m_trianglesRead(0)
+, m_inTriangles(false)
+, m_endOfFile(false)
+, m_failed(false)
+{
+}
+
+TextMeshStream::~TextMeshStream()
+{
+    Close();
+}
+
+bool TextMeshStream::Open(const char* fileName)
+{
+    Close();
+
+    m_file = fopen(fileName, "rb");
+    if(!m_file)
+        return false;
+
+    m_buffer.resize(StreamBufferBytes);
+
+    // "VertexCount: n" and "TriangleCount: m", then the vertex list.
+    bool valid = Refill();
+    if(valid)
+    {
+        const char* begin = &m_buffer[0];
+        const char* end = begin + m_lineEnd;
+
+        const char* p = Find(begin, end, ':');
+        valid = p < end && ParseUInt(++p, end, &m_vertexCount);
+        if(valid)
+        {
+            p = Find(p, end, ':');
+            valid = p < end && ParseUInt(++p, end, &m_triangleCount);
+        }
+        m_position = (uint32)(p - begin);
+    }
+
+    if(!valid || !SkipToList())
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void TextMeshStream::Close()
+{
+    if(m_file)
+        fclose(m_file);
+
+    m_file = nullptr;
+    m_bufferSize = 0;
+    m_position = 0;
+    m_lineEnd = 0;
+    m_vertexCount = 0;
+    m_triangleCount = 0;
+    m_verticesRead = 0;
+    m_trianglesRead = 0;
+    m_inTriangles = false;
+    m_endOfFile = false;
+    m_failed = false;
+}
+
+bool TextMeshStream::Refill()
+{
+    if(m_endOfFile)
+        return false;
+
+    uint32 kept = m_bufferSize - m_position;
+    if(kept > 0 && m_position > 0)
+        memmove(&m_buffer[0], &m_buffer[m_position], kept);
+
+    size_t read = fread(&m_buffer[kept], 1, m_buffer.size() - kept, m_file);
+    m_bufferSize = kept + (uint32)read;
+    m_position = 0;
+    m_endOfFile = m_bufferSize < m_buffer.size();
+
+    if(m_endOfFile)
+    {
+        m_lineEnd = m_bufferSize;
+        return true;
+    }
+
+    // A line longer than the whole buffer is not a model.
+    const char* begin = &m_buffer[0];
+    const char* p = begin + m_bufferSize;
+    while(p > begin && p[-1] != '\n')
+        --p;
+
+    m_lineEnd = (uint32)(p - begin);
+    return m_lineEnd > 0;
+}
+
+bool TextMeshStream::SkipToList()
+{
+    for(;;)
+    {
+        const char* begin = &m_buffer[0];
+        const char* p = Find(begin + m_position, begin + m_lineEnd, '{');
+        m_position = (uint32)(p - begin);
+        if(m_position < m_lineEnd)
+        {
+            ++m_position;
+            return true;
+        }
+
+        if(!Refill())
+            return false;
+    }
+}
+
+bool TextMeshStream::NextRecord()
+{
+    if(m_lineEnd - m_position < MaxRecordBytes && !m_endOfFile)
+        return Refill();
+    return true;
+}
+
+uint32 TextMeshStream::ReadVertices(XMFLOAT3* positions, XMFLOAT3* normals, uint32 stride, uint32 maxCount)
+{
+    if(!m_file || m_failed || m_inTriangles)
+        return 0;
+
+    uint8* positionBytes = reinterpret_cast<uint8*>(positions);
+    uint8* normalBytes = reinterpret_cast<uint8*>(normals);
+
+    uint32 count = 0;
+    for(; count < maxCount && m_verticesRead < m_vertexCount; ++count, ++m_verticesRead)
+    {
+        if(!NextRecord())
+        {
+            m_failed = true;
+            break;
+        }
+
+        const char* begin = &m_buffer[0];
+        const char* p = begin + m_position;
+        const char* end = begin + m_lineEnd;
+
+        XMFLOAT3* pos = reinterpret_cast<XMFLOAT3*>(positionBytes + count * stride);
+        XMFLOAT3* normal = reinterpret_cast<XMFLOAT3*>(normalBytes + count * stride);
+        if(!ParseFloat(p, end, &pos->x) || !ParseFloat(p, end, &pos->y) || !ParseFloat(p, end, &pos->z) ||
+           !ParseFloat(p, end, &normal->x) || !ParseFloat(p, end, &normal->y) || !ParseFloat(p, end, &normal->z))
+        {
+            m_failed = true;
+            break;
+        }
+
+        m_position = (uint32)(p - begin);
+    }
+
+    return count;
+}
+
+uint32 TextMeshStream::ReadTriangles(uint32* indices, uint32 maxCount)
+{
+    if(!m_file || m_failed)
+        return 0;
+
+    if(!m_inTriangles)
+    {
+        // The vertices must be read first, the triangles come after them.
+        if(m_verticesRead != m_vertexCount || !SkipToList())
+        {
+            m_failed = true;
+            return 0;
+        }
+        m_inTriangles = true;
+    }
+
+    uint32 count = 0;
+    for(; count < maxCount && m_trianglesRead < m_triangleCount; ++count, ++m_trianglesRead)
+    {
+        if(!NextRecord())
+        {
+            m_failed = true;
+            break;
+        }
+
+        const char* begin = &m_buffer[0];
+        const char* p = begin + m_position;
+        const char* end = begin + m_lineEnd;
+
+        uint32* triangle = indices + 3 * count;
+        if(!ParseUInt(p, end, &triangle[0]) || !ParseUInt(p, end, &triangle[1]) || !ParseUInt(p, end, &triangle[2]) ||
+           triangle[0] >= m_vertexCount || triangle[1] >= m_vertexCount || triangle[2] >= m_vertexCount)
+        {
+            m_failed = true;
+            break;
+        }
+
+        m_position = (uint32)(p - begin);
+    }
+
+    return count;
+}
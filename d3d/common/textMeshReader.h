@@ -0,0 +1,127 @@
+//---------------------------------------------------------------------------------------
+//
+// Parallel reader for the text models (Models/skull.txt, Models/car.txt).
+//
+//   VertexCount: n
+//   TriangleCount: m
+//   VertexList (pos, normal)
+//   {
+//       px py pz nx ny nz
+//       ...
+//   }
+//   TriangleList
+//   {
+//       i0 i1 i2
+//       ...
+//   }
+//
+// The file is mapped, the two lists are cut in chunks at line starts and the chunks
+// are parsed by the thread pool: a first pass counts the numbers of each chunk to
+// know where its records go, the second one parses them in place. The bounds of the
+// positions are computed during the parse.
+//
+// TextMeshStream reads the same format sequentially through a fixed size buffer, for
+// the models too large to be mapped or held in memory (see streamingMesh.h).
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_TEXTMESHREADER_H
+#define _INCGUARD_TEXTMESHREADER_H
+
+#include "mappedFile.h"
+#include "xnacollision.h"
+#include "types.h"
+#include <cstdio>
+#include <vector>
+
+class ThreadPool;
+
+class TextMeshReader
+{
+public:
+    TextMeshReader();
+
+    // Map the file and read the counts. Returns false if the file can not be
+    // opened or does not look like a text model.
+    bool Open(const char* fileName);
+    void Close() { m_file.Close(); }
+
+    uint32 VertexCount() const { return m_vertexCount; }
+    uint32 TriangleCount() const { return m_triangleCount; }
+
+    // Parse the lists. Positions and normals are written with the given stride
+    // (e.g. &vertices[0].Pos, &vertices[0].Normal, sizeof(Vertex::Basic32)),
+    // indices receives 3 * TriangleCount() values. pBounds and pPool may be
+    // null, the shared pool is used then. Returns false on malformed lists or
+    // out of range indices.
+    bool Read(XMFLOAT3* positions, XMFLOAT3* normals, uint32 stride, uint32* indices,
+        XNA::AxisAlignedBox* pBounds = nullptr, ThreadPool* pPool = nullptr) const;
+
+private:
+    MappedFile m_file;
+
+    uint32 m_vertexCount;
+    uint32 m_triangleCount;
+
+    // Text between the braces of the lists.
+    const char* m_vertexBegin;
+    const char* m_vertexEnd;
+    const char* m_triangleBegin;
+    const char* m_triangleEnd;
+};
+
+class TextMeshStream
+{
+public:
+    TextMeshStream();
+    ~TextMeshStream();
+
+    // Open the file and read the counts. Returns false if the file can not be
+    // opened or does not look like a text model.
+    bool Open(const char* fileName);
+    void Close();
+
+    uint32 VertexCount() const { return m_vertexCount; }
+    uint32 TriangleCount() const { return m_triangleCount; }
+
+    // Read the next vertices, up to maxCount, with the stride of TextMeshReader.
+    // Returns the number read, 0 once all of them are read or on error.
+    uint32 ReadVertices(XMFLOAT3* positions, XMFLOAT3* normals, uint32 stride, uint32 maxCount);
+
+    // Read the next triangles (3 indices each), up to maxCount, once all the
+    // vertices are read. Returns the number read, 0 at the end or on error.
+    uint32 ReadTriangles(uint32* indices, uint32 maxCount);
+
+    // Malformed or truncated file, or out of range index.
+    bool Failed() const { return m_failed; }
+
+private:
+    TextMeshStream(const TextMeshStream&);
+    TextMeshStream& operator=(const TextMeshStream&);
+
+    // Keep the text not parsed yet and read the following one. The buffer
+    // always ends at a line end, so no record is cut.
+    bool Refill();
+
+    // Move past the next '{', reading as needed.
+    bool SkipToList();
+
+    // Make sure the next record is in the buffer.
+    bool NextRecord();
+
+    FILE* m_file;
+    std::vector<char> m_buffer;
+    uint32 m_bufferSize;        // Bytes read in the buffer.
+    uint32 m_position;          // Next byte to parse.
+    uint32 m_lineEnd;           // End of the last complete line.
+
+    uint32 m_vertexCount;
+    uint32 m_triangleCount;
+    uint32 m_verticesRead;
+    uint32 m_trianglesRead;
+    bool m_inTriangles;
+    bool m_endOfFile;
+    bool m_failed;
+};
+
+#endif // _INCGUARD_TEXTMESHREADER_H
@@ -0,0 +1,209 @@
+#include "threadPool.h"
+#include "cpuFeatures.h"
+#include <atomic>
+#include <exception>
+
+ThreadPool::ThreadPool(uint32 threadCount)
+: m_stopping(false)
+{
+    if(threadCount == 0)
+        threadCount = CpuFeatures::HardwareThreadCount();
+
+    for(uint32 i = 0; i < threadCount; ++i)
+    {
+        m_workers.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wakeUp.notify_all();
+
+    for(size_t i = 0; i < m_workers.size(); ++i)
+    {
+        m_workers[i].join();
+    }
+}
+
+ThreadPool& ThreadPool::Shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+std::future<void> ThreadPool::Submit(Task task)
+{
+    std::packaged_task<void()> packaged(task);
+    std::future<void> result = packaged.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(packaged));
+    }
+    m_wakeUp.notify_one();
+
+    return result;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    for(;;)
+    {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(!m_stopping && m_tasks.empty())
+                m_wakeUp.wait(lock);
+
+            // Drain the queue before leaving so no future is left unsatisfied.
+            if(m_tasks.empty())
+                return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+uint32 ThreadPool::ChunkCount(uint32 count, uint32 minChunkSize) const
+{
+    if(count == 0)
+        return 0;
+
+    if(minChunkSize == 0)
+        minChunkSize = 1;
+
+    // A few chunks per thread (workers plus the caller) to balance uneven work.
+    uint64 maxChunks = 4 * ((uint64)m_workers.size() + 1);
+    uint64 chunks = ((uint64)count + minChunkSize - 1) / minChunkSize;
+
+    return (uint32)(chunks < maxChunks ? chunks : maxChunks);
+}
+
+void ThreadPool::ParallelFor(uint32 count, uint32 minChunkSize, const RangeTask& task)
+{
+    uint32 chunkCount = ChunkCount(count, minChunkSize);
+    if(chunkCount == 0)
+        return;
+
+    if(chunkCount == 1 || m_workers.empty())
+    {
+        for(uint32 c = 0; c < chunkCount; ++c)
+            task(c, (uint32)((uint64)count * c / chunkCount), (uint32)((uint64)count * (c + 1) / chunkCount));
+        return;
+    }
+
+    struct Batch
+    {
+        std::atomic<uint32> next;
+        std::atomic<uint32> done;
+        std::atomic<bool> failed;
+        std::exception_ptr error;       // First exception thrown by a chunk, under mutex.
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+    batch->next = 0;
+    batch->done = 0;
+    batch->failed = false;
+
+    // The task is only referenced while chunks are left, that is before the
+    // caller returns, so capturing it by pointer is safe.
+    const RangeTask* body = &task;
+    auto runChunks = [batch, body, count, chunkCount]()
+    {
+        for(;;)
+        {
+            uint32 c = batch->next++;
+            if(c >= chunkCount)
+                break;
+
+            // A chunk that throws still counts as done, or the caller would
+            // wait forever. The chunks left after a failure are skipped.
+            if(!batch->failed)
+            {
+                try
+                {
+                    (*body)(c, (uint32)((uint64)count * c / chunkCount), (uint32)((uint64)count * (c + 1) / chunkCount));
+                }
+                catch(...)
+                {
+                    std::lock_guard<std::mutex> lock(batch->mutex);
+                    if(!batch->error)
+                        batch->error = std::current_exception();
+                    batch->failed = true;
+                }
+            }
+
+            if(++batch->done == chunkCount)
+            {
+                std::lock_guard<std::mutex> lock(batch->mutex);
+                batch->finished.notify_all();
+            }
+        }
+    };
+
+    uint32 helpers = chunkCount - 1 < ThreadCount() ? chunkCount - 1 : ThreadCount();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(uint32 i = 0; i < helpers; ++i)
+            m_tasks.push_back(std::packaged_task<void()>(runChunks));
+    }
+    m_wakeUp.notify_all();
+
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    while(batch->done != chunkCount)
+        batch->finished.wait(lock);
+
+    // Rethrown on the caller's thread once no chunk runs anymore.
+    if(batch->error)
+        std::rethrow_exception(batch->error);
+}
+
+void ThreadPool::RunAll(const Task* tasks, uint32 count)
+{
+    // One task per chunk as long as the tasks do not outnumber the chunks.
+    ParallelFor(count, 1, [tasks](uint32, uint32 begin, uint32 end)
+    {
+        for(uint32 i = begin; i < end; ++i)
+            tasks[i]();
+    });
+}
+
+uint32 ThreadPool::ParallelCompact(uint32 count, uint32 minChunkSize, const CountTask& countTask,
+    const CompactTask& compactTask)
+{
+    uint32 chunkCount = ChunkCount(count, minChunkSize);
+    if(chunkCount == 0)
+        return 0;
+
+    std::vector<uint32> offsets(chunkCount);
+    ParallelFor(count, minChunkSize, [&offsets, &countTask](uint32 chunk, uint32 begin, uint32 end)
+    {
+        offsets[chunk] = countTask(chunk, begin, end);
+    });
+
+    uint32 total = 0;
+    for(uint32 c = 0; c < chunkCount; ++c)
+    {
+        uint32 kept = offsets[c];
+        offsets[c] = total;
+        total += kept;
+    }
+
+    ParallelFor(count, minChunkSize, [&offsets, &compactTask](uint32 chunk, uint32 begin, uint32 end)
+    {
+        compactTask(chunk, begin, end, offsets[chunk]);
+    });
+
+    return total;
+}
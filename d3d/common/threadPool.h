@@ -0,0 +1,86 @@
+//---------------------------------------------------------------------------------------
+//
+// Simple worker thread pool
+//
+// Tasks are pushed in a single FIFO queue protected by a mutex. ParallelFor splits
+// a range in chunks and lets the calling thread take part in the work, so nested
+// calls from a worker cannot dead lock the pool.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef _INCGUARD_THREADPOOL_H
+#define _INCGUARD_THREADPOOL_H
+
+#include "types.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    // Chunk callback: (chunk index, first item, one past the last item).
+    typedef std::function<void(uint32, uint32, uint32)> RangeTask;
+
+    // Stream compaction callbacks. The count task returns the number of items
+    // of its chunk to keep, the compact task writes them from the given slot:
+    // (chunk index, first item, one past the last item, first output slot).
+    typedef std::function<uint32(uint32, uint32, uint32)> CountTask;
+    typedef std::function<void(uint32, uint32, uint32, uint32)> CompactTask;
+
+    // 0 means one worker per hardware thread.
+    explicit ThreadPool(uint32 threadCount = 0);
+    ~ThreadPool();
+
+    uint32 ThreadCount() const { return (uint32)m_workers.size(); }
+
+    // Queue a task, the future is ready once it ran.
+    std::future<void> Submit(Task task);
+
+    // Number of chunks ParallelFor will use for the given range. Depends only
+    // on the arguments and the pool size so per chunk results can be reduced in
+    // a deterministic order.
+    uint32 ChunkCount(uint32 count, uint32 minChunkSize) const;
+
+    // Run task on every chunk of [0, count) and wait for all of them. If a
+    // chunk throws, the chunks not started yet are skipped and the first
+    // exception is rethrown here once the others are over.
+    void ParallelFor(uint32 count, uint32 minChunkSize, const RangeTask& task);
+
+    // Run independent tasks concurrently, the caller taking its share, and
+    // wait for all of them. Meant for a handful of coarse tasks (one per file
+    // to load), the batch lasts as long as its longest task.
+    void RunAll(const Task* tasks, uint32 count);
+
+    // Keep a subset of [0, count) without locks: every chunk counts its kept
+    // items, an exclusive prefix sum over the chunks gives their first output
+    // slot, then every chunk writes its items from there. Both passes use the
+    // same chunks, so the output is in item order whatever the scheduling.
+    // Returns the number of kept items.
+    uint32 ParallelCompact(uint32 count, uint32 minChunkSize, const CountTask& countTask,
+        const CompactTask& compactTask);
+
+    // Process wide pool sized to the machine.
+    static ThreadPool& Shared();
+
+private:
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    void WorkerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::packaged_task<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    bool m_stopping;
+};
+
+#endif // _INCGUARD_THREADPOOL_H
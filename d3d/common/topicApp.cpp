@@ -23,10 +23,14 @@ bool TopicApp::Init()
 
     // Better to init d3d stuff at the beginning (buffer...)
     // Device call are expensive, specially for creating stuff
+    RequestAssets();
 	InitGeometryBuffers();
 	InitFX();
 	InitVertexLayout();
 
+    // Create what depends on the files still loading.
+    m_assets.Finish();
+
 	return true;
 }
 
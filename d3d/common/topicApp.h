@@ -9,6 +9,7 @@
 
 #include "dxApp.h"
 #include "camera.h"
+#include "assetLoader.h"
 
 class TopicApp : public DXApp
 {
@@ -28,8 +29,15 @@ public:
 protected:
     Camera m_cam;
 
+    // Files loaded in the background during Init.
+    AssetLoader m_assets;
+
 private:
 
+    // Request the files from m_assets. Called before the other Init steps so
+    // the files are read while they run, the callbacks create the device
+    // objects before Init returns.
+    virtual void RequestAssets() {}
     virtual void InitGeometryBuffers() =0;
 	virtual void InitFX() =0;
 	virtual void InitVertexLayout() =0;
@@ -2,6 +2,8 @@
 #ifndef _INCGUARD_TYPES_H
 #define _INCGUARD_TYPES_H
 
+#if defined(_MSC_VER)
+
 // link : http://msdn.microsoft.com/en-us/library/s3f49ktz.aspx
 
 typedef unsigned __int8         uint8;
@@ -14,4 +16,20 @@ typedef __int16                 int16;
 typedef __int32                 int32;
 typedef __int64                 int64;
 
+#else
+
+#include <stdint.h>
+
+typedef uint8_t                 uint8;
+typedef uint16_t                uint16;
+typedef uint32_t                uint32;
+typedef uint64_t                uint64;
+
+typedef int8_t                  int8;
+typedef int16_t                 int16;
+typedef int32_t                 int32;
+typedef int64_t                 int64;
+
+#endif
+
 #endif // _INCGUARD_TYPES_H
\ No newline at end of file
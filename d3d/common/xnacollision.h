@@ -12,8 +12,24 @@
 #ifndef _XNA_COLLISION_H_
 #define _XNA_COLLISION_H_
 
+// xnamath.h uses the Windows types. Without the min/max macros, which would
+// break std::min and std::max in the files including this one.
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
 #include <xnamath.h>
 
+// Alignment and warning control differ between compilers, keep the structure
+// declarations below free of MSVC only keywords.
+#if defined(_MSC_VER)
+#define XNA_ALIGN16 __declspec(align(16))
+#else
+#define XNA_ALIGN16 __attribute__((aligned(16)))
+#endif
+
 namespace XNA
 {
 
@@ -25,29 +41,31 @@ namespace XNA
 // premium relative to CPU cycles on Xbox 360.
 //-----------------------------------------------------------------------------
 
+#if defined(_MSC_VER)
 #pragma warning(push)
 #pragma warning(disable: 4324)
+#endif
 
-_DECLSPEC_ALIGN_16_ struct Sphere
+struct XNA_ALIGN16 Sphere
 {
     XMFLOAT3 Center;            // Center of the sphere.
     FLOAT Radius;               // Radius of the sphere.
 };
 
-_DECLSPEC_ALIGN_16_ struct AxisAlignedBox
+struct XNA_ALIGN16 AxisAlignedBox
 {
     XMFLOAT3 Center;            // Center of the box.
     XMFLOAT3 Extents;           // Distance from the center to each side.
 };
 
-_DECLSPEC_ALIGN_16_ struct OrientedBox
+struct XNA_ALIGN16 OrientedBox
 {
     XMFLOAT3 Center;            // Center of the box.
     XMFLOAT3 Extents;           // Distance from the center to each side.
     XMFLOAT4 Orientation;       // Unit quaternion representing rotation (box -> world).
 };
 
-_DECLSPEC_ALIGN_16_ struct Frustum
+struct XNA_ALIGN16 Frustum
 {
     XMFLOAT3 Origin;            // Origin of the frustum (and projection).
     XMFLOAT4 Orientation;       // Unit quaternion representing rotation.
@@ -59,7 +77,9 @@ _DECLSPEC_ALIGN_16_ struct Frustum
     FLOAT Near, Far;            // Z of the near plane and far plane.
 };
 
+#if defined(_MSC_VER)
 #pragma warning(pop)
+#endif
 
 //-----------------------------------------------------------------------------
 // Bounding volume construction.
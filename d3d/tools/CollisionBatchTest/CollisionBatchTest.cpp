@@ -0,0 +1,804 @@
+//---------------------------------------------------------------------------------------
+//
+// Differential test of the portable collision routines (collisionBatch.h and
+// collisionPortable.h).
+//
+// Random planes, boxes and spheres are generated, some of the volumes placed exactly
+// on a plane. Every batch routine is run with each backend the CPU supports and its
+// results compared with those of the scalar backend. On Windows the scalar results
+// are also compared with the XNAMath functions they reproduce:
+// XNA::IntersectAxisAlignedBox6Planes and XNA::IntersectSphere6Planes, per frustum
+// for the multi frustum routines.
+//
+// The single volume routines of collisionPortable.h are run the same way on random
+// points, rays, triangles, planes and volumes: every backend must return bitwise the
+// same results as the scalar one. On Windows they are also compared with their
+// xnacollision originals. Those do not add in the same order, so the computed values
+// are compared with a tolerance, and a few tests are allowed to flip for inputs
+// within rounding of a boundary.
+//
+// The tool only needs a C++11 compiler besides XNAMath, it builds and runs on the
+// Linux hosts too (without the XNAMath comparison):
+//   g++ -std=c++11 -O2 -I../../common CollisionBatchTest.cpp ../../common/collisionBatch.cpp
+//       ../../common/collisionPortable.cpp ../../common/cpuFeatures.cpp -o CollisionBatchTest -lpthread
+//
+// Usage: CollisionBatchTest [-count n] [-frustums n] [-cases n] [-seed n] [-runs n]
+//
+// Prints the mismatches and the throughput of every backend, returns 1 on any
+// mismatch.
+//
+//---------------------------------------------------------------------------------------
+
+#include "collisionBatch.h"
+#include "collisionPortable.h"
+#include "types.h"
+#if defined(_WIN32)
+#include "xnacollision.h"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace
+{
+    struct Volumes
+    {
+        std::vector<float> CenterX, CenterY, CenterZ;
+        std::vector<float> ExtentX, ExtentY, ExtentZ;
+        std::vector<float> Radius;
+
+        XNA::AxisAlignedBoxStream Boxes() const
+        {
+            XNA::AxisAlignedBoxStream s = { &CenterX[0], &CenterY[0], &CenterZ[0], &ExtentX[0], &ExtentY[0], &ExtentZ[0] };
+            return s;
+        }
+
+        XNA::SphereStream Spheres() const
+        {
+            XNA::SphereStream s = { &CenterX[0], &CenterY[0], &CenterZ[0], &Radius[0] };
+            return s;
+        }
+    };
+
+    // count * 6 planes (a, b, c, d), unit normals, facing away from the origin
+    // more or less like the planes of a frustum around it.
+    std::vector<float> RandomPlanes(std::mt19937& rng, uint32 frustums)
+    {
+        std::uniform_real_distribution<float> dir(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> dist(5.0f, 50.0f);
+
+        std::vector<float> planes(frustums * 6 * 4);
+        for(uint32 p = 0; p < frustums * 6; ++p)
+        {
+            float n[3];
+            float length;
+            do
+            {
+                n[0] = dir(rng);
+                n[1] = dir(rng);
+                n[2] = dir(rng);
+                length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            } while(length < 0.1f || length > 1.0f);
+
+            planes[p * 4 + 0] = n[0] / length;
+            planes[p * 4 + 1] = n[1] / length;
+            planes[p * 4 + 2] = n[2] / length;
+            planes[p * 4 + 3] = -dist(rng);
+        }
+        return planes;
+    }
+
+    // One volume in 8 touches the first plane: its center is moved onto the plane
+    // and its extents/radius set to 0, so the comparisons meet their equality case.
+    Volumes RandomVolumes(std::mt19937& rng, uint32 count, const std::vector<float>& planes)
+    {
+        std::uniform_real_distribution<float> pos(-60.0f, 60.0f);
+        std::uniform_real_distribution<float> size(0.0f, 10.0f);
+
+        Volumes v;
+        v.CenterX.resize(count);
+        v.CenterY.resize(count);
+        v.CenterZ.resize(count);
+        v.ExtentX.resize(count);
+        v.ExtentY.resize(count);
+        v.ExtentZ.resize(count);
+        v.Radius.resize(count);
+
+        for(uint32 i = 0; i < count; ++i)
+        {
+            v.CenterX[i] = pos(rng);
+            v.CenterY[i] = pos(rng);
+            v.CenterZ[i] = pos(rng);
+            v.ExtentX[i] = size(rng);
+            v.ExtentY[i] = size(rng);
+            v.ExtentZ[i] = size(rng);
+            v.Radius[i] = size(rng);
+
+            if(i % 8 == 7)
+            {
+                // Where the plane crosses the axis of the largest normal component.
+                int axis = 0;
+                for(int k = 1; k < 3; ++k)
+                {
+                    if(std::fabs(planes[k]) > std::fabs(planes[axis]))
+                        axis = k;
+                }
+                float* center[3] = { &v.CenterX[i], &v.CenterY[i], &v.CenterZ[i] };
+                for(int k = 0; k < 3; ++k)
+                    *center[k] = k == axis ? -planes[3] / planes[axis] : 0.0f;
+
+                v.ExtentX[i] = v.ExtentY[i] = v.ExtentZ[i] = 0.0f;
+                v.Radius[i] = 0.0f;
+            }
+        }
+        return v;
+    }
+
+    template<typename T>
+    uint32 CountMismatches(const char* what, const std::vector<T>& expected, const std::vector<T>& actual)
+    {
+        uint32 mismatches = 0;
+        for(size_t i = 0; i < expected.size(); ++i)
+        {
+            if(expected[i] != actual[i])
+            {
+                if(mismatches < 5)
+                    printf("  %s: volume %u, expected %u, got %u\n", what, (uint32)i, (uint32)expected[i], (uint32)actual[i]);
+                ++mismatches;
+            }
+        }
+        return mismatches;
+    }
+
+    // Best of the runs, in millions of volumes per second.
+    double Throughput(uint32 count, uint32 runs, const std::function<void()>& work)
+    {
+        double best = 0.0;
+        for(uint32 r = 0; r < runs; ++r)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            work();
+            std::chrono::duration<double> seconds = std::chrono::high_resolution_clock::now() - start;
+            if(seconds.count() > 0.0)
+                best = std::max(best, count / seconds.count() / 1e6);
+        }
+        return best;
+    }
+
+#if defined(_WIN32)
+    // Results of the XNAMath functions for the frustum f of planes.
+    void XnaResults(const Volumes& v, const std::vector<float>& planes, uint32 f,
+        std::vector<uint8>* pBoxes, std::vector<uint8>* pSpheres)
+    {
+        XMVECTOR p[6];
+        for(uint32 k = 0; k < 6; ++k)
+            p[k] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&planes[(f * 6 + k) * 4]));
+
+        for(size_t i = 0; i < v.CenterX.size(); ++i)
+        {
+            XNA::AxisAlignedBox box;
+            box.Center = XMFLOAT3(v.CenterX[i], v.CenterY[i], v.CenterZ[i]);
+            box.Extents = XMFLOAT3(v.ExtentX[i], v.ExtentY[i], v.ExtentZ[i]);
+            (*pBoxes)[i] = (uint8)XNA::IntersectAxisAlignedBox6Planes(&box, p[0], p[1], p[2], p[3], p[4], p[5]);
+
+            XNA::Sphere sphere;
+            sphere.Center = box.Center;
+            sphere.Radius = v.Radius[i];
+            (*pSpheres)[i] = (uint8)XNA::IntersectSphere6Planes(&sphere, p[0], p[1], p[2], p[3], p[4], p[5]);
+        }
+    }
+#endif
+
+    //-----------------------------------------------------------------------------
+    // Single volume routines.
+    //-----------------------------------------------------------------------------
+    namespace P = XNA::Portable;
+
+    const uint32 CLOUD_POINTS = 16;
+
+    struct SingleCase
+    {
+        P::Float4 Point;
+        P::Float4 Origin, Direction;            // Unit direction.
+        P::Float4 Triangles[2][3];
+        P::Float4 Plane;
+        P::Float4 Planes[6];
+        P::Sphere Spheres[2];
+        P::AxisAlignedBox Boxes[2];
+        P::OrientedBox OrientedBoxes[2];
+        P::Frustum Frustums[2];
+        P::Float3 Cloud[CLOUD_POINTS];
+        P::Matrix Projection;
+    };
+
+    // Return code and computed values of one routine for one case.
+    struct Outcome
+    {
+        int Code;
+        uint32 ValueCount;
+        float Values[24];
+    };
+
+    enum Routine
+    {
+        COMPUTE_SPHERE, COMPUTE_BOX, COMPUTE_ORIENTED_BOX, COMPUTE_FRUSTUM, COMPUTE_PLANES,
+        POINT_SPHERE, POINT_BOX, POINT_ORIENTED_BOX, POINT_FRUSTUM,
+        RAY_TRIANGLE, RAY_SPHERE, RAY_BOX, RAY_ORIENTED_BOX,
+        TRIANGLE_TRIANGLE, TRIANGLE_SPHERE, TRIANGLE_BOX, TRIANGLE_ORIENTED_BOX,
+        SPHERE_SPHERE, SPHERE_BOX, SPHERE_ORIENTED_BOX, BOX_BOX, BOX_ORIENTED_BOX, ORIENTED_BOX_ORIENTED_BOX,
+        TRIANGLE_FRUSTUM, SPHERE_FRUSTUM, BOX_FRUSTUM, ORIENTED_BOX_FRUSTUM, FRUSTUM_FRUSTUM,
+        TRIANGLE_6PLANES, SPHERE_6PLANES, BOX_6PLANES, ORIENTED_BOX_6PLANES, FRUSTUM_6PLANES,
+        TRIANGLE_PLANE, SPHERE_PLANE, BOX_PLANE, ORIENTED_BOX_PLANE, FRUSTUM_PLANE,
+        ROUTINE_COUNT
+    };
+
+    const char* const RoutineNames[ROUTINE_COUNT] =
+    {
+        "ComputeBoundingSphereFromPoints", "ComputeBoundingAxisAlignedBoxFromPoints",
+        "ComputeBoundingOrientedBoxFromPoints", "ComputeFrustumFromProjection", "ComputePlanesFromFrustum",
+        "IntersectPointSphere", "IntersectPointAxisAlignedBox", "IntersectPointOrientedBox", "IntersectPointFrustum",
+        "IntersectRayTriangle", "IntersectRaySphere", "IntersectRayAxisAlignedBox", "IntersectRayOrientedBox",
+        "IntersectTriangleTriangle", "IntersectTriangleSphere", "IntersectTriangleAxisAlignedBox",
+        "IntersectTriangleOrientedBox", "IntersectSphereSphere", "IntersectSphereAxisAlignedBox",
+        "IntersectSphereOrientedBox", "IntersectAxisAlignedBoxAxisAlignedBox", "IntersectAxisAlignedBoxOrientedBox",
+        "IntersectOrientedBoxOrientedBox", "IntersectTriangleFrustum", "IntersectSphereFrustum",
+        "IntersectAxisAlignedBoxFrustum", "IntersectOrientedBoxFrustum", "IntersectFrustumFrustum",
+        "IntersectTriangle6Planes", "IntersectSphere6Planes", "IntersectAxisAlignedBox6Planes",
+        "IntersectOrientedBox6Planes", "IntersectFrustum6Planes", "IntersectTrianglePlane", "IntersectSpherePlane",
+        "IntersectAxisAlignedBoxPlane", "IntersectOrientedBoxPlane", "IntersectFrustumPlane",
+    };
+
+    // Outcomes of every routine, [routine][case].
+    typedef std::vector<std::vector<Outcome> > SingleResults;
+
+    P::Float4 Make4(float x, float y, float z, float w)
+    {
+        P::Float4 v = { x, y, z, w };
+        return v;
+    }
+
+    P::Float3 Make3(float x, float y, float z)
+    {
+        P::Float3 v = { x, y, z };
+        return v;
+    }
+
+    P::Float4 RandomUnit(std::mt19937& rng, bool quaternion)
+    {
+        std::uniform_real_distribution<float> dir(-1.0f, 1.0f);
+        float v[4];
+        float length;
+        do
+        {
+            for(int k = 0; k < 4; ++k)
+                v[k] = k < 3 || quaternion ? dir(rng) : 0.0f;
+            length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3]);
+        } while(length < 0.1f || length > 1.0f);
+
+        return Make4(v[0] / length, v[1] / length, v[2] / length, v[3] / length);
+    }
+
+    // Volumes, rays and triangles gathered around the origin so that every outcome
+    // of the tests (disjoint, intersecting, contained) is common.
+    std::vector<SingleCase> RandomCases(std::mt19937& rng, uint32 count)
+    {
+        std::uniform_real_distribution<float> pos(-8.0f, 8.0f);
+        std::uniform_real_distribution<float> offset(-6.0f, 6.0f);
+        std::uniform_real_distribution<float> size(0.5f, 6.0f);
+        std::uniform_real_distribution<float> slope(0.2f, 2.0f);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        std::vector<SingleCase> cases(count);
+        for(uint32 i = 0; i < count; ++i)
+        {
+            SingleCase& c = cases[i];
+
+            c.Point = Make4(pos(rng), pos(rng), pos(rng), 0.0f);
+
+            P::Float4 target = Make4(pos(rng) * 0.5f, pos(rng) * 0.5f, pos(rng) * 0.5f, 0.0f);
+            c.Origin = Make4(pos(rng) * 2.5f, pos(rng) * 2.5f, pos(rng) * 2.5f, 0.0f);
+            float d[3] = { target.x - c.Origin.x, target.y - c.Origin.y, target.z - c.Origin.z };
+            float length = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+            c.Direction = Make4(d[0] / length, d[1] / length, d[2] / length, 0.0f);
+
+            for(int t = 0; t < 2; ++t)
+            {
+                P::Float4 center = Make4(pos(rng), pos(rng), pos(rng), 0.0f);
+                for(int v = 0; v < 3; ++v)
+                    c.Triangles[t][v] = Make4(center.x + offset(rng), center.y + offset(rng), center.z + offset(rng), 0.0f);
+            }
+
+            P::Float4 normal = RandomUnit(rng, false);
+            c.Plane = Make4(normal.x, normal.y, normal.z, pos(rng));
+            for(int k = 0; k < 6; ++k)
+            {
+                normal = RandomUnit(rng, false);
+                c.Planes[k] = Make4(normal.x, normal.y, normal.z, -size(rng) * 2.0f);
+            }
+
+            for(int v = 0; v < 2; ++v)
+            {
+                P::Float3 center = Make3(pos(rng), pos(rng), pos(rng));
+                P::Float3 extents = Make3(size(rng), size(rng), size(rng));
+
+                c.Spheres[v].Center = center;
+                c.Spheres[v].Radius = size(rng);
+                c.Boxes[v].Center = Make3(pos(rng), pos(rng), pos(rng));
+                c.Boxes[v].Extents = extents;
+                c.OrientedBoxes[v].Center = Make3(pos(rng), pos(rng), pos(rng));
+                c.OrientedBoxes[v].Extents = Make3(size(rng), size(rng), size(rng));
+                c.OrientedBoxes[v].Orientation = RandomUnit(rng, true);
+
+                P::Frustum& f = c.Frustums[v];
+                f.Origin = Make3(pos(rng) * 2.0f, pos(rng) * 2.0f, pos(rng) * 2.0f);
+                f.Orientation = RandomUnit(rng, true);
+                f.RightSlope = slope(rng);
+                f.LeftSlope = -slope(rng);
+                f.TopSlope = slope(rng);
+                f.BottomSlope = -slope(rng);
+                f.Near = size(rng) * 0.2f;
+                f.Far = f.Near + size(rng) * 5.0f;
+            }
+
+            for(uint32 p = 0; p < CLOUD_POINTS; ++p)
+                c.Cloud[p] = Make3(pos(rng), pos(rng) * 0.5f, pos(rng) * 0.25f);
+
+            // Perspective projection, left handed (XMMatrixPerspectiveFovLH).
+            float fov = 0.5f + 1.5f * unit(rng);
+            float aspect = 0.5f + 1.5f * unit(rng);
+            float zn = 0.1f + unit(rng);
+            float zf = 10.0f + 90.0f * unit(rng);
+            float yScale = 1.0f / std::tan(fov * 0.5f);
+            float range = zf / (zf - zn);
+            c.Projection.r[0] = Make4(yScale / aspect, 0.0f, 0.0f, 0.0f);
+            c.Projection.r[1] = Make4(0.0f, yScale, 0.0f, 0.0f);
+            c.Projection.r[2] = Make4(0.0f, 0.0f, range, 1.0f);
+            c.Projection.r[3] = Make4(0.0f, 0.0f, -range * zn, 0.0f);
+        }
+        return cases;
+    }
+
+    Outcome Code(int code)
+    {
+        Outcome o;
+        o.Code = code;
+        o.ValueCount = 0;
+        return o;
+    }
+
+    Outcome Values(int code, const void* values, uint32 count)
+    {
+        Outcome o;
+        o.Code = code;
+        o.ValueCount = count;
+        memcpy(o.Values, values, count * sizeof(float));
+        return o;
+    }
+
+    // Distance of a ray test, only when it hits.
+    Outcome Hit(bool hit, float dist)
+    {
+        return Values(hit, &dist, hit ? 1 : 0);
+    }
+
+    // Every routine of collisionPortable.h on every case, on the current backend.
+    SingleResults EvaluatePortable(const std::vector<SingleCase>& cases)
+    {
+        SingleResults r(ROUTINE_COUNT, std::vector<Outcome>(cases.size()));
+
+        for(size_t i = 0; i < cases.size(); ++i)
+        {
+            const SingleCase& c = cases[i];
+            const P::Float4* a = c.Triangles[0];
+            const P::Float4* b = c.Triangles[1];
+            const P::Float4* p = c.Planes;
+            float dist = 0.0f;
+            bool hit;
+
+            P::Sphere sphere;
+            P::ComputeBoundingSphereFromPoints(&sphere, CLOUD_POINTS, c.Cloud, sizeof(P::Float3));
+            r[COMPUTE_SPHERE][i] = Values(0, &sphere, 4);
+
+            P::AxisAlignedBox box;
+            P::ComputeBoundingAxisAlignedBoxFromPoints(&box, CLOUD_POINTS, c.Cloud, sizeof(P::Float3));
+            r[COMPUTE_BOX][i] = Values(0, &box, 6);
+
+            P::OrientedBox orientedBox;
+            P::ComputeBoundingOrientedBoxFromPoints(&orientedBox, CLOUD_POINTS, c.Cloud, sizeof(P::Float3));
+            r[COMPUTE_ORIENTED_BOX][i] = Values(0, &orientedBox, 10);
+
+            P::Frustum frustum;
+            P::ComputeFrustumFromProjection(&frustum, &c.Projection);
+            r[COMPUTE_FRUSTUM][i] = Values(0, &frustum.RightSlope, 6);
+
+            P::Float4 planes[6];
+            P::ComputePlanesFromFrustum(&c.Frustums[0], &planes[0], &planes[1], &planes[2], &planes[3], &planes[4],
+                &planes[5]);
+            r[COMPUTE_PLANES][i] = Values(0, planes, 24);
+
+            r[POINT_SPHERE][i] = Code(P::IntersectPointSphere(c.Point, &c.Spheres[0]));
+            r[POINT_BOX][i] = Code(P::IntersectPointAxisAlignedBox(c.Point, &c.Boxes[0]));
+            r[POINT_ORIENTED_BOX][i] = Code(P::IntersectPointOrientedBox(c.Point, &c.OrientedBoxes[0]));
+            r[POINT_FRUSTUM][i] = Code(P::IntersectPointFrustum(c.Point, &c.Frustums[0]));
+
+            hit = P::IntersectRayTriangle(c.Origin, c.Direction, a[0], a[1], a[2], &dist);
+            r[RAY_TRIANGLE][i] = Hit(hit, dist);
+            hit = P::IntersectRaySphere(c.Origin, c.Direction, &c.Spheres[0], &dist);
+            r[RAY_SPHERE][i] = Hit(hit, dist);
+            hit = P::IntersectRayAxisAlignedBox(c.Origin, c.Direction, &c.Boxes[0], &dist);
+            r[RAY_BOX][i] = Hit(hit, dist);
+            hit = P::IntersectRayOrientedBox(c.Origin, c.Direction, &c.OrientedBoxes[0], &dist);
+            r[RAY_ORIENTED_BOX][i] = Hit(hit, dist);
+
+            r[TRIANGLE_TRIANGLE][i] = Code(P::IntersectTriangleTriangle(a[0], a[1], a[2], b[0], b[1], b[2]));
+            r[TRIANGLE_SPHERE][i] = Code(P::IntersectTriangleSphere(a[0], a[1], a[2], &c.Spheres[0]));
+            r[TRIANGLE_BOX][i] = Code(P::IntersectTriangleAxisAlignedBox(a[0], a[1], a[2], &c.Boxes[0]));
+            r[TRIANGLE_ORIENTED_BOX][i] = Code(P::IntersectTriangleOrientedBox(a[0], a[1], a[2], &c.OrientedBoxes[0]));
+
+            r[SPHERE_SPHERE][i] = Code(P::IntersectSphereSphere(&c.Spheres[0], &c.Spheres[1]));
+            r[SPHERE_BOX][i] = Code(P::IntersectSphereAxisAlignedBox(&c.Spheres[0], &c.Boxes[0]));
+            r[SPHERE_ORIENTED_BOX][i] = Code(P::IntersectSphereOrientedBox(&c.Spheres[0], &c.OrientedBoxes[0]));
+            r[BOX_BOX][i] = Code(P::IntersectAxisAlignedBoxAxisAlignedBox(&c.Boxes[0], &c.Boxes[1]));
+            r[BOX_ORIENTED_BOX][i] = Code(P::IntersectAxisAlignedBoxOrientedBox(&c.Boxes[0], &c.OrientedBoxes[0]));
+            r[ORIENTED_BOX_ORIENTED_BOX][i] = Code(P::IntersectOrientedBoxOrientedBox(&c.OrientedBoxes[0],
+                &c.OrientedBoxes[1]));
+
+            r[TRIANGLE_FRUSTUM][i] = Code(P::IntersectTriangleFrustum(a[0], a[1], a[2], &c.Frustums[0]));
+            r[SPHERE_FRUSTUM][i] = Code(P::IntersectSphereFrustum(&c.Spheres[0], &c.Frustums[0]));
+            r[BOX_FRUSTUM][i] = Code(P::IntersectAxisAlignedBoxFrustum(&c.Boxes[0], &c.Frustums[0]));
+            r[ORIENTED_BOX_FRUSTUM][i] = Code(P::IntersectOrientedBoxFrustum(&c.OrientedBoxes[0], &c.Frustums[0]));
+            r[FRUSTUM_FRUSTUM][i] = Code(P::IntersectFrustumFrustum(&c.Frustums[0], &c.Frustums[1]));
+
+            r[TRIANGLE_6PLANES][i] = Code(P::IntersectTriangle6Planes(a[0], a[1], a[2], p[0], p[1], p[2], p[3], p[4],
+                p[5]));
+            r[SPHERE_6PLANES][i] = Code(P::IntersectSphere6Planes(&c.Spheres[0], p[0], p[1], p[2], p[3], p[4], p[5]));
+            r[BOX_6PLANES][i] = Code(P::IntersectAxisAlignedBox6Planes(&c.Boxes[0], p[0], p[1], p[2], p[3], p[4],
+                p[5]));
+            r[ORIENTED_BOX_6PLANES][i] = Code(P::IntersectOrientedBox6Planes(&c.OrientedBoxes[0], p[0], p[1], p[2],
+                p[3], p[4], p[5]));
+            r[FRUSTUM_6PLANES][i] = Code(P::IntersectFrustum6Planes(&c.Frustums[0], p[0], p[1], p[2], p[3], p[4],
+                p[5]));
+
+            r[TRIANGLE_PLANE][i] = Code(P::IntersectTrianglePlane(a[0], a[1], a[2], c.Plane));
+            r[SPHERE_PLANE][i] = Code(P::IntersectSpherePlane(&c.Spheres[0], c.Plane));
+            r[BOX_PLANE][i] = Code(P::IntersectAxisAlignedBoxPlane(&c.Boxes[0], c.Plane));
+            r[ORIENTED_BOX_PLANE][i] = Code(P::IntersectOrientedBoxPlane(&c.OrientedBoxes[0], c.Plane));
+            r[FRUSTUM_PLANE][i] = Code(P::IntersectFrustumPlane(&c.Frustums[0], c.Plane));
+        }
+        return r;
+    }
+
+    // Cases of a routine where the two backends do not return the very same bits.
+    uint32 CountSingleMismatches(const SingleResults& expected, const SingleResults& actual)
+    {
+        uint32 mismatches = 0;
+        for(uint32 f = 0; f < ROUTINE_COUNT; ++f)
+        {
+            uint32 routineMismatches = 0;
+            for(size_t i = 0; i < expected[f].size(); ++i)
+            {
+                const Outcome& e = expected[f][i];
+                const Outcome& a = actual[f][i];
+                if(e.Code != a.Code || e.ValueCount != a.ValueCount
+                    || memcmp(e.Values, a.Values, e.ValueCount * sizeof(float)))
+                {
+                    if(routineMismatches < 3)
+                        printf("  %s: case %u, expected %d, got %d\n", RoutineNames[f], (uint32)i, e.Code, a.Code);
+                    ++routineMismatches;
+                }
+            }
+            mismatches += routineMismatches;
+        }
+        return mismatches;
+    }
+
+#if defined(_WIN32)
+    XMVECTOR Load(const P::Float4& v)
+    {
+        return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&v));
+    }
+
+    // The same routines through xnacollision, the volume structures have the same layout.
+    SingleResults EvaluateXna(const std::vector<SingleCase>& cases)
+    {
+        SingleResults r(ROUTINE_COUNT, std::vector<Outcome>(cases.size()));
+
+        for(size_t i = 0; i < cases.size(); ++i)
+        {
+            const SingleCase& c = cases[i];
+            XMVECTOR a[3], b[3], p[6];
+            for(int v = 0; v < 3; ++v)
+            {
+                a[v] = Load(c.Triangles[0][v]);
+                b[v] = Load(c.Triangles[1][v]);
+            }
+            for(int k = 0; k < 6; ++k)
+                p[k] = Load(c.Planes[k]);
+            XMVECTOR point = Load(c.Point);
+            XMVECTOR origin = Load(c.Origin);
+            XMVECTOR direction = Load(c.Direction);
+            XMVECTOR plane = Load(c.Plane);
+            const XMFLOAT3* cloud = reinterpret_cast<const XMFLOAT3*>(c.Cloud);
+
+            const XNA::Sphere* spheres = reinterpret_cast<const XNA::Sphere*>(c.Spheres);
+            const XNA::AxisAlignedBox* boxes = reinterpret_cast<const XNA::AxisAlignedBox*>(c.Boxes);
+            const XNA::OrientedBox* orientedBoxes = reinterpret_cast<const XNA::OrientedBox*>(c.OrientedBoxes);
+            const XNA::Frustum* frustums = reinterpret_cast<const XNA::Frustum*>(c.Frustums);
+            float dist = 0.0f;
+            BOOL hit;
+
+            XNA::Sphere sphere;
+            XNA::ComputeBoundingSphereFromPoints(&sphere, CLOUD_POINTS, cloud, sizeof(XMFLOAT3));
+            r[COMPUTE_SPHERE][i] = Values(0, &sphere, 4);
+
+            XNA::AxisAlignedBox box;
+            XNA::ComputeBoundingAxisAlignedBoxFromPoints(&box, CLOUD_POINTS, cloud, sizeof(XMFLOAT3));
+            r[COMPUTE_BOX][i] = Values(0, &box, 6);
+
+            XNA::OrientedBox orientedBox;
+            XNA::ComputeBoundingOrientedBoxFromPoints(&orientedBox, CLOUD_POINTS, cloud, sizeof(XMFLOAT3));
+            r[COMPUTE_ORIENTED_BOX][i] = Values(0, &orientedBox, 10);
+
+            XMMATRIX projection;
+            for(int k = 0; k < 4; ++k)
+                projection.r[k] = Load(c.Projection.r[k]);
+            XNA::Frustum frustum;
+            XNA::ComputeFrustumFromProjection(&frustum, &projection);
+            r[COMPUTE_FRUSTUM][i] = Values(0, &frustum.RightSlope, 6);
+
+            XMVECTOR planes[6];
+            XNA::ComputePlanesFromFrustum(&frustums[0], &planes[0], &planes[1], &planes[2], &planes[3], &planes[4],
+                &planes[5]);
+            XMFLOAT4 stored[6];
+            for(int k = 0; k < 6; ++k)
+                XMStoreFloat4(&stored[k], planes[k]);
+            r[COMPUTE_PLANES][i] = Values(0, stored, 24);
+
+            r[POINT_SPHERE][i] = Code(XNA::IntersectPointSphere(point, &spheres[0]));
+            r[POINT_BOX][i] = Code(XNA::IntersectPointAxisAlignedBox(point, &boxes[0]));
+            r[POINT_ORIENTED_BOX][i] = Code(XNA::IntersectPointOrientedBox(point, &orientedBoxes[0]));
+            r[POINT_FRUSTUM][i] = Code(XNA::IntersectPointFrustum(point, &frustums[0]));
+
+            hit = XNA::IntersectRayTriangle(origin, direction, a[0], a[1], a[2], &dist);
+            r[RAY_TRIANGLE][i] = Hit(hit != FALSE, dist);
+            hit = XNA::IntersectRaySphere(origin, direction, &spheres[0], &dist);
+            r[RAY_SPHERE][i] = Hit(hit != FALSE, dist);
+            hit = XNA::IntersectRayAxisAlignedBox(origin, direction, &boxes[0], &dist);
+            r[RAY_BOX][i] = Hit(hit != FALSE, dist);
+            hit = XNA::IntersectRayOrientedBox(origin, direction, &orientedBoxes[0], &dist);
+            r[RAY_ORIENTED_BOX][i] = Hit(hit != FALSE, dist);
+
+            r[TRIANGLE_TRIANGLE][i] = Code(XNA::IntersectTriangleTriangle(a[0], a[1], a[2], b[0], b[1], b[2]) != FALSE);
+            r[TRIANGLE_SPHERE][i] = Code(XNA::IntersectTriangleSphere(a[0], a[1], a[2], &spheres[0]) != FALSE);
+            r[TRIANGLE_BOX][i] = Code(XNA::IntersectTriangleAxisAlignedBox(a[0], a[1], a[2], &boxes[0]) != FALSE);
+            r[TRIANGLE_ORIENTED_BOX][i] = Code(XNA::IntersectTriangleOrientedBox(a[0], a[1], a[2],
+                &orientedBoxes[0]) != FALSE);
+
+            r[SPHERE_SPHERE][i] = Code(XNA::IntersectSphereSphere(&spheres[0], &spheres[1]) != FALSE);
+            r[SPHERE_BOX][i] = Code(XNA::IntersectSphereAxisAlignedBox(&spheres[0], &boxes[0]) != FALSE);
+            r[SPHERE_ORIENTED_BOX][i] = Code(XNA::IntersectSphereOrientedBox(&spheres[0], &orientedBoxes[0]) != FALSE);
+            r[BOX_BOX][i] = Code(XNA::IntersectAxisAlignedBoxAxisAlignedBox(&boxes[0], &boxes[1]) != FALSE);
+            r[BOX_ORIENTED_BOX][i] = Code(XNA::IntersectAxisAlignedBoxOrientedBox(&boxes[0], &orientedBoxes[0])
+                != FALSE);
+            r[ORIENTED_BOX_ORIENTED_BOX][i] = Code(XNA::IntersectOrientedBoxOrientedBox(&orientedBoxes[0],
+                &orientedBoxes[1]) != FALSE);
+
+            r[TRIANGLE_FRUSTUM][i] = Code(XNA::IntersectTriangleFrustum(a[0], a[1], a[2], &frustums[0]));
+            r[SPHERE_FRUSTUM][i] = Code(XNA::IntersectSphereFrustum(&spheres[0], &frustums[0]));
+            r[BOX_FRUSTUM][i] = Code(XNA::IntersectAxisAlignedBoxFrustum(&boxes[0], &frustums[0]));
+            r[ORIENTED_BOX_FRUSTUM][i] = Code(XNA::IntersectOrientedBoxFrustum(&orientedBoxes[0], &frustums[0]));
+            r[FRUSTUM_FRUSTUM][i] = Code(XNA::IntersectFrustumFrustum(&frustums[0], &frustums[1]));
+
+            r[TRIANGLE_6PLANES][i] = Code(XNA::IntersectTriangle6Planes(a[0], a[1], a[2], p[0], p[1], p[2], p[3], p[4],
+                p[5]));
+            r[SPHERE_6PLANES][i] = Code(XNA::IntersectSphere6Planes(&spheres[0], p[0], p[1], p[2], p[3], p[4], p[5]));
+            r[BOX_6PLANES][i] = Code(XNA::IntersectAxisAlignedBox6Planes(&boxes[0], p[0], p[1], p[2], p[3], p[4],
+                p[5]));
+            r[ORIENTED_BOX_6PLANES][i] = Code(XNA::IntersectOrientedBox6Planes(&orientedBoxes[0], p[0], p[1], p[2],
+                p[3], p[4], p[5]));
+            r[FRUSTUM_6PLANES][i] = Code(XNA::IntersectFrustum6Planes(&frustums[0], p[0], p[1], p[2], p[3], p[4],
+                p[5]));
+
+            r[TRIANGLE_PLANE][i] = Code(XNA::IntersectTrianglePlane(a[0], a[1], a[2], plane));
+            r[SPHERE_PLANE][i] = Code(XNA::IntersectSpherePlane(&spheres[0], plane));
+            r[BOX_PLANE][i] = Code(XNA::IntersectAxisAlignedBoxPlane(&boxes[0], plane));
+            r[ORIENTED_BOX_PLANE][i] = Code(XNA::IntersectOrientedBoxPlane(&orientedBoxes[0], plane));
+            r[FRUSTUM_PLANE][i] = Code(XNA::IntersectFrustumPlane(&frustums[0], plane));
+        }
+        return r;
+    }
+
+    bool Close(float expected, float actual)
+    {
+        float scale = std::max(1.0f, std::max(std::fabs(expected), std::fabs(actual)));
+        return std::fabs(expected - actual) <= 1e-3f * scale;
+    }
+
+    // Cases where the portable routines and xnacollision disagree beyond rounding.
+    // A flipped return code is only an error past one case in a thousand, the
+    // inputs within rounding of a boundary. The orientation of the oriented box
+    // is the same rotation for q and -q.
+    uint32 CountXnaMismatches(const SingleResults& xna, const SingleResults& portable)
+    {
+        uint32 mismatches = 0;
+        for(uint32 f = 0; f < ROUTINE_COUNT; ++f)
+        {
+            uint32 flips = 0;
+            uint32 errors = 0;
+            for(size_t i = 0; i < xna[f].size(); ++i)
+            {
+                const Outcome& e = xna[f][i];
+                const Outcome& a = portable[f][i];
+                if(e.Code != a.Code || e.ValueCount != a.ValueCount)
+                {
+                    ++flips;
+                    continue;
+                }
+
+                float sign = 1.0f;
+                if(f == COMPUTE_ORIENTED_BOX && e.Values[9] * a.Values[9] < 0.0f)
+                    sign = -1.0f;
+
+                bool close = true;
+                for(uint32 k = 0; k < e.ValueCount; ++k)
+                    close &= Close(e.Values[k], k >= 6 ? sign * a.Values[k] : a.Values[k]);
+
+                if(!close)
+                {
+                    if(errors < 3)
+                        printf("  %s: case %u, values differ from xnacollision\n", RoutineNames[f], (uint32)i);
+                    ++errors;
+                }
+            }
+
+            if(flips)
+                printf("  %s: %u of %u cases flipped against xnacollision\n", RoutineNames[f], flips,
+                    (uint32)xna[f].size());
+            if(flips * 1000 > xna[f].size())
+                mismatches += flips;
+            mismatches += errors;
+        }
+        return mismatches;
+    }
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+    uint32 count = 100000;
+    uint32 frustums = 7;
+    uint32 cases = 20000;
+    uint32 seed = 1;
+    uint32 runs = 5;
+
+    for(int a = 1; a < argc; ++a)
+    {
+        if(!strcmp(argv[a], "-count") && a + 1 < argc)
+            count = std::max(1u, (uint32)strtoul(argv[++a], nullptr, 10));
+        else if(!strcmp(argv[a], "-frustums") && a + 1 < argc)
+            frustums = std::min(XNA::MULTI_FRUSTUM_MAX, std::max(1u, (uint32)strtoul(argv[++a], nullptr, 10)));
+        else if(!strcmp(argv[a], "-cases") && a + 1 < argc)
+            cases = std::max(1u, (uint32)strtoul(argv[++a], nullptr, 10));
+        else if(!strcmp(argv[a], "-seed") && a + 1 < argc)
+            seed = (uint32)strtoul(argv[++a], nullptr, 10);
+        else if(!strcmp(argv[a], "-runs") && a + 1 < argc)
+            runs = std::max(1u, (uint32)strtoul(argv[++a], nullptr, 10));
+        else
+        {
+            printf("Usage: CollisionBatchTest [-count n] [-frustums n] [-cases n] [-seed n] [-runs n]\n");
+            return 1;
+        }
+    }
+
+    std::mt19937 rng(seed);
+    std::vector<float> planes = RandomPlanes(rng, frustums);
+    Volumes volumes = RandomVolumes(rng, count, planes);
+    XNA::AxisAlignedBoxStream boxes = volumes.Boxes();
+    XNA::SphereStream spheres = volumes.Spheres();
+
+    XNA::PlaneSet6 planeSet;
+    XNA::LoadPlaneSet6(&planeSet, &planes[0]);
+
+    XNA::MultiFrustumPlanes multi;
+    XNA::LoadMultiFrustumPlanes(&multi, &planes[0], frustums);
+
+    // Reference results, scalar backend.
+    XNA::SetSimdBackend(XNA::SIMD_BACKEND_SCALAR);
+    std::vector<uint8> refBoxes(count), refSpheres(count);
+    std::vector<uint32> refBoxMasks(count), refSphereMasks(count);
+    XNA::IntersectAxisAlignedBoxStream6Planes(&boxes, count, &planeSet, &refBoxes[0]);
+    XNA::IntersectSphereStream6Planes(&spheres, count, &planeSet, &refSpheres[0]);
+    XNA::CullAxisAlignedBoxStreamMultiFrustum(&boxes, count, &multi, &refBoxMasks[0]);
+    XNA::CullSphereStreamMultiFrustum(&spheres, count, &multi, &refSphereMasks[0]);
+
+    std::vector<SingleCase> singleCases = RandomCases(rng, cases);
+    SingleResults refSingles = EvaluatePortable(singleCases);
+
+    printf("%u volumes, %u frustums, %u single volume cases, seed %u\n", count, frustums, cases, seed);
+
+    uint32 mismatches = 0;
+
+    // The multi frustum masks must agree with the 6 planes test of each frustum.
+    for(uint32 f = 0; f < frustums; ++f)
+    {
+        XNA::PlaneSet6 single;
+        XNA::LoadPlaneSet6(&single, &planes[f * 6 * 4]);
+
+        std::vector<uint8> b(count), s(count);
+        XNA::IntersectAxisAlignedBoxStream6Planes(&boxes, count, &single, &b[0]);
+        XNA::IntersectSphereStream6Planes(&spheres, count, &single, &s[0]);
+
+        std::vector<uint8> fromMaskB(count), fromMaskS(count), visibleB(count), visibleS(count);
+        for(uint32 i = 0; i < count; ++i)
+        {
+            fromMaskB[i] = (refBoxMasks[i] >> f) & 1;
+            fromMaskS[i] = (refSphereMasks[i] >> f) & 1;
+            visibleB[i] = b[i] != 0;
+            visibleS[i] = s[i] != 0;
+        }
+        mismatches += CountMismatches("box multi frustum vs 6 planes", visibleB, fromMaskB);
+        mismatches += CountMismatches("sphere multi frustum vs 6 planes", visibleS, fromMaskS);
+
+#if defined(_WIN32)
+        std::vector<uint8> xnaB(count), xnaS(count);
+        XnaResults(volumes, planes, f, &xnaB, &xnaS);
+        mismatches += CountMismatches("IntersectAxisAlignedBox6Planes", xnaB, b);
+        mismatches += CountMismatches("IntersectSphere6Planes", xnaS, s);
+#endif
+    }
+
+#if defined(_WIN32)
+    mismatches += CountXnaMismatches(EvaluateXna(singleCases), refSingles);
+#endif
+
+    for(int backend = XNA::SIMD_BACKEND_SCALAR; backend < XNA::SIMD_BACKEND_COUNT; ++backend)
+    {
+        const char* name = XNA::GetSimdBackendName((XNA::SimdBackend)backend);
+        if(!XNA::IsSimdBackendSupported((XNA::SimdBackend)backend))
+        {
+            printf("%-8s not supported by this CPU\n", name);
+            continue;
+        }
+        XNA::SetSimdBackend((XNA::SimdBackend)backend);
+
+        std::vector<uint8> b(count), s(count);
+        std::vector<uint32> bm(count), sm(count);
+
+        double boxRate = Throughput(count, runs, [&]() {
+            XNA::IntersectAxisAlignedBoxStream6Planes(&boxes, count, &planeSet, &b[0]); });
+        double sphereRate = Throughput(count, runs, [&]() {
+            XNA::IntersectSphereStream6Planes(&spheres, count, &planeSet, &s[0]); });
+        double boxMultiRate = Throughput(count, runs, [&]() {
+            XNA::CullAxisAlignedBoxStreamMultiFrustum(&boxes, count, &multi, &bm[0]); });
+        double sphereMultiRate = Throughput(count, runs, [&]() {
+            XNA::CullSphereStreamMultiFrustum(&spheres, count, &multi, &sm[0]); });
+
+        SingleResults singles;
+        double singleRate = Throughput(cases * ROUTINE_COUNT, runs, [&]() {
+            singles = EvaluatePortable(singleCases); });
+
+        uint32 backendMismatches = CountMismatches("IntersectAxisAlignedBoxStream6Planes", refBoxes, b)
+            + CountMismatches("IntersectSphereStream6Planes", refSpheres, s)
+            + CountMismatches("CullAxisAlignedBoxStreamMultiFrustum", refBoxMasks, bm)
+            + CountMismatches("CullSphereStreamMultiFrustum", refSphereMasks, sm)
+            + CountSingleMismatches(refSingles, singles);
+        mismatches += backendMismatches;
+
+        printf("%-8s %s   Mvolumes/s: box %7.1f  sphere %7.1f  box multi %6.1f  sphere multi %6.1f"
+            "  single tests %5.1f\n", name, backendMismatches ? "MISMATCH" : "same    ", boxRate, sphereRate,
+            boxMultiRate, sphereMultiRate, singleRate);
+    }
+
+    if(mismatches)
+        printf("error: %u mismatches\n", mismatches);
+    else
+        printf("all the backends agree\n");
+
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,823 @@
+//---------------------------------------------------------------------------------------
+//
+// Headless culling benchmark
+//
+// Runs the instance culling of the InstancingFrustumCulling demo without window or
+// device: the instances are spread in a grid, at random or in clusters, a camera
+// flies a scripted path through them and the time of each Cull call is recorded.
+// Every method sees the same scene and the same camera, the frustum methods must
+// agree on the visible counts.
+//
+// The plain method is the test the demo had before the cached world boxes and the
+// coherent plane tests: the camera frustum is moved into the local space of each
+// instance and XNA::IntersectAxisAlignedBoxFrustum tests it against the mesh box.
+// It tests the tighter local box, so it may find a few less instances in the frustum.
+//
+// With occlusion, the table gives the instances rejected by the occlusion buffer on
+// top of the frustum and the part of the Cull time spent rasterizing the occluders.
+// "conservative" runs the occlusion buffer in its conservative mode.
+//
+// With -moving f, a fraction f of the instances turns and bobs every frame. The
+// InstanceCuller methods call SetWorld and Update for them before culling, the
+// plain method only needs SetWorld as it reads the world matrices directly. The
+// update time is included in the frame time and also given on its own.
+//
+// -count takes a list: -count 125,1000,8000 runs the three scenes in turn with the
+// same options.
+//
+// -encode benchmarks the compact instance format of the demo instead of the
+// culling: count random placements are encoded on one thread and over the pool,
+// then decoded, and the largest rotation, scale, position and color errors are
+// checked against what the 16 bit quaternion and the 8 bit color allow.
+//
+// Usage: CullingBenchmark [-count n[,n...]] [-distribution grid|random|clustered]
+//                         [-frames n] [-method none|linear|octree|plain|all]
+//                         [-occlusion on|off|conservative|both|all] [-threads n] [-seed n]
+//                         [-mesh file] [-moving f] [-perframe] [-encode]
+//
+//---------------------------------------------------------------------------------------
+
+#include "instanceCuller.h"
+#include "instanceFormat.h"
+#include "mathHelper.h"
+#include "textMeshReader.h"
+#include "threadPool.h"
+#include "timer.h"
+#include "types.h"
+#include "xnacollision.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    enum Distribution
+    {
+        DISTRIBUTION_GRID = 0,
+        DISTRIBUTION_RANDOM,
+        DISTRIBUTION_CLUSTERED
+    };
+
+    struct Options
+    {
+        std::vector<uint32> Counts;     // Scenes to run, one after the other.
+        uint32 Count;                   // Instances of the current scene.
+        Distribution Layout;
+        uint32 Frames;
+        int32 Method;           // FrustumMethod, METHOD_PLAIN, or -1 for all of them.
+        uint32 OcclusionModes;  // One bit per OcclusionMode to run.
+        uint32 Threads;         // 0 means one per hardware thread.
+        uint32 Seed;
+        std::string MeshFile;   // Empty for the skull of the demo.
+        float Moving;           // Fraction of the instances moved every frame.
+        bool PerFrame;
+        bool Encode;            // Benchmark the compact instance format instead.
+    };
+
+    struct Mesh
+    {
+        XNA::AxisAlignedBox Box;
+        std::vector<XMFLOAT3> Positions;
+        std::vector<uint32> Indices;
+    };
+
+    enum OcclusionMode
+    {
+        OCCLUSION_OFF = 0,
+        OCCLUSION_ON,
+        OCCLUSION_CONSERVATIVE
+    };
+
+    // After the InstanceCuller methods, run by the benchmark itself.
+    const int32 METHOD_PLAIN = InstanceCuller::FRUSTUM_OCTREE + 1;
+
+    // Instances per culling task, as in InstanceCuller.
+    const uint32 CullChunkSize = 256;
+
+    // Same spacing as the demo (5x5x5 skulls in a 200 units cube), the scene
+    // grows with the instance count.
+    const float InstanceSpacing = 40.0f;
+
+    // Small deterministic generator so every run (and every platform) places
+    // the instances at the same positions.
+    class Random
+    {
+    public:
+        explicit Random(uint32 seed) : m_state(seed ? seed : 1) {}
+
+        uint32 Next()
+        {
+            m_state ^= m_state << 13;
+            m_state ^= m_state >> 17;
+            m_state ^= m_state << 5;
+            return m_state;
+        }
+
+        // In [a, b].
+        float Range(float a, float b)
+        {
+            return a + (b - a) * (Next() & 0xffffff) / (float)0xffffff;
+        }
+
+    private:
+        uint32 m_state;
+    };
+
+    void PrintUsage()
+    {
+        printf("Usage: CullingBenchmark [-count n[,n...]] [-distribution grid|random|clustered]\n"
+               "                        [-frames n] [-method none|linear|octree|plain|all]\n"
+               "                        [-occlusion on|off|conservative|both|all] [-threads n] [-seed n]\n"
+               "                        [-mesh file] [-moving f] [-perframe] [-encode]\n");
+    }
+
+    bool ParseOptions(int argc, char* argv[], Options* pOptions)
+    {
+        pOptions->Counts.assign(1, 100000);
+        pOptions->Layout = DISTRIBUTION_RANDOM;
+        pOptions->Frames = 600;
+        pOptions->Method = -1;
+        pOptions->OcclusionModes = 1 << OCCLUSION_OFF;
+        pOptions->Threads = 0;
+        pOptions->Seed = 1;
+        pOptions->Moving = 0.0f;
+        pOptions->PerFrame = false;
+        pOptions->Encode = false;
+
+        for(int a = 1; a < argc; ++a)
+        {
+            std::string arg = argv[a];
+            const char* value = (a + 1 < argc) ? argv[a + 1] : nullptr;
+
+            if(arg == "-perframe")
+            {
+                pOptions->PerFrame = true;
+                continue;
+            }
+            if(arg == "-encode")
+            {
+                pOptions->Encode = true;
+                continue;
+            }
+
+            if(!value)
+                return false;
+            ++a;
+
+            if(arg == "-count")
+            {
+                // Comma separated list.
+                pOptions->Counts.clear();
+                for(const char* p = value; ; ++p)
+                {
+                    char* end = nullptr;
+                    pOptions->Counts.push_back((uint32)strtoul(p, &end, 10));
+                    p = end;
+                    if(*p != ',')
+                        break;
+                }
+            }
+            else if(arg == "-frames")
+                pOptions->Frames = (uint32)strtoul(value, nullptr, 10);
+            else if(arg == "-threads")
+                pOptions->Threads = (uint32)strtoul(value, nullptr, 10);
+            else if(arg == "-seed")
+                pOptions->Seed = (uint32)strtoul(value, nullptr, 10);
+            else if(arg == "-mesh")
+                pOptions->MeshFile = value;
+            else if(arg == "-moving")
+                pOptions->Moving = std::min(std::max((float)atof(value), 0.0f), 1.0f);
+            else if(arg == "-distribution")
+            {
+                if(!strcmp(value, "grid"))
+                    pOptions->Layout = DISTRIBUTION_GRID;
+                else if(!strcmp(value, "random"))
+                    pOptions->Layout = DISTRIBUTION_RANDOM;
+                else if(!strcmp(value, "clustered"))
+                    pOptions->Layout = DISTRIBUTION_CLUSTERED;
+                else
+                    return false;
+            }
+            else if(arg == "-method")
+            {
+                if(!strcmp(value, "none"))
+                    pOptions->Method = InstanceCuller::FRUSTUM_NONE;
+                else if(!strcmp(value, "linear"))
+                    pOptions->Method = InstanceCuller::FRUSTUM_LINEAR;
+                else if(!strcmp(value, "octree"))
+                    pOptions->Method = InstanceCuller::FRUSTUM_OCTREE;
+                else if(!strcmp(value, "plain"))
+                    pOptions->Method = METHOD_PLAIN;
+                else if(!strcmp(value, "all"))
+                    pOptions->Method = -1;
+                else
+                    return false;
+            }
+            else if(arg == "-occlusion")
+            {
+                if(!strcmp(value, "on"))
+                    pOptions->OcclusionModes = 1 << OCCLUSION_ON;
+                else if(!strcmp(value, "off"))
+                    pOptions->OcclusionModes = 1 << OCCLUSION_OFF;
+                else if(!strcmp(value, "conservative"))
+                    pOptions->OcclusionModes = 1 << OCCLUSION_CONSERVATIVE;
+                else if(!strcmp(value, "both"))
+                    pOptions->OcclusionModes = (1 << OCCLUSION_OFF) | (1 << OCCLUSION_ON);
+                else if(!strcmp(value, "all"))
+                    pOptions->OcclusionModes = (1 << OCCLUSION_OFF) | (1 << OCCLUSION_ON) | (1 << OCCLUSION_CONSERVATIVE);
+                else
+                    return false;
+            }
+            else
+                return false;
+        }
+
+        for(size_t c = 0; c < pOptions->Counts.size(); ++c)
+        {
+            if(pOptions->Counts[c] == 0)
+                return false;
+        }
+        return pOptions->Frames > 0;
+    }
+
+    // The skull of the demo, looked for from the project directory (the default
+    // working directory of the debugger), from the d3d directory and from the
+    // directories in between, so the benchmark runs from any of them.
+    const char* const DefaultMeshFiles[] =
+    {
+        "../../topics/InstancingFrustumCulling/Models/skull.txt",
+        "../topics/InstancingFrustumCulling/Models/skull.txt",
+        "topics/InstancingFrustumCulling/Models/skull.txt",
+        "d3d/topics/InstancingFrustumCulling/Models/skull.txt",
+    };
+
+    // Read a model in the text format of the demos. Returns false if the file can
+    // not be read, the caller then falls back to a box.
+    bool LoadMesh(const char* fileName, ThreadPool* pPool, Mesh* pMesh)
+    {
+        TextMeshReader reader;
+        if(!reader.Open(fileName) || reader.VertexCount() == 0)
+            return false;
+
+        std::vector<XMFLOAT3> normals(reader.VertexCount());
+        pMesh->Positions.resize(reader.VertexCount());
+        pMesh->Indices.resize(3 * reader.TriangleCount());
+        return reader.Read(&pMesh->Positions[0], &normals[0], sizeof(XMFLOAT3), &pMesh->Indices[0],
+            &pMesh->Box, pPool);
+    }
+
+    // Closed box about the size of the skull.
+    void BuildBoxMesh(Mesh* pMesh)
+    {
+        const float h = 5.0f;
+        const XMFLOAT3 corners[8] =
+        {
+            XMFLOAT3(-h, -h, -h), XMFLOAT3(-h, +h, -h), XMFLOAT3(+h, +h, -h), XMFLOAT3(+h, -h, -h),
+            XMFLOAT3(-h, -h, +h), XMFLOAT3(-h, +h, +h), XMFLOAT3(+h, +h, +h), XMFLOAT3(+h, -h, +h)
+        };
+        const uint32 indices[36] =
+        {
+            0, 1, 2,  0, 2, 3,      // front
+            4, 6, 5,  4, 7, 6,      // back
+            4, 5, 1,  4, 1, 0,      // left
+            3, 2, 6,  3, 6, 7,      // right
+            1, 5, 6,  1, 6, 2,      // top
+            4, 0, 3,  4, 3, 7       // bottom
+        };
+
+        pMesh->Positions.assign(corners, corners + 8);
+        pMesh->Indices.assign(indices, indices + 36);
+        pMesh->Box.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        pMesh->Box.Extents = XMFLOAT3(h, h, h);
+    }
+
+    void BuildScene(const Options& options, const Mesh& mesh, float halfSize, InstanceCuller* pCuller)
+    {
+        Random random(options.Seed);
+
+        pCuller->SetMesh(mesh.Box, &mesh.Positions[0], (uint32)mesh.Positions.size(),
+            &mesh.Indices[0], (uint32)mesh.Indices.size() / 3);
+
+        // Cluster centers, a thousand instances each.
+        std::vector<XMFLOAT3> clusters;
+        if(options.Layout == DISTRIBUTION_CLUSTERED)
+        {
+            uint32 clusterCount = std::max(1u, options.Count / 1000);
+            for(uint32 c = 0; c < clusterCount; ++c)
+            {
+                clusters.push_back(XMFLOAT3(random.Range(-0.8f * halfSize, 0.8f * halfSize),
+                    random.Range(-0.8f * halfSize, 0.8f * halfSize), random.Range(-0.8f * halfSize, 0.8f * halfSize)));
+            }
+        }
+
+        uint32 n = (uint32)ceil(pow((double)options.Count, 1.0 / 3.0));
+        float clusterRadius = 0.1f * halfSize;
+
+        for(uint32 i = 0; i < options.Count; ++i)
+        {
+            XMFLOAT3 p;
+            switch(options.Layout)
+            {
+            case DISTRIBUTION_GRID:
+                p.x = -halfSize + (i % n) * InstanceSpacing;
+                p.y = -halfSize + ((i / n) % n) * InstanceSpacing;
+                p.z = -halfSize + (i / (n * n)) * InstanceSpacing;
+                break;
+
+            case DISTRIBUTION_RANDOM:
+                p.x = random.Range(-halfSize, halfSize);
+                p.y = random.Range(-halfSize, halfSize);
+                p.z = random.Range(-halfSize, halfSize);
+                break;
+
+            default:
+                {
+                    // Sum of uniforms, denser at the cluster center.
+                    const XMFLOAT3& c = clusters[random.Next() % clusters.size()];
+                    p.x = c.x + clusterRadius * (random.Range(-1.0f, 1.0f) + random.Range(-1.0f, 1.0f));
+                    p.y = c.y + clusterRadius * (random.Range(-1.0f, 1.0f) + random.Range(-1.0f, 1.0f));
+                    p.z = c.z + clusterRadius * (random.Range(-1.0f, 1.0f) + random.Range(-1.0f, 1.0f));
+                }
+                break;
+            }
+
+            // The grid keeps the demo orientation, the other layouts turn the
+            // instances so their world boxes are not just translated.
+            XMMATRIX rotation = XMMatrixIdentity();
+            if(options.Layout != DISTRIBUTION_GRID)
+                rotation = XMMatrixRotationY(random.Range(0.0f, XM_2PI));
+
+            pCuller->AddInstance(XMMatrixMultiply(rotation, XMMatrixTranslation(p.x, p.y, p.z)));
+        }
+
+        XNA::AxisAlignedBox sceneBox;
+        sceneBox.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        sceneBox.Extents = XMFLOAT3(halfSize + 10.0f, halfSize + 10.0f, halfSize + 10.0f);
+        pCuller->Build(sceneBox);
+    }
+
+    // Camera of the given frame: it orbits the scene, closing in and pulling
+    // out twice per lap, so it looks over the whole scene, through it and at
+    // the empty space around it.
+    void CameraMatrices(uint32 frame, uint32 frameCount, float halfSize, XMMATRIX* pView, XMMATRIX* pProj,
+        XMVECTOR* pEyePos)
+    {
+        float t = (float)frame / frameCount;
+        float angle = XM_2PI * t;
+        float radius = halfSize * (0.2f + 1.3f * fabs(cosf(XM_2PI * t)));
+
+        XMVECTOR eye = XMVectorSet(radius * cosf(angle), 0.3f * halfSize * sinf(2.0f * angle), radius * sinf(angle), 1.0f);
+        XMVECTOR target = XMVectorSet(0.5f * halfSize * cosf(3.0f * angle), 0.0f, 0.5f * halfSize * sinf(2.0f * angle), 1.0f);
+        XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+
+        *pView = XMMatrixLookAtLH(eye, target, up);
+        *pProj = XMMatrixPerspectiveFovLH(0.25f * MathHelper::Pi, 16.0f / 9.0f, 1.0f, 4.0f * halfSize);
+        *pEyePos = eye;
+    }
+
+    // The plain method: the view space frustum is transformed into the local space
+    // of every instance, nothing is cached from frame to frame. Returns the number
+    // of instances in the frustum, their indices are in pVisible.
+    uint32 CullPlain(const InstanceStore& instances, const XNA::Frustum& viewFrustum, CXMMATRIX view,
+        ThreadPool& pool, std::vector<uint8>* pFlags, std::vector<uint32>* pVisible)
+    {
+        XMVECTOR detView = XMMatrixDeterminant(view);
+        XMMATRIX invView = XMMatrixInverse(&detView, view);
+
+        uint32 count = instances.Count();
+        pFlags->resize(count);
+        pVisible->resize(count);
+
+        uint32 visible = pool.ParallelCompact(count, CullChunkSize,
+            [&](uint32, uint32 begin, uint32 end) -> uint32
+            {
+                uint32 kept = 0;
+                for(uint32 i = begin; i < end; ++i)
+                {
+                    XMMATRIX W = XMLoadFloat4x4(&instances.World(i));
+                    XMVECTOR detWorld = XMMatrixDeterminant(W);
+                    XMMATRIX toLocal = XMMatrixMultiply(invView, XMMatrixInverse(&detWorld, W));
+
+                    XMVECTOR scale;
+                    XMVECTOR rotQuat;
+                    XMVECTOR translation;
+                    XMMatrixDecompose(&scale, &rotQuat, &translation, toLocal);
+
+                    XNA::Frustum localFrustum;
+                    XNA::TransformFrustum(&localFrustum, &viewFrustum, XMVectorGetX(scale), rotQuat, translation);
+
+                    (*pFlags)[i] = XNA::IntersectAxisAlignedBoxFrustum(&instances.LocalBox(), &localFrustum) != 0;
+                    kept += (*pFlags)[i];
+                }
+                return kept;
+            },
+            [&](uint32, uint32 begin, uint32 end, uint32 slot)
+            {
+                for(uint32 i = begin; i < end; ++i)
+                {
+                    if((*pFlags)[i])
+                        (*pVisible)[slot++] = i;
+                }
+            });
+
+        pVisible->resize(visible);
+        return visible;
+    }
+
+    // Move the instances of the frame: a window of moveCount instances sliding
+    // along the list, each one turned and lifted from its initial placement by
+    // amounts that only depend on the frame, so every method sees the same scene.
+    void MoveInstances(uint32 frame, uint32 moveCount, const std::vector<XMFLOAT4X4>& initialWorlds,
+        InstanceCuller* pCuller)
+    {
+        uint32 count = (uint32)initialWorlds.size();
+        uint32 first = (uint32)(((uint64)frame * moveCount) % count);
+
+        XMMATRIX motion = XMMatrixMultiply(XMMatrixRotationY(0.05f * frame),
+            XMMatrixTranslation(0.0f, 0.25f * InstanceSpacing * sinf(0.1f * frame), 0.0f));
+
+        for(uint32 m = 0; m < moveCount; ++m)
+        {
+            uint32 i = (first + m) % count;
+            XMMATRIX initial = XMLoadFloat4x4(&initialWorlds[i]);
+
+            // Turn in place, then lift.
+            XMMATRIX world = initial;
+            world.r[3] = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+            world = XMMatrixMultiply(world, motion);
+            world.r[3] = initial.r[3] + XMVectorSet(0.0f, XMVectorGetY(motion.r[3]), 0.0f, 0.0f);
+
+            pCuller->SetWorld(i, world);
+        }
+    }
+
+    float Percentile(const std::vector<float>& sorted, float p)
+    {
+        size_t i = (size_t)(p * (sorted.size() - 1) + 0.5f);
+        return sorted[std::min(i, sorted.size() - 1)];
+    }
+
+    const char* OcclusionName(int32 occlusion)
+    {
+        switch(occlusion)
+        {
+        case OCCLUSION_OFF:     return "off";
+        case OCCLUSION_ON:      return "on";
+        default:                return "conserv.";
+        }
+    }
+
+    const char* MethodName(int32 method)
+    {
+        switch(method)
+        {
+        case InstanceCuller::FRUSTUM_NONE:      return "none";
+        case InstanceCuller::FRUSTUM_LINEAR:    return "linear";
+        case InstanceCuller::FRUSTUM_OCTREE:    return "octree";
+        default:                                return "plain";
+        }
+    }
+    // Build the scene of options.Count instances and run the methods over the
+    // camera path. False if the frustum methods disagree.
+    bool RunScene(const Options& options, const Mesh& mesh, ThreadPool& pool)
+    {
+        float halfSize = 0.5f * InstanceSpacing * ceilf(powf((float)options.Count, 1.0f / 3.0f));
+
+        InstanceCuller culler;
+        BuildScene(options, mesh, halfSize, &culler);
+
+        uint32 moveCount = (uint32)(options.Moving * options.Count);
+        std::vector<XMFLOAT4X4> initialWorlds;
+        for(uint32 i = 0; moveCount && i < culler.Instances().Count(); ++i)
+            initialWorlds.push_back(culler.Instances().World(i));
+
+        static const char* distributionNames[] = { "grid", "random", "clustered" };
+        printf("%u instances (%s), %u frames, %u worker threads, %u triangles per occluder\n",
+            options.Count, distributionNames[options.Layout], options.Frames, pool.ThreadCount(),
+            (uint32)mesh.Indices.size() / 3);
+        if(moveCount)
+            printf("%u instances moving per frame\n", moveCount);
+        printf("%-8s %-9s %9s %9s %9s %9s %11s %11s %11s %11s %9s %9s\n",
+            "method", "occlusion", "p50 ms", "p90 ms", "p99 ms", "max ms", "in frustum", "occluded", "visible", "tested",
+            "update ms", "raster ms");
+
+        // Frustum visible count of each frame for the first method, the others
+        // must find the same.
+        std::vector<uint32> reference;
+
+        // The projection does not change along the path.
+        XNA::Frustum viewFrustum;
+        {
+            XMMATRIX view;
+            XMMATRIX proj;
+            XMVECTOR eyePos;
+            CameraMatrices(0, options.Frames, halfSize, &view, &proj, &eyePos);
+            XNA::ComputeFrustumFromProjection(&viewFrustum, &proj);
+        }
+        std::vector<uint8> plainFlags;
+        std::vector<uint32> plainVisible;
+
+        bool agree = true;
+
+        Timer timer;
+        timer.Reset();
+
+        for(int32 method = InstanceCuller::FRUSTUM_NONE; method <= METHOD_PLAIN; ++method)
+        {
+            if(options.Method >= 0 && method != options.Method)
+                continue;
+
+            for(int32 occlusion = OCCLUSION_OFF; occlusion <= OCCLUSION_CONSERVATIVE; ++occlusion)
+            {
+                if(!(options.OcclusionModes & (1 << occlusion)))
+                    continue;
+
+                // Nothing to occlude when every instance is drawn, and the plain
+                // method only tests the frustum.
+                if((method == InstanceCuller::FRUSTUM_NONE || method == METHOD_PLAIN) && occlusion != OCCLUSION_OFF)
+                    continue;
+
+                culler.SetConservativeOcclusion(occlusion == OCCLUSION_CONSERVATIVE);
+
+                // Every run starts from the initial placement.
+                for(uint32 i = 0; i < (uint32)initialWorlds.size(); ++i)
+                    culler.SetWorld(i, XMLoadFloat4x4(&initialWorlds[i]));
+                culler.Update();
+
+                std::vector<float> times(options.Frames);
+                std::vector<float> updateTimes(options.Frames);
+                std::vector<float> rasterizeTimes(options.Frames);
+                uint64 frustumVisible = 0;
+                uint64 occluded = 0;
+                uint64 visible = 0;
+                uint64 tested = 0;
+                uint32 mismatches = 0;
+
+                for(uint32 frame = 0; frame < options.Frames; ++frame)
+                {
+                    XMMATRIX view;
+                    XMMATRIX proj;
+                    XMVECTOR eyePos;
+                    CameraMatrices(frame, options.Frames, halfSize, &view, &proj, &eyePos);
+                    XMMATRIX viewProj = XMMatrixMultiply(view, proj);
+
+                    InstanceCuller::Stats stats;
+                    timer.Tick();
+                    if(moveCount)
+                    {
+                        MoveInstances(frame, moveCount, initialWorlds, &culler);
+                        if(method != METHOD_PLAIN)
+                            culler.Update();
+
+                        timer.Tick();
+                        updateTimes[frame] = timer.DeltaTime() * 1000.0f;
+                    }
+
+                    if(method == METHOD_PLAIN)
+                    {
+                        memset(&stats, 0, sizeof(stats));
+                        stats.InstanceCount = culler.Instances().Count();
+                        stats.FrustumVisible = CullPlain(culler.Instances(), viewFrustum, view, pool, &plainFlags,
+                            &plainVisible);
+                        stats.Visible = stats.FrustumVisible;
+                        stats.TestedBoxes = stats.InstanceCount;
+                    }
+                    else
+                    {
+                        culler.Cull(viewProj, eyePos, (InstanceCuller::FrustumMethod)method, occlusion != OCCLUSION_OFF,
+                            &pool);
+                        stats = culler.LastStats();
+                    }
+                    timer.Tick();
+
+                    times[frame] = updateTimes[frame] + timer.DeltaTime() * 1000.0f;
+                    rasterizeTimes[frame] = stats.RasterizeTime * 1000.0f;
+                    frustumVisible += stats.FrustumVisible;
+                    occluded += stats.Occluded;
+                    visible += stats.Visible;
+                    tested += stats.TestedNodes + stats.TestedBoxes;
+
+                    // The plain method tests the local boxes, not the world boxes.
+                    if(method != InstanceCuller::FRUSTUM_NONE && method != METHOD_PLAIN)
+                    {
+                        if(reference.size() < options.Frames)
+                            reference.push_back(stats.FrustumVisible);
+                        else if(reference[frame] != stats.FrustumVisible)
+                            ++mismatches;
+                    }
+
+                    if(options.PerFrame)
+                    {
+                        printf("  %s %s frame %u: %.3f ms (%.3f ms updating, %.3f ms rasterizing), %u in frustum, "
+                            "%u occluded, %u visible\n",
+                            MethodName(method), OcclusionName(occlusion), frame, times[frame], updateTimes[frame],
+                            rasterizeTimes[frame],
+                            stats.FrustumVisible, stats.Occluded, stats.Visible);
+                    }
+                }
+
+                std::sort(times.begin(), times.end());
+                std::sort(updateTimes.begin(), updateTimes.end());
+                std::sort(rasterizeTimes.begin(), rasterizeTimes.end());
+                printf("%-8s %-9s %9.3f %9.3f %9.3f %9.3f %11u %11u %11u %11u %9.3f %9.3f\n",
+                    MethodName(method), OcclusionName(occlusion),
+                    Percentile(times, 0.5f), Percentile(times, 0.9f), Percentile(times, 0.99f), times.back(),
+                    (uint32)(frustumVisible / options.Frames), (uint32)(occluded / options.Frames),
+                    (uint32)(visible / options.Frames), (uint32)(tested / options.Frames),
+                    Percentile(updateTimes, 0.5f), Percentile(rasterizeTimes, 0.5f));
+
+                if(mismatches)
+                {
+                    printf("  error: %u frames differ from the first frustum method\n", mismatches);
+                    agree = false;
+                }
+            }
+        }
+
+        return agree;
+    }
+
+    // Largest errors of a compact instance round trip.
+    struct EncodeErrors
+    {
+        float Rotation;     // Degrees.
+        float Scale;        // Relative.
+        float Position;     // Absolute.
+        float Color;        // In 8 bit steps.
+    };
+
+    // Rotation angle between two unit quaternions. From the length of their
+    // difference rather than the acos of their dot product, which is 1 in float
+    // for the small angles measured here.
+    float QuaternionAngle(FXMVECTOR q0, FXMVECTOR q1)
+    {
+        XMVECTOR q = XMVectorGetX(XMQuaternionDot(q0, q1)) < 0.0f ? XMVectorNegate(q1) : q1;
+        float half = 0.5f * XMVectorGetX(XMVector4Length(q0 - q));
+        return 4.0f * asinf(std::min(half, 1.0f));
+    }
+
+    void MeasureEncodeErrors(const std::vector<XMFLOAT4X4>& worlds, const std::vector<XMFLOAT4>& colors,
+        const std::vector<CompactInstanceData>& encoded, EncodeErrors* pErrors)
+    {
+        memset(pErrors, 0, sizeof(*pErrors));
+
+        for(size_t i = 0; i < worlds.size(); ++i)
+        {
+            XMMATRIX world = XMLoadFloat4x4(&worlds[i]);
+            XMMATRIX decoded = DecodeCompactInstanceWorld(encoded[i]);
+
+            float scale = XMVectorGetX(XMVector3Length(world.r[0]));
+            float decodedScale = XMVectorGetX(XMVector3Length(decoded.r[0]));
+
+            XMMATRIX rotation = world;
+            rotation.r[0] /= scale;
+            rotation.r[1] /= scale;
+            rotation.r[2] /= scale;
+            rotation.r[3] = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+            XMVECTOR q = XMQuaternionNormalize(XMQuaternionRotationMatrix(rotation));
+            XMVECTOR decodedQ = XMQuaternionNormalize(XMLoadShortN4(&encoded[i].Rotation));
+
+            XMVECTOR color = XMLoadFloat4(&colors[i]);
+            XMVECTOR colorError = XMVectorAbs(DecodeCompactInstanceColor(encoded[i]) - color) * 255.0f;
+            XMVECTOR positionError = XMVectorAbs(decoded.r[3] - world.r[3]);
+
+            pErrors->Rotation = std::max(pErrors->Rotation, XMConvertToDegrees(QuaternionAngle(q, decodedQ)));
+            pErrors->Scale = std::max(pErrors->Scale, fabsf(decodedScale - scale) / scale);
+            pErrors->Position = std::max(pErrors->Position, std::max(XMVectorGetX(positionError),
+                std::max(XMVectorGetY(positionError), XMVectorGetZ(positionError))));
+            pErrors->Color = std::max(pErrors->Color, std::max(std::max(XMVectorGetX(colorError),
+                XMVectorGetY(colorError)), std::max(XMVectorGetZ(colorError), XMVectorGetW(colorError))));
+        }
+    }
+
+    // Encode options.Count random placements (any rotation, scale 0.1 to 10) on one
+    // thread and over the pool, best of a few runs each, then check the round trip.
+    // False if an error is larger than the quantization allows: a 16 bit quaternion
+    // component is off by at most half a step, 1.5e-5, so the rotation by well under
+    // 0.01 degree; the color by half an 8 bit step; scale and position are floats.
+    bool RunEncode(const Options& options, ThreadPool& pool)
+    {
+        const uint32 count = options.Count;
+        const uint32 runs = 5;
+
+        std::vector<XMFLOAT4X4> worlds(count);
+        std::vector<XMFLOAT4> colors(count);
+        Random random(options.Seed);
+        for(uint32 i = 0; i < count; ++i)
+        {
+            float scale = random.Range(0.1f, 10.0f);
+            XMMATRIX rotation = XMMatrixRotationRollPitchYaw(random.Range(-XM_PI, XM_PI),
+                random.Range(-XM_PI, XM_PI), random.Range(-XM_PI, XM_PI));
+            XMMATRIX translation = XMMatrixTranslation(random.Range(-1000.0f, 1000.0f),
+                random.Range(-1000.0f, 1000.0f), random.Range(-1000.0f, 1000.0f));
+
+            XMStoreFloat4x4(&worlds[i], XMMatrixScaling(scale, scale, scale) * rotation * translation);
+            colors[i] = XMFLOAT4(random.Range(0.0f, 1.0f), random.Range(0.0f, 1.0f),
+                random.Range(0.0f, 1.0f), random.Range(0.0f, 1.0f));
+        }
+
+        std::vector<CompactInstanceData> encoded(count);
+        std::vector<CompactInstanceData> parallelEncoded(count);
+
+        Timer timer;
+        timer.Reset();
+        float serialTime = MathHelper::Infinity;
+        float parallelTime = MathHelper::Infinity;
+        for(uint32 r = 0; r < runs; ++r)
+        {
+            timer.Tick();
+            EncodeCompactInstances(&encoded[0], &worlds[0], sizeof(XMFLOAT4X4), &colors[0], sizeof(XMFLOAT4), count);
+            timer.Tick();
+            serialTime = std::min(serialTime, timer.DeltaTime());
+
+            pool.ParallelFor(count, CullChunkSize, [&](uint32, uint32 begin, uint32 end)
+            {
+                EncodeCompactInstances(&parallelEncoded[begin], &worlds[begin], sizeof(XMFLOAT4X4), &colors[begin],
+                    sizeof(XMFLOAT4), end - begin);
+            });
+            timer.Tick();
+            parallelTime = std::min(parallelTime, timer.DeltaTime());
+        }
+
+        printf("%u instances encoded (%u bytes each instead of %u), best of %u runs\n", count,
+            (uint32)sizeof(CompactInstanceData), (uint32)(sizeof(XMFLOAT4X4) + sizeof(XMFLOAT4)), runs);
+        printf("  serial:        %9.3f ms, %8.2f M instances/s\n", serialTime * 1000.0f, count / serialTime * 1e-6f);
+        printf("  pool of %3u:   %9.3f ms, %8.2f M instances/s\n", pool.ThreadCount(), parallelTime * 1000.0f,
+            count / parallelTime * 1e-6f);
+
+        bool ok = true;
+        if(memcmp(&encoded[0], &parallelEncoded[0], count * sizeof(CompactInstanceData)))
+        {
+            printf("  error: the threaded encoding differs from the serial one\n");
+            ok = false;
+        }
+
+        EncodeErrors errors;
+        MeasureEncodeErrors(worlds, colors, encoded, &errors);
+        printf("  max error: rotation %.5f degrees, scale %.2g, position %.2g, color %.3f / 255\n",
+            errors.Rotation, errors.Scale, errors.Position, errors.Color);
+
+        if(errors.Rotation > 0.01f || errors.Scale > 1e-5f || errors.Position > 0.0f || errors.Color > 0.501f)
+        {
+            printf("  error: round trip error above the quantization bounds\n");
+            ok = false;
+        }
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if(!ParseOptions(argc, argv, &options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    ThreadPool pool(options.Threads);
+
+    if(options.Encode)
+    {
+        bool ok = true;
+        for(size_t c = 0; c < options.Counts.size(); ++c)
+        {
+            options.Count = options.Counts[c];
+            ok &= RunEncode(options, pool);
+        }
+        return ok ? 0 : 1;
+    }
+
+    Mesh mesh;
+    bool loaded = false;
+    if(!options.MeshFile.empty())
+        loaded = LoadMesh(options.MeshFile.c_str(), &pool, &mesh);
+    else
+    {
+        for(size_t f = 0; f < sizeof(DefaultMeshFiles) / sizeof(DefaultMeshFiles[0]) && !loaded; ++f)
+            loaded = LoadMesh(DefaultMeshFiles[f], &pool, &mesh);
+    }
+
+    if(!loaded)
+    {
+        printf("Can not read %s, using a box as instanced mesh.\n",
+            options.MeshFile.empty() ? DefaultMeshFiles[0] : options.MeshFile.c_str());
+        BuildBoxMesh(&mesh);
+    }
+
+    bool agree = true;
+    for(size_t c = 0; c < options.Counts.size(); ++c)
+    {
+        if(c > 0)
+            printf("\n");
+
+        options.Count = options.Counts[c];
+        agree &= RunScene(options, mesh, pool);
+    }
+
+    return agree ? 0 : 1;
+}
@@ -0,0 +1,726 @@
+//---------------------------------------------------------------------------------------
+//
+// Times the creation of a large effect and the lookups of its parts by name.
+//
+// The effect is generated: n float4 variables spread over constant buffers, and
+// techniques of two passes in the default group and in a named one. It is compiled
+// once, then created and cloned a number of times on a device without a window
+// (the NULL reference device, or WARP when it is not installed). Last, every
+// variable, constant buffer, technique ("group|technique" for the named group) and
+// pass is looked up by name; all must be found, each by its own name.
+//
+// Then the effects of the demos (Basic, Blur and TreeSprite by default, compiled
+// from their .fx or read from a .fxo) are created from memory, and through an
+// EffectCache: its first run loads the effect, the next ones are clones.
+//
+// Last, a pass of the generated effect is applied a number of times, a variable set
+// before each one, on deferred contexts: from the main thread alone, then split over
+// the thread pool, every chunk recording with its own EffectApplyContext on the one
+// effect, the variable set through the context. The command lists are executed in
+// order on the immediate context. Then straight on the immediate
+// context, where the buffers can be updated in part. -dynamic creates the generated
+// effect with D3DX11_EFFECT_DYNAMIC_CONSTANT_BUFFERS.
+//
+// The demo effects are also created side by side, as the effects of a scene, first
+// each with its own constant buffers, then with D3DX11_EFFECT_SHARED_CONSTANT_BUFFERS.
+// Their constant buffers, and the state objects of their state variables, are
+// counted per effect and per device object, with the bytes of the buffers.
+//
+// The recording is checked by replay: a thousand applies are recorded again, from the
+// main thread and over the pool, the constant buffer bound after each one copied to a
+// staging buffer in the same command list. Once executed, every copy must hold the
+// value set before its apply. The NULL reference device executes no copy, the check
+// is skipped on it.
+//
+// Usage: EffectLoadBenchmark [-variables n] [-cbuffers n] [-techniques n] [-runs n]
+//                            [-applies n] [-dynamic] [-fx file.fx|file.fxo]...
+//
+// The best and the median times of the runs are printed, and for the applies the
+// buffer uploads of a run (D3DX11GetEffectUploadStats), a run standing for a frame.
+//
+//---------------------------------------------------------------------------------------
+
+#include "comPtr.h"
+#include "effectApplyContext.h"
+#include "effectCache.h"
+#include "threadPool.h"
+#include "timer.h"
+#include "types.h"
+#include <d3d11.h>
+#include <d3dcompiler.h>
+#include <d3dx11.h>
+#include <d3dx11effect.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const char* NamedGroup = "Shadow";
+
+    std::string VariableName(uint32 i)
+    {
+        std::ostringstream name;
+        name << "gParam" << i;
+        return name.str();
+    }
+
+    std::string CBufferName(uint32 i)
+    {
+        std::ostringstream name;
+        name << "cbBlock" << i;
+        return name.str();
+    }
+
+    std::string TechniqueName(uint32 i)
+    {
+        std::ostringstream name;
+        name << "Technique" << i;
+        return name.str();
+    }
+
+    // Half the techniques in the default group, half in NamedGroup. The pixel
+    // shaders read a few variables, all of them are kept in the effect anyway.
+    std::string GenerateEffect(uint32 variables, uint32 cbuffers, uint32 techniques)
+    {
+        std::ostringstream fx;
+
+        uint32 perBuffer = (variables + cbuffers - 1) / cbuffers;
+        for(uint32 cb = 0, v = 0; cb < cbuffers && v < variables; ++cb)
+        {
+            fx << "cbuffer " << CBufferName(cb) << "\n{\n";
+            for(uint32 i = 0; i < perBuffer && v < variables; ++i, ++v)
+                fx << "    float4 " << VariableName(v) << ";\n";
+            fx << "};\n\n";
+        }
+
+        fx << "float4 VS(float3 pos : POSITION) : SV_POSITION\n{\n    return float4(pos, 1.0f);\n}\n\n";
+        fx << "float4 PS(uniform int i) : SV_Target\n{\n    return " << VariableName(0) << " * i + "
+           << VariableName(variables - 1) << ";\n}\n\n";
+
+        uint32 defaultTechniques = (techniques + 1) / 2;
+        for(uint32 t = 0; t < techniques; ++t)
+        {
+            if(t == defaultTechniques)
+                fx << "fxgroup " << NamedGroup << "\n{\n";
+
+            fx << "technique11 " << TechniqueName(t) << "\n{\n";
+            for(uint32 p = 0; p < 2; ++p)
+            {
+                fx << "    pass P" << p << "\n    {\n"
+                   << "        SetVertexShader(CompileShader(vs_5_0, VS()));\n"
+                   << "        SetGeometryShader(NULL);\n"
+                   << "        SetPixelShader(CompileShader(ps_5_0, PS(" << t + p << ")));\n"
+                   << "    }\n";
+            }
+            fx << "}\n\n";
+        }
+
+        if(techniques > defaultTechniques)
+            fx << "}\n";
+
+        return fx.str();
+    }
+
+    template<typename T> struct DescOf;
+    template<> struct DescOf<ID3DX11EffectVariable> { typedef D3DX11_EFFECT_VARIABLE_DESC Type; };
+    template<> struct DescOf<ID3DX11EffectConstantBuffer> { typedef D3DX11_EFFECT_VARIABLE_DESC Type; };
+    template<> struct DescOf<ID3DX11EffectTechnique> { typedef D3DX11_TECHNIQUE_DESC Type; };
+    template<> struct DescOf<ID3DX11EffectPass> { typedef D3DX11_PASS_DESC Type; };
+
+    bool CreateDevice(ID3D11Device** ppDevice, D3D_DRIVER_TYPE* pDriverType, const char** pDriverName)
+    {
+        D3D_DRIVER_TYPE types[] = { D3D_DRIVER_TYPE_NULL, D3D_DRIVER_TYPE_WARP, D3D_DRIVER_TYPE_HARDWARE };
+        const char* names[] = { "NULL reference", "WARP", "hardware" };
+
+        for(uint32 i = 0; i < 3; ++i)
+        {
+            D3D_FEATURE_LEVEL featureLevel;
+            if(SUCCEEDED(D3D11CreateDevice(nullptr, types[i], nullptr, 0, nullptr, 0, D3D11_SDK_VERSION,
+                ppDevice, &featureLevel, nullptr)) && featureLevel >= D3D_FEATURE_LEVEL_11_0)
+            {
+                *pDriverType = types[i];
+                *pDriverName = names[i];
+                return true;
+            }
+
+            if(*ppDevice)
+            {
+                (*ppDevice)->Release();
+                *ppDevice = nullptr;
+            }
+        }
+        return false;
+    }
+
+    // Compiled effect of a .fx file, or the content of a .fxo file.
+    bool LoadCompiledEffect(const std::string& fileName, std::vector<uint8>* pData)
+    {
+        if(fileName.size() > 4 && !_stricmp(fileName.c_str() + fileName.size() - 4, ".fxo"))
+        {
+            std::ifstream fin(fileName, std::ios::binary);
+            if(!fin.good())
+                return false;
+
+            fin.seekg(0, std::ios_base::end);
+            std::streamoff size = fin.tellg();
+            fin.seekg(0, std::ios_base::beg);
+            if(size <= 0)
+                return false;
+
+            pData->resize((size_t)size);
+            fin.read(reinterpret_cast<char*>(&(*pData)[0]), size);
+            return !fin.fail();
+        }
+
+        ComPtr<ID3D10Blob> compiled;
+        ComPtr<ID3D10Blob> errors;
+        if(FAILED(D3DX11CompileFromFile(fileName.c_str(), nullptr, nullptr, nullptr, "fx_5_0", 0, 0, nullptr,
+            compiled.GetAddressOf(), errors.GetAddressOf(), nullptr)))
+        {
+            if(errors.Get())
+                printf("%s\n", (const char*)errors->GetBufferPointer());
+            return false;
+        }
+
+        const uint8* bytes = static_cast<const uint8*>(compiled->GetBufferPointer());
+        pData->assign(bytes, bytes + compiled->GetBufferSize());
+        return true;
+    }
+
+    // Whether a lookup found the object of this name.
+    template<typename T>
+    bool HasName(T* pObject, const std::string& name)
+    {
+        typename DescOf<T>::Type desc;
+        return pObject->IsValid() && SUCCEEDED(pObject->GetDesc(&desc)) && name == desc.Name;
+    }
+
+    // Best and median of the runs, in milliseconds.
+    void Report(const char* name, std::vector<float>& times)
+    {
+        std::sort(times.begin(), times.end());
+        printf("%-26s best %8.2f ms   median %8.2f ms\n", name, times.front(), times[times.size() / 2]);
+    }
+
+    // Buffer uploads since *pLast, per run, and the new sample in *pLast.
+    void ReportUploads(uint32 runs, D3DX11_EFFECT_UPLOAD_STATS* pLast)
+    {
+        D3DX11_EFFECT_UPLOAD_STATS now;
+        D3DX11GetEffectUploadStats(&now);
+
+        printf("%-26s %8.0f updates, %8.0f discard maps, %10.2f KB sent, %10.2f KB skipped per run\n", "",
+            (double)(now.Updates - pLast->Updates) / runs, (double)(now.DiscardMaps - pLast->DiscardMaps) / runs,
+            (double)(now.BytesUploaded - pLast->BytesUploaded) / runs / 1024.0,
+            (double)(now.BytesSkipped - pLast->BytesSkipped) / runs / 1024.0);
+        *pLast = now;
+    }
+
+    // Device objects of a set of effects: the constant buffers and the state
+    // objects of the state variables, each counted per effect and per object.
+    struct ObjectCounts
+    {
+        uint32 CBuffers;
+        uint32 Buffers;
+        uint64 CBufferBytes;
+        uint64 BufferBytes;
+        uint32 StateVariables;
+        uint32 States;
+    };
+
+    void AddState(ID3D11DeviceChild* pState, ObjectCounts* pCounts, std::set<ID3D11DeviceChild*>* pSeen)
+    {
+        if(!pState)
+            return;
+
+        ++pCounts->StateVariables;
+        if(pSeen->insert(pState).second)
+            ++pCounts->States;
+        pState->Release();
+    }
+
+    ObjectCounts CountObjects(const std::vector<ComPtr<ID3DX11Effect>>& effects)
+    {
+        ObjectCounts counts = {};
+        std::set<ID3D11Buffer*> buffers;
+        std::set<ID3D11DeviceChild*> states;
+
+        for(size_t e = 0; e < effects.size(); ++e)
+        {
+            ID3DX11Effect* pEffect = effects[e].Get();
+            D3DX11_EFFECT_DESC desc;
+            pEffect->GetDesc(&desc);
+
+            for(uint32 i = 0; i < desc.ConstantBuffers; ++i)
+            {
+                ComPtr<ID3D11Buffer> buffer;
+                if(FAILED(pEffect->GetConstantBufferByIndex(i)->GetConstantBuffer(buffer.GetAddressOf())))
+                    continue;
+
+                D3D11_BUFFER_DESC bufferDesc;
+                buffer->GetDesc(&bufferDesc);
+                ++counts.CBuffers;
+                counts.CBufferBytes += bufferDesc.ByteWidth;
+                if(buffers.insert(buffer.Get()).second)
+                {
+                    ++counts.Buffers;
+                    counts.BufferBytes += bufferDesc.ByteWidth;
+                }
+            }
+
+            for(uint32 i = 0; i < desc.GlobalVariables; ++i)
+            {
+                ID3DX11EffectVariable* pVariable = pEffect->GetVariableByIndex(i);
+                D3DX11_EFFECT_TYPE_DESC typeDesc;
+                pVariable->GetType()->GetDesc(&typeDesc);
+
+                for(uint32 j = 0; j < std::max(1u, (uint32)typeDesc.Elements); ++j)
+                {
+                    ID3D11BlendState* pBlend = nullptr;
+                    ID3D11DepthStencilState* pDepthStencil = nullptr;
+                    ID3D11RasterizerState* pRasterizer = nullptr;
+                    ID3D11SamplerState* pSampler = nullptr;
+
+                    if(pVariable->AsBlend()->IsValid() && SUCCEEDED(pVariable->AsBlend()->GetBlendState(j, &pBlend)))
+                        AddState(pBlend, &counts, &states);
+                    else if(pVariable->AsDepthStencil()->IsValid() &&
+                        SUCCEEDED(pVariable->AsDepthStencil()->GetDepthStencilState(j, &pDepthStencil)))
+                        AddState(pDepthStencil, &counts, &states);
+                    else if(pVariable->AsRasterizer()->IsValid() &&
+                        SUCCEEDED(pVariable->AsRasterizer()->GetRasterizerState(j, &pRasterizer)))
+                        AddState(pRasterizer, &counts, &states);
+                    else if(pVariable->AsSampler()->IsValid() && SUCCEEDED(pVariable->AsSampler()->GetSampler(j, &pSampler)))
+                        AddState(pSampler, &counts, &states);
+                }
+            }
+        }
+        return counts;
+    }
+
+    bool Run(const char* name, uint32 runs, const std::function<bool()>& work)
+    {
+        Timer timer;
+        timer.Reset();
+
+        std::vector<float> times(runs);
+        for(uint32 r = 0; r < runs; ++r)
+        {
+            timer.Tick();
+            bool done = work();
+            timer.Tick();
+
+            if(!done)
+            {
+                printf("%s: failed\n", name);
+                return false;
+            }
+            times[r] = timer.DeltaTime() * 1000.0f;
+        }
+
+        Report(name, times);
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    uint32 variables = 10000;
+    uint32 cbuffers = 100;
+    uint32 techniques = 32;
+    uint32 runs = 5;
+    uint32 applies = 100000;
+    UINT effectFlags = 0;
+    std::vector<std::string> fxFiles;
+
+    for(int a = 1; a < argc; ++a)
+    {
+        if(!strcmp(argv[a], "-variables") && a + 1 < argc)
+            variables = std::max(1u, (uint32)strtoul(argv[++a], nullptr, 10));
+        else if(!strcmp(argv[a], "-cbuffers") && a + 1 < argc)
+            cbuffers = std::max(1u, (uint32)strtoul(argv[++a], nullptr, 10));
+        else if(!strcmp(argv[a], "-techniques") && a + 1 < argc)
+            techniques = std::max(1u, (uint32)strtoul(argv[++a], nullptr, 10));
+        else if(!strcmp(argv[a], "-runs") && a + 1 < argc)
+            runs = std::max(1u, (uint32)strtoul(argv[++a], nullptr, 10));
+        else if(!strcmp(argv[a], "-applies") && a + 1 < argc)
+            applies = std::max(1u, (uint32)strtoul(argv[++a], nullptr, 10));
+        else if(!strcmp(argv[a], "-dynamic"))
+            effectFlags |= D3DX11_EFFECT_DYNAMIC_CONSTANT_BUFFERS;
+        else if(!strcmp(argv[a], "-fx") && a + 1 < argc)
+            fxFiles.push_back(argv[++a]);
+        else
+        {
+            printf("Usage: EffectLoadBenchmark [-variables n] [-cbuffers n] [-techniques n] [-runs n]\n"
+                   "                           [-applies n] [-dynamic] [-fx file.fx|file.fxo]...\n");
+            return 1;
+        }
+    }
+
+    if(fxFiles.empty())
+    {
+        fxFiles.push_back("../../topics/CubeMap/FX/Basic.fx");
+        fxFiles.push_back("../../basic/CSBlurWaves/FX/Blur.fx");
+        fxFiles.push_back("../../basic/TreeBillboard/FX/TreeSprite.fx");
+    }
+    cbuffers = std::min(cbuffers, variables);
+
+    std::string source = GenerateEffect(variables, cbuffers, techniques);
+
+    ComPtr<ID3DBlob> compiled;
+    ComPtr<ID3DBlob> errors;
+    if(FAILED(D3DCompile(source.c_str(), source.size(), "EffectLoadBenchmark", nullptr, nullptr, nullptr, "fx_5_0",
+        0, 0, compiled.GetAddressOf(), errors.GetAddressOf())))
+    {
+        printf("Compilation failed\n%s\n", errors.Get() ? (const char*)errors->GetBufferPointer() : "");
+        return 1;
+    }
+
+    ComPtr<ID3D11Device> device;
+    D3D_DRIVER_TYPE driverType = D3D_DRIVER_TYPE_UNKNOWN;
+    const char* driverName = nullptr;
+    if(!CreateDevice(device.GetAddressOf(), &driverType, &driverName))
+    {
+        printf("No Direct3D 11 device\n");
+        return 1;
+    }
+
+    printf("%u variables in %u cbuffers%s, %u techniques, %.2f KB compiled, %s device, %u runs\n", variables, cbuffers,
+        effectFlags ? " (dynamic)" : "", techniques, compiled->GetBufferSize() / 1024.0f, driverName, runs);
+
+    ComPtr<ID3DX11Effect> effect;
+    if(!Run("D3DX11CreateEffect", runs, [&]()
+    {
+        return SUCCEEDED(D3DX11CreateEffectFromMemory(compiled->GetBufferPointer(), compiled->GetBufferSize(),
+            effectFlags, device.Get(), effect.ReleaseAndGetAddressOf()));
+    }))
+        return 1;
+
+    ComPtr<ID3DX11Effect> clone;
+    if(!Run("CloneEffect", runs, [&]()
+    {
+        return SUCCEEDED(effect->CloneEffect(0, clone.ReleaseAndGetAddressOf()));
+    }))
+        return 1;
+
+    // The names are made before the timing, the lookups alone are measured.
+    std::vector<std::string> variableNames(variables);
+    for(uint32 i = 0; i < variables; ++i)
+        variableNames[i] = VariableName(i);
+
+    std::vector<std::string> cbufferNames(cbuffers);
+    for(uint32 i = 0; i < cbuffers; ++i)
+        cbufferNames[i] = CBufferName(i);
+
+    uint32 defaultTechniques = (techniques + 1) / 2;
+    std::vector<std::string> techniqueNames(techniques);
+    for(uint32 i = 0; i < techniques; ++i)
+        techniqueNames[i] = i < defaultTechniques ? TechniqueName(i) : std::string(NamedGroup) + "|" + TechniqueName(i);
+
+    uint32 missing = 0;
+    Run("GetVariableByName", runs, [&]()
+    {
+        for(uint32 i = 0; i < variables; ++i)
+        {
+            if(!HasName(effect->GetVariableByName(variableNames[i].c_str()), variableNames[i]))
+                ++missing;
+        }
+        return true;
+    });
+
+    Run("GetConstantBufferByName", runs, [&]()
+    {
+        for(uint32 i = 0; i < cbuffers; ++i)
+        {
+            if(!HasName(effect->GetConstantBufferByName(cbufferNames[i].c_str()), cbufferNames[i]))
+                ++missing;
+        }
+        return true;
+    });
+
+    Run("GetTechniqueByName", runs, [&]()
+    {
+        for(uint32 i = 0; i < techniques; ++i)
+        {
+            ID3DX11EffectTechnique* pTechnique = effect->GetTechniqueByName(techniqueNames[i].c_str());
+            if(!HasName(pTechnique, TechniqueName(i)) || !HasName(pTechnique->GetPassByName("P1"), "P1"))
+                ++missing;
+        }
+        return true;
+    });
+
+    // The clone has its own names.
+    for(uint32 i = 0; i < variables; ++i)
+    {
+        if(!HasName(clone->GetVariableByName(variableNames[i].c_str()), variableNames[i]))
+            ++missing;
+    }
+
+    if(missing)
+        printf("error: %u lookups failed\n", missing);
+    else
+        printf("all the lookups found their own name\n");
+
+    EffectCache cache;
+    uint32 failures = 0;
+    std::vector<std::vector<uint8>> demoData;
+    std::vector<std::string> demoNames;
+    for(size_t f = 0; f < fxFiles.size(); ++f)
+    {
+        std::vector<uint8> data;
+        if(!LoadCompiledEffect(fxFiles[f], &data))
+        {
+            printf("%s: can not be compiled or read\n", fxFiles[f].c_str());
+            ++failures;
+            continue;
+        }
+
+        printf("%s, %.2f KB compiled\n", fxFiles[f].c_str(), data.size() / 1024.0f);
+
+        ComPtr<ID3DX11Effect> fx;
+        if(!Run("  D3DX11CreateEffect", runs, [&]()
+            {
+                return SUCCEEDED(D3DX11CreateEffectFromMemory(&data[0], data.size(), 0, device.Get(),
+                    fx.ReleaseAndGetAddressOf()));
+            }) ||
+           !Run("  EffectCache", runs, [&]()
+            {
+                return SUCCEEDED(cache.Create(device.Get(), data, fx.ReleaseAndGetAddressOf()));
+            }))
+            ++failures;
+        else
+        {
+            demoData.push_back(data);
+            demoNames.push_back(fxFiles[f]);
+        }
+    }
+
+    EffectCache::Stats stats = cache.GetStats();
+    printf("EffectCache: %u loads (%.2f ms), %u clones (%.2f ms), %.2f ms of loading saved\n",
+        stats.Loads, stats.LoadTime * 1000.0f, stats.Loads + stats.Hits, stats.CloneTime * 1000.0f,
+        stats.LoadTimeSaved * 1000.0f);
+
+    // The demo effects side by side. The runtime gives equal state descriptions
+    // one object whatever the flags, the cbuffers are only merged when shared.
+    for(uint32 shared = 0; shared < 2 && !demoData.empty(); ++shared)
+    {
+        UINT flags = shared ? D3DX11_EFFECT_SHARED_CONSTANT_BUFFERS : 0;
+        std::vector<ComPtr<ID3DX11Effect>> scene(demoData.size());
+        for(size_t f = 0; f < demoData.size(); ++f)
+        {
+            if(FAILED(D3DX11CreateEffectFromMemory(&demoData[f][0], demoData[f].size(), flags, device.Get(),
+                scene[f].GetAddressOf())))
+            {
+                printf("%s: can not be created\n", demoNames[f].c_str());
+                return 1;
+            }
+        }
+
+        ObjectCounts counts = CountObjects(scene);
+        printf("%u demo effects%s: %u cbuffers (%.2f KB) in %u buffers (%.2f KB), %u state variables on %u objects\n",
+            (uint32)scene.size(), shared ? ", shared cbuffers" : "", counts.CBuffers, counts.CBufferBytes / 1024.0,
+            counts.Buffers, counts.BufferBytes / 1024.0, counts.StateVariables, counts.States);
+    }
+
+    ComPtr<ID3D11DeviceContext> immediate;
+    device->GetImmediateContext(immediate.GetAddressOf());
+
+    // The variable set before each apply, and the pixel shader slot of its
+    // constant buffer, where the apply contexts bind their own copy of it.
+    ID3DX11EffectVariable* param = effect->GetVariableByName(variableNames[0].c_str());
+    ID3DX11EffectPass* pass = effect->GetTechniqueByIndex(0)->GetPassByIndex(0);
+    ComPtr<ID3D11Buffer> cbuffer;
+    uint32 cbufferSlot = D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+    if(SUCCEEDED(effect->GetConstantBufferByName(cbufferNames[0].c_str())->GetConstantBuffer(cbuffer.GetAddressOf())))
+    {
+        ID3D11Buffer* bound[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+        pass->Apply(0, immediate.Get());
+        immediate->PSGetConstantBuffers(0, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, bound);
+        for(uint32 slot = 0; slot < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT; ++slot)
+        {
+            if(bound[slot] == cbuffer.Get() && cbufferSlot == D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT)
+                cbufferSlot = slot;
+            if(bound[slot])
+                bound[slot]->Release();
+        }
+    }
+    if(cbufferSlot == D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT)
+    {
+        printf("EffectApplyContext: no constant buffer\n");
+        return 1;
+    }
+
+    // One deferred and apply context per chunk of the pool, made before the timing.
+    ThreadPool& pool = ThreadPool::Shared();
+    const uint32 minChunkSize = 256;
+    uint32 chunks = pool.ChunkCount(applies, minChunkSize);
+
+    struct Recorder
+    {
+        std::unique_ptr<EffectApplyContext> Context;
+        ComPtr<ID3D11CommandList> List;
+    };
+
+    std::vector<Recorder> recorders(chunks);
+    for(uint32 c = 0; c < chunks; ++c)
+    {
+        Recorder& r = recorders[c];
+        r.Context.reset(new EffectApplyContext());
+        if(FAILED(r.Context->Init(device.Get())))
+        {
+            printf("EffectApplyContext: failed\n");
+            return 1;
+        }
+    }
+
+    // Record [first, last) with the recorder of the chunk.
+    auto record = [&](uint32 chunk, uint32 first, uint32 last)
+    {
+        Recorder& r = recorders[chunk];
+        for(uint32 i = first; i < last; ++i)
+        {
+            float value[4] = { (float)i, 0.0f, 0.0f, 1.0f };
+            r.Context->SetRawValue(param, value, 0, sizeof(value));
+            r.Context->Apply(pass);
+        }
+        r.Context->Finish(r.List.ReleaseAndGetAddressOf());
+    };
+
+    auto execute = [&](uint32 lists)
+    {
+        for(uint32 c = 0; c < lists; ++c)
+        {
+            if(!recorders[c].List)
+                return false;
+            immediate->ExecuteCommandList(recorders[c].List.Get(), FALSE);
+            recorders[c].List.Reset();
+        }
+        return true;
+    };
+
+    printf("%u applies, %u chunks over %u threads\n", applies, chunks, pool.ThreadCount() + 1);
+    D3DX11_EFFECT_UPLOAD_STATS uploads;
+    D3DX11GetEffectUploadStats(&uploads);
+
+    bool recorded = Run("Apply, one thread", runs, [&]()
+    {
+        record(0, 0, applies);
+        return execute(1);
+    });
+    ReportUploads(runs, &uploads);
+
+    recorded = Run("Apply, thread pool", runs, [&]()
+    {
+        pool.ParallelFor(applies, minChunkSize, record);
+        return execute(chunks);
+    }) && recorded;
+    ReportUploads(runs, &uploads);
+
+    recorded = Run("Apply, immediate context", runs, [&]()
+    {
+        for(uint32 i = 0; i < applies; ++i)
+        {
+            float value[4] = { (float)i, 0.0f, 0.0f, 1.0f };
+            param->SetRawValue(value, 0, sizeof(value));
+            pass->Apply(0, immediate.Get());
+        }
+        return true;
+    }) && recorded;
+    ReportUploads(runs, &uploads);
+
+    if(driverType == D3D_DRIVER_TYPE_NULL)
+    {
+        printf("replay check: skipped, the NULL reference device does not execute the copies\n");
+        return missing || failures || !recorded ? 1 : 0;
+    }
+
+    // Replay check, one staging buffer per apply, cleared by the check.
+    const uint32 checks = std::min(applies, 1024u);
+    D3D11_BUFFER_DESC captureDesc;
+    cbuffer->GetDesc(&captureDesc);
+    captureDesc.Usage = D3D11_USAGE_STAGING;
+    captureDesc.BindFlags = 0;
+    captureDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ | D3D11_CPU_ACCESS_WRITE;
+    captureDesc.MiscFlags = 0;
+
+    std::vector<uint8> zeros(captureDesc.ByteWidth, 0);
+    D3D11_SUBRESOURCE_DATA zeroData = { &zeros[0], 0, 0 };
+
+    std::vector<ComPtr<ID3D11Buffer>> captures(checks);
+    for(uint32 i = 0; i < checks; ++i)
+    {
+        if(FAILED(device->CreateBuffer(&captureDesc, &zeroData, captures[i].GetAddressOf())))
+        {
+            printf("Replay check: no staging buffer\n");
+            return 1;
+        }
+    }
+
+    // Record [first, last) like record, and copy the buffer bound at the slot
+    // of the variable's constant buffer after each apply.
+    auto capture = [&](uint32 chunk, uint32 first, uint32 last)
+    {
+        Recorder& r = recorders[chunk];
+        ID3D11DeviceContext* context = r.Context->Context();
+        for(uint32 i = first; i < last; ++i)
+        {
+            float value[4] = { (float)i, 0.0f, 0.0f, 1.0f };
+            r.Context->SetRawValue(param, value, 0, sizeof(value));
+            r.Context->Apply(pass);
+
+            ID3D11Buffer* bound = nullptr;
+            context->PSGetConstantBuffers(cbufferSlot, 1, &bound);
+            if(bound)
+            {
+                context->CopyResource(captures[i].Get(), bound);
+                bound->Release();
+            }
+        }
+        r.Context->Finish(r.List.ReleaseAndGetAddressOf());
+    };
+
+    // Number of copies without the value set before their apply. A buffer not
+    // bound leaves its copy cleared, which never matches (w is 1).
+    auto mismatches = [&]()
+    {
+        uint32 count = 0;
+        for(uint32 i = 0; i < checks; ++i)
+        {
+            D3D11_MAPPED_SUBRESOURCE mapped;
+            if(FAILED(immediate->Map(captures[i].Get(), 0, D3D11_MAP_READ_WRITE, 0, &mapped)))
+            {
+                ++count;
+                continue;
+            }
+
+            const float* value = static_cast<const float*>(mapped.pData);
+            if(value[0] != (float)i || value[1] != 0.0f || value[2] != 0.0f || value[3] != 1.0f)
+                ++count;
+
+            memset(mapped.pData, 0, captureDesc.ByteWidth);
+            immediate->Unmap(captures[i].Get(), 0);
+        }
+        return count;
+    };
+
+    capture(0, 0, checks);
+    uint32 serialMismatches = execute(1) ? mismatches() : checks;
+
+    pool.ParallelFor(checks, minChunkSize, capture);
+    uint32 poolMismatches = execute(pool.ChunkCount(checks, minChunkSize)) ? mismatches() : checks;
+
+    if(serialMismatches || poolMismatches)
+        printf("error: replay check, %u of %u applies bound other values, %u over the pool\n", serialMismatches,
+            checks, poolMismatches);
+    else
+        printf("replay check: the %u applies bound their own values, from one thread and over the pool\n", checks);
+
+    return missing || failures || !recorded || serialMismatches || poolMismatches ? 1 : 0;
+}
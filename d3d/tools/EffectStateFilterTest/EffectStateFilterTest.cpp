@@ -0,0 +1,514 @@
+//---------------------------------------------------------------------------------------
+//
+// Checks the redundant state filter of Effects11 (CEffectStateFilter, Effect.h).
+//
+// A small effect is compiled and created on a device without a window (the NULL
+// reference device, or WARP), and its passes are applied through ID3DX11EffectPass::
+// Apply on a recording stub of ID3D11DeviceContext: the stub counts every call it
+// gets, by method. Each step applies a pass and checks the exact calls that reached
+// the stub, so a wrong gate or a missed invalidation in ApplyPassBlock shows:
+//  - the first pass with filtering enabled makes all its calls,
+//  - the same pass applied again makes none,
+//  - a variable set in between only updates its constant buffer,
+//  - a pass with another pixel shader, its view and sampler only sets those,
+//  - a new view in a variable only reissues the view,
+//  - after D3DX11InvalidateEffectStateFilter every call is made again,
+//  - without filtering, every apply makes all its calls,
+// and the issued and skipped counters of the filter must match the stub.
+//
+// Then the same effect through two ID3DX11EffectApplyContext, each on its own stub:
+// each context binds its own copy of the constant buffer, a value set through one
+// context only updates that copy and leaves the effect and the other context as they
+// were, and a value set on the effect reaches both copies at their next apply.
+//
+// Then the filter list, on the immediate context of the device: a filter found before
+// filtering is disabled on its context, as by an Apply in flight on another thread,
+// stays usable until that reference is released.
+//
+// The tool includes the private headers of Effects11 and links the library.
+//
+// Usage: EffectStateFilterTest
+//
+// Prints the failed checks, returns 1 if any.
+//
+//---------------------------------------------------------------------------------------
+
+#include "pchfx.h"
+#include "comPtr.h"
+#include <d3dcompiler.h>
+#include <cstdio>
+#include <cstring>
+
+namespace D3DX11Effects
+{
+    extern SD3DShaderVTable g_vtVS;
+}
+
+using namespace D3DX11Effects;
+
+namespace
+{
+    bool g_failed = false;
+
+    void Check(bool condition, const char* what)
+    {
+        if(!condition)
+        {
+            printf("error: %s\n", what);
+            g_failed = true;
+        }
+    }
+
+    // The context commands the stub tells apart, the others are counted together.
+#define STAGE_CALLS(Stage) Call_##Stage##SetShader, Call_##Stage##SetConstantBuffers, \
+    Call_##Stage##SetShaderResources, Call_##Stage##SetSamplers
+
+    enum Call
+    {
+        STAGE_CALLS(VS), STAGE_CALLS(HS), STAGE_CALLS(DS), STAGE_CALLS(GS), STAGE_CALLS(PS), STAGE_CALLS(CS),
+        Call_OMSetBlendState,
+        Call_OMSetDepthStencilState,
+        Call_RSSetState,
+        Call_UpdateSubresource,
+        Call_Map,
+        Call_Other,
+        Call_Count
+    };
+
+#undef STAGE_CALLS
+
+    const char* const c_CallNames[Call_Count] =
+    {
+        "VSSetShader", "VSSetConstantBuffers", "VSSetShaderResources", "VSSetSamplers",
+        "HSSetShader", "HSSetConstantBuffers", "HSSetShaderResources", "HSSetSamplers",
+        "DSSetShader", "DSSetConstantBuffers", "DSSetShaderResources", "DSSetSamplers",
+        "GSSetShader", "GSSetConstantBuffers", "GSSetShaderResources", "GSSetSamplers",
+        "PSSetShader", "PSSetConstantBuffers", "PSSetShaderResources", "PSSetSamplers",
+        "CSSetShader", "CSSetConstantBuffers", "CSSetShaderResources", "CSSetSamplers",
+        "OMSetBlendState", "OMSetDepthStencilState", "RSSetState", "UpdateSubresource", "Map", "other"
+    };
+
+    UINT64 Bit(Call call)
+    {
+        return 1ull << call;
+    }
+
+    struct CallCounts
+    {
+        UINT Count[Call_Count];
+    };
+
+    // Stands for an immediate context: records the commands and does nothing. The
+    // state setting commands the filter can drop are counted by method.
+    class RecordingContext : public ID3D11DeviceContext
+    {
+    public:
+        explicit RecordingContext(ID3D11Device* pDevice)
+            : m_pDevice(pDevice), m_RefCount(1)
+        {
+            memset(&m_Counts, 0, sizeof(m_Counts));
+            m_pLastConstantBuffer = nullptr;
+            m_pLastUpdated = nullptr;
+        }
+
+        const CallCounts& GetCounts() const { return m_Counts; }
+
+        // The first buffer of the last SetConstantBuffers, of any stage, and the
+        // resource of the last UpdateSubresource. Not referenced.
+        ID3D11Buffer* GetLastConstantBuffer() const { return m_pLastConstantBuffer; }
+        ID3D11Resource* GetLastUpdated() const { return m_pLastUpdated; }
+
+        // IUnknown: only the context interfaces of D3D11.0, Effects11 then takes
+        // the paths of a runtime without D3D11.1.
+        STDMETHOD(QueryInterface)(REFIID riid, void** ppvObject)
+        {
+            if(IsEqualIID(riid, __uuidof(IUnknown)) || IsEqualIID(riid, __uuidof(ID3D11DeviceChild)) ||
+                IsEqualIID(riid, __uuidof(ID3D11DeviceContext)))
+            {
+                AddRef();
+                *ppvObject = this;
+                return S_OK;
+            }
+            *ppvObject = nullptr;
+            return E_NOINTERFACE;
+        }
+        STDMETHOD_(ULONG, AddRef)() { return ++m_RefCount; }
+        STDMETHOD_(ULONG, Release)() { return --m_RefCount; }
+
+        // ID3D11DeviceChild
+        STDMETHOD_(void, GetDevice)(ID3D11Device** ppDevice) { m_pDevice->AddRef(); *ppDevice = m_pDevice; }
+        STDMETHOD(GetPrivateData)(REFGUID, UINT*, void*) { return E_NOTIMPL; }
+        STDMETHOD(SetPrivateData)(REFGUID, UINT, const void*) { return E_NOTIMPL; }
+        STDMETHOD(SetPrivateDataInterface)(REFGUID, const IUnknown*) { return E_NOTIMPL; }
+
+        // The shader stages.
+#define RECORD_STAGE(Stage, Shader) \
+        STDMETHOD_(void, Stage##SetShader)(Shader*, ID3D11ClassInstance* const*, UINT) \
+            { Record(Call_##Stage##SetShader); } \
+        STDMETHOD_(void, Stage##SetConstantBuffers)(UINT, UINT Count, ID3D11Buffer* const* ppBuffers) \
+            { Record(Call_##Stage##SetConstantBuffers); m_pLastConstantBuffer = Count ? ppBuffers[0] : nullptr; } \
+        STDMETHOD_(void, Stage##SetShaderResources)(UINT, UINT, ID3D11ShaderResourceView* const*) \
+            { Record(Call_##Stage##SetShaderResources); } \
+        STDMETHOD_(void, Stage##SetSamplers)(UINT, UINT, ID3D11SamplerState* const*) \
+            { Record(Call_##Stage##SetSamplers); } \
+        STDMETHOD_(void, Stage##GetShader)(Shader** ppShader, ID3D11ClassInstance**, UINT* pCount) \
+            { *ppShader = nullptr; if(pCount) *pCount = 0; } \
+        STDMETHOD_(void, Stage##GetConstantBuffers)(UINT, UINT Count, ID3D11Buffer** ppBuffers) \
+            { memset(ppBuffers, 0, Count * sizeof(*ppBuffers)); } \
+        STDMETHOD_(void, Stage##GetShaderResources)(UINT, UINT Count, ID3D11ShaderResourceView** ppViews) \
+            { memset(ppViews, 0, Count * sizeof(*ppViews)); } \
+        STDMETHOD_(void, Stage##GetSamplers)(UINT, UINT Count, ID3D11SamplerState** ppSamplers) \
+            { memset(ppSamplers, 0, Count * sizeof(*ppSamplers)); }
+
+        RECORD_STAGE(VS, ID3D11VertexShader)
+        RECORD_STAGE(HS, ID3D11HullShader)
+        RECORD_STAGE(DS, ID3D11DomainShader)
+        RECORD_STAGE(GS, ID3D11GeometryShader)
+        RECORD_STAGE(PS, ID3D11PixelShader)
+        RECORD_STAGE(CS, ID3D11ComputeShader)
+
+#undef RECORD_STAGE
+
+        // Output merger and rasterizer.
+        STDMETHOD_(void, OMSetBlendState)(ID3D11BlendState*, const FLOAT[4], UINT) { Record(Call_OMSetBlendState); }
+        STDMETHOD_(void, OMSetDepthStencilState)(ID3D11DepthStencilState*, UINT) { Record(Call_OMSetDepthStencilState); }
+        STDMETHOD_(void, RSSetState)(ID3D11RasterizerState*) { Record(Call_RSSetState); }
+        STDMETHOD_(void, OMSetRenderTargets)(UINT, ID3D11RenderTargetView* const*, ID3D11DepthStencilView*)
+            { Record(Call_Other); }
+        STDMETHOD_(void, OMSetRenderTargetsAndUnorderedAccessViews)(UINT, ID3D11RenderTargetView* const*,
+            ID3D11DepthStencilView*, UINT, UINT, ID3D11UnorderedAccessView* const*, const UINT*) { Record(Call_Other); }
+        STDMETHOD_(void, CSSetUnorderedAccessViews)(UINT, UINT, ID3D11UnorderedAccessView* const*, const UINT*)
+            { Record(Call_Other); }
+        STDMETHOD_(void, SOSetTargets)(UINT, ID3D11Buffer* const*, const UINT*) { Record(Call_Other); }
+        STDMETHOD_(void, RSSetViewports)(UINT, const D3D11_VIEWPORT*) { Record(Call_Other); }
+        STDMETHOD_(void, RSSetScissorRects)(UINT, const D3D11_RECT*) { Record(Call_Other); }
+
+        // Resources: the stub has no memory, a map fails and the buffer stays dirty.
+        STDMETHOD(Map)(ID3D11Resource*, UINT, D3D11_MAP, UINT, D3D11_MAPPED_SUBRESOURCE*)
+            { Record(Call_Map); return E_FAIL; }
+        STDMETHOD_(void, Unmap)(ID3D11Resource*, UINT) { Record(Call_Other); }
+        STDMETHOD_(void, UpdateSubresource)(ID3D11Resource* pResource, UINT, const D3D11_BOX*, const void*, UINT, UINT)
+            { Record(Call_UpdateSubresource); m_pLastUpdated = pResource; }
+        STDMETHOD_(void, CopySubresourceRegion)(ID3D11Resource*, UINT, UINT, UINT, UINT, ID3D11Resource*, UINT,
+            const D3D11_BOX*) { Record(Call_Other); }
+        STDMETHOD_(void, CopyResource)(ID3D11Resource*, ID3D11Resource*) { Record(Call_Other); }
+        STDMETHOD_(void, CopyStructureCount)(ID3D11Buffer*, UINT, ID3D11UnorderedAccessView*) { Record(Call_Other); }
+        STDMETHOD_(void, ClearRenderTargetView)(ID3D11RenderTargetView*, const FLOAT[4]) { Record(Call_Other); }
+        STDMETHOD_(void, ClearUnorderedAccessViewUint)(ID3D11UnorderedAccessView*, const UINT[4]) { Record(Call_Other); }
+        STDMETHOD_(void, ClearUnorderedAccessViewFloat)(ID3D11UnorderedAccessView*, const FLOAT[4])
+            { Record(Call_Other); }
+        STDMETHOD_(void, ClearDepthStencilView)(ID3D11DepthStencilView*, UINT, FLOAT, UINT8) { Record(Call_Other); }
+        STDMETHOD_(void, GenerateMips)(ID3D11ShaderResourceView*) { Record(Call_Other); }
+        STDMETHOD_(void, SetResourceMinLOD)(ID3D11Resource*, FLOAT) { Record(Call_Other); }
+        STDMETHOD_(FLOAT, GetResourceMinLOD)(ID3D11Resource*) { return 0.0f; }
+        STDMETHOD_(void, ResolveSubresource)(ID3D11Resource*, UINT, ID3D11Resource*, UINT, DXGI_FORMAT)
+            { Record(Call_Other); }
+
+        // Input assembler and draws.
+        STDMETHOD_(void, IASetInputLayout)(ID3D11InputLayout*) { Record(Call_Other); }
+        STDMETHOD_(void, IASetVertexBuffers)(UINT, UINT, ID3D11Buffer* const*, const UINT*, const UINT*)
+            { Record(Call_Other); }
+        STDMETHOD_(void, IASetIndexBuffer)(ID3D11Buffer*, DXGI_FORMAT, UINT) { Record(Call_Other); }
+        STDMETHOD_(void, IASetPrimitiveTopology)(D3D11_PRIMITIVE_TOPOLOGY) { Record(Call_Other); }
+        STDMETHOD_(void, Draw)(UINT, UINT) { Record(Call_Other); }
+        STDMETHOD_(void, DrawIndexed)(UINT, UINT, INT) { Record(Call_Other); }
+        STDMETHOD_(void, DrawInstanced)(UINT, UINT, UINT, UINT) { Record(Call_Other); }
+        STDMETHOD_(void, DrawIndexedInstanced)(UINT, UINT, UINT, INT, UINT) { Record(Call_Other); }
+        STDMETHOD_(void, DrawAuto)() { Record(Call_Other); }
+        STDMETHOD_(void, DrawInstancedIndirect)(ID3D11Buffer*, UINT) { Record(Call_Other); }
+        STDMETHOD_(void, DrawIndexedInstancedIndirect)(ID3D11Buffer*, UINT) { Record(Call_Other); }
+        STDMETHOD_(void, Dispatch)(UINT, UINT, UINT) { Record(Call_Other); }
+        STDMETHOD_(void, DispatchIndirect)(ID3D11Buffer*, UINT) { Record(Call_Other); }
+
+        // Queries and command lists.
+        STDMETHOD_(void, Begin)(ID3D11Asynchronous*) { Record(Call_Other); }
+        STDMETHOD_(void, End)(ID3D11Asynchronous*) { Record(Call_Other); }
+        STDMETHOD(GetData)(ID3D11Asynchronous*, void*, UINT, UINT) { return E_NOTIMPL; }
+        STDMETHOD_(void, SetPredication)(ID3D11Predicate*, BOOL) { Record(Call_Other); }
+        STDMETHOD_(void, ExecuteCommandList)(ID3D11CommandList*, BOOL) { Record(Call_Other); }
+        STDMETHOD(FinishCommandList)(BOOL, ID3D11CommandList** ppCommandList)
+            { *ppCommandList = nullptr; return DXGI_ERROR_INVALID_CALL; }
+        STDMETHOD_(void, ClearState)() { Record(Call_Other); }
+        STDMETHOD_(void, Flush)() { Record(Call_Other); }
+        STDMETHOD_(D3D11_DEVICE_CONTEXT_TYPE, GetType)() { return D3D11_DEVICE_CONTEXT_IMMEDIATE; }
+        STDMETHOD_(UINT, GetContextFlags)() { return 0; }
+
+        // The getters of the other state, nothing is ever bound.
+        STDMETHOD_(void, IAGetInputLayout)(ID3D11InputLayout** ppLayout) { *ppLayout = nullptr; }
+        STDMETHOD_(void, IAGetVertexBuffers)(UINT, UINT Count, ID3D11Buffer** ppBuffers, UINT*, UINT*)
+            { if(ppBuffers) memset(ppBuffers, 0, Count * sizeof(*ppBuffers)); }
+        STDMETHOD_(void, IAGetIndexBuffer)(ID3D11Buffer** ppBuffer, DXGI_FORMAT*, UINT*)
+            { if(ppBuffer) *ppBuffer = nullptr; }
+        STDMETHOD_(void, IAGetPrimitiveTopology)(D3D11_PRIMITIVE_TOPOLOGY* pTopology)
+            { *pTopology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED; }
+        STDMETHOD_(void, GetPredication)(ID3D11Predicate** ppPredicate, BOOL*) { if(ppPredicate) *ppPredicate = nullptr; }
+        STDMETHOD_(void, OMGetRenderTargets)(UINT Count, ID3D11RenderTargetView** ppViews, ID3D11DepthStencilView** ppDepth)
+        {
+            if(ppViews) memset(ppViews, 0, Count * sizeof(*ppViews));
+            if(ppDepth) *ppDepth = nullptr;
+        }
+        STDMETHOD_(void, OMGetRenderTargetsAndUnorderedAccessViews)(UINT Count, ID3D11RenderTargetView** ppViews,
+            ID3D11DepthStencilView** ppDepth, UINT, UINT UAVCount, ID3D11UnorderedAccessView** ppUAVs)
+        {
+            OMGetRenderTargets(Count, ppViews, ppDepth);
+            if(ppUAVs) memset(ppUAVs, 0, UAVCount * sizeof(*ppUAVs));
+        }
+        STDMETHOD_(void, OMGetBlendState)(ID3D11BlendState** ppState, FLOAT[4], UINT*) { if(ppState) *ppState = nullptr; }
+        STDMETHOD_(void, OMGetDepthStencilState)(ID3D11DepthStencilState** ppState, UINT*)
+            { if(ppState) *ppState = nullptr; }
+        STDMETHOD_(void, SOGetTargets)(UINT Count, ID3D11Buffer** ppBuffers) { memset(ppBuffers, 0, Count * sizeof(*ppBuffers)); }
+        STDMETHOD_(void, RSGetState)(ID3D11RasterizerState** ppState) { *ppState = nullptr; }
+        STDMETHOD_(void, RSGetViewports)(UINT* pCount, D3D11_VIEWPORT*) { *pCount = 0; }
+        STDMETHOD_(void, RSGetScissorRects)(UINT* pCount, D3D11_RECT*) { *pCount = 0; }
+        STDMETHOD_(void, CSGetUnorderedAccessViews)(UINT, UINT Count, ID3D11UnorderedAccessView** ppUAVs)
+            { memset(ppUAVs, 0, Count * sizeof(*ppUAVs)); }
+
+    private:
+        void Record(Call call) { ++m_Counts.Count[call]; }
+
+        ID3D11Device* m_pDevice;
+        ULONG m_RefCount;
+        CallCounts m_Counts;
+        ID3D11Buffer* m_pLastConstantBuffer;
+        ID3D11Resource* m_pLastUpdated;
+    };
+
+    const char c_EffectSource[] =
+        "cbuffer PerObject { float4 gColor; };\n"
+        "Texture2D gTexture;\n"
+        "SamplerState gSampler { Filter = MIN_MAG_MIP_POINT; };\n"
+        "BlendState gAdditive { BlendEnable[0] = TRUE; SrcBlend = ONE; DestBlend = ONE; };\n"
+        "RasterizerState gNoCull { CullMode = None; };\n"
+        "float4 VS(float3 pos : POSITION) : SV_POSITION { return float4(pos, 1.0f); }\n"
+        "float4 PSColor(float4 pos : SV_POSITION) : SV_Target { return gColor; }\n"
+        "float4 PSTextured(float4 pos : SV_POSITION) : SV_Target { return gColor * gTexture.Sample(gSampler, pos.xy); }\n"
+        "VertexShader gVS = CompileShader(vs_5_0, VS());\n"
+        "technique11 Color { pass P0 {\n"
+        "    SetVertexShader(gVS); SetPixelShader(CompileShader(ps_5_0, PSColor()));\n"
+        "    SetBlendState(gAdditive, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xffffffff); SetRasterizerState(gNoCull); } }\n"
+        "technique11 Textured { pass P0 {\n"
+        "    SetVertexShader(gVS); SetPixelShader(CompileShader(ps_5_0, PSTextured()));\n"
+        "    SetBlendState(gAdditive, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xffffffff); SetRasterizerState(gNoCull); } }\n";
+
+    // Applies the first pass of the technique, through the apply context if one is
+    // given, and checks that it made exactly the expected calls on the stub, one of
+    // each.
+    void CheckApply(ID3DX11EffectTechnique* pTechnique, RecordingContext* pContext, UINT64 expected, const char* what,
+        ID3DX11EffectApplyContext* pApplyContext = nullptr)
+    {
+        CallCounts before = pContext->GetCounts();
+        ID3DX11EffectPass* pPass = pTechnique->GetPassByIndex(0);
+        if(FAILED(pApplyContext ? pApplyContext->Apply(pPass, 0) : pPass->Apply(0, pContext)))
+        {
+            printf("error: %s: Apply failed\n", what);
+            g_failed = true;
+            return;
+        }
+
+        const CallCounts& after = pContext->GetCounts();
+        for(UINT i = 0; i < Call_Count; ++i)
+        {
+            UINT made = after.Count[i] - before.Count[i];
+            UINT wanted = (expected & Bit((Call)i)) ? 1 : 0;
+            if(made != wanted)
+            {
+                printf("error: %s: %u %s, %u expected\n", what, made, c_CallNames[i], wanted);
+                g_failed = true;
+            }
+        }
+    }
+
+    bool CreateDevice(ID3D11Device** ppDevice, ID3D11DeviceContext** ppContext)
+    {
+        D3D_DRIVER_TYPE types[] = { D3D_DRIVER_TYPE_NULL, D3D_DRIVER_TYPE_WARP };
+
+        for(UINT i = 0; i < 2; ++i)
+        {
+            if(SUCCEEDED(D3D11CreateDevice(nullptr, types[i], nullptr, 0, nullptr, 0, D3D11_SDK_VERSION,
+                ppDevice, nullptr, ppContext)))
+                return true;
+        }
+        return false;
+    }
+
+    // The effect holds color in gColor, no filter is enabled on the stubs.
+    void CheckApplyContexts(ID3D11Device* pDevice, ID3DX11Effect* pEffect, const FLOAT color[4])
+    {
+        ID3DX11EffectTechnique* pColor = pEffect->GetTechniqueByName("Color");
+        ID3DX11EffectVectorVariable* pColorVariable = pEffect->GetVariableByName("gColor")->AsVector();
+        const UINT64 colorPass = Bit(Call_OMSetBlendState) | Bit(Call_RSSetState) | Bit(Call_VSSetShader) |
+            Bit(Call_PSSetConstantBuffers) | Bit(Call_PSSetShader);
+
+        RecordingContext contextA(pDevice);
+        RecordingContext contextB(pDevice);
+        ComPtr<ID3DX11EffectApplyContext> applyA;
+        ComPtr<ID3DX11EffectApplyContext> applyB;
+        ComPtr<ID3D11Buffer> effectBuffer;
+        if(FAILED(D3DX11CreateEffectApplyContext(&contextA, applyA.GetAddressOf())) ||
+            FAILED(D3DX11CreateEffectApplyContext(&contextB, applyB.GetAddressOf())) ||
+            FAILED(pEffect->GetConstantBufferByName("PerObject")->GetConstantBuffer(effectBuffer.GetAddressOf())))
+        {
+            printf("error: the apply contexts could not be created\n");
+            g_failed = true;
+            return;
+        }
+
+        // The copies are made with the values of the effect, nothing to update.
+        CheckApply(pColor, &contextA, colorPass, "apply context, first pass", applyA.Get());
+        CheckApply(pColor, &contextB, colorPass, "second apply context, first pass", applyB.Get());
+        ID3D11Buffer* pBufferA = contextA.GetLastConstantBuffer();
+        ID3D11Buffer* pBufferB = contextB.GetLastConstantBuffer();
+        Check(pBufferA != nullptr && pBufferB != nullptr && pBufferA != pBufferB && pBufferA != effectBuffer.Get() &&
+            pBufferB != effectBuffer.Get(), "each apply context must bind its own copy of the cbuffer");
+
+        const FLOAT red[4] = { 1.0f, 0.0f, 0.0f, 1.0f };
+        Check(SUCCEEDED(applyA->SetRawValue(pColorVariable, red, 0, sizeof(red))), "SetRawValue must succeed");
+        CheckApply(pColor, &contextA, colorPass | Bit(Call_UpdateSubresource), "apply context, own value", applyA.Get());
+        Check(contextA.GetLastUpdated() == pBufferA, "a value set through a context must update its copy");
+        Check(contextA.GetLastConstantBuffer() == pBufferA, "an apply context must keep its copy");
+        CheckApply(pColor, &contextB, colorPass, "second apply context, value of the first", applyB.Get());
+
+        FLOAT value[4];
+        pColorVariable->GetFloatVector(value);
+        Check(memcmp(value, color, sizeof(value)) == 0, "a value set through a context must not reach the effect");
+
+        const FLOAT green[4] = { 0.0f, 1.0f, 0.0f, 1.0f };
+        pColorVariable->SetFloatVector(green);
+        CheckApply(pColor, &contextA, colorPass | Bit(Call_UpdateSubresource), "apply context, new value of the effect",
+            applyA.Get());
+        Check(contextA.GetLastUpdated() == pBufferA, "a value of the effect must update the copy of the first context");
+        CheckApply(pColor, &contextB, colorPass | Bit(Call_UpdateSubresource),
+            "second apply context, new value of the effect", applyB.Get());
+        Check(contextB.GetLastUpdated() == pBufferB, "a value of the effect must update the copy of the second context");
+        CheckApply(pColor, &contextB, colorPass, "second apply context, same value", applyB.Get());
+
+        // The contexts hold the effect and their stub until released.
+        applyA.Reset();
+        applyB.Reset();
+        Check(contextA.Release() == 0 && contextB.Release() == 0, "the apply contexts must release their context");
+        printf("apply contexts: checked\n");
+    }
+
+    void CheckAppliedPasses(ID3D11Device* pDevice)
+    {
+        ComPtr<ID3DBlob> compiled;
+        ComPtr<ID3DBlob> errors;
+        if(FAILED(D3DCompile(c_EffectSource, sizeof(c_EffectSource) - 1, "EffectStateFilterTest", nullptr, nullptr,
+            nullptr, "fx_5_0", 0, 0, compiled.GetAddressOf(), errors.GetAddressOf())))
+        {
+            printf("error: compilation failed\n%s\n", errors.Get() ? (const char*)errors->GetBufferPointer() : "");
+            g_failed = true;
+            return;
+        }
+
+        ComPtr<ID3DX11Effect> effect;
+        if(FAILED(D3DX11CreateEffectFromMemory(compiled->GetBufferPointer(), compiled->GetBufferSize(), 0, pDevice,
+            effect.GetAddressOf())))
+        {
+            printf("error: the effect could not be created\n");
+            g_failed = true;
+            return;
+        }
+
+        ID3DX11EffectTechnique* pColor = effect->GetTechniqueByName("Color");
+        ID3DX11EffectTechnique* pTextured = effect->GetTechniqueByName("Textured");
+        ID3DX11EffectVectorVariable* pColorVariable = effect->GetVariableByName("gColor")->AsVector();
+        ID3DX11EffectShaderResourceVariable* pTexture = effect->GetVariableByName("gTexture")->AsShaderResource();
+
+        // A view for gTexture, any one: the stub never reads it.
+        D3D11_TEXTURE2D_DESC textureDesc = { 1, 1, 1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, { 1, 0 }, D3D11_USAGE_DEFAULT,
+            D3D11_BIND_SHADER_RESOURCE, 0, 0 };
+        ComPtr<ID3D11Texture2D> texture;
+        ComPtr<ID3D11ShaderResourceView> view;
+        Check(SUCCEEDED(pDevice->CreateTexture2D(&textureDesc, nullptr, texture.GetAddressOf())) &&
+            SUCCEEDED(pDevice->CreateShaderResourceView(texture.Get(), nullptr, view.GetAddressOf())),
+            "the texture and its view must be created");
+
+        RecordingContext context(pDevice);
+        const UINT64 colorPass = Bit(Call_OMSetBlendState) | Bit(Call_RSSetState) | Bit(Call_VSSetShader) |
+            Bit(Call_PSSetConstantBuffers) | Bit(Call_PSSetShader);
+        const UINT64 texturedPass = colorPass | Bit(Call_PSSetShaderResources) | Bit(Call_PSSetSamplers);
+
+        Check(SUCCEEDED(D3DX11EnableEffectStateFilter(&context, TRUE)), "enabling the filter must succeed");
+
+        CheckApply(pColor, &context, colorPass, "first pass");
+        CheckApply(pColor, &context, 0, "same pass again");
+
+        const FLOAT color[4] = { 1.0f, 0.5f, 0.25f, 1.0f };
+        pColorVariable->SetFloatVector(color);
+        CheckApply(pColor, &context, Bit(Call_UpdateSubresource), "same pass, new color");
+
+        CheckApply(pTextured, &context, Bit(Call_PSSetShader) | Bit(Call_PSSetShaderResources) | Bit(Call_PSSetSamplers),
+            "pass with another pixel shader");
+        CheckApply(pTextured, &context, 0, "textured pass again");
+
+        pTexture->SetResource(view.Get());
+        CheckApply(pTextured, &context, Bit(Call_PSSetShaderResources), "textured pass, new view");
+
+        CheckApply(pColor, &context, Bit(Call_PSSetShader), "back to the first pass");
+
+        Check(SUCCEEDED(D3DX11InvalidateEffectStateFilter(&context)), "invalidating the filter must succeed");
+        CheckApply(pColor, &context, colorPass, "first pass after invalidation");
+
+        // 5 + 0 + 0 + 3 + 0 + 1 + 1 + 5 issued, of 8 applies of 5 or 7 filtered calls.
+        D3DX11_EFFECT_STATE_FILTER_STATS stats;
+        Check(SUCCEEDED(D3DX11GetEffectStateFilterStats(&context, &stats)), "the filter stats must be read");
+        UINT issued = 0;
+        for(UINT i = 0; i < Call_UpdateSubresource; ++i)
+            issued += context.GetCounts().Count[i];
+        Check(stats.CallsIssued == issued, "the issued counter must match the recorded calls");
+        Check(stats.CallsIssued + stats.CallsSkipped == 5 * 5 + 3 * 7, "every filtered call must be counted once");
+        printf("applied passes: %u calls issued, %u skipped\n", (UINT)stats.CallsIssued, (UINT)stats.CallsSkipped);
+
+        Check(SUCCEEDED(D3DX11EnableEffectStateFilter(&context, FALSE)), "disabling the filter must succeed");
+        CheckApply(pTextured, &context, texturedPass, "textured pass, filtering disabled");
+        CheckApply(pTextured, &context, texturedPass, "textured pass again, filtering disabled");
+
+        CheckApplyContexts(pDevice, effect.Get(), color);
+
+        // Released before the device of the stub.
+        effect.Reset();
+        Check(context.Release() == 0, "the filter must release the context");
+    }
+
+    void CheckFilterList(ID3D11DeviceContext* pContext)
+    {
+        Check(g_EffectStateFilters.Find(pContext) == nullptr, "no filter before filtering is enabled");
+        Check(SUCCEEDED(D3DX11EnableEffectStateFilter(pContext, TRUE)), "enabling the filter must succeed");
+
+        // What an Apply on another thread holds while filtering is disabled.
+        CEffectStateFilter* pFilter = g_EffectStateFilters.Find(pContext);
+        Check(pFilter != nullptr, "the enabled filter must be found");
+        Check(SUCCEEDED(D3DX11EnableEffectStateFilter(pContext, FALSE)), "disabling the filter must succeed");
+        Check(g_EffectStateFilters.Find(pContext) == nullptr, "a disabled filter must not be found");
+
+        if(pFilter)
+        {
+            // The filter only compares the pointers, the shader is never touched.
+            ID3D11DeviceChild* pShader = reinterpret_cast<ID3D11DeviceChild*>(static_cast<UINT_PTR>(0x10000));
+            Check(pFilter->SetShader(&g_vtVS, pShader, 0) == TRUE, "a filter disabled during an Apply must stay usable");
+            Check(pFilter->SetShader(&g_vtVS, pShader, 0) == FALSE, "a filter disabled during an Apply must keep its shadow");
+            pFilter->Release();
+        }
+
+        Check(FAILED(D3DX11InvalidateEffectStateFilter(pContext)), "invalidating a disabled filter must fail");
+        printf("filter list: checked\n");
+    }
+}
+
+int main()
+{
+    ComPtr<ID3D11Device> device;
+    ComPtr<ID3D11DeviceContext> context;
+    if(!CreateDevice(device.GetAddressOf(), context.GetAddressOf()))
+    {
+        printf("No Direct3D 11 device\n");
+        return 1;
+    }
+
+    CheckAppliedPasses(device.Get());
+    CheckFilterList(context.Get());
+
+    printf(g_failed ? "FAILED\n" : "passed\n");
+    return g_failed ? 1 : 0;
+}
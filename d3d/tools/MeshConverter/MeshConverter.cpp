@@ -0,0 +1,140 @@
+//---------------------------------------------------------------------------------------
+//
+// Converts the text models (Models/skull.txt, Models/car.txt) to binary mesh files,
+// see common/meshFile.h.
+//
+// Usage: MeshConverter input.txt output.mesh [-format pn|pnt] [-index32]
+//        MeshConverter input.txt output.msc -streamed [trianglesPerCluster] [-budget MB]
+//
+// pn stores Vertex::PosNormal vertices, pnt (the default) Vertex::Basic32 ones with
+// zero texture coordinates. Indices are 16 bits when the mesh allows it.
+//
+// -streamed writes a clustered mesh instead (common/streamingMesh.h), for the models
+// that do not fit in memory: the model is never loaded whole, the conversion uses
+// about the given budget (256 MB by default) whatever the size of the model.
+//
+//---------------------------------------------------------------------------------------
+
+#include "meshFile.h"
+#include "streamingMesh.h"
+#include "textMeshReader.h"
+#include "types.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    void PrintUsage()
+    {
+        printf("Usage: MeshConverter input.txt output.mesh [-format pn|pnt] [-index32]\n"
+               "       MeshConverter input.txt output.msc -streamed [trianglesPerCluster] [-budget MB]\n");
+    }
+
+    // Text model: vertex and triangle counts, then positions and normals,
+    // then the triangles.
+    bool ReadTextMesh(const char* fileName, std::vector<XMFLOAT3>* pPositions, std::vector<XMFLOAT3>* pNormals,
+        std::vector<uint32>* pIndices)
+    {
+        TextMeshReader reader;
+        if(!reader.Open(fileName) || !reader.VertexCount() || !reader.TriangleCount())
+            return false;
+
+        pPositions->resize(reader.VertexCount());
+        pNormals->resize(reader.VertexCount());
+        pIndices->resize(3 * reader.TriangleCount());
+        return reader.Read(&(*pPositions)[0], &(*pNormals)[0], sizeof(XMFLOAT3), &(*pIndices)[0]);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc < 3)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    uint32 vertexFormat = MESH_VERTEX_POSITION | MESH_VERTEX_NORMAL | MESH_VERTEX_TEXCOORD;
+    bool force32BitIndices = false;
+    bool streamed = false;
+    StreamingMeshSettings streamedSettings;
+
+    for(int a = 3; a < argc; ++a)
+    {
+        if(!strcmp(argv[a], "-index32"))
+            force32BitIndices = true;
+        else if(!strcmp(argv[a], "-streamed"))
+        {
+            streamed = true;
+            if(a + 1 < argc && argv[a + 1][0] != '-')
+                streamedSettings.TrianglesPerCluster = (uint32)strtoul(argv[++a], nullptr, 10);
+        }
+        else if(!strcmp(argv[a], "-budget") && a + 1 < argc)
+            streamedSettings.MemoryBudget = strtoull(argv[++a], nullptr, 10) * 1024 * 1024;
+        else if(!strcmp(argv[a], "-format") && a + 1 < argc)
+        {
+            ++a;
+            if(!strcmp(argv[a], "pn"))
+                vertexFormat = MESH_VERTEX_POSITION | MESH_VERTEX_NORMAL;
+            else if(!strcmp(argv[a], "pnt"))
+                vertexFormat = MESH_VERTEX_POSITION | MESH_VERTEX_NORMAL | MESH_VERTEX_TEXCOORD;
+            else
+            {
+                PrintUsage();
+                return 1;
+            }
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if(streamed)
+    {
+        StreamingMeshBuildStats stats;
+        if(!BuildStreamingMesh(argv[1], argv[2], streamedSettings, &stats))
+        {
+            printf("Can not convert %s to %s\n", argv[1], argv[2]);
+            return 1;
+        }
+
+        printf("%s: %u vertices, %u triangles, %u clusters (%u sorted runs, %.2f s)\n", argv[2], stats.VertexCount,
+            stats.TriangleCount, stats.ClusterCount, stats.SortRuns, stats.BuildTime);
+        return 0;
+    }
+
+    std::vector<XMFLOAT3> positions;
+    std::vector<XMFLOAT3> normals;
+    std::vector<uint32> indices;
+    if(!ReadTextMesh(argv[1], &positions, &normals, &indices))
+    {
+        printf("Can not read %s\n", argv[1]);
+        return 1;
+    }
+
+    // Interleave the vertex components in the order of the format.
+    uint32 vertexCount = (uint32)positions.size();
+    uint32 floatsPerVertex = MeshVertexStride(vertexFormat) / sizeof(float);
+
+    std::vector<float> vertices(vertexCount * floatsPerVertex, 0.0f);
+    for(uint32 i = 0; i < vertexCount; ++i)
+    {
+        float* v = &vertices[i * floatsPerVertex];
+        memcpy(v, &positions[i], sizeof(XMFLOAT3));
+        memcpy(v + 3, &normals[i], sizeof(XMFLOAT3));
+    }
+
+    if(!WriteMeshFile(argv[2], vertexFormat, vertexCount ? &vertices[0] : nullptr, vertexCount,
+        indices.empty() ? nullptr : &indices[0], (uint32)indices.size(), force32BitIndices))
+    {
+        printf("Can not write %s\n", argv[2]);
+        return 1;
+    }
+
+    printf("%s: %u vertices, %u triangles\n", argv[2], vertexCount, (uint32)indices.size() / 3);
+    return 0;
+}
@@ -0,0 +1,576 @@
+//---------------------------------------------------------------------------------------
+//
+// Compares the ways to load a model:
+//  - the std::ifstream >> loop the demos used to have,
+//  - TextMeshReader on the same text file (parallel parse of the mapped file),
+//  - MeshFile on the binary version of the model, when there is one.
+// It then welds the model (vertex counts before and after, time) and acquires it
+// for a number of scenes through MeshRegistry, printing what the sharing saved.
+// Last, it converts the model to a clustered mesh within a memory budget (in KB) and
+// picks it through a cluster cache holding a quarter of the clusters, checking the
+// hits against a brute force test of all the triangles.
+//
+// With -bounds, the box, oriented box and sphere of the vertices are computed with the
+// XNA::ComputeBounding*FromPoints functions and with the pointCloudBounds builders;
+// the positions are repeated n times to make a larger cloud (same bounds). Prints the
+// times, the volumes relative to the XNA ones and how far a point sticks out.
+//
+// With -collide other.txt, MeshBvh trees are built over both models and the other
+// model is dropped at random orientations and positions around the first one. Prints
+// the build times and the overlap and contact queries per second.
+//
+// Usage: MeshLoadBenchmark [model.txt] [-mesh model.mesh] [-runs n] [-threads n] [-scenes n]
+//                          [-weld position normal] [-budget KB] [-picks n] [-bounds [n]]
+//                          [-collide other.txt] [-queries n]
+//
+// Each loader runs n times, the best and the median times are printed. The text
+// loaders must produce the same vertices and indices.
+//
+//---------------------------------------------------------------------------------------
+
+#include "meshBvh.h"
+#include "meshFile.h"
+#include "meshRegistry.h"
+#include "meshWelder.h"
+#include "pointCloudBounds.h"
+#include "streamingMesh.h"
+#include "textMeshReader.h"
+#include "threadPool.h"
+#include "timer.h"
+#include "types.h"
+#include <algorithm>
+#include <cctype>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Same layout as Vertex::Basic32.
+    struct Vertex
+    {
+        XMFLOAT3 Pos;
+        XMFLOAT3 Normal;
+        XMFLOAT2 Tex;
+    };
+
+    struct Mesh
+    {
+        std::vector<Vertex> Vertices;
+        std::vector<uint32> Indices;
+    };
+
+    // The loop of the demos.
+    bool LoadWithStream(const char* fileName, Mesh* pMesh)
+    {
+        std::ifstream fin(fileName);
+        if(!fin.good())
+            return false;
+
+        uint32 vcount = 0;
+        uint32 tcount = 0;
+        std::string ignore;
+
+        fin >> ignore >> vcount;
+        fin >> ignore >> tcount;
+        fin >> ignore >> ignore >> ignore >> ignore;
+
+        pMesh->Vertices.resize(vcount);
+        for(uint32 i = 0; i < vcount; ++i)
+        {
+            fin >> pMesh->Vertices[i].Pos.x >> pMesh->Vertices[i].Pos.y >> pMesh->Vertices[i].Pos.z;
+            fin >> pMesh->Vertices[i].Normal.x >> pMesh->Vertices[i].Normal.y >> pMesh->Vertices[i].Normal.z;
+        }
+
+        fin >> ignore;
+        fin >> ignore;
+        fin >> ignore;
+
+        pMesh->Indices.resize(3 * tcount);
+        for(uint32 i = 0; i < tcount; ++i)
+            fin >> pMesh->Indices[i*3+0] >> pMesh->Indices[i*3+1] >> pMesh->Indices[i*3+2];
+
+        return !fin.fail();
+    }
+
+    bool LoadWithReader(const char* fileName, ThreadPool* pPool, Mesh* pMesh)
+    {
+        TextMeshReader reader;
+        if(!reader.Open(fileName))
+            return false;
+
+        pMesh->Vertices.resize(reader.VertexCount());
+        pMesh->Indices.resize(3 * reader.TriangleCount());
+        return reader.Read(&pMesh->Vertices[0].Pos, &pMesh->Vertices[0].Normal, sizeof(Vertex),
+            &pMesh->Indices[0], nullptr, pPool);
+    }
+
+    // Open and touch every vertex and index, as CreateBuffer would.
+    bool LoadWithMeshFile(const char* fileName, uint32* pChecksum)
+    {
+        MeshFile mesh;
+        if(!mesh.Open(fileName))
+            return false;
+
+        const uint8* vertices = reinterpret_cast<const uint8*>(mesh.Vertices());
+        uint32 checksum = 0;
+        for(uint32 i = 0; i < mesh.VertexCount() * mesh.VertexStride(); i += 64)
+            checksum += vertices[i];
+        for(uint32 i = 0; i < mesh.IndexCount(); i += 16)
+            checksum += mesh.Index(i);
+
+        *pChecksum = checksum;
+        return true;
+    }
+
+    // Best and median of the runs, in milliseconds.
+    float Report(const char* name, std::vector<float>& times)
+    {
+        std::sort(times.begin(), times.end());
+        printf("%-22s best %8.2f ms   median %8.2f ms\n", name, times.front(), times[times.size() / 2]);
+        return times.front();
+    }
+
+    // pBest, if given, receives the best time in milliseconds.
+    bool Run(const char* name, uint32 runs, const std::function<bool()>& load, float* pBest = nullptr)
+    {
+        Timer timer;
+        timer.Reset();
+
+        std::vector<float> times(runs);
+        for(uint32 r = 0; r < runs; ++r)
+        {
+            timer.Tick();
+            bool loaded = load();
+            timer.Tick();
+
+            if(!loaded)
+            {
+                printf("%s: loading failed\n", name);
+                return false;
+            }
+            times[r] = timer.DeltaTime() * 1000.0f;
+        }
+
+        float best = Report(name, times);
+        if(pBest)
+            *pBest = best;
+        return true;
+    }
+
+    // How far the farthest point is outside of the volume, 0 if they are all inside.
+    float Outside(const XNA::AxisAlignedBox& box, const std::vector<XMFLOAT3>& points)
+    {
+        float outside = 0.0f;
+        for(size_t i = 0; i < points.size(); ++i)
+        {
+            outside = std::max(outside, fabsf(points[i].x - box.Center.x) - box.Extents.x);
+            outside = std::max(outside, fabsf(points[i].y - box.Center.y) - box.Extents.y);
+            outside = std::max(outside, fabsf(points[i].z - box.Center.z) - box.Extents.z);
+        }
+        return outside;
+    }
+
+    float Outside(const XNA::OrientedBox& box, const std::vector<XMFLOAT3>& points)
+    {
+        // Points in the frame of the box.
+        XMVECTOR center = XMLoadFloat3(&box.Center);
+        XMVECTOR orientation = XMLoadFloat4(&box.Orientation);
+
+        std::vector<XMFLOAT3> local(points.size());
+        for(size_t i = 0; i < points.size(); ++i)
+            XMStoreFloat3(&local[i], XMVector3InverseRotate(XMLoadFloat3(&points[i]) - center, orientation));
+
+        XNA::AxisAlignedBox aligned;
+        aligned.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        aligned.Extents = box.Extents;
+        return Outside(aligned, local);
+    }
+
+    float Outside(const XNA::Sphere& sphere, const std::vector<XMFLOAT3>& points)
+    {
+        XMVECTOR center = XMLoadFloat3(&sphere.Center);
+
+        float outside = 0.0f;
+        for(size_t i = 0; i < points.size(); ++i)
+            outside = std::max(outside, XMVectorGetX(XMVector3Length(XMLoadFloat3(&points[i]) - center)) - sphere.Radius);
+        return outside;
+    }
+
+    float Volume(const XNA::AxisAlignedBox& box) { return 8.0f * box.Extents.x * box.Extents.y * box.Extents.z; }
+    float Volume(const XNA::OrientedBox& box) { return 8.0f * box.Extents.x * box.Extents.y * box.Extents.z; }
+    float Volume(const XNA::Sphere& sphere) { return 4.0f / 3.0f * XM_PI * sphere.Radius * sphere.Radius * sphere.Radius; }
+
+    void ReportBounds(const char* name, float volume, float reference, float outside)
+    {
+        printf("%-22s volume %12.2f   x%.3f of XNA   farthest point outside %g\n", name, volume, volume / reference,
+            outside);
+    }
+
+    // The XNA builders against the stream builders over the positions repeated copies times.
+    void RunBounds(const Mesh& mesh, uint32 copies, uint32 runs, ThreadPool* pPool)
+    {
+        std::vector<XMFLOAT3> points;
+        points.reserve(mesh.Vertices.size() * copies);
+        for(uint32 c = 0; c < copies; ++c)
+            for(size_t i = 0; i < mesh.Vertices.size(); ++i)
+                points.push_back(mesh.Vertices[i].Pos);
+
+        // The stream builders read structure of arrays.
+        uint32 count = (uint32)points.size();
+        std::vector<float> xs(count);
+        std::vector<float> ys(count);
+        std::vector<float> zs(count);
+        for(uint32 i = 0; i < count; ++i)
+        {
+            xs[i] = points[i].x;
+            ys[i] = points[i].y;
+            zs[i] = points[i].z;
+        }
+        XNA::PointStream stream = { &xs[0], &ys[0], &zs[0] };
+
+        printf("Bounds of %u points (%u copies)\n", count, copies);
+
+        XNA::AxisAlignedBox xnaBox;
+        XNA::AxisAlignedBox streamBox;
+        XNA::OrientedBox xnaOriented;
+        XNA::OrientedBox streamOriented;
+        XNA::Sphere xnaSphere;
+        XNA::Sphere ritterSphere;
+        XNA::Sphere refinedSphere;
+        XNA::Sphere exactSphere;
+
+        Run("box, XNA", runs, [&]()
+        {
+            XNA::ComputeBoundingAxisAlignedBoxFromPoints(&xnaBox, count, &points[0], sizeof(XMFLOAT3));
+            return true;
+        });
+        Run("box, stream", runs, [&]()
+        {
+            XNA::ComputeBoundingAxisAlignedBoxFromPointStream(&streamBox, count, &stream, pPool);
+            return true;
+        });
+        Run("oriented box, XNA", runs, [&]()
+        {
+            XNA::ComputeBoundingOrientedBoxFromPoints(&xnaOriented, count, &points[0], sizeof(XMFLOAT3));
+            return true;
+        });
+        Run("oriented box, stream", runs, [&]()
+        {
+            XNA::ComputeBoundingOrientedBoxFromPointStream(&streamOriented, count, &stream, pPool);
+            return true;
+        });
+        Run("sphere, XNA", runs, [&]()
+        {
+            XNA::ComputeBoundingSphereFromPoints(&xnaSphere, count, &points[0], sizeof(XMFLOAT3));
+            return true;
+        });
+        Run("sphere, Ritter", runs, [&]()
+        {
+            XNA::ComputeBoundingSphereFromPointStream(&ritterSphere, count, &stream, XNA::SPHERE_FIT_RITTER, pPool);
+            return true;
+        });
+        Run("sphere, refined", runs, [&]()
+        {
+            XNA::ComputeBoundingSphereFromPointStream(&refinedSphere, count, &stream, XNA::SPHERE_FIT_RITTER_REFINED, pPool);
+            return true;
+        });
+        Run("sphere, exact", runs, [&]()
+        {
+            XNA::ComputeBoundingSphereFromPointStream(&exactSphere, count, &stream, XNA::SPHERE_FIT_EXACT, pPool);
+            return true;
+        });
+
+        // The copies do not change the bounds, the checks read the model once.
+        points.resize(mesh.Vertices.size());
+
+        ReportBounds("box, XNA", Volume(xnaBox), Volume(xnaBox), Outside(xnaBox, points));
+        ReportBounds("box, stream", Volume(streamBox), Volume(xnaBox), Outside(streamBox, points));
+        ReportBounds("oriented box, XNA", Volume(xnaOriented), Volume(xnaOriented), Outside(xnaOriented, points));
+        ReportBounds("oriented box, stream", Volume(streamOriented), Volume(xnaOriented), Outside(streamOriented, points));
+        ReportBounds("sphere, XNA", Volume(xnaSphere), Volume(xnaSphere), Outside(xnaSphere, points));
+        ReportBounds("sphere, Ritter", Volume(ritterSphere), Volume(xnaSphere), Outside(ritterSphere, points));
+        ReportBounds("sphere, refined", Volume(refinedSphere), Volume(xnaSphere), Outside(refinedSphere, points));
+        ReportBounds("sphere, exact", Volume(exactSphere), Volume(xnaSphere), Outside(exactSphere, points));
+    }
+
+    // Random placements of mesh B around mesh A, which stays at the origin. False if
+    // the two queries disagree.
+    bool RunCollide(const Mesh& meshA, const Mesh& meshB, uint32 queries, uint32 runs)
+    {
+        MeshBvh bvhA;
+        MeshBvh bvhB;
+        Run("BVH build, A", runs, [&]()
+        {
+            bvhA.Build(&meshA.Vertices[0].Pos, sizeof(Vertex), (uint32)meshA.Vertices.size(), &meshA.Indices[0],
+                (uint32)meshA.Indices.size() / 3);
+            return true;
+        });
+        Run("BVH build, B", runs, [&]()
+        {
+            bvhB.Build(&meshB.Vertices[0].Pos, sizeof(Vertex), (uint32)meshB.Vertices.size(), &meshB.Indices[0],
+                (uint32)meshB.Indices.size() / 3);
+            return true;
+        });
+        printf("  %u and %u triangles, %u and %u nodes\n", bvhA.TriangleCount(), bvhB.TriangleCount(),
+            bvhA.NodeCount(), bvhB.NodeCount());
+
+        XNA::AxisAlignedBox boxA;
+        XNA::AxisAlignedBox boxB;
+        XNA::ComputeBoundingAxisAlignedBoxFromPoints(&boxA, (uint32)meshA.Vertices.size(), &meshA.Vertices[0].Pos,
+            sizeof(Vertex));
+        XNA::ComputeBoundingAxisAlignedBoxFromPoints(&boxB, (uint32)meshB.Vertices.size(), &meshB.Vertices[0].Pos,
+            sizeof(Vertex));
+
+        // The center of B anywhere in the box of A grown by the radius of B, so part
+        // of the placements miss and part go through the middle of A.
+        float radiusB = XMVectorGetX(XMVector3Length(XMLoadFloat3(&boxB.Extents)));
+        XMMATRIX worldA = XMMatrixIdentity();
+
+        std::vector<MeshBvh::RelativeTransform> placements(queries);
+        srand(2);
+        for(uint32 q = 0; q < queries; ++q)
+        {
+            float u[6];
+            for(uint32 k = 0; k < 6; ++k)
+                u[k] = rand() / (float)RAND_MAX * 2.0f - 1.0f;
+
+            XMMATRIX worldB = XMMatrixTranslation(-boxB.Center.x, -boxB.Center.y, -boxB.Center.z) *
+                XMMatrixRotationRollPitchYaw(u[0] * XM_PI, u[1] * XM_PI, u[2] * XM_PI) *
+                XMMatrixTranslation(boxA.Center.x + u[3] * (boxA.Extents.x + radiusB),
+                                    boxA.Center.y + u[4] * (boxA.Extents.y + radiusB),
+                                    boxA.Center.z + u[5] * (boxA.Extents.z + radiusB));
+            placements[q] = MeshBvh::ComputeRelativeTransform(worldA, worldB);
+        }
+
+        uint32 overlaps = 0;
+        float overlapTime = 0.0f;
+        Run("BVH overlaps", runs, [&]()
+        {
+            overlaps = 0;
+            for(uint32 q = 0; q < queries; ++q)
+                overlaps += MeshBvh::Overlaps(bvhA, bvhB, placements[q]);
+            return true;
+        }, &overlapTime);
+
+        std::vector<MeshBvh::TrianglePair> pairs;
+        uint32 touching = 0;
+        uint64 contacts = 0;
+        float contactTime = 0.0f;
+        Run("BVH contacts", runs, [&]()
+        {
+            touching = 0;
+            contacts = 0;
+            for(uint32 q = 0; q < queries; ++q)
+            {
+                uint32 found = MeshBvh::CollectContacts(bvhA, bvhB, placements[q], pairs);
+                touching += found > 0;
+                contacts += found;
+            }
+            return true;
+        }, &contactTime);
+
+        printf("  %u placements, %u overlap, %llu contacting pairs%s\n", queries, overlaps, contacts,
+            touching == overlaps ? "" : " (error: Overlaps and CollectContacts disagree)");
+        printf("  %.0f Overlaps/s, %.0f CollectContacts/s\n", queries * 1000.0f / std::max(overlapTime, 1e-3f),
+            queries * 1000.0f / std::max(contactTime, 1e-3f));
+        return touching == overlaps;
+    }
+
+    // Nearest hit of the ray among all the triangles, FLT_MAX if none.
+    float PickBruteForce(const Mesh& mesh, FXMVECTOR rayOrigin, FXMVECTOR rayDir)
+    {
+        float nearest = FLT_MAX;
+        for(size_t i = 0; i < mesh.Indices.size(); i += 3)
+        {
+            XMVECTOR v0 = XMLoadFloat3(&mesh.Vertices[mesh.Indices[i]].Pos);
+            XMVECTOR v1 = XMLoadFloat3(&mesh.Vertices[mesh.Indices[i+1]].Pos);
+            XMVECTOR v2 = XMLoadFloat3(&mesh.Vertices[mesh.Indices[i+2]].Pos);
+
+            float t = 0.0f;
+            if(XNA::IntersectRayTriangle(rayOrigin, rayDir, v0, v1, v2, &t) && t < nearest)
+                nearest = t;
+        }
+        return nearest;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string textFile = "../../topics/Camera/Models/skull.txt";
+    std::string meshFile = "../../topics/Camera/Models/skull.mesh";
+    uint32 runs = 10;
+    uint32 threads = 0;
+    uint32 scenes = 5;
+    WeldTolerance weld = { 0.0f, 0.0f };
+    uint32 budget = 1024;
+    uint32 picks = 100;
+    uint32 boundsCopies = 0;
+    std::string collideFile;
+    uint32 queries = 1000;
+
+    for(int a = 1; a < argc; ++a)
+    {
+        if(!strcmp(argv[a], "-mesh") && a + 1 < argc)
+            meshFile = argv[++a];
+        else if(!strcmp(argv[a], "-runs") && a + 1 < argc)
+            runs = std::max(1u, (uint32)strtoul(argv[++a], nullptr, 10));
+        else if(!strcmp(argv[a], "-threads") && a + 1 < argc)
+            threads = (uint32)strtoul(argv[++a], nullptr, 10);
+        else if(!strcmp(argv[a], "-scenes") && a + 1 < argc)
+            scenes = (uint32)strtoul(argv[++a], nullptr, 10);
+        else if(!strcmp(argv[a], "-weld") && a + 2 < argc)
+        {
+            weld.Position = (float)atof(argv[++a]);
+            weld.Normal = (float)atof(argv[++a]);
+        }
+        else if(!strcmp(argv[a], "-budget") && a + 1 < argc)
+            budget = (uint32)strtoul(argv[++a], nullptr, 10);
+        else if(!strcmp(argv[a], "-picks") && a + 1 < argc)
+            picks = (uint32)strtoul(argv[++a], nullptr, 10);
+        else if(!strcmp(argv[a], "-bounds"))
+        {
+            boundsCopies = 1;
+            if(a + 1 < argc && isdigit((unsigned char)argv[a + 1][0]))
+                boundsCopies = std::max(1u, (uint32)strtoul(argv[++a], nullptr, 10));
+        }
+        else if(!strcmp(argv[a], "-collide") && a + 1 < argc)
+            collideFile = argv[++a];
+        else if(!strcmp(argv[a], "-queries") && a + 1 < argc)
+            queries = std::max(1u, (uint32)strtoul(argv[++a], nullptr, 10));
+        else if(argv[a][0] != '-')
+            textFile = argv[a];
+        else
+        {
+            printf("Usage: MeshLoadBenchmark [model.txt] [-mesh model.mesh] [-runs n] [-threads n] [-scenes n]\n"
+                   "                         [-weld position normal] [-budget KB] [-picks n] [-bounds [n]]\n"
+                   "                         [-collide other.txt] [-queries n]\n");
+            return 1;
+        }
+    }
+
+    ThreadPool pool(threads);
+    printf("%s, %u runs, %u worker threads\n", textFile.c_str(), runs, pool.ThreadCount());
+
+    Mesh streamMesh;
+    Mesh readerMesh;
+    if(!Run("ifstream >>", runs, [&]() { return LoadWithStream(textFile.c_str(), &streamMesh); }) ||
+       !Run("TextMeshReader", runs, [&]() { return LoadWithReader(textFile.c_str(), &pool, &readerMesh); }))
+        return 1;
+
+    // Both parse to the nearest float, the results must be identical.
+    bool same = streamMesh.Vertices.size() == readerMesh.Vertices.size() && streamMesh.Indices == readerMesh.Indices;
+    for(size_t i = 0; same && i < streamMesh.Vertices.size(); ++i)
+        same = !memcmp(&streamMesh.Vertices[i], &readerMesh.Vertices[i], 2 * sizeof(XMFLOAT3));
+
+    printf("%u vertices, %u triangles, %s\n", (uint32)readerMesh.Vertices.size(), (uint32)readerMesh.Indices.size() / 3,
+        same ? "identical results" : "error: the loaders differ");
+
+    uint32 checksum = 0;
+    if(!Run("MeshFile (binary)", runs, [&]() { return LoadWithMeshFile(meshFile.c_str(), &checksum); }))
+        printf("(no binary model at %s, build the Camera demo or run MeshConverter)\n", meshFile.c_str());
+
+    WeldedMesh welded;
+    Run("WeldVertices", runs, [&]()
+    {
+        WeldVertices(&readerMesh.Vertices[0].Pos, &readerMesh.Vertices[0].Normal, sizeof(Vertex),
+            (uint32)readerMesh.Vertices.size(), &readerMesh.Indices[0], (uint32)readerMesh.Indices.size() / 3, weld, &welded);
+        return true;
+    });
+    printf("  tolerance %g / %g: %u -> %u vertices, %u -> %u triangles (%u degenerate)\n", weld.Position, weld.Normal,
+        (uint32)readerMesh.Vertices.size(), (uint32)welded.Source.size(), (uint32)readerMesh.Indices.size() / 3,
+        (uint32)welded.Indices.size() / 3, welded.DegenerateTriangles);
+
+    if(boundsCopies)
+        RunBounds(readerMesh, boundsCopies, runs, &pool);
+
+    if(!collideFile.empty())
+    {
+        Mesh otherMesh;
+        if(!LoadWithReader(collideFile.c_str(), &pool, &otherMesh))
+        {
+            printf("%s: loading failed\n", collideFile.c_str());
+            return 1;
+        }
+        printf("Collisions with %s\n", collideFile.c_str());
+        if(!RunCollide(readerMesh, otherMesh, queries, runs))
+            return 1;
+    }
+
+    // Every scene keeps its mesh, as the demos do.
+    MeshRegistry registry;
+    std::vector<MeshAssetPtr> sceneMeshes;
+    for(uint32 s = 0; s < scenes; ++s)
+    {
+        sceneMeshes.push_back(registry.Acquire(textFile.c_str(), &pool));
+        if(!sceneMeshes.back())
+        {
+            printf("MeshRegistry: loading failed\n");
+            return 1;
+        }
+    }
+
+    MeshRegistry::Stats stats = registry.GetStats();
+    printf("MeshRegistry, %u scenes: %u loads, %u hits, %u live meshes (%.2f MB)\n", scenes, stats.Loads, stats.Hits,
+        stats.LiveMeshes, stats.LiveBytes / (1024.0 * 1024.0));
+    printf("  saved %.2f MB and %.2f ms of parsing\n", stats.BytesSaved / (1024.0 * 1024.0),
+        stats.LoadTimeSaved * 1000.0f);
+
+    const char* clusteredFile = "MeshLoadBenchmark.msc";
+    StreamingMeshSettings settings;
+    settings.TrianglesPerCluster = 1024;
+    settings.MemoryBudget = (uint64)budget * 1024;
+
+    StreamingMeshBuildStats buildStats;
+    StreamingMesh streamingMesh;
+    if(!BuildStreamingMesh(textFile.c_str(), clusteredFile, settings, &buildStats) || !streamingMesh.Open(clusteredFile))
+    {
+        printf("StreamingMesh: conversion failed\n");
+        return 1;
+    }
+
+    printf("StreamingMesh, %u KB budget: %u clusters, %u sorted runs, %llu vertex pages read, %.2f ms\n", budget,
+        buildStats.ClusterCount, buildStats.SortRuns, buildStats.VertexPageReads, buildStats.BuildTime * 1000.0f);
+
+    uint64 clusterBytes = streamingMesh.Header().DirectoryOffset - sizeof(StreamingMeshHeader);
+    MeshClusterCache cache(streamingMesh, clusterBytes / 4);
+
+    // Rays from the front of the box toward its back face.
+    XNA::AxisAlignedBox box = streamingMesh.Bounds();
+    uint32 agree = 0;
+    uint32 hits = 0;
+    srand(1);
+    for(uint32 p = 0; p < picks; ++p)
+    {
+        float u = rand() / (float)RAND_MAX * 2.0f - 1.0f;
+        float v = rand() / (float)RAND_MAX * 2.0f - 1.0f;
+        XMVECTOR rayOrigin = XMVectorSet(box.Center.x + u * box.Extents.x, box.Center.y + v * box.Extents.y,
+            box.Center.z - 2.0f * box.Extents.z - 1.0f, 1.0f);
+        XMVECTOR rayDir = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+
+        float dist = FLT_MAX;
+        uint32 cluster = 0;
+        uint32 triangle = 0;
+        if(cache.Pick(rayOrigin, rayDir, &dist, &cluster, &triangle))
+            ++hits;
+
+        agree += dist == PickBruteForce(readerMesh, rayOrigin, rayDir);
+    }
+
+    MeshClusterCache::Stats cacheStats = cache.GetStats();
+    printf("  %u picks, %u hits, %u agree with the brute force test\n", picks, hits, agree);
+    printf("  cache: %llu hits, %llu misses, %llu evictions, %u resident clusters (%.2f of %.2f MB)\n",
+        cacheStats.Hits, cacheStats.Misses, cacheStats.Evictions, cacheStats.ResidentValues,
+        cacheStats.ResidentBytes / (1024.0 * 1024.0), clusterBytes / (1024.0 * 1024.0));
+
+    streamingMesh.Close();
+    remove(clusteredFile);
+
+    return same && agree == picks ? 0 : 1;
+}
@@ -18,10 +18,10 @@
 #include "effects.h"
 #include "renderStates.h"
 #include "vertex.h"
+#include "meshFile.h"
 #include <d3dcompiler.h>
 #include <iostream>
 #include <sstream>
-#include <fstream>
 #include <vector>
 
 class CameraApp : public TopicApp
@@ -83,6 +83,7 @@ private:
 	uint32 m_cylinderIndexCount;
 
 	uint32 m_skullIndexCount;
+    DXGI_FORMAT m_skullIndexFormat;
 
 	uint32 m_lightCount;
 };
@@ -111,6 +112,7 @@ CameraApp::CameraApp(HINSTANCE hInstance)
 , m_stoneTexSRV(nullptr)
 , m_brickTexSRV(nullptr)
 , m_skullIndexCount(0)
+, m_skullIndexFormat(DXGI_FORMAT_R32_UINT)
 , m_lightCount(3)
 {
     m_windowCaption = "Camera Demo";
@@ -198,56 +200,33 @@ void CameraApp::InitGeometryBuffers()
 
 void CameraApp::BuildSkullBuffers()
 {
-    std::ifstream fin("Models/skull.txt");
-    OC_ASSERT(fin.good());
+    // Binary model, converted from Models/skull.txt by tools/MeshConverter when
+    // the project builds. The buffers are created straight from the mapped file.
+    MeshFile mesh;
+    bool opened = mesh.Open("Models/skull.mesh");
+    OC_ASSERT(opened && mesh.VertexStride() == sizeof(Vertex::Basic32));
 
-	UINT vcount = 0;
-	UINT tcount = 0;
-	std::string ignore;
-
-	fin >> ignore >> vcount;
-	fin >> ignore >> tcount;
-	fin >> ignore >> ignore >> ignore >> ignore;
-	
-	std::vector<Vertex::Basic32> vertices(vcount);
-	for(UINT i = 0; i < vcount; ++i)
-	{
-		fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-		fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
-	}
-
-	fin >> ignore;
-	fin >> ignore;
-	fin >> ignore;
-
-    m_skullIndexCount = 3*tcount;
-	std::vector<UINT> indices(m_skullIndexCount);
-	for(UINT i = 0; i < tcount; ++i)
-	{
-		fin >> indices[i*3+0] >> indices[i*3+1] >> indices[i*3+2];
-	}
-
-	fin.close();
+    m_skullIndexCount = mesh.IndexCount();
+    m_skullIndexFormat = mesh.IndexSize() == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 
     D3D11_BUFFER_DESC vbd;
     vbd.Usage = D3D11_USAGE_IMMUTABLE;
-	vbd.ByteWidth = sizeof(Vertex::Basic32) * vcount;
+	vbd.ByteWidth = mesh.VertexStride() * mesh.VertexCount();
     vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
     vbd.CPUAccessFlags = 0;
     vbd.MiscFlags = 0;
     D3D11_SUBRESOURCE_DATA vinitData;
-    vinitData.pSysMem = &vertices[0];
+    vinitData.pSysMem = mesh.Vertices();
     HR(m_dxDevice->CreateBuffer(&vbd, &vinitData, m_skullVB.GetAddressOf()));
 
-	// Pack the indices of all the meshes into one index buffer.
 	D3D11_BUFFER_DESC ibd;
     ibd.Usage = D3D11_USAGE_IMMUTABLE;
-    ibd.ByteWidth = sizeof(UINT) * m_skullIndexCount;
+    ibd.ByteWidth = mesh.IndexSize() * m_skullIndexCount;
     ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
     ibd.CPUAccessFlags = 0;
     ibd.MiscFlags = 0;
     D3D11_SUBRESOURCE_DATA iinitData;
-	iinitData.pSysMem = &indices[0];
+	iinitData.pSysMem = mesh.Indices();
     HR(m_dxDevice->CreateBuffer(&ibd, &iinitData, m_skullIB.GetAddressOf()));
 }
 
@@ -513,7 +492,7 @@ void CameraApp::DrawScene()
         ID3DX11EffectPass* pass = activeSkullTech->GetPassByIndex( p );
 
         m_dxImmediateContext->IASetVertexBuffers(0, 1, m_skullVB.GetAddressOf(), &stride, &offset);
-        m_dxImmediateContext->IASetIndexBuffer(m_skullIB.Get(), DXGI_FORMAT_R32_UINT, 0);
+        m_dxImmediateContext->IASetIndexBuffer(m_skullIB.Get(), m_skullIndexFormat, 0);
 
         XMMATRIX world = XMLoadFloat4x4(&m_skullWorld);
         XMMATRIX worldInvTranspose = MathHelper::InverseTranspose(world);
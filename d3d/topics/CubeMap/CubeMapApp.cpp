@@ -18,11 +18,11 @@
 #include "effects.h"
 #include "renderStates.h"
 #include "vertex.h"
+#include "meshRegistry.h"
 #include "sky.h"
 #include <d3dcompiler.h>
 #include <iostream>
 #include <sstream>
-#include <fstream>
 #include <vector>
 
 class CubeMapApp : public TopicApp
@@ -37,12 +37,14 @@ public:
 
 private:
 
+    virtual void RequestAssets();
     virtual void InitGeometryBuffers();
 	virtual void InitFX();
 	virtual void InitVertexLayout();
 
     void BuildShapeBuffers();
-	void BuildSkullBuffers();
+	void BuildSkullBuffers(const MeshAssetPtr& skull);
+    void CreateTexture(const AssetLoader::FileDataPtr& data, ComPtr<ID3D11ShaderResourceView>* pSRV);
 
     std::unique_ptr<Sky> m_sky;
 
@@ -51,6 +53,7 @@ private:
 
     ComPtr<ID3D11Buffer>           m_skullVB;
     ComPtr<ID3D11Buffer>           m_skullIB;
+    MeshAssetPtr                   m_skull;
 
     ComPtr<ID3D11Buffer>           m_skySphereVB;
     ComPtr<ID3D11Buffer>           m_skySphereIB;
@@ -202,44 +205,39 @@ bool CubeMapApp::Init()
 	return true;
 }
 
+void CubeMapApp::RequestAssets()
+{
+    // Read and parsed by the workers while the shapes and the effects are
+    // built, the callbacks create the device objects.
+    Effects::LoadAll(m_assets);
+
+    m_assets.LoadMesh("Models/skull.txt", [this](const MeshAssetPtr& skull) { BuildSkullBuffers(skull); });
+
+    m_assets.LoadFile("Textures/floor.dds",
+        [this](const AssetLoader::FileDataPtr& data) { CreateTexture(data, &m_floorTexSRV); });
+    m_assets.LoadFile("Textures/stone.dds",
+        [this](const AssetLoader::FileDataPtr& data) { CreateTexture(data, &m_stoneTexSRV); });
+    m_assets.LoadFile("Textures/bricks.dds",
+        [this](const AssetLoader::FileDataPtr& data) { CreateTexture(data, &m_brickTexSRV); });
+}
+
 void CubeMapApp::InitGeometryBuffers()
 {
     BuildShapeBuffers();
-    BuildSkullBuffers();
 }
 
-void CubeMapApp::BuildSkullBuffers()
+void CubeMapApp::BuildSkullBuffers(const MeshAssetPtr& skull)
 {
-    std::ifstream fin("Models/skull.txt");
-    OC_ASSERT(fin.good());
-
-	UINT vcount = 0;
-	UINT tcount = 0;
-	std::string ignore;
+    // Shared with the other scenes of the process that use the same model.
+    m_skull = skull;
+    OC_ASSERT(m_skull);
 
-	fin >> ignore >> vcount;
-	fin >> ignore >> tcount;
-	fin >> ignore >> ignore >> ignore >> ignore;
+	UINT vcount = m_skull->VertexCount();
 	
-	std::vector<Vertex::Basic32> vertices(vcount);
-	for(UINT i = 0; i < vcount; ++i)
-	{
-		fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-		fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
-	}
-
-	fin >> ignore;
-	fin >> ignore;
-	fin >> ignore;
+	std::vector<Vertex::Basic32> vertices;
+    CopyMeshVertices(*m_skull, &vertices);
 
-    m_skullIndexCount = 3*tcount;
-	std::vector<UINT> indices(m_skullIndexCount);
-	for(UINT i = 0; i < tcount; ++i)
-	{
-		fin >> indices[i*3+0] >> indices[i*3+1] >> indices[i*3+2];
-	}
-
-	fin.close();
+	m_skullIndexCount = m_skull->IndexCount();
 
     D3D11_BUFFER_DESC vbd;
     vbd.Usage = D3D11_USAGE_IMMUTABLE;
@@ -259,7 +257,7 @@ void CubeMapApp::BuildSkullBuffers()
     ibd.CPUAccessFlags = 0;
     ibd.MiscFlags = 0;
     D3D11_SUBRESOURCE_DATA iinitData;
-	iinitData.pSysMem = &indices[0];
+	iinitData.pSysMem = &m_skull->Indices[0];
     HR(m_dxDevice->CreateBuffer(&ibd, &iinitData, m_skullIB.GetAddressOf()));
 }
 
@@ -370,20 +368,18 @@ void CubeMapApp::BuildShapeBuffers()
 void CubeMapApp::InitFX()
 {
     // Must init Effects first since InputLayouts depend on shader signatures.
-	Effects::InitAll(m_dxDevice.Get());
+	Effects::InitAll(m_dxDevice.Get(), m_assets);
 	InputLayouts::InitAll(m_dxDevice.Get());
 	RenderStates::InitAll(m_dxDevice.Get());
 
     m_sky.reset(new Sky(m_dxDevice.Get(), "Textures/grasscube1024.dds", 5000.0f));
+}
 
-	HR(D3DX11CreateShaderResourceViewFromFile(m_dxDevice.Get(), 
-        "Textures/floor.dds", 0, 0, m_floorTexSRV.GetAddressOf(), 0 ));
-
-    HR(D3DX11CreateShaderResourceViewFromFile(m_dxDevice.Get(), 
-        "Textures/stone.dds", 0, 0, m_stoneTexSRV.GetAddressOf(), 0 ));
-
-    HR(D3DX11CreateShaderResourceViewFromFile(m_dxDevice.Get(), 
-        "Textures/bricks.dds", 0, 0, m_brickTexSRV.GetAddressOf(), 0 ));
+void CubeMapApp::CreateTexture(const AssetLoader::FileDataPtr& data, ComPtr<ID3D11ShaderResourceView>* pSRV)
+{
+    OC_ASSERT(data);
+    HR(D3DX11CreateShaderResourceViewFromMemory(m_dxDevice.Get(), &(*data)[0], data->size(),
+        0, 0, pSRV->GetAddressOf(), 0));
 }
 
 void CubeMapApp::InitVertexLayout() { }
@@ -1,33 +1,23 @@
 
 #include "effects.h"
+#include "assetLoader.h"
 #include "config.h"
-#include <vector>
-#include <fstream>
+#include "effectCache.h"
+#include "threadPool.h"
 
-Effect::Effect(ID3D11Device* device, const std::string& filename)
+Effect::Effect(ID3D11Device* device, const std::vector<uint8>& compiledShader)
 : m_fx(nullptr)
 {
-	std::ifstream fin(filename, std::ios::binary);
-    OC_ASSERT(fin.good());
-
-	fin.seekg(0, std::ios_base::end);
-	int size = (int)fin.tellg();
-	fin.seekg(0, std::ios_base::beg);
-	std::vector<char> compiledShader(size);
-
-	fin.read(&compiledShader[0], size);
-	fin.close();
-	
-	HR(D3DX11CreateEffectFromMemory(&compiledShader[0], size, 
-        0, device, m_fx.GetAddressOf()));
+	// Clone of the effect when another wrapper of the process loaded it.
+	HR(EffectCache::Shared().Create(device, compiledShader, m_fx.GetAddressOf()));
 }
 
 Effect::~Effect()
 {
 }
 
-BasicEffect::BasicEffect(ID3D11Device* device, const std::string& filename)
-: Effect(device, filename)
+BasicEffect::BasicEffect(ID3D11Device* device, const std::vector<uint8>& compiledShader)
+: Effect(device, compiledShader)
 {
 	Light1Tech    = m_fx->GetTechniqueByName("Light1");
 	Light2Tech    = m_fx->GetTechniqueByName("Light2");
@@ -105,8 +95,8 @@ BasicEffect::~BasicEffect()
 
 std::unique_ptr<BasicEffect> Effects::BasicFX = nullptr;
 
-SkyEffect::SkyEffect(ID3D11Device* device, const std::string& filename)
-	: Effect(device, filename)
+SkyEffect::SkyEffect(ID3D11Device* device, const std::vector<uint8>& compiledShader)
+	: Effect(device, compiledShader)
 {
 	SkyTech       = m_fx->GetTechniqueByName("SkyTech");
 	WorldViewProj = m_fx->GetVariableByName("gWorldViewProj")->AsMatrix();
@@ -119,14 +109,36 @@ SkyEffect::~SkyEffect()
 
 std::unique_ptr<SkyEffect> Effects::SkyFX = nullptr;
 
-void Effects::InitAll(ID3D11Device* device)
+void Effects::LoadAll(AssetLoader& assets)
 {
-    BasicFX.reset(new BasicEffect(device, "FX/Basic.fxo"));
-    SkyFX.reset(new SkyEffect(device, "FX/Sky.fxo"));
+    assets.LoadFile("FX/Basic.fxo");
+    assets.LoadFile("FX/Sky.fxo");
+}
+
+void Effects::InitAll(ID3D11Device* device, AssetLoader& assets)
+{
+    // Wait for the files here: the loads run on the shared pool too, a task
+    // of the pool must not block on them.
+    AssetLoader::FileDataPtr basic = assets.LoadFile("FX/Basic.fxo").get();
+    OC_ASSERT(basic);
+    AssetLoader::FileDataPtr sky = assets.LoadFile("FX/Sky.fxo").get();
+    OC_ASSERT(sky);
+
+    // The effects are independent and the device is free threaded, create
+    // them concurrently.
+    ThreadPool::Task tasks[2] =
+    {
+        [device, &basic]() { BasicFX.reset(new BasicEffect(device, *basic)); },
+        [device, &sky]() { SkyFX.reset(new SkyEffect(device, *sky)); },
+    };
+    ThreadPool::Shared().RunAll(tasks, 2);
 }
 
 void Effects::DestroyAll()
 {
     BasicFX.reset(nullptr);
     SkyFX.reset(nullptr);
+
+    // The cached masters hold the device.
+    EffectCache::Shared().Clear();
 }
\ No newline at end of file
@@ -18,11 +18,13 @@
 #include "effects.h"
 #include "renderStates.h"
 #include "vertex.h"
+#include "meshRegistry.h"
 #include "sky.h"
+#include "xnacollision.h"
+#include "collisionBatch.h"
 #include <d3dcompiler.h>
 #include <iostream>
 #include <sstream>
-#include <fstream>
 #include <vector>
 
 class DynamicCubeMapApp : public TopicApp
@@ -37,17 +39,23 @@ public:
 
 private:
 
+    virtual void RequestAssets();
     virtual void InitGeometryBuffers();
 	virtual void InitFX();
 	virtual void InitVertexLayout();
 
     void BuildShapeBuffers();
-	void BuildSkullBuffers();
+	void BuildSkullBuffers(const MeshAssetPtr& skull);
+    void CreateTexture(const AssetLoader::FileDataPtr& data, ComPtr<ID3D11ShaderResourceView>* pSRV);
 
     void BuildCubeFaceCamera(float x, float y, float z);
     void BuildDynamicCubeMapViews();
 
-    void DrawScene(const Camera& camera, bool drawSkull);
+    void UpdateObjectBounds(uint32 object, const XNA::AxisAlignedBox& localBox, CXMMATRIX world);
+    void CullViews();
+    bool IsVisible(uint32 object, uint32 view) const { return (m_viewMasks[object] & (1u << view)) != 0; }
+
+    void DrawScene(const Camera& camera, uint32 viewIndex, bool drawCenterSphere);
 
     std::unique_ptr<Sky> m_sky;
 
@@ -56,6 +64,7 @@ private:
 
     ComPtr<ID3D11Buffer>           m_skullVB;
     ComPtr<ID3D11Buffer>           m_skullIB;
+    MeshAssetPtr                   m_skull;
 
     ComPtr<ID3D11Buffer>           m_skySphereVB;
     ComPtr<ID3D11Buffer>           m_skySphereIB;
@@ -107,6 +116,42 @@ private:
 	uint32 m_skullIndexCount;
 
 	uint32 m_lightCount;
+
+    // Culling. Every drawn object has a slot in the bounds arrays and a mask
+    // with one bit per view (cube map faces then main camera), filled by a
+    // single pass over all the views.
+    enum
+    {
+        SkullObject = 0,
+        GridObject,
+        BoxObject,
+        CylinderObject0,
+        SphereObject0 = CylinderObject0 + 10,
+        CenterSphereObject = SphereObject0 + 10,
+        ObjectCount
+    };
+
+    enum
+    {
+        MainView = 6,
+        ViewCount
+    };
+
+    XNA::AxisAlignedBox m_skullBox;
+    XNA::AxisAlignedBox m_gridBox;
+    XNA::AxisAlignedBox m_boxBox;
+    XNA::AxisAlignedBox m_sphereBox;
+    XNA::AxisAlignedBox m_cylinderBox;
+
+    // World space boxes as structure of arrays for the batch tests.
+    float m_boundsCenterX[ObjectCount];
+    float m_boundsCenterY[ObjectCount];
+    float m_boundsCenterZ[ObjectCount];
+    float m_boundsExtentX[ObjectCount];
+    float m_boundsExtentY[ObjectCount];
+    float m_boundsExtentZ[ObjectCount];
+
+    uint32 m_viewMasks[ObjectCount];
 };
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
@@ -150,6 +195,12 @@ DynamicCubeMapApp::DynamicCubeMapApp(HINSTANCE hInstance)
         m_dynamicCubeMapRTV[i] = nullptr;
 	}
 
+    // Draw everything until the first culling pass.
+    for(int i = 0; i < ObjectCount; ++i)
+	{
+        m_viewMasks[i] = (1u << ViewCount) - 1;
+	}
+
 	XMMATRIX I = XMMatrixIdentity();
     XMStoreFloat4x4(&m_gridWorld, I);
 
@@ -232,12 +283,81 @@ bool DynamicCubeMapApp::Init()
 	return true;
 }
 
+void DynamicCubeMapApp::RequestAssets()
+{
+    // Read and parsed by the workers while the shapes and the effects are
+    // built, the callbacks create the device objects.
+    Effects::LoadAll(m_assets);
+
+    m_assets.LoadMesh("Models/skull.txt", [this](const MeshAssetPtr& skull) { BuildSkullBuffers(skull); });
+
+    m_assets.LoadFile("Textures/floor.dds",
+        [this](const AssetLoader::FileDataPtr& data) { CreateTexture(data, &m_floorTexSRV); });
+    m_assets.LoadFile("Textures/stone.dds",
+        [this](const AssetLoader::FileDataPtr& data) { CreateTexture(data, &m_stoneTexSRV); });
+    m_assets.LoadFile("Textures/bricks.dds",
+        [this](const AssetLoader::FileDataPtr& data) { CreateTexture(data, &m_brickTexSRV); });
+}
+
 void DynamicCubeMapApp::InitGeometryBuffers()
 {
     BuildDynamicCubeMapViews();
 
     BuildShapeBuffers();
-    BuildSkullBuffers();
+
+    // Only the skull moves (see UpdateScene), the other bounds are computed once.
+    UpdateObjectBounds(GridObject, m_gridBox, XMLoadFloat4x4(&m_gridWorld));
+    UpdateObjectBounds(BoxObject, m_boxBox, XMLoadFloat4x4(&m_boxWorld));
+    UpdateObjectBounds(CenterSphereObject, m_sphereBox, XMLoadFloat4x4(&m_centerSphereWorld));
+
+    for(int i = 0; i < 10; ++i)
+	{
+        UpdateObjectBounds(CylinderObject0 + i, m_cylinderBox, XMLoadFloat4x4(&m_cylWorld[i]));
+        UpdateObjectBounds(SphereObject0 + i, m_sphereBox, XMLoadFloat4x4(&m_sphereWorld[i]));
+	}
+}
+
+void DynamicCubeMapApp::UpdateObjectBounds(uint32 object, const XNA::AxisAlignedBox& localBox, CXMMATRIX world)
+{
+    // World space box enclosing the transformed local box: the center is
+    // transformed as a point, the extents by the absolute value of the matrix.
+    XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&localBox.Center), world);
+
+    XMFLOAT4X4 M;
+    XMStoreFloat4x4(&M, world);
+
+    const XMFLOAT3& e = localBox.Extents;
+
+    m_boundsCenterX[object] = XMVectorGetX(center);
+    m_boundsCenterY[object] = XMVectorGetY(center);
+    m_boundsCenterZ[object] = XMVectorGetZ(center);
+    m_boundsExtentX[object] = e.x*fabsf(M._11) + e.y*fabsf(M._21) + e.z*fabsf(M._31);
+    m_boundsExtentY[object] = e.x*fabsf(M._12) + e.y*fabsf(M._22) + e.z*fabsf(M._32);
+    m_boundsExtentZ[object] = e.x*fabsf(M._13) + e.y*fabsf(M._23) + e.z*fabsf(M._33);
+}
+
+void DynamicCubeMapApp::CullViews()
+{
+    // Planes of the 6 cube map faces followed by the main camera.
+    XMFLOAT4 planes[ViewCount][6];
+    for(int i = 0; i < 6; ++i)
+    {
+        MathHelper::ExtractFrustumPlanes(m_cubeMapCam[i].viewProj(), planes[i]);
+    }
+    MathHelper::ExtractFrustumPlanes(m_cam.viewProj(), planes[MainView]);
+
+    XNA::MultiFrustumPlanes frustums;
+    XNA::LoadMultiFrustumPlanes(&frustums, &planes[0][0].x, ViewCount);
+
+    XNA::AxisAlignedBoxStream boxes;
+    boxes.CenterX = m_boundsCenterX;
+    boxes.CenterY = m_boundsCenterY;
+    boxes.CenterZ = m_boundsCenterZ;
+    boxes.ExtentX = m_boundsExtentX;
+    boxes.ExtentY = m_boundsExtentY;
+    boxes.ExtentZ = m_boundsExtentZ;
+
+    XNA::CullAxisAlignedBoxStreamMultiFrustum(&boxes, ObjectCount, &frustums, m_viewMasks);
 }
 
 void DynamicCubeMapApp::BuildCubeFaceCamera(float x, float y, float z)
@@ -360,38 +480,20 @@ void DynamicCubeMapApp::BuildDynamicCubeMapViews()
     m_cubeMapViewport.MaxDepth = 1.0f;
 }
 
-void DynamicCubeMapApp::BuildSkullBuffers()
+void DynamicCubeMapApp::BuildSkullBuffers(const MeshAssetPtr& skull)
 {
-    std::ifstream fin("Models/skull.txt");
-    OC_ASSERT(fin.good());
+    // Shared with the other scenes of the process that use the same model.
+    m_skull = skull;
+    OC_ASSERT(m_skull);
 
-	UINT vcount = 0;
-	UINT tcount = 0;
-	std::string ignore;
-
-	fin >> ignore >> vcount;
-	fin >> ignore >> tcount;
-	fin >> ignore >> ignore >> ignore >> ignore;
+	UINT vcount = m_skull->VertexCount();
 	
-	std::vector<Vertex::Basic32> vertices(vcount);
-	for(UINT i = 0; i < vcount; ++i)
-	{
-		fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-		fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
-	}
+	std::vector<Vertex::Basic32> vertices;
+    CopyMeshVertices(*m_skull, &vertices);
 
-	fin >> ignore;
-	fin >> ignore;
-	fin >> ignore;
+	m_skullIndexCount = m_skull->IndexCount();
 
-    m_skullIndexCount = 3*tcount;
-	std::vector<UINT> indices(m_skullIndexCount);
-	for(UINT i = 0; i < tcount; ++i)
-	{
-		fin >> indices[i*3+0] >> indices[i*3+1] >> indices[i*3+2];
-	}
-
-	fin.close();
+    m_skullBox = m_skull->Bounds;
 
     D3D11_BUFFER_DESC vbd;
     vbd.Usage = D3D11_USAGE_IMMUTABLE;
@@ -411,7 +513,7 @@ void DynamicCubeMapApp::BuildSkullBuffers()
     ibd.CPUAccessFlags = 0;
     ibd.MiscFlags = 0;
     D3D11_SUBRESOURCE_DATA iinitData;
-	iinitData.pSysMem = &indices[0];
+	iinitData.pSysMem = &m_skull->Indices[0];
     HR(m_dxDevice->CreateBuffer(&ibd, &iinitData, m_skullIB.GetAddressOf()));
 }
 
@@ -428,6 +530,16 @@ void DynamicCubeMapApp::BuildShapeBuffers()
 	geoGen.CreateSphere(0.5f, 20, 20, sphere);
 	geoGen.CreateCylinder(0.5f, 0.3f, 3.0f, 20, 20, cylinder);
 
+    // Local bounds used for culling.
+    XNA::ComputeBoundingAxisAlignedBoxFromPoints(&m_boxBox, box.vertices.size(),
+        &box.vertices[0].position, sizeof(GeometryGenerator::Vertex));
+    XNA::ComputeBoundingAxisAlignedBoxFromPoints(&m_gridBox, grid.vertices.size(),
+        &grid.vertices[0].position, sizeof(GeometryGenerator::Vertex));
+    XNA::ComputeBoundingAxisAlignedBoxFromPoints(&m_sphereBox, sphere.vertices.size(),
+        &sphere.vertices[0].position, sizeof(GeometryGenerator::Vertex));
+    XNA::ComputeBoundingAxisAlignedBoxFromPoints(&m_cylinderBox, cylinder.vertices.size(),
+        &cylinder.vertices[0].position, sizeof(GeometryGenerator::Vertex));
+
     // Cache the vertex offsets to each object in the concatenated vertex buffer.
 	m_boxVertexOffset      = 0;
 	m_gridVertexOffset     = box.vertices.size();
@@ -522,20 +634,18 @@ void DynamicCubeMapApp::BuildShapeBuffers()
 void DynamicCubeMapApp::InitFX()
 {
     // Must init Effects first since InputLayouts depend on shader signatures.
-	Effects::InitAll(m_dxDevice.Get());
+	Effects::InitAll(m_dxDevice.Get(), m_assets);
 	InputLayouts::InitAll(m_dxDevice.Get());
 	RenderStates::InitAll(m_dxDevice.Get());
 
     m_sky.reset(new Sky(m_dxDevice.Get(), "Textures/sunsetcube1024.dds", 5000.0f));
+}
 
-	HR(D3DX11CreateShaderResourceViewFromFile(m_dxDevice.Get(), 
-        "Textures/floor.dds", 0, 0, m_floorTexSRV.GetAddressOf(), 0 ));
-
-    HR(D3DX11CreateShaderResourceViewFromFile(m_dxDevice.Get(), 
-        "Textures/stone.dds", 0, 0, m_stoneTexSRV.GetAddressOf(), 0 ));
-
-    HR(D3DX11CreateShaderResourceViewFromFile(m_dxDevice.Get(), 
-        "Textures/bricks.dds", 0, 0, m_brickTexSRV.GetAddressOf(), 0 ));
+void DynamicCubeMapApp::CreateTexture(const AssetLoader::FileDataPtr& data, ComPtr<ID3D11ShaderResourceView>* pSRV)
+{
+    OC_ASSERT(data);
+    HR(D3DX11CreateShaderResourceViewFromMemory(m_dxDevice.Get(), &(*data)[0], data->size(),
+        0, 0, pSRV->GetAddressOf(), 0));
 }
 
 void DynamicCubeMapApp::InitVertexLayout() { }
@@ -560,6 +670,11 @@ void DynamicCubeMapApp::UpdateScene(float dt)
 	XMMATRIX skullLocalRotate = XMMatrixRotationY(2.0f*m_timer.TotalTime());
 	XMMATRIX skullGlobalRotate = XMMatrixRotationY(0.5f*m_timer.TotalTime());
 	XMStoreFloat4x4(&m_skullWorld, skullScale*skullLocalRotate*skullOffset*skullGlobalRotate);
+
+    UpdateObjectBounds(SkullObject, m_skullBox, XMLoadFloat4x4(&m_skullWorld));
+
+    // One pass gives the visible objects of all the views.
+    CullViews();
 }
 
 void DynamicCubeMapApp::DrawScene()
@@ -579,7 +694,7 @@ void DynamicCubeMapApp::DrawScene()
 		m_dxImmediateContext->OMSetRenderTargets(1, &renderTargets, m_dynamicCubeMapDSV.Get());
 
 		// Draw the scene with the exception of the center sphere to this cube map face.
-		DrawScene(m_cubeMapCam[i], false);
+		DrawScene(m_cubeMapCam[i], i, false);
 	}
 
 	// Restore old viewport and render targets.
@@ -594,12 +709,12 @@ void DynamicCubeMapApp::DrawScene()
     m_dxImmediateContext->ClearRenderTargetView(m_renderTargetView.Get(), reinterpret_cast<const float*>(&oc::Colors::Silver));
     m_dxImmediateContext->ClearDepthStencilView(m_depthStencilView.Get(), D3D11_CLEAR_DEPTH|D3D11_CLEAR_STENCIL, 1.0f, 0);
 	
-	DrawScene(m_cam, true);
+	DrawScene(m_cam, MainView, true);
 
 	HR(m_swapChain->Present(0, 0));
 }
 
-void DynamicCubeMapApp::DrawScene(const Camera& camera, bool drawCenterSphere)
+void DynamicCubeMapApp::DrawScene(const Camera& camera, uint32 viewIndex, bool drawCenterSphere)
 {
     m_dxImmediateContext->IASetInputLayout(InputLayouts::Basic32.Get());
     m_dxImmediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -648,7 +763,7 @@ void DynamicCubeMapApp::DrawScene(const Camera& camera, bool drawCenterSphere)
     // Draw the skull
     D3DX11_TECHNIQUE_DESC techDesc;
     activeSkullTech->GetDesc(&techDesc);
-    for(uint32 p = 0; p < techDesc.Passes; ++p)
+    for(uint32 p = 0; p < techDesc.Passes && IsVisible(SkullObject, viewIndex); ++p)
     {
         ID3DX11EffectPass* pass = activeSkullTech->GetPassByIndex( p );
 
@@ -679,38 +794,47 @@ void DynamicCubeMapApp::DrawScene(const Camera& camera, bool drawCenterSphere)
         ID3DX11EffectPass* pass = activeTexTech->GetPassByIndex( p );
 
         // Draw the grid
-        world = XMLoadFloat4x4(&m_gridWorld);
-		worldInvTranspose = MathHelper::InverseTranspose(world);
-		worldViewProj = world*view*proj;
-		
-		Effects::BasicFX->SetWorld(world);
-		Effects::BasicFX->SetWorldInvTranspose(worldInvTranspose);
-		Effects::BasicFX->SetWorldViewProj(worldViewProj);
-        Effects::BasicFX->SetTexTransform(XMMatrixScaling(6.0f, 8.0f, 1.0f));
-		Effects::BasicFX->SetMaterial(m_gridMat);
-        Effects::BasicFX->SetDiffuseMap(m_floorTexSRV.Get());
+        if(IsVisible(GridObject, viewIndex))
+        {
+            world = XMLoadFloat4x4(&m_gridWorld);
+            worldInvTranspose = MathHelper::InverseTranspose(world);
+            worldViewProj = world*view*proj;
+
+            Effects::BasicFX->SetWorld(world);
+            Effects::BasicFX->SetWorldInvTranspose(worldInvTranspose);
+            Effects::BasicFX->SetWorldViewProj(worldViewProj);
+            Effects::BasicFX->SetTexTransform(XMMatrixScaling(6.0f, 8.0f, 1.0f));
+            Effects::BasicFX->SetMaterial(m_gridMat);
+            Effects::BasicFX->SetDiffuseMap(m_floorTexSRV.Get());
 
-        pass->Apply(0, m_dxImmediateContext.Get());
-        m_dxImmediateContext->DrawIndexed(m_gridIndexCount, m_gridIndexOffset, m_gridVertexOffset);
+            pass->Apply(0, m_dxImmediateContext.Get());
+            m_dxImmediateContext->DrawIndexed(m_gridIndexCount, m_gridIndexOffset, m_gridVertexOffset);
+        }
 
         //Draw the box
-        world = XMLoadFloat4x4(&m_boxWorld);
-		worldInvTranspose = MathHelper::InverseTranspose(world);
-		worldViewProj = world*view*proj;
-
-		Effects::BasicFX->SetWorld(world);
-		Effects::BasicFX->SetWorldInvTranspose(worldInvTranspose);
-		Effects::BasicFX->SetWorldViewProj(worldViewProj);
-		Effects::BasicFX->SetTexTransform(XMMatrixIdentity());
-		Effects::BasicFX->SetMaterial(m_boxMat);
-        Effects::BasicFX->SetDiffuseMap(m_stoneTexSRV.Get());
+        if(IsVisible(BoxObject, viewIndex))
+        {
+            world = XMLoadFloat4x4(&m_boxWorld);
+            worldInvTranspose = MathHelper::InverseTranspose(world);
+            worldViewProj = world*view*proj;
+
+            Effects::BasicFX->SetWorld(world);
+            Effects::BasicFX->SetWorldInvTranspose(worldInvTranspose);
+            Effects::BasicFX->SetWorldViewProj(worldViewProj);
+            Effects::BasicFX->SetTexTransform(XMMatrixIdentity());
+            Effects::BasicFX->SetMaterial(m_boxMat);
+            Effects::BasicFX->SetDiffuseMap(m_stoneTexSRV.Get());
 
-        activeTexTech->GetPassByIndex(p)->Apply(0, m_dxImmediateContext.Get());
-        m_dxImmediateContext->DrawIndexed(m_boxIndexCount, m_boxIndexOffset, m_boxVertexOffset);
+            activeTexTech->GetPassByIndex(p)->Apply(0, m_dxImmediateContext.Get());
+            m_dxImmediateContext->DrawIndexed(m_boxIndexCount, m_boxIndexOffset, m_boxVertexOffset);
+        }
 
         // Draw the cylinders.
 		for(int i = 0; i < 10; ++i)
 		{
+            if(!IsVisible(CylinderObject0 + i, viewIndex))
+                continue;
+
             world = XMLoadFloat4x4(&m_cylWorld[i]);
 			worldInvTranspose = MathHelper::InverseTranspose(world);
 			worldViewProj = world*view*proj;
@@ -729,6 +853,9 @@ void DynamicCubeMapApp::DrawScene(const Camera& camera, bool drawCenterSphere)
 		// Draw the spheres.
 		for(int i = 0; i < 10; ++i)
 		{
+            if(!IsVisible(SphereObject0 + i, viewIndex))
+                continue;
+
 			world = XMLoadFloat4x4(&m_sphereWorld[i]);
 			worldInvTranspose = MathHelper::InverseTranspose(world);
 			worldViewProj = world*view*proj;
@@ -745,7 +872,7 @@ void DynamicCubeMapApp::DrawScene(const Camera& camera, bool drawCenterSphere)
 		}
     }
 
-    if (drawCenterSphere)
+    if (drawCenterSphere && IsVisible(CenterSphereObject, viewIndex))
     {
         activeReflectTech->GetDesc( &techDesc );
 		for(UINT p = 0; p < techDesc.Passes; ++p)
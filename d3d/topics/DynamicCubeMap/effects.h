@@ -12,13 +12,17 @@
 #include "comPtr.h"
 #include "lightHelper.h"
 #include "d3dx11Effect.h"
+#include "types.h"
 #include <string>
 #include <memory>
+#include <vector>
+
+class AssetLoader;
 
 class Effect
 {
 public:
-	Effect(ID3D11Device* device, const std::string& filename);
+	Effect(ID3D11Device* device, const std::vector<uint8>& compiledShader);
 	virtual ~Effect();
 
 private:
@@ -33,7 +37,7 @@ protected:
 class BasicEffect : public Effect
 {
 public:
-	BasicEffect(ID3D11Device* device, const std::string& filename);
+	BasicEffect(ID3D11Device* device, const std::vector<uint8>& compiledShader);
 	virtual ~BasicEffect();
 
 	void SetWorldViewProj(CXMMATRIX M)                  { WorldViewProj->SetMatrix(reinterpret_cast<const float*>(&M)); }
@@ -123,7 +127,7 @@ public:
 class SkyEffect : public Effect
 {
 public:
-	SkyEffect(ID3D11Device* device, const std::string& filename);
+	SkyEffect(ID3D11Device* device, const std::vector<uint8>& compiledShader);
 	~SkyEffect();
 
 	void SetWorldViewProj(CXMMATRIX M)                  { WorldViewProj->SetMatrix(reinterpret_cast<const float*>(&M)); }
@@ -139,7 +143,10 @@ public:
 class Effects
 {
 public:
-	static void InitAll(ID3D11Device* device);
+	// Start reading the compiled effects in the background, InitAll waits
+	// for them and creates the effects.
+	static void LoadAll(AssetLoader& assets);
+	static void InitAll(ID3D11Device* device, AssetLoader& assets);
 	static void DestroyAll();
 
 	static std::unique_ptr<BasicEffect> BasicFX;
@@ -74,6 +74,46 @@ VertexOut VS(VertexIn vin)
 	return vout;
 }
  
+// Compact instance data (see instanceFormat.h): translation and uniform
+// scale, unit quaternion, color.
+struct VertexInCompact
+{
+	float3 PosL          : POSITION;
+	float3 NormalL       : NORMAL;
+	float2 Tex           : TEXCOORD;
+	float4 PositionScale : INSTANCEPOS;
+	float4 Rotation      : INSTANCEROT;
+	float4 Color         : COLOR;
+};
+
+// Rotate v by the unit quaternion q.
+float3 QuatRotate(float3 v, float4 q)
+{
+	float3 t = 2.0f*cross(q.xyz, v);
+	return v + q.w*t + cross(q.xyz, t);
+}
+
+VertexOut VSCompact(VertexInCompact vin)
+{
+	VertexOut vout;
+
+	// The 16 bit quaternion is not exactly unit length.
+	float4 q = normalize(vin.Rotation);
+
+	// Transform to world space space.
+	vout.PosW    = QuatRotate(vin.PosL*vin.PositionScale.w, q) + vin.PositionScale.xyz;
+	vout.NormalW = QuatRotate(vin.NormalL, q);
+
+	// Transform to homogeneous clip space.
+	vout.PosH = mul(float4(vout.PosW, 1.0f), gViewProj);
+
+	// Output vertex attributes for interpolation across triangle.
+	vout.Tex   = mul(float4(vin.Tex, 0.0f, 1.0f), gTexTransform).xy;
+	vout.Color = vin.Color;
+
+	return vout;
+}
+
 float4 PS(VertexOut pin, uniform int gLightCount, uniform bool gUseTexure, uniform bool gAlphaClip, uniform bool gFogEnabled) : SV_Target
 {
 	// Interpolating normal can unnormalize it, so normalize it.
@@ -181,6 +221,36 @@ technique11 Light3
     }
 }
 
+technique11 Light1Compact
+{
+    pass P0
+    {
+        SetVertexShader( CompileShader( vs_5_0, VSCompact() ) );
+		SetGeometryShader( NULL );
+        SetPixelShader( CompileShader( ps_5_0, PS(1, false, false, false) ) );
+    }
+}
+
+technique11 Light2Compact
+{
+    pass P0
+    {
+        SetVertexShader( CompileShader( vs_5_0, VSCompact() ) );
+		SetGeometryShader( NULL );
+        SetPixelShader( CompileShader( ps_5_0, PS(2, false, false, false) ) );
+    }
+}
+
+technique11 Light3Compact
+{
+    pass P0
+    {
+        SetVertexShader( CompileShader( vs_5_0, VSCompact() ) );
+		SetGeometryShader( NULL );
+        SetPixelShader( CompileShader( ps_5_0, PS(3, false, false, false) ) );
+    }
+}
+
 technique11 Light0Tex
 {
     pass P0
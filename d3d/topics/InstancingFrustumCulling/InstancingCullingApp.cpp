@@ -19,10 +19,13 @@
 #include "renderStates.h"
 #include "vertex.h"
 #include "xnacollision.h"
+#include "instanceCuller.h"
+#include "instanceFormat.h"
+#include "meshFile.h"
+#include "meshSimplifier.h"
 #include <d3dcompiler.h>
 #include <iostream>
 #include <sstream>
-#include <fstream>
 #include <vector>
 
 struct InstanceData
@@ -31,6 +34,21 @@ struct InstanceData
     XMFLOAT4 Color;
 };
 
+// Instances per copy task (at least).
+
+// Levels of detail of the skull, the full mesh then meshes simplified with
+// grid cells of the given fractions of the skull size.
+const uint32 SKULL_LOD_COUNT = 4;
+const float SKULL_LOD_CELL_SIZES[SKULL_LOD_COUNT] = { 0.0f, 1.0f/64.0f, 1.0f/32.0f, 1.0f/16.0f };
+
+// Part of the skull index and vertex buffers drawn for one LOD.
+struct MeshLod
+{
+    uint32 IndexCount;
+    uint32 StartIndex;
+    int32 BaseVertex;
+};
+
 class InstancingCullingApp : public TopicApp
 {
 public:
@@ -38,7 +56,6 @@ public:
 	~InstancingCullingApp();
 
 	virtual bool Init();
-	virtual void OnResize();
 	virtual void UpdateScene(float dt);
 	virtual void DrawScene(); 
 
@@ -56,13 +73,29 @@ private:
     ComPtr<ID3D11Buffer>           m_instancedBuffer;
 
    	XNA::AxisAlignedBox m_skullbox;
-	XNA::Frustum m_camFrustum;
 
     uint32 m_visibleObjectCount;
 
-    std::vector<InstanceData> m_instancedData;
+    // Color of each instance. Their world matrices are only kept by m_culler,
+    // the instance data is assembled from both when it is copied to the buffer.
+    std::vector<XMFLOAT4> m_instanceColors;
+
+    // The same instances in the compact format, uploaded instead of
+    // InstanceData when m_compactInstancesEnabled is set.
+    std::vector<CompactInstanceData> m_compactData;
+    bool m_compactInstancesEnabled;
+
+    // Instance bounds, octree and occlusion buffer: finds the instances to draw.
+    InstanceCuller m_culler;
+    std::vector<uint32> m_movedInstances;
+
+    uint32 m_occludedObjectCount;
 
     bool m_frustumCullingEnabled;
+    bool m_occlusionCullingEnabled;
+    bool m_lodEnabled;
+
+    uint32 m_drawnTriangleCount;
 
     DirectionalLight m_dirLight[3];
     Material m_skullMat;
@@ -70,7 +103,7 @@ private:
     // Define transformations from local spaces to world space.
 	XMFLOAT4X4 m_skullWorld;
 
-	uint32 m_skullIndexCount;
+    MeshLod m_skullLods[SKULL_LOD_COUNT];
 };
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
@@ -91,9 +124,13 @@ InstancingCullingApp::InstancingCullingApp(HINSTANCE hInstance)
 : TopicApp(hInstance) 
 , m_skullVB(nullptr)
 , m_skullIB(nullptr)
-, m_skullIndexCount(0)
 , m_visibleObjectCount(0)
+, m_occludedObjectCount(0)
 , m_frustumCullingEnabled(true)
+, m_occlusionCullingEnabled(true)
+, m_compactInstancesEnabled(false)
+, m_lodEnabled(true)
+, m_drawnTriangleCount(0)
 {
     m_windowCaption = "Culling Demo";
     m_enable4xMsaa = false;
@@ -142,14 +179,6 @@ bool InstancingCullingApp::Init()
 	return true;
 }
 
-void InstancingCullingApp::OnResize()
-{
-    TopicApp::OnResize();
-
-    // Build the frustum from the projection matrix in view space.
-    ComputeFrustumFromProjection(&m_camFrustum, &m_cam.proj());
-}
-
 void InstancingCullingApp::InitGeometryBuffers()
 {
     BuildSkullBuffers();
@@ -158,55 +187,73 @@ void InstancingCullingApp::InitGeometryBuffers()
 
 void InstancingCullingApp::BuildSkullBuffers()
 {
-    std::ifstream fin("Models/skull.txt");
-    OC_ASSERT(fin.good());
-
-	UINT vcount = 0;
-	UINT tcount = 0;
-	std::string ignore;
+    // Binary model, converted from Models/skull.txt by tools/MeshConverter when
+    // the project builds. The vertices are copied since the LODs are appended
+    // to them.
+    MeshFile mesh;
+    bool opened = mesh.Open("Models/skull.mesh");
+    OC_ASSERT(opened && mesh.VertexStride() == sizeof(Vertex::Basic32));
+
+    UINT vcount = mesh.VertexCount();
+    UINT tcount = mesh.IndexCount() / 3;
+
+    const Vertex::Basic32* meshVertices = reinterpret_cast<const Vertex::Basic32*>(mesh.Vertices());
+	std::vector<Vertex::Basic32> vertices(meshVertices, meshVertices + vcount);
+    std::vector<XMFLOAT3> positions(vcount);
+	for(UINT i = 0; i < vcount; ++i)
+        positions[i] = vertices[i].Pos;
 
-	fin >> ignore >> vcount;
-	fin >> ignore >> tcount;
-	fin >> ignore >> ignore >> ignore >> ignore;
+    // 15.2.2
+    m_skullbox = mesh.Bounds();
 
-    // Get min and max vector (for bounding box)
-	XMFLOAT3 vMinf3(+MathHelper::Infinity, +MathHelper::Infinity, +MathHelper::Infinity);
-	XMFLOAT3 vMaxf3(-MathHelper::Infinity, -MathHelper::Infinity, -MathHelper::Infinity);
-	
-    XMVECTOR vMin = XMLoadFloat3(&vMinf3);
-	XMVECTOR vMax = XMLoadFloat3(&vMaxf3);
-	std::vector<Vertex::Basic32> vertices(vcount);
-	for(UINT i = 0; i < vcount; ++i)
-	{
-		fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-		fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
+	std::vector<UINT> indices(3*tcount);
+	for(UINT i = 0; i < 3*tcount; ++i)
+		indices[i] = mesh.Index(i);
 
-        XMVECTOR P = XMLoadFloat3(&vertices[i].Pos);
-		
-		vMin = XMVectorMin(vMin, P);
-		vMax = XMVectorMax(vMax, P);
-	}
+    // The full skull is also rasterized as occluder.
+    m_culler.SetMesh(m_skullbox, &positions[0], vcount, &indices[0], tcount);
 
-    // 15.2.2
-    XMStoreFloat3(&m_skullbox.Center, 0.5f*(vMin+vMax));
-	XMStoreFloat3(&m_skullbox.Extents, 0.5f*(vMax-vMin));
+    // Simplified skulls, appended to the same buffers. The normals of the
+    // merged vertices are averaged.
+    float skullSize = 2.0f * MathHelper::Max(m_skullbox.Extents.x, MathHelper::Max(m_skullbox.Extents.y, m_skullbox.Extents.z));
+    float lodErrors[SKULL_LOD_COUNT];
 
-	fin >> ignore;
-	fin >> ignore;
-	fin >> ignore;
+    m_skullLods[0].IndexCount = 3*tcount;
+    m_skullLods[0].StartIndex = 0;
+    m_skullLods[0].BaseVertex = 0;
+    lodErrors[0] = 0.0f;
 
-    m_skullIndexCount = 3*tcount;
-	std::vector<UINT> indices(m_skullIndexCount);
-	for(UINT i = 0; i < tcount; ++i)
-	{
-		fin >> indices[i*3+0] >> indices[i*3+1] >> indices[i*3+2];
-	}
+    for(uint32 lod = 1; lod < SKULL_LOD_COUNT; ++lod)
+    {
+        ClusteredMesh simplified;
+        ClusterVertices(&positions[0], sizeof(XMFLOAT3), vcount, &indices[0], tcount,
+            SKULL_LOD_CELL_SIZES[lod] * skullSize, &simplified);
+
+        m_skullLods[lod].IndexCount = (uint32)simplified.Indices.size();
+        m_skullLods[lod].StartIndex = (uint32)indices.size();
+        m_skullLods[lod].BaseVertex = (int32)vertices.size();
+        lodErrors[lod] = simplified.MaxError;
+
+        std::vector<XMVECTOR> normals(simplified.Positions.size(), XMVectorZero());
+        for(UINT i = 0; i < vcount; ++i)
+            normals[simplified.ClusterOf[i]] += XMLoadFloat3(&vertices[i].Normal);
+
+        for(size_t c = 0; c < simplified.Positions.size(); ++c)
+        {
+            Vertex::Basic32 v;
+            v.Pos = simplified.Positions[c];
+            XMStoreFloat3(&v.Normal, XMVector3Normalize(normals[c]));
+            vertices.push_back(v);
+        }
+
+        indices.insert(indices.end(), simplified.Indices.begin(), simplified.Indices.end());
+    }
 
-	fin.close();
+    m_culler.SetLods(lodErrors, SKULL_LOD_COUNT);
 
     D3D11_BUFFER_DESC vbd;
     vbd.Usage = D3D11_USAGE_IMMUTABLE;
-	vbd.ByteWidth = sizeof(Vertex::Basic32) * vcount;
+	vbd.ByteWidth = sizeof(Vertex::Basic32) * vertices.size();
     vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
     vbd.CPUAccessFlags = 0;
     vbd.MiscFlags = 0;
@@ -217,7 +264,7 @@ void InstancingCullingApp::BuildSkullBuffers()
 	// Pack the indices of all the meshes into one index buffer.
 	D3D11_BUFFER_DESC ibd;
     ibd.Usage = D3D11_USAGE_IMMUTABLE;
-    ibd.ByteWidth = sizeof(UINT) * m_skullIndexCount;
+    ibd.ByteWidth = sizeof(UINT) * indices.size();
     ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
     ibd.CPUAccessFlags = 0;
     ibd.MiscFlags = 0;
@@ -233,7 +280,7 @@ void InstancingCullingApp::BuildInstancedBuffer()
 
     // 5 x 5 x 5 grid of skull
     const int n = 5;
-    m_instancedData.resize(n*n*n);
+    m_instanceColors.resize(n*n*n);
 	
     // Scene is 200 x 200 x 200
 	float width = 200.0f;
@@ -252,25 +299,37 @@ void InstancingCullingApp::BuildInstancedBuffer()
 		{
 			for(int j = 0; j < n; ++j)
 			{
-				// Position instanced along a 3D grid.
-                m_instancedData[k*n*n + i*n + j].World = XMFLOAT4X4(
-					1.0f, 0.0f, 0.0f, 0.0f,
-					0.0f, 1.0f, 0.0f, 0.0f,
-					0.0f, 0.0f, 1.0f, 0.0f,
-					x+j*dx, y+i*dy, z+k*dz, 1.0f); //translation only
+				// Position instanced along a 3D grid, in the order of the colors.
+                // The world boxes of the skulls are computed by Build and then
+                // only when an instance moves (InstanceCuller::SetWorld).
+                uint32 index = m_culler.AddInstance(XMMatrixTranslation(x+j*dx, y+i*dy, z+k*dz));
+                OC_ASSERT(index == (uint32)(k*n*n + i*n + j));
+                (void)index;
 				
 				// Random color.
-                m_instancedData[k*n*n + i*n + j].Color.x = MathHelper::RandF(0.0f, 1.0f);
-				m_instancedData[k*n*n + i*n + j].Color.y = MathHelper::RandF(0.0f, 1.0f);
-				m_instancedData[k*n*n + i*n + j].Color.z = MathHelper::RandF(0.0f, 1.0f);
-				m_instancedData[k*n*n + i*n + j].Color.w = 1.0f;
+                m_instanceColors[k*n*n + i*n + j].x = MathHelper::RandF(0.0f, 1.0f);
+				m_instanceColors[k*n*n + i*n + j].y = MathHelper::RandF(0.0f, 1.0f);
+				m_instanceColors[k*n*n + i*n + j].z = MathHelper::RandF(0.0f, 1.0f);
+				m_instanceColors[k*n*n + i*n + j].w = 1.0f;
 			}
 		}
 	}
 
+    m_compactData.resize(m_instanceColors.size());
+    EncodeCompactInstances(&m_compactData[0], &m_culler.Instances().World(0), sizeof(XMFLOAT4X4),
+        &m_instanceColors[0], sizeof(XMFLOAT4), (uint32)m_instanceColors.size());
+
+    // Octree over the scene, with some margin for the size of the skulls.
+    XNA::AxisAlignedBox sceneBox;
+    sceneBox.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    sceneBox.Extents = XMFLOAT3(0.5f*width + 10.0f, 0.5f*height + 10.0f, 0.5f*depth + 10.0f);
+
+    m_culler.Build(sceneBox);
+
     D3D11_BUFFER_DESC vbd;
     vbd.Usage = D3D11_USAGE_DYNAMIC;
-    vbd.ByteWidth = sizeof(InstanceData) * m_instancedData.size();
+    // Large enough for both instance formats.
+    vbd.ByteWidth = sizeof(InstanceData) * m_instanceColors.size();
     vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
     vbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
     vbd.MiscFlags = 0;
@@ -300,71 +359,84 @@ void InstancingCullingApp::UpdateScene(float dt)
 	if( GetAsyncKeyState('2') & 0x8000 )
 		m_frustumCullingEnabled = false;
 
-    //Perform culling
-    m_visibleObjectCount = 0;
+	// Switch occlusion culling (on top of frustum culling)
+	if( GetAsyncKeyState('3') & 0x8000 )
+        m_occlusionCullingEnabled = true;
 
-    if(m_frustumCullingEnabled)
-	{
-        // Get matrix to transform view to world
-        // Needed to transform frustum to instanced skulls local coordinate (for frustum test)
-		XMVECTOR detView = XMMatrixDeterminant(m_cam.view());
-		XMMATRIX invView = XMMatrixInverse(&detView, m_cam.view());
-	
-		D3D11_MAPPED_SUBRESOURCE mappedData; 
-        m_dxImmediateContext->Map(m_instancedBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData);
+	if( GetAsyncKeyState('4') & 0x8000 )
+		m_occlusionCullingEnabled = false;
 
-		InstanceData* dataView = reinterpret_cast<InstanceData*>(mappedData.pData);
+	// Switch the instance data format
+	if( GetAsyncKeyState('5') & 0x8000 )
+        m_compactInstancesEnabled = false;
 
-        // For each instanced data check if the bounding box is in the frustum
-        // and if it's the case copy it to the dynamic buffer
-        for(UINT i = 0; i < m_instancedData.size(); ++i)
-		{
-			XMMATRIX W = XMLoadFloat4x4(&m_instancedData[i].World);
-			XMMATRIX invWorld = XMMatrixInverse(&XMMatrixDeterminant(W), W);
-
-			// View space to the object's local space.
-			XMMATRIX toLocal = XMMatrixMultiply(invView, invWorld);
-		
-			// Decompose the matrix into its individual parts.
-			XMVECTOR scale;
-			XMVECTOR rotQuat;
-			XMVECTOR translation;
-			XMMatrixDecompose(&scale, &rotQuat, &translation, toLocal);
-
-			// Transform the camera frustum from view space to the object's local space.
-			XNA::Frustum localspaceFrustum;
-            XNA::TransformFrustum(&localspaceFrustum, &m_camFrustum, XMVectorGetX(scale), rotQuat, translation);
-
-			// Perform the box/frustum intersection test in local space.
-            if(XNA::IntersectAxisAlignedBoxFrustum(&m_skullbox, &localspaceFrustum) != 0)
-			{
-				// Write the instance data to dynamic VB of the visible objects.
-                dataView[m_visibleObjectCount++] = m_instancedData[i];
-			}
-		}
+	if( GetAsyncKeyState('6') & 0x8000 )
+		m_compactInstancesEnabled = true;
 
-        m_dxImmediateContext->Unmap(m_instancedBuffer.Get(), 0);
-	}
-	else // No culling enabled, draw all objects.
-	{
-		D3D11_MAPPED_SUBRESOURCE mappedData; 
-        m_dxImmediateContext->Map(m_instancedBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData);
+	// Switch the levels of detail
+	if( GetAsyncKeyState('7') & 0x8000 )
+        m_lodEnabled = true;
 
-		InstanceData* dataView = reinterpret_cast<InstanceData*>(mappedData.pData);
+	if( GetAsyncKeyState('8') & 0x8000 )
+		m_lodEnabled = false;
 
-		for(UINT i = 0; i < m_instancedData.size(); ++i)
-		{
-            dataView[m_visibleObjectCount++] = m_instancedData[i];
-		}
+    // Refresh the bounds of the instances that moved, and their place in the octree.
+    m_movedInstances.clear();
+    m_culler.Update(&m_movedInstances);
 
-        m_dxImmediateContext->Unmap(m_instancedBuffer.Get(), 0);
-	}
+    for(size_t m = 0; m < m_movedInstances.size(); ++m)
+    {
+        uint32 i = m_movedInstances[m];
+        EncodeCompactInstance(&m_compactData[i], XMLoadFloat4x4(&m_culler.Instances().World(i)),
+            XMLoadFloat4(&m_instanceColors[i]));
+    }
+
+	D3D11_MAPPED_SUBRESOURCE mappedData; 
+    m_dxImmediateContext->Map(m_instancedBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData);
+
+	InstanceData* dataView = reinterpret_cast<InstanceData*>(mappedData.pData);
+    CompactInstanceData* compactView = reinterpret_cast<CompactInstanceData*>(mappedData.pData);
+
+    // Write the instance data of the visible objects to the dynamic VB from
+    // the culling tasks, at the slot they give each visible instance.
+    InstanceCuller::VisibleWriter writer = [&](uint32 slot, uint32 i)
+    {
+        if(m_compactInstancesEnabled)
+            compactView[slot] = m_compactData[i];
+        else
+        {
+            dataView[slot].World = m_culler.Instances().World(i);
+            dataView[slot].Color = m_instanceColors[i];
+        }
+    };
+
+    // Perform culling. The pass that settles the order writes the buffer: the
+    // LOD sort when there are LODs, each LOD being drawn from its range of the
+    // instance buffer. Without LODs they all stay in the full mesh range.
+    m_culler.Cull(m_cam.viewProj(), m_cam.getPositionXM(),
+        m_frustumCullingEnabled ? InstanceCuller::FRUSTUM_OCTREE : InstanceCuller::FRUSTUM_NONE,
+        m_occlusionCullingEnabled, nullptr, m_lodEnabled ? InstanceCuller::VisibleWriter() : writer);
+
+    if(m_lodEnabled)
+        m_culler.SelectLods(m_cam.getPositionXM(), m_cam.getFovY(), (float)m_windowHeight, nullptr, writer);
+
+    m_dxImmediateContext->Unmap(m_instancedBuffer.Get(), 0);
+
+    m_drawnTriangleCount = 0;
+    for(uint32 lod = 0; lod < SKULL_LOD_COUNT; ++lod)
+        m_drawnTriangleCount += m_culler.VisibleLodRange(lod).Count * m_skullLods[lod].IndexCount / 3;
+
+    m_visibleObjectCount = (uint32)m_culler.VisibleInstances().size();
+    m_occludedObjectCount = m_culler.LastStats().Occluded;
 
 	std::stringstream outs;   
 	outs.precision(6);
 	outs << "Instancing and Culling Demo" << 
 		"    " << m_visibleObjectCount << 
-        " objects visible out of " << m_instancedData.size();
+        " objects visible out of " << m_instanceColors.size() <<
+        "    " << m_occludedObjectCount << " occluded" <<
+        "    " << m_drawnTriangleCount << " triangles" <<
+        "    " << (m_compactInstancesEnabled ? sizeof(CompactInstanceData) : sizeof(InstanceData)) << " bytes per instance";
     m_windowCaption = outs.str();
 }
 
@@ -374,11 +446,13 @@ void InstancingCullingApp::DrawScene()
     //Reset depth buffer to 1 and stencil buffer to 0
     m_dxImmediateContext->ClearDepthStencilView(m_depthStencilView.Get(), D3D11_CLEAR_DEPTH|D3D11_CLEAR_STENCIL, 1.0f, 0);
 
-    m_dxImmediateContext->IASetInputLayout(InputLayouts::InstancedBasic32.Get());
+    m_dxImmediateContext->IASetInputLayout(m_compactInstancesEnabled ?
+        InputLayouts::InstancedCompact32.Get() : InputLayouts::InstancedBasic32.Get());
     m_dxImmediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
     // Use 2 input slots, one for the vertex data and the other for the instanced data
-    uint32 stride[2] = {sizeof(Vertex::Basic32), sizeof(InstanceData)};
+    uint32 stride[2] = {sizeof(Vertex::Basic32),
+        m_compactInstancesEnabled ? sizeof(CompactInstanceData) : sizeof(InstanceData)};
     uint32 offset[2] = {0, 0};
 
     ID3D11Buffer* vbs[2] = {m_skullVB.Get(), m_instancedBuffer.Get()};
@@ -398,7 +472,8 @@ void InstancingCullingApp::DrawScene()
     Effects::InstancedBasicFX->SetEyePosW(m_cam.getPosition());
 
     // Skull doesn't have texture coordinates, so we can't texture it.
-    ID3DX11EffectTechnique* activeTech = Effects::InstancedBasicFX->Light3Tech;
+    ID3DX11EffectTechnique* activeTech = m_compactInstancesEnabled ?
+        Effects::InstancedBasicFX->Light3CompactTech : Effects::InstancedBasicFX->Light3Tech;
 
     D3DX11_TECHNIQUE_DESC techDesc;
     activeTech->GetDesc(&techDesc);
@@ -420,7 +495,17 @@ void InstancingCullingApp::DrawScene()
         Effects::InstancedBasicFX->SetMaterial(m_skullMat);
 
         pass->Apply(0, m_dxImmediateContext.Get());
-        m_dxImmediateContext->DrawIndexedInstanced(m_skullIndexCount, m_visibleObjectCount, 0, 0, 0);
+
+        // One draw per LOD, its instances are contiguous in the instance buffer.
+        for(uint32 lod = 0; lod < SKULL_LOD_COUNT; ++lod)
+        {
+            const InstanceCuller::LodRange& range = m_culler.VisibleLodRange(lod);
+            if(range.Count == 0)
+                continue;
+
+            m_dxImmediateContext->DrawIndexedInstanced(m_skullLods[lod].IndexCount, range.Count,
+                m_skullLods[lod].StartIndex, m_skullLods[lod].BaseVertex, range.First);
+        }
     }
 
 	HR(m_swapChain->Present(0, 0));
@@ -33,6 +33,10 @@ InstancedBasicEffect::InstancedBasicEffect(ID3D11Device* device, const std::stri
 	Light2Tech    = m_fx->GetTechniqueByName("Light2");
 	Light3Tech    = m_fx->GetTechniqueByName("Light3");
 
+	Light1CompactTech = m_fx->GetTechniqueByName("Light1Compact");
+	Light2CompactTech = m_fx->GetTechniqueByName("Light2Compact");
+	Light3CompactTech = m_fx->GetTechniqueByName("Light3Compact");
+
 	Light0TexTech = m_fx->GetTechniqueByName("Light0Tex");
 	Light1TexTech = m_fx->GetTechniqueByName("Light1Tex");
 	Light2TexTech = m_fx->GetTechniqueByName("Light2Tex");
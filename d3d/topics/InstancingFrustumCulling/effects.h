@@ -52,6 +52,11 @@ public:
 	ID3DX11EffectTechnique* Light2Tech;
 	ID3DX11EffectTechnique* Light3Tech;
 
+	// Same as LightN with the compact instance data.
+	ID3DX11EffectTechnique* Light1CompactTech;
+	ID3DX11EffectTechnique* Light2CompactTech;
+	ID3DX11EffectTechnique* Light3CompactTech;
+
 	ID3DX11EffectTechnique* Light0TexTech;
 	ID3DX11EffectTechnique* Light1TexTech;
 	ID3DX11EffectTechnique* Light2TexTech;
@@ -13,7 +13,19 @@ const D3D11_INPUT_ELEMENT_DESC InputLayoutDesc::InstancedBasic32[8] =
 	{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 64,  D3D11_INPUT_PER_INSTANCE_DATA, 1 }
 };
 
+// Per instance data is CompactInstanceData (instanceFormat.h).
+const D3D11_INPUT_ELEMENT_DESC InputLayoutDesc::InstancedCompact32[6] = 
+{
+	{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+	{"NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0},
+	{"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0},
+	{ "INSTANCEPOS", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+    { "INSTANCEROT", 0, DXGI_FORMAT_R16G16B16A16_SNORM, 1, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "COLOR", 0, DXGI_FORMAT_B8G8R8A8_UNORM, 1, 24,  D3D11_INPUT_PER_INSTANCE_DATA, 1 }
+};
+
 ComPtr<ID3D11InputLayout> InputLayouts::InstancedBasic32 = nullptr;
+ComPtr<ID3D11InputLayout> InputLayouts::InstancedCompact32 = nullptr;
 
 void InputLayouts::InitAll(ID3D11Device* device)
 {
@@ -25,6 +37,12 @@ void InputLayouts::InitAll(ID3D11Device* device)
 	Effects::InstancedBasicFX->Light1Tech->GetPassByIndex(0)->GetDesc(&passDescBasic);
 	HR(device->CreateInputLayout(InputLayoutDesc::InstancedBasic32, 8, passDescBasic.pIAInputSignature, 
         passDescBasic.IAInputSignatureSize, InstancedBasic32.GetAddressOf()));
+
+	// InstancedCompact32
+	D3DX11_PASS_DESC passDescCompact;
+	Effects::InstancedBasicFX->Light1CompactTech->GetPassByIndex(0)->GetDesc(&passDescCompact);
+	HR(device->CreateInputLayout(InputLayoutDesc::InstancedCompact32, 6, passDescCompact.pIAInputSignature, 
+        passDescCompact.IAInputSignatureSize, InstancedCompact32.GetAddressOf()));
 }
 
 void InputLayouts::DestroyAll()
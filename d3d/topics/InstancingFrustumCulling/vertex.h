@@ -31,6 +31,7 @@ class InputLayoutDesc
 public:
 	// Init like const int A::a[4] = {0, 1, 2, 3}; in .cpp file.
 	static const D3D11_INPUT_ELEMENT_DESC InstancedBasic32[8];
+	static const D3D11_INPUT_ELEMENT_DESC InstancedCompact32[6];
 };
 
 class InputLayouts
@@ -40,6 +41,7 @@ public:
 	static void DestroyAll();
 
     static ComPtr<ID3D11InputLayout> InstancedBasic32;
+    static ComPtr<ID3D11InputLayout> InstancedCompact32;
 };
 
 #endif // VERTEX_H
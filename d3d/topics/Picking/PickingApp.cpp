@@ -18,11 +18,11 @@
 #include "effects.h"
 #include "renderStates.h"
 #include "vertex.h"
+#include "meshRegistry.h"
 #include "xnacollision.h"
 #include <d3dcompiler.h>
 #include <iostream>
 #include <sstream>
-#include <fstream>
 #include <vector>
 
 class PickingApp : public TopicApp
@@ -39,21 +39,20 @@ public:
 
 private:
 
+    virtual void RequestAssets();
     virtual void InitGeometryBuffers();
 	virtual void InitFX();
 	virtual void InitVertexLayout();
 
-    void BuildMeshGeometryBuffers();
+    void BuildMeshGeometryBuffers(const MeshAssetPtr& mesh);
     void Pick(int sx, int sy);
 
     ComPtr<ID3D11Buffer>           m_meshVB;
     ComPtr<ID3D11Buffer>           m_meshIB;
 
-    // Keep system memory copies of the Mesh geometry for picking
-    std::vector<Vertex::Basic32> m_meshVertices;
-    std::vector<uint32> m_meshIndices;
-
-    XNA::AxisAlignedBox m_meshBox;
+    // System memory copy of the Mesh geometry for picking, shared through
+    // the mesh registry.
+    MeshAssetPtr m_mesh;
 
     DirectionalLight m_dirLight[3];
 	Material m_meshMat;
@@ -64,6 +63,9 @@ private:
 
 	uint32 m_meshIndexCount;
 	uint32 m_pickedTriangle;
+
+    // Filter counters at the end of the previous frame.
+    D3DX11_EFFECT_STATE_FILTER_STATS m_filterStats;
 };
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
@@ -87,6 +89,7 @@ PickingApp::PickingApp(HINSTANCE hInstance)
 , m_meshIndexCount(0)
 , m_pickedTriangle(-1)
 {
+    ZeroMemory(&m_filterStats, sizeof(m_filterStats));
     m_windowCaption = "Picking Demo";
     m_enable4xMsaa = false;
 
@@ -123,6 +126,8 @@ PickingApp::PickingApp(HINSTANCE hInstance)
 
 PickingApp::~PickingApp()
 {
+    D3DX11EnableEffectStateFilter(m_dxImmediateContext.Get(), FALSE);
+
     Effects::DestroyAll();
 	InputLayouts::DestroyAll();
 	RenderStates::DestroyAll();
@@ -133,62 +138,41 @@ bool PickingApp::Init()
     if(!TopicApp::Init())
 		return false;
 
+    // Both draws of the picked triangle apply the same pass. The demo only binds
+    // rasterizer and depth states itself, which its passes never set, so the
+    // filter never has to be invalidated.
+    HR(D3DX11EnableEffectStateFilter(m_dxImmediateContext.Get(), TRUE));
+
 	return true;
 }
 
-void PickingApp::InitGeometryBuffers()
+void PickingApp::RequestAssets()
 {
-    BuildMeshGeometryBuffers();
+    // Read and parsed by the workers while the effects are built.
+    Effects::LoadAll(m_assets);
+
+    // The car repeats a vertex for every face sharing it, welding the equal
+    // ones leaves 1540 of the 1860 vertices.
+    WeldTolerance exact = { 0.0f, 0.0f };
+    m_assets.LoadMesh("Models/car.txt", [this](const MeshAssetPtr& mesh) { BuildMeshGeometryBuffers(mesh); }, &exact);
 }
 
-void PickingApp::BuildMeshGeometryBuffers()
+void PickingApp::InitGeometryBuffers()
 {
-    std::ifstream fin("Models/car.txt");
-    OC_ASSERT(fin.good());
-
-	uint32 vcount = 0;
-	uint32 tcount = 0;
-	std::string ignore;
-
-	fin >> ignore >> vcount;
-	fin >> ignore >> tcount;
-	fin >> ignore >> ignore >> ignore >> ignore;
-
-    // Min and max are for constructing the bounding box
-    XMFLOAT3 vMinf3(+MathHelper::Infinity, +MathHelper::Infinity, +MathHelper::Infinity);
-	XMFLOAT3 vMaxf3(-MathHelper::Infinity, -MathHelper::Infinity, -MathHelper::Infinity);
-	
-	XMVECTOR vMin = XMLoadFloat3(&vMinf3);
-	XMVECTOR vMax = XMLoadFloat3(&vMaxf3);
-	
-    m_meshVertices.resize(vcount);
-	for(uint32 i = 0; i < vcount; ++i)
-	{
-        fin >> m_meshVertices[i].Pos.x >> m_meshVertices[i].Pos.y >> m_meshVertices[i].Pos.z;
-		fin >> m_meshVertices[i].Normal.x >> m_meshVertices[i].Normal.y >> m_meshVertices[i].Normal.z;
+    // The mesh buffers are created once the mesh is loaded, see RequestAssets.
+}
 
-        XMVECTOR P = XMLoadFloat3(&m_meshVertices[i].Pos);
-		
-		vMin = XMVectorMin(vMin, P);
-		vMax = XMVectorMax(vMax, P);
-	}
+void PickingApp::BuildMeshGeometryBuffers(const MeshAssetPtr& mesh)
+{
+    m_mesh = mesh;
+    OC_ASSERT(m_mesh);
 
-    // Set the AABB
-    XMStoreFloat3(&m_meshBox.Center, 0.5f*(vMin+vMax));
-	XMStoreFloat3(&m_meshBox.Extents, 0.5f*(vMax-vMin));
+	uint32 vcount = m_mesh->VertexCount();
 
-	fin >> ignore;
-	fin >> ignore;
-	fin >> ignore;
+    std::vector<Vertex::Basic32> vertices;
+    CopyMeshVertices(*m_mesh, &vertices);
 
-    m_meshIndexCount = 3*tcount;
-    m_meshIndices.resize(m_meshIndexCount);
-	for(uint32 i = 0; i < tcount; ++i)
-	{
-        fin >> m_meshIndices[i*3+0] >> m_meshIndices[i*3+1] >> m_meshIndices[i*3+2];
-	}
-
-	fin.close();
+    m_meshIndexCount = m_mesh->IndexCount();
 
     D3D11_BUFFER_DESC vbd;
     vbd.Usage = D3D11_USAGE_IMMUTABLE;
@@ -197,7 +181,7 @@ void PickingApp::BuildMeshGeometryBuffers()
     vbd.CPUAccessFlags = 0;
     vbd.MiscFlags = 0;
     D3D11_SUBRESOURCE_DATA vinitData;
-    vinitData.pSysMem = &m_meshVertices[0];
+    vinitData.pSysMem = &vertices[0];
     HR(m_dxDevice->CreateBuffer(&vbd, &vinitData, m_meshVB.GetAddressOf()));
 
 	// Pack the indices of all the meshes into one index buffer.
@@ -208,14 +192,14 @@ void PickingApp::BuildMeshGeometryBuffers()
     ibd.CPUAccessFlags = 0;
     ibd.MiscFlags = 0;
     D3D11_SUBRESOURCE_DATA iinitData;
-    iinitData.pSysMem = &m_meshIndices[0];
+    iinitData.pSysMem = &m_mesh->Indices[0];
     HR(m_dxDevice->CreateBuffer(&ibd, &iinitData, m_meshIB.GetAddressOf()));
 }
 
 void PickingApp::InitFX()
 {
     // Must init Effects first since InputLayouts depend on shader signatures.
-	Effects::InitAll(m_dxDevice.Get());
+	Effects::InitAll(m_dxDevice.Get(), m_assets);
 	InputLayouts::InitAll(m_dxDevice.Get());
 	RenderStates::InitAll(m_dxDevice.Get());
 }
@@ -285,21 +269,21 @@ void PickingApp::Pick(int sx, int sy)
     m_pickedTriangle = -1;
 	float tmin = 0.0f;
     // Check for AABB first to avoid looking through all triangles
-    if(XNA::IntersectRayAxisAlignedBox(rayOrigin, rayDir, &m_meshBox, &tmin))
+    if(XNA::IntersectRayAxisAlignedBox(rayOrigin, rayDir, &m_mesh->Bounds, &tmin))
 	{
 		// Find the nearest ray/triangle intersection.
 		tmin = MathHelper::Infinity;
-        for(UINT i = 0; i < m_meshIndices.size()/3; ++i)
+        for(UINT i = 0; i < m_mesh->Indices.size()/3; ++i)
 		{
 			// Indices for this triangle.
-			UINT i0 = m_meshIndices[i*3+0];
-			UINT i1 = m_meshIndices[i*3+1];
-			UINT i2 = m_meshIndices[i*3+2];
+			UINT i0 = m_mesh->Indices[i*3+0];
+			UINT i1 = m_mesh->Indices[i*3+1];
+			UINT i2 = m_mesh->Indices[i*3+2];
 
 			// Vertices for this triangle.
-            XMVECTOR v0 = XMLoadFloat3(&m_meshVertices[i0].Pos);
-			XMVECTOR v1 = XMLoadFloat3(&m_meshVertices[i1].Pos);
-			XMVECTOR v2 = XMLoadFloat3(&m_meshVertices[i2].Pos);
+            XMVECTOR v0 = XMLoadFloat3(&m_mesh->Positions[i0]);
+			XMVECTOR v1 = XMLoadFloat3(&m_mesh->Positions[i1]);
+			XMVECTOR v2 = XMLoadFloat3(&m_mesh->Positions[i2]);
 
 			// We have to iterate over all the triangles in order to find the nearest intersection.
 			float t = 0.0f;
@@ -385,5 +369,18 @@ void PickingApp::DrawScene()
     }
 
 	HR(m_swapChain->Present(0, 0));
+
+    // State calls the filter let through and dropped this frame, shown in
+    // the caption.
+    D3DX11_EFFECT_STATE_FILTER_STATS filterStats;
+    if(SUCCEEDED(D3DX11GetEffectStateFilterStats(m_dxImmediateContext.Get(), &filterStats)))
+    {
+        std::ostringstream outs;
+        outs << "Picking Demo    state calls: "
+             << filterStats.CallsIssued - m_filterStats.CallsIssued << " issued, "
+             << filterStats.CallsSkipped - m_filterStats.CallsSkipped << " skipped";
+        m_windowCaption = outs.str();
+        m_filterStats = filterStats;
+    }
 }
 
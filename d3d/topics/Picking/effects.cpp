@@ -1,33 +1,22 @@
 
 #include "effects.h"
+#include "assetLoader.h"
 #include "config.h"
-#include <vector>
-#include <fstream>
+#include "effectCache.h"
 
-Effect::Effect(ID3D11Device* device, const std::string& filename)
+Effect::Effect(ID3D11Device* device, const std::vector<uint8>& compiledShader)
 : m_fx(nullptr)
 {
-	std::ifstream fin(filename, std::ios::binary);
-    OC_ASSERT(fin.good());
-
-	fin.seekg(0, std::ios_base::end);
-	int size = (int)fin.tellg();
-	fin.seekg(0, std::ios_base::beg);
-	std::vector<char> compiledShader(size);
-
-	fin.read(&compiledShader[0], size);
-	fin.close();
-	
-	HR(D3DX11CreateEffectFromMemory(&compiledShader[0], size, 
-        0, device, m_fx.GetAddressOf()));
+	// Clone of the effect when another wrapper of the process loaded it.
+	HR(EffectCache::Shared().Create(device, compiledShader, m_fx.GetAddressOf()));
 }
 
 Effect::~Effect()
 {
 }
 
-BasicEffect::BasicEffect(ID3D11Device* device, const std::string& filename)
-: Effect(device, filename)
+BasicEffect::BasicEffect(ID3D11Device* device, const std::vector<uint8>& compiledShader)
+: Effect(device, compiledShader)
 {
 	Light1Tech        = m_fx->GetTechniqueByName("Light1");
 	Light2Tech        = m_fx->GetTechniqueByName("Light2");
@@ -76,12 +65,22 @@ BasicEffect::~BasicEffect()
 
 std::unique_ptr<BasicEffect> Effects::BasicFX = nullptr;
 
-void Effects::InitAll(ID3D11Device* device)
+void Effects::LoadAll(AssetLoader& assets)
 {
-    BasicFX.reset(new BasicEffect(device, "FX/Basic.fxo"));
+    assets.LoadFile("FX/Basic.fxo");
+}
+
+void Effects::InitAll(ID3D11Device* device, AssetLoader& assets)
+{
+    AssetLoader::FileDataPtr basic = assets.LoadFile("FX/Basic.fxo").get();
+    OC_ASSERT(basic);
+    BasicFX.reset(new BasicEffect(device, *basic));
 }
 
 void Effects::DestroyAll()
 {
     BasicFX.reset(nullptr);
+
+    // The cached masters hold the device.
+    EffectCache::Shared().Clear();
 }
\ No newline at end of file